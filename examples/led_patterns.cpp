@@ -8,6 +8,9 @@
 
 #include "../src/usb_raw_midi.h"
 #include "../src/apc_mini_defs.h"
+#include "../src/apc_device_profile.h"
+#include "../src/led_behavior.h"
+#include "../src/led_snapshot_bank.h"
 
 class LEDPatternsApp : public BApplication {
 public:
@@ -41,6 +44,9 @@ private:
     // Utility functions
     void SetPadColor(int x, int y, APCMiniLEDColor color);
     void SetAllPads(APCMiniLEDColor color);
+    // MK2 only: every pad runs the animation for duration_us, through the
+    // compositor (native blink/pulse when the rate allows). false: not an MK2
+    bool AnimateAllPads(const LEDPadAnimation& animation, bigtime_t duration_us);
     bool IsValidPosition(int x, int y);
     void ShowPattern(const char* name);
     void WaitForUser();
@@ -165,10 +171,16 @@ void LEDPatternsApp::RunDemo()
     };
     const char* blink_names[] = { "Green Blink", "Red Blink", "Yellow Blink" };
 
+    // The MK1 blinks the *_BLINK velocities itself; the MK2 needs a blink channel
+    bigtime_t blink_period = MK2LEDBehaviorPeriod(APC_MK2_LED_BLINK_1_4,
+                                                  LEDAnimationCompositor::DEFAULT_BPM);
+
     for (size_t i = 0; i < sizeof(blink_colors) / sizeof(blink_colors[0]) && running; i++) {
         printf("  %s...\n", blink_names[i]);
-        PatternAllOn(blink_colors[i]);
-        snooze(2000000); // 2 seconds
+        if (!AnimateAllPads(LEDPadAnimation::FromLegacy(blink_colors[i], blink_period), 2000000)) {
+            PatternAllOn(blink_colors[i]);
+            snooze(2000000); // 2 seconds
+        }
     }
 
     PatternAllOff();
@@ -369,6 +381,14 @@ void LEDPatternsApp::PatternRainbow(int cycles)
 
 void LEDPatternsApp::PatternBlink(APCMiniLEDColor color, int count)
 {
+    // MK2: a 1/4 blink (500ms cycles at the default 120 BPM) runs natively
+    bigtime_t period = MK2LEDBehaviorPeriod(APC_MK2_LED_BLINK_1_4,
+                                            LEDAnimationCompositor::DEFAULT_BPM);
+    if (AnimateAllPads(LEDPadAnimation::Blink(MK2PaletteColor(color), period), count * period)) {
+        SetAllPads(APC_LED_OFF);
+        return;
+    }
+
     for (int i = 0; i < count && running; i++) {
         SetAllPads(color);
         snooze(300000); // 300ms on
@@ -518,6 +538,43 @@ void LEDPatternsApp::SetAllPads(APCMiniLEDColor color)
     }
 }
 
+bool LEDPatternsApp::AnimateAllPads(const LEDPadAnimation& animation, bigtime_t duration_us)
+{
+    const APCDeviceDescriptor* profile = usb_midi ? usb_midi->GetDeviceProfile() : nullptr;
+    if (simulation_mode || !profile || profile->led_encoding != APC_LED_ENCODING_RGB_PALETTE) {
+        return false;
+    }
+
+    LEDAnimationCompositor compositor;
+    compositor.SetAll(animation);
+    bigtime_t start = system_time();
+    bigtime_t end = start + duration_us;
+    compositor.SetEpoch(start);
+
+    // Only pads that changed since the last frame are sent; a native blink
+    // is one message per pad for the whole duration
+    LEDSnapshot shown;
+    LEDSnapshot frame;
+    frame.Clear();
+    bool first = true;
+    for (bigtime_t now = start; running && now < end; now = system_time()) {
+        compositor.Compose(now, frame);
+        for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+            if (first || frame.velocity[pad] != shown.velocity[pad] ||
+                frame.channel[pad] != shown.channel[pad]) {
+                usb_midi->SendMIDI(MIDI_NOTE_ON | (frame.channel[pad] & 0x0F),
+                                   LEDSnapshot::NoteForLED(pad), frame.velocity[pad]);
+            }
+        }
+        shown = frame;
+        first = false;
+
+        bigtime_t next = compositor.NextChange(now);
+        snooze_until(next < end ? next : end, B_SYSTEM_TIMEBASE);
+    }
+    return true;
+}
+
 bool LEDPatternsApp::IsValidPosition(int x, int y)
 {
     return (x >= 0 && x < APC_MINI_PAD_COLS && y >= 0 && y < APC_MINI_PAD_ROWS);
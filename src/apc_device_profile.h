@@ -0,0 +1,414 @@
+// apc_device_profile.h
+// Compile-time device profiles for Akai APC grid controllers
+//
+// PURPOSE:
+// Collects everything that differs between Akai grid controllers (control map,
+// LED encoding, SysEx header, USB endpoint expectations) into constexpr profile
+// structs. Hot paths are written once as templates over a profile and the
+// compiler specializes them per device:
+//
+//   APCMiniMK2Device::ClassifyNote(note)      -> 128-entry table lookup
+//   APCMiniMK2Device::BuildNotePacket(...)    -> constant CIN/header
+//   APCMiniMK1Device::EncodePadLED(color)     -> device-specific velocity
+//
+// ADDING A DEVICE:
+// A new controller is a new profile struct (data only) plus one line in
+// APC_KNOWN_DEVICES. Classification tables are generated at compile time and
+// checked by APCValidateProfile<>() through static_assert, so overlapping or
+// miscounted ranges fail the build instead of misrouting events at runtime.
+//
+// RUNTIME BOUNDARY:
+// Only device discovery deals with a runtime product ID. APCFindDevice()
+// returns a descriptor whose function pointers are the specialized template
+// instances, so code after detection never branches on the product ID again.
+// Profiles not verified against hardware (SUPPORTED = false) stay in the
+// table for validation but are never opened.
+
+#ifndef APC_DEVICE_PROFILE_H
+#define APC_DEVICE_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "apc_mini_defs.h"
+#include "usb_midi_codec.h"
+
+// Control classes produced by the classification tables
+enum APCControlClass : uint8_t {
+    APC_CONTROL_NONE = 0,
+    APC_CONTROL_PAD,             // Grid pad (clip launch)
+    APC_CONTROL_TRACK_BUTTON,    // Button row below the grid
+    APC_CONTROL_SCENE_BUTTON,    // Button column right of the grid
+    APC_CONTROL_SHIFT_BUTTON,    // Shift modifier
+    APC_CONTROL_AUX_BUTTON,      // Other buttons (stop all, transport...)
+    APC_CONTROL_TRACK_FADER,     // Channel fader
+    APC_CONTROL_MASTER_FADER,    // Master fader
+    APC_CONTROL_KNOB             // Rotary control (APC Key 25, APC40)
+};
+
+// How pad LEDs are addressed
+enum APCLEDEncoding : uint8_t {
+    APC_LED_ENCODING_LEGACY_7COLOR = 0,  // Velocity selects APCMiniLEDColor, channel ignored
+    APC_LED_ENCODING_RGB_PALETTE = 1     // Velocity = palette index, channel = brightness/behavior
+};
+
+// Contiguous range of note or CC numbers belonging to one control class
+struct APCControlRange {
+    uint8_t first;
+    uint8_t last;
+    APCControlClass control_class;
+};
+
+// Result of a classification lookup: class plus index within that class
+struct APCControlEntry {
+    APCControlClass control_class;
+    uint8_t index;
+};
+
+// Full 7-bit classification table (one entry per note or CC number)
+struct APCControlTable {
+    APCControlEntry entries[128];
+};
+
+constexpr APCControlTable APCBuildControlTable(const APCControlRange* ranges, size_t count)
+{
+    APCControlTable table{};
+    for (size_t r = 0; r < count; r++) {
+        for (uint8_t n = ranges[r].first; n <= ranges[r].last && n < 128; n++) {
+            table.entries[n].control_class = ranges[r].control_class;
+            table.entries[n].index = static_cast<uint8_t>(n - ranges[r].first);
+        }
+    }
+    return table;
+}
+
+constexpr bool APCRangesAreDisjoint(const APCControlRange* ranges, size_t count)
+{
+    for (size_t a = 0; a < count; a++) {
+        if (ranges[a].first > ranges[a].last || ranges[a].last > 127) {
+            return false;
+        }
+        for (size_t b = a + 1; b < count; b++) {
+            if (ranges[a].first <= ranges[b].last && ranges[b].first <= ranges[a].last) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr size_t APCCountClass(const APCControlTable& table, APCControlClass control_class)
+{
+    size_t count = 0;
+    for (size_t n = 0; n < 128; n++) {
+        if (table.entries[n].control_class == control_class) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// ===============================
+// Device profiles (data only)
+// ===============================
+
+// Original APC Mini (PID 0x0028): 7-color LEDs, no SysEx
+struct APCMiniMK1Profile {
+    static constexpr const char* NAME = "APC Mini";
+    static constexpr bool SUPPORTED = true;
+    static constexpr uint16_t VENDOR_ID = APC_MINI_VENDOR_ID;
+    static constexpr uint16_t PRODUCT_ID = APC_MINI_PRODUCT_ID;
+
+    static constexpr uint8_t PAD_ROWS = 8;
+    static constexpr uint8_t PAD_COLS = 8;
+    static constexpr uint8_t PAD_NOTE_START = 0x00;
+    static constexpr uint8_t TRACK_BUTTON_COUNT = 8;
+    static constexpr uint8_t SCENE_BUTTON_COUNT = 8;
+    static constexpr uint8_t TRACK_FADER_COUNT = 8;
+    static constexpr uint8_t MASTER_FADER_COUNT = 1;
+    static constexpr uint8_t KNOB_COUNT = 0;
+
+    static constexpr APCControlRange NOTE_RANGES[] = {
+        {0x00, 0x3F, APC_CONTROL_PAD},
+        {0x40, 0x47, APC_CONTROL_TRACK_BUTTON},   // 64-71
+        {0x52, 0x59, APC_CONTROL_SCENE_BUTTON},   // 82-89
+        {0x62, 0x62, APC_CONTROL_SHIFT_BUTTON}    // 98
+    };
+    static constexpr APCControlRange CC_RANGES[] = {
+        {0x30, 0x37, APC_CONTROL_TRACK_FADER},
+        {0x38, 0x38, APC_CONTROL_MASTER_FADER}
+    };
+
+    static constexpr APCLEDEncoding LED_ENCODING = APC_LED_ENCODING_LEGACY_7COLOR;
+    static constexpr uint8_t LED_CHANNEL = 0;
+    static constexpr uint8_t BUTTON_LED_ON = 1;
+
+    static constexpr bool HAS_SYSEX = false;
+    static constexpr uint8_t SYSEX_HEADER[] = {0xF0, 0x47, 0x7F, 0x28};
+
+    // USB endpoint expectations
+    static constexpr uint8_t MIDI_INTERFACE = 0;
+    static constexpr uint8_t ENDPOINT_OUT = 0x01;
+    static constexpr uint8_t ENDPOINT_IN = 0x81;
+    static constexpr bool INTERRUPT_ENDPOINTS = false;
+};
+
+// APC Mini MK2 (PID 0x004F): RGB palette pads, SysEx RGB/introduction/mode
+struct APCMiniMK2Profile {
+    static constexpr const char* NAME = "APC Mini MK2";
+    static constexpr bool SUPPORTED = true;
+    static constexpr uint16_t VENDOR_ID = APC_MINI_VENDOR_ID;
+    static constexpr uint16_t PRODUCT_ID = APC_MINI_MK2_PRODUCT_ID;
+
+    static constexpr uint8_t PAD_ROWS = 8;
+    static constexpr uint8_t PAD_COLS = 8;
+    static constexpr uint8_t PAD_NOTE_START = APC_MINI_PAD_NOTE_START;
+    static constexpr uint8_t TRACK_BUTTON_COUNT = 8;
+    static constexpr uint8_t SCENE_BUTTON_COUNT = 8;
+    static constexpr uint8_t TRACK_FADER_COUNT = APC_MINI_TRACK_FADER_COUNT;
+    static constexpr uint8_t MASTER_FADER_COUNT = 1;
+    static constexpr uint8_t KNOB_COUNT = 0;
+
+    static constexpr APCControlRange NOTE_RANGES[] = {
+        {APC_MINI_PAD_NOTE_START, APC_MINI_PAD_NOTE_END, APC_CONTROL_PAD},
+        {APC_MINI_TRACK_NOTE_START, APC_MINI_TRACK_NOTE_END, APC_CONTROL_TRACK_BUTTON},
+        {APC_MINI_SCENE_NOTE_START, APC_MINI_SCENE_NOTE_END, APC_CONTROL_SCENE_BUTTON},
+        {APC_MINI_SHIFT_NOTE, APC_MINI_SHIFT_NOTE, APC_CONTROL_SHIFT_BUTTON}
+    };
+    static constexpr APCControlRange CC_RANGES[] = {
+        {APC_MINI_FADER_CC_START, APC_MINI_FADER_CC_END, APC_CONTROL_TRACK_FADER},
+        {APC_MINI_MASTER_CC, APC_MINI_MASTER_CC, APC_CONTROL_MASTER_FADER}
+    };
+
+    static constexpr APCLEDEncoding LED_ENCODING = APC_LED_ENCODING_RGB_PALETTE;
+    static constexpr uint8_t LED_CHANNEL = 6;          // 100% brightness
+    static constexpr uint8_t BUTTON_LED_ON = 1;
+
+    static constexpr bool HAS_SYSEX = true;
+    static constexpr uint8_t SYSEX_HEADER[] = {APC_MK2_SYSEX_HEADER};
+
+    static constexpr uint8_t MIDI_INTERFACE = 1;
+    static constexpr uint8_t ENDPOINT_OUT = 0x01;
+    static constexpr uint8_t ENDPOINT_IN = 0x81;
+    static constexpr bool INTERRUPT_ENDPOINTS = true;
+};
+
+// APC Key 25 (PID 0x0027): 5x8 clip grid, 8 knobs, legacy LEDs.
+// Provided as profile data; not yet verified against hardware, so discovery
+// does not accept it.
+struct APCKey25Profile {
+    static constexpr const char* NAME = "APC Key 25";
+    static constexpr bool SUPPORTED = false;
+    static constexpr uint16_t VENDOR_ID = APC_MINI_VENDOR_ID;
+    static constexpr uint16_t PRODUCT_ID = 0x0027;
+
+    static constexpr uint8_t PAD_ROWS = 5;
+    static constexpr uint8_t PAD_COLS = 8;
+    static constexpr uint8_t PAD_NOTE_START = 0x00;
+    static constexpr uint8_t TRACK_BUTTON_COUNT = 8;
+    static constexpr uint8_t SCENE_BUTTON_COUNT = 5;
+    static constexpr uint8_t TRACK_FADER_COUNT = 0;
+    static constexpr uint8_t MASTER_FADER_COUNT = 0;
+    static constexpr uint8_t KNOB_COUNT = 8;
+
+    static constexpr APCControlRange NOTE_RANGES[] = {
+        {0x00, 0x27, APC_CONTROL_PAD},            // 0-39
+        {0x40, 0x47, APC_CONTROL_TRACK_BUTTON},   // 64-71
+        {0x51, 0x51, APC_CONTROL_AUX_BUTTON},     // 81 stop all clips
+        {0x52, 0x56, APC_CONTROL_SCENE_BUTTON},   // 82-86
+        {0x5B, 0x5B, APC_CONTROL_AUX_BUTTON},     // 91 play
+        {0x5D, 0x5D, APC_CONTROL_AUX_BUTTON},     // 93 record
+        {0x62, 0x62, APC_CONTROL_SHIFT_BUTTON}    // 98
+    };
+    static constexpr APCControlRange CC_RANGES[] = {
+        {0x30, 0x37, APC_CONTROL_KNOB}
+    };
+
+    static constexpr APCLEDEncoding LED_ENCODING = APC_LED_ENCODING_LEGACY_7COLOR;
+    static constexpr uint8_t LED_CHANNEL = 0;
+    static constexpr uint8_t BUTTON_LED_ON = 1;
+
+    static constexpr bool HAS_SYSEX = false;
+    static constexpr uint8_t SYSEX_HEADER[] = {0xF0, 0x47, 0x7F, 0x27};
+
+    static constexpr uint8_t MIDI_INTERFACE = 1;
+    static constexpr uint8_t ENDPOINT_OUT = 0x01;
+    static constexpr uint8_t ENDPOINT_IN = 0x81;
+    static constexpr bool INTERRUPT_ENDPOINTS = false;
+};
+
+// ===============================
+// Profile-specialized operations
+// ===============================
+
+template <typename Profile>
+struct APCDevice {
+    typedef Profile ProfileType;
+
+    static constexpr uint8_t PAD_COUNT = Profile::PAD_ROWS * Profile::PAD_COLS;
+
+    static constexpr APCControlTable NOTE_TABLE = APCBuildControlTable(
+        Profile::NOTE_RANGES, sizeof(Profile::NOTE_RANGES) / sizeof(Profile::NOTE_RANGES[0]));
+    static constexpr APCControlTable CC_TABLE = APCBuildControlTable(
+        Profile::CC_RANGES, sizeof(Profile::CC_RANGES) / sizeof(Profile::CC_RANGES[0]));
+
+    // Control classification (single table lookup, no branches)
+    static constexpr APCControlEntry ClassifyNote(uint8_t note) {
+        return NOTE_TABLE.entries[note & 0x7F];
+    }
+
+    static constexpr APCControlEntry ClassifyCC(uint8_t controller) {
+        return CC_TABLE.entries[controller & 0x7F];
+    }
+
+    // Note number of the first control of a class (inverse of ClassifyNote)
+    static constexpr uint8_t FirstNote(APCControlClass control_class) {
+        for (size_t n = 0; n < 128; n++) {
+            if (NOTE_TABLE.entries[n].control_class == control_class) {
+                return static_cast<uint8_t>(n);
+            }
+        }
+        return 0xFF;
+    }
+
+    static constexpr uint8_t PadNote(uint8_t pad) { return Profile::PAD_NOTE_START + pad; }
+    static constexpr uint8_t TrackButtonNote(uint8_t index) {
+        return FirstNote(APC_CONTROL_TRACK_BUTTON) + index;
+    }
+    static constexpr uint8_t SceneButtonNote(uint8_t index) {
+        return FirstNote(APC_CONTROL_SCENE_BUTTON) + index;
+    }
+    static constexpr uint8_t ShiftNote() { return FirstNote(APC_CONTROL_SHIFT_BUTTON); }
+
+    // LED encoding: returns the Note On status byte for a pad color
+    static constexpr uint8_t PadLEDStatus() {
+        return MIDI_NOTE_ON | (Profile::LED_ENCODING == APC_LED_ENCODING_RGB_PALETTE
+                               ? Profile::LED_CHANNEL : APC_MINI_MIDI_CHANNEL);
+    }
+
+    // LED encoding: velocity for one of the legacy colors. MK2 palette indices
+    // 0-6 are close to the legacy colors, so both encodings accept them.
+    static constexpr uint8_t EncodePadLED(APCMiniLEDColor color) {
+        return static_cast<uint8_t>(color);
+    }
+
+    // Packet building: a Note On event with constant header for cable 0
+    static constexpr USBMIDIEventPacket BuildNotePacket(uint8_t status, uint8_t note,
+                                                        uint8_t velocity) {
+        return USBMIDIEncodeMessage(0, status, static_cast<uint8_t>(note & 0x7F),
+                                    static_cast<uint8_t>(velocity & 0x7F));
+    }
+
+    static constexpr USBMIDIEventPacket BuildPadLEDPacket(uint8_t pad, uint8_t velocity) {
+        return BuildNotePacket(PadLEDStatus(), PadNote(pad), velocity);
+    }
+
+    static constexpr bool IsSupported(uint16_t vendor_id, uint16_t product_id) {
+        return vendor_id == Profile::VENDOR_ID && product_id == Profile::PRODUCT_ID;
+    }
+};
+
+// Compile-time profile validation (used with static_assert)
+template <typename Profile>
+constexpr bool APCValidateProfile()
+{
+    typedef APCDevice<Profile> Device;
+    constexpr size_t note_ranges = sizeof(Profile::NOTE_RANGES) / sizeof(Profile::NOTE_RANGES[0]);
+    constexpr size_t cc_ranges = sizeof(Profile::CC_RANGES) / sizeof(Profile::CC_RANGES[0]);
+
+    return APCRangesAreDisjoint(Profile::NOTE_RANGES, note_ranges)
+        && APCRangesAreDisjoint(Profile::CC_RANGES, cc_ranges)
+        && APCCountClass(Device::NOTE_TABLE, APC_CONTROL_PAD) == Device::PAD_COUNT
+        && APCCountClass(Device::NOTE_TABLE, APC_CONTROL_TRACK_BUTTON) == Profile::TRACK_BUTTON_COUNT
+        && APCCountClass(Device::NOTE_TABLE, APC_CONTROL_SCENE_BUTTON) == Profile::SCENE_BUTTON_COUNT
+        && APCCountClass(Device::CC_TABLE, APC_CONTROL_TRACK_FADER) == Profile::TRACK_FADER_COUNT
+        && APCCountClass(Device::CC_TABLE, APC_CONTROL_MASTER_FADER) == Profile::MASTER_FADER_COUNT
+        && APCCountClass(Device::CC_TABLE, APC_CONTROL_KNOB) == Profile::KNOB_COUNT
+        && Device::ClassifyNote(Profile::PAD_NOTE_START).control_class == APC_CONTROL_PAD
+        && Profile::SYSEX_HEADER[0] == 0xF0
+        && Profile::SYSEX_HEADER[1] == 0x47
+        && (Profile::ENDPOINT_IN & 0x80) != 0
+        && (Profile::ENDPOINT_OUT & 0x80) == 0;
+}
+
+typedef APCDevice<APCMiniMK1Profile> APCMiniMK1Device;
+typedef APCDevice<APCMiniMK2Profile> APCMiniMK2Device;
+typedef APCDevice<APCKey25Profile> APCKey25Device;
+
+static_assert(APCValidateProfile<APCMiniMK1Profile>(), "APC Mini MK1 profile is inconsistent");
+static_assert(APCValidateProfile<APCMiniMK2Profile>(), "APC Mini MK2 profile is inconsistent");
+static_assert(APCValidateProfile<APCKey25Profile>(), "APC Key 25 profile is inconsistent");
+
+// The MK2 table must agree with the legacy IS_*_NOTE / IS_*_CC macros
+static_assert(APCMiniMK2Device::ClassifyNote(APC_MINI_PAD_NOTE_END).control_class == APC_CONTROL_PAD, "");
+static_assert(APCMiniMK2Device::ClassifyNote(APC_MINI_TRACK_NOTE_START).index == 0, "");
+static_assert(APCMiniMK2Device::ClassifyNote(APC_MINI_SCENE_NOTE_END).index == 7, "");
+static_assert(APCMiniMK2Device::ShiftNote() == APC_MINI_SHIFT_NOTE, "");
+static_assert(APCMiniMK2Device::ClassifyCC(APC_MINI_FADER_CC_END).index == 7, "");
+static_assert(APCMiniMK2Device::ClassifyCC(APC_MINI_MASTER_CC).control_class == APC_CONTROL_MASTER_FADER, "");
+static_assert(APCMiniMK2Device::ClassifyNote(0x40).control_class == APC_CONTROL_NONE, "");
+static_assert(APCMiniMK2Device::BuildPadLEDPacket(0, 5).header == USB_MIDI_CIN_NOTE_ON, "");
+static_assert(APCMiniMK1Device::SceneButtonNote(7) == 89, "");
+
+// ===============================
+// Runtime descriptor (discovery boundary only)
+// ===============================
+
+struct APCDeviceDescriptor {
+    const char* name;
+    uint16_t vendor_id;
+    uint16_t product_id;
+    bool supported;             // false: known layout, never opened
+    uint8_t pad_count;
+    APCLEDEncoding led_encoding;
+    bool has_sysex;
+    uint8_t midi_interface;
+    bool interrupt_endpoints;
+    APCControlEntry (*classify_note)(uint8_t note);
+    APCControlEntry (*classify_cc)(uint8_t controller);
+};
+
+template <typename Profile>
+constexpr APCDeviceDescriptor APCMakeDescriptor()
+{
+    return APCDeviceDescriptor{
+        Profile::NAME, Profile::VENDOR_ID, Profile::PRODUCT_ID, Profile::SUPPORTED,
+        APCDevice<Profile>::PAD_COUNT, Profile::LED_ENCODING, Profile::HAS_SYSEX,
+        Profile::MIDI_INTERFACE, Profile::INTERRUPT_ENDPOINTS,
+        &APCDevice<Profile>::ClassifyNote, &APCDevice<Profile>::ClassifyCC
+    };
+}
+
+static constexpr APCDeviceDescriptor APC_KNOWN_DEVICES[] = {
+    APCMakeDescriptor<APCMiniMK1Profile>(),
+    APCMakeDescriptor<APCMiniMK2Profile>(),
+    APCMakeDescriptor<APCKey25Profile>()
+};
+
+static constexpr size_t APC_KNOWN_DEVICE_COUNT =
+    sizeof(APC_KNOWN_DEVICES) / sizeof(APC_KNOWN_DEVICES[0]);
+
+// Supported devices only; nullptr for unknown and unverified ones
+constexpr const APCDeviceDescriptor* APCFindDevice(uint16_t vendor_id, uint16_t product_id)
+{
+    for (size_t i = 0; i < APC_KNOWN_DEVICE_COUNT; i++) {
+        if (APC_KNOWN_DEVICES[i].vendor_id == vendor_id &&
+            APC_KNOWN_DEVICES[i].product_id == product_id &&
+            APC_KNOWN_DEVICES[i].supported) {
+            return &APC_KNOWN_DEVICES[i];
+        }
+    }
+    return nullptr;
+}
+
+constexpr bool APCIsSupportedDevice(uint16_t vendor_id, uint16_t product_id)
+{
+    return APCFindDevice(vendor_id, product_id) != nullptr;
+}
+
+static_assert(APCIsSupportedDevice(APC_MINI_VENDOR_ID, APC_MINI_PRODUCT_ID), "");
+static_assert(!APCIsSupportedDevice(APC_MINI_VENDOR_ID, APCKey25Profile::PRODUCT_ID), "");
+static_assert(APCIsSupportedDevice(APC_MINI_VENDOR_ID, APC_MINI_MK2_PRODUCT_ID), "");
+static_assert(!APCIsSupportedDevice(0x1234, APC_MINI_MK2_PRODUCT_ID), "");
+
+#endif // APC_DEVICE_PROFILE_H
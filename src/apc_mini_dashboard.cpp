@@ -0,0 +1,296 @@
+// APC Mini Terminal Dashboard
+// Headless monitoring over SSH: drives the simulated MK2 with a simulated
+// performer (pad hits, fader sweeps, button presses) plus an LED animation
+// load, and shows device state, send-to-echo latency and throughput in a
+// diffed ANSI dashboard at a fixed frame rate.
+//
+// Usage: apc_mini_dashboard [--fps <n>] [--seconds <s>] [--rate <msg/s>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <random>
+#include <unistd.h>
+
+#include "terminal_dashboard.h"
+#include "midi_transport.h"
+#include "latency_histogram.h"
+
+static std::atomic<bool> stop_requested(false);
+
+static void HandleSignal(int)
+{
+    stop_requested.store(true);
+}
+
+// Host side: what the application knows about the device
+class DashboardHost {
+public:
+    DashboardHost(SimulatedDeviceTransport& device)
+        : device(device), rx_total(0), tx_total(0)
+    {
+        snapshot.Clear();
+        snprintf(snapshot.source, sizeof(snapshot.source), "%s", device.Name());
+        device.SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+            OnMIDI(status, data1, data2);
+        });
+    }
+
+    // Host -> device, remembered so the echo can be timed
+    void Send(uint8_t status, uint8_t data1, uint8_t data2) {
+        // Record and send in one order, or echoes would not match up
+        std::lock_guard<std::mutex> send_guard(send_lock);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            in_flight.push_back({ { status, data1, data2 }, system_time() });
+        }
+        if (device.SendMIDI(status, data1, data2) == APC_SUCCESS) {
+            tx_total.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void TakeSnapshot(DashboardSnapshot& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        out = snapshot;
+
+        // LEDs as the device shows them
+        for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+            out.pad_velocity[pad] = device.GetLEDVelocity(APC_MINI_PAD_NOTE_START + pad);
+            out.pad_channel[pad] = device.GetLEDChannel(APC_MINI_PAD_NOTE_START + pad);
+        }
+        for (uint8_t i = 0; i < 8; i++) {
+            out.track_led[i] = device.GetLEDVelocity(APC_MINI_TRACK_NOTE_START + i);
+            out.scene_led[i] = device.GetLEDVelocity(APC_MINI_SCENE_NOTE_START + i);
+        }
+
+        out.latency_p50_us = latency.Percentile(50.0);
+        out.latency_p95_us = latency.Percentile(95.0);
+        out.latency_p99_us = latency.Percentile(99.0);
+        out.latency_max_us = latency.Max();
+        out.rx_total = rx_total.load(std::memory_order_relaxed);
+        out.tx_total = tx_total.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct InFlight {
+        uint8_t bytes[3];
+        bigtime_t sent_at;
+    };
+
+    void OnMIDI(uint8_t status, uint8_t data1, uint8_t data2) {
+        rx_total.fetch_add(1, std::memory_order_relaxed);
+
+        bool pad_hit = false;
+        uint8_t reply_velocity = 0;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            // Echoes arrive in send order; anything else is the performer.
+            // Entries that never came back (lost sync) are dropped after a second
+            while (!in_flight.empty() && system_time() - in_flight.front().sent_at > 1000000) {
+                in_flight.pop_front();
+            }
+            if (!in_flight.empty() && in_flight.front().bytes[0] == status &&
+                in_flight.front().bytes[1] == data1 && in_flight.front().bytes[2] == data2) {
+                latency.Record(system_time() - in_flight.front().sent_at);
+                in_flight.pop_front();
+                return;
+            }
+
+            uint8_t type = status & 0xF0;
+            bool pressed = type == MIDI_NOTE_ON && data2 > 0;
+            if (type == MIDI_NOTE_ON || type == MIDI_NOTE_OFF) {
+                if (IS_PAD_NOTE(data1)) {
+                    snapshot.pad_pressed[data1] = pressed;
+                    pad_hit = pressed;
+                    reply_velocity = (uint8_t)(5 + (data1 * 7) % 120);
+                } else if (IS_TRACK_NOTE(data1)) {
+                    snapshot.track_pressed[data1 - APC_MINI_TRACK_NOTE_START] = pressed;
+                } else if (IS_SCENE_NOTE(data1)) {
+                    snapshot.scene_pressed[data1 - APC_MINI_SCENE_NOTE_START] = pressed;
+                } else if (IS_SHIFT_NOTE(data1)) {
+                    snapshot.shift_pressed = pressed;
+                }
+            } else if (type == MIDI_CONTROL_CHANGE && IS_ANY_FADER_CC(data1)) {
+                snapshot.faders[data1 - APC_MINI_FADER_CC_START] = data2;
+            }
+        }
+
+        // Light the hit pad (callbacks may send)
+        if (pad_hit) {
+            Send(MIDI_NOTE_ON | 6, data1, reply_velocity);
+        }
+    }
+
+    SimulatedDeviceTransport& device;
+    std::mutex send_lock;
+    std::mutex lock;
+    DashboardSnapshot snapshot;
+    std::deque<InFlight> in_flight;
+    LatencyHistogram latency;
+    std::atomic<uint64_t> rx_total;
+    std::atomic<uint64_t> tx_total;
+};
+
+// Pad hits, fader sweeps and button taps on the simulated hardware
+static void RunPerformer(SimulatedDeviceTransport& device)
+{
+    std::mt19937 rng(3);
+    bigtime_t start = system_time();
+    int step = 0;
+    uint8_t held_pad = 0;
+    uint8_t held_scene = 0;
+
+    while (!stop_requested.load()) {
+        snooze(20000);
+        step++;
+
+        double t = (system_time() - start) / 1000000.0;
+        for (int fader = 0; fader < APC_MINI_TOTAL_FADER_COUNT; fader++) {
+            uint8_t value = (uint8_t)(63.5 + 63.5 * sin(t * (0.5 + fader * 0.15)));
+            device.InjectMIDI(MIDI_CONTROL_CHANGE, APC_MINI_FADER_CC_START + fader, value);
+        }
+
+        // Each hit is held until the next one so presses stay visible
+        if (step % 5 == 0) {
+            device.InjectMIDI(MIDI_NOTE_OFF, held_pad, 0);
+            held_pad = rng() % APC_MINI_PAD_COUNT;
+            device.InjectMIDI(MIDI_NOTE_ON, held_pad, 127);
+        }
+        if (step % 25 == 0) {
+            device.InjectMIDI(MIDI_NOTE_OFF, APC_MINI_SCENE_NOTE_START + held_scene, 0);
+            held_scene = rng() % 8;
+            device.InjectMIDI(MIDI_NOTE_ON, APC_MINI_SCENE_NOTE_START + held_scene, 127);
+        }
+    }
+}
+
+// Steady LED animation at rate messages per second
+static void RunAnimation(DashboardHost& host, int rate)
+{
+    if (rate <= 0) {
+        return;
+    }
+
+    bigtime_t interval = 1000000 / rate;
+    bigtime_t next = system_time();
+    uint32_t frame = 0;
+
+    while (!stop_requested.load()) {
+        snooze_until(next, B_SYSTEM_TIMEBASE);
+        next += interval;
+
+        uint8_t pad = frame % APC_MINI_PAD_COUNT;
+        uint8_t row = pad / APC_MINI_PAD_COLS;
+        uint8_t color = (uint8_t)(((frame / APC_MINI_PAD_COUNT) + row) % 32 + 1);
+        host.Send(MIDI_NOTE_ON | 6, pad, color);
+
+        if (pad == 0) {
+            uint8_t button = (frame / APC_MINI_PAD_COUNT) % 8;
+            host.Send(MIDI_NOTE_ON, APC_MINI_TRACK_NOTE_START + button, 1);
+            host.Send(MIDI_NOTE_ON, APC_MINI_TRACK_NOTE_START + (button + 7) % 8, 0);
+        }
+        frame++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int fps = 30;
+    double seconds = 0;
+    int rate = 500;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--fps <n>] [--seconds <s>] [--rate <msg/s>]\n", argv[0]);
+            printf("  Runs until Ctrl+C unless --seconds is given\n");
+            return 1;
+        }
+    }
+    if (fps <= 0 || fps > 240 || rate < 0 || rate > 20000) {
+        printf("❌ --fps must be 1-240 and --rate 0-20000\n");
+        return 1;
+    }
+
+    signal(SIGINT, HandleSignal);
+    signal(SIGTERM, HandleSignal);
+
+    SimulatedDeviceTransport device(SimulatedLinkModel::FullSpeedUSB());
+    DashboardHost host(device);
+    device.Open();
+
+    std::thread performer(RunPerformer, std::ref(device));
+    std::thread animation(RunAnimation, std::ref(host), rate);
+
+    TerminalDashboard dashboard(STDOUT_FILENO);
+    dashboard.Start();
+
+    DashboardSnapshot snapshot;
+    bigtime_t frame_interval = 1000000 / fps;
+    bigtime_t start = system_time();
+    bigtime_t next_frame = start;
+    bigtime_t rate_window_start = start;
+    uint64_t rate_rx = 0;
+    uint64_t rate_tx = 0;
+    double rx_per_sec = 0;
+    double tx_per_sec = 0;
+    size_t full_frame_bytes = 0;
+
+    while (!stop_requested.load()) {
+        bigtime_t now = system_time();
+        if (seconds > 0 && now - start >= (bigtime_t)(seconds * 1000000)) {
+            break;
+        }
+
+        host.TakeSnapshot(snapshot);
+
+        // Rates over one-second windows
+        if (now - rate_window_start >= 1000000) {
+            double window = (now - rate_window_start) / 1000000.0;
+            rx_per_sec = (snapshot.rx_total - rate_rx) / window;
+            tx_per_sec = (snapshot.tx_total - rate_tx) / window;
+            rate_rx = snapshot.rx_total;
+            rate_tx = snapshot.tx_total;
+            rate_window_start = now;
+        }
+        snapshot.rx_per_sec = rx_per_sec;
+        snapshot.tx_per_sec = tx_per_sec;
+
+        DashboardStats stats = dashboard.GetStats();
+        snprintf(snapshot.status, sizeof(snapshot.status), "%d fps | last frame %zu bytes | Ctrl+C quits",
+                 fps, stats.last_frame_bytes);
+
+        size_t written = dashboard.RenderFrame(snapshot);
+        if (full_frame_bytes == 0) {
+            full_frame_bytes = written;
+        }
+
+        next_frame += frame_interval;
+        snooze_until(next_frame, B_SYSTEM_TIMEBASE);
+    }
+
+    stop_requested.store(true);
+    performer.join();
+    animation.join();
+    dashboard.Stop();
+    device.Close();
+
+    DashboardStats stats = dashboard.GetStats();
+    printf("🖥️  Dashboard: %llu frames, %llu written, %.0f bytes/frame on average "
+           "(full repaint %zu bytes)\n",
+           (unsigned long long)stats.frames, (unsigned long long)stats.frames_written,
+           stats.frames > 0 ? (double)stats.bytes_written / stats.frames : 0.0, full_frame_bytes);
+    return 0;
+}
@@ -45,12 +45,44 @@ enum APCMiniLEDColor {
     APC_LED_YELLOW_BLINK= 0x06
 };
 
+// MK2 palette indices (APC_MK2_PRESET_COLORS) for the original's colors;
+// on the MK2 the original velocities 1-6 are grays, white and light reds
+enum APCMiniMK2PaletteColor {
+    APC_MK2_PALETTE_OFF    = 0,
+    APC_MK2_PALETTE_RED    = 5,
+    APC_MK2_PALETTE_YELLOW = 13,
+    APC_MK2_PALETTE_GREEN  = 21
+};
+
 // LED Colors - APC Mini MK2 RGB Support
 enum APCMiniMK2LEDMode {
     APC_MK2_LED_MODE_LEGACY = 0,  // Use original 7-color mode
     APC_MK2_LED_MODE_RGB = 1      // Use full RGB mode via SysEx
 };
 
+// MK2 pad LED behavior, selected by the Note On channel (velocity = color).
+// Pulse and blink run on the device, synced to incoming MIDI clock (or its
+// own default tempo); the fraction is the note value of one cycle
+// (1/4 = one beat).
+enum APCMiniMK2LEDBehavior {
+    APC_MK2_LED_BRIGHTNESS_10 = 0,
+    APC_MK2_LED_BRIGHTNESS_25 = 1,
+    APC_MK2_LED_BRIGHTNESS_50 = 2,
+    APC_MK2_LED_BRIGHTNESS_65 = 3,
+    APC_MK2_LED_BRIGHTNESS_75 = 4,
+    APC_MK2_LED_BRIGHTNESS_90 = 5,
+    APC_MK2_LED_BRIGHTNESS_100 = 6,
+    APC_MK2_LED_PULSE_1_16 = 7,
+    APC_MK2_LED_PULSE_1_8 = 8,
+    APC_MK2_LED_PULSE_1_4 = 9,
+    APC_MK2_LED_PULSE_1_2 = 10,
+    APC_MK2_LED_BLINK_1_24 = 11,
+    APC_MK2_LED_BLINK_1_16 = 12,
+    APC_MK2_LED_BLINK_1_8 = 13,
+    APC_MK2_LED_BLINK_1_4 = 14,
+    APC_MK2_LED_BLINK_1_2 = 15
+};
+
 // MK2 Operating Modes
 enum APCMiniMK2Mode {
     APC_MK2_MODE_SESSION = 0,      // Classic session mode (like original)
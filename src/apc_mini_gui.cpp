@@ -571,6 +571,10 @@ void FaderControl::MouseMoved(BPoint where, uint32 /*code*/, const BMessage* /*m
 
 void FaderControl::MouseUp(BPoint /*where*/)
 {
+    if (is_dragging) {
+        // Final position of the drag, sent even if unchanged
+        SendFaderMessage(true);
+    }
     is_dragging = false;
 }
 
@@ -623,11 +627,12 @@ BPoint FaderControl::ValueToPoint(uint8_t value)
     return BPoint(track_rect.left + track_rect.Width() / 2, y);
 }
 
-void FaderControl::SendFaderMessage()
+void FaderControl::SendFaderMessage(bool released)
 {
     BMessage msg(MSG_FADER_CHANGED);
     msg.AddInt32("fader_index", fader_index);
     msg.AddInt32("value", current_value);
+    msg.AddBool("final", released);
     Window()->PostMessage(&msg);
 }
 
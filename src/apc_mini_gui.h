@@ -26,13 +26,31 @@
 #include <MidiConsumer.h>
 #include <MidiProducer.h>
 
+#include <mutex>
+
 #include "apc_mini_defs.h"
+#include "apc_device_profile.h"
 #include "usb_raw_midi.h"
+#include "midi_pipeline.h"
+#include "outbound_scheduler.h"
+#include "deferred_io.h"
+#include "latency_histogram.h"
 
 // Forward declarations for new MIDI system
 class MIDIMessageQueue;
 class MIDIEventHandler;
 class MIDIEventLooper;
+class RTTProber;
+class RealtimeArena;
+class GestureRecognizer;
+class StateJournal;
+struct JournalState;
+class LatencyWatchdog;
+class CCCoalescer;
+class StagedPipeline;
+
+// Device profile the GUI is laid out for (control map and LED encoding)
+typedef APCMiniMK2Device APCGUIDevice;
 
 // GUI Constants - Hardware Accurate Dimensions
 #define APC_GUI_PAD_SIZE          35    // Size of each pad in pixels
@@ -48,6 +66,9 @@ class MIDIEventLooper;
 #define APC_GUI_MARGIN            20    // Margin around the entire control (increased for better visual breathing room)
 #define APC_GUI_CORNER_RADIUS     3     // Radius for rounded corners
 
+// Hardware pad feedback lit from the reader thread (MK2 palette white)
+#define APC_GUI_ECHO_VELOCITY     3
+
 // Color Constants (matching real APC Mini MK2)
 #define APC_GUI_BACKGROUND_COLOR  rgb_color{18, 17, 16, 255}    // Very dark background with warm tone
 #define APC_GUI_DEVICE_BODY_COLOR rgb_color{30, 29, 28, 255}    // Matte black device body with warm tone
@@ -193,7 +214,7 @@ private:
     BRect GetKnobRect();
     uint8_t PointToValue(BPoint point);
     BPoint ValueToPoint(uint8_t value);
-    void SendFaderMessage();
+    void SendFaderMessage(bool released = false);
 
     // Enhanced drawing methods
     void DrawFaderScale(BRect track_rect);
@@ -291,13 +312,15 @@ public:
 
     virtual void MessageReceived(BMessage* message) override;
     virtual bool QuitRequested() override;
+    // Times every dispatch: the window lock is held throughout
+    virtual void DispatchMessage(BMessage* message, BHandler* handler) override;
 
     // Hardware interface
     void UpdateFromDevice(const APCMiniState& state);
     void HandlePadPress(uint8_t pad_index, uint8_t velocity);
     void HandlePadRelease(uint8_t pad_index);
-    void UpdatePadPressDirectly(uint8_t pad_index, uint8_t velocity); // Ultra-low latency direct update
-    void UpdatePadReleaseDirectly(uint8_t pad_index); // Ultra-low latency direct update
+    void UpdatePadPressDirectly(uint8_t pad_index, uint8_t velocity, bool from_hardware = false); // Ultra-low latency direct update
+    void UpdatePadReleaseDirectly(uint8_t pad_index, bool from_hardware = false); // Ultra-low latency direct update
     void HandleFaderChange(uint8_t fader_index, uint8_t value);
     void UpdateFaderDirectly(uint8_t fader_index, uint8_t value); // Ultra-low latency direct update
     void UpdateTrackButtonDirectly(uint8_t button_index, bool pressed); // Ultra-low latency direct update
@@ -336,9 +359,12 @@ public:
     ControlButton* track_buttons[8];
 
     bool is_connected;
+    // Window thread lock hold per dispatch ("window.lock_hold_us")
+    LatencyHistogram lock_hold;
     // Per-fader ignore flags to prevent feedback loops without blocking other faders
     bool ignore_hardware_updates[9];  // One flag per fader (8 track + 1 master)
     bigtime_t ignore_flag_timestamp[9]; // When each ignore flag was set
+    static constexpr bigtime_t FADER_ECHO_IGNORE_US = 20000;
 
     void InitializeInterface();
     void CreateMenuBar();
@@ -373,11 +399,20 @@ public:
     APCMiniMIDIProducer();
 };
 
+// Work the window and sender threads hand to the deferred I/O thread
+enum APCGUIDeferredIO {
+    APC_GUI_IO_SPRAY = 0,       // Patchbay output of a message
+    APC_GUI_IO_LOG_TX,          // Debug log line for a message sent to the device
+    APC_GUI_IO_LOG_RX           // Debug log line for a received message the window applied
+};
+
 // Main Application Class
 class APCMiniGUIApp : public BApplication {
     friend class APCMiniMIDIConsumer; // Allow MIDI consumer to access private methods
 public:
-    APCMiniGUIApp();
+    // staged_input: run the input pipeline on its own worker thread
+    // (StagedPipeline) instead of fused on the USB reader thread
+    explicit APCMiniGUIApp(bool staged_input = false);
     virtual ~APCMiniGUIApp();
 
     virtual void ReadyToRun() override;
@@ -390,10 +425,15 @@ public:
     bool IsHardwareConnected() const;
 
     // MIDI communication
-    void SendNoteOn(uint8_t note, uint8_t velocity);
-    void SendNoteOff(uint8_t note);
+    // update_led false: an echo rule already set the LED (Patchbay/state only)
+    void SendNoteOn(uint8_t note, uint8_t velocity, bool update_led = true);
+    void SendNoteOff(uint8_t note, bool update_led = true);
     void SendControlChange(uint8_t controller, uint8_t value);
+    // GUI drags: coalesced to one CC per output tick, final sent at once
+    void QueueControlChange(uint8_t controller, uint8_t value, bool released);
     void SendPadRGB(uint8_t pad_index, const APCMiniMK2RGB& color);
+    // True if hardware presses of this note are lit by the reader thread
+    bool IsLEDEchoed(uint8_t note) const { return led_echo && led_echo->HasRule(note); }
     void SetTrackButtonLED(uint8_t button_index, bool on);
     void SetSceneButtonLED(uint8_t button_index, bool on);
 
@@ -410,7 +450,24 @@ public:
     // MIDI handling (public for thread-safe message passing)
     void HandleMIDIMessage(uint8_t status, uint8_t data1, uint8_t data2);
 
+    // Window thread: queue the debug log line for a dispatched USB message
+    void LogReceivedMIDI(const MIDIMessage& message);
+
+    // Window thread: a hardware batch posted at dispatched_at has been applied
+    void NoteBatchDrawn(bigtime_t dispatched_at, size_t count);
+
 private:
+    // Queue an LED message on the outbound scheduler (dropped while it is stopped)
+    void SendOutbound(OutboundQoS qos, uint8_t status, uint8_t data1, uint8_t data2);
+    // Patchbay spray and debug log line, off the calling thread
+    void SendSideEffects(uint8_t status, uint8_t data1, uint8_t data2, bool to_device);
+    void RunDeferredIO(const DeferredIOItem& item);
+    // Wire side of SendControlChange; the coalescer's flusher calls it, so
+    // it must not touch device_state
+    void TransmitControlChange(uint8_t controller, uint8_t value);
+    // Window thread only
+    void UpdateFaderState(uint8_t controller, uint8_t value);
+
     APCMiniWindow* main_window;
     USBRawMIDI* usb_midi;
     APCMiniState device_state;
@@ -418,19 +475,68 @@ private:
     volatile bool should_stop;
     bool use_hardware;
 
+    // Pre-faulted memory for realtime structures (owns midi_queue's storage)
+    RealtimeArena* realtime_arena;
+
     // New MIDI system components
     MIDIMessageQueue* midi_queue;
     MIDIEventHandler* midi_handler;
     MIDIEventLooper* midi_looper;
 
+    // Long-press / double-tap / Shift-combo detection on the looper thread,
+    // which is the only producer of gesture_queue
+    GestureRecognizer* gesture_recognizer;
+    MIDIMessageQueue* gesture_queue;
+
+    // Fused reader-thread chain: filter -> normalize -> state -> echo -> dedup -> midi_queue
+    PipelineControlState input_state;
+    APCInputPipeline<APCGUIDevice>* input_pipeline;
+    StagedPipeline* staged_input;   // Runs input_pipeline on a worker; nullptr = inline
+
     // Patchbay integration
     APCMiniMIDIConsumer* midi_consumer;
     APCMiniMIDIProducer* midi_producer;
 
+    // Link latency monitoring (MK2 introduction round trip)
+    RTTProber* rtt_prober;
+
+    // Last LED/fader state, persisted across restarts (memory-mapped file).
+    // The window, MIDI Kit and app threads edit journal_state under
+    // journal_lock and mark it dirty; apc_sync commits it once per tick
+    StateJournal* state_journal;
+    JournalState* journal_state;
+    std::mutex journal_lock;
+    bool journal_dirty;
+
+    // Latest-value slots for GUI fader drags, flushed once per tick
+    CCCoalescer* cc_coalescer;
+
+    // Outbound LED traffic by class: feedback ahead of patterns and resets
+    OutboundScheduler* outbound;
+
+    // Press/release LED feedback evaluated in input_pipeline (reader thread)
+    LEDEchoRules* led_echo;
+
+    // Patchbay sprays and debug log lines, so the window never blocks on them
+    DeferredIOQueue* deferred_io;
+
+    // Drops the MIDI Kit copy of events USB already delivered (and vice versa)
+    IngressDeduplicator* ingress_dedup;
+
+    // Stage budgets and heartbeats; dumps the flight recorder on a glitch
+    LatencyWatchdog* watchdog;
+    int watchdog_dispatch_budget;      // reader -> looper dispatch
+    int watchdog_draw_budget;          // looper dispatch -> window applied
+    int watchdog_looper_heartbeat;
+    int watchdog_sync_heartbeat;
+
     // MIDI handling (private methods)
     void HandleNoteOn(uint8_t note, uint8_t velocity);
     void HandleNoteOff(uint8_t note, uint8_t velocity);
     void HandleControlChange(uint8_t controller, uint8_t value);
+    void UpdateNoteState(uint8_t note, bool pressed, uint8_t velocity);
+    // MIDI Kit consumer input: false for a copy of a USB event
+    bool AcceptPatchbayInput(uint8_t status, uint8_t data1, uint8_t data2);
 
     // New MIDI system integration
     void RegisterMIDICallbacks();
@@ -443,6 +549,9 @@ private:
     void UpdateGUIFromState();
     void InitializeDeviceState();
     void QueryFaderPositions(); // Interrogate hardware for current fader positions
+    bool RestoreFromJournal();  // Faders and LEDs as they were before the restart
+    void JournalLED(uint8_t note, uint8_t channel, uint8_t velocity);
+    void CommitJournal(bool flush_to_disk = false);   // Writes only if dirty
     uint8_t ScanSingleFader(uint8_t cc_number); // Scan individual fader position
     rgb_color MIDIVelocityToRGB(uint8_t velocity);
     APCMiniMK2RGB VelocityToMK2RGB(uint8_t velocity);
@@ -1,9 +1,11 @@
 #include "apc_mini_gui.h"
+#include "midi_message_queue.h"
+#include "midi_message_batch.h"
+#include "metrics_registry.h"
 #include <Roster.h>
 #include <Path.h>
 #include <Resources.h>
 #include <Alert.h>
-#include <MessageRunner.h>
 #include <stdio.h>
 
 // ===============================
@@ -37,6 +39,8 @@ APCMiniWindow::APCMiniWindow()
         ignore_flag_timestamp[i] = 0;
     }
 
+    MetricsRegistry::Default().RegisterHistogram("window.lock_hold_us", &lock_hold);
+
     InitializeInterface();
 
     // Debug window will be created on demand when requested
@@ -51,6 +55,16 @@ APCMiniWindow::APCMiniWindow()
 
 APCMiniWindow::~APCMiniWindow()
 {
+    MetricsRegistry::Default().Unregister(&lock_hold);
+}
+
+void APCMiniWindow::DispatchMessage(BMessage* message, BHandler* handler)
+{
+    // The looper holds the window lock around every dispatch, so this is
+    // how long drawing and input wait behind one message
+    bigtime_t start = system_time();
+    BWindow::DispatchMessage(message, handler);
+    lock_hold.Record(system_time() - start);
 }
 
 void APCMiniWindow::MessageReceived(BMessage* message)
@@ -61,15 +75,16 @@ void APCMiniWindow::MessageReceived(BMessage* message)
             int32 pad_index;
             bool pressed;
             int32 velocity;
+            bool from_hardware = message->GetBool("apc:hardware", false);
 
             if (message->FindInt32("pad_index", &pad_index) == B_OK &&
                 message->FindBool("pressed", &pressed) == B_OK &&
                 message->FindInt32("velocity", &velocity) == B_OK) {
 
                 if (pressed) {
-                    UpdatePadPressDirectly(pad_index, velocity);
+                    UpdatePadPressDirectly(pad_index, velocity, from_hardware);
                 } else {
-                    UpdatePadReleaseDirectly(pad_index);
+                    UpdatePadReleaseDirectly(pad_index, from_hardware);
                 }
             }
             break;
@@ -86,12 +101,16 @@ void APCMiniWindow::MessageReceived(BMessage* message)
                 // This is a GUI-initiated change, send to hardware
                 // printf("GUI fader %d changed to %d - sending to hardware\n", (int)fader_index, (int)value); // Disabled for performance
 
-                // Set per-fader flag to ignore feedback from hardware for a short time
+                // Ignore hardware echoes of this fader for FADER_ECHO_IGNORE_US;
+                // the timestamp expires the flag, no timer per move
                 uint8_t fader_idx = (fader_index < APC_MINI_TRACK_FADER_COUNT) ? fader_index : APC_MINI_TRACK_FADER_COUNT;
                 ignore_hardware_updates[fader_idx] = true;
                 ignore_flag_timestamp[fader_idx] = system_time();
 
-                // Send to hardware
+                // Drags are coalesced to one CC per output tick; the release
+                // carries the final value and is sent at once
+                bool released = false;
+                message->FindBool("final", &released);
                 if (app) {
                     uint8_t cc_number;
                     if (fader_index < APC_MINI_TRACK_FADER_COUNT) {
@@ -99,19 +118,7 @@ void APCMiniWindow::MessageReceived(BMessage* message)
                     } else {
                         cc_number = APC_MINI_MASTER_CC;
                     }
-                    static_cast<APCMiniGUIApp*>(app)->SendControlChange(cc_number, value);
-                }
-
-                // Clear per-fader flag after ultra-minimal delay (aggressive low latency)
-                BMessage* clear_flag = new BMessage(MSG_HARDWARE_FADER_CHANGE);
-                clear_flag->AddBool("clear_flag", true);
-                clear_flag->AddInt32("fader_index", fader_idx); // Include which fader to clear
-                // Ultra-low latency: minimal delay for immediate responsiveness
-                if (BMessageRunner::StartSending(this, clear_flag, 20000, 1) != B_OK) {
-                    // If BMessageRunner fails, clear flag immediately to prevent permanent blocking
-                    ignore_hardware_updates[fader_idx] = false;
-                    ignore_flag_timestamp[fader_idx] = 0;
-                    printf("Warning: BMessageRunner failed, clearing ignore flag immediately\n");
+                    static_cast<APCMiniGUIApp*>(app)->QueueControlChange(cc_number, value, released);
                 }
             }
             break;
@@ -185,19 +192,6 @@ void APCMiniWindow::MessageReceived(BMessage* message)
 
         case MSG_HARDWARE_FADER_CHANGE:
         {
-            bool clear_flag;
-            if (message->FindBool("clear_flag", &clear_flag) == B_OK && clear_flag) {
-                // This is the delayed message to clear the per-fader ignore flag
-                int32 clear_fader_index;
-                if (message->FindInt32("fader_index", &clear_fader_index) == B_OK &&
-                    clear_fader_index >= 0 && clear_fader_index < 9) {
-                    ignore_hardware_updates[clear_fader_index] = false;
-                    ignore_flag_timestamp[clear_fader_index] = 0;
-                    // printf("Cleared ignore flag for fader %d via timer\n", (int)clear_fader_index); // Disabled for performance
-                }
-                break;
-            }
-
             int32 fader_index, value;
             if (message->FindInt32("fader_index", &fader_index) == B_OK &&
                 message->FindInt32("value", &value) == B_OK) {
@@ -205,10 +199,10 @@ void APCMiniWindow::MessageReceived(BMessage* message)
                 // Check if we should ignore hardware updates for this specific fader (to prevent feedback loops)
                 uint8_t fader_idx = (fader_index < APC_MINI_TRACK_FADER_COUNT) ? fader_index : APC_MINI_TRACK_FADER_COUNT;
                 if (ignore_hardware_updates[fader_idx]) {
-                    // Safety check: if too much time has passed, clear the flag to prevent permanent blocking
+                    // The flag expires FADER_ECHO_IGNORE_US after the last GUI move
                     bigtime_t current_time = system_time();
-                    if (current_time - ignore_flag_timestamp[fader_idx] > 50000) { // 50ms safety timeout
-                        // Silently clear stuck ignore flag to prevent permanent blocking
+                    if (current_time - ignore_flag_timestamp[fader_idx] > FADER_ECHO_IGNORE_US) {
+                        // Echo window over: accept hardware updates again
                         ignore_hardware_updates[fader_idx] = false;
                         ignore_flag_timestamp[fader_idx] = 0;
                     } else {
@@ -252,11 +246,19 @@ void APCMiniWindow::MessageReceived(BMessage* message)
 
         case MSG_HARDWARE_MIDI_EVENT:
         {
-            uint8_t status, data1, data2;
-            if (message->FindUInt8("status", &status) == B_OK &&
-                message->FindUInt8("data1", &data1) == B_OK &&
-                message->FindUInt8("data2", &data2) == B_OK && app) {
-                static_cast<APCMiniGUIApp*>(app)->HandleMIDIMessage(status, data1, data2);
+            MIDIMessageBatch batch;
+            if (MIDIMessageQueue::ExtractBatchFromBMessage(message, batch) && app) {
+                MIDIMessage midi_msg;
+                for (size_t i = 0; i < batch.Count(); i++) {
+                    batch.Get(i, midi_msg);
+                    static_cast<APCMiniGUIApp*>(app)->HandleMIDIMessage(
+                        midi_msg.status, midi_msg.data1, midi_msg.data2);
+                    static_cast<APCMiniGUIApp*>(app)->LogReceivedMIDI(midi_msg);
+                }
+                bigtime_t dispatched_at = 0;
+                if (message->FindInt64("apc:dispatched", &dispatched_at) == B_OK) {
+                    static_cast<APCMiniGUIApp*>(app)->NoteBatchDrawn(dispatched_at, batch.Count());
+                }
             }
             break;
         }
@@ -324,27 +326,43 @@ void APCMiniWindow::UpdateFromDevice(const APCMiniState& state)
     }
 }
 
-void APCMiniWindow::UpdatePadPressDirectly(uint8_t pad_index, uint8_t velocity)
+void APCMiniWindow::UpdatePadPressDirectly(uint8_t pad_index, uint8_t velocity,
+                                          bool from_hardware)
 {
-    if (app && Lock()) {
-        uint8_t note = APC_MINI_PAD_NOTE_START + pad_index;
-        static_cast<APCMiniGUIApp*>(app)->SendNoteOn(note, velocity);
-
-        // Visual feedback - cycle through colors for demo
-        static int color_cycle = 0;
-        APCMiniMK2RGB demo_colors[] = {
-            {127, 0, 0},    // Red
-            {0, 127, 0},    // Green
-            {0, 0, 127},    // Blue
-            {127, 127, 0},  // Yellow
-            {127, 0, 127},  // Magenta
-            {0, 127, 127},  // Cyan
-        };
-
-        SetPadColor(pad_index, demo_colors[color_cycle % 6]);
-        color_cycle++;
+    if (!app) {
+        return;
+    }
+
+    uint8_t note = APC_MINI_PAD_NOTE_START + pad_index;
+    APCMiniGUIApp* gui_app = static_cast<APCMiniGUIApp*>(app);
+
+    // The reader thread already lit this pad; only the GUI needs updating
+    bool echoed = from_hardware && gui_app->IsLEDEchoed(note);
+
+    // Visual feedback - cycle through colors for demo
+    static int color_cycle = 0;
+    APCMiniMK2RGB demo_colors[] = {
+        {127, 0, 0},    // Red
+        {0, 127, 0},    // Green
+        {0, 0, 127},    // Blue
+        {127, 127, 0},  // Yellow
+        {127, 0, 127},  // Magenta
+        {0, 127, 127},  // Cyan
+    };
+    APCMiniMK2RGB color = demo_colors[color_cycle % 6];
+    color_cycle++;
+
+    // View state under the lock; device and Patchbay messages only queued
+    if (Lock()) {
+        if (pad_matrix) {
+            pad_matrix->SetPadColor(pad_index, color);
+        }
         Unlock();
     }
+    gui_app->SendNoteOn(note, velocity, !echoed);
+    if (!echoed) {
+        gui_app->SendPadRGB(pad_index, color);
+    }
 }
 
 void APCMiniWindow::HandlePadPress(uint8_t pad_index, uint8_t velocity)
@@ -352,23 +370,24 @@ void APCMiniWindow::HandlePadPress(uint8_t pad_index, uint8_t velocity)
     // Try direct update if we're already in the main thread (ultra-low latency path)
     if (find_thread(NULL) == Thread()) {
         // Direct update - no message queue latency
-        UpdatePadPressDirectly(pad_index, velocity);
+        UpdatePadPressDirectly(pad_index, velocity, true);
     } else {
         // Send message to main thread to update GUI safely
         BMessage msg(MSG_PAD_PRESSED);
         msg.AddInt32("pad_index", pad_index);
         msg.AddBool("pressed", true);
         msg.AddInt32("velocity", velocity);
+        msg.AddBool("apc:hardware", true);
         PostMessage(&msg);
     }
 }
 
-void APCMiniWindow::UpdatePadReleaseDirectly(uint8_t pad_index)
+void APCMiniWindow::UpdatePadReleaseDirectly(uint8_t pad_index, bool from_hardware)
 {
-    if (app && Lock()) {
+    if (app) {
         uint8_t note = APC_MINI_PAD_NOTE_START + pad_index;
-        static_cast<APCMiniGUIApp*>(app)->SendNoteOff(note);
-        Unlock();
+        APCMiniGUIApp* gui_app = static_cast<APCMiniGUIApp*>(app);
+        gui_app->SendNoteOff(note, !(from_hardware && gui_app->IsLEDEchoed(note)));
     }
 }
 
@@ -377,13 +396,14 @@ void APCMiniWindow::HandlePadRelease(uint8_t pad_index)
     // Try direct update if we're already in the main thread (ultra-low latency path)
     if (find_thread(NULL) == Thread()) {
         // Direct update - no message queue latency
-        UpdatePadReleaseDirectly(pad_index);
+        UpdatePadReleaseDirectly(pad_index, true);
     } else {
         // Send message to main thread to update GUI safely
         BMessage msg(MSG_PAD_PRESSED);
         msg.AddInt32("pad_index", pad_index);
         msg.AddBool("pressed", false);
         msg.AddInt32("velocity", 0);
+        msg.AddBool("apc:hardware", true);
         PostMessage(&msg);
     }
 }
@@ -409,7 +429,7 @@ void APCMiniWindow::UpdateFaderDirectly(uint8_t fader_index, uint8_t value)
     uint8_t fader_idx = (fader_index < APC_MINI_TRACK_FADER_COUNT) ? fader_index : APC_MINI_TRACK_FADER_COUNT;
     if (ignore_hardware_updates[fader_idx]) {
         bigtime_t current_time = system_time();
-        if (current_time - ignore_flag_timestamp[fader_idx] > 50000) { // 50ms safety timeout
+        if (current_time - ignore_flag_timestamp[fader_idx] > FADER_ECHO_IGNORE_US) {
             ignore_hardware_updates[fader_idx] = false;
             ignore_flag_timestamp[fader_idx] = 0;
         } else {
@@ -426,19 +446,24 @@ void APCMiniWindow::UpdateFaderDirectly(uint8_t fader_index, uint8_t value)
 
 void APCMiniWindow::UpdateTrackButtonDirectly(uint8_t button_index, bool pressed)
 {
-    if (app && button_index < 8 && Lock()) {
-        uint8_t note = APC_MINI_TRACK_NOTE_START + button_index;
-        if (pressed) {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOn(note, 127);
-            // Toggle LED state for individual track button
-            if (track_buttons[button_index]) {
-                track_buttons[button_index]->SetLEDOn(!track_buttons[button_index]->IsPressed());
-            }
-        } else {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOff(note);
+    if (!app || button_index >= 8) {
+        return;
+    }
+
+    // Toggle LED state for individual track button
+    if (pressed && Lock()) {
+        if (track_buttons[button_index]) {
+            track_buttons[button_index]->SetLEDOn(!track_buttons[button_index]->IsPressed());
         }
         Unlock();
     }
+
+    uint8_t note = APC_MINI_TRACK_NOTE_START + button_index;
+    if (pressed) {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOn(note, 127);
+    } else {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOff(note);
+    }
 }
 
 void APCMiniWindow::HandleTrackButton(uint8_t button_index, bool pressed)
@@ -458,17 +483,22 @@ void APCMiniWindow::HandleTrackButton(uint8_t button_index, bool pressed)
 
 void APCMiniWindow::UpdateSceneButtonDirectly(uint8_t button_index, bool pressed)
 {
-    if (app && button_index < 8 && Lock()) {
-        uint8_t note = APC_MINI_SCENE_NOTE_START + button_index;
-        if (pressed) {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOn(note, 127);
-            // Toggle LED state
-            button_panel->SetSceneButtonLED(button_index, !button_panel->ChildAt(button_index + 8));
-        } else {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOff(note);
-        }
+    if (!app || button_index >= 8) {
+        return;
+    }
+
+    // Toggle LED state
+    if (pressed && Lock()) {
+        button_panel->SetSceneButtonLED(button_index, !button_panel->ChildAt(button_index + 8));
         Unlock();
     }
+
+    uint8_t note = APC_MINI_SCENE_NOTE_START + button_index;
+    if (pressed) {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOn(note, 127);
+    } else {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOff(note);
+    }
 }
 
 void APCMiniWindow::HandleSceneButton(uint8_t button_index, bool pressed)
@@ -488,13 +518,15 @@ void APCMiniWindow::HandleSceneButton(uint8_t button_index, bool pressed)
 
 void APCMiniWindow::UpdateShiftButtonDirectly(bool pressed)
 {
-    if (app && Lock()) {
-        if (pressed) {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOn(APC_MINI_SHIFT_NOTE, 127);
-        } else {
-            static_cast<APCMiniGUIApp*>(app)->SendNoteOff(APC_MINI_SHIFT_NOTE);
-        }
-        Unlock();
+    if (!app) {
+        return;
+    }
+
+    // No view state for Shift; the messages are only queued
+    if (pressed) {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOn(APC_MINI_SHIFT_NOTE, 127);
+    } else {
+        static_cast<APCMiniGUIApp*>(app)->SendNoteOff(APC_MINI_SHIFT_NOTE);
     }
 }
 
@@ -1,6 +1,15 @@
 #include "apc_mini_gui.h"
 #include "midi_message_queue.h"
 #include "midi_event_handler.h"
+#include "metrics_registry.h"
+#include "rtt_prober.h"
+#include "realtime_arena.h"
+#include "gesture_recognizer.h"
+#include "thread_accounting.h"
+#include "state_journal.h"
+#include "latency_watchdog.h"
+#include "cc_coalescer.h"
+#include "staged_pipeline.h"
 #include <stdio.h>
 #include <signal.h>
 
@@ -28,20 +37,20 @@ APCMiniMIDIConsumer::APCMiniMIDIConsumer(APCMiniGUIApp* app) : gui_app(app) {
     delete properties;
 }
 
-void APCMiniMIDIConsumer::NoteOn(uchar /*channel*/, uchar note, uchar velocity, bigtime_t /*time*/) {
-    if (gui_app) {
+void APCMiniMIDIConsumer::NoteOn(uchar channel, uchar note, uchar velocity, bigtime_t /*time*/) {
+    if (gui_app && gui_app->AcceptPatchbayInput(MIDI_NOTE_ON | channel, note, velocity)) {
         gui_app->HandleNoteOn(note, velocity);
     }
 }
 
-void APCMiniMIDIConsumer::NoteOff(uchar /*channel*/, uchar note, uchar velocity, bigtime_t /*time*/) {
-    if (gui_app) {
+void APCMiniMIDIConsumer::NoteOff(uchar channel, uchar note, uchar velocity, bigtime_t /*time*/) {
+    if (gui_app && gui_app->AcceptPatchbayInput(MIDI_NOTE_OFF | channel, note, velocity)) {
         gui_app->HandleNoteOff(note, velocity);
     }
 }
 
-void APCMiniMIDIConsumer::ControlChange(uchar /*channel*/, uchar controller, uchar value, bigtime_t /*time*/) {
-    if (gui_app) {
+void APCMiniMIDIConsumer::ControlChange(uchar channel, uchar controller, uchar value, bigtime_t /*time*/) {
+    if (gui_app && gui_app->AcceptPatchbayInput(MIDI_CONTROL_CHANGE | channel, controller, value)) {
         gui_app->HandleControlChange(controller, value);
     }
 }
@@ -72,25 +81,163 @@ APCMiniMIDIProducer::APCMiniMIDIProducer() {
 
 const char* APC_GUI_APP_SIGNATURE = "application/x-vnd.akai-apc-mini-gui";
 
-APCMiniGUIApp::APCMiniGUIApp()
+APCMiniGUIApp::APCMiniGUIApp(bool staged_input_enabled)
     : BApplication(APC_GUI_APP_SIGNATURE)
     , main_window(nullptr)
     , usb_midi(nullptr)
     , sync_thread(-1)
     , should_stop(false)
     , use_hardware(true)
+    , realtime_arena(nullptr)
     , midi_queue(nullptr)
     , midi_handler(nullptr)
     , midi_looper(nullptr)
+    , gesture_recognizer(nullptr)
+    , gesture_queue(nullptr)
+    , input_pipeline(nullptr)
+    , staged_input(nullptr)
     , midi_consumer(nullptr)
     , midi_producer(nullptr)
+    , rtt_prober(nullptr)
+    , state_journal(nullptr)
+    , journal_state(nullptr)
+    , journal_dirty(false)
+    , cc_coalescer(nullptr)
+    , outbound(nullptr)
+    , led_echo(nullptr)
+    , deferred_io(nullptr)
+    , ingress_dedup(nullptr)
+    , watchdog(nullptr)
+    , watchdog_dispatch_budget(-1)
+    , watchdog_draw_budget(-1)
+    , watchdog_looper_heartbeat(-1)
+    , watchdog_sync_heartbeat(-1)
 {
     InitializeDeviceState();
 
+    // Map the state journal first so restore can start as soon as the
+    // device is open
+    state_journal = new StateJournal(&MetricsRegistry::Default());
+    journal_state = new JournalState();
+    journal_state->Clear();
+    char journal_path[B_PATH_NAME_LENGTH];
+    if (!StateJournal::DefaultPath(journal_path, sizeof(journal_path)) ||
+        state_journal->Open(journal_path) != APC_SUCCESS) {
+        printf("⚠️  State journal unavailable, state will not survive a restart\n");
+    }
+
+    // Everything the USB reader, looper and outbound writer touch per event
+    // comes from one pre-faulted, locked arena, so those threads never take
+    // a first-touch page fault. Exempt: the flight recorder, which is
+    // process-wide, exists before the arena and touches its slots when
+    // built; the deferred I/O ring, which only the window and I/O threads
+    // use; the staged input rings, filled in when StagedPipeline::Start()
+    // builds them; and outbound SysEx, which is not on a realtime path.
+    realtime_arena = new RealtimeArena();
+    realtime_arena->Reserve<MIDIMessageQueue>("midi_queue");
+    realtime_arena->Reserve<MIDIMessageQueue>("gesture_queue");
+    realtime_arena->Reserve<GestureRecognizer>("gesture_recognizer");
+    realtime_arena->Reserve<LEDEchoRules>("led_echo");
+    realtime_arena->Reserve<IngressDeduplicator>("ingress_dedup");
+    realtime_arena->Reserve<CCCoalescer>("cc_coalescer");
+    realtime_arena->Reserve<OutboundScheduler>("outbound");
+    if (realtime_arena->Commit(true) == APC_SUCCESS) {
+        realtime_arena->RegisterMetrics(&MetricsRegistry::Default());
+    } else {
+        printf("⚠️  Realtime arena unavailable, realtime structures allocated from heap\n");
+    }
+
     // Initialize new MIDI system
-    midi_queue = new MIDIMessageQueue();
+    midi_queue = realtime_arena->NewOrHeap<MIDIMessageQueue>("midi_queue");
     midi_handler = new MIDIEventHandler("APC Mini MIDI Handler");
     midi_handler->SetMessageQueue(midi_queue);
+    // Gestures have their own queue: midi_queue's producer is the reader
+    gesture_queue = realtime_arena->NewOrHeap<MIDIMessageQueue>("gesture_queue");
+    gesture_recognizer = realtime_arena->NewOrHeap<GestureRecognizer>("gesture_recognizer",
+                                                                      gesture_queue);
+    midi_handler->SetGestureRecognizer(gesture_recognizer, gesture_queue);
+
+    // Pad presses light their LED from the reader thread, one hop to USB;
+    // the window thread only redraws them
+    led_echo = realtime_arena->NewOrHeap<LEDEchoRules>("led_echo",
+        [this](uint8_t status, uint8_t data1, uint8_t data2) {
+            return outbound ? outbound->Send(OUTBOUND_QOS_INTERACTIVE, status, data1, data2)
+                            : APC_ERROR_DEVICE_NOT_FOUND;
+        }, &MetricsRegistry::Default());
+    led_echo->SetPadRule(LEDEchoRule::Light(APC_GUI_ECHO_VELOCITY));
+
+    // USB and a Patchbay-connected MIDI Kit port carry the same controller
+    ingress_dedup = realtime_arena->NewOrHeap<IngressDeduplicator>(
+        "ingress_dedup", IngressDeduplicator::DEFAULT_WINDOW_US, &MetricsRegistry::Default());
+    input_pipeline = new APCInputPipeline<APCGUIDevice>(
+        MakeAPCInputPipeline<APCGUIDevice>(&input_state, midi_queue, led_echo, ingress_dedup));
+
+    // Optionally hand the whole chain to one worker: the reader only
+    // copies into a ring, the worker is then midi_queue's single producer
+    if (staged_input_enabled) {
+        staged_input = new StagedPipeline(&MetricsRegistry::Default());
+        staged_input->AddStage("input", input_pipeline);
+        if (staged_input->Start(StagedPipelineLayout::Spread(1, 1)) != APC_SUCCESS) {
+            printf("⚠️  Staged input pipeline not started, running inline\n");
+            delete staged_input;
+            staged_input = nullptr;
+        }
+    }
+
+    // GUI fader drags go out at most once per controller per millisecond
+    cc_coalescer = realtime_arena->NewOrHeap<CCCoalescer>("cc_coalescer",
+        [this](uint8_t controller, uint8_t value) {
+            TransmitControlChange(controller, value);
+        }, CCCoalescer::DEFAULT_TICK_US, &MetricsRegistry::Default());
+    cc_coalescer->Start();
+
+    // One writer for LED traffic: a pad's feedback LED no longer waits
+    // behind a full-grid pattern frame or a reset. Packets per transfer are
+    // tuned to the host controller at runtime.
+    OutboundSchedulerConfig outbound_config = OutboundSchedulerConfig::Defaults();
+    outbound_config.autotune = true;
+    outbound = realtime_arena->NewOrHeap<OutboundScheduler>("outbound",
+        [this](const uint8_t (*messages)[3], size_t count) {
+            return usb_midi ? usb_midi->SendMIDIBatch(messages, count) : APC_ERROR_DEVICE_NOT_FOUND;
+        },
+        [this](const uint8_t* data, size_t length) {
+            if (!usb_midi) {
+                return APC_ERROR_DEVICE_NOT_FOUND;
+            }
+            // Handshakes sent here must not be taken for probe replies
+            if (rtt_prober) {
+                rtt_prober->NoteSysExSent(data, length);
+            }
+            return usb_midi->SendSysEx(data, length);
+        },
+        outbound_config, &MetricsRegistry::Default());
+
+    // Patchbay sprays and debug log lines leave the window thread
+    deferred_io = new DeferredIOQueue([this](const DeferredIOItem& item) {
+        RunDeferredIO(item);
+    }, DeferredIOQueue::DEFAULT_CAPACITY, &MetricsRegistry::Default());
+    deferred_io->Start();
+    realtime_arena->Print(stdout);
+
+    // Latency budgets: a pad press should be dispatched within 500 us of
+    // the looper's next poll and on screen within a frame. The reader ->
+    // dispatch figure includes the wait for that poll, so the budget sits a
+    // full polling interval above the 500 us. The USB reader blocks in the
+    // transfer while the controller is idle, so it has no heartbeat; a
+    // stalled reader shows up as a reader->dispatch violation instead
+    watchdog = &LatencyWatchdog::Default();
+    watchdog_dispatch_budget = watchdog->AddBudget("reader_dispatch",
+        MIDIEventLooper::DEFAULT_POLLING_INTERVAL_US + 500);
+    watchdog_draw_budget = watchdog->AddBudget("dispatch_draw", 16000);
+    watchdog_looper_heartbeat = watchdog->AddHeartbeat("midi_processing", 250000);
+    watchdog_sync_heartbeat = watchdog->AddHeartbeat("apc_sync", 500000);
+    watchdog->AddGauge("midi_queue.depth", [this]() {
+        return (uint64_t)midi_queue->GetQueueDepth();
+    });
+    midi_handler->SetWatchdog(watchdog, watchdog_dispatch_budget, watchdog_looper_heartbeat);
+    if (watchdog->Start() != APC_SUCCESS) {
+        printf("⚠️  Latency watchdog not started, glitches will not be dumped\n");
+    }
 
     // Initialize Patchbay integration
     midi_consumer = new APCMiniMIDIConsumer(this);
@@ -107,7 +254,20 @@ APCMiniGUIApp::APCMiniGUIApp()
 
 APCMiniGUIApp::~APCMiniGUIApp()
 {
+    // Sends the last dragged values while the device is still open
+    realtime_arena->Destroy(cc_coalescer);
+    cc_coalescer = nullptr;
+
+    // Flushes queued LEDs and stops the reader; echoes send into outbound
+    // until then
     ShutdownHardware();
+    realtime_arena->Destroy(outbound);
+    outbound = nullptr;
+
+    // Already stopped by QuitRequested() when the app ran; sprays what is
+    // left while the producer is still registered
+    delete deferred_io;
+    deferred_io = nullptr;
 
     // Shutdown MIDI system
     if (midi_looper) {
@@ -129,11 +289,39 @@ APCMiniGUIApp::~APCMiniGUIApp()
         midi_producer = nullptr;
     }
 
+    // Gauges read midi_queue, so the watchdog stops first
+    if (watchdog) {
+        watchdog->Stop();
+        watchdog = nullptr;
+    }
+
+    delete staged_input;
+    staged_input = nullptr;
+    delete input_pipeline;
+    input_pipeline = nullptr;
+    realtime_arena->Destroy(led_echo);
+    led_echo = nullptr;
+    realtime_arena->Destroy(ingress_dedup);
+    ingress_dedup = nullptr;
+
     delete midi_handler;
     midi_handler = nullptr;
 
-    delete midi_queue;
+    realtime_arena->Destroy(gesture_recognizer);
+    gesture_recognizer = nullptr;
+    realtime_arena->Destroy(gesture_queue);
+    gesture_queue = nullptr;
+
+    realtime_arena->Destroy(midi_queue);
     midi_queue = nullptr;
+
+    delete realtime_arena;
+    realtime_arena = nullptr;
+
+    delete state_journal;
+    state_journal = nullptr;
+    delete journal_state;
+    journal_state = nullptr;
 }
 
 void APCMiniGUIApp::ReadyToRun()
@@ -173,6 +361,7 @@ void APCMiniGUIApp::ReadyToRun()
         // Query current fader positions to synchronize GUI with hardware
         // Note: Removed snooze delay to improve startup responsiveness
         QueryFaderPositions();
+        RestoreFromJournal();
 
         printf("\n━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n\n");
     } else {
@@ -194,6 +383,15 @@ bool APCMiniGUIApp::QuitRequested()
         sync_thread = -1;
     }
 
+    // Changes since the last tick; the mapping already survives a crash,
+    // flush it for power loss too
+    CommitJournal(true);
+
+    // Log lines go to the debug window, which closes with the windows
+    if (deferred_io) {
+        deferred_io->Stop();
+    }
+
     return true;
 }
 
@@ -212,33 +410,76 @@ bool APCMiniGUIApp::InitializeHardware()
 
     // Set up MIDI callback to use new queue system
     usb_midi->SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
-        // Log incoming MIDI message
-        if (main_window && main_window->debug_window) {
-            main_window->debug_window->LogMIDIMessage("RX", status, data1, data2);
-        }
+        FlightRecorder::Default().Record(FLIGHT_EVENT_MIDI_IN, 0, status, data1, data2);
 
-        // Submit to queue for thread-safe processing
-        if (midi_handler) {
-            midi_handler->SubmitEvent(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
+        // Nothing here takes a lock: the RX log line is posted by the window
+        // once the message has been dispatched (LogReceivedMIDI)
+
+        // Filter, normalize and record state inline, then queue for the
+        // looper, which runs the registered callbacks
+        if (staged_input) {
+            staged_input->Submit(MIDIMessage(status, data1, data2, MIDI_SOURCE_HARDWARE_USB));
+        } else if (input_pipeline) {
+            input_pipeline->Push(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
         } else {
             // Fallback to message posting for thread-safe GUI updates
             if (main_window) {
-                BMessage msg(MSG_HARDWARE_MIDI_EVENT);
-                msg.AddUInt8("status", status);
-                msg.AddUInt8("data1", data1);
-                msg.AddUInt8("data2", data2);
-                main_window->PostMessage(&msg);
+                MIDIMessage midi_msg(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
+                BMessage* msg = MIDIMessageQueue::CreateBMessage(midi_msg, MSG_HARDWARE_MIDI_EVENT);
+                main_window->PostMessage(msg);
+                delete msg;
             }
         }
     });
 
+    // Introduction responses complete the round-trip probes. Probes share
+    // the outbound writer with LED traffic instead of racing it on the pipe;
+    // the queue wait is part of the measured round trip
+    rtt_prober = new RTTProber([this](const uint8_t* data, size_t length) {
+        return outbound ? outbound->SendSysEx(data, length) : APC_ERROR_DEVICE_NOT_FOUND;
+    }, &MetricsRegistry::Default());
+
+    usb_midi->SetSysExCallback([this](const uint8_t* data, size_t length) {
+        rtt_prober->HandleSysEx(data, length);
+    });
+
     APCMiniError result = usb_midi->Initialize();
     if (result != APC_SUCCESS) {
+        FlightRecorder::Default().Record(FLIGHT_EVENT_TRANSPORT, (uint32_t)result, 0,
+                                         FLIGHT_TRANSPORT_ERROR, 0);
+        delete rtt_prober;
+        rtt_prober = nullptr;
         delete usb_midi;
         usb_midi = nullptr;
         return false;
     }
 
+    FlightRecorder::Default().Record(FLIGHT_EVENT_TRANSPORT, 0, 0, FLIGHT_TRANSPORT_OPENED, 0);
+
+    // The views, pipeline and gesture/LED maps are built for one profile at
+    // compile time; any other layout would be misclassified, so refuse it
+    const APCDeviceDescriptor* profile = usb_midi->GetDeviceProfile();
+    if (profile && profile->product_id != APCGUIDevice::ProfileType::PRODUCT_ID) {
+        printf("❌ %s connected; this GUI only supports the %s\n",
+               profile->name, APCGUIDevice::ProfileType::NAME);
+        FlightRecorder::Default().Record(FLIGHT_EVENT_TRANSPORT, (uint32_t)APC_ERROR_DEVICE_NOT_FOUND, 0,
+                                         FLIGHT_TRANSPORT_ERROR, 0);
+        usb_midi->Shutdown();
+        delete rtt_prober;
+        rtt_prober = nullptr;
+        delete usb_midi;
+        usb_midi = nullptr;
+        return false;
+    }
+
+    if (outbound) {
+        outbound->Start();
+    }
+    // Only profiles with SysEx answer the introduction probe
+    if (profile && profile->has_sysex) {
+        rtt_prober->Start();
+    }
+
     // Start synchronization thread
     sync_thread = spawn_thread(SyncThreadEntry, "apc_sync", B_NORMAL_PRIORITY, this);
     if (sync_thread >= 0) {
@@ -258,11 +499,29 @@ void APCMiniGUIApp::ShutdownHardware()
         sync_thread = -1;
     }
 
+    if (rtt_prober) {
+        rtt_prober->Stop();
+    }
+
+    // Sends what is queued; the writer must be idle before usb_midi goes
+    if (outbound) {
+        outbound->Stop();
+    }
+
     if (usb_midi) {
         usb_midi->Shutdown();
+        FlightRecorder::Default().Record(FLIGHT_EVENT_TRANSPORT, 0, 0, FLIGHT_TRANSPORT_CLOSED, 0);
         delete usb_midi;
         usb_midi = nullptr;
     }
+
+    // The reader is gone; run what it submitted through to midi_queue
+    if (staged_input) {
+        staged_input->Stop();
+    }
+
+    delete rtt_prober;
+    rtt_prober = nullptr;
 }
 
 bool APCMiniGUIApp::IsHardwareConnected() const
@@ -270,106 +529,183 @@ bool APCMiniGUIApp::IsHardwareConnected() const
     return usb_midi && usb_midi->IsConnected();
 }
 
-void APCMiniGUIApp::SendNoteOn(uint8_t note, uint8_t velocity)
+void APCMiniGUIApp::SendNoteOn(uint8_t note, uint8_t velocity, bool update_led)
 {
-    // Send via USB Raw (direct hardware)
-    if (usb_midi && usb_midi->IsConnected()) {
-        // Log outgoing MIDI message
-        if (main_window && main_window->debug_window) {
-            main_window->debug_window->LogMIDIMessage("TX", MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity);
-        }
-        usb_midi->SendNoteOn(note, velocity);
+    // Called with the window locked: queue everything, wait for nothing
+    bool to_device = update_led && usb_midi && usb_midi->IsConnected();
+    if (to_device) {
+        SendOutbound(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity);
+        JournalLED(note, APC_MINI_MIDI_CHANNEL, velocity);
     }
 
-    // Also send via Patchbay (for external connections)
-    if (midi_producer) {
-        midi_producer->SprayNoteOn(APC_MINI_MIDI_CHANNEL, note, velocity, system_time());
-    }
+    // Debug log and Patchbay (for external connections)
+    SendSideEffects(MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity, to_device);
 
     // Update device state
-    if (IS_PAD_NOTE(note)) {
-        uint8_t pad_index = note - APC_MINI_PAD_NOTE_START;
-        if (pad_index < APC_MINI_PAD_COUNT) {
-            device_state.pads[pad_index] = true;
-            device_state.pad_velocities[pad_index] = velocity;
-        }
-    } else if (IS_TRACK_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_TRACK_NOTE_START;
-        if (button_index < 8) {
-            device_state.track_buttons[button_index] = true;
-        }
-    } else if (IS_SCENE_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_SCENE_NOTE_START;
-        if (button_index < 8) {
-            device_state.scene_buttons[button_index] = true;
-        }
-    } else if (IS_SHIFT_NOTE(note)) {
-        device_state.shift_pressed = true;
-    }
+    UpdateNoteState(note, true, velocity);
 }
 
-void APCMiniGUIApp::SendNoteOff(uint8_t note)
+void APCMiniGUIApp::SendNoteOff(uint8_t note, bool update_led)
 {
-    // Send via USB Raw (direct hardware)
-    if (usb_midi && usb_midi->IsConnected()) {
-        // Log outgoing MIDI message
-        if (main_window && main_window->debug_window) {
-            main_window->debug_window->LogMIDIMessage("TX", MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL, note, 0);
-        }
-        usb_midi->SendNoteOff(note);
+    // Called with the window locked: queue everything, wait for nothing
+    bool to_device = update_led && usb_midi && usb_midi->IsConnected();
+    if (to_device) {
+        SendOutbound(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL, note, 0);
+        JournalLED(note, APC_MINI_MIDI_CHANNEL, 0);
     }
 
-    // Also send via Patchbay (for external connections)
-    if (midi_producer) {
-        midi_producer->SprayNoteOff(APC_MINI_MIDI_CHANNEL, note, 0, system_time());
-    }
+    // Debug log and Patchbay (for external connections)
+    SendSideEffects(MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL, note, 0, to_device);
 
     // Update device state
-    if (IS_PAD_NOTE(note)) {
-        uint8_t pad_index = note - APC_MINI_PAD_NOTE_START;
-        if (pad_index < APC_MINI_PAD_COUNT) {
-            device_state.pads[pad_index] = false;
-            device_state.pad_velocities[pad_index] = 0;
-        }
-    } else if (IS_TRACK_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_TRACK_NOTE_START;
-        if (button_index < 8) {
-            device_state.track_buttons[button_index] = false;
-        }
-    } else if (IS_SCENE_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_SCENE_NOTE_START;
-        if (button_index < 8) {
-            device_state.scene_buttons[button_index] = false;
-        }
-    } else if (IS_SHIFT_NOTE(note)) {
-        device_state.shift_pressed = false;
+    UpdateNoteState(note, false, 0);
+}
+
+bool APCMiniGUIApp::AcceptPatchbayInput(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    // Patchbay may connect the controller's own MIDI Kit port to our input
+    return !ingress_dedup ||
+           ingress_dedup->Accept(MIDI_SOURCE_HARDWARE_MIDI, status, data1, data2);
+}
+
+void APCMiniGUIApp::UpdateNoteState(uint8_t note, bool pressed, uint8_t velocity)
+{
+    APCControlEntry control = APCGUIDevice::ClassifyNote(note);
+
+    switch (control.control_class) {
+        case APC_CONTROL_PAD:
+            device_state.pads[control.index] = pressed;
+            device_state.pad_velocities[control.index] = velocity;
+            break;
+
+        case APC_CONTROL_TRACK_BUTTON:
+            device_state.track_buttons[control.index] = pressed;
+            break;
+
+        case APC_CONTROL_SCENE_BUTTON:
+            device_state.scene_buttons[control.index] = pressed;
+            break;
+
+        case APC_CONTROL_SHIFT_BUTTON:
+            device_state.shift_pressed = pressed;
+            break;
+
+        default:
+            break;
     }
 }
 
 void APCMiniGUIApp::SendControlChange(uint8_t controller, uint8_t value)
 {
-    // Send via USB Raw (direct hardware)
-    if (usb_midi && usb_midi->IsConnected()) {
-        // Log outgoing MIDI message
-        if (main_window && main_window->debug_window) {
-            main_window->debug_window->LogMIDIMessage("TX", MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL, controller, value);
-        }
-        usb_midi->SendControlChange(controller, value);
+    UpdateFaderState(controller, value);
+    TransmitControlChange(controller, value);
+}
+
+void APCMiniGUIApp::TransmitControlChange(uint8_t controller, uint8_t value)
+{
+    // Runs on the coalescer's flusher: queue on the outbound writer, which
+    // keeps the newest value per controller
+    bool to_device = usb_midi && usb_midi->IsConnected();
+    if (to_device) {
+        SendOutbound(OUTBOUND_QOS_INTERACTIVE, MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL,
+                     controller, value);
+    }
+
+    // Debug log and Patchbay (for external connections)
+    SendSideEffects(MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL, controller, value, to_device);
+}
+
+void APCMiniGUIApp::UpdateFaderState(uint8_t controller, uint8_t value)
+{
+    APCControlEntry control = APCGUIDevice::ClassifyCC(controller);
+    if (control.control_class == APC_CONTROL_TRACK_FADER) {
+        device_state.track_fader_values[control.index] = value;
+    } else if (control.control_class == APC_CONTROL_MASTER_FADER) {
+        device_state.master_fader_value = value;
+    }
+}
+
+void APCMiniGUIApp::SendOutbound(OutboundQoS qos, uint8_t status, uint8_t data1, uint8_t data2)
+{
+    // Runs from InitializeHardware to ShutdownHardware; outside that there
+    // is no device, and a synchronous fallback would block the caller
+    if (outbound && outbound->IsRunning()) {
+        outbound->Send(qos, status, data1, data2);
     }
+}
 
-    // Also send via Patchbay (for external connections)
+void APCMiniGUIApp::SendSideEffects(uint8_t status, uint8_t data1, uint8_t data2, bool to_device)
+{
+    if (!deferred_io) {
+        return;
+    }
+    if (to_device && main_window && main_window->debug_window) {
+        deferred_io->Post(APC_GUI_IO_LOG_TX, status, data1, data2);
+    }
     if (midi_producer) {
-        midi_producer->SprayControlChange(APC_MINI_MIDI_CHANNEL, controller, value, system_time());
+        deferred_io->Post(APC_GUI_IO_SPRAY, status, data1, data2);
     }
+}
 
-    // Update device state
-    if (IS_TRACK_FADER_CC(controller)) {
-        uint8_t fader_index = controller - APC_MINI_FADER_CC_START;
-        if (fader_index < APC_MINI_TRACK_FADER_COUNT) {
-            device_state.track_fader_values[fader_index] = value;
-        }
-    } else if (IS_MASTER_FADER_CC(controller)) {
-        device_state.master_fader_value = value;
+void APCMiniGUIApp::LogReceivedMIDI(const MIDIMessage& message)
+{
+    if (message.source != MIDI_SOURCE_HARDWARE_USB || !deferred_io) {
+        return;
+    }
+    if (main_window && main_window->debug_window) {
+        deferred_io->Post(APC_GUI_IO_LOG_RX, message.status, message.data1, message.data2);
+    }
+}
+
+void APCMiniGUIApp::RunDeferredIO(const DeferredIOItem& item)
+{
+    const uint8_t channel = item.status & 0x0F;
+
+    switch (item.kind) {
+        case APC_GUI_IO_LOG_TX:
+            if (main_window && main_window->debug_window) {
+                main_window->debug_window->LogMIDIMessage("TX", item.status, item.data1, item.data2);
+            }
+            break;
+
+        case APC_GUI_IO_LOG_RX:
+            if (main_window && main_window->debug_window) {
+                main_window->debug_window->LogMIDIMessage("RX", item.status, item.data1, item.data2);
+            }
+            break;
+
+        case APC_GUI_IO_SPRAY:
+            if (!midi_producer) {
+                break;
+            }
+            // Stamped with the original send time, not the spray time
+            switch (item.status & 0xF0) {
+                case MIDI_NOTE_ON:
+                    midi_producer->SprayNoteOn(channel, item.data1, item.data2, item.posted_at);
+                    break;
+                case MIDI_NOTE_OFF:
+                    midi_producer->SprayNoteOff(channel, item.data1, item.data2, item.posted_at);
+                    break;
+                case MIDI_CONTROL_CHANGE:
+                    midi_producer->SprayControlChange(channel, item.data1, item.data2,
+                                                      item.posted_at);
+                    break;
+            }
+            break;
+    }
+}
+
+void APCMiniGUIApp::QueueControlChange(uint8_t controller, uint8_t value, bool released)
+{
+    // The state follows the drag here, on the window thread; only the wire
+    // message is coalesced
+    UpdateFaderState(controller, value);
+    if (!cc_coalescer) {
+        TransmitControlChange(controller, value);
+    } else if (released) {
+        cc_coalescer->Release(controller, value);
+    } else {
+        cc_coalescer->Update(controller, value);
     }
 }
 
@@ -414,8 +750,14 @@ void APCMiniGUIApp::SendPadRGB(uint8_t pad_index, const APCMiniMK2RGB& color)
         velocity = 127; // White/bright
     }
 
-    // Send Note On command
-    usb_midi->SendNoteOn(note, velocity);
+    // Pattern frames: only the latest color per pad is sent
+    SendOutbound(OUTBOUND_QOS_ANIMATION, MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity);
+
+    {
+        std::lock_guard<std::mutex> guard(journal_lock);
+        journal_state->pad_rgb[pad_index] = color;
+    }
+    JournalLED(note, APC_MINI_MIDI_CHANNEL, velocity);
 }
 
 void APCMiniGUIApp::SetTrackButtonLED(uint8_t button_index, bool on)
@@ -425,10 +767,11 @@ void APCMiniGUIApp::SetTrackButtonLED(uint8_t button_index, bool on)
     if (usb_midi && usb_midi->IsConnected()) {
         uint8_t note = APC_MINI_TRACK_NOTE_START + button_index;
         if (on) {
-            usb_midi->SendNoteOn(note, 127);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, 127);
         } else {
-            usb_midi->SendNoteOff(note);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL, note, 0);
         }
+        JournalLED(note, APC_MINI_MIDI_CHANNEL, on ? 127 : 0);
     }
 
     device_state.track_buttons[button_index] = on;
@@ -441,10 +784,11 @@ void APCMiniGUIApp::SetSceneButtonLED(uint8_t button_index, bool on)
     if (usb_midi && usb_midi->IsConnected()) {
         uint8_t note = APC_MINI_SCENE_NOTE_START + button_index;
         if (on) {
-            usb_midi->SendNoteOn(note, 127);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, 127);
         } else {
-            usb_midi->SendNoteOff(note);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL, note, 0);
         }
+        JournalLED(note, APC_MINI_MIDI_CHANNEL, on ? 127 : 0);
     }
 
     device_state.scene_buttons[button_index] = on;
@@ -458,23 +802,29 @@ void APCMiniGUIApp::ResetDeviceState()
 
     // Send reset commands to hardware
     if (usb_midi && usb_midi->IsConnected()) {
-        // Turn off all LEDs
+        // Turn off all LEDs; feedback queued after the reset still wins
+        const uint8_t note_off = MIDI_NOTE_OFF | APC_MINI_MIDI_CHANNEL;
+        const uint8_t cc = MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL;
         for (int i = 0; i < APC_MINI_PAD_COUNT; i++) {
-            usb_midi->SendNoteOff(APC_MINI_PAD_NOTE_START + i);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, note_off, APC_MINI_PAD_NOTE_START + i, 0);
         }
 
         for (int i = 0; i < 8; i++) {
-            usb_midi->SendNoteOff(APC_MINI_TRACK_NOTE_START + i);
-            usb_midi->SendNoteOff(APC_MINI_SCENE_NOTE_START + i);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, note_off, APC_MINI_TRACK_NOTE_START + i, 0);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, note_off, APC_MINI_SCENE_NOTE_START + i, 0);
         }
 
         // Reset all faders to 0
         for (int i = 0; i < APC_MINI_TRACK_FADER_COUNT; i++) {
-            usb_midi->SendControlChange(APC_MINI_FADER_CC_START + i, 0);
+            SendOutbound(OUTBOUND_QOS_STATE_SYNC, cc, APC_MINI_FADER_CC_START + i, 0);
             device_state.track_fader_values[i] = 0; // Update state to match hardware
         }
-        usb_midi->SendControlChange(APC_MINI_MASTER_CC, 0);
+        SendOutbound(OUTBOUND_QOS_STATE_SYNC, cc, APC_MINI_MASTER_CC, 0);
         device_state.master_fader_value = 0; // Update state to match hardware
+
+        std::lock_guard<std::mutex> guard(journal_lock);
+        journal_state->Clear();
+        journal_dirty = true;
     }
 
     // Update GUI to match reset state
@@ -509,66 +859,88 @@ void APCMiniGUIApp::HandleMIDIMessage(uint8_t status, uint8_t data1, uint8_t dat
 
 void APCMiniGUIApp::HandleNoteOn(uint8_t note, uint8_t velocity)
 {
-    if (IS_PAD_NOTE(note)) {
-        uint8_t pad_index = note - APC_MINI_PAD_NOTE_START;
-        if (main_window) {
-            main_window->HandlePadPress(pad_index, velocity);
-        }
-    } else if (IS_TRACK_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_TRACK_NOTE_START;
-        if (main_window) {
-            main_window->HandleTrackButton(button_index, true);
-        }
-    } else if (IS_SCENE_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_SCENE_NOTE_START;
-        if (main_window) {
-            main_window->HandleSceneButton(button_index, true);
-        }
-    } else if (IS_SHIFT_NOTE(note)) {
-        if (main_window) {
+    if (!main_window) {
+        return;
+    }
+
+    APCControlEntry control = APCGUIDevice::ClassifyNote(note);
+    switch (control.control_class) {
+        case APC_CONTROL_PAD:
+            main_window->HandlePadPress(control.index, velocity);
+            break;
+
+        case APC_CONTROL_TRACK_BUTTON:
+            main_window->HandleTrackButton(control.index, true);
+            break;
+
+        case APC_CONTROL_SCENE_BUTTON:
+            main_window->HandleSceneButton(control.index, true);
+            break;
+
+        case APC_CONTROL_SHIFT_BUTTON:
             main_window->HandleShiftButton(true);
-        }
+            break;
+
+        default:
+            break;
     }
 }
 
 void APCMiniGUIApp::HandleNoteOff(uint8_t note, uint8_t /*velocity*/)
 {
-    if (IS_PAD_NOTE(note)) {
-        uint8_t pad_index = note - APC_MINI_PAD_NOTE_START;
-        if (main_window) {
-            main_window->HandlePadRelease(pad_index);
-        }
-    } else if (IS_TRACK_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_TRACK_NOTE_START;
-        if (main_window) {
-            main_window->HandleTrackButton(button_index, false);
-        }
-    } else if (IS_SCENE_NOTE(note)) {
-        uint8_t button_index = note - APC_MINI_SCENE_NOTE_START;
-        if (main_window) {
-            main_window->HandleSceneButton(button_index, false);
-        }
-    } else if (IS_SHIFT_NOTE(note)) {
-        if (main_window) {
+    if (!main_window) {
+        return;
+    }
+
+    APCControlEntry control = APCGUIDevice::ClassifyNote(note);
+    switch (control.control_class) {
+        case APC_CONTROL_PAD:
+            main_window->HandlePadRelease(control.index);
+            break;
+
+        case APC_CONTROL_TRACK_BUTTON:
+            main_window->HandleTrackButton(control.index, false);
+            break;
+
+        case APC_CONTROL_SCENE_BUTTON:
+            main_window->HandleSceneButton(control.index, false);
+            break;
+
+        case APC_CONTROL_SHIFT_BUTTON:
             main_window->HandleShiftButton(false);
-        }
+            break;
+
+        default:
+            break;
     }
 }
 
 void APCMiniGUIApp::HandleControlChange(uint8_t controller, uint8_t value)
 {
-    if (IS_TRACK_FADER_CC(controller)) {
-        uint8_t fader_index = controller - APC_MINI_FADER_CC_START;
+    APCControlEntry control = APCGUIDevice::ClassifyCC(controller);
+
+    if (control.control_class == APC_CONTROL_TRACK_FADER) {
+        uint8_t fader_index = control.index;
 
         // Update device state to stay in sync with hardware
         device_state.track_fader_values[fader_index] = value;
+        {
+            std::lock_guard<std::mutex> guard(journal_lock);
+            journal_state->SetFader(fader_index, value);
+            journal_dirty = true;
+        }
 
         if (main_window) {
             main_window->HandleFaderChange(fader_index, value);
         }
-    } else if (IS_MASTER_FADER_CC(controller)) {
+    } else if (control.control_class == APC_CONTROL_MASTER_FADER) {
         // Update device state to stay in sync with hardware
         device_state.master_fader_value = value;
+        {
+            std::lock_guard<std::mutex> guard(journal_lock);
+            journal_state->SetFader(APC_MINI_TRACK_FADER_COUNT, value);
+            journal_dirty = true;
+        }
 
         if (main_window) {
             main_window->HandleFaderChange(APC_MINI_TRACK_FADER_COUNT, value);
@@ -585,6 +957,8 @@ int32 APCMiniGUIApp::SyncThreadEntry(void* data)
 
 void APCMiniGUIApp::SyncThreadLoop()
 {
+    ScopedThreadAccounting accounting("apc_sync");
+
     while (!should_stop) {
         if (usb_midi && usb_midi->IsConnected() && main_window) {
             // NOTE: Removed UpdateGUIFromState() call here as it was overwriting
@@ -594,6 +968,13 @@ void APCMiniGUIApp::SyncThreadLoop()
         }
 
         snooze(50000); // 50ms update interval
+        ThreadAccounting::NoteWakeup();
+
+        // LED and fader changes of the last tick in one journal commit
+        CommitJournal();
+        if (watchdog) {
+            watchdog->Beat(watchdog_sync_heartbeat);
+        }
     }
 }
 
@@ -649,6 +1030,114 @@ void APCMiniGUIApp::QueryFaderPositions()
     printf("   💡 Tip: You only need to sync faders you plan to use\n");
 }
 
+bool APCMiniGUIApp::RestoreFromJournal()
+{
+    bigtime_t start = system_time();
+
+    JournalState restored;
+    if (!state_journal || !state_journal->Restore(restored)) {
+        printf("   📓 No saved state to restore\n");
+        return false;
+    }
+    bigtime_t read_done = system_time();
+
+    // Faders the device reported before the restart replace "needs sync"
+    int faders_restored = 0;
+    for (int i = 0; i < APC_MINI_TOTAL_FADER_COUNT; i++) {
+        if (!restored.IsFaderKnown(i)) {
+            continue;
+        }
+        if (i < APC_MINI_TRACK_FADER_COUNT) {
+            device_state.track_fader_values[i] = restored.fader_values[i];
+        } else {
+            device_state.master_fader_value = restored.fader_values[i];
+        }
+        faders_restored++;
+    }
+
+    memcpy(device_state.pad_rgb_colors, restored.pad_rgb, sizeof(device_state.pad_rgb_colors));
+    for (int i = 0; i < 8; i++) {
+        device_state.track_buttons[i] = restored.leds.velocity[APC_MINI_PAD_COUNT + i] != 0;
+        device_state.scene_buttons[i] = restored.leds.velocity[APC_MINI_PAD_COUNT + 8 + i] != 0;
+    }
+    {
+        std::lock_guard<std::mutex> guard(journal_lock);
+        *journal_state = restored;
+    }
+
+    // Every LED as one state-sync frame through the single writer, which
+    // packs it into as few transfers as it can
+    uint8_t messages[LED_SNAPSHOT_LED_COUNT][3];
+    size_t count = restored.BuildLEDMessages(messages, LED_SNAPSHOT_LED_COUNT);
+    for (size_t i = 0; led_echo && i < count; i++) {
+        bool on = (messages[i][0] & 0xF0) == MIDI_NOTE_ON;
+        led_echo->NoteLED(messages[i][1], on ? messages[i][2] : 0, messages[i][0] & 0x0F);
+    }
+    APCMiniError result = APC_ERROR_DEVICE_NOT_FOUND;
+    if (outbound && outbound->IsRunning()) {
+        result = outbound->SendFrame(OUTBOUND_QOS_STATE_SYNC, messages, count);
+    }
+    bigtime_t pushed = system_time();
+
+    UpdateGUIFromState();
+
+    printf("   📓 State restored: %d faders, %zu LEDs\n", faders_restored, count);
+    printf("      journal read %lld us, LED queue %lld us (%s), total %lld us\n",
+           (long long)(read_done - start), (long long)(pushed - read_done),
+           result == APC_SUCCESS ? "ok" : "failed", (long long)(system_time() - start));
+    return true;
+}
+
+void APCMiniGUIApp::JournalLED(uint8_t note, uint8_t channel, uint8_t velocity)
+{
+    // Echo releases restore whatever the app set last
+    if (led_echo) {
+        led_echo->NoteLED(note, velocity, channel);
+    }
+
+    APCControlEntry control = APCGUIDevice::ClassifyNote(note);
+    std::lock_guard<std::mutex> guard(journal_lock);
+
+    switch (control.control_class) {
+        case APC_CONTROL_PAD:
+            journal_state->leds.SetPad(control.index, velocity, channel);
+            break;
+
+        case APC_CONTROL_TRACK_BUTTON:
+            journal_state->leds.SetTrackButton(control.index,
+                                               velocity ? LED_BUTTON_ON : LED_BUTTON_OFF);
+            break;
+
+        case APC_CONTROL_SCENE_BUTTON:
+            journal_state->leds.SetSceneButton(control.index,
+                                               velocity ? LED_BUTTON_ON : LED_BUTTON_OFF);
+            break;
+
+        default:
+            return;
+    }
+
+    // Committed by apc_sync; a pad fill costs one commit, not 64
+    journal_dirty = true;
+}
+
+void APCMiniGUIApp::CommitJournal(bool flush_to_disk)
+{
+    // Held across the commit: it is the journal's only writer, whichever
+    // thread calls (apc_sync per tick, the app thread at quit)
+    std::lock_guard<std::mutex> guard(journal_lock);
+    if (!state_journal || !state_journal->IsOpen()) {
+        return;
+    }
+    if (journal_dirty) {
+        state_journal->Commit(*journal_state);
+        journal_dirty = false;
+    }
+    if (flush_to_disk) {
+        state_journal->Sync();
+    }
+}
+
 uint8_t APCMiniGUIApp::ScanSingleFader(uint8_t /*cc_number*/)
 {
     // This method is now unused since we can't actually scan APC Mini faders
@@ -681,63 +1170,55 @@ APCMiniMK2RGB APCMiniGUIApp::VelocityToMK2RGB(uint8_t velocity)
     return {r, g, b};
 }
 
-void APCMiniGUIApp::RegisterMIDICallbacks()
+void APCMiniGUIApp::NoteBatchDrawn(bigtime_t dispatched_at, size_t count)
 {
-    if (!midi_handler) return;
+    if (!watchdog || dispatched_at <= 0) return;
 
-    // Register callback for pad presses (Note On/Off events)
-    MIDIEventFilter pad_filter;
-    pad_filter.accept_note_on = true;
-    pad_filter.accept_note_off = true;
-    pad_filter.accept_cc = false;
-    pad_filter.accept_sysex = false;
+    bigtime_t latency = system_time() - dispatched_at;
+    watchdog->ReportLatency(watchdog_draw_budget, latency);
+    FlightRecorder::Default().Record(FLIGHT_EVENT_DRAW, (uint32_t)latency, 0, (uint8_t)count, 0);
+}
 
-    midi_handler->RegisterCallback([this](const MIDIMessage& msg) {
-        // Post message to main thread for thread-safe GUI updates
-        if (main_window) {
-            BMessage bmsg(MSG_HARDWARE_MIDI_EVENT);
-            bmsg.AddUInt8("status", msg.status);
-            bmsg.AddUInt8("data1", msg.data1);
-            bmsg.AddUInt8("data2", msg.data2);
-            main_window->PostMessage(&bmsg);
-        }
-    }, pad_filter);
+void APCMiniGUIApp::RegisterMIDICallbacks()
+{
+    if (!midi_handler) return;
 
-    // Register callback for fader movements (Control Change events)
-    MIDIEventFilter fader_filter;
-    fader_filter.accept_note_on = false;
-    fader_filter.accept_note_off = false;
-    fader_filter.accept_cc = true;
-    fader_filter.accept_sysex = false;
+    // Register one batch callback for pads, faders and SysEx: everything
+    // dispatched in one poll reaches the window in a single BMessage
+    MIDIEventFilter hardware_filter;
+    hardware_filter.accept_note_on = true;
+    hardware_filter.accept_note_off = true;
+    hardware_filter.accept_cc = true;
+    hardware_filter.accept_sysex = true;
+    hardware_filter.accept_gestures = false;
 
-    midi_handler->RegisterCallback([this](const MIDIMessage& msg) {
+    midi_handler->RegisterBatchCallback([this](const MIDIMessageBatch& batch) {
         // Post message to main thread for thread-safe GUI updates
         if (main_window) {
             BMessage bmsg(MSG_HARDWARE_MIDI_EVENT);
-            bmsg.AddUInt8("status", msg.status);
-            bmsg.AddUInt8("data1", msg.data1);
-            bmsg.AddUInt8("data2", msg.data2);
-            main_window->PostMessage(&bmsg);
+            bmsg.AddInt64("apc:dispatched", system_time());
+            if (MIDIMessageQueue::AddBatchToBMessage(&bmsg, batch) == B_OK) {
+                main_window->PostMessage(&bmsg);
+            }
         }
-    }, fader_filter);
+    }, hardware_filter);
 
-    // Register callback for SysEx messages (APC Mini MK2 RGB data)
-    MIDIEventFilter sysex_filter;
-    sysex_filter.accept_note_on = false;
-    sysex_filter.accept_note_off = false;
-    sysex_filter.accept_cc = false;
-    sysex_filter.accept_sysex = true;
+    // Register callback for gestures synthesized by the recognizer
+    MIDIEventFilter gesture_filter;
+    gesture_filter.accept_note_on = false;
+    gesture_filter.accept_note_off = false;
+    gesture_filter.accept_cc = false;
+    gesture_filter.accept_sysex = false;
+    gesture_filter.accept_gestures = true;
 
     midi_handler->RegisterCallback([this](const MIDIMessage& msg) {
-        // Post message to main thread for thread-safe GUI updates
-        if (main_window) {
-            BMessage bmsg(MSG_HARDWARE_MIDI_EVENT);
-            bmsg.AddUInt8("status", msg.status);
-            bmsg.AddUInt8("data1", msg.data1);
-            bmsg.AddUInt8("data2", msg.data2);
-            main_window->PostMessage(&bmsg);
+        if (main_window && main_window->debug_window) {
+            char text[64];
+            snprintf(text, sizeof(text), "Gesture: %s on note %d",
+                     GestureRecognizer::GestureName(msg.data2), msg.data1);
+            main_window->debug_window->LogStatusMessage(text);
         }
-    }, sysex_filter);
+    }, gesture_filter);
 
     // Set event priorities for real-time performance
     midi_handler->SetEventPriority(0x90, MIDI_PRIORITY_HIGH);      // Note On
@@ -762,20 +1243,25 @@ int main(int argc, char* argv[])
 
     // Handle command line arguments
     bool simulation_mode = false;
+    bool staged_input = false;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--sim") == 0 || strcmp(argv[i], "--simulation") == 0) {
             simulation_mode = true;
             printf("Running in simulation mode (no hardware required)\n");
+        } else if (strcmp(argv[i], "--staged-input") == 0) {
+            staged_input = true;
+            printf("Input pipeline runs on its own worker thread\n");
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             printf("Usage: %s [options]\n", argv[0]);
             printf("Options:\n");
             printf("  --sim, --simulation    Run in simulation mode (no hardware)\n");
+            printf("  --staged-input         Run the input pipeline on a worker thread\n");
             printf("  --help, -h            Show this help message\n");
             return 0;
         }
     }
 
-    APCMiniGUIApp app;
+    APCMiniGUIApp app(staged_input);
 
     if (simulation_mode) {
         printf("Hardware connection disabled.\n");
@@ -5,6 +5,7 @@
 // PerformanceIndicatorPanel: Shows real-time latency and message statistics
 
 #include "apc_mini_gui.h"
+#include "metrics_registry.h"
 #include <LayoutBuilder.h>
 #include <GroupLayoutBuilder.h>
 #include <StringFormat.h>
@@ -288,6 +289,15 @@ void PerformanceIndicatorPanel::UpdateLabels()
         latency_label->SetHighColor(APC_GUI_LABEL_COLOR);
     }
 
+    // Device round trip measured by the background RTT prober
+    MetricSample rtt;
+    if (MetricsRegistry::Default().Find("usb.rtt_us", rtt) && rtt.value > 0) {
+        BString rtt_text;
+        rtt_text.SetToFormat("  RTT p50/p99: %lld/%lld μs",
+                             (long long)rtt.p50_us, (long long)rtt.p99_us);
+        latency_text << rtt_text;
+    }
+
     messages_text.SetToFormat("Messages: TX:%u RX:%u", messages_sent, messages_received);
 
     if (current_throughput > 0) {
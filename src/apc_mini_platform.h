@@ -0,0 +1,75 @@
+// apc_mini_platform.h
+// Minimal Kernel Kit shim for the portable (non-GUI) modules
+//
+// PURPOSE:
+// Transports, load generation and statistics code only need bigtime_t,
+// system_time() and snooze(). On Haiku these come from <OS.h>; elsewhere
+// (Linux CI, developer machines) this header provides equivalents based on
+// CLOCK_MONOTONIC so the same sources build and run unchanged.
+//
+// Anything that needs BMessage, BLooper or the USB Kit stays Haiku-only.
+
+#ifndef APC_MINI_PLATFORM_H
+#define APC_MINI_PLATFORM_H
+
+#ifdef __HAIKU__
+
+#include <OS.h>
+
+#else
+
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+
+typedef int64_t bigtime_t;
+typedef int32_t status_t;
+
+#ifndef B_OK
+#define B_OK 0
+#endif
+#ifndef B_ERROR
+#define B_ERROR (-1)
+#endif
+#ifndef B_INFINITE_TIMEOUT
+#define B_INFINITE_TIMEOUT ((bigtime_t)0x7FFFFFFFFFFFFFFFLL)
+#endif
+
+enum {
+    B_SYSTEM_TIMEBASE = 0
+};
+
+inline bigtime_t system_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (bigtime_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+inline status_t snooze(bigtime_t microseconds)
+{
+    if (microseconds <= 0) {
+        return B_OK;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = microseconds / 1000000;
+    ts.tv_nsec = (microseconds % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+    return B_OK;
+}
+
+inline status_t snooze_until(bigtime_t when, int /*timebase*/)
+{
+    struct timespec ts;
+    ts.tv_sec = when / 1000000;
+    ts.tv_nsec = (when % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+    return B_OK;
+}
+
+#endif // __HAIKU__
+
+#endif // APC_MINI_PLATFORM_H
@@ -0,0 +1,137 @@
+// apc_mk2_colors.cpp
+// MK2 preset palette shared by the test app and the portable tools
+
+#include "apc_mini_defs.h"
+
+// MK2 Preset RGB Colors Table (128 colors from official protocol)
+// These hex values are converted from the official velocity-to-color mapping
+const APCMiniMK2RGB APC_MK2_PRESET_COLORS[128] = {
+    {0x00, 0x00, 0x00}, // 0 - #000000 Black
+    {0x1E, 0x1E, 0x1E}, // 1 - #1E1E1E Dark Gray
+    {0x7F, 0x7F, 0x7F}, // 2 - #7F7F7F Gray
+    {0x7F, 0x7F, 0x7F}, // 3 - #FFFFFF White (capped at 7F)
+    {0x7F, 0x4C, 0x4C}, // 4 - #FF4C4C Light Red
+    {0x7F, 0x00, 0x00}, // 5 - #FF0000 Red
+    {0x59, 0x00, 0x00}, // 6 - #590000 Dark Red
+    {0x19, 0x00, 0x00}, // 7 - #190000 Very Dark Red
+    {0x7F, 0x5D, 0x6C}, // 8 - #FFBD6C Orange
+    {0x7F, 0x54, 0x00}, // 9 - #FF5400 Orange Red
+    {0x59, 0x1D, 0x00}, // 10 - #591D00
+    {0x27, 0x1B, 0x00}, // 11 - #271B00
+    {0x7F, 0x7F, 0x4C}, // 12 - #FFFF4C Yellow
+    {0x7F, 0x7F, 0x00}, // 13 - #FFFF00 Yellow
+    {0x59, 0x59, 0x00}, // 14 - #595900
+    {0x19, 0x19, 0x00}, // 15 - #191900
+    {0x4C, 0x7F, 0x4C}, // 16 - #88FF4C Light Green
+    {0x54, 0x7F, 0x00}, // 17 - #54FF00 Green
+    {0x1D, 0x59, 0x00}, // 18 - #1D5900
+    {0x14, 0x2B, 0x00}, // 19 - #142B00
+    {0x4C, 0x7F, 0x4C}, // 20 - #4CFF4C Green
+    {0x00, 0x7F, 0x00}, // 21 - #00FF00 Pure Green
+    {0x00, 0x59, 0x00}, // 22 - #005900
+    {0x00, 0x19, 0x00}, // 23 - #001900
+    {0x4C, 0x7F, 0x5E}, // 24 - #4CFF5E
+    {0x00, 0x7F, 0x19}, // 25 - #00FF19
+    {0x00, 0x59, 0x0D}, // 26 - #00590D
+    {0x00, 0x19, 0x02}, // 27 - #001902
+    {0x4C, 0x7F, 0x7F}, // 28 - #4CFF88 (approximated)
+    {0x00, 0x7F, 0x55}, // 29 - #00FF55
+    {0x00, 0x59, 0x1D}, // 30 - #00591D
+    {0x00, 0x1F, 0x12}, // 31 - #001F12
+    {0x4C, 0x7F, 0x77}, // 32 - #4CFFB7 (approximated)
+    {0x00, 0x7F, 0x7F}, // 33 - #00FF99 (approximated)
+    {0x00, 0x59, 0x35}, // 34 - #005935
+    {0x00, 0x19, 0x12}, // 35 - #001912
+    {0x4C, 0x63, 0x7F}, // 36 - #4CC3FF (approximated)
+    {0x00, 0x69, 0x7F}, // 37 - #00A9FF (approximated)
+    {0x00, 0x41, 0x52}, // 38 - #004152
+    {0x00, 0x10, 0x19}, // 39 - #001019
+    {0x4C, 0x7F, 0x7F}, // 40 - #4C88FF (approximated)
+    {0x00, 0x55, 0x7F}, // 41 - #0055FF
+    {0x00, 0x1D, 0x59}, // 42 - #001D59
+    {0x00, 0x08, 0x19}, // 43 - #000819
+    {0x4C, 0x4C, 0x7F}, // 44 - #4C4CFF
+    {0x00, 0x00, 0x7F}, // 45 - #0000FF Blue
+    {0x00, 0x00, 0x59}, // 46 - #000059
+    {0x00, 0x00, 0x19}, // 47 - #000019
+    {0x7F, 0x4C, 0x7F}, // 48 - #874CFF (approximated)
+    {0x54, 0x00, 0x7F}, // 49 - #5400FF
+    {0x19, 0x00, 0x64}, // 50 - #190064
+    {0x0F, 0x00, 0x30}, // 51 - #0F0030
+    {0x7F, 0x4C, 0x7F}, // 52 - #FF4CFF
+    {0x7F, 0x00, 0x7F}, // 53 - #FF00FF Magenta
+    {0x59, 0x00, 0x59}, // 54 - #590059
+    {0x19, 0x00, 0x19}, // 55 - #190019
+    {0x7F, 0x4C, 0x7F}, // 56 - #FF4C87 (approximated)
+    {0x7F, 0x00, 0x54}, // 57 - #FF0054
+    {0x59, 0x00, 0x1D}, // 58 - #59001D
+    {0x22, 0x00, 0x13}, // 59 - #220013
+    {0x7F, 0x15, 0x00}, // 60 - #FF1500
+    {0x7F, 0x35, 0x00}, // 61 - #993500 (approximated)
+    {0x79, 0x51, 0x00}, // 62 - #795100
+    {0x43, 0x64, 0x00}, // 63 - #436400
+    {0x03, 0x39, 0x00}, // 64 - #033900
+    {0x00, 0x57, 0x35}, // 65 - #005735
+    {0x00, 0x54, 0x7F}, // 66 - #00547F
+    {0x00, 0x00, 0x7F}, // 67 - #0000FF
+    {0x00, 0x45, 0x4F}, // 68 - #00454F
+    {0x25, 0x00, 0x7F}, // 69 - #2500CC (approximated)
+    {0x7F, 0x7F, 0x7F}, // 70 - #7F7F7F
+    {0x20, 0x20, 0x20}, // 71 - #202020
+    {0x7F, 0x00, 0x00}, // 72 - #FF0000
+    {0x5D, 0x7F, 0x2D}, // 73 - #BDFF2D (approximated)
+    {0x6F, 0x7F, 0x06}, // 74 - #AFED06 (approximated)
+    {0x64, 0x7F, 0x09}, // 75 - #64FF09
+    {0x10, 0x7F, 0x00}, // 76 - #108B00 (approximated)
+    {0x00, 0x7F, 0x7F}, // 77 - #00FF87 (approximated)
+    {0x00, 0x69, 0x7F}, // 78 - #00A9FF (approximated)
+    {0x00, 0x2A, 0x7F}, // 79 - #002AFF
+    {0x3F, 0x00, 0x7F}, // 80 - #3F00FF
+    {0x7A, 0x00, 0x7F}, // 81 - #7A00FF
+    {0x72, 0x1A, 0x7D}, // 82 - #B21A7D (approximated)
+    {0x40, 0x21, 0x00}, // 83 - #402100
+    {0x7F, 0x4A, 0x00}, // 84 - #FF4A00
+    {0x7F, 0x61, 0x06}, // 85 - #88E106 (approximated)
+    {0x72, 0x7F, 0x15}, // 86 - #72FF15
+    {0x00, 0x7F, 0x00}, // 87 - #00FF00
+    {0x3B, 0x7F, 0x26}, // 88 - #3BFF26
+    {0x59, 0x7F, 0x71}, // 89 - #59FF71
+    {0x38, 0x7F, 0x7F}, // 90 - #38FFCC (approximated)
+    {0x5B, 0x7F, 0x7F}, // 91 - #5B8AFF (approximated)
+    {0x31, 0x51, 0x7F}, // 92 - #3151C6 (approximated)
+    {0x7F, 0x7F, 0x69}, // 93 - #877FE9 (approximated)
+    {0x53, 0x1D, 0x7F}, // 94 - #D31DFF (approximated)
+    {0x7F, 0x00, 0x5D}, // 95 - #FF005D
+    {0x7F, 0x7F, 0x00}, // 96 - #FF7F00
+    {0x79, 0x70, 0x00}, // 97 - #B9B000 (approximated)
+    {0x7F, 0x7F, 0x00}, // 98 - #90FF00 (approximated)
+    {0x35, 0x5D, 0x07}, // 99 - #835D07 (approximated)
+    {0x39, 0x2B, 0x00}, // 100 - #392b00
+    {0x14, 0x4C, 0x10}, // 101 - #144C10
+    {0x0D, 0x50, 0x38}, // 102 - #0D5038
+    {0x15, 0x15, 0x2A}, // 103 - #15152A
+    {0x16, 0x20, 0x5A}, // 104 - #16205A
+    {0x69, 0x3C, 0x1C}, // 105 - #693C1C
+    {0x68, 0x00, 0x0A}, // 106 - #A8000A (approximated)
+    {0x5E, 0x51, 0x3D}, // 107 - #DE513D (approximated)
+    {0x58, 0x6A, 0x1C}, // 108 - #D86A1C (approximated)
+    {0x7F, 0x61, 0x26}, // 109 - #FFE126 (approximated)
+    {0x4E, 0x61, 0x2F}, // 110 - #9EE12F (approximated)
+    {0x67, 0x75, 0x0F}, // 111 - #67B50F (approximated)
+    {0x1E, 0x1E, 0x30}, // 112 - #1E1E30
+    {0x5C, 0x7F, 0x6B}, // 113 - #DCFF6B (approximated)
+    {0x40, 0x7F, 0x5D}, // 114 - #80FFBD (approximated)
+    {0x4A, 0x7F, 0x7F}, // 115 - #9A99FF (approximated)
+    {0x4E, 0x66, 0x7F}, // 116 - #8E66FF (approximated)
+    {0x40, 0x40, 0x40}, // 117 - #404040
+    {0x75, 0x75, 0x75}, // 118 - #757575
+    {0x60, 0x7F, 0x7F}, // 119 - #E0FFFF (approximated)
+    {0x60, 0x00, 0x00}, // 120 - #A00000 (approximated)
+    {0x35, 0x00, 0x00}, // 121 - #350000
+    {0x1A, 0x50, 0x00}, // 122 - #1AD000 (approximated)
+    {0x07, 0x42, 0x00}, // 123 - #074200
+    {0x79, 0x70, 0x00}, // 124 - #B9B000 (approximated)
+    {0x3F, 0x31, 0x00}, // 125 - #3F3100
+    {0x73, 0x5F, 0x00}, // 126 - #B35F00 (approximated)
+    {0x4B, 0x15, 0x02}  // 127 - #4B1502
+};
@@ -0,0 +1,144 @@
+// BMessage Batch Benchmark for APC Mini
+// Compares the per-message cost of the old six named fields per MIDI
+// message with one packed MIDIMessageBatch field, including the
+// Flatten/Unflatten a BMessage goes through when it crosses a port
+
+#include <cstdio>
+#include <cstring>
+#include <OS.h>
+#include <Message.h>
+
+#include "midi_message_queue.h"
+#include "midi_message_batch.h"
+
+#define BENCHMARK_ROUNDS 2000
+#define BENCHMARK_WHAT 'bmbk'
+
+static const size_t BATCH_SIZES[] = {1, 8, 32, 64};
+
+static MIDIMessage MakeMessage(size_t i)
+{
+    MIDIMessage message(MIDI_NOTE_ON, (uint8_t)(i % 64), 127, MIDI_SOURCE_HARDWARE_USB, system_time());
+    message.sequence = (uint32_t)i;
+    return message;
+}
+
+// Previous encoding: six named fields per message, repeated per message
+static void EncodeLegacy(BMessage& bmsg, const MIDIMessage* messages, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        bmsg.AddUInt8("midi:status", messages[i].status);
+        bmsg.AddUInt8("midi:data1", messages[i].data1);
+        bmsg.AddUInt8("midi:data2", messages[i].data2);
+        bmsg.AddInt64("midi:timestamp", messages[i].timestamp);
+        bmsg.AddUInt8("midi:source", messages[i].source);
+        bmsg.AddUInt32("midi:sequence", messages[i].sequence);
+    }
+}
+
+static size_t DecodeLegacy(const BMessage& bmsg, size_t count)
+{
+    size_t decoded = 0;
+    for (size_t i = 0; i < count; i++) {
+        MIDIMessage message;
+        uint8 source;
+        if (bmsg.FindUInt8("midi:status", i, &message.status) == B_OK &&
+            bmsg.FindUInt8("midi:data1", i, &message.data1) == B_OK &&
+            bmsg.FindUInt8("midi:data2", i, &message.data2) == B_OK &&
+            bmsg.FindInt64("midi:timestamp", i, &message.timestamp) == B_OK &&
+            bmsg.FindUInt8("midi:source", i, &source) == B_OK &&
+            bmsg.FindUInt32("midi:sequence", i, &message.sequence) == B_OK) {
+            decoded++;
+        }
+    }
+    return decoded;
+}
+
+static void EncodeBatch(BMessage& bmsg, const MIDIMessage* messages, size_t count)
+{
+    MIDIMessageBatch batch;
+    for (size_t i = 0; i < count; i++) {
+        batch.Add(messages[i]);
+    }
+    MIDIMessageQueue::AddBatchToBMessage(&bmsg, batch);
+}
+
+static size_t DecodeBatch(BMessage& bmsg)
+{
+    MIDIMessageBatch batch;
+    if (!MIDIMessageQueue::ExtractBatchFromBMessage(&bmsg, batch)) {
+        return 0;
+    }
+    MIDIMessage message;
+    for (size_t i = 0; i < batch.Count(); i++) {
+        batch.Get(i, message);
+    }
+    return batch.Count();
+}
+
+// Encode, flatten, unflatten, decode; returns microseconds per MIDI message
+static double RunRound(bool packed, const MIDIMessage* messages, size_t count, ssize_t* flat_size)
+{
+    static char flat[64 * 1024];
+
+    bigtime_t start = system_time();
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        BMessage out(BENCHMARK_WHAT);
+        if (packed) {
+            EncodeBatch(out, messages, count);
+        } else {
+            EncodeLegacy(out, messages, count);
+        }
+
+        *flat_size = out.FlattenedSize();
+        out.Flatten(flat, sizeof(flat));
+
+        BMessage in;
+        in.Unflatten(flat);
+        size_t decoded = packed ? DecodeBatch(in) : DecodeLegacy(in, count);
+        if (decoded != count) {
+            printf("❌ Decoded %zu of %zu messages\n", decoded, count);
+            return -1.0;
+        }
+    }
+    bigtime_t elapsed = system_time() - start;
+
+    return (double)elapsed / ((double)BENCHMARK_ROUNDS * count);
+}
+
+int main()
+{
+    printf("📦 BMessage Batch Benchmark\n");
+    printf("===========================\n");
+    printf("Rounds per size: %d (encode + Flatten + Unflatten + decode)\n\n", BENCHMARK_ROUNDS);
+
+    MIDIMessage messages[MIDIMessageBatch::MAX_MESSAGES];
+    for (size_t i = 0; i < MIDIMessageBatch::MAX_MESSAGES; i++) {
+        messages[i] = MakeMessage(i);
+    }
+
+    // Warm up allocator and caches
+    ssize_t flat_size = 0;
+    RunRound(false, messages, 8, &flat_size);
+    RunRound(true, messages, 8, &flat_size);
+
+    printf("%-8s %14s %12s %14s %12s %9s\n",
+           "Batch", "Legacy us/msg", "Legacy B", "Packed us/msg", "Packed B", "Speedup");
+
+    for (size_t size : BATCH_SIZES) {
+        ssize_t legacy_size = 0;
+        ssize_t packed_size = 0;
+        double legacy = RunRound(false, messages, size, &legacy_size);
+        double packed = RunRound(true, messages, size, &packed_size);
+        if (legacy < 0 || packed < 0) {
+            return 1;
+        }
+
+        printf("%-8zu %14.3f %12zd %14.3f %12zd %8.1fx\n",
+               size, legacy, legacy_size, packed, packed_size,
+               packed > 0 ? legacy / packed : 0.0);
+    }
+
+    printf("\n✅ Benchmark complete\n");
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "cc_coalescer.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+#include <chrono>
+
+CCCoalescer::CCCoalescer(SendFunction send_function, bigtime_t tick_interval_us,
+                         MetricsRegistry* metrics_registry)
+    : send(send_function)
+    , tick_us(tick_interval_us > 0 ? tick_interval_us : DEFAULT_TICK_US)
+    , registry(metrics_registry)
+    , wake_requested(false)
+    , urgent_requested(false)
+    , stop_requested(false)
+    , flusher_idle(false)
+    , running(false)
+    , updates(0)
+    , sent(0)
+    , coalesced(0)
+    , flushes(0)
+{
+    for (size_t i = 0; i < CONTROLLER_COUNT; i++) {
+        slots[i].store(0, std::memory_order_relaxed);
+        last_sent[i] = -1;
+    }
+    for (size_t i = 0; i < CONTROLLER_COUNT / 64; i++) {
+        dirty[i].store(0, std::memory_order_relaxed);
+    }
+
+    if (registry) {
+        registry->RegisterCounter("cc_coalescer.updates", &updates);
+        registry->RegisterCounter("cc_coalescer.sent", &sent);
+        registry->RegisterCounter("cc_coalescer.coalesced", &coalesced);
+        registry->RegisterCounter("cc_coalescer.flushes", &flushes);
+    }
+}
+
+CCCoalescer::~CCCoalescer()
+{
+    Stop();
+
+    if (registry) {
+        registry->Unregister(&updates);
+        registry->Unregister(&sent);
+        registry->Unregister(&coalesced);
+        registry->Unregister(&flushes);
+    }
+}
+
+APCMiniError CCCoalescer::Start()
+{
+    if (!send) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) {
+        return APC_SUCCESS;
+    }
+    running = true;
+    stop_requested = false;
+    flusher_thread = std::thread(&CCCoalescer::FlusherThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void CCCoalescer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) {
+            return;
+        }
+        stop_requested = true;
+    }
+    wake.notify_all();
+
+    if (flusher_thread.joinable()) {
+        flusher_thread.join();
+    }
+    running = false;
+}
+
+void CCCoalescer::Wake(bool urgent)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    wake_requested = true;
+    if (urgent) {
+        urgent_requested = true;
+    }
+    wake.notify_one();
+}
+
+bool CCCoalescer::HasPending() const
+{
+    for (size_t i = 0; i < CONTROLLER_COUNT / 64; i++) {
+        if (dirty[i].load() != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t CCCoalescer::Flush()
+{
+    std::lock_guard<std::mutex> guard(flush_lock);
+
+    size_t count = 0;
+    for (size_t word = 0; word < CONTROLLER_COUNT / 64; word++) {
+        uint64_t bits = dirty[word].exchange(0);
+        while (bits) {
+            int bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            uint8_t controller = (uint8_t)(word * 64 + bit);
+
+            // Take the latest value; a newer Update() in between simply wins
+            uint16_t slot = slots[controller].load(std::memory_order_relaxed);
+            do {
+                if (!(slot & SLOT_PENDING)) {
+                    break;
+                }
+            } while (!slots[controller].compare_exchange_weak(slot, slot & 0x7F,
+                                                              std::memory_order_relaxed));
+            if (!(slot & SLOT_PENDING)) {
+                continue;      // Already sent by the previous pass
+            }
+
+            uint8_t value = (uint8_t)(slot & 0x7F);
+            if (!(slot & SLOT_FINAL) && last_sent[controller] == value) {
+                coalesced.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            send(controller, value);
+            last_sent[controller] = value;
+            count++;
+        }
+    }
+
+    if (count > 0) {
+        sent.fetch_add(count, std::memory_order_relaxed);
+        flushes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return count;
+}
+
+void CCCoalescer::FlusherThreadLoop()
+{
+    ScopedThreadAccounting accounting("cc_flush");
+
+    bigtime_t last_flush = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            // Nothing dirty: sleep until the next Update()
+            if (!stop_requested && !wake_requested && !HasPending()) {
+                flusher_idle.store(true);
+                wake.wait(guard, [this]() {
+                    return stop_requested || wake_requested || HasPending();
+                });
+                flusher_idle.store(false);
+            }
+
+            // At most one pass per tick, unless a release is waiting
+            bigtime_t due = last_flush + tick_us;
+            while (!stop_requested && !urgent_requested) {
+                bigtime_t now = system_time();
+                if (now >= due) {
+                    break;
+                }
+                wake.wait_for(guard, std::chrono::microseconds(due - now));
+            }
+            wake_requested = false;
+            urgent_requested = false;
+            if (stop_requested) {
+                break;
+            }
+        }
+
+        Flush();
+        last_flush = system_time();
+        ThreadAccounting::NoteWakeup();
+    }
+
+    // Final values are never lost on shutdown
+    Flush();
+}
+
+CCCoalescerStats CCCoalescer::GetStats() const
+{
+    CCCoalescerStats stats;
+    stats.updates = updates.load(std::memory_order_relaxed);
+    stats.sent = sent.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced.load(std::memory_order_relaxed);
+    stats.flushes = flushes.load(std::memory_order_relaxed);
+    return stats;
+}
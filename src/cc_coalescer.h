@@ -0,0 +1,128 @@
+#ifndef CC_COALESCER_H
+#define CC_COALESCER_H
+
+/*
+ * Outbound Control Change Coalescer
+ *
+ * A GUI fader drag produces a mouse-move event every few hundred
+ * microseconds, and each one used to become a synchronous USB send, a
+ * Patchbay spray and a debug log line. Only the latest position matters,
+ * so drags write a per-controller latest-value slot instead and a flusher
+ * thread sends what changed once per output tick:
+ *
+ * - Update() stores the value and marks the controller dirty; it never
+ *   blocks and never allocates (one store and one fetch_or)
+ * - At most one CC per controller per tick is sent; values overwritten
+ *   within a tick are counted as coalesced
+ * - Release() is the final value of a gesture: it is sent right away,
+ *   without waiting for the tick, even if it equals the last value sent
+ * - The flusher sleeps while nothing is dirty, so an idle GUI costs no
+ *   wakeups; the first move after a pause is sent without delay
+ *
+ * Metrics: "cc_coalescer.updates", "cc_coalescer.sent",
+ * "cc_coalescer.coalesced" and "cc_coalescer.flushes".
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+class MetricsRegistry;
+
+struct CCCoalescerStats {
+    uint64_t updates;       // Update() and Release() calls
+    uint64_t sent;          // CCs handed to the send function
+    uint64_t coalesced;     // Values replaced before their tick, or equal to the last sent
+    uint64_t flushes;       // Flusher passes that sent something
+};
+
+class CCCoalescer {
+public:
+    static constexpr bigtime_t DEFAULT_TICK_US = 1000;     // 1 kHz
+    static constexpr size_t CONTROLLER_COUNT = 128;
+
+    // Called on the flusher thread (or the Flush() caller)
+    typedef std::function<void(uint8_t controller, uint8_t value)> SendFunction;
+
+    CCCoalescer(SendFunction send, bigtime_t tick_us = DEFAULT_TICK_US,
+                MetricsRegistry* registry = nullptr);
+    ~CCCoalescer();
+
+    APCMiniError Start();
+    void Stop();                    // Sends what is still pending first
+    bool IsRunning() const { return running.load(); }
+
+    // Latest value of a drag; sent on the next tick
+    void Update(uint8_t controller, uint8_t value) {
+        Store(controller & 0x7F, value & 0x7F, false);
+        if (flusher_idle.load()) {
+            Wake(false);
+        }
+    }
+
+    // Final value of a drag; sent now, whatever was sent before
+    void Release(uint8_t controller, uint8_t value) {
+        Store(controller & 0x7F, value & 0x7F, true);
+        Wake(true);
+    }
+
+    /**
+     * Send every dirty controller once (what the flusher does each tick)
+     *
+     * @return Number of CCs sent
+     */
+    size_t Flush();
+
+    bigtime_t TickInterval() const { return tick_us; }
+    bool HasPending() const;
+    CCCoalescerStats GetStats() const;
+
+private:
+    static constexpr uint16_t SLOT_PENDING = 0x100;   // Written since the last flush
+    static constexpr uint16_t SLOT_FINAL = 0x200;     // Release(): send even if unchanged
+
+    void Store(uint8_t controller, uint8_t value, bool final) {
+        uint16_t previous = slots[controller].exchange(
+            value | SLOT_PENDING | (final ? SLOT_FINAL : 0), std::memory_order_relaxed);
+        if (previous & SLOT_PENDING) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+        dirty[controller >> 6].fetch_or(1ULL << (controller & 63));
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Wake(bool urgent);
+    void FlusherThreadLoop();
+
+    SendFunction send;
+    bigtime_t tick_us;
+    MetricsRegistry* registry;
+
+    std::atomic<uint16_t> slots[CONTROLLER_COUNT];
+    std::atomic<uint64_t> dirty[CONTROLLER_COUNT / 64];
+    int16_t last_sent[CONTROLLER_COUNT];    // -1 = never; flusher only
+    std::mutex flush_lock;                  // Serializes Flush() callers
+
+    std::mutex lock;
+    std::condition_variable wake;
+    bool wake_requested;
+    bool urgent_requested;
+    bool stop_requested;
+    std::atomic<bool> flusher_idle;
+    std::atomic<bool> running;
+    std::thread flusher_thread;
+
+    std::atomic<uint64_t> updates;
+    std::atomic<uint64_t> sent;
+    std::atomic<uint64_t> coalesced;
+    std::atomic<uint64_t> flushes;
+};
+
+#endif // CC_COALESCER_H
@@ -0,0 +1,149 @@
+// CC Coalescer Benchmark
+// A simulated fader drag (one mouse move every few hundred microseconds)
+// sent to the simulated MK2 directly, one CC per move as the GUI used to,
+// and through the coalescer at different output ticks: CCs per second on
+// the wire and process CPU per second of dragging.
+//
+// Usage: cc_coalescer_benchmark [--moves <per s>] [--seconds <s>] [--faders <n>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "cc_coalescer.h"
+#include "midi_transport.h"
+
+struct DragResult {
+    uint64_t moves;
+    uint64_t sent;
+    double seconds;
+    double cpu_seconds;
+    bool final_values_match;
+};
+
+static double Seconds(const struct timeval& tv)
+{
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double ProcessCPUSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return Seconds(usage.ru_utime) + Seconds(usage.ru_stime);
+}
+
+// tick_us == 0: every move is sent synchronously from the dragging thread
+static DragResult Drag(bigtime_t tick_us, int moves_per_sec, double seconds, int faders)
+{
+    SimulatedDeviceTransport device;
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    // Last value put on the wire per controller
+    uint8_t wire[128] = {};
+    CCCoalescer coalescer([&device, &wire](uint8_t controller, uint8_t value) {
+        device.SendMIDI(MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL, controller, value);
+        wire[controller] = value;
+    }, tick_us > 0 ? tick_us : CCCoalescer::DEFAULT_TICK_US);
+    if (tick_us > 0) {
+        coalescer.Start();
+    }
+
+    DragResult result;
+    result.moves = 0;
+    result.sent = 0;
+
+    uint8_t values[APC_MINI_TRACK_FADER_COUNT] = {};
+    bigtime_t interval = 1000000 / moves_per_sec;
+    double cpu_before = ProcessCPUSeconds();
+    bigtime_t start = system_time();
+    bigtime_t end = start + (bigtime_t)(seconds * 1000000);
+    int position = 0;
+    for (bigtime_t next = start; next < end; next += interval) {
+        snooze_until(next, B_SYSTEM_TIMEBASE);
+        // Sweep up and down, all dragged faders together
+        position = (position + 1) % 254;
+        uint8_t value = (uint8_t)(position < 127 ? position : 253 - position);
+        for (int fader = 0; fader < faders; fader++) {
+            uint8_t controller = APC_MINI_FADER_CC_START + fader;
+            values[fader] = value;
+            if (tick_us > 0) {
+                coalescer.Update(controller, value);
+            } else {
+                device.SendMIDI(MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL, controller, value);
+                wire[controller] = value;
+                result.sent++;
+            }
+            result.moves++;
+        }
+    }
+    for (int fader = 0; fader < faders; fader++) {
+        if (tick_us > 0) {
+            coalescer.Release(APC_MINI_FADER_CC_START + fader, values[fader]);
+        }
+    }
+    coalescer.Stop();
+    result.seconds = (system_time() - start) / 1e6;
+    result.cpu_seconds = ProcessCPUSeconds() - cpu_before;
+    if (tick_us > 0) {
+        result.sent = coalescer.GetStats().sent;
+    }
+
+    result.final_values_match = true;
+    for (int fader = 0; fader < faders; fader++) {
+        if (wire[APC_MINI_FADER_CC_START + fader] != values[fader]) {
+            result.final_values_match = false;
+        }
+    }
+
+    device.Close();
+    return result;
+}
+
+static void Report(const char* label, const DragResult& result)
+{
+    printf("   %-16s %8.0f moves/s %8.0f CC/s %8.1f ms CPU/s   final values %s\n",
+           label, result.moves / result.seconds, result.sent / result.seconds,
+           1000.0 * result.cpu_seconds / result.seconds,
+           result.final_values_match ? "✅" : "❌");
+}
+
+int main(int argc, char** argv)
+{
+    int moves = 4000;
+    double seconds = 2.0;
+    int faders = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            moves = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--faders") == 0 && i + 1 < argc) {
+            faders = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--moves <per s>] [--seconds <s>] [--faders <n>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (moves <= 0 || moves > 1000000 || seconds <= 0 ||
+        faders < 1 || faders > APC_MINI_TRACK_FADER_COUNT) {
+        printf("❌ --moves, --seconds must be positive, --faders 1-%d\n", APC_MINI_TRACK_FADER_COUNT);
+        return 1;
+    }
+
+    printf("🎚️ CC Coalescer Benchmark (%d moves/s on %d fader%s, %.1f s per run)\n",
+           moves, faders, faders == 1 ? "" : "s", seconds);
+
+    Report("Direct", Drag(0, moves, seconds, faders));
+    Report("Tick 1 kHz", Drag(1000, moves, seconds, faders));
+    Report("Tick 250 Hz", Drag(4000, moves, seconds, faders));
+    Report("Tick 100 Hz", Drag(10000, moves, seconds, faders));
+
+    printf("\n   Coalesced drags send at most one CC per fader per tick and always end\n");
+    printf("   on the released value; CPU includes the simulated link.\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * CC Coalescer Test
+ * Latest-value slots, one CC per controller per tick, the final value on
+ * release, and an idle flusher that sends the first move without delay
+ */
+
+#include "cc_coalescer.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <mutex>
+#include <vector>
+
+struct SentCC {
+    uint8_t controller;
+    uint8_t value;
+    bigtime_t time;
+};
+
+struct SendLog {
+    std::mutex lock;
+    std::vector<SentCC> sent;
+
+    CCCoalescer::SendFunction Function() {
+        return [this](uint8_t controller, uint8_t value) {
+            std::lock_guard<std::mutex> guard(lock);
+            sent.push_back({controller, value, system_time()});
+        };
+    }
+
+    size_t Count() {
+        std::lock_guard<std::mutex> guard(lock);
+        return sent.size();
+    }
+
+    SentCC Last() {
+        std::lock_guard<std::mutex> guard(lock);
+        return sent.back();
+    }
+};
+
+void test_flush_coalesces()
+{
+    printf("Testing latest-value slots...\n");
+
+    SendLog log;
+    MetricsRegistry registry;
+    CCCoalescer coalescer(log.Function(), 1000, &registry);
+
+    // Many moves on two faders collapse to one CC each, latest value
+    for (uint8_t value = 0; value < 100; value++) {
+        coalescer.Update(48, value);
+        coalescer.Update(56, 127 - value);
+    }
+    assert(coalescer.HasPending());
+    assert(coalescer.Flush() == 2);
+    assert(!coalescer.HasPending());
+    assert(log.sent[0].controller == 48 && log.sent[0].value == 99);
+    assert(log.sent[1].controller == 56 && log.sent[1].value == 28);
+
+    // A move back to the value already sent costs nothing
+    coalescer.Update(48, 50);
+    coalescer.Update(48, 99);
+    assert(coalescer.Flush() == 0);
+
+    // ...but a release always goes out
+    coalescer.Release(48, 99);
+    assert(coalescer.Flush() == 1 && log.Last().value == 99);
+
+    CCCoalescerStats stats = coalescer.GetStats();
+    assert(stats.updates == 203 && stats.sent == 3);
+    assert(stats.coalesced == 200);
+    assert(stats.flushes == 2);
+
+    MetricSample sample;
+    assert(registry.Find("cc_coalescer.coalesced", sample) && sample.value == 200);
+
+    printf("✅ %llu updates became %llu CCs\n",
+           (unsigned long long)stats.updates, (unsigned long long)stats.sent);
+}
+
+void test_flusher_rate_limit()
+{
+    printf("Testing one CC per controller per tick...\n");
+
+    SendLog log;
+    const bigtime_t tick = 2000;
+    CCCoalescer coalescer(log.Function(), tick);
+    assert(coalescer.Start() == APC_SUCCESS);
+
+    // A 100 ms drag with a move every 100 us
+    bigtime_t start = system_time();
+    uint8_t value = 0;
+    for (bigtime_t next = start; next < start + 100000; next += 100) {
+        snooze_until(next, B_SYSTEM_TIMEBASE);
+        coalescer.Update(48, value);
+        value = (value + 1) & 0x7F;
+    }
+    uint8_t final_value = (value + 64) & 0x7F;
+    coalescer.Release(48, final_value);
+    snooze(20000);
+
+    size_t count = log.Count();
+    assert(log.Last().value == final_value);
+
+    // ~50 ticks plus the release; never two sends for one controller in a tick
+    assert(count >= 10 && count <= 100 / (tick / 1000) + 5);
+    for (size_t i = 1; i + 1 < count; i++) {
+        assert(log.sent[i].time - log.sent[i - 1].time >= tick - 200);
+    }
+
+    // The release did not wait for the tick
+    bigtime_t release_gap = log.sent[count - 1].time - log.sent[count - 2].time;
+
+    coalescer.Stop();
+    printf("✅ 1000 moves sent as %zu CCs, release after %lld us\n",
+           count, (long long)release_gap);
+}
+
+void test_idle_flusher()
+{
+    printf("Testing idle flusher wakeup...\n");
+
+    SendLog log;
+    CCCoalescer coalescer(log.Function(), 50000);
+    assert(coalescer.Start() == APC_SUCCESS);
+
+    // After a pause the first move is sent at once, not one tick later
+    snooze(100000);
+    bigtime_t moved_at = system_time();
+    coalescer.Update(49, 10);
+    while (log.Count() == 0 && system_time() - moved_at < 1000000) {
+        snooze(200);
+    }
+    assert(log.Count() == 1);
+    bigtime_t delay = log.Last().time - moved_at;
+    assert(delay < 25000);
+
+    // Values still pending on Stop() are sent
+    coalescer.Update(49, 20);
+    coalescer.Stop();
+    assert(log.Count() == 2 && log.Last().value == 20);
+
+    printf("✅ First move after idle sent in %lld us, pending value flushed on stop\n",
+           (long long)delay);
+}
+
+int main()
+{
+    printf("🎚️ CC Coalescer Test\n");
+    printf("====================\n\n");
+
+    test_flush_coalesces();
+    test_flusher_rate_limit();
+    test_idle_flusher();
+
+    printf("\n🎉 ALL TESTS PASSED! Fader drags are coalesced.\n");
+    return 0;
+}
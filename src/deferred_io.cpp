@@ -0,0 +1,153 @@
+#include "deferred_io.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+
+DeferredIOQueue::DeferredIOQueue(Handler handler_function, size_t capacity,
+                                 MetricsRegistry* metrics_registry)
+    : handler(handler_function)
+    , registry(metrics_registry)
+    , ring(capacity > 0 ? capacity : DEFAULT_CAPACITY)
+    , head(0)
+    , count(0)
+    , stop_requested(false)
+    , running(false)
+    , posted(0)
+    , handled(0)
+    , dropped(0)
+{
+    if (registry) {
+        registry->RegisterCounter("deferred_io.posted", &posted);
+        registry->RegisterCounter("deferred_io.handled", &handled);
+        registry->RegisterCounter("deferred_io.dropped", &dropped);
+        registry->RegisterHistogram("deferred_io.wait_us", &wait_histogram);
+    }
+}
+
+DeferredIOQueue::~DeferredIOQueue()
+{
+    Stop();
+
+    if (registry) {
+        registry->Unregister(&posted);
+        registry->Unregister(&handled);
+        registry->Unregister(&dropped);
+        registry->Unregister(&wait_histogram);
+    }
+}
+
+APCMiniError DeferredIOQueue::Start()
+{
+    if (!handler) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) {
+        return APC_SUCCESS;
+    }
+    running = true;
+    stop_requested = false;
+    worker_thread = std::thread(&DeferredIOQueue::WorkerThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void DeferredIOQueue::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) {
+            return;
+        }
+        stop_requested = true;
+    }
+    wake.notify_all();
+
+    if (worker_thread.joinable()) {
+        worker_thread.join();
+    }
+    running = false;
+}
+
+APCMiniError DeferredIOQueue::Post(uint8_t kind, uint8_t status, uint8_t data1, uint8_t data2)
+{
+    DeferredIOItem item;
+    item.kind = kind;
+    item.status = status;
+    item.data1 = data1;
+    item.data2 = data2;
+    item.posted_at = system_time();
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running || stop_requested) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return APC_ERROR_DEVICE_NOT_FOUND;
+        }
+        if (count == ring.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return APC_ERROR_TIMEOUT;
+        }
+        ring[(head + count) % ring.size()] = item;
+        count++;
+    }
+    posted.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_one();
+    return APC_SUCCESS;
+}
+
+size_t DeferredIOQueue::TakeLocked(DeferredIOItem* items, size_t max_items)
+{
+    size_t taken = 0;
+    while (count > 0 && taken < max_items) {
+        items[taken++] = ring[head];
+        head = (head + 1) % ring.size();
+        count--;
+    }
+    return taken;
+}
+
+void DeferredIOQueue::Handle(const DeferredIOItem* items, size_t item_count)
+{
+    for (size_t i = 0; i < item_count; i++) {
+        wait_histogram.Record(system_time() - items[i].posted_at);
+        handler(items[i]);
+    }
+    handled.fetch_add(item_count, std::memory_order_relaxed);
+}
+
+void DeferredIOQueue::WorkerThreadLoop()
+{
+    ScopedThreadAccounting accounting("deferred_io");
+
+    DeferredIOItem items[BATCH_SIZE];
+    for (;;) {
+        size_t taken;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this]() { return stop_requested || count > 0; });
+            // Posts stop with the request, so this drains the ring
+            taken = TakeLocked(items, BATCH_SIZE);
+            if (taken == 0 && stop_requested) {
+                break;
+            }
+        }
+
+        Handle(items, taken);
+        ThreadAccounting::NoteWakeup();
+    }
+}
+
+size_t DeferredIOQueue::Pending() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return count;
+}
+
+DeferredIOStats DeferredIOQueue::GetStats() const
+{
+    DeferredIOStats stats;
+    stats.posted = posted.load(std::memory_order_relaxed);
+    stats.handled = handled.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,109 @@
+#ifndef DEFERRED_IO_H
+#define DEFERRED_IO_H
+
+/*
+ * Deferred I/O Queue
+ *
+ * The window thread handles a pad press with its BWindow lock held, and it
+ * used to do the slow parts right there: a Patchbay spray into other
+ * applications' ports, and a debug log line that locks the debug window.
+ * Either one stalls drawing and input for as long as it takes. The window
+ * now posts a small record describing the work and returns; one worker
+ * thread performs it:
+ *
+ * - Post() copies 4 bytes plus a timestamp into a ring under a short lock;
+ *   it never waits for the handler and never allocates
+ * - A full ring drops the new record and counts it, like MIDIMessageQueue:
+ *   a missing log line or spray is better than a frozen window
+ * - The worker takes everything queued in one pass and runs the handler
+ *   outside the lock, in posting order
+ * - Stop() handles what is still queued before returning
+ *
+ * Record kinds are defined by the owner; the queue only carries them.
+ *
+ * Metrics: "deferred_io.posted", "deferred_io.handled", "deferred_io.dropped"
+ * and the "deferred_io.wait_us" histogram (post to handler start).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "latency_histogram.h"
+
+class MetricsRegistry;
+
+struct DeferredIOItem {
+    uint8_t kind;                   // Owner-defined
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    bigtime_t posted_at;
+};
+
+struct DeferredIOStats {
+    uint64_t posted;
+    uint64_t handled;
+    uint64_t dropped;               // Ring full, or posted while stopped
+};
+
+class DeferredIOQueue {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    // Called on the worker thread
+    typedef std::function<void(const DeferredIOItem& item)> Handler;
+
+    explicit DeferredIOQueue(Handler handler, size_t capacity = DEFAULT_CAPACITY,
+                             MetricsRegistry* registry = nullptr);
+    ~DeferredIOQueue();
+
+    APCMiniError Start();
+    void Stop();                    // Handles what is still queued first
+    bool IsRunning() const { return running.load(); }
+
+    /**
+     * Queue one record for the worker (any thread, never blocks on I/O)
+     *
+     * @return APC_ERROR_DEVICE_NOT_FOUND if not running,
+     *         APC_ERROR_TIMEOUT if the ring is full (record dropped)
+     */
+    APCMiniError Post(uint8_t kind, uint8_t status, uint8_t data1, uint8_t data2);
+
+    size_t Pending() const;
+    DeferredIOStats GetStats() const;
+    const LatencyHistogram& GetWaitHistogram() const { return wait_histogram; }
+
+private:
+    static constexpr size_t BATCH_SIZE = 64;
+
+    size_t TakeLocked(DeferredIOItem* items, size_t max_items);
+    void Handle(const DeferredIOItem* items, size_t count);
+    void WorkerThreadLoop();
+
+    Handler handler;
+    MetricsRegistry* registry;
+
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::vector<DeferredIOItem> ring;
+    size_t head;
+    size_t count;
+    bool stop_requested;
+    std::atomic<bool> running;
+    std::thread worker_thread;
+
+    std::atomic<uint64_t> posted;
+    std::atomic<uint64_t> handled;
+    std::atomic<uint64_t> dropped;
+    LatencyHistogram wait_histogram;
+};
+
+#endif // DEFERRED_IO_H
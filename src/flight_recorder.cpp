@@ -0,0 +1,97 @@
+#include "flight_recorder.h"
+
+static const char* const KIND_NAMES[FLIGHT_EVENT_KIND_COUNT] = {
+    "midi_in", "dispatch", "draw", "midi_out", "stage_latency", "gauge",
+    "transport", "stall", "over_budget", "mark"
+};
+
+static size_t RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+FlightRecorder::FlightRecorder(size_t capacity)
+    : slots(nullptr)
+    , mask(RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity) - 1)
+    , head(0)
+    , dropped(0)
+    , frozen(false)
+    , freeze_depth(0)
+{
+    // Touch every slot now so recording never takes a first-touch fault
+    slots = new Slot[mask + 1];
+    for (size_t i = 0; i <= mask; i++) {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+        slots[i].time.store(0, std::memory_order_relaxed);
+        slots[i].payload.store(0, std::memory_order_relaxed);
+    }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    delete[] slots;
+}
+
+FlightRecorder& FlightRecorder::Default()
+{
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+void FlightRecorder::Freeze()
+{
+    if (freeze_depth.fetch_add(1) == 0) {
+        frozen.store(true);
+    }
+}
+
+void FlightRecorder::Thaw()
+{
+    if (freeze_depth.fetch_sub(1) == 1) {
+        frozen.store(false);
+    }
+}
+
+size_t FlightRecorder::Snapshot(FlightEvent* events, size_t max_events, bigtime_t since) const
+{
+    if (!events || max_events == 0) {
+        return 0;
+    }
+
+    const uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t window = Capacity() < max_events ? Capacity() : max_events;
+    uint64_t begin = end > window ? end - window : 0;
+
+    size_t written = 0;
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot& slot = slots[index & mask];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) {
+            continue;      // Still being written, or already overwritten
+        }
+        bigtime_t time = slot.time.load(std::memory_order_relaxed);
+        uint64_t payload = slot.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence || time < since) {
+            continue;
+        }
+
+        FlightEvent& event = events[written++];
+        event.time = time;
+        event.value = (uint32_t)(payload >> 32);
+        event.kind = (uint8_t)(payload >> 24);
+        event.status = (uint8_t)(payload >> 16);
+        event.data1 = (uint8_t)(payload >> 8);
+        event.data2 = (uint8_t)payload;
+    }
+    return written;
+}
+
+const char* FlightRecorder::KindName(uint8_t kind)
+{
+    return kind < FLIGHT_EVENT_KIND_COUNT ? KIND_NAMES[kind] : "unknown";
+}
@@ -0,0 +1,133 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+/*
+ * Always-On Flight Recorder
+ *
+ * When a show glitches, averages and a resettable max say nothing about
+ * what led up to it. The flight recorder keeps the most recent trace events
+ * (MIDI in/out, dispatch, draw, stage latencies, queue depths, transport
+ * state) in a preallocated ring so the seconds before a problem can be
+ * dumped after the fact (see LatencyWatchdog):
+ *
+ * - The ring is allocated once; Record() never allocates or locks. It is
+ *   one relaxed load, one fetch_add and four stores, callable from any
+ *   thread, so it can stay on in production
+ * - The oldest events are overwritten; each slot carries a sequence number
+ *   so a reader can tell a complete event from one being rewritten
+ * - Freeze() stops recording (new events are counted as dropped) so a dump
+ *   sees a stable history; Thaw() resumes
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "apc_mini_platform.h"
+
+enum FlightEventKind {
+    FLIGHT_EVENT_MIDI_IN = 0,      // Reader thread received (status, data1, data2)
+    FLIGHT_EVENT_DISPATCH,         // Looper dispatched; value = reader->dispatch us
+    FLIGHT_EVENT_DRAW,             // Window applied; value = dispatch->draw us
+    FLIGHT_EVENT_MIDI_OUT,         // Sent to the device
+    FLIGHT_EVENT_STAGE_LATENCY,    // data1 = budget index, value = us
+    FLIGHT_EVENT_GAUGE,            // data1 = gauge index, value = sampled value
+    FLIGHT_EVENT_TRANSPORT,        // data1 = FlightTransportState, value = detail
+    FLIGHT_EVENT_HEARTBEAT_STALL,  // data1 = heartbeat index, value = silence us
+    FLIGHT_EVENT_BUDGET_EXCEEDED,  // data1 = budget index, value = us
+    FLIGHT_EVENT_MARK,             // Free-form marker, value = caller-defined
+    FLIGHT_EVENT_KIND_COUNT
+};
+
+enum FlightTransportState {
+    FLIGHT_TRANSPORT_OPENED = 0,
+    FLIGHT_TRANSPORT_CLOSED = 1,
+    FLIGHT_TRANSPORT_ERROR = 2,    // value = APCMiniError
+    FLIGHT_TRANSPORT_STALLED = 3
+};
+
+struct FlightEvent {
+    bigtime_t time;
+    uint32_t value;
+    uint8_t kind;                  // FlightEventKind
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+class FlightRecorder {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;   // ~1.5 MB, several seconds at full MIDI rate
+
+    // Capacity is rounded up to a power of two
+    explicit FlightRecorder(size_t capacity = DEFAULT_CAPACITY);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // Process-wide recorder used by the application
+    static FlightRecorder& Default();
+
+    void Record(FlightEventKind kind, uint32_t value = 0,
+                uint8_t status = 0, uint8_t data1 = 0, uint8_t data2 = 0) {
+        Record(kind, system_time(), value, status, data1, data2);
+    }
+
+    void Record(FlightEventKind kind, bigtime_t time, uint32_t value,
+                uint8_t status, uint8_t data1, uint8_t data2) {
+        if (frozen.load(std::memory_order_relaxed)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[index & mask];
+        // Odd while being written, 2 * (index + 1) once complete
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.time.store(time, std::memory_order_relaxed);
+        slot.payload.store(Pack(kind, value, status, data1, data2), std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // Stop/resume recording; nests, so overlapping dumps are safe
+    void Freeze();
+    void Thaw();
+    bool IsFrozen() const { return frozen.load(std::memory_order_relaxed); }
+
+    /**
+     * Copy complete events recorded at or after since, oldest first
+     *
+     * Events that were overwritten or torn while copying are skipped.
+     * @return Number of events written (at most max_events; the newest win)
+     */
+    size_t Snapshot(FlightEvent* events, size_t max_events, bigtime_t since = 0) const;
+
+    size_t Capacity() const { return mask + 1; }
+    uint64_t Recorded() const { return head.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    static const char* KindName(uint8_t kind);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<bigtime_t> time;
+        std::atomic<uint64_t> payload;
+    };
+
+    static uint64_t Pack(FlightEventKind kind, uint32_t value, uint8_t status, uint8_t data1, uint8_t data2) {
+        return ((uint64_t)value << 32) | ((uint64_t)kind << 24) | ((uint64_t)status << 16) |
+               ((uint64_t)data1 << 8) | data2;
+    }
+
+    Slot* slots;
+    size_t mask;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> frozen;
+    std::atomic<int> freeze_depth;
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,204 @@
+#include "gesture_recognizer.h"
+
+#define CONTROL_TRACK_FIRST  GestureDevice::PAD_COUNT
+#define CONTROL_SCENE_FIRST  (GestureDevice::PAD_COUNT + GestureDevice::ProfileType::TRACK_BUTTON_COUNT)
+
+static_assert(CONTROL_SCENE_FIRST + GestureDevice::ProfileType::SCENE_BUTTON_COUNT == GESTURE_CONTROL_COUNT,
+              "GESTURE_CONTROL_COUNT does not match the GestureDevice layout");
+
+// Timer cookies: control index * 2 + timer kind
+#define TIMER_KIND_HOLD  0
+#define TIMER_KIND_TAP   1
+
+GestureRecognizer::GestureRecognizer(MIDIMessageQueue* output_queue, const GestureConfig& gesture_config,
+                                     bigtime_t start_time)
+    : output(output_queue)
+    , config(gesture_config)
+    , wheel(TimerWheel::DEFAULT_TICK_US, start_time)
+    , shift_held(false)
+    , firing_time(start_time)
+    , presses_observed(0)
+    , taps(0)
+    , double_taps(0)
+    , long_presses(0)
+    , shift_combos(0)
+    , dropped(0)
+{
+    for (int i = 0; i < GESTURE_CONTROL_COUNT; i++) {
+        ControlState& control = controls[i];
+        if (i < CONTROL_TRACK_FIRST) {
+            control.note = GestureDevice::PadNote(i);
+        } else if (i < CONTROL_SCENE_FIRST) {
+            control.note = GestureDevice::TrackButtonNote(i - CONTROL_TRACK_FIRST);
+        } else {
+            control.note = GestureDevice::SceneButtonNote(i - CONTROL_SCENE_FIRST);
+        }
+        control.hold_timer.cookie = i * 2 + TIMER_KIND_HOLD;
+        control.tap_timer.cookie = i * 2 + TIMER_KIND_TAP;
+        control.pressed = false;
+        control.hold_fired = false;
+        control.double_fired = false;
+        control.combo = false;
+    }
+}
+
+void GestureRecognizer::Observe(const MIDIMessage& message)
+{
+    if (message.source == MIDI_SOURCE_GESTURE) {
+        return;
+    }
+    Observe(message.status, message.data1, message.data2, message.timestamp);
+}
+
+void GestureRecognizer::Observe(uint8_t status, uint8_t data1, uint8_t data2, bigtime_t timestamp)
+{
+    uint8_t type = status & 0xF0;
+    if (type != MIDI_NOTE_ON && type != MIDI_NOTE_OFF) {
+        return;
+    }
+
+    // Note On with velocity 0 is a release
+    bool pressed = type == MIDI_NOTE_ON && data2 > 0;
+
+    if (GestureDevice::ClassifyNote(data1).control_class == APC_CONTROL_SHIFT_BUTTON) {
+        shift_held = pressed;
+        return;
+    }
+
+    int index = ControlForNote(data1);
+    if (index < 0) {
+        return;
+    }
+
+    if (pressed) {
+        Press(controls[index], timestamp);
+    } else {
+        Release(controls[index], timestamp);
+    }
+}
+
+size_t GestureRecognizer::Advance(bigtime_t now)
+{
+    firing_time = now;
+    return wheel.Advance(now, &GestureRecognizer::OnTimer, this);
+}
+
+GestureStats GestureRecognizer::GetStats() const
+{
+    GestureStats stats;
+    stats.presses_observed = presses_observed.load();
+    stats.taps = taps.load();
+    stats.double_taps = double_taps.load();
+    stats.long_presses = long_presses.load();
+    stats.shift_combos = shift_combos.load();
+    stats.dropped = dropped.load();
+    return stats;
+}
+
+const char* GestureRecognizer::GestureName(uint8_t type)
+{
+    switch (type) {
+        case GESTURE_TAP: return "Tap";
+        case GESTURE_DOUBLE_TAP: return "Double Tap";
+        case GESTURE_LONG_PRESS: return "Long Press";
+        case GESTURE_SHIFT_COMBO: return "Shift Combo";
+        default: return "None";
+    }
+}
+
+int GestureRecognizer::ControlForNote(uint8_t note)
+{
+    const APCControlEntry entry = GestureDevice::ClassifyNote(note);
+    switch (entry.control_class) {
+        case APC_CONTROL_PAD:
+            return entry.index;
+        case APC_CONTROL_TRACK_BUTTON:
+            return CONTROL_TRACK_FIRST + entry.index;
+        case APC_CONTROL_SCENE_BUTTON:
+            return CONTROL_SCENE_FIRST + entry.index;
+        default:
+            return -1;
+    }
+}
+
+void GestureRecognizer::OnTimer(WheelTimer* timer, void* context)
+{
+    GestureRecognizer* recognizer = static_cast<GestureRecognizer*>(context);
+    ControlState& control = recognizer->controls[timer->cookie / 2];
+
+    if (timer->cookie % 2 == TIMER_KIND_HOLD) {
+        if (control.pressed) {
+            control.hold_fired = true;
+            recognizer->Emit(control, GESTURE_LONG_PRESS, recognizer->firing_time);
+        }
+    } else if (recognizer->config.report_taps) {
+        recognizer->Emit(control, GESTURE_TAP, recognizer->firing_time);
+    }
+}
+
+void GestureRecognizer::Press(ControlState& control, bigtime_t timestamp)
+{
+    if (control.pressed) {
+        return;   // Repeated Note On without a release
+    }
+
+    presses_observed.fetch_add(1, std::memory_order_relaxed);
+    control.pressed = true;
+    control.hold_fired = false;
+    control.double_fired = false;
+    control.combo = false;
+
+    if (shift_held) {
+        wheel.Cancel(&control.tap_timer);
+        control.combo = true;
+        Emit(control, GESTURE_SHIFT_COMBO, timestamp);
+        return;
+    }
+
+    if (control.tap_timer.IsArmed()) {
+        // Second press inside the window of a short tap
+        wheel.Cancel(&control.tap_timer);
+        control.double_fired = true;
+        Emit(control, GESTURE_DOUBLE_TAP, timestamp);
+    }
+
+    wheel.Arm(&control.hold_timer, timestamp + config.long_press_us);
+}
+
+void GestureRecognizer::Release(ControlState& control, bigtime_t timestamp)
+{
+    if (!control.pressed) {
+        return;
+    }
+
+    control.pressed = false;
+    wheel.Cancel(&control.hold_timer);
+
+    if (control.combo || control.hold_fired || control.double_fired) {
+        return;
+    }
+
+    // Short tap: wait for a possible second tap
+    wheel.Arm(&control.tap_timer, timestamp + config.double_tap_us);
+}
+
+void GestureRecognizer::Emit(const ControlState& control, GestureType type, bigtime_t timestamp)
+{
+    switch (type) {
+        case GESTURE_TAP: taps.fetch_add(1, std::memory_order_relaxed); break;
+        case GESTURE_DOUBLE_TAP: double_taps.fetch_add(1, std::memory_order_relaxed); break;
+        case GESTURE_LONG_PRESS: long_presses.fetch_add(1, std::memory_order_relaxed); break;
+        case GESTURE_SHIFT_COMBO: shift_combos.fetch_add(1, std::memory_order_relaxed); break;
+        default: break;
+    }
+
+    if (!output) {
+        return;
+    }
+
+    MIDIMessage message(MIDI_GESTURE_STATUS, control.note, type, MIDI_SOURCE_GESTURE, timestamp);
+    message.priority = 1;   // Same as the notes it was derived from
+    if (!output->Enqueue(message)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+/*
+ * Gesture Recognizer for Pads and Buttons
+ *
+ * Turns raw Note On/Off events of the 64 pads and the track and scene
+ * buttons into higher level gestures:
+ *
+ * - GESTURE_LONG_PRESS: held for long_press_us (fires while still held)
+ * - GESTURE_DOUBLE_TAP: pressed again within double_tap_us of a short tap
+ * - GESTURE_TAP: short tap confirmed once the double-tap window closed
+ * - GESTURE_SHIFT_COMBO: pressed while Shift is held (no tap/hold tracking)
+ *
+ * All pending thresholds live on one TimerWheel driven by the dispatch
+ * thread (MIDIEventHandler::ProcessPendingEvents), so arming and cancelling
+ * is O(1) and nothing is allocated per press. Raw events keep flowing
+ * unchanged; gestures are added to the output queue as synthesized
+ * messages. The output queue must have no other producer (give it its own
+ * queue, see MIDIEventHandler::SetGestureRecognizer()):
+ *
+ *   status = MIDI_GESTURE_STATUS, data1 = note, data2 = GestureType,
+ *   source = MIDI_SOURCE_GESTURE
+ *
+ * Notes are classified with the GestureDevice profile (the MK2, the only
+ * device the GUI opens), not with hard-coded note ranges.
+ *
+ * Observe() and Advance() must be called from the same thread.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "apc_device_profile.h"
+#include "midi_message_queue.h"
+#include "timer_wheel.h"
+
+// Control layout the recognizer tracks
+typedef APCMiniMK2Device GestureDevice;
+
+// Undefined System Common status: never valid on the wire, so it cannot
+// collide with device traffic
+#define MIDI_GESTURE_STATUS     0xF5
+
+#define GESTURE_CONTROL_COUNT   (APC_MINI_PAD_COUNT + 8 + 8)
+
+enum GestureType : uint8_t {
+    GESTURE_NONE = 0,
+    GESTURE_TAP = 1,
+    GESTURE_DOUBLE_TAP = 2,
+    GESTURE_LONG_PRESS = 3,
+    GESTURE_SHIFT_COMBO = 4
+};
+
+struct GestureConfig {
+    bigtime_t long_press_us;
+    bigtime_t double_tap_us;
+    bool report_taps;          // Emit GESTURE_TAP after the double-tap window
+
+    static GestureConfig Default() {
+        GestureConfig config;
+        config.long_press_us = 500000;
+        config.double_tap_us = 300000;
+        config.report_taps = true;
+        return config;
+    }
+};
+
+struct GestureStats {
+    uint64_t presses_observed;
+    uint64_t taps;
+    uint64_t double_taps;
+    uint64_t long_presses;
+    uint64_t shift_combos;
+    uint64_t dropped;          // Gesture messages lost to a full queue
+};
+
+class GestureRecognizer {
+public:
+    GestureRecognizer(MIDIMessageQueue* output, const GestureConfig& config = GestureConfig::Default(),
+                      bigtime_t start_time = system_time());
+
+    // Feed a raw input event; ignores anything but pad/button/Shift notes
+    void Observe(const MIDIMessage& message);
+    void Observe(uint8_t status, uint8_t data1, uint8_t data2, bigtime_t timestamp);
+
+    // Fire due thresholds; call from the dispatch loop every poll
+    size_t Advance(bigtime_t now);
+
+    size_t PendingTimers() const { return wheel.ArmedCount(); }
+    bool IsShiftHeld() const { return shift_held; }
+    GestureStats GetStats() const;
+
+    static bool IsGestureMessage(const MIDIMessage& message) {
+        return message.source == MIDI_SOURCE_GESTURE && message.status == MIDI_GESTURE_STATUS;
+    }
+    static const char* GestureName(uint8_t type);
+
+private:
+    struct ControlState {
+        WheelTimer hold_timer;
+        WheelTimer tap_timer;
+        uint8_t note;
+        bool pressed;
+        bool hold_fired;       // Long press reported for this press
+        bool double_fired;     // This press completed a double tap
+        bool combo;            // This press was a Shift combo
+    };
+
+    static int ControlForNote(uint8_t note);
+    static void OnTimer(WheelTimer* timer, void* context);
+
+    void Press(ControlState& control, bigtime_t timestamp);
+    void Release(ControlState& control, bigtime_t timestamp);
+    void Emit(const ControlState& control, GestureType type, bigtime_t timestamp);
+
+    MIDIMessageQueue* output;
+    GestureConfig config;
+    TimerWheel wheel;
+    ControlState controls[GESTURE_CONTROL_COUNT];
+    bool shift_held;
+    bigtime_t firing_time;     // Timestamp for gestures emitted by timers
+
+    std::atomic<uint64_t> presses_observed;
+    std::atomic<uint64_t> taps;
+    std::atomic<uint64_t> double_taps;
+    std::atomic<uint64_t> long_presses;
+    std::atomic<uint64_t> shift_combos;
+    std::atomic<uint64_t> dropped;
+};
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,229 @@
+/*
+ * Gesture Recognizer Test
+ * Timer wheel behaviour and tap/hold/Shift gestures with simulated time
+ */
+
+#include "gesture_recognizer.h"
+#include "timer_wheel.h"
+#include <stdio.h>
+#include <assert.h>
+#include <vector>
+
+// Fixed epoch so tests do not depend on the clock
+static const bigtime_t T0 = 1000000;
+
+static void RecordFired(WheelTimer* timer, void* context)
+{
+    static_cast<std::vector<uint32_t>*>(context)->push_back(timer->cookie);
+}
+
+void test_timer_wheel()
+{
+    printf("Testing TimerWheel arm/cancel/advance...\n");
+
+    TimerWheel wheel(1000, T0);
+    WheelTimer a, b, c, far;
+    a.cookie = 1;
+    b.cookie = 2;
+    c.cookie = 3;
+    far.cookie = 4;
+
+    wheel.Arm(&a, T0 + 5000);
+    wheel.Arm(&b, T0 + 5500);        // Rounds up to tick 6
+    wheel.Arm(&c, T0 + 3000);
+    wheel.Arm(&far, T0 + 700000);    // Several turns of the wheel
+    assert(wheel.ArmedCount() == 4);
+
+    wheel.Cancel(&c);
+    wheel.Cancel(&c);                // Cancelling twice is harmless
+    assert(wheel.ArmedCount() == 3 && !c.IsArmed());
+
+    std::vector<uint32_t> fired;
+    assert(wheel.Advance(T0 + 4999, RecordFired, &fired) == 0);
+    assert(wheel.Advance(T0 + 5000, RecordFired, &fired) == 1);
+    assert(fired.size() == 1 && fired[0] == 1);
+    assert(wheel.Advance(T0 + 5999, RecordFired, &fired) == 0);
+    assert(wheel.Advance(T0 + 6000, RecordFired, &fired) == 1);
+    assert(fired[1] == 2);
+
+    // Same slot on earlier turns must not fire the far timer
+    assert(wheel.Advance(T0 + 699999, RecordFired, &fired) == 0);
+    assert(far.IsArmed());
+    assert(wheel.Advance(T0 + 700000, RecordFired, &fired) == 1);
+    assert(fired[2] == 4 && wheel.ArmedCount() == 0);
+
+    // Re-arming moves a timer; past deadlines fire on the next tick
+    wheel.Arm(&a, T0 + 900000);
+    wheel.Arm(&a, T0 + 1000);
+    assert(wheel.ArmedCount() == 1);
+    assert(wheel.Advance(T0 + 701000, RecordFired, &fired) == 1);
+
+    printf("✅ Timers fire once, at or after their deadline\n");
+}
+
+struct Rearm {
+    TimerWheel* wheel;
+    int remaining;
+    bigtime_t next_deadline;
+};
+
+static void RearmHandler(WheelTimer* timer, void* context)
+{
+    Rearm* rearm = static_cast<Rearm*>(context);
+    if (--rearm->remaining > 0) {
+        rearm->next_deadline += 1000;
+        rearm->wheel->Arm(timer, rearm->next_deadline);
+    }
+}
+
+void test_rearm_from_handler()
+{
+    printf("Testing re-arm from inside a handler...\n");
+
+    TimerWheel wheel(1000, T0);
+    WheelTimer periodic;
+    Rearm rearm = {&wheel, 10, T0 + 1000};
+    wheel.Arm(&periodic, rearm.next_deadline);
+
+    // One big jump catches up tick by tick
+    size_t fired = wheel.Advance(T0 + 50000, RearmHandler, &rearm);
+    assert(fired == 10);
+    assert(rearm.remaining == 0 && !periodic.IsArmed());
+
+    printf("✅ Periodic timer re-armed %zu times in one Advance\n", fired);
+}
+
+static std::vector<MIDIMessage> Drain(MIDIMessageQueue& queue)
+{
+    std::vector<MIDIMessage> messages;
+    MIDIMessage message;
+    while (queue.Dequeue(message)) {
+        assert(GestureRecognizer::IsGestureMessage(message));
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+void test_gestures()
+{
+    printf("Testing tap, double tap, long press and Shift combo...\n");
+
+    MIDIMessageQueue* queue = new MIDIMessageQueue();
+    GestureRecognizer recognizer(queue, GestureConfig::Default(), T0);
+    const uint8_t pad = 12;
+    const uint8_t scene = APC_MINI_SCENE_NOTE_START + 2;
+
+    // Single tap: reported when the double-tap window closes
+    recognizer.Observe(MIDI_NOTE_ON, pad, 127, T0 + 1000);
+    recognizer.Observe(MIDI_NOTE_OFF, pad, 0, T0 + 80000);
+    recognizer.Advance(T0 + 300000);
+    assert(Drain(*queue).empty());
+    recognizer.Advance(T0 + 380000);
+    std::vector<MIDIMessage> gestures = Drain(*queue);
+    assert(gestures.size() == 1);
+    assert(gestures[0].data1 == pad && gestures[0].data2 == GESTURE_TAP);
+    assert(gestures[0].source == MIDI_SOURCE_GESTURE);
+
+    // Double tap: reported on the second press, no tap afterwards
+    bigtime_t t = T0 + 1000000;
+    recognizer.Observe(MIDI_NOTE_ON, scene, 127, t);
+    recognizer.Observe(MIDI_NOTE_ON, scene, 0, t + 50000);     // Velocity 0 = release
+    recognizer.Observe(MIDI_NOTE_ON, scene, 127, t + 200000);
+    gestures = Drain(*queue);
+    assert(gestures.size() == 1 && gestures[0].data1 == scene && gestures[0].data2 == GESTURE_DOUBLE_TAP);
+    recognizer.Observe(MIDI_NOTE_OFF, scene, 0, t + 250000);
+    recognizer.Advance(t + 2000000);
+    assert(Drain(*queue).empty());
+
+    // Long press: fires while held, release adds nothing
+    t = T0 + 4000000;
+    recognizer.Observe(MIDI_NOTE_ON, pad, 127, t);
+    recognizer.Advance(t + 499000);
+    assert(Drain(*queue).empty());
+    recognizer.Advance(t + 500000);
+    gestures = Drain(*queue);
+    assert(gestures.size() == 1 && gestures[0].data2 == GESTURE_LONG_PRESS);
+    recognizer.Observe(MIDI_NOTE_OFF, pad, 0, t + 900000);
+    recognizer.Advance(t + 2000000);
+    assert(Drain(*queue).empty());
+
+    // Shift combo: immediate, no hold tracking; Shift itself is no gesture
+    t = T0 + 7000000;
+    recognizer.Observe(MIDI_NOTE_ON, APC_MINI_SHIFT_NOTE, 127, t);
+    assert(recognizer.IsShiftHeld());
+    recognizer.Observe(MIDI_NOTE_ON, APC_MINI_TRACK_NOTE_START, 127, t + 10000);
+    gestures = Drain(*queue);
+    assert(gestures.size() == 1 && gestures[0].data1 == APC_MINI_TRACK_NOTE_START);
+    assert(gestures[0].data2 == GESTURE_SHIFT_COMBO);
+    recognizer.Advance(t + 2000000);
+    recognizer.Observe(MIDI_NOTE_OFF, APC_MINI_TRACK_NOTE_START, 0, t + 2100000);
+    recognizer.Observe(MIDI_NOTE_OFF, APC_MINI_SHIFT_NOTE, 0, t + 2200000);
+    recognizer.Advance(t + 4000000);
+    assert(Drain(*queue).empty());
+    assert(!recognizer.IsShiftHeld());
+
+    // Faders and other messages are ignored
+    recognizer.Observe(MIDI_CONTROL_CHANGE, APC_MINI_FADER_CC_START, 64, t);
+    assert(recognizer.PendingTimers() == 0);
+
+    GestureStats stats = recognizer.GetStats();
+    assert(stats.taps == 1 && stats.double_taps == 1 && stats.long_presses == 1 && stats.shift_combos == 1);
+    assert(stats.dropped == 0);
+
+    delete queue;
+    printf("✅ Each gesture is reported exactly once\n");
+}
+
+void test_hammered_controls()
+{
+    printf("Testing 80 controls hammered at once...\n");
+
+    MIDIMessageQueue* queue = new MIDIMessageQueue();
+    GestureRecognizer recognizer(queue, GestureConfig::Default(), T0);
+
+    // Every control tapped every 40 ms for 2 s; the last round leaves one
+    // open double-tap window per control
+    bigtime_t t = T0;
+    for (int round = 0; round < 51; round++) {
+        for (int control = 0; control < GESTURE_CONTROL_COUNT; control++) {
+            uint8_t note = control < 64 ? control
+                         : control < 72 ? APC_MINI_TRACK_NOTE_START + (control - 64)
+                                        : APC_MINI_SCENE_NOTE_START + (control - 72);
+            recognizer.Observe(MIDI_NOTE_ON, note, 127, t);
+            recognizer.Observe(MIDI_NOTE_OFF, note, 0, t + 10000);
+        }
+        t += 40000;
+        recognizer.Advance(t);
+    }
+    assert(recognizer.PendingTimers() == GESTURE_CONTROL_COUNT);
+
+    recognizer.Advance(t + 1000000);
+    assert(recognizer.PendingTimers() == 0);
+
+    GestureStats stats = recognizer.GetStats();
+    printf("Presses: %llu, double taps: %llu, taps: %llu\n",
+           (unsigned long long)stats.presses_observed, (unsigned long long)stats.double_taps,
+           (unsigned long long)stats.taps);
+    assert(stats.presses_observed == 51 * GESTURE_CONTROL_COUNT);
+    // Presses pair up into double taps; the odd last one ends as a tap
+    assert(stats.double_taps == 25 * GESTURE_CONTROL_COUNT);
+    assert(stats.taps == GESTURE_CONTROL_COUNT);
+    assert(stats.dropped == 0);
+
+    delete queue;
+    printf("✅ No timers leak under load\n");
+}
+
+int main()
+{
+    printf("👆 Gesture Recognizer Test\n");
+    printf("==========================\n\n");
+
+    test_timer_wheel();
+    test_rearm_from_handler();
+    test_gestures();
+    test_hammered_controls();
+
+    printf("\n🎉 ALL TESTS PASSED! Gestures are recognized on the timer wheel.\n");
+    return 0;
+}
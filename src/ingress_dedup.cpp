@@ -0,0 +1,198 @@
+#include "ingress_dedup.h"
+#include "metrics_registry.h"
+
+static_assert((IngressDeduplicator::SET_COUNT & (IngressDeduplicator::SET_COUNT - 1)) == 0,
+              "SET_COUNT must be a power of two");
+
+static_assert(MIDI_SOURCE_COUNT <= 8, "sources must fit the 3-bit entry field");
+
+IngressDeduplicator::IngressDeduplicator(bigtime_t window, MetricsRegistry* metrics_registry)
+    : registry(metrics_registry)
+    , window_us(DEFAULT_WINDOW_US)
+    , accepted(0)
+    , dropped(0)
+    , evicted(0)
+{
+    SetWindow(window);
+    for (size_t i = 0; i < MIDI_SOURCE_COUNT; i++) {
+        sources[i].store(PackSource(IngressSourceConfig::Ignored()), std::memory_order_relaxed);
+        dropped_by_source[i].store(0, std::memory_order_relaxed);
+    }
+    sources[MIDI_SOURCE_HARDWARE_USB].store(PackSource(IngressSourceConfig::Device(0)),
+                                            std::memory_order_relaxed);
+    sources[MIDI_SOURCE_HARDWARE_MIDI].store(PackSource(IngressSourceConfig::Device(0)),
+                                             std::memory_order_relaxed);
+    Reset();
+
+    if (registry) {
+        registry->RegisterCounter("ingress_dedup.accepted", &accepted);
+        registry->RegisterCounter("ingress_dedup.dropped", &dropped);
+        registry->RegisterCounter("ingress_dedup.evicted", &evicted);
+    }
+}
+
+IngressDeduplicator::~IngressDeduplicator()
+{
+    if (registry) {
+        registry->Unregister(&accepted);
+        registry->Unregister(&dropped);
+        registry->Unregister(&evicted);
+    }
+}
+
+void IngressDeduplicator::ConfigureSource(uint8_t source, const IngressSourceConfig& config)
+{
+    if (source >= MIDI_SOURCE_COUNT) {
+        return;
+    }
+    sources[source].store(PackSource(config), std::memory_order_relaxed);
+}
+
+IngressSourceConfig IngressDeduplicator::GetSourceConfig(uint8_t source) const
+{
+    if (source >= MIDI_SOURCE_COUNT) {
+        return IngressSourceConfig::Ignored();
+    }
+    uint16_t packed = sources[source].load(std::memory_order_relaxed);
+    IngressSourceConfig config;
+    config.deduplicate = (packed & 0x100) != 0;
+    config.device = (uint8_t)packed;
+    return config;
+}
+
+void IngressDeduplicator::SetWindow(bigtime_t window)
+{
+    if (window <= 0) {
+        window = DEFAULT_WINDOW_US;
+    }
+    window_us.store(window > MAX_WINDOW_US ? MAX_WINDOW_US : window, std::memory_order_relaxed);
+}
+
+bigtime_t IngressDeduplicator::GetWindow() const
+{
+    return window_us.load(std::memory_order_relaxed);
+}
+
+void IngressDeduplicator::Reset()
+{
+    for (size_t i = 0; i < SET_COUNT * WAYS; i++) {
+        table[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t IngressDeduplicator::MakeKey(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2)
+{
+    // USB delivers Note On velocity 0, MIDI Kit a Note Off: one release
+    uint8_t type = status & 0xF0;
+    if (type == MIDI_NOTE_OFF || (type == MIDI_NOTE_ON && data2 == 0)) {
+        status = (uint8_t)(MIDI_NOTE_OFF | (status & 0x0F));
+        data2 = 0;
+    }
+    // Channel statuses all have the top bit set; it carries no information
+    return ((uint32_t)device << 21) | ((uint32_t)(status & 0x7F) << 14) |
+           ((uint32_t)(data1 & 0x7F) << 7) | (uint32_t)(data2 & 0x7F);
+}
+
+bool IngressDeduplicator::Accept(uint8_t source, uint8_t status, uint8_t data1, uint8_t data2,
+                                 bigtime_t now)
+{
+    // System messages and data bytes are never matched
+    if (status < 0x80 || status >= 0xF0 || source >= MIDI_SOURCE_COUNT) {
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const IngressSourceConfig config = GetSourceConfig(source);
+    if (!config.deduplicate) {
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const uint32_t key = MakeKey(config.device, status, data1, data2);
+    const uint64_t stamp = (uint64_t)now & TIME_MASK;
+    const bigtime_t window = window_us.load(std::memory_order_relaxed);
+    std::atomic<uint64_t>* set = &table[SetIndex(key) * WAYS];
+
+    for (;;) {
+        uint64_t words[WAYS];
+        uint64_t current = 0;
+        size_t match = WAYS;
+        size_t victim = 0;
+        bigtime_t victim_age = -1;
+        for (size_t way = 0; way < WAYS; way++) {
+            uint64_t word = set[way].load(std::memory_order_acquire);
+            words[way] = word;
+            if (!EntryUsed(word)) {
+                if (victim_age != INT64_MAX) {
+                    victim = way;
+                    victim_age = INT64_MAX;     // Free ways before the oldest entry
+                }
+                continue;
+            }
+            if (EntryKey(word) == key) {
+                match = way;
+                current = word;
+                break;
+            }
+            if (EntryAge(word, stamp) > victim_age) {
+                victim = way;
+                victim_age = EntryAge(word, stamp);
+            }
+        }
+
+        if (match == WAYS) {
+            // First sighting: replace the free or least recently seen way,
+            // unless it changed since the scan (it may now hold this key)
+            uint64_t old = words[victim];
+            uint64_t desired = PackEntry(key, source, 1, stamp);
+            if (!set[victim].compare_exchange_weak(old, desired, std::memory_order_acq_rel)) {
+                continue;
+            }
+            if (EntryUsed(old) && EntryPending(old) > 0 && EntryAge(old, stamp) <= window) {
+                evicted.fetch_add(1, std::memory_order_relaxed);
+            }
+            accepted.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        uint8_t owner = EntrySource(current);
+        uint8_t pending = EntryPending(current);
+        if (EntryAge(current, stamp) > window) {
+            pending = 0;        // Copies this late are new events
+        }
+
+        // Another source's copy of something already accepted
+        if (owner != source && pending > 0) {
+            uint64_t desired = PackEntry(key, owner, pending - 1, current);
+            if (!set[match].compare_exchange_weak(current, desired, std::memory_order_acq_rel)) {
+                continue;
+            }
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            dropped_by_source[source].fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // First copy: this source now owns the key until the other one catches up
+        if (owner != source) {
+            pending = 0;
+        }
+        uint64_t desired = PackEntry(key, source, pending < MAX_PENDING ? pending + 1 : pending, stamp);
+        if (!set[match].compare_exchange_weak(current, desired, std::memory_order_acq_rel)) {
+            continue;
+        }
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+IngressDedupStats IngressDeduplicator::GetStats() const
+{
+    IngressDedupStats stats;
+    stats.accepted = accepted.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.evicted = evicted.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < MIDI_SOURCE_COUNT; i++) {
+        stats.dropped_by_source[i] = dropped_by_source[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
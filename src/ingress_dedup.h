@@ -0,0 +1,165 @@
+#ifndef INGRESS_DEDUP_H
+#define INGRESS_DEDUP_H
+
+/*
+ * Ingress Deduplicator
+ *
+ * With Patchbay connecting the controller's MIDI Kit port to the GUI input,
+ * every physical event arrives twice: once from USBRawMIDI and once through
+ * APCMiniMIDIConsumer. The GUI processed both. The deduplicator remembers
+ * recent messages per physical device and drops the copy that arrives
+ * second over another source:
+ *
+ * - Key: (device, status, data1, data2), with Note On velocity 0 and any
+ *   Note Off velocity folded into one release, so both drivers' forms match
+ * - A fixed set-associative table (SET_COUNT x WAYS): one hash, one set
+ *   scan, no allocation. A full set evicts its least recently seen entry
+ * - Each entry counts the copies its first source delivered within the
+ *   window; a copy from another source consumes one and is dropped. A
+ *   double press therefore stays a double press, whichever path is faster
+ * - Per source: whether it takes part and which device it carries. By
+ *   default the two hardware paths share device 0 and everything else
+ *   (GUI, simulation, gestures) is never touched
+ * - Only channel messages are matched; system messages always pass
+ *
+ * Accept() may be called from the USB reader and the MIDI Kit consumer at
+ * the same time without either waiting on the other: every entry is one
+ * 64-bit word (key, source, pending copies, last seen) replaced with a
+ * compare-and-swap, and a lost race rescans the set. Last seen is kept
+ * modulo 2^28 us, so windows are capped at MAX_WINDOW_US and a timestamp
+ * slightly older than the entry's (the other thread stamped later) counts
+ * as no time at all. Up to MAX_PENDING copies are counted per entry.
+ *
+ * Metrics: "ingress_dedup.accepted", "ingress_dedup.dropped" and
+ * "ingress_dedup.evicted" (entries replaced while still expecting a copy).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "apc_mini_platform.h"
+#include "midi_message_queue.h"
+
+class MetricsRegistry;
+
+struct IngressSourceConfig {
+    bool deduplicate;           // false: always accepted, never matched
+    uint8_t device;             // Copies only match within the same device
+
+    static IngressSourceConfig Device(uint8_t device) {
+        IngressSourceConfig config;
+        config.deduplicate = true;
+        config.device = device;
+        return config;
+    }
+
+    static IngressSourceConfig Ignored() {
+        IngressSourceConfig config;
+        config.deduplicate = false;
+        config.device = 0;
+        return config;
+    }
+};
+
+struct IngressDedupStats {
+    uint64_t accepted;
+    uint64_t dropped;
+    uint64_t evicted;
+    uint64_t dropped_by_source[MIDI_SOURCE_COUNT];
+};
+
+class IngressDeduplicator {
+public:
+    static constexpr bigtime_t DEFAULT_WINDOW_US = 20000;
+    static constexpr size_t SET_COUNT = 256;
+    static constexpr size_t WAYS = 4;
+    static constexpr bigtime_t MAX_WINDOW_US = (bigtime_t)1 << 27;
+    static constexpr uint8_t MAX_PENDING = 7;
+
+    explicit IngressDeduplicator(bigtime_t window_us = DEFAULT_WINDOW_US,
+                                 MetricsRegistry* registry = nullptr);
+    ~IngressDeduplicator();
+
+    void ConfigureSource(uint8_t source, const IngressSourceConfig& config);
+    IngressSourceConfig GetSourceConfig(uint8_t source) const;
+    void SetWindow(bigtime_t window_us);
+    bigtime_t GetWindow() const;
+
+    /**
+     * Check one incoming message (any thread)
+     *
+     * @return false if it is another source's copy of a message already
+     *         accepted within the window
+     */
+    bool Accept(uint8_t source, uint8_t status, uint8_t data1, uint8_t data2) {
+        return Accept(source, status, data1, data2, system_time());
+    }
+    bool Accept(uint8_t source, uint8_t status, uint8_t data1, uint8_t data2, bigtime_t now);
+
+    void Reset();                   // Forget every remembered message
+    IngressDedupStats GetStats() const;
+
+private:
+    // Entry word, low to high bits:
+    //   last_seen:28 (us) | pending:3 | used:1 | source:3 | key:29
+    // pending counts the copies another source may still deliver; key is
+    // device << 21 | (status & 0x7F) << 14 | data1 << 7 | data2
+    static constexpr uint64_t TIME_MASK = ((uint64_t)1 << 28) - 1;
+    static constexpr int PENDING_SHIFT = 28;
+    static constexpr uint64_t USED_BIT = (uint64_t)1 << 31;
+    static constexpr int SOURCE_SHIFT = 32;
+    static constexpr int KEY_SHIFT = 35;
+
+    static uint64_t PackEntry(uint32_t key, uint8_t source, uint8_t pending, uint64_t stamp) {
+        return ((uint64_t)key << KEY_SHIFT) | ((uint64_t)source << SOURCE_SHIFT) | USED_BIT |
+               ((uint64_t)pending << PENDING_SHIFT) | (stamp & TIME_MASK);
+    }
+    static uint32_t EntryKey(uint64_t entry) { return (uint32_t)(entry >> KEY_SHIFT); }
+    static uint8_t EntrySource(uint64_t entry) { return (uint8_t)((entry >> SOURCE_SHIFT) & 0x07); }
+    static uint8_t EntryPending(uint64_t entry) { return (uint8_t)((entry >> PENDING_SHIFT) & 0x07); }
+    static bool EntryUsed(uint64_t entry) { return (entry & USED_BIT) != 0; }
+
+    // Microseconds since the entry was last seen; 0 if stamped after now
+    static bigtime_t EntryAge(uint64_t entry, uint64_t stamp) {
+        uint64_t age = (stamp - entry) & TIME_MASK;
+        return age > TIME_MASK / 2 ? 0 : (bigtime_t)age;
+    }
+
+    static uint32_t MakeKey(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2);
+    static size_t SetIndex(uint32_t key) {
+        // Hash the fields a byte apart, as they are on the wire: packed 7-bit
+        // fields crowd more of a played grid into the same sets
+        uint32_t spread = ((key >> 21) << 24) | ((0x80 | ((key >> 14) & 0x7F)) << 16) |
+                          (((key >> 7) & 0x7F) << 8) | (key & 0x7F);
+        return (size_t)((spread * 0x9E3779B1u) >> 24) & (SET_COUNT - 1);
+    }
+
+    // deduplicate << 8 | device
+    static uint16_t PackSource(const IngressSourceConfig& config) {
+        return (uint16_t)((config.deduplicate ? 0x100 : 0) | config.device);
+    }
+
+    MetricsRegistry* registry;
+
+    std::atomic<bigtime_t> window_us;
+    std::atomic<uint16_t> sources[MIDI_SOURCE_COUNT];
+    std::atomic<uint64_t> table[SET_COUNT * WAYS];
+
+    std::atomic<uint64_t> accepted;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> evicted;
+    std::atomic<uint64_t> dropped_by_source[MIDI_SOURCE_COUNT];
+};
+
+// Input pipeline stage: drops the redundant copy, passes everything else
+struct IngressDedupStage {
+    IngressDeduplicator* dedup;
+
+    bool Process(MIDIMessage& message) const {
+        return !dedup || dedup->Accept(message.source, message.status, message.data1,
+                                       message.data2, message.timestamp);
+    }
+};
+
+#endif // INGRESS_DEDUP_H
@@ -0,0 +1,355 @@
+/*
+ * Ingress Deduplicator Test
+ * The same controller stream delivered twice by loopback transports (USB
+ * and MIDI Kit), in either order and with lag, repeats that must survive,
+ * the window, per-source configuration, the production input pipeline
+ * (also with the MIDI Kit copy first), concurrent sources, eviction and
+ * metrics
+ */
+
+#include "ingress_dedup.h"
+#include "midi_pipeline.h"
+#include "midi_transport.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::array<uint8_t, 3> Message;
+
+// Two transports carrying one controller into one deduplicator
+struct DuplicatedInput {
+    IngressDeduplicator dedup;
+    LoopbackTransport usb;
+    LoopbackTransport midikit;
+    std::mutex lock;
+    std::vector<Message> received;
+
+    explicit DuplicatedInput(bigtime_t window_us = IngressDeduplicator::DEFAULT_WINDOW_US)
+        : dedup(window_us) {
+        usb.SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+            Deliver(MIDI_SOURCE_HARDWARE_USB, status, data1, data2);
+        });
+        midikit.SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+            Deliver(MIDI_SOURCE_HARDWARE_MIDI, status, data1, data2);
+        });
+        usb.Open();
+        midikit.Open();
+    }
+
+    void Deliver(uint8_t source, uint8_t status, uint8_t data1, uint8_t data2) {
+        if (dedup.Accept(source, status, data1, data2)) {
+            std::lock_guard<std::mutex> guard(lock);
+            received.push_back({ status, data1, data2 });
+        }
+    }
+};
+
+// A short performance: presses, releases as Note On 0, a fader move
+static std::vector<Message> Performance()
+{
+    std::vector<Message> stream;
+    for (uint8_t pad = 0; pad < 8; pad++) {
+        stream.push_back({ 0x90, pad, 127 });
+        stream.push_back({ 0xB0, APC_MINI_FADER_CC_START, (uint8_t)(pad * 10) });
+        stream.push_back({ 0x90, pad, 0 });
+    }
+    return stream;
+}
+
+void test_duplicated_streams()
+{
+    printf("Testing duplicated USB + MIDI Kit streams...\n");
+
+    std::vector<Message> stream = Performance();
+
+    // USB first, MIDI Kit first, and MIDI Kit lagging three messages behind
+    for (int order = 0; order < 3; order++) {
+        DuplicatedInput input;
+        for (size_t i = 0; i < stream.size() + 3; i++) {
+            if (order == 2) {
+                if (i < stream.size()) {
+                    input.usb.SendMIDI(stream[i][0], stream[i][1], stream[i][2]);
+                }
+                if (i >= 3) {
+                    const Message& late = stream[i - 3];
+                    input.midikit.SendMIDI(late[0], late[1], late[2]);
+                }
+                continue;
+            }
+            if (i >= stream.size()) {
+                break;
+            }
+            MIDITransport& first = order == 0 ? (MIDITransport&)input.usb : input.midikit;
+            MIDITransport& second = order == 0 ? (MIDITransport&)input.midikit : input.usb;
+            first.SendMIDI(stream[i][0], stream[i][1], stream[i][2]);
+            second.SendMIDI(stream[i][0], stream[i][1], stream[i][2]);
+        }
+
+        assert(input.received == stream);
+        IngressDedupStats stats = input.dedup.GetStats();
+        assert(stats.accepted == stream.size() && stats.dropped == stream.size());
+    }
+
+    // MIDI Kit reports releases as Note Off with a velocity
+    DuplicatedInput input;
+    input.usb.SendMIDI(0x90, 5, 0);
+    input.midikit.SendMIDI(0x80, 5, 64);
+    assert(input.received.size() == 1);
+
+    printf("✅ Each event processed once, whichever path is faster\n");
+}
+
+void test_repeats_survive()
+{
+    printf("Testing genuine repeats...\n");
+
+    DuplicatedInput input;
+
+    // A double press and a fader resting on one value, then both copies
+    input.usb.SendMIDI(0x90, 3, 127);
+    input.usb.SendMIDI(0x90, 3, 127);
+    input.usb.SendMIDI(0xB0, APC_MINI_MASTER_CC, 64);
+    input.usb.SendMIDI(0xB0, APC_MINI_MASTER_CC, 64);
+    input.midikit.SendMIDI(0x90, 3, 127);
+    input.midikit.SendMIDI(0xB0, APC_MINI_MASTER_CC, 64);
+    input.midikit.SendMIDI(0x90, 3, 127);
+    input.midikit.SendMIDI(0xB0, APC_MINI_MASTER_CC, 64);
+    assert(input.received.size() == 4);
+
+    // A third copy has nothing left to match
+    input.midikit.SendMIDI(0x90, 3, 127);
+    assert(input.received.size() == 5);
+
+    printf("✅ Repeats on one source are kept, one copy each is dropped\n");
+}
+
+void test_window()
+{
+    printf("Testing the window...\n");
+
+    IngressDeduplicator dedup(10000);
+    assert(dedup.GetWindow() == 10000);
+
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 1, 100, 1000));
+    assert(!dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 1, 100, 11000));
+
+    // Later than the window: a new press on the other path
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 2, 100, 20000));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 2, 100, 30001));
+
+    // ...which now owns the key; the USB copy is the redundant one
+    assert(!dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 2, 100, 30100));
+
+    // The other thread may have stamped its copy a little earlier
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 4, 100, 35000));
+    assert(!dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 4, 100, 34990));
+
+    dedup.SetWindow(0);
+    assert(dedup.GetWindow() == IngressDeduplicator::DEFAULT_WINDOW_US);
+    dedup.SetWindow(IngressDeduplicator::MAX_WINDOW_US * 2);
+    assert(dedup.GetWindow() == IngressDeduplicator::MAX_WINDOW_US);
+    dedup.SetWindow(IngressDeduplicator::DEFAULT_WINDOW_US);
+
+    // Reset forgets pending copies
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 3, 100, 40000));
+    dedup.Reset();
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 3, 100, 40001));
+
+    printf("✅ Copies only match inside the window\n");
+}
+
+void test_source_config()
+{
+    printf("Testing per-source configuration...\n");
+
+    IngressDeduplicator dedup;
+    assert(dedup.GetSourceConfig(MIDI_SOURCE_HARDWARE_USB).deduplicate);
+    assert(dedup.GetSourceConfig(MIDI_SOURCE_HARDWARE_MIDI).deduplicate);
+    assert(!dedup.GetSourceConfig(MIDI_SOURCE_GUI).deduplicate);
+    assert(!dedup.GetSourceConfig(MIDI_SOURCE_COUNT).deduplicate);
+
+    // GUI clicks are never matched against the hardware
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 1, 100, 1000));
+    assert(dedup.Accept(MIDI_SOURCE_GUI, 0x90, 1, 100, 1001));
+    assert(dedup.Accept(MIDI_SOURCE_GUI, 0x90, 1, 100, 1002));
+
+    // A second controller on MIDI Kit is a different device
+    dedup.ConfigureSource(MIDI_SOURCE_HARDWARE_MIDI, IngressSourceConfig::Device(1));
+    assert(dedup.GetSourceConfig(MIDI_SOURCE_HARDWARE_MIDI).device == 1);
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 1, 100, 1003));
+
+    // Deduplication switched off for a source
+    dedup.ConfigureSource(MIDI_SOURCE_HARDWARE_MIDI, IngressSourceConfig::Ignored());
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x90, 2, 100, 2000));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 2, 100, 2001));
+
+    // Channel matters; system messages always pass
+    dedup.ConfigureSource(MIDI_SOURCE_HARDWARE_MIDI, IngressSourceConfig::Device(0));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0x91, 4, 100, 3000));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x92, 4, 100, 3001));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_USB, 0xF8, 0, 0, 3002));
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0xF8, 0, 0, 3003));
+
+    printf("✅ Sources opt in and carry a device id\n");
+}
+
+void test_input_pipeline()
+{
+    printf("Testing the dedup stage in the production input chain...\n");
+
+    IngressDeduplicator dedup;
+    PipelineControlState state;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<APCMiniMK2Device> pipeline =
+        MakeAPCInputPipeline<APCMiniMK2Device>(&state, inbox, nullptr, &dedup);
+
+    assert(pipeline.Push(0x90, 12, 100, MIDI_SOURCE_HARDWARE_USB));
+    assert(!pipeline.Push(0x90, 12, 100, MIDI_SOURCE_HARDWARE_MIDI));
+    assert(pipeline.Push(0x90, 12, 0, MIDI_SOURCE_HARDWARE_MIDI));
+    assert(!pipeline.Push(0x80, 12, 0, MIDI_SOURCE_HARDWARE_USB));
+
+    MIDIMessage message;
+    assert(inbox->Dequeue(message) && message.source == MIDI_SOURCE_HARDWARE_USB);
+    assert(inbox->Dequeue(message) && message.source == MIDI_SOURCE_HARDWARE_MIDI);
+    assert(message.status == 0x80);
+    assert(!inbox->Dequeue(message));
+
+    delete inbox;
+    printf("✅ The copy never reaches the inbox\n");
+}
+
+void test_midikit_wins()
+{
+    printf("Testing the MIDI Kit copy arriving first...\n");
+
+    // As in the app: USB runs the reader's chain, the MIDI Kit consumer
+    // only asks the deduplicator before handing the event to the window
+    std::vector<Message> echoed;
+    LEDEchoRules rules([&echoed](uint8_t status, uint8_t data1, uint8_t data2) {
+        echoed.push_back({ status, data1, data2 });
+        return APC_SUCCESS;
+    });
+    rules.SetPadRule(LEDEchoRule::Light(21));
+
+    IngressDeduplicator dedup;
+    PipelineControlState state;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<APCMiniMK2Device> pipeline =
+        MakeAPCInputPipeline<APCMiniMK2Device>(&state, inbox, &rules, &dedup);
+
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 12, 100));
+    assert(!pipeline.Push(0x90, 12, 100, MIDI_SOURCE_HARDWARE_USB));
+
+    // The window got the press from MIDI Kit; the reader still lit the pad
+    // and recorded it
+    assert(echoed.size() == 1);
+    assert(echoed.back()[0] == (MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_100));
+    assert(echoed.back()[1] == 12 && echoed.back()[2] == 21);
+    assert(state.note_values[12].load() == 100);
+
+    assert(dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, 0x90, 12, 0));
+    assert(!pipeline.Push(0x80, 12, 0, MIDI_SOURCE_HARDWARE_USB));
+    assert(echoed.size() == 2 && echoed.back()[0] == MIDI_NOTE_OFF);
+    assert(state.note_values[12].load() == 0);
+
+    MIDIMessage message;
+    assert(!inbox->Dequeue(message));
+    assert(dedup.GetStats().dropped_by_source[MIDI_SOURCE_HARDWARE_USB] == 2);
+
+    delete inbox;
+    printf("✅ Echo and state run before the USB copy is dropped\n");
+}
+
+void test_concurrent_sources()
+{
+    printf("Testing both sources on their own threads...\n");
+
+    // Wide window and fewer keys than the table holds: thread scheduling must
+    // not turn copies into new events
+    DuplicatedInput input(1000000);
+    std::vector<Message> stream;
+    for (int i = 0; i < 512; i++) {
+        stream.push_back({ (uint8_t)(0x90 | (i % 16)), (uint8_t)(i / 16), 1 });
+    }
+
+    std::thread usb_reader([&]() {
+        for (const Message& m : stream) {
+            input.usb.SendMIDI(m[0], m[1], m[2]);
+        }
+    });
+    std::thread midikit_reader([&]() {
+        for (const Message& m : stream) {
+            input.midikit.SendMIDI(m[0], m[1], m[2]);
+        }
+    });
+    usb_reader.join();
+    midikit_reader.join();
+
+    IngressDedupStats stats = input.dedup.GetStats();
+    assert(input.received.size() == stream.size());
+    assert(stats.dropped == stream.size() && stats.evicted == 0);
+    assert(stats.dropped_by_source[MIDI_SOURCE_HARDWARE_USB] +
+           stats.dropped_by_source[MIDI_SOURCE_HARDWARE_MIDI] == stream.size());
+
+    printf("✅ %zu events, %llu copies dropped across two threads\n", stream.size(),
+           (unsigned long long)stats.dropped);
+}
+
+void test_eviction_and_metrics()
+{
+    printf("Testing eviction and metrics...\n");
+
+    MetricsRegistry registry;
+    {
+        IngressDeduplicator dedup(1000000, &registry);
+
+        // More distinct messages in flight than the table holds
+        const int count = (int)(IngressDeduplicator::SET_COUNT * IngressDeduplicator::WAYS) * 2;
+        for (int i = 0; i < count; i++) {
+            dedup.Accept(MIDI_SOURCE_HARDWARE_USB, (uint8_t)(0x90 | (i >> 14)),
+                         (uint8_t)((i >> 7) & 0x7F), (uint8_t)(i & 0x7F), 1000);
+        }
+        for (int i = 0; i < count; i++) {
+            dedup.Accept(MIDI_SOURCE_HARDWARE_MIDI, (uint8_t)(0x90 | (i >> 14)),
+                         (uint8_t)((i >> 7) & 0x7F), (uint8_t)(i & 0x7F), 2000);
+        }
+
+        // Evicted entries let their copy through; nothing is dropped twice
+        IngressDedupStats stats = dedup.GetStats();
+        assert(stats.evicted > 0);
+        assert(stats.dropped > 0 && stats.dropped < (uint64_t)count);
+        assert(stats.accepted + stats.dropped == 2 * (uint64_t)count);
+
+        MetricSample sample;
+        assert(registry.Find("ingress_dedup.accepted", sample) && sample.value == stats.accepted);
+        assert(registry.Find("ingress_dedup.dropped", sample) && sample.value == stats.dropped);
+        assert(registry.Find("ingress_dedup.evicted", sample) && sample.value == stats.evicted);
+    }
+
+    MetricSample sample;
+    assert(!registry.Find("ingress_dedup.dropped", sample));
+
+    printf("✅ Eviction only lets copies through; counters registered and removed\n");
+}
+
+int main()
+{
+    printf("👯 Ingress Deduplicator Test\n");
+    printf("============================\n\n");
+
+    test_duplicated_streams();
+    test_repeats_survive();
+    test_window();
+    test_source_config();
+    test_input_pipeline();
+    test_midikit_wins();
+    test_concurrent_sources();
+    test_eviction_and_metrics();
+
+    printf("\n🎉 ALL TESTS PASSED! Duplicate ingress is processed once.\n");
+    return 0;
+}
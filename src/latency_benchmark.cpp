@@ -12,12 +12,29 @@
 
 #include "usb_raw_midi.h"
 #include "apc_mini_defs.h"
+#include "workload.h"
 
-// Benchmark configuration
-#define BENCHMARK_ITERATIONS 20  // Reduced from 100 for manual testing
-#define WARMUP_ITERATIONS 3      // Reduced from 10 for manual testing
+// Benchmark configuration; the probe counts come from a workload (default: probe)
 #define PAD_NOTE_TEST 0x38       // Top-left pad (row 7, col 0 = 7*8+0 = 56 = 0x38)
 
+// One probe per burst: bursts inside the warmup window are warmup probes
+static int warmup_iterations = 3;
+static int benchmark_iterations = 20;
+
+static bool ConfigureWorkload(const Workload& workload)
+{
+    const LoadProfile& profile = workload.phases[0].profile;
+    if (profile.arrival != LOAD_ARRIVAL_BURST) {
+        printf("ERROR: workload '%s' is not a burst workload\n", workload.name);
+        return false;
+    }
+
+    warmup_iterations = (int)profile.BurstsBefore(profile.warmup_us);
+    benchmark_iterations = (int)profile.BurstsBefore(profile.duration_us) - warmup_iterations;
+    printf("Workload '%s': %s\n", workload.name, workload.description);
+    return benchmark_iterations > 0;
+}
+
 // Statistics structure
 struct BenchmarkStats {
     bigtime_t min_latency;
@@ -161,7 +178,7 @@ bool RunMIDILatencyTest(BMidiProducer* apc_producer, BMidiConsumer* apc_consumer
     snooze(500000); // 500ms to see the grid
 
     // Run the test
-    for (int i = 0; i < WARMUP_ITERATIONS + BENCHMARK_ITERATIONS; i++) {
+    for (int i = 0; i < warmup_iterations + benchmark_iterations; i++) {
         // Light up the pad YELLOW to indicate which one to press
         // MK2 uses velocity 13 for yellow
         local_producer->SprayNoteOn(0, PAD_NOTE_TEST, 13, system_time());
@@ -180,22 +197,22 @@ bool RunMIDILatencyTest(BMidiProducer* apc_producer, BMidiConsumer* apc_consumer
         if (!local_consumer->IsWaiting()) {
             bigtime_t latency = local_consumer->GetResponseTime() - send_time;
             // Always show feedback
-            if (i >= WARMUP_ITERATIONS) {
+            if (i >= warmup_iterations) {
                 stats.RecordMeasurement(latency);
                 printf("   ✓ Measurement %d/%d: %.2f ms\n",
-                       i - WARMUP_ITERATIONS + 1, BENCHMARK_ITERATIONS, latency / 1000.0);
+                       i - warmup_iterations + 1, benchmark_iterations, latency / 1000.0);
             } else {
-                printf("   Warmup %d/%d: %.2f ms\n", i + 1, WARMUP_ITERATIONS, latency / 1000.0);
+                printf("   Warmup %d/%d: %.2f ms\n", i + 1, warmup_iterations, latency / 1000.0);
             }
             // Brief flash to confirm
             local_producer->SprayNoteOn(0, PAD_NOTE_TEST, 15, system_time());
             snooze(100000); // 100ms flash
         } else {
-            if (i >= WARMUP_ITERATIONS) {
+            if (i >= warmup_iterations) {
                 stats.failure_count++;
-                printf("   ✗ Timeout %d/%d - no response\n", i - WARMUP_ITERATIONS + 1, BENCHMARK_ITERATIONS);
+                printf("   ✗ Timeout %d/%d - no response\n", i - warmup_iterations + 1, benchmark_iterations);
             } else {
-                printf("   ✗ Warmup timeout %d/%d\n", i + 1, WARMUP_ITERATIONS);
+                printf("   ✗ Warmup timeout %d/%d\n", i + 1, warmup_iterations);
             }
         }
 
@@ -272,7 +289,7 @@ bool RunUSBRawLatencyTest(USBRawMIDI* usb, BenchmarkStats& stats) {
     printf("   Ready! Watch for the green LED.\n\n");
     snooze(500000); // 500ms to see the grid
 
-    for (int i = 0; i < WARMUP_ITERATIONS + BENCHMARK_ITERATIONS; i++) {
+    for (int i = 0; i < warmup_iterations + benchmark_iterations; i++) {
         // Light up the pad GREEN to indicate which one to press
         usb->SetPadColor(PAD_NOTE_TEST, static_cast<APCMiniLEDColor>(21));  // Green on MK2
         snooze(50000); // 50ms to see the LED
@@ -290,22 +307,22 @@ bool RunUSBRawLatencyTest(USBRawMIDI* usb, BenchmarkStats& stats) {
         if (!usb_waiting_for_response) {
             bigtime_t latency = usb_response_time - send_time;
             // Always show feedback
-            if (i >= WARMUP_ITERATIONS) {
+            if (i >= warmup_iterations) {
                 stats.RecordMeasurement(latency);
                 printf("   ✓ Measurement %d/%d: %.2f ms\n",
-                       i - WARMUP_ITERATIONS + 1, BENCHMARK_ITERATIONS, latency / 1000.0);
+                       i - warmup_iterations + 1, benchmark_iterations, latency / 1000.0);
             } else {
-                printf("   Warmup %d/%d: %.2f ms\n", i + 1, WARMUP_ITERATIONS, latency / 1000.0);
+                printf("   Warmup %d/%d: %.2f ms\n", i + 1, warmup_iterations, latency / 1000.0);
             }
             // Brief flash to confirm
             usb->SetPadColor(PAD_NOTE_TEST, static_cast<APCMiniLEDColor>(25));
             snooze(100000); // 100ms flash
         } else {
-            if (i >= WARMUP_ITERATIONS) {
+            if (i >= warmup_iterations) {
                 stats.failure_count++;
-                printf("   ✗ Timeout %d/%d - no response\n", i - WARMUP_ITERATIONS + 1, BENCHMARK_ITERATIONS);
+                printf("   ✗ Timeout %d/%d - no response\n", i - warmup_iterations + 1, benchmark_iterations);
             } else {
-                printf("   ✗ Warmup timeout %d/%d\n", i + 1, WARMUP_ITERATIONS);
+                printf("   ✗ Warmup timeout %d/%d\n", i + 1, warmup_iterations);
             }
         }
 
@@ -332,7 +349,7 @@ void PrintBenchmarkHeader() {
     printf("========================================\n");
     printf("Testing round-trip latency:\n");
     printf("  - USB Raw access vs MIDI API\n");
-    printf("  - %d iterations (after %d warmup)\n", BENCHMARK_ITERATIONS, WARMUP_ITERATIONS);
+    printf("  - %d iterations (after %d warmup)\n", benchmark_iterations, warmup_iterations);
     printf("  - Measures Note On -> Echo response\n");
     printf("========================================\n\n");
 }
@@ -370,10 +387,9 @@ void PrintComparison(const BenchmarkStats& usb_stats, const BenchmarkStats& midi
 }
 
 int main(int argc, char** argv) {
-    PrintBenchmarkHeader();
-
     bool test_usb = true;
     bool test_midi = true;
+    const char* workload_name = "probe";
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -381,16 +397,31 @@ int main(int argc, char** argv) {
             test_midi = false;
         } else if (strcmp(argv[i], "--midi-only") == 0) {
             test_usb = false;
+        } else if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            workload_name = argv[++i];
         } else if (strcmp(argv[i], "--help") == 0) {
             printf("Usage: %s [options]\n", argv[0]);
             printf("Options:\n");
             printf("  --usb-only    Test only USB Raw access\n");
             printf("  --midi-only   Test only MIDI API\n");
+            printf("  --workload <name|file>  Probe counts from a workload (default: probe)\n");
             printf("  --help        Show this help\n");
             return 0;
         }
     }
 
+    Workload workload;
+    char error[128];
+    if (!Workload::Resolve(workload_name, workload, error, sizeof(error))) {
+        printf("ERROR: workload '%s': %s\n", workload_name, error);
+        return 1;
+    }
+    if (!ConfigureWorkload(workload)) {
+        return 1;
+    }
+
+    PrintBenchmarkHeader();
+
     BenchmarkStats usb_stats, midi_stats;
     usb_stats.Reset();
     midi_stats.Reset();
@@ -0,0 +1,183 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apc_mini_platform.h"
+
+/**
+ * LatencyHistogram - Fixed-size log-linear histogram for microsecond latencies
+ *
+ * Min/max/average (as kept by BenchmarkStats and MIDIQueueStats) hide the
+ * tail, which is what users feel as "lag". This histogram keeps the whole
+ * distribution in constant memory so percentiles can be reported:
+ *
+ * BUCKET LAYOUT:
+ * - Values below 64 us are counted exactly (one bucket per microsecond)
+ * - Above that, each power of two is split into 32 linear sub-buckets,
+ *   giving ~3% relative precision up to ~12 days
+ *
+ * THREAD SAFETY:
+ * - Record() uses relaxed atomic increments and may be called from any
+ *   number of threads concurrently (no locks, no allocation)
+ * - Readers see an approximate snapshot while recording is in progress
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t LINEAR_LIMIT = 64;
+    static constexpr uint32_t SUB_BUCKET_BITS = 5;
+    static constexpr uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_EXPONENT = 40;    // 2^40 us
+    static constexpr uint32_t BUCKET_COUNT =
+        LINEAR_LIMIT + (MAX_EXPONENT - 6 + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { Reset(); }
+
+    void Record(bigtime_t latency_us) {
+        uint64_t value = latency_us < 0 ? 0 : static_cast<uint64_t>(latency_us);
+        buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        total_count.fetch_add(1, std::memory_order_relaxed);
+        total_sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current_max = max_value.load(std::memory_order_relaxed);
+        while (value > current_max &&
+               !max_value.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+        }
+        uint64_t current_min = min_value.load(std::memory_order_relaxed);
+        while (value < current_min &&
+               !min_value.compare_exchange_weak(current_min, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Reset() {
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i].store(0, std::memory_order_relaxed);
+        }
+        total_count.store(0, std::memory_order_relaxed);
+        total_sum.store(0, std::memory_order_relaxed);
+        max_value.store(0, std::memory_order_relaxed);
+        min_value.store(UINT64_MAX, std::memory_order_relaxed);
+    }
+
+    // Add all samples of another histogram (e.g. per-thread histograms)
+    void Merge(const LatencyHistogram& other) {
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+        }
+        total_count.fetch_add(other.Count(), std::memory_order_relaxed);
+        total_sum.fetch_add(other.total_sum.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+
+        uint64_t other_max = other.max_value.load(std::memory_order_relaxed);
+        uint64_t current_max = max_value.load(std::memory_order_relaxed);
+        while (other_max > current_max &&
+               !max_value.compare_exchange_weak(current_max, other_max, std::memory_order_relaxed)) {
+        }
+        uint64_t other_min = other.min_value.load(std::memory_order_relaxed);
+        uint64_t current_min = min_value.load(std::memory_order_relaxed);
+        while (other_min < current_min &&
+               !min_value.compare_exchange_weak(current_min, other_min, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t Count() const { return total_count.load(std::memory_order_relaxed); }
+
+    bigtime_t Max() const {
+        return static_cast<bigtime_t>(max_value.load(std::memory_order_relaxed));
+    }
+
+    bigtime_t Min() const {
+        uint64_t value = min_value.load(std::memory_order_relaxed);
+        return value == UINT64_MAX ? 0 : static_cast<bigtime_t>(value);
+    }
+
+    double Mean() const {
+        uint64_t count = Count();
+        return count > 0 ? (double)total_sum.load(std::memory_order_relaxed) / count : 0.0;
+    }
+
+    /**
+     * Value at the given percentile (0.0 - 100.0)
+     *
+     * Returns the upper bound of the bucket holding the requested rank,
+     * clamped to the recorded maximum, so the result never under-reports.
+     */
+    bigtime_t Percentile(double percentile) const {
+        uint64_t count = Count();
+        if (count == 0) {
+            return 0;
+        }
+
+        if (percentile < 0.0) percentile = 0.0;
+        if (percentile > 100.0) percentile = 100.0;
+
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+        if (rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = BucketUpperBound(i);
+                uint64_t max = max_value.load(std::memory_order_relaxed);
+                return static_cast<bigtime_t>(upper < max ? upper : max);
+            }
+        }
+        return Max();
+    }
+
+    uint32_t GetBucketCount() const { return BUCKET_COUNT; }
+
+    uint64_t GetBucketSamples(uint32_t index) const {
+        return index < BUCKET_COUNT ? buckets[index].load(std::memory_order_relaxed) : 0;
+    }
+
+    static uint32_t BucketIndex(uint64_t value) {
+        if (value < LINEAR_LIMIT) {
+            return static_cast<uint32_t>(value);
+        }
+
+        uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+        if (msb > MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+
+        uint32_t shift = msb - SUB_BUCKET_BITS;
+        uint32_t mantissa = static_cast<uint32_t>(value >> shift) - SUB_BUCKETS;
+        return LINEAR_LIMIT + (msb - 6) * SUB_BUCKETS + mantissa;
+    }
+
+    static uint64_t BucketLowerBound(uint32_t index) {
+        if (index < LINEAR_LIMIT) {
+            return index;
+        }
+
+        uint32_t msb = (index - LINEAR_LIMIT) / SUB_BUCKETS + 6;
+        uint64_t mantissa = (index - LINEAR_LIMIT) % SUB_BUCKETS + SUB_BUCKETS;
+        return mantissa << (msb - SUB_BUCKET_BITS);
+    }
+
+    static uint64_t BucketUpperBound(uint32_t index) {
+        if (index < LINEAR_LIMIT) {
+            return index;
+        }
+
+        uint32_t msb = (index - LINEAR_LIMIT) / SUB_BUCKETS + 6;
+        return BucketLowerBound(index) + (1ULL << (msb - SUB_BUCKET_BITS)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> total_count;
+    std::atomic<uint64_t> total_sum;
+    std::atomic<uint64_t> max_value;
+    std::atomic<uint64_t> min_value;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+};
+
+#endif // LATENCY_HISTOGRAM_H
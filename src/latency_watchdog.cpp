@@ -0,0 +1,443 @@
+#include "latency_watchdog.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <sys/stat.h>
+
+#ifdef __HAIKU__
+#include <FindDirectory.h>
+#endif
+
+static const char* const TRANSPORT_STATE_NAMES[] = {
+    "opened", "closed", "error", "stalled"
+};
+
+WatchdogConfig WatchdogConfig::Default()
+{
+    WatchdogConfig config;
+    config.check_interval_us = 100000;      // 10 wakeups/s
+    config.dump_window_us = 5000000;        // Last 5 s
+    config.dump_cooldown_us = 10000000;     // At most one dump per 10 s
+    config.max_dumps = 20;
+    if (!LatencyWatchdog::DefaultDumpDirectory(config.dump_directory, sizeof(config.dump_directory))) {
+        snprintf(config.dump_directory, sizeof(config.dump_directory), ".");
+    }
+    return config;
+}
+
+LatencyWatchdog::LatencyWatchdog(FlightRecorder* flight_recorder, MetricsRegistry* metrics_registry)
+    : recorder(flight_recorder)
+    , registry(metrics_registry)
+    , config()
+    , budget_count(0)
+    , heartbeat_count(0)
+    , gauge_count(0)
+    , pending_budget(-1)
+    , pending_latency(0)
+    , pending_stall(false)
+    , violations(0)
+    , stalls(0)
+    , dumps(0)
+    , recorder_dropped(0)
+    , last_dump_at(0)
+    , dumps_this_run(0)
+    , dump_events(new FlightEvent[DUMP_MAX_EVENTS])
+    , stop_requested(false)
+    , running(false)
+{
+    pending_stall_name[0] = '\0';
+    last_dump_path[0] = '\0';
+
+    if (registry) {
+        registry->RegisterCounter("watchdog.violations", &violations);
+        registry->RegisterCounter("watchdog.stalls", &stalls);
+        registry->RegisterCounter("watchdog.dumps", &dumps);
+        registry->RegisterCounter("flight.dropped", &recorder_dropped);
+    }
+}
+
+LatencyWatchdog::~LatencyWatchdog()
+{
+    Stop();
+
+    if (registry) {
+        registry->Unregister(&violations);
+        registry->Unregister(&stalls);
+        registry->Unregister(&dumps);
+        registry->Unregister(&recorder_dropped);
+    }
+    delete[] dump_events;
+}
+
+LatencyWatchdog& LatencyWatchdog::Default()
+{
+    static LatencyWatchdog watchdog(&FlightRecorder::Default(), &MetricsRegistry::Default());
+    return watchdog;
+}
+
+int LatencyWatchdog::AddBudget(const char* name, bigtime_t budget_us)
+{
+    if (!name || budget_us <= 0 || budget_count == MAX_BUDGETS || running.load()) {
+        return -1;
+    }
+
+    Budget& entry = budgets[budget_count];
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.budget_us = budget_us;
+    entry.samples.store(0);
+    entry.violations.store(0);
+    entry.worst_us.store(0);
+    return (int)budget_count++;
+}
+
+int LatencyWatchdog::AddHeartbeat(const char* name, bigtime_t stall_us)
+{
+    if (!name || stall_us <= 0 || heartbeat_count == MAX_HEARTBEATS || running.load()) {
+        return -1;
+    }
+
+    Heartbeat& entry = heartbeats[heartbeat_count];
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.stall_us = stall_us;
+    entry.last_beat.store(system_time());
+    entry.stalled = false;
+    return (int)heartbeat_count++;
+}
+
+int LatencyWatchdog::AddGauge(const char* name, GaugeReader reader)
+{
+    if (!name || !reader || gauge_count == MAX_GAUGES || running.load()) {
+        return -1;
+    }
+
+    Gauge& entry = gauges[gauge_count];
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.reader = reader;
+    entry.last_value = 0;
+    return (int)gauge_count++;
+}
+
+void LatencyWatchdog::RaiseWorst(Budget& entry, bigtime_t latency_us)
+{
+    bigtime_t worst = entry.worst_us.load(std::memory_order_relaxed);
+    while (latency_us > worst &&
+           !entry.worst_us.compare_exchange_weak(worst, latency_us, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyWatchdog::OnBudgetExceeded(int budget, bigtime_t latency_us)
+{
+    budgets[budget].violations.fetch_add(1, std::memory_order_relaxed);
+    violations.fetch_add(1, std::memory_order_relaxed);
+    recorder->Record(FLIGHT_EVENT_BUDGET_EXCEEDED, ClampValue(latency_us), 0, (uint8_t)budget, 0);
+
+    // Keep the first violation since the last check as the dump reason
+    if (pending_budget.load(std::memory_order_relaxed) < 0) {
+        pending_latency.store(latency_us, std::memory_order_relaxed);
+        int expected = -1;
+        pending_budget.compare_exchange_strong(expected, budget, std::memory_order_release);
+    }
+}
+
+APCMiniError LatencyWatchdog::Start(const WatchdogConfig& watchdog_config)
+{
+    if (running.load()) {
+        return APC_SUCCESS;
+    }
+    if (watchdog_config.check_interval_us <= 0 || watchdog_config.dump_window_us <= 0) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        config = watchdog_config;
+        dumps_this_run = 0;
+        last_dump_at = 0;
+        pending_stall = false;
+        bigtime_t now = system_time();
+        for (size_t i = 0; i < heartbeat_count; i++) {
+            heartbeats[i].last_beat.store(now);
+            heartbeats[i].stalled = false;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guard(thread_lock);
+        stop_requested = false;
+    }
+
+    running.store(true);
+    watchdog_thread = std::thread(&LatencyWatchdog::WatchdogThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void LatencyWatchdog::Stop()
+{
+    if (!running.load()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(thread_lock);
+        stop_requested = true;
+    }
+    stop_signal.notify_all();
+
+    if (watchdog_thread.joinable()) {
+        watchdog_thread.join();
+    }
+    running.store(false);
+}
+
+void LatencyWatchdog::WatchdogThreadLoop()
+{
+    ScopedThreadAccounting accounting("watchdog");
+
+    std::unique_lock<std::mutex> guard(thread_lock);
+    while (!stop_requested) {
+        stop_signal.wait_for(guard, std::chrono::microseconds(config.check_interval_us));
+        ThreadAccounting::NoteWakeup();
+        if (stop_requested) {
+            break;
+        }
+
+        guard.unlock();
+        CheckNow();
+        guard.lock();
+    }
+}
+
+void LatencyWatchdog::SampleGauges(bigtime_t now)
+{
+    // Called with lock held
+    for (size_t i = 0; i < gauge_count; i++) {
+        uint64_t value = gauges[i].reader();
+        gauges[i].last_value = value;
+        recorder->Record(FLIGHT_EVENT_GAUGE, now, ClampValue((bigtime_t)value), 0, (uint8_t)i, 0);
+    }
+}
+
+void LatencyWatchdog::CheckHeartbeats(bigtime_t now)
+{
+    // Called with lock held
+    for (size_t i = 0; i < heartbeat_count; i++) {
+        Heartbeat& entry = heartbeats[i];
+        bigtime_t silence = now - entry.last_beat.load(std::memory_order_relaxed);
+        if (silence <= entry.stall_us) {
+            entry.stalled = false;
+            continue;
+        }
+        if (entry.stalled) {
+            continue;      // Already reported this stall
+        }
+
+        entry.stalled = true;
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        recorder->Record(FLIGHT_EVENT_HEARTBEAT_STALL, now, ClampValue(silence), 0, (uint8_t)i, 0);
+        if (!pending_stall) {
+            pending_stall = true;
+            snprintf(pending_stall_name, sizeof(pending_stall_name), "%s", entry.name);
+        }
+    }
+}
+
+bool LatencyWatchdog::CheckNow()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    bigtime_t now = system_time();
+    recorder_dropped.store(recorder->Dropped(), std::memory_order_relaxed);
+    SampleGauges(now);
+    CheckHeartbeats(now);
+
+    char reason[160];
+    reason[0] = '\0';
+    int budget = pending_budget.exchange(-1, std::memory_order_acquire);
+    if (budget >= 0) {
+        snprintf(reason, sizeof(reason), "%s took %lld us (budget %lld us)", budgets[budget].name,
+                 (long long)pending_latency.load(std::memory_order_relaxed),
+                 (long long)budgets[budget].budget_us);
+    } else if (pending_stall) {
+        for (size_t i = 0; i < heartbeat_count; i++) {
+            if (strcmp(heartbeats[i].name, pending_stall_name) == 0) {
+                snprintf(reason, sizeof(reason), "%s heartbeat silent for more than %lld ms",
+                         pending_stall_name, (long long)(heartbeats[i].stall_us / 1000));
+            }
+        }
+    }
+    pending_stall = false;
+
+    if (reason[0] == '\0') {
+        return false;
+    }
+    if (dumps_this_run >= config.max_dumps ||
+        (last_dump_at != 0 && now - last_dump_at < config.dump_cooldown_us)) {
+        return false;
+    }
+    return WriteDump(reason, now);
+}
+
+bool LatencyWatchdog::DumpNow(const char* reason)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return WriteDump(reason ? reason : "requested", system_time());
+}
+
+bool LatencyWatchdog::WriteDump(const char* reason, bigtime_t now)
+{
+    // Called with lock held
+    char path[sizeof(last_dump_path)];
+    time_t wall = time(nullptr);
+    struct tm local;
+    localtime_r(&wall, &local);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    snprintf(path, sizeof(path), "%s/apc_flight_%s_%llu.txt", config.dump_directory, stamp,
+             (unsigned long long)dumps.load(std::memory_order_relaxed));
+
+    // Created on first use; fopen() reports anything else
+    mkdir(config.dump_directory, 0755);
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    WriteDumpBody(file, reason, now);
+    fclose(file);
+
+    last_dump_at = now;
+    dumps_this_run++;
+    dumps.fetch_add(1, std::memory_order_relaxed);
+    memcpy(last_dump_path, path, sizeof(last_dump_path));
+    return true;
+}
+
+void LatencyWatchdog::WriteDumpBody(FILE* file, const char* reason, bigtime_t now)
+{
+    // Freeze only for the copy; the file is written with recording back on
+    uint64_t dropped_before = recorder->Dropped();
+    recorder->Freeze();
+    size_t count = recorder->Snapshot(dump_events, DUMP_MAX_EVENTS, now - config.dump_window_us);
+    recorder->Thaw();
+
+    fprintf(file, "APC Mini flight recorder dump\n");
+    fprintf(file, "Reason: %s\n", reason);
+    fprintf(file, "Window: last %lld ms, %zu events (%llu dropped in total)\n\n",
+            (long long)(config.dump_window_us / 1000), count, (unsigned long long)dropped_before);
+
+    fprintf(file, "%-24s %10s %10s %10s %10s\n", "Budget", "Limit us", "Samples", "Over", "Worst us");
+    for (size_t i = 0; i < budget_count; i++) {
+        const Budget& entry = budgets[i];
+        fprintf(file, "%-24s %10lld %10llu %10llu %10lld\n", entry.name, (long long)entry.budget_us,
+                (unsigned long long)entry.samples.load(), (unsigned long long)entry.violations.load(),
+                (long long)entry.worst_us.load());
+    }
+
+    if (heartbeat_count > 0) {
+        fprintf(file, "\n%-24s %10s %10s\n", "Heartbeat", "Limit ms", "Silent ms");
+        for (size_t i = 0; i < heartbeat_count; i++) {
+            const Heartbeat& entry = heartbeats[i];
+            fprintf(file, "%-24s %10lld %10.1f%s\n", entry.name, (long long)(entry.stall_us / 1000),
+                    (now - entry.last_beat.load()) / 1000.0, entry.stalled ? "  STALLED" : "");
+        }
+    }
+
+    if (gauge_count > 0) {
+        fprintf(file, "\n%-24s %10s\n", "Gauge", "Value");
+        for (size_t i = 0; i < gauge_count; i++) {
+            fprintf(file, "%-24s %10llu\n", gauges[i].name, (unsigned long long)gauges[i].last_value);
+        }
+    }
+
+    if (registry) {
+        fprintf(file, "\nMetrics:\n");
+        registry->Print(file);
+    }
+
+    fprintf(file, "\nEvents (ms relative to the dump):\n");
+    for (size_t i = 0; i < count; i++) {
+        const FlightEvent& event = dump_events[i];
+        fprintf(file, "%10.3f  %-13s ", (event.time - now) / 1000.0, FlightRecorder::KindName(event.kind));
+        switch (event.kind) {
+            case FLIGHT_EVENT_MIDI_IN:
+            case FLIGHT_EVENT_MIDI_OUT:
+                fprintf(file, "%02X %02X %02X\n", event.status, event.data1, event.data2);
+                break;
+            case FLIGHT_EVENT_DISPATCH:
+            case FLIGHT_EVENT_DRAW:
+                fprintf(file, "%02X %02X %02X  %u us\n", event.status, event.data1, event.data2, event.value);
+                break;
+            case FLIGHT_EVENT_STAGE_LATENCY:
+            case FLIGHT_EVENT_BUDGET_EXCEEDED:
+                fprintf(file, "%s %u us\n",
+                        event.data1 < budget_count ? budgets[event.data1].name : "?", event.value);
+                break;
+            case FLIGHT_EVENT_GAUGE:
+                fprintf(file, "%s = %u\n",
+                        event.data1 < gauge_count ? gauges[event.data1].name : "?", event.value);
+                break;
+            case FLIGHT_EVENT_HEARTBEAT_STALL:
+                fprintf(file, "%s silent %.1f ms\n",
+                        event.data1 < heartbeat_count ? heartbeats[event.data1].name : "?",
+                        event.value / 1000.0);
+                break;
+            case FLIGHT_EVENT_TRANSPORT:
+                fprintf(file, "%s %u\n", event.data1 <= FLIGHT_TRANSPORT_STALLED
+                        ? TRANSPORT_STATE_NAMES[event.data1] : "?", event.value);
+                break;
+            default:
+                fprintf(file, "%u\n", event.value);
+                break;
+        }
+    }
+}
+
+WatchdogStageStats LatencyWatchdog::GetStageStats(int budget) const
+{
+    WatchdogStageStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (budget < 0 || (size_t)budget >= budget_count) {
+        return stats;
+    }
+
+    const Budget& entry = budgets[budget];
+    stats.name = entry.name;
+    stats.budget_us = entry.budget_us;
+    stats.samples = entry.samples.load(std::memory_order_relaxed);
+    stats.violations = entry.violations.load(std::memory_order_relaxed);
+    stats.worst_us = entry.worst_us.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LatencyWatchdog::GetLastDumpPath(char* path, size_t path_size) const
+{
+    if (!path || path_size == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    snprintf(path, path_size, "%s", last_dump_path);
+}
+
+bool LatencyWatchdog::DefaultDumpDirectory(char* path, size_t path_size)
+{
+    if (!path || path_size == 0) {
+        return false;
+    }
+
+#ifdef __HAIKU__
+    char directory[B_PATH_NAME_LENGTH];
+    if (find_directory(B_USER_SETTINGS_DIRECTORY, -1, true, directory, sizeof(directory)) != B_OK) {
+        return false;
+    }
+    int written = snprintf(path, path_size, "%s/apc_mini_flight", directory);
+#else
+    const char* home = getenv("HOME");
+    if (!home || !*home) {
+        return false;
+    }
+    int written = snprintf(path, path_size, "%s/.apc_mini_flight", home);
+#endif
+
+    return written > 0 && (size_t)written < path_size;
+}
@@ -0,0 +1,209 @@
+#ifndef LATENCY_WATCHDOG_H
+#define LATENCY_WATCHDOG_H
+
+/*
+ * Latency-Budget Watchdog
+ *
+ * Checks per-stage latencies against configured budgets (for example
+ * reader->dispatch < 500 us, dispatch->draw < 16 ms) and watches thread
+ * heartbeats for stalls. On a violation it freezes the FlightRecorder and
+ * dumps the last few seconds of trace events, gauges (queue depths) and the
+ * MetricsRegistry (transport state, RTT, thread usage) to a text file.
+ *
+ * - ReportLatency() is the hot path: it records the sample in the flight
+ *   recorder and compares it with the budget. Within budget that is all;
+ *   over budget it bumps counters and flags the watchdog thread
+ * - Beat() stores the current time in the heartbeat's slot
+ * - A background thread (one wakeup per check interval) samples the gauges
+ *   into the recorder, looks for silent heartbeats and writes the dump, so
+ *   file I/O never happens on a realtime thread
+ * - Dumps are rate limited by a cooldown and capped per run so a sustained
+ *   overload cannot fill the disk
+ *
+ * Budgets, heartbeats and gauges are added before Start().
+ * Metrics: "watchdog.violations", "watchdog.stalls", "watchdog.dumps" and
+ * "flight.dropped".
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "flight_recorder.h"
+
+class MetricsRegistry;
+
+#define WATCHDOG_NAME_LENGTH 32
+#define WATCHDOG_PATH_LENGTH 256
+
+struct WatchdogConfig {
+    bigtime_t check_interval_us;   // Watchdog thread period
+    bigtime_t dump_window_us;      // History written per dump
+    bigtime_t dump_cooldown_us;    // Minimum time between dumps
+    uint32_t max_dumps;            // Per Start(); 0 = never write files
+    char dump_directory[WATCHDOG_PATH_LENGTH];
+
+    static WatchdogConfig Default();
+};
+
+struct WatchdogStageStats {
+    const char* name;
+    bigtime_t budget_us;
+    uint64_t samples;
+    uint64_t violations;
+    bigtime_t worst_us;            // Since Start(); never reset by reads
+};
+
+class LatencyWatchdog {
+public:
+    static constexpr size_t MAX_BUDGETS = 8;
+    static constexpr size_t MAX_HEARTBEATS = 8;
+    static constexpr size_t MAX_GAUGES = 8;
+    static constexpr size_t DUMP_MAX_EVENTS = 16384;
+
+    // Sampled on the watchdog thread only
+    typedef std::function<uint64_t()> GaugeReader;
+
+    LatencyWatchdog(FlightRecorder* recorder, MetricsRegistry* registry = nullptr);
+    ~LatencyWatchdog();
+
+    // Default() recorder and registry; budgets are added by the application
+    static LatencyWatchdog& Default();
+
+    /**
+     * Add a stage budget (before Start())
+     *
+     * @return Index for ReportLatency(), or -1 when full
+     */
+    int AddBudget(const char* name, bigtime_t budget_us);
+
+    // A thread that should Beat() at least every stall_us (before Start())
+    int AddHeartbeat(const char* name, bigtime_t stall_us);
+
+    // A value sampled into the recorder every check (queue depths)
+    int AddGauge(const char* name, GaugeReader reader);
+
+    // Any thread; no locks, no allocation
+    void ReportLatency(int budget, bigtime_t latency_us) {
+        if (budget < 0 || (size_t)budget >= budget_count) {
+            return;
+        }
+        Budget& entry = budgets[budget];
+        entry.samples.fetch_add(1, std::memory_order_relaxed);
+        recorder->Record(FLIGHT_EVENT_STAGE_LATENCY, ClampValue(latency_us), 0, (uint8_t)budget, 0);
+        if (latency_us > entry.worst_us.load(std::memory_order_relaxed)) {
+            RaiseWorst(entry, latency_us);
+        }
+        if (latency_us > entry.budget_us) {
+            OnBudgetExceeded(budget, latency_us);
+        }
+    }
+
+    void Beat(int heartbeat) {
+        if (heartbeat >= 0 && (size_t)heartbeat < heartbeat_count) {
+            heartbeats[heartbeat].last_beat.store(system_time(), std::memory_order_relaxed);
+        }
+    }
+
+    APCMiniError Start(const WatchdogConfig& config = WatchdogConfig::Default());
+    void Stop();
+    bool IsRunning() const { return running.load(); }
+
+    /**
+     * One watchdog pass: sample gauges, check heartbeats and dump if a
+     * violation is pending (what the thread does every interval)
+     *
+     * @return true if a dump was written
+     */
+    bool CheckNow();
+
+    // Write a dump now, whatever the budgets say
+    bool DumpNow(const char* reason);
+
+    WatchdogStageStats GetStageStats(int budget) const;
+    uint64_t Violations() const { return violations.load(std::memory_order_relaxed); }
+    uint64_t Stalls() const { return stalls.load(std::memory_order_relaxed); }
+    uint64_t Dumps() const { return dumps.load(std::memory_order_relaxed); }
+
+    // Path of the most recent dump ("" if none yet)
+    void GetLastDumpPath(char* path, size_t path_size) const;
+
+    // Settings directory on Haiku, $HOME elsewhere
+    static bool DefaultDumpDirectory(char* path, size_t path_size);
+
+private:
+    struct Budget {
+        char name[WATCHDOG_NAME_LENGTH];
+        bigtime_t budget_us;
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> violations;
+        std::atomic<bigtime_t> worst_us;
+    };
+
+    struct Heartbeat {
+        char name[WATCHDOG_NAME_LENGTH];
+        bigtime_t stall_us;
+        std::atomic<bigtime_t> last_beat;
+        bool stalled;              // Reported; cleared by the next beat
+    };
+
+    struct Gauge {
+        char name[WATCHDOG_NAME_LENGTH];
+        GaugeReader reader;
+        uint64_t last_value;
+    };
+
+    static uint32_t ClampValue(bigtime_t value) {
+        return value < 0 ? 0 : (value > (bigtime_t)UINT32_MAX ? UINT32_MAX : (uint32_t)value);
+    }
+
+    static void RaiseWorst(Budget& entry, bigtime_t latency_us);
+    void OnBudgetExceeded(int budget, bigtime_t latency_us);
+    void SampleGauges(bigtime_t now);
+    void CheckHeartbeats(bigtime_t now);
+    bool WriteDump(const char* reason, bigtime_t now);
+    void WriteDumpBody(FILE* file, const char* reason, bigtime_t now);
+    void WatchdogThreadLoop();
+
+    FlightRecorder* recorder;
+    MetricsRegistry* registry;
+    WatchdogConfig config;
+
+    Budget budgets[MAX_BUDGETS];
+    size_t budget_count;
+    Heartbeat heartbeats[MAX_HEARTBEATS];
+    size_t heartbeat_count;
+    Gauge gauges[MAX_GAUGES];
+    size_t gauge_count;
+
+    // First violation since the last check (budget index, -1 = none)
+    std::atomic<int> pending_budget;
+    std::atomic<bigtime_t> pending_latency;
+    bool pending_stall;                    // Watchdog thread only
+    char pending_stall_name[WATCHDOG_NAME_LENGTH];
+
+    std::atomic<uint64_t> violations;
+    std::atomic<uint64_t> stalls;
+    std::atomic<uint64_t> dumps;
+    std::atomic<uint64_t> recorder_dropped;
+    bigtime_t last_dump_at;
+    uint32_t dumps_this_run;
+    FlightEvent* dump_events;              // Preallocated for the dump
+
+    mutable std::mutex lock;               // Check/dump and last_dump_path
+    std::mutex thread_lock;
+    std::condition_variable stop_signal;
+    bool stop_requested;
+    std::atomic<bool> running;
+    std::thread watchdog_thread;
+    char last_dump_path[WATCHDOG_PATH_LENGTH + 64];
+};
+
+#endif // LATENCY_WATCHDOG_H
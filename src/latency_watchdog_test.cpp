@@ -0,0 +1,267 @@
+/*
+ * Latency Watchdog Test
+ * Flight recorder ring (wrap, freeze, concurrent writers), budget and
+ * heartbeat violations, and the dump file contents
+ */
+
+#include "latency_watchdog.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_DUMP_DIRECTORY "/tmp/apc_mini_watchdog_test"
+
+static WatchdogConfig TestConfig()
+{
+    WatchdogConfig config = WatchdogConfig::Default();
+    config.check_interval_us = 10000000;    // Tests call CheckNow() themselves
+    config.dump_window_us = 2000000;
+    config.dump_cooldown_us = 0;
+    config.max_dumps = 4;
+    snprintf(config.dump_directory, sizeof(config.dump_directory), "%s", TEST_DUMP_DIRECTORY);
+    return config;
+}
+
+static std::string ReadFile(const char* path)
+{
+    std::string text;
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return text;
+    }
+    char chunk[1024];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, count);
+    }
+    fclose(file);
+    return text;
+}
+
+void test_recorder_ring()
+{
+    printf("Testing flight recorder ring...\n");
+
+    FlightRecorder recorder(100);
+    assert(recorder.Capacity() == 128);
+
+    // Wraps: only the newest 128 survive, oldest first
+    for (uint32_t i = 0; i < 300; i++) {
+        recorder.Record(FLIGHT_EVENT_MIDI_IN, 1000 + i, i, 0x90, (uint8_t)(i & 0x3F), 0x7F);
+    }
+    std::vector<FlightEvent> events(256);
+    size_t count = recorder.Snapshot(events.data(), events.size());
+    assert(count == 128);
+    assert(events[0].value == 172 && events[127].value == 299);
+    assert(events[0].kind == FLIGHT_EVENT_MIDI_IN && events[0].status == 0x90 && events[0].data2 == 0x7F);
+
+    // Time filter and a short output buffer keep the newest events
+    count = recorder.Snapshot(events.data(), events.size(), 1290);
+    assert(count == 10 && events[0].value == 290);
+    count = recorder.Snapshot(events.data(), 5);
+    assert(count == 5 && events[4].value == 299);
+
+    // Frozen: nothing is recorded, drops are counted
+    recorder.Freeze();
+    recorder.Freeze();
+    recorder.Record(FLIGHT_EVENT_MARK, 5000, 1, 0, 0, 0);
+    recorder.Thaw();
+    assert(recorder.IsFrozen());
+    recorder.Record(FLIGHT_EVENT_MARK, 5001, 2, 0, 0, 0);
+    recorder.Thaw();
+    assert(!recorder.IsFrozen());
+    assert(recorder.Dropped() == 2);
+    recorder.Record(FLIGHT_EVENT_MARK, 5002, 3, 0, 0, 0);
+    count = recorder.Snapshot(events.data(), events.size());
+    assert(events[count - 1].value == 3 && events[count - 2].value == 299);
+
+    assert(strcmp(FlightRecorder::KindName(FLIGHT_EVENT_DRAW), "draw") == 0);
+
+    printf("✅ Ring wraps, filters by time and stops while frozen\n");
+}
+
+void test_recorder_concurrent_writers()
+{
+    printf("Testing concurrent writers against a reader...\n");
+
+    FlightRecorder recorder(1024);
+    std::atomic<bool> stop(false);
+    const int writers = 3;
+
+    // value encodes (writer, sequence); every snapshot must be consistent
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.push_back(std::thread([&recorder, &stop, w]() {
+            uint32_t sequence = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t value = ((uint32_t)w << 24) | (sequence & 0xFFFFFF);
+                recorder.Record(FLIGHT_EVENT_MARK, (bigtime_t)value, value, (uint8_t)w,
+                                (uint8_t)value, (uint8_t)(value >> 8));
+                sequence++;
+            }
+        }));
+    }
+
+    // Under a loaded build the writers may not have started yet
+    while (recorder.Recorded() < 1024) {
+        std::this_thread::yield();
+    }
+
+    std::vector<FlightEvent> events(1024);
+    size_t checked = 0;
+    for (int round = 0; round < 200; round++) {
+        size_t count = recorder.Snapshot(events.data(), events.size());
+        for (size_t i = 0; i < count; i++) {
+            const FlightEvent& event = events[i];
+            assert(event.kind == FLIGHT_EVENT_MARK);
+            assert((bigtime_t)event.value == event.time);
+            assert(event.status == (uint8_t)(event.value >> 24));
+            assert(event.data1 == (uint8_t)event.value && event.data2 == (uint8_t)(event.value >> 8));
+        }
+        checked += count;
+    }
+
+    stop.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    assert(recorder.Recorded() > 0);
+
+    printf("✅ %zu events read back untorn while %d threads wrote\n", checked, writers);
+}
+
+void test_budget_violation_dump()
+{
+    printf("Testing budget violations and dumps...\n");
+
+    MetricsRegistry registry;
+    FlightRecorder recorder(4096);
+    LatencyWatchdog watchdog(&recorder, &registry);
+
+    int reader_dispatch = watchdog.AddBudget("reader_dispatch", 500);
+    int dispatch_draw = watchdog.AddBudget("dispatch_draw", 16000);
+    assert(reader_dispatch == 0 && dispatch_draw == 1);
+    assert(watchdog.AddBudget("bad", 0) == -1);
+
+    uint64_t queue_depth = 7;
+    assert(watchdog.AddGauge("midi_queue.depth", [&queue_depth]() { return queue_depth; }) == 0);
+    assert(watchdog.Start(TestConfig()) == APC_SUCCESS);
+    assert(watchdog.AddBudget("too_late", 100) == -1);
+
+    // Within budget: samples only, no dump
+    for (int i = 0; i < 100; i++) {
+        recorder.Record(FLIGHT_EVENT_MIDI_IN, 0, 0x90, (uint8_t)i, 0x7F);
+        watchdog.ReportLatency(reader_dispatch, 100 + i);
+        watchdog.ReportLatency(dispatch_draw, 2000);
+    }
+    assert(!watchdog.CheckNow());
+    assert(watchdog.Violations() == 0 && watchdog.Dumps() == 0);
+
+    // One slow dispatch
+    queue_depth = 250;
+    watchdog.ReportLatency(reader_dispatch, 812);
+    watchdog.ReportLatency(reader_dispatch, 900);
+    assert(watchdog.Violations() == 2);
+    assert(watchdog.CheckNow());
+    assert(watchdog.Dumps() == 1);
+
+    WatchdogStageStats stats = watchdog.GetStageStats(reader_dispatch);
+    assert(stats.samples == 102 && stats.violations == 2 && stats.worst_us == 900);
+    assert(strcmp(stats.name, "reader_dispatch") == 0);
+
+    MetricSample sample;
+    assert(registry.Find("watchdog.violations", sample) && sample.value == 2);
+    assert(registry.Find("watchdog.dumps", sample) && sample.value == 1);
+
+    // The dump names the first violation and holds the history before it
+    char path[512];
+    watchdog.GetLastDumpPath(path, sizeof(path));
+    assert(strstr(path, TEST_DUMP_DIRECTORY "/apc_flight_") == path);
+    std::string dump = ReadFile(path);
+    assert(dump.find("Reason: reader_dispatch took 812 us (budget 500 us)") != std::string::npos);
+    assert(dump.find("midi_in       90 3F 7F") != std::string::npos);
+    assert(dump.find("over_budget   reader_dispatch 812 us") != std::string::npos);
+    assert(dump.find("midi_queue.depth = 250") != std::string::npos);
+    assert(dump.find("watchdog.violations") != std::string::npos);
+    unlink(path);
+
+    // Nothing pending: the next check stays quiet
+    assert(!watchdog.CheckNow());
+
+    // Dumps stop at max_dumps
+    for (int i = 0; i < 10; i++) {
+        watchdog.ReportLatency(dispatch_draw, 20000);
+        if (watchdog.CheckNow()) {
+            watchdog.GetLastDumpPath(path, sizeof(path));
+            unlink(path);
+        }
+    }
+    assert(watchdog.Dumps() == 4);
+    assert(watchdog.Violations() == 12);
+
+    watchdog.Stop();
+    printf("✅ Over-budget stage dumped with the events that led up to it\n");
+}
+
+void test_heartbeat_stall()
+{
+    printf("Testing heartbeat stalls...\n");
+
+    FlightRecorder recorder(1024);
+    LatencyWatchdog watchdog(&recorder);
+    int reader = watchdog.AddHeartbeat("usb_reader", 20000);
+    int looper = watchdog.AddHeartbeat("midi_processing", 20000);
+
+    WatchdogConfig config = TestConfig();
+    config.check_interval_us = 5000;        // Let the thread find it
+    assert(watchdog.Start(config) == APC_SUCCESS);
+
+    // The looper keeps beating, the reader goes silent
+    bigtime_t until = system_time() + 80000;
+    while (system_time() < until) {
+        watchdog.Beat(looper);
+        snooze(2000);
+    }
+    watchdog.Stop();
+
+    assert(watchdog.Stalls() == 1);        // Reported once, not every check
+    assert(watchdog.Dumps() == 1);
+
+    char path[512];
+    watchdog.GetLastDumpPath(path, sizeof(path));
+    std::string dump = ReadFile(path);
+    assert(dump.find("Reason: usb_reader heartbeat silent for more than 20 ms") != std::string::npos);
+    assert(dump.find("STALLED") != std::string::npos);
+    assert(dump.find("stall         usb_reader silent") != std::string::npos);
+    unlink(path);
+
+    // A beat clears the stall; silence after that is a new one
+    watchdog.Beat(reader);
+    assert(!watchdog.CheckNow());
+
+    printf("✅ Silent thread reported once and dumped from the watchdog thread\n");
+}
+
+int main()
+{
+    printf("🛟 Latency Watchdog Test\n");
+    printf("========================\n\n");
+
+    mkdir(TEST_DUMP_DIRECTORY, 0755);
+
+    test_recorder_ring();
+    test_recorder_concurrent_writers();
+    test_budget_violation_dump();
+    test_heartbeat_stall();
+
+    rmdir(TEST_DUMP_DIRECTORY);
+    printf("\n🎉 ALL TESTS PASSED! Glitches leave a flight record.\n");
+    return 0;
+}
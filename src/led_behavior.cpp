@@ -0,0 +1,235 @@
+#include "led_behavior.h"
+#include "led_snapshot_bank.h"
+#include <math.h>
+
+// Emulated pulses step through off + the seven brightness channels
+#define PULSE_LEVELS 7
+
+struct NativeRate {
+    APCMiniMK2LEDBehavior behavior;
+    uint8_t kind;
+    double beats;                  // Cycle length in quarter notes
+};
+
+static const NativeRate NATIVE_RATES[] = {
+    { APC_MK2_LED_PULSE_1_16, LED_ANIMATION_PULSE, 0.25 },
+    { APC_MK2_LED_PULSE_1_8, LED_ANIMATION_PULSE, 0.5 },
+    { APC_MK2_LED_PULSE_1_4, LED_ANIMATION_PULSE, 1.0 },
+    { APC_MK2_LED_PULSE_1_2, LED_ANIMATION_PULSE, 2.0 },
+    { APC_MK2_LED_BLINK_1_24, LED_ANIMATION_BLINK, 1.0 / 6.0 },
+    { APC_MK2_LED_BLINK_1_16, LED_ANIMATION_BLINK, 0.25 },
+    { APC_MK2_LED_BLINK_1_8, LED_ANIMATION_BLINK, 0.5 },
+    { APC_MK2_LED_BLINK_1_4, LED_ANIMATION_BLINK, 1.0 },
+    { APC_MK2_LED_BLINK_1_2, LED_ANIMATION_BLINK, 2.0 }
+};
+
+static bigtime_t BeatsToMicroseconds(double beats, double bpm)
+{
+    return (bigtime_t)(beats * 60000000.0 / bpm + 0.5);
+}
+
+LEDPadAnimation LEDPadAnimation::Solid(uint8_t color, uint8_t brightness)
+{
+    LEDPadAnimation animation = { LED_ANIMATION_SOLID, (uint8_t)(color & 0x7F),
+                                  (uint8_t)(brightness <= APC_MK2_LED_BRIGHTNESS_100
+                                            ? brightness : (uint8_t)APC_MK2_LED_BRIGHTNESS_100), 0, 0 };
+    return animation;
+}
+
+LEDPadAnimation LEDPadAnimation::Blink(uint8_t color, bigtime_t period_us, bigtime_t phase_us)
+{
+    LEDPadAnimation animation = { LED_ANIMATION_BLINK, (uint8_t)(color & 0x7F),
+                                  APC_MK2_LED_BRIGHTNESS_100, period_us, phase_us };
+    return animation;
+}
+
+LEDPadAnimation LEDPadAnimation::Pulse(uint8_t color, bigtime_t period_us, bigtime_t phase_us)
+{
+    LEDPadAnimation animation = { LED_ANIMATION_PULSE, (uint8_t)(color & 0x7F),
+                                  APC_MK2_LED_BRIGHTNESS_100, period_us, phase_us };
+    return animation;
+}
+
+LEDPadAnimation LEDPadAnimation::FromLegacy(APCMiniLEDColor color, bigtime_t blink_period_us)
+{
+    switch (color) {
+        case APC_LED_GREEN_BLINK:
+        case APC_LED_RED_BLINK:
+        case APC_LED_YELLOW_BLINK:
+            return Blink(MK2PaletteColor(color), blink_period_us);
+        default:
+            return Solid(MK2PaletteColor(color));
+    }
+}
+
+uint8_t MK2PaletteColor(APCMiniLEDColor color)
+{
+    switch (color) {
+        case APC_LED_GREEN:
+        case APC_LED_GREEN_BLINK:
+            return APC_MK2_PALETTE_GREEN;
+        case APC_LED_RED:
+        case APC_LED_RED_BLINK:
+            return APC_MK2_PALETTE_RED;
+        case APC_LED_YELLOW:
+        case APC_LED_YELLOW_BLINK:
+            return APC_MK2_PALETTE_YELLOW;
+        default:
+            return APC_MK2_PALETTE_OFF;
+    }
+}
+
+bigtime_t MK2LEDBehaviorPeriod(APCMiniMK2LEDBehavior behavior, double bpm)
+{
+    for (const NativeRate& rate : NATIVE_RATES) {
+        if (rate.behavior == behavior) {
+            return BeatsToMicroseconds(rate.beats, bpm > 0 ? bpm : LEDAnimationCompositor::DEFAULT_BPM);
+        }
+    }
+    return 0;
+}
+
+bool MK2NativeBehaviorFor(LEDAnimationKind kind, bigtime_t period_us, double bpm,
+                          double tolerance, APCMiniMK2LEDBehavior& behavior)
+{
+    if (period_us <= 0 || bpm <= 0) {
+        return false;
+    }
+
+    double best_error = tolerance;
+    bool found = false;
+    for (const NativeRate& rate : NATIVE_RATES) {
+        if (rate.kind != kind) {
+            continue;
+        }
+        double native = (double)BeatsToMicroseconds(rate.beats, bpm);
+        double error = fabs((double)period_us - native) / native;
+        if (error <= best_error) {
+            best_error = error;
+            behavior = rate.behavior;
+            found = true;
+        }
+    }
+    return found;
+}
+
+LEDAnimationCompositor::LEDAnimationCompositor()
+    : tempo_bpm(DEFAULT_BPM)
+    , tolerance(DEFAULT_TOLERANCE)
+    , native_enabled(true)
+    , epoch(0)
+{
+    Clear();
+}
+
+void LEDAnimationCompositor::SetPad(uint8_t pad, const LEDPadAnimation& animation)
+{
+    if (pad >= APC_MINI_PAD_COUNT) {
+        return;
+    }
+    pads[pad] = animation;
+    if (animation.kind != LED_ANIMATION_SOLID && animation.period_us <= 0) {
+        pads[pad].kind = LED_ANIMATION_SOLID;      // No period: nothing to animate
+    }
+}
+
+void LEDAnimationCompositor::SetAll(const LEDPadAnimation& animation)
+{
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        SetPad(pad, animation);
+    }
+}
+
+void LEDAnimationCompositor::Clear()
+{
+    SetAll(LEDPadAnimation::Solid(0));
+}
+
+uint8_t LEDAnimationCompositor::PulseLevel(bigtime_t position, bigtime_t period)
+{
+    // Triangle: 0 at the start and end of the cycle, PULSE_LEVELS halfway
+    bigtime_t half = period / 2;
+    bigtime_t distance = position < half ? position : period - position;
+    return (uint8_t)((distance * PULSE_LEVELS + half / 2) / (half > 0 ? half : 1));
+}
+
+bool LEDAnimationCompositor::RenderNative(const LEDPadAnimation& animation,
+                                          APCMiniMK2LEDBehavior& behavior) const
+{
+    // Native rates are locked to the beat, so only in-phase animations fit
+    if (!native_enabled || animation.phase_us % animation.period_us != 0) {
+        return false;
+    }
+    return MK2NativeBehaviorFor((LEDAnimationKind)animation.kind, animation.period_us,
+                                tempo_bpm, tolerance, behavior);
+}
+
+LEDCompositorStats LEDAnimationCompositor::Compose(bigtime_t now, LEDSnapshot& snapshot) const
+{
+    LEDCompositorStats stats = { 0, 0, 0 };
+
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        const LEDPadAnimation& animation = pads[pad];
+        if (animation.kind == LED_ANIMATION_SOLID) {
+            snapshot.SetPad(pad, animation.color, animation.brightness);
+            stats.solid_pads++;
+            continue;
+        }
+
+        APCMiniMK2LEDBehavior behavior;
+        if (RenderNative(animation, behavior)) {
+            snapshot.SetPad(pad, animation.color, behavior);
+            stats.native_pads++;
+            continue;
+        }
+
+        bigtime_t elapsed = now - epoch + animation.phase_us;
+        bigtime_t position = ((elapsed % animation.period_us) + animation.period_us) % animation.period_us;
+        if (animation.kind == LED_ANIMATION_BLINK) {
+            bool lit = position < animation.period_us / 2;
+            snapshot.SetPad(pad, lit ? animation.color : 0, animation.brightness);
+        } else {
+            uint8_t level = PulseLevel(position, animation.period_us);
+            if (level == 0) {
+                snapshot.SetPad(pad, 0, APC_MK2_LED_BRIGHTNESS_10);
+            } else {
+                snapshot.SetPad(pad, animation.color, (uint8_t)(level - 1));
+            }
+        }
+        stats.emulated_pads++;
+    }
+    return stats;
+}
+
+bigtime_t LEDAnimationCompositor::NextChange(bigtime_t now) const
+{
+    bigtime_t next = B_INFINITE_TIMEOUT;
+
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        const LEDPadAnimation& animation = pads[pad];
+        APCMiniMK2LEDBehavior behavior;
+        if (animation.kind == LED_ANIMATION_SOLID || RenderNative(animation, behavior)) {
+            continue;
+        }
+
+        bigtime_t period = animation.period_us;
+        bigtime_t elapsed = now - epoch + animation.phase_us;
+        bigtime_t position = ((elapsed % period) + period) % period;
+        bigtime_t wait;
+        if (animation.kind == LED_ANIMATION_BLINK) {
+            bigtime_t half = period / 2;
+            wait = position < half ? half - position : period - position;
+        } else {
+            // Level steps are at most period / (2 * PULSE_LEVELS) apart
+            bigtime_t step = period / (2 * PULSE_LEVELS);
+            if (step <= 0) {
+                step = 1;
+            }
+            wait = step - position % step;
+        }
+        if (now + wait < next) {
+            next = now + wait;
+        }
+    }
+    return next;
+}
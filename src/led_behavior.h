@@ -0,0 +1,124 @@
+#ifndef LED_BEHAVIOR_H
+#define LED_BEHAVIOR_H
+
+/*
+ * Native LED Behaviors and the Animation Compositor
+ *
+ * The MK2 can pulse and blink a pad by itself: the Note On channel selects
+ * one of seven brightness levels, four pulse rates or five blink rates (see
+ * APCMiniMK2LEDBehavior). Emulating a blink on the host means re-sending
+ * the pad twice per cycle, forever; the native behavior costs one message.
+ *
+ * LEDAnimationCompositor holds what every pad should do (solid, blink or
+ * pulse at a period) and renders it into an LEDSnapshot for a given time:
+ *
+ * - Blinks and pulses whose period is within the tolerance of a native
+ *   rate at the device tempo, and that start on the beat (phase 0), become
+ *   that behavior's channel: the snapshot does not change over time, so a
+ *   diffed flush (LEDSnapshotBank) sends each pad once
+ * - Anything else is emulated: blinks toggle the velocity, pulses step
+ *   through the brightness channels, and only the steps are sent
+ * - With native behaviors disabled (MK1, or for comparison) everything is
+ *   emulated
+ *
+ * The native rates follow MIDI clock sent to the device; SetTempo() must
+ * match it (120 BPM when no clock is sent).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+struct LEDSnapshot;
+
+enum LEDAnimationKind {
+    LED_ANIMATION_SOLID = 0,
+    LED_ANIMATION_BLINK = 1,       // color / off, half a period each
+    LED_ANIMATION_PULSE = 2        // off -> color -> off over one period
+};
+
+struct LEDPadAnimation {
+    uint8_t kind;                  // LEDAnimationKind
+    uint8_t color;                 // MK2 palette index (velocity)
+    uint8_t brightness;            // Solid and emulated blink: APC_MK2_LED_BRIGHTNESS_*
+    bigtime_t period_us;           // One full blink/pulse cycle
+    bigtime_t phase_us;            // Offset into the cycle (0 = on the beat)
+
+    static LEDPadAnimation Solid(uint8_t color, uint8_t brightness = APC_MK2_LED_BRIGHTNESS_100);
+    static LEDPadAnimation Blink(uint8_t color, bigtime_t period_us, bigtime_t phase_us = 0);
+    static LEDPadAnimation Pulse(uint8_t color, bigtime_t period_us, bigtime_t phase_us = 0);
+
+    // A legacy 7-color value in MK2 palette colors; the *_BLINK colors
+    // become a blink of their base color
+    static LEDPadAnimation FromLegacy(APCMiniLEDColor color, bigtime_t blink_period_us);
+};
+
+// MK2 palette index for a legacy color (blink variants give their base color)
+uint8_t MK2PaletteColor(APCMiniLEDColor color);
+
+// Cycle length of a native pulse/blink at a tempo (0 for brightness channels)
+bigtime_t MK2LEDBehaviorPeriod(APCMiniMK2LEDBehavior behavior, double bpm);
+
+/**
+ * Native behavior closest to a blink or pulse period
+ *
+ * @param tolerance  Largest accepted relative period error (0.1 = 10%)
+ * @return true if one is within tolerance
+ */
+bool MK2NativeBehaviorFor(LEDAnimationKind kind, bigtime_t period_us, double bpm,
+                          double tolerance, APCMiniMK2LEDBehavior& behavior);
+
+struct LEDCompositorStats {
+    size_t native_pads;            // Animated pads rendered as a native behavior
+    size_t emulated_pads;          // Animated pads rendered by the host
+    size_t solid_pads;
+};
+
+class LEDAnimationCompositor {
+public:
+    static constexpr double DEFAULT_BPM = 120.0;
+    static constexpr double DEFAULT_TOLERANCE = 0.1;
+
+    LEDAnimationCompositor();
+
+    void SetTempo(double bpm) { tempo_bpm = bpm > 0 ? bpm : DEFAULT_BPM; }
+    double Tempo() const { return tempo_bpm; }
+    void SetNativeEnabled(bool enabled) { native_enabled = enabled; }
+    bool IsNativeEnabled() const { return native_enabled; }
+    void SetTolerance(double relative) { tolerance = relative < 0 ? 0 : relative; }
+
+    void SetPad(uint8_t pad, const LEDPadAnimation& animation);
+    void SetAll(const LEDPadAnimation& animation);
+    void Clear();
+    const LEDPadAnimation& GetPad(uint8_t pad) const { return pads[pad % APC_MINI_PAD_COUNT]; }
+
+    // Time the emulated animations are measured from (e.g. the last beat)
+    void SetEpoch(bigtime_t epoch_us) { epoch = epoch_us; }
+
+    /**
+     * Render every pad at now into snapshot (pads only; buttons untouched)
+     *
+     * @return Counts of native, emulated and solid pads
+     */
+    LEDCompositorStats Compose(bigtime_t now, LEDSnapshot& snapshot) const;
+
+    /**
+     * Earliest time after now at which an emulated pad changes
+     * (B_INFINITE_TIMEOUT when every pad is static), for scheduling flushes
+     */
+    bigtime_t NextChange(bigtime_t now) const;
+
+private:
+    static uint8_t PulseLevel(bigtime_t position, bigtime_t period);
+    bool RenderNative(const LEDPadAnimation& animation, APCMiniMK2LEDBehavior& behavior) const;
+
+    LEDPadAnimation pads[APC_MINI_PAD_COUNT];
+    double tempo_bpm;
+    double tolerance;
+    bool native_enabled;
+    bigtime_t epoch;
+};
+
+#endif // LED_BEHAVIOR_H
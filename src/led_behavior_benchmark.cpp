@@ -0,0 +1,151 @@
+// LED Behavior Benchmark
+// Messages per second a diffed flush sends for the built-in LED patterns,
+// rendered by the host versus with the MK2's native pulse/blink behaviors
+// wherever the compositor can use them.
+//
+// Usage: led_behavior_benchmark [--seconds <s>] [--fps <frames/s>] [--bpm <tempo>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "led_behavior.h"
+#include "led_snapshot_bank.h"
+
+struct PatternCase {
+    const char* name;
+    void (*build)(LEDAnimationCompositor& compositor, double bpm);
+};
+
+static bigtime_t Beats(double beats, double bpm)
+{
+    return (bigtime_t)(beats * 60000000.0 / bpm);
+}
+
+// led_patterns "Blinking Colors": legacy *_BLINK velocities on every pad
+static void BuildLegacyBlink(LEDAnimationCompositor& compositor, double bpm)
+{
+    compositor.SetAll(LEDPadAnimation::FromLegacy(APC_LED_GREEN_BLINK, Beats(1, bpm)));
+}
+
+// led_patterns "Finale" as it was emulated: the grid on/off, 300 ms each
+static void BuildFinale(LEDAnimationCompositor& compositor, double /*bpm*/)
+{
+    compositor.SetAll(LEDPadAnimation::Blink(21, 600000));
+}
+
+// Clip launcher look: queued clips blink on the beat, playing clips pulse
+static void BuildClipLauncher(LEDAnimationCompositor& compositor, double bpm)
+{
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        if (pad % 8 == 0) {
+            compositor.SetPad(pad, LEDPadAnimation::Blink(13, Beats(0.5, bpm)));
+        } else if (pad % 8 == 1) {
+            compositor.SetPad(pad, LEDPadAnimation::Pulse(21, Beats(2, bpm)));
+        } else {
+            compositor.SetPad(pad, LEDPadAnimation::Solid(45, APC_MK2_LED_BRIGHTNESS_25));
+        }
+    }
+}
+
+// Record arm: one row blinks fast, the rest stays lit
+static void BuildAlertRow(LEDAnimationCompositor& compositor, double bpm)
+{
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        compositor.SetPad(pad, pad < 8 ? LEDPadAnimation::Blink(5, Beats(0.25, bpm))
+                                       : LEDPadAnimation::Solid(3));
+    }
+}
+
+// Alternating checkerboard: the out-of-phase half stays on the host
+static void BuildCheckerBlink(LEDAnimationCompositor& compositor, double bpm)
+{
+    bigtime_t period = Beats(1, bpm);
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        bool odd = ((pad / 8) + (pad % 8)) % 2;
+        compositor.SetPad(pad, LEDPadAnimation::Blink(odd ? 5 : 21, period, odd ? period / 2 : 0));
+    }
+}
+
+static double MessagesPerSecond(const PatternCase& pattern, bool native, double seconds,
+                                int fps, double bpm, LEDCompositorStats& stats)
+{
+    LEDAnimationCompositor compositor;
+    compositor.SetTempo(bpm);
+    compositor.SetNativeEnabled(native);
+    pattern.build(compositor, bpm);
+
+    uint64_t messages = 0;
+    LEDSnapshotBank bank(1, [&messages](uint8_t, uint8_t, uint8_t) {
+        messages++;
+        return APC_SUCCESS;
+    });
+
+    // The first flush (every LED) is the same either way; count the steady state
+    LEDSnapshot look;
+    look.Clear();
+    stats = compositor.Compose(0, look);
+    bank.Store(0, look);
+    bank.Recall(0);
+    bank.Flush();
+    messages = 0;
+
+    bigtime_t frame = 1000000 / fps;
+    bigtime_t end = (bigtime_t)(seconds * 1000000);
+    for (bigtime_t now = frame; now <= end; now += frame) {
+        look.Clear();
+        compositor.Compose(now, look);
+        bank.Store(0, look);
+        bank.Flush();
+    }
+    return messages / seconds;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 10.0;
+    int fps = 100;
+    double bpm = LEDAnimationCompositor::DEFAULT_BPM;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bpm") == 0 && i + 1 < argc) {
+            bpm = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--seconds <s>] [--fps <frames/s>] [--bpm <tempo>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seconds <= 0 || fps <= 0 || fps > 1000 || bpm <= 0) {
+        printf("❌ --seconds and --bpm must be positive, --fps 1-1000\n");
+        return 1;
+    }
+
+    printf("💡 LED Behavior Benchmark (%.0f s at %d frames/s, %.0f BPM)\n", seconds, fps, bpm);
+    printf("   Steady-state messages/s after the first full flush\n\n");
+    printf("   %-18s %10s %10s %10s   %s\n", "Pattern", "Host", "Native", "Saved", "Native pads");
+
+    const PatternCase patterns[] = {
+        { "Blinking colors", BuildLegacyBlink },
+        { "Finale (600 ms)", BuildFinale },
+        { "Clip launcher", BuildClipLauncher },
+        { "Alert row", BuildAlertRow },
+        { "Checker blink", BuildCheckerBlink }
+    };
+    for (const PatternCase& pattern : patterns) {
+        LEDCompositorStats host_stats;
+        LEDCompositorStats native_stats;
+        double host = MessagesPerSecond(pattern, false, seconds, fps, bpm, host_stats);
+        double native = MessagesPerSecond(pattern, true, seconds, fps, bpm, native_stats);
+        printf("   %-18s %10.1f %10.1f %10.1f   %zu/%zu\n", pattern.name, host, native,
+               host - native, native_stats.native_pads,
+               native_stats.native_pads + native_stats.emulated_pads);
+    }
+
+    printf("\n   Native pads cost one message when set; out-of-phase or off-tempo\n");
+    printf("   animations stay on the host.\n");
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * LED Behavior Test
+ * Native MK2 pulse/blink rates, compositor choice between native and
+ * emulated animations, and the messages a diffed flush sends for each
+ */
+
+#include "led_behavior.h"
+#include "led_snapshot_bank.h"
+#include "midi_transport.h"
+#include <stdio.h>
+#include <assert.h>
+
+// Compose at now and flush the differences; returns messages sent
+static size_t ComposeAndFlush(const LEDAnimationCompositor& compositor, LEDSnapshotBank& bank,
+                              bigtime_t now)
+{
+    LEDSnapshot look;
+    look.Clear();
+    compositor.Compose(now, look);
+    bank.Store(0, look);
+    bank.Recall(0);
+    size_t sent = 0;
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    return sent;
+}
+
+void test_native_rates()
+{
+    printf("Testing native rate lookup...\n");
+
+    assert(MK2LEDBehaviorPeriod(APC_MK2_LED_BLINK_1_4, 120.0) == 500000);
+    assert(MK2LEDBehaviorPeriod(APC_MK2_LED_PULSE_1_2, 120.0) == 1000000);
+    assert(MK2LEDBehaviorPeriod(APC_MK2_LED_BLINK_1_24, 120.0) == 83333);
+    assert(MK2LEDBehaviorPeriod(APC_MK2_LED_BRIGHTNESS_100, 120.0) == 0);
+
+    APCMiniMK2LEDBehavior behavior;
+    assert(MK2NativeBehaviorFor(LED_ANIMATION_BLINK, 500000, 120.0, 0.1, behavior));
+    assert(behavior == APC_MK2_LED_BLINK_1_4);
+    assert(MK2NativeBehaviorFor(LED_ANIMATION_PULSE, 260000, 120.0, 0.1, behavior));
+    assert(behavior == APC_MK2_LED_PULSE_1_8);
+
+    // 600 ms is 20% off at 120 BPM but exactly a beat at 100 BPM
+    assert(!MK2NativeBehaviorFor(LED_ANIMATION_BLINK, 600000, 120.0, 0.1, behavior));
+    assert(MK2NativeBehaviorFor(LED_ANIMATION_BLINK, 600000, 100.0, 0.1, behavior));
+    assert(behavior == APC_MK2_LED_BLINK_1_4);
+
+    // No native 1/24 pulse
+    assert(!MK2NativeBehaviorFor(LED_ANIMATION_PULSE, 83333, 120.0, 0.05, behavior));
+
+    printf("✅ Periods and nearest native behaviors match the tempo\n");
+}
+
+void test_native_blink_grid()
+{
+    printf("Testing a natively blinking grid...\n");
+
+    SimulatedDeviceTransport device;
+    device.SetEchoEnabled(false);
+    assert(device.Open() == APC_SUCCESS);
+    LEDSnapshotBank bank(1, [&device](uint8_t status, uint8_t data1, uint8_t data2) {
+        return device.SendMIDI(status, data1, data2);
+    });
+
+    LEDAnimationCompositor compositor;
+    compositor.SetAll(LEDPadAnimation::Blink(5, 500000));
+
+    LEDSnapshot look;
+    look.Clear();
+    LEDCompositorStats stats = compositor.Compose(0, look);
+    assert(stats.native_pads == APC_MINI_PAD_COUNT && stats.emulated_pads == 0);
+    assert(look.velocity[0] == 5 && look.channel[0] == APC_MK2_LED_BLINK_1_4);
+    assert(compositor.NextChange(0) == B_INFINITE_TIMEOUT);
+
+    // One message per LED once, then nothing for the rest of the blink
+    size_t first = ComposeAndFlush(compositor, bank, 0);
+    assert(first == LED_SNAPSHOT_LED_COUNT);
+    size_t later = 0;
+    for (bigtime_t now = 10000; now < 2000000; now += 10000) {
+        later += ComposeAndFlush(compositor, bank, now);
+    }
+    assert(later == 0);
+
+    snooze(50000);
+    assert(device.GetLEDChannel(APC_MINI_PAD_NOTE_START) == APC_MK2_LED_BLINK_1_4);
+    assert(device.GetLEDVelocity(APC_MINI_PAD_NOTE_START + 63) == 5);
+    device.Close();
+
+    printf("✅ 64 pads blink for 2 s on %zu messages\n", first + later);
+}
+
+void test_emulated_fallbacks()
+{
+    printf("Testing emulated blink and pulse...\n");
+
+    LEDAnimationCompositor compositor;
+    LEDSnapshot look;
+    look.Clear();
+
+    // Native disabled: the host toggles the velocity every half period
+    compositor.SetNativeEnabled(false);
+    compositor.SetAll(LEDPadAnimation::Blink(5, 500000));
+    LEDCompositorStats stats = compositor.Compose(0, look);
+    assert(stats.emulated_pads == APC_MINI_PAD_COUNT);
+    assert(look.velocity[0] == 5 && look.channel[0] == APC_MK2_LED_BRIGHTNESS_100);
+    compositor.Compose(260000, look);
+    assert(look.velocity[0] == 0);
+    assert(compositor.NextChange(260000) == 500000);
+
+    LEDSnapshotBank bank(1, [](uint8_t, uint8_t, uint8_t) { return APC_SUCCESS; });
+    size_t messages = 0;
+    for (bigtime_t now = 0; now < 2000000; now += 10000) {
+        messages += ComposeAndFlush(compositor, bank, now);
+    }
+    // Every LED once, then 64 pads per toggle: 7 toggles in 2 s
+    assert(messages == LED_SNAPSHOT_LED_COUNT + 7 * APC_MINI_PAD_COUNT);
+
+    // Native on, but out of phase or off-rate: still emulated
+    compositor.SetNativeEnabled(true);
+    compositor.Clear();
+    compositor.SetPad(0, LEDPadAnimation::Blink(5, 500000, 250000));
+    compositor.SetPad(1, LEDPadAnimation::Blink(5, 700000));
+    compositor.SetPad(2, LEDPadAnimation::Blink(5, 500000, 500000));
+    stats = compositor.Compose(0, look);
+    assert(stats.emulated_pads == 2 && stats.native_pads == 1 && stats.solid_pads == 61);
+    assert(look.velocity[0] == 0 && look.velocity[1] == 5);
+
+    // Emulated pulse: off at the ends, full brightness halfway
+    compositor.SetTolerance(0);
+    compositor.SetPad(3, LEDPadAnimation::Pulse(9, 700000));
+    compositor.Compose(0, look);
+    assert(look.velocity[3] == 0);
+    compositor.Compose(350000, look);
+    assert(look.velocity[3] == 9 && look.channel[3] == APC_MK2_LED_BRIGHTNESS_100);
+    compositor.Compose(175000, look);
+    assert(look.velocity[3] == 9 && look.channel[3] < APC_MK2_LED_BRIGHTNESS_100);
+
+    // Legacy blink colors blink their base color, in MK2 palette colors
+    LEDPadAnimation legacy = LEDPadAnimation::FromLegacy(APC_LED_RED_BLINK, 500000);
+    assert(legacy.kind == LED_ANIMATION_BLINK && legacy.color == APC_MK2_PALETTE_RED);
+    LEDPadAnimation solid = LEDPadAnimation::FromLegacy(APC_LED_GREEN, 500000);
+    assert(solid.kind == LED_ANIMATION_SOLID && solid.color == APC_MK2_PALETTE_GREEN);
+    assert(MK2PaletteColor(APC_LED_YELLOW_BLINK) == APC_MK2_PALETTE_YELLOW);
+    assert(MK2PaletteColor(APC_LED_OFF) == APC_MK2_PALETTE_OFF);
+    assert(APC_MK2_PRESET_COLORS[APC_MK2_PALETTE_RED].red == 0x7F);
+    assert(APC_MK2_PRESET_COLORS[APC_MK2_PALETTE_RED].green == 0);
+    assert(APC_MK2_PRESET_COLORS[APC_MK2_PALETTE_GREEN].green == 0x7F);
+    assert(APC_MK2_PRESET_COLORS[APC_MK2_PALETTE_GREEN].red == 0);
+
+    printf("✅ Host emulation sent %zu messages for the same 2 s blink\n", messages);
+}
+
+int main()
+{
+    printf("💡 LED Behavior Test\n");
+    printf("====================\n\n");
+
+    test_native_rates();
+    test_native_blink_grid();
+    test_emulated_fallbacks();
+
+    printf("\n🎉 ALL TESTS PASSED! The MK2 blinks by itself.\n");
+    return 0;
+}
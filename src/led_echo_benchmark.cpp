@@ -0,0 +1,285 @@
+// LED Echo Benchmark
+// Pad-press-to-LED latency on the simulated full-speed MK2. Before: the
+// press travels reader -> input pipeline -> queue -> looper polling every
+// millisecond (MIDIEventHandler's default) -> window thread, which sends
+// the feedback LED. After: an echo rule in the input pipeline sends it from
+// the reader thread. Both write into the outbound scheduler's interactive
+// class; a press counts as lit when the transfer carrying its LED completes.
+// "Host" is the part spent in the app: reader callback to outbound enqueue.
+//
+// Usage: led_echo_benchmark [--presses <n>] [--fps <animation rate>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "led_echo_rules.h"
+#include "midi_pipeline.h"
+#include "midi_transport.h"
+#include "outbound_scheduler.h"
+
+static const uint8_t ECHO_VELOCITY = 3;
+static const bigtime_t LOOPER_POLL_US = 1000;
+
+struct EchoResult {
+    bigtime_t p50_us;
+    bigtime_t p99_us;
+    bigtime_t max_us;
+    bigtime_t host_p50_us;
+    bigtime_t host_p99_us;
+    int presses;
+    int lit;
+};
+
+static bigtime_t Percentile(const std::vector<bigtime_t>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+// The looper -> window leg of the old path: a BMessage posted to another thread
+class WindowThread {
+public:
+    explicit WindowThread(OutboundScheduler* scheduler)
+        : scheduler(scheduler), running(true), thread(&WindowThread::Run, this) {}
+
+    ~WindowThread() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            running = false;
+        }
+        changed.notify_one();
+        thread.join();
+    }
+
+    void Post(const MIDIMessage& message) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            posted.push_back(message);
+        }
+        changed.notify_one();
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [this]() { return !running || !posted.empty(); });
+            if (posted.empty()) {
+                return;
+            }
+            MIDIMessage message = posted.front();
+            posted.pop_front();
+            guard.unlock();
+
+            // What the window's pad handler sends for a hardware press
+            bool pressed = (message.status & 0xF0) == MIDI_NOTE_ON && message.data2 > 0;
+            scheduler->Send(OUTBOUND_QOS_INTERACTIVE,
+                            pressed ? MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_100 : MIDI_NOTE_OFF,
+                            message.data1, pressed ? ECHO_VELOCITY : 0);
+            guard.lock();
+        }
+    }
+
+    OutboundScheduler* scheduler;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<MIDIMessage> posted;
+    bool running;
+    std::thread thread;
+};
+
+static EchoResult Measure(bool echo, int presses, int fps)
+{
+    SimulatedDeviceTransport device;
+    device.SetEchoEnabled(false);
+
+    OutboundScheduler scheduler(
+        [&device](const uint8_t (*messages)[3], size_t count) {
+            return device.SendMIDIBatch(messages, count);
+        });
+
+    // Press time per pad; the completion hook turns it into a latency
+    std::atomic<bigtime_t> pressed_at[APC_MINI_PAD_COUNT];
+    std::atomic<bigtime_t> received_at[APC_MINI_PAD_COUNT];
+    for (size_t i = 0; i < APC_MINI_PAD_COUNT; i++) {
+        pressed_at[i].store(0);
+        received_at[i].store(0);
+    }
+    std::mutex latency_lock;
+    std::condition_variable lit;
+    std::vector<bigtime_t> latencies;
+    std::vector<bigtime_t> host_latencies;
+    scheduler.SetCompletionHook([&](OutboundQoS qos, const uint8_t* message,
+                                    bigtime_t enqueued_at, bigtime_t completed_at) {
+        if (qos != OUTBOUND_QOS_INTERACTIVE || (message[0] & 0xF0) != MIDI_NOTE_ON ||
+            message[2] != ECHO_VELOCITY || message[1] >= APC_MINI_PAD_COUNT) {
+            return;
+        }
+        bigtime_t start = pressed_at[message[1]].exchange(0);
+        if (start != 0) {
+            std::lock_guard<std::mutex> guard(latency_lock);
+            latencies.push_back(completed_at - start);
+            host_latencies.push_back(enqueued_at - received_at[message[1]].load());
+            lit.notify_one();
+        }
+    });
+    scheduler.Start();
+
+    LEDEchoRules rules([&scheduler](uint8_t status, uint8_t data1, uint8_t data2) {
+        return scheduler.Send(OUTBOUND_QOS_INTERACTIVE, status, data1, data2);
+    });
+    if (echo) {
+        rules.SetPadRule(LEDEchoRule::Light(ECHO_VELOCITY, APC_MK2_LED_BRIGHTNESS_100,
+                                            LED_ECHO_RELEASE_OFF));
+    }
+
+    PipelineControlState state;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<APCMiniMK2Device> pipeline =
+        MakeAPCInputPipeline<APCMiniMK2Device>(&state, inbox, &rules);
+    device.SetMIDICallback([&](uint8_t status, uint8_t data1, uint8_t data2) {
+        if ((data1 & 0x7F) < APC_MINI_PAD_COUNT) {
+            received_at[data1 & 0x7F].store(system_time());
+        }
+        pipeline.Push(status, data1, data2);
+    });
+    device.Open();
+
+    // The app side: looper polling the inbox, forwarding to the window
+    std::atomic<bool> running(true);
+    std::thread looper([&]() {
+        WindowThread window(&scheduler);
+        MIDIMessage message;
+        while (running.load()) {
+            while (inbox->Dequeue(message)) {
+                if (!echo) {
+                    window.Post(message);
+                }
+            }
+            snooze(LOOPER_POLL_US);
+        }
+    });
+
+    // Optional background animation on the same link
+    std::thread animation;
+    if (fps > 0) {
+        animation = std::thread([&scheduler, &running, fps]() {
+            uint8_t frame[APC_MINI_PAD_COUNT][3];
+            bigtime_t next = system_time();
+            for (uint32_t step = 0; running.load(); step++) {
+                for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+                    frame[pad][0] = MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_50;
+                    frame[pad][1] = pad;
+                    frame[pad][2] = (uint8_t)((pad + step) % 120 + 4);
+                }
+                scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT);
+                next += 1000000 / fps;
+                snooze_until(next, B_SYSTEM_TIMEBASE);
+            }
+        });
+    }
+
+    // One press at a time at a random offset from the poll tick, then release
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> pad(0, APC_MINI_PAD_COUNT - 1);
+    std::uniform_int_distribution<int> gap(2000, 5000);
+    for (int i = 0; i < presses; i++) {
+        uint8_t note = (uint8_t)pad(rng);
+        size_t before;
+        {
+            std::lock_guard<std::mutex> guard(latency_lock);
+            before = latencies.size();
+        }
+        pressed_at[note].store(system_time());
+        device.InjectMIDI(MIDI_NOTE_ON, note, 100);
+        {
+            std::unique_lock<std::mutex> guard(latency_lock);
+            lit.wait_for(guard, std::chrono::milliseconds(100),
+                         [&]() { return latencies.size() > before; });
+        }
+        pressed_at[note].store(0);
+        device.InjectMIDI(MIDI_NOTE_OFF, note, 0);
+        snooze(gap(rng));
+    }
+
+    running = false;
+    if (animation.joinable()) {
+        animation.join();
+    }
+    looper.join();
+    scheduler.Stop();
+    device.Close();
+    delete inbox;
+
+    EchoResult result;
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_us = Percentile(latencies, 0.50);
+    result.p99_us = Percentile(latencies, 0.99);
+    result.max_us = latencies.empty() ? 0 : latencies.back();
+    std::sort(host_latencies.begin(), host_latencies.end());
+    result.host_p50_us = Percentile(host_latencies, 0.50);
+    result.host_p99_us = Percentile(host_latencies, 0.99);
+    result.presses = presses;
+    result.lit = (int)latencies.size();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int presses = 200;
+    int fps = 250;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--presses") == 0 && i + 1 < argc) {
+            presses = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--presses <n>] [--fps <animation rate>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (presses <= 0 || fps < 0) {
+        printf("❌ --presses must be positive and --fps not negative\n");
+        return 1;
+    }
+
+    printf("💡 LED Echo Benchmark (%d presses per run)\n", presses);
+    printf("   Pad press to feedback LED on the simulated full-speed MK2\n\n");
+    printf("   %-10s %-20s %9s %9s %9s %12s %12s %9s\n", "Animation", "Path", "p50 us",
+           "p99 us", "max us", "host p50 us", "host p99 us", "Lit");
+
+    std::vector<int> rates = { 0 };
+    if (fps > 0) {
+        rates.push_back(fps);
+    }
+    for (int rate : rates) {
+        for (int mode = 0; mode < 2; mode++) {
+            bool echo = mode == 1;
+            EchoResult result = Measure(echo, presses, rate);
+            char anim[16];
+            snprintf(anim, sizeof(anim), rate ? "%d/s" : "idle", rate);
+            printf("   %-10s %-20s %9lld %9lld %9lld %12lld %12lld %4d/%-4d\n",
+                   mode == 0 ? anim : "", echo ? "reader-thread echo" : "looper -> window",
+                   (long long)result.p50_us, (long long)result.p99_us, (long long)result.max_us,
+                   (long long)result.host_p50_us, (long long)result.host_p99_us,
+                   result.lit, result.presses);
+        }
+    }
+
+    printf("\n   The echo rule skips the queue poll and both thread handoffs; what is\n");
+    printf("   left is the USB frames carrying the press in and the LED out.\n");
+    return 0;
+}
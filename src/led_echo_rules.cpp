@@ -0,0 +1,144 @@
+#include "led_echo_rules.h"
+#include "metrics_registry.h"
+
+LEDEchoRules::LEDEchoRules(SendFunction send_function, MetricsRegistry* metrics_registry)
+    : send(send_function)
+    , registry(metrics_registry)
+    , presses(0)
+    , releases(0)
+    , send_failures(0)
+{
+    for (size_t i = 0; i < NOTE_COUNT; i++) {
+        rules[i].store(0, std::memory_order_relaxed);
+        base[i].store(0, std::memory_order_relaxed);
+        held[i] = false;
+    }
+
+    if (registry) {
+        registry->RegisterCounter("led_echo.presses", &presses);
+        registry->RegisterCounter("led_echo.releases", &releases);
+        registry->RegisterCounter("led_echo.send_failures", &send_failures);
+    }
+}
+
+LEDEchoRules::~LEDEchoRules()
+{
+    if (registry) {
+        registry->Unregister(&presses);
+        registry->Unregister(&releases);
+        registry->Unregister(&send_failures);
+    }
+}
+
+void LEDEchoRules::SetRule(uint8_t note, const LEDEchoRule& rule)
+{
+    rules[note & 0x7F].store(Pack(rule), std::memory_order_relaxed);
+}
+
+void LEDEchoRules::SetPadRule(const LEDEchoRule& rule)
+{
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        SetRule(APC_MINI_PAD_NOTE_START + pad, rule);
+    }
+}
+
+void LEDEchoRules::ClearRule(uint8_t note)
+{
+    rules[note & 0x7F].store(0, std::memory_order_relaxed);
+}
+
+void LEDEchoRules::ClearAll()
+{
+    for (size_t i = 0; i < NOTE_COUNT; i++) {
+        rules[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool LEDEchoRules::GetRule(uint8_t note, LEDEchoRule& rule) const
+{
+    uint32_t packed = rules[note & 0x7F].load(std::memory_order_relaxed);
+    if (!(packed & RULE_ENABLED)) {
+        return false;
+    }
+    rule.velocity = (uint8_t)(packed & 0x7F);
+    rule.channel = (uint8_t)((packed >> 8) & 0x0F);
+    rule.release = (LEDEchoRelease)((packed >> 16) & 0x03);
+    return true;
+}
+
+bool LEDEchoRules::Echo(uint8_t status, uint8_t note, uint8_t velocity)
+{
+    if (!send || send(status, note, velocity) != APC_SUCCESS) {
+        send_failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool LEDEchoRules::Process(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    uint8_t type = status & 0xF0;
+    if (type != MIDI_NOTE_ON && type != MIDI_NOTE_OFF) {
+        return false;
+    }
+
+    uint8_t note = data1 & 0x7F;
+    bool pressed = type == MIDI_NOTE_ON && data2 > 0;
+    uint32_t packed = rules[note].load(std::memory_order_relaxed);
+
+    if (pressed) {
+        if (!(packed & RULE_ENABLED)) {
+            return false;
+        }
+        held[note] = true;
+        uint8_t channel = (uint8_t)((packed >> 8) & 0x0F);
+        if (!Echo((uint8_t)(MIDI_NOTE_ON | channel), note, (uint8_t)(packed & 0x7F))) {
+            return false;
+        }
+        presses.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // A release only answers a press this rule lit, even if the rule has
+    // been removed since
+    if (!held[note]) {
+        return false;
+    }
+    held[note] = false;
+
+    LEDEchoRelease release = (packed & RULE_ENABLED)
+        ? (LEDEchoRelease)((packed >> 16) & 0x03) : LED_ECHO_RELEASE_RESTORE;
+    bool sent = false;
+    switch (release) {
+        case LED_ECHO_RELEASE_KEEP:
+            return false;
+
+        case LED_ECHO_RELEASE_OFF:
+            sent = Echo(MIDI_NOTE_OFF, note, 0);
+            break;
+
+        case LED_ECHO_RELEASE_RESTORE:
+        default: {
+            uint16_t look = base[note].load(std::memory_order_relaxed);
+            uint8_t velocity = (uint8_t)(look & 0x7F);
+            uint8_t channel = (uint8_t)((look >> 8) & 0x0F);
+            sent = velocity ? Echo((uint8_t)(MIDI_NOTE_ON | channel), note, velocity)
+                            : Echo((uint8_t)(MIDI_NOTE_OFF | channel), note, 0);
+            break;
+        }
+    }
+
+    if (sent) {
+        releases.fetch_add(1, std::memory_order_relaxed);
+    }
+    return sent;
+}
+
+LEDEchoStats LEDEchoRules::GetStats() const
+{
+    LEDEchoStats stats;
+    stats.presses = presses.load(std::memory_order_relaxed);
+    stats.releases = releases.load(std::memory_order_relaxed);
+    stats.send_failures = send_failures.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,135 @@
+#ifndef LED_ECHO_RULES_H
+#define LED_ECHO_RULES_H
+
+/*
+ * Local LED Echo Rules
+ *
+ * Tactile feedback for a pad press used to travel reader -> queue ->
+ * looper -> BMessage -> window thread -> SendNoteOn -> USB, several thread
+ * hops before the LED changed. Echo rules are evaluated on the reader
+ * thread instead, as a stage of the input pipeline, and write straight
+ * into the outbound fast lane (the interactive QoS class):
+ *
+ * - A rule per note says what to light while it is held (MK2 palette
+ *   velocity and brightness/behavior channel) and what to do on release:
+ *   restore the LED the app last set, switch it off, or keep the color
+ * - The app reports every LED it sends with NoteLED(), so a release
+ *   restores the current look even if it changed while the pad was held
+ * - Rules and LED state are atomics: the GUI edits them while the reader
+ *   evaluates, without a lock; Process() itself runs on one thread
+ *
+ * The press is never consumed: the app still receives it and only skips
+ * its own LED write for notes with a rule (HasRule()).
+ *
+ * Metrics: "led_echo.presses", "led_echo.releases", "led_echo.send_failures".
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+
+#include "apc_mini_defs.h"
+#include "midi_message_queue.h"
+
+class MetricsRegistry;
+
+enum LEDEchoRelease {
+    LED_ECHO_RELEASE_RESTORE = 0,   // Back to what the app last set
+    LED_ECHO_RELEASE_OFF,           // LED off
+    LED_ECHO_RELEASE_KEEP           // The press color stays (latch)
+};
+
+struct LEDEchoRule {
+    uint8_t velocity;               // Palette index while held
+    uint8_t channel;                // Brightness/behavior channel (0-15)
+    LEDEchoRelease release;
+
+    static LEDEchoRule Light(uint8_t velocity, uint8_t channel = APC_MK2_LED_BRIGHTNESS_100,
+                             LEDEchoRelease release = LED_ECHO_RELEASE_RESTORE) {
+        LEDEchoRule rule;
+        rule.velocity = velocity & 0x7F;
+        rule.channel = channel & 0x0F;
+        rule.release = release;
+        return rule;
+    }
+};
+
+struct LEDEchoStats {
+    uint64_t presses;               // Echoes sent for a press
+    uint64_t releases;              // Echoes sent for a release
+    uint64_t send_failures;
+};
+
+class LEDEchoRules {
+public:
+    static const size_t NOTE_COUNT = 128;
+
+    // Called on the reader thread (e.g. OutboundScheduler::Send, interactive)
+    typedef std::function<APCMiniError(uint8_t status, uint8_t data1, uint8_t data2)> SendFunction;
+
+    explicit LEDEchoRules(SendFunction send, MetricsRegistry* registry = nullptr);
+    ~LEDEchoRules();
+
+    // Rules (any thread)
+    void SetRule(uint8_t note, const LEDEchoRule& rule);
+    void SetPadRule(const LEDEchoRule& rule);           // All 64 grid pads
+    void ClearRule(uint8_t note);
+    void ClearAll();
+    bool HasRule(uint8_t note) const {
+        return (rules[note & 0x7F].load(std::memory_order_relaxed) & RULE_ENABLED) != 0;
+    }
+    bool GetRule(uint8_t note, LEDEchoRule& rule) const;
+
+    // The app's own LED state, restored on release (any thread)
+    void NoteLED(uint8_t note, uint8_t velocity, uint8_t channel) {
+        base[note & 0x7F].store((uint16_t)((velocity & 0x7F) | ((channel & 0x0F) << 8)),
+                                std::memory_order_relaxed);
+    }
+
+    /**
+     * Evaluate one incoming message (reader thread only)
+     *
+     * Note On with velocity 0 counts as a release.
+     *
+     * @return true if an echo was sent
+     */
+    bool Process(uint8_t status, uint8_t data1, uint8_t data2);
+
+    LEDEchoStats GetStats() const;
+
+private:
+    static constexpr uint32_t RULE_ENABLED = 0x80000000u;
+
+    static uint32_t Pack(const LEDEchoRule& rule) {
+        return RULE_ENABLED | rule.velocity | ((uint32_t)rule.channel << 8) |
+               ((uint32_t)rule.release << 16);
+    }
+
+    bool Echo(uint8_t status, uint8_t note, uint8_t velocity);
+
+    SendFunction send;
+    MetricsRegistry* registry;
+
+    std::atomic<uint32_t> rules[NOTE_COUNT];
+    std::atomic<uint16_t> base[NOTE_COUNT];     // velocity | channel << 8
+    bool held[NOTE_COUNT];                      // Reader thread only
+
+    std::atomic<uint64_t> presses;
+    std::atomic<uint64_t> releases;
+    std::atomic<uint64_t> send_failures;
+};
+
+// Input pipeline stage: echoes presses and releases, never drops a message
+struct LEDEchoStage {
+    LEDEchoRules* rules;
+
+    bool Process(MIDIMessage& message) const {
+        if (rules) {
+            rules->Process(message.status, message.data1, message.data2);
+        }
+        return true;
+    }
+};
+
+#endif // LED_ECHO_RULES_H
@@ -0,0 +1,213 @@
+/*
+ * LED Echo Rules Test
+ * Press/release echoes for each release mode, restoring the app's current
+ * LED, releases after a rule is removed, the production input pipeline
+ * with the echo stage, and the metrics
+ */
+
+#include "led_echo_rules.h"
+#include "midi_pipeline.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <array>
+#include <vector>
+
+typedef std::array<uint8_t, 3> Message;
+
+// Records what the rules would put on the outbound fast lane
+struct RecordingLane {
+    std::vector<Message> sent;
+    APCMiniError result = APC_SUCCESS;
+
+    LEDEchoRules::SendFunction Send() {
+        return [this](uint8_t status, uint8_t data1, uint8_t data2) {
+            if (result == APC_SUCCESS) {
+                sent.push_back({ status, data1, data2 });
+            }
+            return result;
+        };
+    }
+
+    bool Last(uint8_t status, uint8_t data1, uint8_t data2) const {
+        if (sent.empty()) {
+            return false;
+        }
+        const Message& message = sent.back();
+        return message[0] == status && message[1] == data1 && message[2] == data2;
+    }
+};
+
+void test_release_modes()
+{
+    printf("Testing press echo and release modes...\n");
+
+    RecordingLane lane;
+    LEDEchoRules rules(lane.Send());
+    rules.SetRule(1, LEDEchoRule::Light(5));
+    rules.SetRule(2, LEDEchoRule::Light(9, APC_MK2_LED_BRIGHTNESS_50, LED_ECHO_RELEASE_OFF));
+    rules.SetRule(3, LEDEchoRule::Light(13, APC_MK2_LED_BRIGHTNESS_100, LED_ECHO_RELEASE_KEEP));
+    rules.NoteLED(1, 21, APC_MK2_LED_BRIGHTNESS_25);
+
+    // Restore: press color while held, the app's LED afterwards
+    assert(rules.Process(MIDI_NOTE_ON, 1, 100));
+    assert(lane.Last(MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_100, 1, 5));
+    assert(rules.Process(MIDI_NOTE_OFF, 1, 0));
+    assert(lane.Last(MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_25, 1, 21));
+
+    // Off, with the rule's channel on press
+    assert(rules.Process(MIDI_NOTE_ON, 2, 100));
+    assert(lane.Last(MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_50, 2, 9));
+    assert(rules.Process(MIDI_NOTE_OFF, 2, 0));
+    assert(lane.Last(MIDI_NOTE_OFF, 2, 0));
+
+    // Keep: nothing on release
+    assert(rules.Process(MIDI_NOTE_ON, 3, 100));
+    size_t sent = lane.sent.size();
+    assert(!rules.Process(MIDI_NOTE_OFF, 3, 0));
+    assert(lane.sent.size() == sent);
+
+    // Note On velocity 0 is a release too
+    assert(rules.Process(MIDI_NOTE_ON, 2, 100));
+    assert(rules.Process(MIDI_NOTE_ON, 2, 0));
+    assert(lane.Last(MIDI_NOTE_OFF, 2, 0));
+
+    // Notes without a rule, CCs and stray releases are left alone
+    sent = lane.sent.size();
+    assert(!rules.Process(MIDI_NOTE_ON, 40, 100));
+    assert(!rules.Process(MIDI_NOTE_OFF, 40, 0));
+    assert(!rules.Process(MIDI_CONTROL_CHANGE, 1, 64));
+    assert(!rules.Process(MIDI_NOTE_OFF, 1, 0));
+    assert(lane.sent.size() == sent);
+
+    LEDEchoRule rule;
+    assert(rules.GetRule(2, rule));
+    assert(rule.velocity == 9 && rule.channel == APC_MK2_LED_BRIGHTNESS_50);
+    assert(rule.release == LED_ECHO_RELEASE_OFF);
+    assert(!rules.GetRule(40, rule));
+
+    printf("✅ Restore, off and keep answer the press they lit\n");
+}
+
+void test_restore_tracks_app()
+{
+    printf("Testing restore after the app changes the LED...\n");
+
+    RecordingLane lane;
+    LEDEchoRules rules(lane.Send());
+    rules.SetPadRule(LEDEchoRule::Light(3));
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        assert(rules.HasRule(APC_MINI_PAD_NOTE_START + pad));
+    }
+    assert(!rules.HasRule(APC_MINI_PAD_COUNT));
+
+    // Unlit pad goes dark again
+    assert(rules.Process(MIDI_NOTE_ON, 7, 127));
+    assert(rules.Process(MIDI_NOTE_OFF, 7, 0));
+    assert(lane.Last(MIDI_NOTE_OFF, 7, 0));
+
+    // The app recolors the pad while it is held: release shows the new look
+    rules.NoteLED(7, 45, APC_MK2_LED_BRIGHTNESS_100);
+    assert(rules.Process(MIDI_NOTE_ON, 7, 127));
+    rules.NoteLED(7, 60, APC_MK2_LED_PULSE_1_4);
+    assert(rules.Process(MIDI_NOTE_OFF, 7, 0));
+    assert(lane.Last(MIDI_NOTE_ON | APC_MK2_LED_PULSE_1_4, 7, 60));
+
+    // Rule removed while held: the press it lit is still restored
+    assert(rules.Process(MIDI_NOTE_ON, 8, 127));
+    rules.ClearRule(8);
+    assert(!rules.HasRule(8));
+    assert(rules.Process(MIDI_NOTE_OFF, 8, 0));
+    assert(lane.Last(MIDI_NOTE_OFF, 8, 0));
+    assert(!rules.Process(MIDI_NOTE_ON, 8, 127));
+
+    rules.ClearAll();
+    assert(!rules.HasRule(7));
+
+    printf("✅ Releases restore the app's current LED\n");
+}
+
+void test_input_pipeline()
+{
+    printf("Testing the echo stage in the production input chain...\n");
+
+    RecordingLane lane;
+    LEDEchoRules rules(lane.Send());
+    rules.SetPadRule(LEDEchoRule::Light(3));
+
+    PipelineControlState state;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<APCMiniMK2Device> pipeline =
+        MakeAPCInputPipeline<APCMiniMK2Device>(&state, inbox, &rules);
+
+    // Press and a Note On 0 release: echoed, and still delivered to the app
+    assert(pipeline.Push(0x90, 12, 100));
+    assert(lane.Last(MIDI_NOTE_ON | APC_MK2_LED_BRIGHTNESS_100, 12, 3));
+    assert(pipeline.Push(0x90, 12, 0));
+    assert(lane.Last(MIDI_NOTE_OFF, 12, 0));
+
+    // Filtered before the echo stage: unknown note, wrong status
+    size_t sent = lane.sent.size();
+    assert(!pipeline.Push(0x90, 0x40, 127));
+    assert(!pipeline.Push(0xE0, 12, 64));
+    assert(lane.sent.size() == sent);
+
+    // A failed echo never drops the message
+    lane.result = APC_ERROR_TIMEOUT;
+    assert(pipeline.Push(0x90, 13, 100));
+    assert(rules.GetStats().send_failures == 1);
+
+    MIDIMessage message;
+    assert(inbox->Dequeue(message));
+    assert(message.status == 0x90 && message.data1 == 12);
+    assert(inbox->Dequeue(message));
+    assert(message.status == 0x80 && message.data1 == 12);
+    assert(inbox->Dequeue(message));
+    assert(message.data1 == 13);
+    assert(!inbox->Dequeue(message));
+
+    delete inbox;
+    printf("✅ Echoes on the reader thread without consuming the press\n");
+}
+
+void test_metrics()
+{
+    printf("Testing metrics...\n");
+
+    MetricsRegistry registry;
+    RecordingLane lane;
+    {
+        LEDEchoRules rules(lane.Send(), &registry);
+        rules.SetRule(1, LEDEchoRule::Light(5));
+        rules.Process(MIDI_NOTE_ON, 1, 100);
+        rules.Process(MIDI_NOTE_OFF, 1, 0);
+        rules.Process(MIDI_NOTE_ON, 1, 100);
+
+        MetricSample sample;
+        assert(registry.Find("led_echo.presses", sample) && sample.value == 2);
+        assert(registry.Find("led_echo.releases", sample) && sample.value == 1);
+        assert(registry.Find("led_echo.send_failures", sample) && sample.value == 0);
+
+        LEDEchoStats stats = rules.GetStats();
+        assert(stats.presses == 2 && stats.releases == 1);
+    }
+
+    MetricSample sample;
+    assert(!registry.Find("led_echo.presses", sample));
+
+    printf("✅ Counters registered and removed with the rules\n");
+}
+
+int main()
+{
+    printf("💡 LED Echo Rules Test\n");
+    printf("======================\n\n");
+
+    test_release_modes();
+    test_restore_tracks_app();
+    test_input_pipeline();
+    test_metrics();
+
+    printf("\n🎉 ALL TESTS PASSED! Pad feedback is lit from the reader thread.\n");
+    return 0;
+}
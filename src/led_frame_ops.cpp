@@ -0,0 +1,337 @@
+#include "led_frame_ops.h"
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LED_FRAME_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LED_FRAME_NEON 1
+#endif
+
+// Distance that can never win (above 3 * 255) for unused palette slots
+static const int16_t UNUSED_PALETTE_VALUE = 1000;
+
+const char* LEDFrameSIMDName()
+{
+#if defined(LED_FRAME_SSE2)
+    return "SSE2";
+#elif defined(LED_FRAME_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+static inline bool UseSIMD(LEDFrameImpl impl)
+{
+#if defined(LED_FRAME_SSE2) || defined(LED_FRAME_NEON)
+    return impl != LED_FRAME_IMPL_SCALAR;
+#else
+    (void)impl;
+    return false;
+#endif
+}
+
+LEDPalette LEDPalette::FromMK2Colors(const APCMiniMK2RGB* colors, size_t count)
+{
+    LEDPalette palette;
+    palette.count = count < LED_PALETTE_MAX_COLORS ? count : LED_PALETTE_MAX_COLORS;
+
+    for (size_t i = 0; i < LED_PALETTE_MAX_COLORS; i++) {
+        if (i < palette.count) {
+            // 7-bit to 8-bit, 0x7F -> 0xFF
+            palette.red[i] = (int16_t)((colors[i].red << 1) | (colors[i].red >> 6));
+            palette.green[i] = (int16_t)((colors[i].green << 1) | (colors[i].green >> 6));
+            palette.blue[i] = (int16_t)((colors[i].blue << 1) | (colors[i].blue >> 6));
+        } else {
+            palette.red[i] = UNUSED_PALETTE_VALUE;
+            palette.green[i] = UNUSED_PALETTE_VALUE;
+            palette.blue[i] = UNUSED_PALETTE_VALUE;
+        }
+    }
+    return palette;
+}
+
+// ===============================
+// Blend
+// ===============================
+
+void LEDFrameBlend(LEDFrame& out, const LEDFrame& from, const LEDFrame& to, uint8_t alpha,
+                   LEDFrameImpl impl)
+{
+    // alpha 0-255 -> weight 0-256 so that 255 lands exactly on "to"
+    const uint16_t weight = alpha + (alpha >> 7);
+    const uint16_t inverse = 256 - weight;
+
+    if (UseSIMD(impl)) {
+#if defined(LED_FRAME_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w = _mm_set1_epi16((short)weight);
+        const __m128i iw = _mm_set1_epi16((short)inverse);
+        const __m128i round = _mm_set1_epi16(128);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            __m128i a = _mm_load_si128((const __m128i*)(from.rgbx + i));
+            __m128i b = _mm_load_si128((const __m128i*)(to.rgbx + i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), iw),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), iw),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+            _mm_store_si128((__m128i*)(out.rgbx + i), _mm_packus_epi16(lo, hi));
+        }
+        return;
+#elif defined(LED_FRAME_NEON)
+        const uint16x8_t w = vdupq_n_u16(weight);
+        const uint16x8_t iw = vdupq_n_u16(inverse);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            uint8x16_t a = vld1q_u8(from.rgbx + i);
+            uint8x16_t b = vld1q_u8(to.rgbx + i);
+            uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(a)), iw), vmovl_u8(vget_low_u8(b)), w);
+            uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(a)), iw), vmovl_u8(vget_high_u8(b)), w);
+            vst1q_u8(out.rgbx + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+        return;
+#endif
+    }
+
+    for (int i = 0; i < LED_FRAME_BYTES; i++) {
+        out.rgbx[i] = (uint8_t)((from.rgbx[i] * inverse + to.rgbx[i] * weight + 128) >> 8);
+    }
+}
+
+// ===============================
+// Fade toward target
+// ===============================
+
+static inline uint8_t SaturatingAdd(uint8_t a, uint8_t b) { return a > 255 - b ? 255 : a + b; }
+static inline uint8_t SaturatingSub(uint8_t a, uint8_t b) { return a < b ? 0 : a - b; }
+static inline uint8_t Min8(uint8_t a, uint8_t b) { return a < b ? a : b; }
+static inline uint8_t Max8(uint8_t a, uint8_t b) { return a > b ? a : b; }
+
+void LEDFrameFadeToward(LEDFrame& frame, const LEDFrame& target, uint8_t step, LEDFrameImpl impl)
+{
+    // down = max(f - step, min(f, t))   (no-op when f < t)
+    // out  = min(down + step, max(down, t))   (no-op when down >= t)
+    if (UseSIMD(impl)) {
+#if defined(LED_FRAME_SSE2)
+        const __m128i s = _mm_set1_epi8((char)step);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            __m128i f = _mm_load_si128((const __m128i*)(frame.rgbx + i));
+            __m128i t = _mm_load_si128((const __m128i*)(target.rgbx + i));
+            __m128i down = _mm_max_epu8(_mm_subs_epu8(f, s), _mm_min_epu8(f, t));
+            __m128i result = _mm_min_epu8(_mm_adds_epu8(down, s), _mm_max_epu8(down, t));
+            _mm_store_si128((__m128i*)(frame.rgbx + i), result);
+        }
+        return;
+#elif defined(LED_FRAME_NEON)
+        const uint8x16_t s = vdupq_n_u8(step);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            uint8x16_t f = vld1q_u8(frame.rgbx + i);
+            uint8x16_t t = vld1q_u8(target.rgbx + i);
+            uint8x16_t down = vmaxq_u8(vqsubq_u8(f, s), vminq_u8(f, t));
+            vst1q_u8(frame.rgbx + i, vminq_u8(vqaddq_u8(down, s), vmaxq_u8(down, t)));
+        }
+        return;
+#endif
+    }
+
+    for (int i = 0; i < LED_FRAME_BYTES; i++) {
+        uint8_t f = frame.rgbx[i];
+        uint8_t t = target.rgbx[i];
+        uint8_t down = Max8(SaturatingSub(f, step), Min8(f, t));
+        frame.rgbx[i] = Min8(SaturatingAdd(down, step), Max8(down, t));
+    }
+}
+
+// ===============================
+// Brightness scale
+// ===============================
+
+void LEDFrameScale(LEDFrame& frame, uint16_t scale, LEDFrameImpl impl)
+{
+    if (scale > 256) {
+        scale = 256;
+    }
+
+    if (UseSIMD(impl)) {
+#if defined(LED_FRAME_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i k = _mm_set1_epi16((short)scale);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            __m128i v = _mm_load_si128((const __m128i*)(frame.rgbx + i));
+            __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), k), 8);
+            __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), k), 8);
+            _mm_store_si128((__m128i*)(frame.rgbx + i), _mm_packus_epi16(lo, hi));
+        }
+        return;
+#elif defined(LED_FRAME_NEON)
+        const uint16x8_t k = vdupq_n_u16(scale);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            uint8x16_t v = vld1q_u8(frame.rgbx + i);
+            uint16x8_t lo = vmulq_u16(vmovl_u8(vget_low_u8(v)), k);
+            uint16x8_t hi = vmulq_u16(vmovl_u8(vget_high_u8(v)), k);
+            vst1q_u8(frame.rgbx + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+        return;
+#endif
+    }
+
+    for (int i = 0; i < LED_FRAME_BYTES; i++) {
+        frame.rgbx[i] = (uint8_t)((frame.rgbx[i] * scale) >> 8);
+    }
+}
+
+// ===============================
+// 8-bit -> 7-bit
+// ===============================
+
+void LEDFrameTo7Bit(LEDFrame& out, const LEDFrame& frame, LEDFrameImpl impl)
+{
+    if (UseSIMD(impl)) {
+#if defined(LED_FRAME_SSE2)
+        const __m128i mask = _mm_set1_epi8(0x7F);
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            __m128i v = _mm_load_si128((const __m128i*)(frame.rgbx + i));
+            // 16-bit shift, then drop the bit carried in from the high byte
+            _mm_store_si128((__m128i*)(out.rgbx + i), _mm_and_si128(_mm_srli_epi16(v, 1), mask));
+        }
+        return;
+#elif defined(LED_FRAME_NEON)
+        for (int i = 0; i < LED_FRAME_BYTES; i += 16) {
+            vst1q_u8(out.rgbx + i, vshrq_n_u8(vld1q_u8(frame.rgbx + i), 1));
+        }
+        return;
+#endif
+    }
+
+    for (int i = 0; i < LED_FRAME_BYTES; i++) {
+        out.rgbx[i] = frame.rgbx[i] >> 1;
+    }
+}
+
+// ===============================
+// Palette quantization
+// ===============================
+
+static uint8_t NearestScalar(const LEDPalette& palette, int16_t r, int16_t g, int16_t b)
+{
+    int best_distance = 0x7FFF;
+    uint8_t best_index = 0;
+    for (size_t i = 0; i < palette.count; i++) {
+        int distance = abs(palette.red[i] - r) + abs(palette.green[i] - g) + abs(palette.blue[i] - b);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best_index = (uint8_t)i;
+        }
+    }
+    return best_index;
+}
+
+// Pick the lane with the smallest distance, lowest palette index on ties
+static uint8_t ReduceLanes(const int16_t distances[8], const int16_t indices[8])
+{
+    int16_t best_distance = distances[0];
+    int16_t best_index = indices[0];
+    for (int lane = 1; lane < 8; lane++) {
+        if (distances[lane] < best_distance ||
+            (distances[lane] == best_distance && indices[lane] < best_index)) {
+            best_distance = distances[lane];
+            best_index = indices[lane];
+        }
+    }
+    return (uint8_t)best_index;
+}
+
+void LEDFrameQuantize(uint8_t indices[LED_FRAME_PADS], const LEDFrame& frame, const LEDPalette& palette,
+                      LEDFrameImpl impl)
+{
+    if (palette.count == 0) {
+        for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+            indices[pad] = 0;
+        }
+        return;
+    }
+
+    // Unused slots past count hold UNUSED_PALETTE_VALUE, so whole vectors
+    // of 8 entries can be searched
+    const size_t vector_count = (palette.count + 7) & ~(size_t)7;
+
+    if (UseSIMD(impl)) {
+#if defined(LED_FRAME_SSE2)
+        const __m128i lane_offsets = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+        alignas(16) int16_t lane_distance[8];
+        alignas(16) int16_t lane_index[8];
+
+        for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+            const __m128i r = _mm_set1_epi16(frame.Red(pad));
+            const __m128i g = _mm_set1_epi16(frame.Green(pad));
+            const __m128i b = _mm_set1_epi16(frame.Blue(pad));
+            __m128i best_distance = _mm_set1_epi16(0x7FFF);
+            __m128i best_index = _mm_setzero_si128();
+
+            for (size_t base = 0; base < vector_count; base += 8) {
+                __m128i dr = _mm_sub_epi16(_mm_load_si128((const __m128i*)(palette.red + base)), r);
+                __m128i dg = _mm_sub_epi16(_mm_load_si128((const __m128i*)(palette.green + base)), g);
+                __m128i db = _mm_sub_epi16(_mm_load_si128((const __m128i*)(palette.blue + base)), b);
+                dr = _mm_max_epi16(dr, _mm_sub_epi16(_mm_setzero_si128(), dr));
+                dg = _mm_max_epi16(dg, _mm_sub_epi16(_mm_setzero_si128(), dg));
+                db = _mm_max_epi16(db, _mm_sub_epi16(_mm_setzero_si128(), db));
+                __m128i distance = _mm_add_epi16(_mm_add_epi16(dr, dg), db);
+
+                __m128i closer = _mm_cmplt_epi16(distance, best_distance);
+                __m128i index = _mm_add_epi16(lane_offsets, _mm_set1_epi16((short)base));
+                best_distance = _mm_min_epi16(distance, best_distance);
+                best_index = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, best_index));
+            }
+
+            _mm_store_si128((__m128i*)lane_distance, best_distance);
+            _mm_store_si128((__m128i*)lane_index, best_index);
+            indices[pad] = ReduceLanes(lane_distance, lane_index);
+        }
+        return;
+#elif defined(LED_FRAME_NEON)
+        const int16_t offsets[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+        const int16x8_t lane_offsets = vld1q_s16(offsets);
+        int16_t lane_distance[8];
+        int16_t lane_index[8];
+
+        for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+            const int16x8_t r = vdupq_n_s16(frame.Red(pad));
+            const int16x8_t g = vdupq_n_s16(frame.Green(pad));
+            const int16x8_t b = vdupq_n_s16(frame.Blue(pad));
+            int16x8_t best_distance = vdupq_n_s16(0x7FFF);
+            int16x8_t best_index = vdupq_n_s16(0);
+
+            for (size_t base = 0; base < vector_count; base += 8) {
+                int16x8_t distance = vaddq_s16(vaddq_s16(vabdq_s16(vld1q_s16(palette.red + base), r),
+                                                         vabdq_s16(vld1q_s16(palette.green + base), g)),
+                                               vabdq_s16(vld1q_s16(palette.blue + base), b));
+                uint16x8_t closer = vcltq_s16(distance, best_distance);
+                int16x8_t index = vaddq_s16(lane_offsets, vdupq_n_s16((int16_t)base));
+                best_distance = vminq_s16(distance, best_distance);
+                best_index = vbslq_s16(closer, index, best_index);
+            }
+
+            vst1q_s16(lane_distance, best_distance);
+            vst1q_s16(lane_index, best_index);
+            indices[pad] = ReduceLanes(lane_distance, lane_index);
+        }
+        return;
+#endif
+    }
+
+    for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+        indices[pad] = NearestScalar(palette, frame.Red(pad), frame.Green(pad), frame.Blue(pad));
+    }
+}
+
+void LEDFrameToMK2RGB(APCMiniMK2RGB out[LED_FRAME_PADS], const LEDFrame& frame_7bit)
+{
+    for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+        out[pad].red = frame_7bit.Red(pad);
+        out[pad].green = frame_7bit.Green(pad);
+        out[pad].blue = frame_7bit.Blue(pad);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef LED_FRAME_OPS_H
+#define LED_FRAME_OPS_H
+
+/*
+ * Full-Grid LED Frame Operations
+ *
+ * Crossfades, fades and brightness changes over all 64 pads at once, so a
+ * 60 Hz transition costs a few hundred nanoseconds of math per step instead
+ * of 64 scalar per-pad loops (and, together with a diffed flush, only the
+ * pads that actually changed are sent).
+ *
+ * Frames are 64 pads x RGBX, 8 bits per channel (X is padding and kept at
+ * 0), 16-byte aligned: 256 bytes, i.e. 16 SSE2/NEON registers. Every op has
+ * an SSE2 path (x86_64 baseline), a NEON path (ARM) and a scalar fallback.
+ * All paths use the same integer formulas and produce identical results;
+ * LED_FRAME_IMPL_SCALAR forces the fallback for testing and benchmarks.
+ *
+ * Output for the hardware is either 7-bit RGB (LEDFrameTo7Bit, the range of
+ * APCMiniMK2RGB and the MK2 RGB SysEx) or palette velocities
+ * (LEDFrameQuantize against the 128 MK2 preset colors).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apc_mini_defs.h"
+
+#define LED_FRAME_PADS          64
+#define LED_FRAME_BYTES         (LED_FRAME_PADS * 4)
+#define LED_PALETTE_MAX_COLORS  128
+
+struct LEDFrame {
+    alignas(16) uint8_t rgbx[LED_FRAME_BYTES];
+
+    void SetPad(int pad, uint8_t red, uint8_t green, uint8_t blue) {
+        rgbx[pad * 4 + 0] = red;
+        rgbx[pad * 4 + 1] = green;
+        rgbx[pad * 4 + 2] = blue;
+        rgbx[pad * 4 + 3] = 0;
+    }
+    uint8_t Red(int pad) const { return rgbx[pad * 4 + 0]; }
+    uint8_t Green(int pad) const { return rgbx[pad * 4 + 1]; }
+    uint8_t Blue(int pad) const { return rgbx[pad * 4 + 2]; }
+};
+
+// Palette in frame space (8-bit), stored planar for vector distance search
+struct LEDPalette {
+    alignas(16) int16_t red[LED_PALETTE_MAX_COLORS];
+    alignas(16) int16_t green[LED_PALETTE_MAX_COLORS];
+    alignas(16) int16_t blue[LED_PALETTE_MAX_COLORS];
+    size_t count;
+
+    // Build from 7-bit MK2 colors (e.g. APC_MK2_PRESET_COLORS)
+    static LEDPalette FromMK2Colors(const APCMiniMK2RGB* colors, size_t count);
+};
+
+enum LEDFrameImpl {
+    LED_FRAME_IMPL_BEST = 0,      // SIMD when compiled in, else scalar
+    LED_FRAME_IMPL_SCALAR = 1
+};
+
+// Name of the path LED_FRAME_IMPL_BEST uses ("SSE2", "NEON" or "scalar")
+const char* LEDFrameSIMDName();
+
+// out = from + (to - from) * alpha / 255 (alpha 0 = from, 255 = to)
+void LEDFrameBlend(LEDFrame& out, const LEDFrame& from, const LEDFrame& to, uint8_t alpha,
+                   LEDFrameImpl impl = LED_FRAME_IMPL_BEST);
+
+// Move every channel toward target by at most step (reaches it exactly)
+void LEDFrameFadeToward(LEDFrame& frame, const LEDFrame& target, uint8_t step,
+                        LEDFrameImpl impl = LED_FRAME_IMPL_BEST);
+
+// channel = channel * scale / 256 (scale 256 = unchanged, 0 = off)
+void LEDFrameScale(LEDFrame& frame, uint16_t scale, LEDFrameImpl impl = LED_FRAME_IMPL_BEST);
+
+// 8-bit channels to the MK2's 7-bit range (same RGBX layout)
+void LEDFrameTo7Bit(LEDFrame& out, const LEDFrame& frame, LEDFrameImpl impl = LED_FRAME_IMPL_BEST);
+
+// Nearest palette index per pad (L1 distance, lowest index on ties)
+void LEDFrameQuantize(uint8_t indices[LED_FRAME_PADS], const LEDFrame& frame, const LEDPalette& palette,
+                      LEDFrameImpl impl = LED_FRAME_IMPL_BEST);
+
+// Copy out as APCMiniMK2RGB (for APCMiniState::pad_rgb_colors)
+void LEDFrameToMK2RGB(APCMiniMK2RGB out[LED_FRAME_PADS], const LEDFrame& frame_7bit);
+
+#endif // LED_FRAME_OPS_H
@@ -0,0 +1,347 @@
+#include "led_snapshot_bank.h"
+#include "led_frame_ops.h"
+#include "metrics_registry.h"
+#include <string.h>
+
+#define LED_TRACK_FIRST  APC_MINI_PAD_COUNT
+#define LED_SCENE_FIRST  (APC_MINI_PAD_COUNT + LED_SNAPSHOT_TRACK_LEDS)
+
+// ===============================
+// LEDSnapshot
+// ===============================
+
+void LEDSnapshot::Clear()
+{
+    memset(velocity, 0, sizeof(velocity));
+    memset(channel, 0, sizeof(channel));
+}
+
+void LEDSnapshot::SetPad(uint8_t pad, uint8_t color, uint8_t led_channel)
+{
+    if (pad >= APC_MINI_PAD_COUNT) {
+        return;
+    }
+    velocity[pad] = color & 0x7F;
+    channel[pad] = led_channel & 0x0F;
+}
+
+void LEDSnapshot::SetTrackButton(uint8_t index, LEDButtonState state)
+{
+    if (index >= LED_SNAPSHOT_TRACK_LEDS) {
+        return;
+    }
+    velocity[LED_TRACK_FIRST + index] = static_cast<uint8_t>(state);
+    channel[LED_TRACK_FIRST + index] = APC_MINI_MIDI_CHANNEL;
+}
+
+void LEDSnapshot::SetSceneButton(uint8_t index, LEDButtonState state)
+{
+    if (index >= LED_SNAPSHOT_SCENE_LEDS) {
+        return;
+    }
+    velocity[LED_SCENE_FIRST + index] = static_cast<uint8_t>(state);
+    channel[LED_SCENE_FIRST + index] = APC_MINI_MIDI_CHANNEL;
+}
+
+void LEDSnapshot::SetPadsFromFrame(const LEDFrame& frame, const LEDPalette& palette, uint8_t led_channel)
+{
+    uint8_t indices[LED_FRAME_PADS];
+    LEDFrameQuantize(indices, frame, palette);
+
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        SetPad(pad, indices[pad], led_channel);
+    }
+}
+
+uint8_t LEDSnapshot::NoteForLED(size_t led)
+{
+    if (led < LED_TRACK_FIRST) {
+        return APCMiniMK2Device::PadNote(static_cast<uint8_t>(led));
+    }
+    if (led < LED_SCENE_FIRST) {
+        return APCMiniMK2Device::TrackButtonNote(static_cast<uint8_t>(led - LED_TRACK_FIRST));
+    }
+    return APCMiniMK2Device::SceneButtonNote(static_cast<uint8_t>(led - LED_SCENE_FIRST));
+}
+
+// ===============================
+// LEDSnapshotBank
+// ===============================
+
+LEDSnapshotBank::LEDSnapshotBank(size_t slot_count, MIDISender midi_sender, MetricsRegistry* metrics_registry)
+    : sender(midi_sender)
+    , registry(metrics_registry)
+    , slots(slot_count)
+    , generations(slot_count, 0)
+    , active(nullptr)
+    , hardware_known(false)
+    , hardware_slot(-1)
+    , hardware_generation(0)
+    , delta_clock(0)
+    , recalls(0)
+    , flushes(0)
+    , messages_sent(0)
+    , messages_skipped(0)
+    , cache_hits(0)
+    , cache_misses(0)
+    , send_failures(0)
+{
+    for (LEDSnapshot& snapshot : slots) {
+        snapshot.Clear();
+    }
+    hardware.Clear();
+
+    for (size_t i = 0; i < LED_DELTA_CACHE_SIZE; i++) {
+        delta_cache[i].from_slot = -1;
+        delta_cache[i].to_slot = -1;
+        delta_cache[i].count = 0;
+        delta_cache[i].last_used = 0;
+    }
+
+    if (registry) {
+        registry->RegisterCounter("led.snapshot_recalls", &recalls);
+        registry->RegisterCounter("led.snapshot_messages", &messages_sent);
+        registry->RegisterCounter("led.snapshot_skipped", &messages_skipped);
+        registry->RegisterCounter("led.delta_cache_hits", &cache_hits);
+    }
+}
+
+LEDSnapshotBank::~LEDSnapshotBank()
+{
+    if (registry) {
+        registry->Unregister(&recalls);
+        registry->Unregister(&messages_sent);
+        registry->Unregister(&messages_skipped);
+        registry->Unregister(&cache_hits);
+    }
+}
+
+APCMiniError LEDSnapshotBank::Store(size_t slot, const LEDSnapshot& snapshot)
+{
+    if (slot >= slots.size()) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    slots[slot] = snapshot;
+    generations[slot]++;
+    return APC_SUCCESS;
+}
+
+const LEDSnapshot* LEDSnapshotBank::Get(size_t slot) const
+{
+    return slot < slots.size() ? &slots[slot] : nullptr;
+}
+
+APCMiniError LEDSnapshotBank::Recall(size_t slot)
+{
+    if (slot >= slots.size()) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    active.store(&slots[slot], std::memory_order_release);
+    recalls.fetch_add(1, std::memory_order_relaxed);
+    return APC_SUCCESS;
+}
+
+int LEDSnapshotBank::ActiveSlot() const
+{
+    const LEDSnapshot* current = active.load(std::memory_order_acquire);
+    return current ? static_cast<int>(current - slots.data()) : -1;
+}
+
+APCMiniError LEDSnapshotBank::Flush(size_t* sent)
+{
+    if (sent) {
+        *sent = 0;
+    }
+
+    const LEDSnapshot* target = active.load(std::memory_order_acquire);
+    if (!target) {
+        return APC_SUCCESS;
+    }
+    if (!hardware_known) {
+        return FlushFull(sent);
+    }
+
+    flushes.fetch_add(1, std::memory_order_relaxed);
+    size_t slot = target - slots.data();
+
+    uint8_t leds[LED_SNAPSHOT_LED_COUNT];
+    const uint8_t* delta = leds;
+    size_t count = 0;
+
+    bool hardware_shows_slot = hardware_slot >= 0 &&
+                               hardware_generation == generations[hardware_slot];
+
+    if (hardware_shows_slot && (size_t)hardware_slot == slot) {
+        count = 0;   // Already lit
+    } else if (hardware_shows_slot) {
+        DeltaEntry* entry = FindDelta(hardware_slot, slot);
+        if (entry) {
+            cache_hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            cache_misses.fetch_add(1, std::memory_order_relaxed);
+            entry = BuildDelta(hardware_slot, slot);
+        }
+        delta = entry->leds;
+        count = entry->count;
+    } else {
+        for (size_t led = 0; led < LED_SNAPSHOT_LED_COUNT; led++) {
+            if (target->velocity[led] != hardware.velocity[led] ||
+                target->channel[led] != hardware.channel[led]) {
+                leds[count++] = static_cast<uint8_t>(led);
+            }
+        }
+    }
+
+    messages_skipped.fetch_add(LED_SNAPSHOT_LED_COUNT - count, std::memory_order_relaxed);
+
+    APCMiniError result = SendLEDs(*target, delta, count, sent);
+    if (result == APC_SUCCESS) {
+        hardware_slot = static_cast<int>(slot);
+        hardware_generation = generations[slot];
+    }
+    return result;
+}
+
+APCMiniError LEDSnapshotBank::FlushFull(size_t* sent)
+{
+    if (sent) {
+        *sent = 0;
+    }
+
+    const LEDSnapshot* target = active.load(std::memory_order_acquire);
+    if (!target) {
+        return APC_SUCCESS;
+    }
+
+    flushes.fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t leds[LED_SNAPSHOT_LED_COUNT];
+    for (size_t led = 0; led < LED_SNAPSHOT_LED_COUNT; led++) {
+        leds[led] = static_cast<uint8_t>(led);
+    }
+
+    APCMiniError result = SendLEDs(*target, leds, LED_SNAPSHOT_LED_COUNT, sent);
+    if (result == APC_SUCCESS) {
+        hardware_known = true;
+        hardware_slot = static_cast<int>(target - slots.data());
+        hardware_generation = generations[hardware_slot];
+    }
+    return result;
+}
+
+APCMiniError LEDSnapshotBank::PrecomputeDelta(size_t from_slot, size_t to_slot)
+{
+    if (from_slot >= slots.size() || to_slot >= slots.size()) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    if (!FindDelta(from_slot, to_slot)) {
+        BuildDelta(from_slot, to_slot);
+    }
+    return APC_SUCCESS;
+}
+
+void LEDSnapshotBank::Invalidate()
+{
+    hardware_known = false;
+    hardware_slot = -1;
+}
+
+LEDSnapshotStats LEDSnapshotBank::GetStats() const
+{
+    LEDSnapshotStats stats;
+    stats.recalls = recalls.load();
+    stats.flushes = flushes.load();
+    stats.messages_sent = messages_sent.load();
+    stats.messages_skipped = messages_skipped.load();
+    stats.cache_hits = cache_hits.load();
+    stats.cache_misses = cache_misses.load();
+    stats.send_failures = send_failures.load();
+    return stats;
+}
+
+LEDSnapshotBank::DeltaEntry* LEDSnapshotBank::FindDelta(size_t from_slot, size_t to_slot)
+{
+    for (size_t i = 0; i < LED_DELTA_CACHE_SIZE; i++) {
+        DeltaEntry& entry = delta_cache[i];
+        if (entry.from_slot == (int)from_slot && entry.to_slot == (int)to_slot &&
+            entry.from_generation == generations[from_slot] &&
+            entry.to_generation == generations[to_slot]) {
+            entry.last_used = ++delta_clock;
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+LEDSnapshotBank::DeltaEntry* LEDSnapshotBank::BuildDelta(size_t from_slot, size_t to_slot)
+{
+    // Replace a free or stale entry first, then the least recently used one
+    DeltaEntry* victim = &delta_cache[0];
+    for (size_t i = 0; i < LED_DELTA_CACHE_SIZE; i++) {
+        DeltaEntry& entry = delta_cache[i];
+        bool stale = entry.from_slot < 0 ||
+                     entry.from_generation != generations[entry.from_slot] ||
+                     entry.to_generation != generations[entry.to_slot];
+        if (stale) {
+            victim = &entry;
+            break;
+        }
+        if (entry.last_used < victim->last_used) {
+            victim = &entry;
+        }
+    }
+
+    const LEDSnapshot& from = slots[from_slot];
+    const LEDSnapshot& to = slots[to_slot];
+
+    victim->from_slot = static_cast<int>(from_slot);
+    victim->to_slot = static_cast<int>(to_slot);
+    victim->from_generation = generations[from_slot];
+    victim->to_generation = generations[to_slot];
+    victim->last_used = ++delta_clock;
+    victim->count = 0;
+
+    for (size_t led = 0; led < LED_SNAPSHOT_LED_COUNT; led++) {
+        if (from.velocity[led] != to.velocity[led] || from.channel[led] != to.channel[led]) {
+            victim->leds[victim->count++] = static_cast<uint8_t>(led);
+        }
+    }
+    return victim;
+}
+
+APCMiniError LEDSnapshotBank::SendLED(const LEDSnapshot& target, size_t led)
+{
+    APCMiniError result = sender(MIDI_NOTE_ON | target.channel[led], LEDSnapshot::NoteForLED(led),
+                                 target.velocity[led]);
+    if (result == APC_SUCCESS) {
+        hardware.velocity[led] = target.velocity[led];
+        hardware.channel[led] = target.channel[led];
+    }
+    return result;
+}
+
+APCMiniError LEDSnapshotBank::SendLEDs(const LEDSnapshot& target, const uint8_t* leds, size_t count,
+                                       size_t* sent)
+{
+    if (!sender) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        APCMiniError result = SendLED(target, leds[i]);
+        if (result != APC_SUCCESS) {
+            // The shadow holds what did get through; diff from it next time
+            send_failures.fetch_add(1, std::memory_order_relaxed);
+            hardware_slot = -1;
+            return result;
+        }
+        messages_sent.fetch_add(1, std::memory_order_relaxed);
+        if (sent) {
+            (*sent)++;
+        }
+    }
+    return APC_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#ifndef LED_SNAPSHOT_BANK_H
+#define LED_SNAPSHOT_BANK_H
+
+/*
+ * LED Snapshot Bank
+ *
+ * Prepared "looks" (whole grid plus track and scene button LEDs) for live
+ * switching. All snapshots are allocated up front; recalling one is a single
+ * atomic pointer store, so it is safe from any thread (GUI, MIDI input, a
+ * clock) and never allocates.
+ *
+ * Flush() brings the hardware to the recalled look. The bank keeps a shadow
+ * of what was last sent to the device and transmits only LEDs that differ,
+ * instead of re-sending all 64 pads like SetPadColorsBatch(). When the
+ * hardware is known to show an unmodified snapshot, the list of differing
+ * LEDs for the (shown, recalled) pair is kept in a small delta cache, so
+ * pairs that are alternated often skip the comparison entirely.
+ *
+ * Threading: Recall() from any thread; Store(), Flush() and Invalidate()
+ * from one output thread (or externally serialized).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "apc_mini_defs.h"
+#include "apc_device_profile.h"
+
+struct LEDFrame;
+struct LEDPalette;
+class MetricsRegistry;
+
+#define LED_SNAPSHOT_TRACK_LEDS   8
+#define LED_SNAPSHOT_SCENE_LEDS   8
+#define LED_SNAPSHOT_LED_COUNT    (APC_MINI_PAD_COUNT + LED_SNAPSHOT_TRACK_LEDS + LED_SNAPSHOT_SCENE_LEDS)
+#define LED_DELTA_CACHE_SIZE      16
+
+// Button LED states (single color LEDs on the MK2)
+enum LEDButtonState {
+    LED_BUTTON_OFF = 0,
+    LED_BUTTON_ON = 1,
+    LED_BUTTON_BLINK = 2
+};
+
+// One look: Note On channel and velocity for every LED. Pads use the MK2
+// palette (velocity = color index, channel = brightness/behaviour).
+struct LEDSnapshot {
+    uint8_t velocity[LED_SNAPSHOT_LED_COUNT];
+    uint8_t channel[LED_SNAPSHOT_LED_COUNT];
+
+    // All LEDs off
+    void Clear();
+
+    void SetPad(uint8_t pad, uint8_t color, uint8_t led_channel = APCMiniMK2Profile::LED_CHANNEL);
+    void SetTrackButton(uint8_t index, LEDButtonState state);
+    void SetSceneButton(uint8_t index, LEDButtonState state);
+
+    // Pads from an 8-bit frame, quantized to the palette (see led_frame_ops.h)
+    void SetPadsFromFrame(const LEDFrame& frame, const LEDPalette& palette,
+                          uint8_t led_channel = APCMiniMK2Profile::LED_CHANNEL);
+
+    // MIDI note for LED index (pads, then track buttons, then scene buttons),
+    // from the MK2 profile
+    static uint8_t NoteForLED(size_t led);
+};
+
+struct LEDSnapshotStats {
+    uint64_t recalls;
+    uint64_t flushes;
+    uint64_t messages_sent;
+    uint64_t messages_skipped;     // LEDs already showing the right state
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t send_failures;
+};
+
+class LEDSnapshotBank {
+public:
+    // Sends one MIDI message; usually USBRawMIDI::SendMIDI or MIDITransport::SendMIDI
+    typedef std::function<APCMiniError(uint8_t status, uint8_t data1, uint8_t data2)> MIDISender;
+
+    LEDSnapshotBank(size_t slot_count, MIDISender sender, MetricsRegistry* registry = nullptr);
+    ~LEDSnapshotBank();
+
+    size_t SlotCount() const { return slots.size(); }
+
+    // Replace a slot's contents (takes effect at the next Flush if recalled)
+    APCMiniError Store(size_t slot, const LEDSnapshot& snapshot);
+    const LEDSnapshot* Get(size_t slot) const;
+
+    // O(1): make slot the look the next Flush() transmits
+    APCMiniError Recall(size_t slot);
+    int ActiveSlot() const;
+
+    /**
+     * Send the LEDs that differ between the hardware and the active look
+     *
+     * @param sent Optional: number of MIDI messages transmitted
+     * @return First send error; LEDs sent before it stay recorded as shown
+     */
+    APCMiniError Flush(size_t* sent = nullptr);
+
+    // Re-send every LED of the active look (after reconnects, for comparison)
+    APCMiniError FlushFull(size_t* sent = nullptr);
+
+    /**
+     * Compute the delta between two slots ahead of time
+     *
+     * Useful for pairs alternated during a song; the entry stays valid until
+     * either slot is stored again.
+     */
+    APCMiniError PrecomputeDelta(size_t from_slot, size_t to_slot);
+
+    // Hardware state unknown (device reconnected): next Flush sends everything
+    void Invalidate();
+
+    LEDSnapshotStats GetStats() const;
+
+private:
+    struct DeltaEntry {
+        int from_slot;                 // -1 = unused
+        int to_slot;
+        uint64_t from_generation;
+        uint64_t to_generation;
+        uint64_t last_used;
+        size_t count;
+        uint8_t leds[LED_SNAPSHOT_LED_COUNT];
+    };
+
+    DeltaEntry* FindDelta(size_t from_slot, size_t to_slot);
+    DeltaEntry* BuildDelta(size_t from_slot, size_t to_slot);
+    APCMiniError SendLED(const LEDSnapshot& target, size_t led);
+    APCMiniError SendLEDs(const LEDSnapshot& target, const uint8_t* leds, size_t count, size_t* sent);
+
+    MIDISender sender;
+    MetricsRegistry* registry;
+
+    std::vector<LEDSnapshot> slots;
+    std::vector<uint64_t> generations;   // Bumped by Store() to invalidate deltas
+    std::atomic<const LEDSnapshot*> active;
+
+    // What the device currently shows
+    LEDSnapshot hardware;
+    bool hardware_known;
+    int hardware_slot;                   // Slot the hardware matches (-1 = none)
+    uint64_t hardware_generation;
+
+    DeltaEntry delta_cache[LED_DELTA_CACHE_SIZE];
+    uint64_t delta_clock;
+
+    std::atomic<uint64_t> recalls;
+    std::atomic<uint64_t> flushes;
+    std::atomic<uint64_t> messages_sent;
+    std::atomic<uint64_t> messages_skipped;
+    std::atomic<uint64_t> cache_hits;
+    std::atomic<uint64_t> cache_misses;
+    std::atomic<uint64_t> send_failures;
+};
+
+#endif // LED_SNAPSHOT_BANK_H
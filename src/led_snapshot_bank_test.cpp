@@ -0,0 +1,208 @@
+/*
+ * LED Snapshot Bank Test
+ * Recall, diffed flushes, delta cache and failure recovery
+ */
+
+#include "led_snapshot_bank.h"
+#include "led_frame_ops.h"
+#include "midi_transport.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+struct SentMessage {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+static LEDSnapshot MakeLook(uint8_t base_color)
+{
+    LEDSnapshot look;
+    look.Clear();
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        look.SetPad(pad, (pad % 8 < 4) ? base_color : 0);
+    }
+    look.SetTrackButton(base_color % 8, LED_BUTTON_ON);
+    look.SetSceneButton(0, LED_BUTTON_BLINK);
+    return look;
+}
+
+void test_recall_and_diff()
+{
+    printf("Testing Recall and diffed Flush...\n");
+
+    std::vector<SentMessage> sent_log;
+    LEDSnapshotBank bank(8, [&sent_log](uint8_t status, uint8_t data1, uint8_t data2) {
+        sent_log.push_back({status, data1, data2});
+        return APC_SUCCESS;
+    });
+
+    assert(bank.ActiveSlot() == -1);
+    assert(bank.Recall(8) == APC_ERROR_INVALID_PARAMETER);
+
+    LEDSnapshot red = MakeLook(5);
+    LEDSnapshot green = MakeLook(22);
+    assert(bank.Store(0, red) == APC_SUCCESS);
+    assert(bank.Store(1, green) == APC_SUCCESS);
+
+    // First flush: hardware unknown, everything goes out
+    size_t sent = 0;
+    assert(bank.Recall(0) == APC_SUCCESS);
+    assert(bank.ActiveSlot() == 0);
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == LED_SNAPSHOT_LED_COUNT);
+    assert(sent_log[0].status == (MIDI_NOTE_ON | APCMiniMK2Profile::LED_CHANNEL));
+    assert(sent_log[0].data1 == APC_MINI_PAD_NOTE_START && sent_log[0].data2 == 5);
+    assert(sent_log[APC_MINI_PAD_COUNT].data1 == APC_MINI_TRACK_NOTE_START);
+    assert(sent_log[LED_SNAPSHOT_LED_COUNT - 1].data1 == APC_MINI_SCENE_NOTE_END);
+
+    // Same look again: nothing to send
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == 0);
+
+    // Switch: only the 32 colored pads and two track buttons differ
+    sent_log.clear();
+    assert(bank.Recall(1) == APC_SUCCESS);
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == 32 + 2);
+    for (const SentMessage& message : sent_log) {
+        if (message.data1 < APC_MINI_PAD_COUNT) {
+            assert(message.data2 == 22);
+        }
+    }
+
+    // Editing the shown look is picked up by the next flush
+    green.SetPad(63, 45);
+    assert(bank.Store(1, green) == APC_SUCCESS);
+    sent_log.clear();
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == 1);
+    assert(sent_log[0].data1 == 63 && sent_log[0].data2 == 45);
+
+    printf("✅ Only changed LEDs are transmitted\n");
+}
+
+void test_delta_cache()
+{
+    printf("Testing delta cache for alternated pairs...\n");
+
+    LEDSnapshotBank bank(4, [](uint8_t, uint8_t, uint8_t) { return APC_SUCCESS; });
+    bank.Store(0, MakeLook(5));
+    bank.Store(1, MakeLook(21));
+    bank.Store(2, MakeLook(45));
+
+    bank.Recall(0);
+    assert(bank.FlushFull() == APC_SUCCESS);
+    assert(bank.PrecomputeDelta(0, 1) == APC_SUCCESS);
+    assert(bank.PrecomputeDelta(0, 9) == APC_ERROR_INVALID_PARAMETER);
+
+    // 0 -> 1 precomputed, 1 -> 0 computed once, then both hit
+    for (int i = 0; i < 10; i++) {
+        bank.Recall(i % 2 == 0 ? 1 : 0);
+        assert(bank.Flush() == APC_SUCCESS);
+    }
+    LEDSnapshotStats stats = bank.GetStats();
+    assert(stats.cache_misses == 1);
+    assert(stats.cache_hits == 9);
+
+    // Storing a slot invalidates its deltas
+    bank.Store(1, MakeLook(13));
+    bank.Recall(1);
+    size_t sent = 0;
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(bank.GetStats().cache_misses == 2);
+    assert(sent > 0);
+
+    printf("✅ Cached deltas hit: %llu, misses: %llu\n",
+           (unsigned long long)bank.GetStats().cache_hits, (unsigned long long)bank.GetStats().cache_misses);
+}
+
+void test_send_failure()
+{
+    printf("Testing recovery from a failed send...\n");
+
+    int budget = 10;
+    LEDSnapshotBank bank(2, [&budget](uint8_t, uint8_t, uint8_t) {
+        return budget-- > 0 ? APC_SUCCESS : APC_ERROR_USB_TRANSFER_FAILED;
+    });
+    bank.Store(0, MakeLook(5));
+    bank.Recall(0);
+
+    size_t sent = 0;
+    assert(bank.Flush(&sent) == APC_ERROR_USB_TRANSFER_FAILED);
+    assert(sent == 10);
+    assert(bank.GetStats().send_failures == 1);
+
+    // Still unknown hardware: full resend, then diffs resume
+    budget = 1000;
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == LED_SNAPSHOT_LED_COUNT);
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == 0);
+
+    bank.Invalidate();
+    assert(bank.Flush(&sent) == APC_SUCCESS);
+    assert(sent == LED_SNAPSHOT_LED_COUNT);
+
+    printf("✅ Failed flush resumes correctly\n");
+}
+
+void test_simulated_device()
+{
+    printf("Testing against the simulated MK2...\n");
+
+    SimulatedDeviceTransport device(SimulatedLinkModel::Instant());
+    device.SetEchoEnabled(false);
+    assert(device.Open() == APC_SUCCESS);
+
+    LEDSnapshotBank bank(3, [&device](uint8_t status, uint8_t data1, uint8_t data2) {
+        return device.SendMIDI(status, data1, data2);
+    });
+
+    // Look built from an 8-bit frame through the palette
+    const APCMiniMK2RGB colors[] = {{0x00, 0x00, 0x00}, {0x7F, 0x00, 0x00}, {0x00, 0x00, 0x7F}};
+    LEDPalette palette = LEDPalette::FromMK2Colors(colors, 3);
+    LEDFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    for (int pad = 0; pad < LED_FRAME_PADS; pad++) {
+        frame.SetPad(pad, pad < 32 ? 250 : 0, 0, pad < 32 ? 0 : 240);
+    }
+    LEDSnapshot frame_look;
+    frame_look.Clear();
+    frame_look.SetPadsFromFrame(frame, palette);
+    bank.Store(0, frame_look);
+    bank.Store(1, MakeLook(9));
+
+    for (int slot : {0, 1, 0, 2, 1}) {
+        bank.Recall(slot);
+        assert(bank.Flush() == APC_SUCCESS);
+        const LEDSnapshot* look = bank.Get(slot);
+        for (size_t led = 0; led < LED_SNAPSHOT_LED_COUNT; led++) {
+            uint8_t note = LEDSnapshot::NoteForLED(led);
+            assert(device.GetLEDVelocity(note) == look->velocity[led]);
+            assert(device.GetLEDChannel(note) == look->channel[led]);
+        }
+        if (slot == 0) {
+            assert(device.GetLEDVelocity(0) == 1 && device.GetLEDVelocity(40) == 2);
+        }
+    }
+
+    device.Close();
+    printf("✅ Device LEDs match every recalled look\n");
+}
+
+int main()
+{
+    printf("🎛️  LED Snapshot Bank Test\n");
+    printf("=========================\n\n");
+
+    test_recall_and_diff();
+    test_delta_cache();
+    test_send_failure();
+    test_simulated_device();
+
+    printf("\n🎉 ALL TESTS PASSED! Looks switch with minimal traffic.\n");
+    return 0;
+}
@@ -0,0 +1,156 @@
+// LED Snapshot Recall Benchmark
+// Recall-to-lit latency on the simulated MK2 (full-speed USB model): time
+// from Recall() until the last LED message of the new look reaches the
+// device, for a full re-send of every LED versus the diffed flush.
+//
+// Usage: led_snapshot_benchmark [--recalls <count>] [--changed <pads>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+
+#include "led_snapshot_bank.h"
+#include "midi_transport.h"
+#include "latency_histogram.h"
+
+#define LOOK_COUNT 8
+
+enum RecallMode {
+    MODE_FULL,          // Every LED each time (like SetPadColorsBatch)
+    MODE_DIFF_RANDOM,   // Diffed flush, random looks (mostly cache misses)
+    MODE_DIFF_PAIR      // Diffed flush, two looks alternated (cache hits)
+};
+
+struct RecallResult {
+    bigtime_t p50_us;
+    bigtime_t p99_us;
+    bigtime_t max_us;
+    double flush_ns;
+    double messages_per_recall;
+    LEDSnapshotStats stats;
+};
+
+// Looks share a background and differ in changed_pads pads each
+static void BuildLooks(LEDSnapshotBank& bank, int changed_pads)
+{
+    std::mt19937 rng(7);
+    LEDSnapshot base;
+    base.Clear();
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        base.SetPad(pad, (pad / 8) * 8 + 1);
+    }
+
+    for (size_t slot = 0; slot < LOOK_COUNT; slot++) {
+        LEDSnapshot look = base;
+        for (int i = 0; i < changed_pads; i++) {
+            look.SetPad(rng() % APC_MINI_PAD_COUNT, rng() % 128);
+        }
+        look.SetTrackButton(slot, LED_BUTTON_ON);
+        look.SetSceneButton(slot, LED_BUTTON_BLINK);
+        bank.Store(slot, look);
+    }
+}
+
+static RecallResult RunRecalls(RecallMode mode, int recalls, int changed_pads)
+{
+    SimulatedDeviceTransport device(SimulatedLinkModel::FullSpeedUSB());
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    LEDSnapshotBank bank(LOOK_COUNT, [&device](uint8_t status, uint8_t data1, uint8_t data2) {
+        return device.SendMIDI(status, data1, data2);
+    });
+    BuildLooks(bank, changed_pads);
+    bank.Recall(0);
+    bank.FlushFull();
+    snooze(20000);
+
+    LatencyHistogram latency;
+    std::mt19937 rng(11);
+    double flush_ns_total = 0;
+    size_t messages_total = 0;
+    size_t current = 0;
+
+    for (int i = 0; i < recalls; i++) {
+        size_t next;
+        if (mode == MODE_DIFF_PAIR) {
+            next = current == 0 ? 1 : 0;
+        } else {
+            do {
+                next = rng() % LOOK_COUNT;
+            } while (next == current);
+        }
+        current = next;
+
+        size_t sent = 0;
+        bigtime_t recalled_at = system_time();
+        auto start = std::chrono::steady_clock::now();
+        bank.Recall(next);
+        if (mode == MODE_FULL) {
+            bank.FlushFull(&sent);
+        } else {
+            bank.Flush(&sent);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        bigtime_t lit_at = sent > 0 ? device.GetLastLEDLitTime() : recalled_at;
+        latency.Record(lit_at - recalled_at);
+        flush_ns_total += std::chrono::duration<double, std::nano>(elapsed).count();
+        messages_total += sent;
+
+        // Looks change seconds apart on stage; let the link drain
+        snooze_until(lit_at + 5000, B_SYSTEM_TIMEBASE);
+    }
+
+    device.Close();
+
+    RecallResult result;
+    result.p50_us = latency.Percentile(50.0);
+    result.p99_us = latency.Percentile(99.0);
+    result.max_us = latency.Max();
+    result.flush_ns = flush_ns_total / recalls;
+    result.messages_per_recall = (double)messages_total / recalls;
+    result.stats = bank.GetStats();
+    return result;
+}
+
+static void Report(const char* name, const RecallResult& result)
+{
+    printf("   %-24s %6.1f msgs | lit p50 %5lld  p99 %5lld  max %5lld us | flush %8.0f ns | cache %llu/%llu\n",
+           name, result.messages_per_recall, (long long)result.p50_us, (long long)result.p99_us,
+           (long long)result.max_us, result.flush_ns, (unsigned long long)result.stats.cache_hits,
+           (unsigned long long)(result.stats.cache_hits + result.stats.cache_misses));
+}
+
+int main(int argc, char** argv)
+{
+    int recalls = 200;
+    int changed_pads = 12;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--recalls") == 0 && i + 1 < argc) {
+            recalls = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--changed") == 0 && i + 1 < argc) {
+            changed_pads = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--recalls <count>] [--changed <pads>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (recalls <= 0 || changed_pads < 0 || changed_pads > APC_MINI_PAD_COUNT) {
+        printf("❌ --recalls must be positive and --changed within 0-%d\n", APC_MINI_PAD_COUNT);
+        return 1;
+    }
+
+    printf("🎛️  LED Snapshot Recall Benchmark (%d recalls, %d looks, ~%d pads differ per look)\n\n",
+           recalls, LOOK_COUNT, changed_pads);
+
+    Report("Full re-send", RunRecalls(MODE_FULL, recalls, changed_pads));
+    Report("Diff, random looks", RunRecalls(MODE_DIFF_RANDOM, recalls, changed_pads));
+    Report("Diff, alternating pair", RunRecalls(MODE_DIFF_PAIR, recalls, changed_pads));
+
+    printf("\n   Recall itself is one atomic store; lit latency is dominated by link packets.\n");
+    return 0;
+}
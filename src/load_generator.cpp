@@ -0,0 +1,328 @@
+#include "load_generator.h"
+#include "midi_message_queue.h"
+#include "realtime_arena.h"
+#include "apc_device_profile.h"
+#include "thread_accounting.h"
+#include <stdio.h>
+
+LoadGenerator::LoadGenerator(MIDITransport* midi_transport, RealtimeArena* arena)
+    : transport(midi_transport)
+    , queue(arena ? arena->New<MIDIMessageQueue>("load_queue") : nullptr)
+    , queue_in_arena(queue != nullptr)
+    , measure_from(0)
+    , received_count(0)
+    , dispatched_count(0)
+    , queue_drops(0)
+    , dispatch_running(false)
+{
+    if (!queue) {
+        queue = new MIDIMessageQueue();
+    }
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    dispatch_running.store(false);
+    if (dispatch_thread.joinable()) {
+        dispatch_thread.join();
+    }
+    if (queue_in_arena) {
+        RealtimeArena::Delete(queue);
+    } else {
+        delete queue;
+    }
+}
+
+void LoadGenerator::BuildSchedule(const LoadProfile& profile, std::mt19937& rng)
+{
+    const bool burst = profile.arrival == LOAD_ARRIVAL_BURST;
+    const uint32_t burst_size = profile.burst_size > 0 ? profile.burst_size : 1;
+    const bigtime_t burst_interval = profile.burst_interval_us > 0 ? profile.burst_interval_us : 1;
+    const double expected = burst
+        ? (double)burst_size * (profile.duration_us / burst_interval + 1)
+        : (double)profile.rate_hz * profile.duration_us / 1000000.0;
+    const size_t capacity = static_cast<size_t>(expected * 1.5) + 1024;
+
+    schedule_offsets.clear();
+    schedule_kinds.clear();
+    schedule_data.clear();
+    schedule_offsets.reserve(capacity);
+    schedule_kinds.reserve(capacity);
+    schedule_data.reserve(capacity * 2);
+
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> byte7(0, 127);
+    std::uniform_int_distribution<int> pad(0, APCMiniMK2Device::PAD_COUNT - 1);
+    std::uniform_int_distribution<int> fader(0, APC_MINI_TOTAL_FADER_COUNT - 1);
+    std::exponential_distribution<double> poisson(profile.rate_hz > 0 ? profile.rate_hz : 1);
+
+    const double period_us = profile.rate_hz > 0 ? 1000000.0 / profile.rate_hz : 0.0;
+    double offset = 0.0;
+    uint32_t in_burst = 0;
+
+    while (offset < profile.duration_us && schedule_offsets.size() < capacity) {
+        schedule_offsets.push_back(static_cast<bigtime_t>(offset));
+
+        int roll = percent(rng);
+        if (roll < profile.pad_percent) {
+            schedule_kinds.push_back(LOAD_MESSAGE_PAD);
+            schedule_data.push_back(static_cast<uint8_t>(pad(rng)));
+        } else if (roll < profile.pad_percent + profile.fader_percent) {
+            schedule_kinds.push_back(LOAD_MESSAGE_FADER);
+            schedule_data.push_back(static_cast<uint8_t>(fader(rng)));
+        } else {
+            schedule_kinds.push_back(LOAD_MESSAGE_SYSEX);
+            schedule_data.push_back(static_cast<uint8_t>(pad(rng)));
+        }
+        schedule_data.push_back(static_cast<uint8_t>(byte7(rng)));
+
+        if (burst) {
+            if (++in_burst == burst_size) {
+                in_burst = 0;
+                offset += burst_interval;
+            }
+        } else if (profile.arrival == LOAD_ARRIVAL_POISSON) {
+            offset += poisson(rng) * 1000000.0;
+        } else {
+            offset += period_us;
+        }
+    }
+}
+
+APCMiniError LoadGenerator::SendScheduled(size_t index)
+{
+    const uint8_t target = schedule_data[index * 2];
+    const uint8_t value = schedule_data[index * 2 + 1];
+
+    switch (schedule_kinds[index]) {
+        case LOAD_MESSAGE_PAD:
+            return transport->SendMIDI(APCMiniMK2Device::PadLEDStatus(),
+                                       APCMiniMK2Device::PadNote(target), value);
+
+        case LOAD_MESSAGE_FADER:
+            return transport->SendMIDI(MIDI_CONTROL_CHANGE | APC_MINI_MIDI_CHANNEL,
+                                       APC_MINI_FADER_CC_START + target, value);
+
+        case LOAD_MESSAGE_SYSEX:
+        default: {
+            // RGB SysEx for one pad: value drives all three channels, each
+            // split into MSB/LSB like APCMiniTestApp::SendMK2CustomRGB()
+            const uint8_t msb = static_cast<uint8_t>((value >> 7) & 0x7F);
+            const uint8_t lsb = static_cast<uint8_t>(value & 0x7F);
+            const uint8_t sysex[] = {
+                APC_MK2_SYSEX_HEADER, APC_MK2_SYSEX_RGB_CMD, 0x00, 0x08,
+                target, target,
+                msb, lsb,
+                msb, lsb,
+                msb, lsb,
+                APC_MK2_SYSEX_END
+            };
+            return transport->SendSysEx(sysex, sizeof(sysex));
+        }
+    }
+}
+
+void LoadGenerator::OnReceived(uint8_t status, uint8_t data1, uint8_t data2, uint16_t sysex_length)
+{
+    // Receive order matches send order, so the n-th arrival belongs to the
+    // n-th successful send; stamp it with that message's intended time.
+    uint64_t index = received_count.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= intended_times.size()) {
+        return;
+    }
+
+    MIDIMessage message(status, data1, data2, MIDI_SOURCE_SIMULATION, intended_times[index]);
+    message.sysex_length = sysex_length;
+
+    if (!queue->Enqueue(message)) {
+        queue_drops.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LoadGenerator::DispatchLoop(bigtime_t poll_us)
+{
+    ScopedThreadAccounting accounting("load_dispatch");
+    MIDIMessage message;
+
+    for (;;) {
+        bool running = dispatch_running.load(std::memory_order_acquire);
+        bool processed = false;
+
+        while (queue->Dequeue(message)) {
+            // Timestamp is the intended send time; warmup is not measured
+            if (message.timestamp >= measure_from.load(std::memory_order_relaxed)) {
+                histogram.Record(system_time() - message.timestamp);
+            }
+            dispatched_count.fetch_add(1, std::memory_order_relaxed);
+            processed = true;
+        }
+
+        if (!running) {
+            break;
+        }
+
+        if (!processed) {
+            if (poll_us > 0) {
+                snooze(poll_us);
+                ThreadAccounting::NoteWakeup();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+LoadRunResult LoadGenerator::Run(const LoadProfile& profile)
+{
+    LoadRunResult result = {};
+    result.target_rate_hz = profile.EffectiveRateHz();
+
+    std::mt19937 rng(profile.seed);
+    BuildSchedule(profile, rng);
+    intended_times.assign(schedule_offsets.size(), 0);
+
+    histogram.Reset();
+    send_histogram.Reset();
+    queue->ResetStatistics();
+    received_count.store(0);
+    dispatched_count.store(0);
+    queue_drops.store(0);
+
+    // Callbacks may only change while the transport is closed
+    transport->Close();
+    transport->SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+        OnReceived(status, data1, data2, 0);
+    });
+    transport->SetSysExCallback([this](const uint8_t* data, size_t length) {
+        OnReceived(data[0], length > 1 ? data[1] : 0, length > 2 ? data[2] : 0,
+                   static_cast<uint16_t>(length));
+    });
+
+    if (transport->Open() != APC_SUCCESS) {
+        printf("❌ Load generator: cannot open transport '%s'\n", transport->Name());
+        return result;
+    }
+
+    dispatch_running.store(true);
+    dispatch_thread = std::thread(&LoadGenerator::DispatchLoop, this, profile.dispatch_poll_us);
+
+    // Sending phase: open loop against the precomputed schedule
+    const bigtime_t start_time = system_time() + 1000;
+    measure_from.store(start_time + profile.warmup_us);
+    bigtime_t max_lag = 0;
+    uint64_t sent = 0;
+
+    for (size_t i = 0; i < schedule_offsets.size(); i++) {
+        const bigtime_t intended = start_time + schedule_offsets[i];
+        bigtime_t now = system_time();
+
+        if (intended > now) {
+            snooze_until(intended, B_SYSTEM_TIMEBASE);
+        } else if (now - intended > max_lag) {
+            max_lag = now - intended;
+        }
+
+        // Publish the intended time before the message can arrive; a failed
+        // send leaves the slot to be overwritten by the next message
+        intended_times[sent] = intended;
+
+        if (SendScheduled(i) == APC_SUCCESS) {
+            sent++;
+            result.per_kind_sent[schedule_kinds[i]]++;
+            if (schedule_offsets[i] >= profile.warmup_us) {
+                send_histogram.Record(system_time() - intended);
+            } else {
+                result.messages_warmup++;
+            }
+        } else {
+            result.send_failures++;
+        }
+    }
+    const bigtime_t send_end = system_time();
+
+    // Drain: wait for in-flight messages up to the timeout
+    const bigtime_t drain_deadline = send_end + profile.drain_timeout_us;
+    while (dispatched_count.load() + queue_drops.load() < sent && system_time() < drain_deadline) {
+        snooze(1000);
+    }
+
+    dispatch_running.store(false, std::memory_order_release);
+    dispatch_thread.join();
+
+    transport->Close();
+    transport->SetMIDICallback(nullptr);
+    transport->SetSysExCallback(nullptr);
+
+    const double send_seconds = (send_end - start_time) / 1000000.0;
+    const uint64_t dispatched = dispatched_count.load();
+
+    result.messages_sent = sent;
+    result.messages_dispatched = dispatched;
+    result.messages_lost = sent > dispatched ? sent - dispatched : 0;
+    result.queue_drops = queue_drops.load();
+    result.achieved_send_rate_hz = send_seconds > 0 ? sent / send_seconds : 0.0;
+    result.delivered_rate_hz = send_seconds > 0 ? dispatched / send_seconds : 0.0;
+    result.max_send_lag_us = max_lag;
+    result.latency_p50_us = histogram.Percentile(50.0);
+    result.latency_p90_us = histogram.Percentile(90.0);
+    result.latency_p99_us = histogram.Percentile(99.0);
+    result.latency_p999_us = histogram.Percentile(99.9);
+    result.latency_max_us = histogram.Max();
+    result.latency_mean_us = histogram.Mean();
+    result.send_p50_us = send_histogram.Percentile(50.0);
+    result.send_p99_us = send_histogram.Percentile(99.0);
+    result.send_max_us = send_histogram.Max();
+
+    return result;
+}
+
+int LoadGenerator::SweepRates(const LoadProfile& base, const uint32_t* rates, size_t rate_count,
+                              LoadRunResult* results, const LoadSweepCriteria& criteria)
+{
+    int knee = -1;
+    bigtime_t baseline_p99 = 0;
+
+    for (size_t i = 0; i < rate_count; i++) {
+        LoadProfile profile = base;
+        profile.rate_hz = rates[i];
+
+        LoadRunResult& result = results[i];
+        result = Run(profile);
+
+        if (i == 0) {
+            baseline_p99 = result.latency_p99_us > 0 ? result.latency_p99_us : 1;
+        }
+
+        double delivery_ratio = result.messages_sent > 0
+            ? (double)result.messages_dispatched / result.messages_sent : 0.0;
+
+        result.saturated = delivery_ratio < criteria.min_delivery_ratio
+            || result.latency_p99_us > criteria.max_p99_us
+            || result.latency_p99_us > baseline_p99 * criteria.max_p99_growth;
+
+        if (result.saturated) {
+            for (size_t rest = i + 1; rest < rate_count; rest++) {
+                results[rest] = LoadRunResult();
+                results[rest].target_rate_hz = rates[rest];
+                results[rest].saturated = true;
+            }
+            break;
+        }
+        knee = static_cast<int>(i);
+    }
+
+    return knee;
+}
+
+void LoadGenerator::PrintResult(const LoadRunResult& result)
+{
+    printf("  %7u Hz | sent %9.1f/s | dispatched %9.1f/s | lost %6llu | "
+           "p50 %6lld  p99 %7lld  p99.9 %7lld  max %7lld us | lag %7lld us %s\n",
+           result.target_rate_hz,
+           result.achieved_send_rate_hz, result.delivered_rate_hz,
+           (unsigned long long)result.messages_lost,
+           (long long)result.latency_p50_us, (long long)result.latency_p99_us,
+           (long long)result.latency_p999_us, (long long)result.latency_max_us,
+           (long long)result.max_send_lag_us,
+           result.saturated ? "⚠️ saturated" : "✓");
+}
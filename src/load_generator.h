@@ -0,0 +1,198 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+/*
+ * Open-Loop MIDI Load Generator
+ *
+ * RunStressTest() sends as fast as it can and reports a rate: every slow
+ * send delays the next one, so queueing delay never shows up in the numbers
+ * (coordinated omission). This generator instead:
+ *
+ * - Computes an intended send time for every message from the target rate
+ *   (constant spacing or Poisson arrivals) before the run starts
+ * - Sends at those times regardless of how earlier messages fared; when the
+ *   sender falls behind it catches up back-to-back and keeps the schedule
+ * - Measures latency from the INTENDED time, through the transport, the
+ *   receive callback and MIDIMessageQueue, to dispatch on a consumer thread
+ *   that polls like MIDIEventLooper
+ * - Sweeps a list of rates and reports the saturation knee: the highest
+ *   rate that is still delivered in full with a bounded p99
+ *
+ * Works with any MIDITransport (loopback, simulated MK2, real hardware).
+ * Messages are correlated by arrival order, which every transport preserves.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <random>
+
+#include "apc_mini_platform.h"
+#include "latency_histogram.h"
+#include "midi_transport.h"
+
+class MIDIMessageQueue;
+class RealtimeArena;
+
+enum LoadArrivalPattern {
+    LOAD_ARRIVAL_CONSTANT = 0,     // Evenly spaced (1 / rate)
+    LOAD_ARRIVAL_POISSON = 1,      // Exponential inter-arrival times
+    LOAD_ARRIVAL_BURST = 2         // burst_size back-to-back every burst_interval_us
+};
+
+enum LoadMessageKind {
+    LOAD_MESSAGE_PAD = 0,          // Note On, MK2 pad LED (channel 6)
+    LOAD_MESSAGE_FADER = 1,        // Control Change on a fader CC
+    LOAD_MESSAGE_SYSEX = 2         // MK2 RGB SysEx for a single pad
+};
+
+struct LoadProfile {
+    uint32_t rate_hz;              // Target messages per second
+    bigtime_t duration_us;         // Sending phase length
+    bigtime_t drain_timeout_us;    // Max wait for in-flight messages after sending
+    uint8_t pad_percent;           // Message mix (should add up to 100)
+    uint8_t fader_percent;
+    uint8_t sysex_percent;
+    LoadArrivalPattern arrival;
+    uint32_t burst_size;           // LOAD_ARRIVAL_BURST only (rate_hz is ignored)
+    bigtime_t burst_interval_us;
+    bigtime_t warmup_us;           // Messages intended before this are not measured
+    bigtime_t dispatch_poll_us;    // Consumer poll interval when idle (0 = spin)
+    uint32_t seed;                 // Mix/arrival RNG seed
+
+    // Average offered rate (derived from the burst shape for bursts)
+    uint32_t EffectiveRateHz() const {
+        if (arrival == LOAD_ARRIVAL_BURST) {
+            return burst_interval_us > 0 ? (uint32_t)(burst_size * 1000000LL / burst_interval_us) : 0;
+        }
+        return rate_hz;
+    }
+
+    // Bursts started before until_us (burst arrivals only)
+    uint32_t BurstsBefore(bigtime_t until_us) const {
+        return burst_interval_us > 0
+            ? (uint32_t)((until_us + burst_interval_us - 1) / burst_interval_us) : 0;
+    }
+
+    static LoadProfile Default() {
+        LoadProfile profile;
+        profile.rate_hz = 1000;
+        profile.duration_us = 2000000;
+        profile.drain_timeout_us = 2000000;
+        profile.pad_percent = 70;
+        profile.fader_percent = 25;
+        profile.sysex_percent = 5;
+        profile.arrival = LOAD_ARRIVAL_CONSTANT;
+        profile.burst_size = 0;
+        profile.burst_interval_us = 0;
+        profile.warmup_us = 0;
+        profile.dispatch_poll_us = 1000;    // Same as MIDIEventLooper default
+        profile.seed = 42;
+        return profile;
+    }
+};
+
+struct LoadRunResult {
+    uint32_t target_rate_hz;
+    double achieved_send_rate_hz;  // Messages actually sent per second
+    double delivered_rate_hz;      // Messages dispatched per second
+    uint64_t messages_sent;
+    uint64_t messages_dispatched;
+    uint64_t messages_lost;        // Sent but never dispatched (drops + timeouts)
+    uint64_t messages_warmup;      // Sent during warmup (counted, not measured)
+    uint64_t queue_drops;          // Rejected by MIDIMessageQueue (full)
+    uint64_t send_failures;        // Transport refused the message
+    uint64_t per_kind_sent[3];     // Indexed by LoadMessageKind
+    bigtime_t max_send_lag_us;     // Worst delay between intended and actual send
+    bigtime_t latency_p50_us;
+    bigtime_t latency_p90_us;
+    bigtime_t latency_p99_us;
+    bigtime_t latency_p999_us;
+    bigtime_t latency_max_us;
+    double latency_mean_us;
+    // Intended time to SendMIDI()/SendSysEx() returning; measurable on
+    // transports that do not echo (real hardware)
+    bigtime_t send_p50_us;
+    bigtime_t send_p99_us;
+    bigtime_t send_max_us;
+    bool saturated;                // Set by SweepRates()
+};
+
+// Rules used by SweepRates() to decide that a rate is no longer sustainable
+struct LoadSweepCriteria {
+    double min_delivery_ratio;     // Dispatched / sent must stay above this
+    double max_p99_growth;         // p99 may grow to this multiple of the first rate's p99
+    bigtime_t max_p99_us;          // Absolute p99 ceiling
+
+    static LoadSweepCriteria Default() {
+        LoadSweepCriteria criteria;
+        criteria.min_delivery_ratio = 0.99;
+        criteria.max_p99_growth = 10.0;
+        criteria.max_p99_us = 50000;
+        return criteria;
+    }
+};
+
+class LoadGenerator {
+public:
+    /**
+     * @param arena Optional committed arena with a "load_queue" block
+     *              reserved for the dispatch queue; nullptr uses the heap
+     */
+    LoadGenerator(MIDITransport* transport, RealtimeArena* arena = nullptr);
+    ~LoadGenerator();
+
+    /**
+     * Run one fixed-rate load phase
+     *
+     * Reopens the transport with the generator's receive callbacks and
+     * closes it again when the run is over. Latency samples are kept in GetHistogram()
+     * until the next run.
+     */
+    LoadRunResult Run(const LoadProfile& profile);
+
+    /**
+     * Run the profile at each rate (ascending) and find the saturation knee
+     *
+     * @param results Array of rate_count entries filled with each run
+     * @return Index of the highest sustainable rate, or -1 if even the
+     *         first rate saturated. Stops after the first saturated rate.
+     */
+    int SweepRates(const LoadProfile& base, const uint32_t* rates, size_t rate_count,
+                   LoadRunResult* results,
+                   const LoadSweepCriteria& criteria = LoadSweepCriteria::Default());
+
+    const LatencyHistogram& GetHistogram() const { return histogram; }
+    const LatencyHistogram& GetSendHistogram() const { return send_histogram; }
+
+    static void PrintResult(const LoadRunResult& result);
+
+private:
+    void BuildSchedule(const LoadProfile& profile, std::mt19937& rng);
+    APCMiniError SendScheduled(size_t index);
+    void OnReceived(uint8_t status, uint8_t data1, uint8_t data2, uint16_t sysex_length);
+    void DispatchLoop(bigtime_t poll_us);
+
+    MIDITransport* transport;
+    MIDIMessageQueue* queue;
+    bool queue_in_arena;
+    LatencyHistogram histogram;
+    LatencyHistogram send_histogram;
+    std::atomic<bigtime_t> measure_from;    // End of warmup (absolute)
+
+    // Schedule, built before the run (no allocation while sending)
+    std::vector<bigtime_t> schedule_offsets;
+    std::vector<uint8_t> schedule_kinds;
+    std::vector<uint8_t> schedule_data;
+    std::vector<bigtime_t> intended_times;  // Indexed by successful send order
+
+    std::atomic<uint64_t> received_count;
+    std::atomic<uint64_t> dispatched_count;
+    std::atomic<uint64_t> queue_drops;
+    std::atomic<bool> dispatch_running;
+    std::thread dispatch_thread;
+};
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,247 @@
+// Open-Loop Load Benchmark for the APC Mini MIDI pipeline
+// Sweeps message rates against the loopback and simulated MK2 transports
+// and reports latency percentiles measured from intended send times.
+//
+// Usage: load_generator_benchmark [--transport loopback|simulated|both]
+//                                 [--duration <ms>] [--rates r1,r2,...]
+//                                 [--mix pad,fader,sysex] [--poisson]
+//                                 [--poll <us>]
+//        load_generator_benchmark --workload <name|file> [--transport ...]
+//        load_generator_benchmark --idle <ms> [--wakeup-budget <per s>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "load_generator.h"
+#include "workload.h"
+#include "workload_driver.h"
+#include "midi_transport.h"
+#include "midi_message_queue.h"
+#include "realtime_arena.h"
+#include "rtt_prober.h"
+#include "thread_accounting.h"
+#include "metrics_registry.h"
+
+// Default sweep (messages per second)
+static const uint32_t DEFAULT_RATES[] = {
+    250, 500, 1000, 2000, 4000, 8000, 16000, 32000, 64000
+};
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("  --transport loopback|simulated|both   Transport to drive (default: both)\n");
+    printf("  --duration <ms>                       Sending time per rate (default: 2000)\n");
+    printf("  --rates r1,r2,...                     Rates to sweep in Hz, ascending\n");
+    printf("  --mix pad,fader,sysex                 Message mix in percent (default: 70,25,5)\n");
+    printf("  --poisson                             Poisson arrivals instead of constant spacing\n");
+    printf("  --poll <us>                           Dispatcher idle poll interval (default: 1000)\n");
+    printf("  --workload <name|file>                Run a shared workload instead of a rate sweep\n");
+    printf("  --idle <ms>                           Measure idle thread wakeups instead of load\n");
+    printf("  --wakeup-budget <per s>               Idle wakeups allowed per thread (default: 5)\n");
+}
+
+static bool ParseRates(const char* text, std::vector<uint32_t>& rates)
+{
+    rates.clear();
+    const char* cursor = text;
+    while (*cursor) {
+        char* end = nullptr;
+        unsigned long rate = strtoul(cursor, &end, 10);
+        if (end == cursor || rate == 0) {
+            return false;
+        }
+        rates.push_back(static_cast<uint32_t>(rate));
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    return !rates.empty();
+}
+
+static void RunSweep(MIDITransport* transport, const LoadProfile& profile,
+                     const std::vector<uint32_t>& rates)
+{
+    printf("\n🚀 Transport: %s (%s arrivals, mix %u/%u/%u pad/fader/sysex)\n",
+           transport->Name(),
+           profile.arrival == LOAD_ARRIVAL_POISSON ? "Poisson" : "constant",
+           profile.pad_percent, profile.fader_percent, profile.sysex_percent);
+
+    // Dispatch queue pre-faulted like the application's
+    RealtimeArena arena;
+    arena.Reserve<MIDIMessageQueue>("load_queue");
+    bool arena_ready = arena.Commit(true) == APC_SUCCESS;
+
+    LoadGenerator generator(transport, arena_ready ? &arena : nullptr);
+    std::vector<LoadRunResult> results(rates.size());
+
+    int knee = generator.SweepRates(profile, rates.data(), rates.size(), results.data());
+
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].messages_sent == 0 && results[i].saturated) {
+            printf("  %7u Hz | skipped (above knee)\n", results[i].target_rate_hz);
+            continue;
+        }
+        LoadGenerator::PrintResult(results[i]);
+    }
+
+    if (knee >= 0) {
+        printf("📈 Saturation knee: %u Hz sustained (p99 %lld us)\n",
+               results[knee].target_rate_hz, (long long)results[knee].latency_p99_us);
+    } else {
+        printf("⚠️  Saturated at the lowest rate (%u Hz)\n", rates[0]);
+    }
+}
+
+// Leave the simulated device and RTT prober idle and check that their
+// threads do not wake up more often than the budget allows
+static int RunIdleCheck(bigtime_t duration_us, double wakeup_budget)
+{
+    printf("\n💤 Idle wakeup check: %.1f s, budget %.1f wakeups/s per thread\n",
+           duration_us / 1000000.0, wakeup_budget);
+
+    SimulatedDeviceTransport simulated(SimulatedLinkModel::FullSpeedUSB());
+    RTTProber prober([&simulated](const uint8_t* data, size_t length) {
+        return simulated.SendSysEx(data, length);
+    });
+    simulated.SetSysExCallback([&prober](const uint8_t* data, size_t length) {
+        prober.HandleSysEx(data, length);
+    });
+
+    if (simulated.Open() != APC_SUCCESS) {
+        printf("❌ Cannot open simulated transport\n");
+        return 1;
+    }
+    prober.Start();
+
+    // Let the threads register, then measure from a clean sample
+    snooze(50000);
+    ThreadAccounting& accounting = ThreadAccounting::Default();
+    accounting.Sample(nullptr, 0);
+    snooze(duration_us);
+
+    ThreadUsage usage[ThreadAccounting::MAX_THREADS];
+    size_t count = accounting.Sample(usage, ThreadAccounting::MAX_THREADS);
+    ThreadAccounting::Print(stdout, usage, count);
+
+    int failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (usage[i].wakeups_per_sec > wakeup_budget) {
+            printf("❌ %s: %.1f wakeups/s over budget\n", usage[i].name, usage[i].wakeups_per_sec);
+            failures++;
+        }
+    }
+
+    MetricSample metric;
+    if (MetricsRegistry::Default().Find("thread.sim_delivery.wakeups_per_s", metric)) {
+        printf("📊 thread.sim_delivery.wakeups_per_s = %llu\n", (unsigned long long)metric.value);
+    }
+
+    prober.Stop();
+    simulated.Close();
+
+    if (count == 0) {
+        printf("❌ No threads registered for accounting\n");
+        return 1;
+    }
+    if (failures == 0) {
+        printf("✅ %zu idle threads within the wakeup budget\n", count);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    LoadProfile profile = LoadProfile::Default();
+    std::vector<uint32_t> rates(DEFAULT_RATES,
+                                DEFAULT_RATES + sizeof(DEFAULT_RATES) / sizeof(DEFAULT_RATES[0]));
+    bool run_loopback = true;
+    bool run_simulated = true;
+    bigtime_t idle_us = 0;
+    double wakeup_budget = 5.0;
+    const char* workload_name = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            run_loopback = strcmp(name, "loopback") == 0 || strcmp(name, "both") == 0;
+            run_simulated = strcmp(name, "simulated") == 0 || strcmp(name, "both") == 0;
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            profile.duration_us = atoll(argv[++i]) * 1000;
+        } else if (strcmp(argv[i], "--rates") == 0 && i + 1 < argc) {
+            if (!ParseRates(argv[++i], rates)) {
+                printf("❌ Invalid rate list\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            unsigned pad = 0, fader = 0, sysex = 0;
+            if (sscanf(argv[++i], "%u,%u,%u", &pad, &fader, &sysex) != 3 ||
+                pad + fader + sysex != 100) {
+                printf("❌ Mix must be three percentages adding up to 100\n");
+                return 1;
+            }
+            profile.pad_percent = pad;
+            profile.fader_percent = fader;
+            profile.sysex_percent = sysex;
+        } else if (strcmp(argv[i], "--poisson") == 0) {
+            profile.arrival = LOAD_ARRIVAL_POISSON;
+        } else if (strcmp(argv[i], "--poll") == 0 && i + 1 < argc) {
+            profile.dispatch_poll_us = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            workload_name = argv[++i];
+        } else if (strcmp(argv[i], "--idle") == 0 && i + 1 < argc) {
+            idle_us = atoll(argv[++i]) * 1000;
+        } else if (strcmp(argv[i], "--wakeup-budget") == 0 && i + 1 < argc) {
+            wakeup_budget = atof(argv[++i]);
+        } else {
+            PrintUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (idle_us > 0) {
+        return RunIdleCheck(idle_us, wakeup_budget);
+    }
+
+    if (!run_loopback && !run_simulated) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    printf("APC Mini Open-Loop Load Benchmark\n");
+    printf("=================================\n");
+    printf("Latency = dispatch time - intended send time (includes sender lag)\n");
+
+    // Same traffic as workload_bench and the other tools
+    if (workload_name) {
+        Workload workload;
+        char error[128];
+        if (!Workload::Resolve(workload_name, workload, error, sizeof(error))) {
+            printf("❌ Workload '%s': %s\n", workload_name, error);
+            return 1;
+        }
+
+        WorkloadReport reports[2];
+        size_t count = 0;
+        if (run_loopback) {
+            WorkloadDriver::Run(workload, "loopback", reports[count++]);
+        }
+        if (run_simulated) {
+            WorkloadDriver::Run(workload, "simulated", reports[count++]);
+        }
+        WorkloadDriver::PrintComparison(reports, count);
+        return 0;
+    }
+
+    if (run_loopback) {
+        LoopbackTransport loopback;
+        RunSweep(&loopback, profile, rates);
+    }
+
+    if (run_simulated) {
+        SimulatedDeviceTransport simulated(SimulatedLinkModel::FullSpeedUSB());
+        RunSweep(&simulated, profile, rates);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "metrics_registry.h"
+#include <string.h>
+
+MetricsRegistry::MetricsRegistry()
+    : entry_count(0)
+{
+}
+
+MetricsRegistry& MetricsRegistry::Default()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+bool MetricsRegistry::RegisterCounter(const char* name, const std::atomic<uint64_t>* counter)
+{
+    return Add(name, METRIC_COUNTER, counter);
+}
+
+bool MetricsRegistry::RegisterHistogram(const char* name, const LatencyHistogram* histogram)
+{
+    return Add(name, METRIC_HISTOGRAM, histogram);
+}
+
+bool MetricsRegistry::Add(const char* name, MetricKind kind, const void* storage)
+{
+    if (!name || !storage) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (size_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            // Re-registration replaces the previous owner
+            entries[i].kind = kind;
+            entries[i].storage = storage;
+            return true;
+        }
+    }
+
+    if (entry_count >= MAX_METRICS) {
+        return false;
+    }
+
+    entries[entry_count].name = name;
+    entries[entry_count].kind = kind;
+    entries[entry_count].storage = storage;
+    entry_count++;
+    return true;
+}
+
+void MetricsRegistry::Unregister(const void* storage)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entries[i].storage != storage) {
+            entries[kept++] = entries[i];
+        }
+    }
+    entry_count = kept;
+}
+
+void MetricsRegistry::Sample(const Entry& entry, MetricSample& sample)
+{
+    memset(&sample, 0, sizeof(sample));
+    sample.name = entry.name;
+    sample.kind = entry.kind;
+
+    if (entry.kind == METRIC_COUNTER) {
+        const std::atomic<uint64_t>* counter = static_cast<const std::atomic<uint64_t>*>(entry.storage);
+        sample.value = counter->load(std::memory_order_relaxed);
+    } else {
+        const LatencyHistogram* histogram = static_cast<const LatencyHistogram*>(entry.storage);
+        sample.value = histogram->Count();
+        sample.p50_us = histogram->Percentile(50.0);
+        sample.p99_us = histogram->Percentile(99.0);
+        sample.p999_us = histogram->Percentile(99.9);
+        sample.max_us = histogram->Max();
+        sample.mean_us = histogram->Mean();
+    }
+}
+
+size_t MetricsRegistry::Snapshot(MetricSample* samples, size_t max_samples) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    size_t count = entry_count < max_samples ? entry_count : max_samples;
+    for (size_t i = 0; i < count; i++) {
+        Sample(entries[i], samples[i]);
+    }
+    return count;
+}
+
+bool MetricsRegistry::Find(const char* name, MetricSample& sample) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (size_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            Sample(entries[i], sample);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MetricsRegistry::Print(FILE* out) const
+{
+    MetricSample samples[MAX_METRICS];
+    size_t count = Snapshot(samples, MAX_METRICS);
+
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i].kind == METRIC_COUNTER) {
+            fprintf(out, "  %-32s %llu\n", samples[i].name, (unsigned long long)samples[i].value);
+        } else {
+            fprintf(out, "  %-32s n=%llu p50=%lld p99=%lld p99.9=%lld max=%lld us\n",
+                    samples[i].name, (unsigned long long)samples[i].value,
+                    (long long)samples[i].p50_us, (long long)samples[i].p99_us,
+                    (long long)samples[i].p999_us, (long long)samples[i].max_us);
+        }
+    }
+}
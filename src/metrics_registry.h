@@ -0,0 +1,88 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+/*
+ * Metrics Registry
+ *
+ * Single place where long-running components publish their counters and
+ * latency histograms so the GUI, debug log and command-line tools can read
+ * them without knowing about each component:
+ *
+ * - Components own their metric storage (atomics, LatencyHistogram) and
+ *   register pointers under a dotted name, e.g. "usb.rtt_us"
+ * - Registration/unregistration is rare and takes a lock; the hot path only
+ *   updates the component's own atomics, never the registry
+ * - Readers take a Snapshot() (copies values under the lock)
+ *
+ * Components must Unregister() before their storage is destroyed.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+
+#include "apc_mini_platform.h"
+#include "latency_histogram.h"
+
+enum MetricKind {
+    METRIC_COUNTER = 0,
+    METRIC_HISTOGRAM = 1
+};
+
+// Copied value of one metric
+struct MetricSample {
+    const char* name;
+    MetricKind kind;
+    uint64_t value;          // Counter value or histogram sample count
+    bigtime_t p50_us;        // Histogram only
+    bigtime_t p99_us;
+    bigtime_t p999_us;
+    bigtime_t max_us;
+    double mean_us;
+};
+
+class MetricsRegistry {
+public:
+    static constexpr size_t MAX_METRICS = 128;
+
+    MetricsRegistry();
+
+    // Process-wide registry used by the application
+    static MetricsRegistry& Default();
+
+    bool RegisterCounter(const char* name, const std::atomic<uint64_t>* counter);
+    bool RegisterHistogram(const char* name, const LatencyHistogram* histogram);
+
+    // Remove every metric that points at the given storage
+    void Unregister(const void* storage);
+
+    /**
+     * Copy current values
+     *
+     * @return Number of samples written (at most max_samples)
+     */
+    size_t Snapshot(MetricSample* samples, size_t max_samples) const;
+
+    // Look up a single metric by name
+    bool Find(const char* name, MetricSample& sample) const;
+
+    void Print(FILE* out) const;
+
+private:
+    struct Entry {
+        const char* name;
+        MetricKind kind;
+        const void* storage;
+    };
+
+    bool Add(const char* name, MetricKind kind, const void* storage);
+    static void Sample(const Entry& entry, MetricSample& sample);
+
+    mutable std::mutex lock;
+    Entry entries[MAX_METRICS];
+    size_t entry_count;
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,213 @@
+#include "midi_coro.h"
+#include "midi_transport.h"
+
+static thread_local MIDICoroExecutor* current_executor = nullptr;
+
+void MIDICoroTask::promise_type::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept
+{
+    MIDICoroExecutor* executor = handle.promise().executor;
+    executor->active_tasks--;
+    executor->stats.tasks_finished++;
+    handle.destroy();
+}
+
+MIDICoroExecutor::MIDICoroExecutor()
+    : event_queue(nullptr)
+    , timer_order(0)
+    , active_tasks(0)
+    , stop_requested(false)
+    , stats()
+{
+}
+
+MIDICoroExecutor::~MIDICoroExecutor()
+{
+    // Every suspended task sits in exactly one of these lists
+    for (std::coroutine_handle<> handle : ready) {
+        handle.destroy();
+    }
+    while (!timers.empty()) {
+        timers.top().handle.destroy();
+        timers.pop();
+    }
+    for (const EventWaiter& waiter : event_waiters) {
+        waiter.handle.destroy();
+    }
+    for (const PendingBatch& batch : pending_batches) {
+        batch.handle.destroy();
+    }
+}
+
+MIDICoroExecutor* MIDICoroExecutor::Current()
+{
+    return current_executor;
+}
+
+void MIDICoroExecutor::Spawn(MIDICoroTask task)
+{
+    if (!task.handle) {
+        return;
+    }
+
+    task.handle.promise().executor = this;
+    ready.push_back(task.handle);
+    task.handle = nullptr;    // Executor owns the frame now
+
+    active_tasks++;
+    stats.tasks_spawned++;
+}
+
+void MIDICoroExecutor::AddTimer(bigtime_t when, std::coroutine_handle<> handle)
+{
+    timers.push(Timer{when, timer_order++, handle});
+}
+
+void MIDICoroExecutor::AddEventWaiter(EventAwaiter* awaiter, std::coroutine_handle<> handle)
+{
+    event_waiters.push_back(EventWaiter{awaiter, handle});
+}
+
+void MIDICoroExecutor::AddBatch(BatchAwaiter* awaiter, std::coroutine_handle<> handle)
+{
+    pending_batches.push_back(PendingBatch{awaiter, handle});
+}
+
+void MIDICoroExecutor::Resume(std::coroutine_handle<> handle)
+{
+    MIDICoroExecutor* previous = current_executor;
+    current_executor = this;
+    stats.resumes++;
+    handle.resume();
+    current_executor = previous;
+}
+
+void MIDICoroExecutor::DispatchEvent(const MIDIMessage& message)
+{
+    // Take the matching waiters out first: resumed tasks re-register for
+    // the next event, not this one
+    dispatching.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < event_waiters.size(); i++) {
+        if (event_waiters[i].awaiter->filter.ShouldAccept(message)) {
+            dispatching.push_back(event_waiters[i]);
+        } else {
+            event_waiters[kept++] = event_waiters[i];
+        }
+    }
+    event_waiters.resize(kept);
+
+    if (dispatching.empty()) {
+        stats.events_unclaimed++;
+        return;
+    }
+
+    for (size_t i = 0; i < dispatching.size(); i++) {
+        dispatching[i].awaiter->message = message;
+        stats.events_delivered++;
+        Resume(dispatching[i].handle);
+    }
+}
+
+size_t MIDICoroExecutor::RunOnce(bigtime_t now)
+{
+    const uint64_t resumes_before = stats.resumes;
+
+    // 1. Input events, in arrival order
+    if (event_queue) {
+        MIDIMessage message;
+        while (event_queue->Dequeue(message)) {
+            DispatchEvent(message);
+        }
+    }
+
+    // 2. Due timers
+    while (!timers.empty() && timers.top().when <= now) {
+        std::coroutine_handle<> handle = timers.top().handle;
+        timers.pop();
+        Resume(handle);
+    }
+
+    // 3. Batched sends, each frame one SendMIDIBatch() (as few transfers
+    //    as the transport can manage)
+    if (!pending_batches.empty()) {
+        sending.swap(pending_batches);
+        for (size_t i = 0; i < sending.size(); i++) {
+            BatchAwaiter* batch = sending[i].awaiter;
+            const size_t count = batch->frame.size();
+            wire_bytes.resize(count * 3);
+            for (size_t m = 0; m < count; m++) {
+                wire_bytes[m * 3] = batch->frame[m].status;
+                wire_bytes[m * 3 + 1] = batch->frame[m].data1;
+                wire_bytes[m * 3 + 2] = batch->frame[m].data2;
+            }
+            batch->result = batch->transport
+                ? batch->transport->SendMIDIBatch(
+                      reinterpret_cast<const uint8_t (*)[3]>(wire_bytes.data()), count)
+                : APC_ERROR_INVALID_PARAMETER;
+            if (batch->result == APC_SUCCESS) {
+                stats.messages_sent += count;
+            }
+            stats.batches_sent++;
+            Resume(sending[i].handle);
+        }
+        sending.clear();
+    }
+
+    // 4. Ready tasks (new spawns and yields); only those queued before this
+    //    step, so a task yielding in a loop cannot starve the others
+    size_t ready_count = ready.size();
+    while (ready_count-- > 0) {
+        std::coroutine_handle<> handle = ready.front();
+        ready.pop_front();
+        Resume(handle);
+    }
+
+    return static_cast<size_t>(stats.resumes - resumes_before);
+}
+
+bigtime_t MIDICoroExecutor::NextWakeTime(bigtime_t now, bigtime_t poll_us) const
+{
+    if (!ready.empty() || !pending_batches.empty()) {
+        return now;
+    }
+
+    bigtime_t wake = now + poll_us;
+    if (!timers.empty() && timers.top().when < wake) {
+        wake = timers.top().when;
+    }
+    return wake;
+}
+
+void MIDICoroExecutor::Run(bigtime_t poll_us)
+{
+    stop_requested = false;
+
+    while (!stop_requested && active_tasks > 0) {
+        bigtime_t now = system_time();
+        RunOnce(now);
+
+        bigtime_t wake = NextWakeTime(system_time(), poll_us);
+        if (wake > system_time()) {
+            snooze_until(wake, B_SYSTEM_TIMEBASE);
+        }
+    }
+}
+
+MIDICoroDevice::MIDICoroDevice(MIDICoroExecutor& coro_executor, MIDITransport* midi_transport,
+                               MIDIMessageQueue* event_inbox)
+    : executor(coro_executor)
+    , transport(midi_transport)
+    , inbox(event_inbox)
+{
+    executor.SetEventQueue(inbox);
+    transport->SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+        inbox->EnqueueMIDI(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
+    });
+}
+
+MIDICoroDevice::~MIDICoroDevice()
+{
+    transport->SetMIDICallback(nullptr);
+    executor.SetEventQueue(nullptr);
+}
@@ -0,0 +1,287 @@
+#ifndef MIDI_CORO_H
+#define MIDI_CORO_H
+
+/*
+ * Coroutine Client API (optional, C++20)
+ *
+ * Client code (test app, examples, tools) either registers callbacks that
+ * run on foreign threads or spawns a thread per script that snooze()s.
+ * With coroutines, interaction scripts and animations are written as
+ * straight-line code and hundreds of them share one thread:
+ *
+ *     MIDICoroTask PadEcho(MIDICoroDevice& device)
+ *     {
+ *         MIDIEventFilter pads;
+ *         pads.accept_cc = false;
+ *         for (;;) {
+ *             MIDIMessage press = co_await device.NextEvent(pads);
+ *             std::vector<MIDIBatchMessage> frame(1, {0x96, press.data1, 5});
+ *             co_await device.SendBatch(frame);
+ *             co_await SleepFor(100000);
+ *         }
+ *     }
+ *
+ * - MIDICoroExecutor is single-threaded and driven by the dispatch loop:
+ *   RunOnce() delivers queued input events to waiting tasks, fires due
+ *   timers, flushes batched sends and resumes ready tasks. Run() loops
+ *   RunOnce() and sleeps until the next timer or poll interval.
+ * - Input arrives from any thread through MIDIMessageQueue (the transport
+ *   callback enqueues), so tasks only ever run on the executor thread.
+ * - An event is delivered to every task waiting with a matching filter;
+ *   a task that immediately waits again sees the next event.
+ *
+ * Only built when compiling with -std=c++20 (see "make coro" in build/).
+ * Build frames as named vectors: GCC 12 rejects braced initializer lists
+ * inside co_await expressions.
+ */
+
+#if !defined(__cpp_impl_coroutine)
+#error "midi_coro.h requires C++20 coroutines (-std=c++20)"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <coroutine>
+#include <exception>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "midi_message_queue.h"
+#include "midi_event_filter.h"
+
+class MIDICoroExecutor;
+class MIDITransport;
+
+// Fire-and-forget task; started and owned by MIDICoroExecutor::Spawn()
+class MIDICoroTask {
+public:
+    struct promise_type {
+        MIDICoroExecutor* executor = nullptr;
+
+        MIDICoroTask get_return_object() {
+            return MIDICoroTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    MIDICoroTask(MIDICoroTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~MIDICoroTask() {
+        // Never spawned: nobody else owns the frame
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+private:
+    friend class MIDICoroExecutor;
+    explicit MIDICoroTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    std::coroutine_handle<promise_type> handle;
+
+    MIDICoroTask(const MIDICoroTask&) = delete;
+    MIDICoroTask& operator=(const MIDICoroTask&) = delete;
+};
+
+// One outbound short message in a batch
+struct MIDIBatchMessage {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+struct MIDICoroStats {
+    uint64_t tasks_spawned;
+    uint64_t tasks_finished;
+    uint64_t resumes;
+    uint64_t events_delivered;     // Task wake-ups from input events
+    uint64_t events_unclaimed;     // Input events no task was waiting for
+    uint64_t batches_sent;
+    uint64_t messages_sent;
+};
+
+class MIDICoroExecutor {
+public:
+    MIDICoroExecutor();
+    ~MIDICoroExecutor();     // Destroys tasks that are still suspended
+
+    // Input events are taken from this queue (any thread may enqueue)
+    void SetEventQueue(MIDIMessageQueue* queue) { event_queue = queue; }
+
+    void Spawn(MIDICoroTask task);
+
+    /**
+     * One dispatch-loop step: input events, due timers, batched sends,
+     * then every ready task
+     *
+     * @return Number of task resumptions
+     */
+    size_t RunOnce(bigtime_t now);
+    size_t RunOnce() { return RunOnce(system_time()); }
+
+    /**
+     * Drive the executor until every task has finished or Stop() is called
+     *
+     * @param poll_us Longest sleep while tasks wait for input events
+     */
+    void Run(bigtime_t poll_us = 1000);
+    void Stop() { stop_requested = true; }
+
+    size_t ActiveTasks() const { return active_tasks; }
+    MIDICoroStats GetStats() const { return stats; }
+
+    // Executor running the current task (valid inside a task only)
+    static MIDICoroExecutor* Current();
+
+    // ---- Awaitables ----
+
+    struct SleepAwaiter {
+        MIDICoroExecutor* executor;
+        bigtime_t wake_time;
+
+        bool await_ready() const { return wake_time <= system_time(); }
+        void await_suspend(std::coroutine_handle<> handle) { executor->AddTimer(wake_time, handle); }
+        void await_resume() const {}
+    };
+
+    struct YieldAwaiter {
+        MIDICoroExecutor* executor;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { executor->ready.push_back(handle); }
+        void await_resume() const {}
+    };
+
+    struct EventAwaiter {
+        MIDICoroExecutor* executor;
+        MIDIEventFilter filter;
+        MIDIMessage message;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { executor->AddEventWaiter(this, handle); }
+        MIDIMessage await_resume() const { return message; }
+    };
+
+    struct BatchAwaiter {
+        MIDICoroExecutor* executor;
+        MIDITransport* transport;
+        std::vector<MIDIBatchMessage> frame;
+        APCMiniError result;
+
+        bool await_ready() const { return frame.empty(); }
+        void await_suspend(std::coroutine_handle<> handle) { executor->AddBatch(this, handle); }
+        APCMiniError await_resume() const { return frame.empty() ? APC_SUCCESS : result; }
+    };
+
+    SleepAwaiter SleepUntil(bigtime_t when) { return SleepAwaiter{this, when}; }
+    YieldAwaiter Yield() { return YieldAwaiter{this}; }
+    EventAwaiter NextEvent(const MIDIEventFilter& filter = MIDIEventFilter()) {
+        return EventAwaiter{this, filter, MIDIMessage()};
+    }
+    BatchAwaiter SendBatch(MIDITransport* transport, std::vector<MIDIBatchMessage> frame) {
+        return BatchAwaiter{this, transport, std::move(frame), APC_SUCCESS};
+    }
+
+private:
+    friend struct MIDICoroTask::promise_type::FinalAwaiter;
+
+    struct Timer {
+        bigtime_t when;
+        uint64_t order;      // FIFO among equal wake times
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : order > other.order;
+        }
+    };
+
+    struct EventWaiter {
+        EventAwaiter* awaiter;
+        std::coroutine_handle<> handle;
+    };
+
+    struct PendingBatch {
+        BatchAwaiter* awaiter;
+        std::coroutine_handle<> handle;
+    };
+
+    void AddTimer(bigtime_t when, std::coroutine_handle<> handle);
+    void AddEventWaiter(EventAwaiter* awaiter, std::coroutine_handle<> handle);
+    void AddBatch(BatchAwaiter* awaiter, std::coroutine_handle<> handle);
+    void Resume(std::coroutine_handle<> handle);
+    void DispatchEvent(const MIDIMessage& message);
+    bigtime_t NextWakeTime(bigtime_t now, bigtime_t poll_us) const;
+
+    MIDIMessageQueue* event_queue;
+    std::deque<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::vector<EventWaiter> event_waiters;
+    std::vector<EventWaiter> dispatching;     // Reused scratch list
+    std::vector<PendingBatch> pending_batches;
+    std::vector<PendingBatch> sending;        // Reused scratch list
+    std::vector<uint8_t> wire_bytes;          // Frame being sent, 3 bytes per message
+
+    uint64_t timer_order;
+    size_t active_tasks;
+    bool stop_requested;
+    MIDICoroStats stats;
+
+    MIDICoroExecutor(const MIDICoroExecutor&) = delete;
+    MIDICoroExecutor& operator=(const MIDICoroExecutor&) = delete;
+};
+
+// Awaitables for the running task's executor
+inline MIDICoroExecutor::SleepAwaiter SleepUntil(bigtime_t when)
+{
+    return MIDICoroExecutor::Current()->SleepUntil(when);
+}
+
+inline MIDICoroExecutor::SleepAwaiter SleepFor(bigtime_t duration_us)
+{
+    return MIDICoroExecutor::Current()->SleepUntil(system_time() + duration_us);
+}
+
+inline MIDICoroExecutor::YieldAwaiter Yield()
+{
+    return MIDICoroExecutor::Current()->Yield();
+}
+
+/**
+ * Device facade for scripts: input events from the transport, batched
+ * sends back to it
+ *
+ * Installs the transport's MIDI callback (before Open(), as MIDITransport
+ * requires); the callback only enqueues, tasks run on the executor thread.
+ */
+class MIDICoroDevice {
+public:
+    MIDICoroDevice(MIDICoroExecutor& executor, MIDITransport* transport, MIDIMessageQueue* inbox);
+    ~MIDICoroDevice();
+
+    MIDICoroExecutor::EventAwaiter NextEvent(const MIDIEventFilter& filter = MIDIEventFilter()) {
+        return executor.NextEvent(filter);
+    }
+
+    MIDICoroExecutor::BatchAwaiter SendBatch(std::vector<MIDIBatchMessage> frame) {
+        return executor.SendBatch(transport, std::move(frame));
+    }
+
+private:
+    MIDICoroExecutor& executor;
+    MIDITransport* transport;
+    MIDIMessageQueue* inbox;
+};
+
+#endif // MIDI_CORO_H
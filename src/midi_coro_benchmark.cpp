@@ -0,0 +1,205 @@
+// Coroutine vs Thread-per-Task Benchmark
+// Measures the cost of switching between client tasks and the wake-up
+// accuracy of periodic animations, with coroutines on one executor thread
+// versus one thread per task.
+//
+// Usage: midi_coro_benchmark [--tasks <count>] [--switches <count>]
+//                            [--period <us>] [--frames <count>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+#include "midi_coro.h"
+#include "latency_histogram.h"
+
+static double Seconds(const struct timeval& tv)
+{
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double ProcessCPUSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return Seconds(usage.ru_utime) + Seconds(usage.ru_stime);
+}
+
+// ===============================
+// Switch cost
+// ===============================
+
+static MIDICoroTask YieldLoop(int switches)
+{
+    for (int i = 0; i < switches; i++) {
+        co_await Yield();
+    }
+}
+
+static double CoroutineSwitchNs(int tasks, int switches)
+{
+    MIDICoroExecutor executor;
+    for (int i = 0; i < tasks; i++) {
+        executor.Spawn(YieldLoop(switches));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    executor.Run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / executor.GetStats().resumes;
+}
+
+// Token ring: each thread waits for its turn, then wakes only the next one
+static double ThreadSwitchNs(int tasks, int switches)
+{
+    std::mutex lock;
+    std::vector<std::condition_variable> turn_changed(tasks);
+    int turn = 0;
+    long long handoffs = 0;
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int id = 0; id < tasks; id++) {
+        threads.emplace_back([&, id]() {
+            for (int i = 0; i < switches; i++) {
+                std::unique_lock<std::mutex> guard(lock);
+                turn_changed[id].wait(guard, [&]() { return turn == id; });
+                turn = (turn + 1) % tasks;
+                handoffs++;
+                turn_changed[turn].notify_one();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / handoffs;
+}
+
+// ===============================
+// Periodic animations
+// ===============================
+
+struct AnimationResult {
+    bigtime_t p50_us;
+    bigtime_t p99_us;
+    bigtime_t max_us;
+    double cpu_seconds;
+};
+
+static MIDICoroTask AnimationTask(int frames, bigtime_t period_us, bigtime_t start, LatencyHistogram* lateness)
+{
+    bigtime_t next = start;
+    for (int frame = 0; frame < frames; frame++) {
+        next += period_us;
+        co_await SleepUntil(next);
+        lateness->Record(system_time() - next);
+    }
+}
+
+static AnimationResult CoroutineAnimations(int tasks, int frames, bigtime_t period_us)
+{
+    LatencyHistogram lateness;
+    MIDICoroExecutor executor;
+    bigtime_t start = system_time();
+    for (int i = 0; i < tasks; i++) {
+        executor.Spawn(AnimationTask(frames, period_us, start + (i * period_us) / tasks, &lateness));
+    }
+
+    double cpu_before = ProcessCPUSeconds();
+    executor.Run();
+
+    AnimationResult result;
+    result.cpu_seconds = ProcessCPUSeconds() - cpu_before;
+    result.p50_us = lateness.Percentile(50.0);
+    result.p99_us = lateness.Percentile(99.0);
+    result.max_us = lateness.Max();
+    return result;
+}
+
+static AnimationResult ThreadAnimations(int tasks, int frames, bigtime_t period_us)
+{
+    LatencyHistogram lateness;
+    bigtime_t start = system_time();
+    double cpu_before = ProcessCPUSeconds();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < tasks; i++) {
+        bigtime_t first = start + (i * period_us) / tasks;
+        threads.emplace_back([&lateness, frames, period_us, first]() {
+            bigtime_t next = first;
+            for (int frame = 0; frame < frames; frame++) {
+                next += period_us;
+                snooze_until(next, B_SYSTEM_TIMEBASE);
+                lateness.Record(system_time() - next);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    AnimationResult result;
+    result.cpu_seconds = ProcessCPUSeconds() - cpu_before;
+    result.p50_us = lateness.Percentile(50.0);
+    result.p99_us = lateness.Percentile(99.0);
+    result.max_us = lateness.Max();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int tasks = 200;
+    int switches = 2000;
+    bigtime_t period_us = 5000;
+    int frames = 100;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tasks") == 0 && i + 1 < argc) {
+            tasks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--switches") == 0 && i + 1 < argc) {
+            switches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            period_us = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--tasks <count>] [--switches <count>] [--period <us>] [--frames <count>]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (tasks <= 0 || switches <= 0 || period_us <= 0 || frames <= 0) {
+        printf("❌ All options must be positive\n");
+        return 1;
+    }
+
+    printf("🌀 Coroutine vs Thread-per-Task Benchmark (%d tasks)\n\n", tasks);
+
+    // Thread ring hand-offs are slow; keep its run short
+    int thread_switches = switches / 10 > 0 ? switches / 10 : 1;
+    double coro_ns = CoroutineSwitchNs(tasks, switches);
+    double thread_ns = ThreadSwitchNs(tasks, thread_switches);
+    printf("Task switch:\n");
+    printf("   Coroutines (1 thread):   %10.1f ns/switch\n", coro_ns);
+    printf("   Threads (token ring):    %10.1f ns/switch (%.0fx)\n\n", thread_ns, thread_ns / coro_ns);
+
+    printf("Periodic animations (%d frames every %lld us):\n", frames, (long long)period_us);
+    AnimationResult coro = CoroutineAnimations(tasks, frames, period_us);
+    AnimationResult threads = ThreadAnimations(tasks, frames, period_us);
+    printf("   Coroutines: lateness p50 %5lld  p99 %6lld  max %6lld us | CPU %.3f s\n",
+           (long long)coro.p50_us, (long long)coro.p99_us, (long long)coro.max_us, coro.cpu_seconds);
+    printf("   Threads:    lateness p50 %5lld  p99 %6lld  max %6lld us | CPU %.3f s\n",
+           (long long)threads.p50_us, (long long)threads.p99_us, (long long)threads.max_us,
+           threads.cpu_seconds);
+    return 0;
+}
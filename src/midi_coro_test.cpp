@@ -0,0 +1,182 @@
+/*
+ * Coroutine Client API Test
+ * Runs interaction scripts and animations as coroutines on one executor
+ */
+
+#include "midi_coro.h"
+#include "midi_transport.h"
+#include <stdio.h>
+#include <assert.h>
+#include <vector>
+
+// Loopback that counts how many batch calls the executor makes
+class BatchCountingTransport : public LoopbackTransport {
+public:
+    int batch_calls = 0;
+
+    APCMiniError SendMIDIBatch(const uint8_t (*messages)[3], size_t count) override {
+        batch_calls++;
+        return LoopbackTransport::SendMIDIBatch(messages, count);
+    }
+};
+
+// Counts destroyed frames (a local of this type lives in each task)
+struct FrameGuard {
+    int* destroyed;
+    ~FrameGuard() { (*destroyed)++; }
+};
+
+static MIDICoroTask SleepThenRecord(bigtime_t delay_us, int id, std::vector<int>* order)
+{
+    co_await SleepFor(delay_us);
+    order->push_back(id);
+}
+
+void test_sleep_ordering()
+{
+    printf("Testing SleepFor ordering on one thread...\n");
+
+    MIDICoroExecutor executor;
+    std::vector<int> order;
+    executor.Spawn(SleepThenRecord(30000, 3, &order));
+    executor.Spawn(SleepThenRecord(10000, 1, &order));
+    executor.Spawn(SleepThenRecord(20000, 2, &order));
+    assert(executor.ActiveTasks() == 3);
+
+    bigtime_t start = system_time();
+    executor.Run();
+    bigtime_t elapsed = system_time() - start;
+
+    assert(order.size() == 3);
+    assert(order[0] == 1 && order[1] == 2 && order[2] == 3);
+    assert(elapsed >= 30000);
+    assert(executor.ActiveTasks() == 0);
+    assert(executor.GetStats().tasks_finished == 3);
+
+    printf("✅ Tasks woke in deadline order (%lld us)\n", (long long)elapsed);
+}
+
+static MIDICoroTask PadScript(MIDICoroDevice* device, int presses, std::vector<uint8_t>* seen)
+{
+    MIDIEventFilter pads;
+    pads.accept_cc = false;
+    pads.min_velocity = 1;
+
+    for (int i = 0; i < presses; i++) {
+        MIDIMessage press = co_await device->NextEvent(pads);
+        seen->push_back(press.data1);
+    }
+}
+
+static MIDICoroTask Player(MIDICoroDevice* device, APCMiniError* result)
+{
+    // CC must not wake the pad script; the frame is one batch call
+    std::vector<MIDIBatchMessage> frame;
+    frame.push_back({0xB0, 48, 10});
+    frame.push_back({0x90, 5, 127});
+    frame.push_back({0x90, 6, 127});
+    *result = co_await device->SendBatch(frame);
+
+    co_await SleepFor(1000);
+    frame.assign(1, {0x90, 7, 127});
+    co_await device->SendBatch(frame);
+}
+
+void test_events_and_batches()
+{
+    printf("Testing NextEvent filters and SendBatch over loopback...\n");
+
+    MIDICoroExecutor executor;
+    BatchCountingTransport transport;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    {
+        MIDICoroDevice device(executor, &transport, inbox);
+        assert(transport.Open() == APC_SUCCESS);
+
+        std::vector<uint8_t> seen;
+        APCMiniError result = APC_ERROR_TIMEOUT;
+        executor.Spawn(PadScript(&device, 3, &seen));
+        executor.Spawn(Player(&device, &result));
+        executor.Run(500);
+
+        assert(result == APC_SUCCESS);
+        assert(seen.size() == 3);
+        assert(seen[0] == 5 && seen[1] == 6 && seen[2] == 7);
+
+        MIDICoroStats stats = executor.GetStats();
+        assert(stats.batches_sent == 2);
+        assert(stats.messages_sent == 4);
+        assert(transport.batch_calls == 2);
+        assert(stats.events_unclaimed == 1);    // The CC
+
+        transport.Close();
+    }
+    delete inbox;
+
+    printf("✅ Scripts see only matching events, in order\n");
+}
+
+static MIDICoroTask Animation(int frames, bigtime_t period_us, int* completed)
+{
+    bigtime_t next = system_time();
+    for (int frame = 0; frame < frames; frame++) {
+        next += period_us;
+        co_await SleepUntil(next);
+    }
+    (*completed)++;
+}
+
+void test_many_tasks()
+{
+    printf("Testing 500 concurrent animations on one thread...\n");
+
+    MIDICoroExecutor executor;
+    int completed = 0;
+    for (int i = 0; i < 500; i++) {
+        executor.Spawn(Animation(10, 2000 + (i % 7) * 100, &completed));
+    }
+    executor.Run();
+
+    assert(completed == 500);
+    assert(executor.GetStats().tasks_finished == 500);
+    printf("✅ All animations finished (%llu resumes)\n",
+           (unsigned long long)executor.GetStats().resumes);
+}
+
+static MIDICoroTask Waiter(MIDICoroExecutor* executor, int* destroyed)
+{
+    FrameGuard guard{destroyed};
+    co_await executor->NextEvent();
+}
+
+void test_shutdown_destroys_suspended_tasks()
+{
+    printf("Testing executor shutdown with suspended tasks...\n");
+
+    int destroyed = 0;
+    {
+        MIDICoroExecutor executor;
+        executor.Spawn(Waiter(&executor, &destroyed));
+        executor.Spawn(Waiter(&executor, &destroyed));
+        executor.RunOnce();
+        assert(executor.ActiveTasks() == 2);
+        assert(destroyed == 0);
+    }
+    assert(destroyed == 2);
+
+    printf("✅ Suspended frames released\n");
+}
+
+int main()
+{
+    printf("🌀 Coroutine Client API Test\n");
+    printf("============================\n\n");
+
+    test_sleep_ordering();
+    test_events_and_batches();
+    test_many_tasks();
+    test_shutdown_destroys_suspended_tasks();
+
+    printf("\n🎉 ALL TESTS PASSED! Coroutine scripts run on one executor.\n");
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * MIDI Event Filter for APC Mini
+ *
+ * Message type, velocity and source filter shared by the dynamic callback
+ * registry (MIDIEventHandler) and the statically composed pipeline
+ * (midi_pipeline.h). Kept free of Be API headers so both the Haiku GUI and
+ * the portable tools can use it.
+ */
+
+#ifndef MIDI_EVENT_FILTER_H
+#define MIDI_EVENT_FILTER_H
+
+#include <stdint.h>
+#include "midi_message_queue.h"
+
+// Event filter for selective processing
+struct MIDIEventFilter {
+    bool accept_note_on = true;
+    bool accept_note_off = true;
+    bool accept_cc = true;
+    bool accept_sysex = true;
+    bool accept_gestures = true;     // Synthesized by GestureRecognizer
+    bool accept_from_hardware = true;
+    bool accept_from_gui = true;
+    uint8_t min_velocity = 0;
+    uint8_t max_velocity = 127;
+
+    bool ShouldAccept(const MIDIMessage& msg) const;
+};
+
+inline bool MIDIEventFilter::ShouldAccept(const MIDIMessage& msg) const
+{
+    // Gestures are not wire messages; only their own flag applies
+    if (msg.source == MIDI_SOURCE_GESTURE) {
+        return accept_gestures;
+    }
+
+    // Check message type
+    uint8_t status = msg.status & 0xF0;
+    switch (status) {
+        case 0x90: // Note On
+            if (!accept_note_on) return false;
+            if (msg.data2 < min_velocity || msg.data2 > max_velocity) return false;
+            break;
+        case 0x80: // Note Off
+            if (!accept_note_off) return false;
+            break;
+        case 0xB0: // Control Change
+            if (!accept_cc) return false;
+            break;
+        case 0xF0: // SysEx
+            if (!accept_sysex) return false;
+            break;
+    }
+
+    // Check source
+    switch (msg.source) {
+        case MIDI_SOURCE_HARDWARE_USB:
+        case MIDI_SOURCE_HARDWARE_MIDI:
+            if (!accept_from_hardware) return false;
+            break;
+        case MIDI_SOURCE_GUI:
+            if (!accept_from_gui) return false;
+            break;
+    }
+
+    return true;
+}
+
+#endif // MIDI_EVENT_FILTER_H
@@ -3,48 +3,21 @@
  */
 
 #include "midi_event_handler.h"
+#include "gesture_recognizer.h"
+#include "latency_watchdog.h"
+#include "thread_accounting.h"
 #include <algorithm>
 #include <chrono>
 
-// MIDIEventFilter implementation
-bool MIDIEventFilter::ShouldAccept(const MIDIMessage& msg) const
-{
-    // Check message type
-    uint8_t status = msg.status & 0xF0;
-    switch (status) {
-        case 0x90: // Note On
-            if (!accept_note_on) return false;
-            if (msg.data2 < min_velocity || msg.data2 > max_velocity) return false;
-            break;
-        case 0x80: // Note Off
-            if (!accept_note_off) return false;
-            break;
-        case 0xB0: // Control Change
-            if (!accept_cc) return false;
-            break;
-        case 0xF0: // SysEx
-            if (!accept_sysex) return false;
-            break;
-    }
-
-    // Check source
-    switch (msg.source) {
-        case MIDI_SOURCE_HARDWARE_USB:
-        case MIDI_SOURCE_HARDWARE_MIDI:
-            if (!accept_from_hardware) return false;
-            break;
-        case MIDI_SOURCE_GUI:
-            if (!accept_from_gui) return false;
-            break;
-    }
-
-    return true;
-}
-
 // MIDIEventHandler implementation
 MIDIEventHandler::MIDIEventHandler(const char* name)
     : BHandler(name)
     , message_queue(nullptr)
+    , gesture_recognizer(nullptr)
+    , gesture_queue(nullptr)
+    , latency_watchdog(nullptr)
+    , watchdog_dispatch_budget(-1)
+    , watchdog_heartbeat(-1)
 {
     // Initialize priority map with defaults
     for (int i = 0; i < 128; i++) {
@@ -55,6 +28,7 @@ MIDIEventHandler::MIDIEventHandler(const char* name)
 MIDIEventHandler::~MIDIEventHandler()
 {
     callbacks.clear();
+    batch_callbacks.clear();
 }
 
 void MIDIEventHandler::MessageReceived(BMessage* message)
@@ -62,21 +36,15 @@ void MIDIEventHandler::MessageReceived(BMessage* message)
     switch (message->what) {
         case MSG_MIDI_EVENT:
         {
-            // Extract MIDI message from BMessage
-            int32 status, data1, data2, source;
-            if (message->FindInt32("status", &status) == B_OK &&
-                message->FindInt32("data1", &data1) == B_OK &&
-                message->FindInt32("data2", &data2) == B_OK &&
-                message->FindInt32("source", &source) == B_OK) {
-
+            // Packed batch (see MIDIMessageQueue::CreateBMessage)
+            MIDIMessageBatch batch;
+            if (MIDIMessageQueue::ExtractBatchFromBMessage(message, batch)) {
                 MIDIMessage midi_msg;
-                midi_msg.status = status;
-                midi_msg.data1 = data1;
-                midi_msg.data2 = data2;
-                midi_msg.source = static_cast<MIDIMessageSource>(source);
-                midi_msg.timestamp = system_time();
-
-                ProcessMessage(midi_msg);
+                for (size_t i = 0; i < batch.Count(); i++) {
+                    batch.Get(i, midi_msg);
+                    ProcessMessage(midi_msg);
+                }
+                FlushBatchCallbacks();
             }
             break;
         }
@@ -159,6 +127,23 @@ MIDIEventHandler::CallbackID MIDIEventHandler::RegisterCallback(
     return entry.id;
 }
 
+MIDIEventHandler::CallbackID MIDIEventHandler::RegisterBatchCallback(
+    MIDIBatchCallback callback, const MIDIEventFilter& filter)
+{
+    if (callbacks.size() + batch_callbacks.size() >= MAX_CALLBACKS) {
+        return 0; // Maximum callbacks reached
+    }
+
+    BatchCallbackEntry entry;
+    entry.id = next_callback_id.fetch_add(1);
+    entry.callback = callback;
+    entry.filter = filter;
+    entry.enabled = true;
+
+    batch_callbacks.push_back(entry);
+    return entry.id;
+}
+
 void MIDIEventHandler::UnregisterCallback(CallbackID id)
 {
     auto it = std::find_if(callbacks.begin(), callbacks.end(),
@@ -166,6 +151,14 @@ void MIDIEventHandler::UnregisterCallback(CallbackID id)
 
     if (it != callbacks.end()) {
         callbacks.erase(it);
+        return;
+    }
+
+    auto batch_it = std::find_if(batch_callbacks.begin(), batch_callbacks.end(),
+        [id](const BatchCallbackEntry& entry) { return entry.id == id; });
+
+    if (batch_it != batch_callbacks.end()) {
+        batch_callbacks.erase(batch_it);
     }
 }
 
@@ -176,6 +169,14 @@ void MIDIEventHandler::SetCallbackEnabled(CallbackID id, bool enabled)
 
     if (it != callbacks.end()) {
         it->enabled = enabled;
+        return;
+    }
+
+    auto batch_it = std::find_if(batch_callbacks.begin(), batch_callbacks.end(),
+        [id](const BatchCallbackEntry& entry) { return entry.id == id; });
+
+    if (batch_it != batch_callbacks.end()) {
+        batch_it->enabled = enabled;
     }
 }
 
@@ -188,16 +189,43 @@ void MIDIEventHandler::ProcessPendingEvents()
     const int max_batch = 32; // Process max 32 messages per call to maintain responsiveness
 
     while (processed < max_batch && message_queue->Dequeue(message)) {
+        if (latency_watchdog && message.timestamp > 0) {
+            bigtime_t waited = system_time() - message.timestamp;
+            latency_watchdog->ReportLatency(watchdog_dispatch_budget, waited);
+            FlightRecorder::Default().Record(FLIGHT_EVENT_DISPATCH, (uint32_t)waited,
+                                             message.status, message.data1, message.data2);
+        }
+        if (gesture_recognizer) {
+            gesture_recognizer->Observe(message);
+        }
         ProcessMessage(message);
         processed++;
     }
 
+    // Gestures from this batch and from fired thresholds; this thread is
+    // the only producer and consumer of gesture_queue
+    if (gesture_recognizer) {
+        gesture_recognizer->Advance(system_time());
+    }
+    if (gesture_queue) {
+        while (gesture_queue->Dequeue(message)) {
+            ProcessMessage(message);
+        }
+    }
+
+    FlushBatchCallbacks();
+
     metrics.current_queue_depth = message_queue->GetQueueDepth();
+
+    if (latency_watchdog) {
+        latency_watchdog->Beat(watchdog_heartbeat);
+    }
 }
 
 void MIDIEventHandler::ProcessSingleEvent(const MIDIMessage& message)
 {
     ProcessMessage(message);
+    FlushBatchCallbacks();
 }
 
 void MIDIEventHandler::ProcessMessage(const MIDIMessage& message)
@@ -233,6 +261,31 @@ void MIDIEventHandler::ExecuteCallbacks(const MIDIMessage& message)
             }
         }
     }
+
+    for (auto& entry : batch_callbacks) {
+        if (entry.enabled && entry.filter.ShouldAccept(message)) {
+            if (entry.pending.IsFull()) {
+                FlushBatchCallbacks();
+            }
+            entry.pending.Add(message);
+        }
+    }
+}
+
+void MIDIEventHandler::FlushBatchCallbacks()
+{
+    for (auto& entry : batch_callbacks) {
+        if (entry.pending.IsEmpty()) {
+            continue;
+        }
+        try {
+            entry.callback(entry.pending);
+            metrics.callbacks_executed.fetch_add(1);
+        } catch (...) {
+            // Protect against callback exceptions
+        }
+        entry.pending.Clear();
+    }
 }
 
 bool MIDIEventHandler::ShouldProcessMessage(const MIDIMessage& message) const
@@ -317,6 +370,7 @@ const char* MIDIEventHandler::GetSourceName(MIDIMessageSource source)
         case MIDI_SOURCE_HARDWARE_MIDI: return "Hardware MIDI";
         case MIDI_SOURCE_GUI: return "GUI";
         case MIDI_SOURCE_SIMULATION: return "Simulation";
+        case MIDI_SOURCE_GESTURE: return "Gesture";
         default: return "Unknown";
     }
 }
@@ -435,6 +489,8 @@ int32 MIDIEventLooper::ProcessingThread(void* data)
 
 void MIDIEventLooper::ProcessingLoop()
 {
+    ScopedThreadAccounting accounting("midi_processing");
+
     while (!should_quit) {
         // Process pending MIDI events
         if (event_handler) {
@@ -443,5 +499,6 @@ void MIDIEventLooper::ProcessingLoop()
 
         // Sleep for the polling interval
         snooze(polling_interval_us.load());
+        ThreadAccounting::NoteWakeup();
     }
 }
\ No newline at end of file
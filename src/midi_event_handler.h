@@ -25,8 +25,13 @@
 #include <atomic>
 
 #include "midi_message_queue.h"
+#include "midi_message_batch.h"
+#include "midi_event_filter.h"
 #include "apc_mini_defs.h"
 
+class GestureRecognizer;
+class LatencyWatchdog;
+
 // Event priorities for real-time scheduling
 enum MIDIEventPriority {
     MIDI_PRIORITY_REALTIME = 0,    // System real-time messages (clock, start, stop)
@@ -39,19 +44,9 @@ enum MIDIEventPriority {
 // Event callback signature
 using MIDIEventCallback = std::function<void(const MIDIMessage&)>;
 
-// Event filter for selective processing
-struct MIDIEventFilter {
-    bool accept_note_on = true;
-    bool accept_note_off = true;
-    bool accept_cc = true;
-    bool accept_sysex = true;
-    bool accept_from_hardware = true;
-    bool accept_from_gui = true;
-    uint8_t min_velocity = 0;
-    uint8_t max_velocity = 127;
-
-    bool ShouldAccept(const MIDIMessage& msg) const;
-};
+// Batch callback: every accepted event of one processing pass at once,
+// e.g. to forward them in a single BMessage
+using MIDIBatchCallback = std::function<void(const MIDIMessageBatch&)>;
 
 // Performance metrics for monitoring
 struct MIDIEventMetrics {
@@ -117,6 +112,8 @@ public:
     using CallbackID = uint32_t;
     CallbackID RegisterCallback(MIDIEventCallback callback,
                                 const MIDIEventFilter& filter = MIDIEventFilter());
+    CallbackID RegisterBatchCallback(MIDIBatchCallback callback,
+                                     const MIDIEventFilter& filter = MIDIEventFilter());
     void UnregisterCallback(CallbackID id);
     void SetCallbackEnabled(CallbackID id, bool enabled);
 
@@ -136,6 +133,25 @@ public:
     void SetMessageQueue(MIDIMessageQueue* queue) { message_queue = queue; }
     MIDIMessageQueue* GetMessageQueue() const { return message_queue; }
 
+    // Gesture recognition: sees every dequeued event and is advanced once
+    // per ProcessPendingEvents() call (i.e. on the looper's poll interval).
+    // The recognizer must write to its own queue, not the input queue:
+    // Enqueue() is single-producer and the reader thread owns that side.
+    // Gestures are dispatched from gesture_queue in the same call.
+    void SetGestureRecognizer(GestureRecognizer* recognizer, MIDIMessageQueue* queue) {
+        gesture_recognizer = recognizer;
+        gesture_queue = queue;
+    }
+
+    // Latency watchdog: every dequeued event reports reader->dispatch time
+    // against dispatch_budget, and each ProcessPendingEvents() call beats
+    // the heartbeat (pass -1 to skip either)
+    void SetWatchdog(LatencyWatchdog* watchdog, int dispatch_budget, int heartbeat) {
+        latency_watchdog = watchdog;
+        watchdog_dispatch_budget = dispatch_budget;
+        watchdog_heartbeat = heartbeat;
+    }
+
     // Performance monitoring
     MIDIEventMetricsSnapshot GetMetrics() const;
     void ResetMetrics() { metrics.Reset(); }
@@ -158,15 +174,30 @@ private:
         bool enabled;
     };
 
+    struct BatchCallbackEntry {
+        CallbackID id;
+        MIDIBatchCallback callback;
+        MIDIEventFilter filter;
+        bool enabled;
+        MIDIMessageBatch pending;
+    };
+
     // Internal processing
     void ProcessMessage(const MIDIMessage& message);
     void ExecuteCallbacks(const MIDIMessage& message);
+    void FlushBatchCallbacks();
     bool ShouldProcessMessage(const MIDIMessage& message) const;
     void UpdateMetrics(const MIDIMessage& message, bigtime_t processing_time);
 
     // Member variables
     MIDIMessageQueue* message_queue;
+    GestureRecognizer* gesture_recognizer;
+    MIDIMessageQueue* gesture_queue;
+    LatencyWatchdog* latency_watchdog;
+    int watchdog_dispatch_budget;
+    int watchdog_heartbeat;
     std::vector<CallbackEntry> callbacks;
+    std::vector<BatchCallbackEntry> batch_callbacks;
     MIDIEventFilter global_filter;
     MIDIEventMetrics metrics;
     std::atomic<CallbackID> next_callback_id{1};
@@ -190,6 +221,8 @@ private:
  */
 class MIDIEventLooper : public BLooper {
 public:
+    static constexpr uint32_t DEFAULT_POLLING_INTERVAL_US = 1000;
+
     MIDIEventLooper(MIDIEventHandler* handler,
                     const char* name = "MIDIEventLooper",
                     int32 priority = B_REAL_TIME_DISPLAY_PRIORITY);
@@ -216,7 +249,7 @@ private:
     thread_id processing_thread;
     std::atomic<bool> is_processing{false};
     std::atomic<bool> should_quit{false};
-    std::atomic<uint32_t> polling_interval_us{1000}; // 1ms default
+    std::atomic<uint32_t> polling_interval_us{DEFAULT_POLLING_INTERVAL_US};
 };
 
 // Message constants for BMessage communication
@@ -0,0 +1,129 @@
+#ifndef MIDI_MESSAGE_BATCH_H
+#define MIDI_MESSAGE_BATCH_H
+
+/*
+ * Packed MIDI Message Batch
+ *
+ * Fixed-layout binary form of MIDIMessage for crossing thread/looper
+ * boundaries in a BMessage. A whole batch travels as ONE data field
+ * (MIDI_MSG_BATCH, AddData/FindData) instead of six string-keyed fields per
+ * message, so a crossing costs one name lookup and one copy no matter how
+ * many messages it carries. Every MIDIMessage field is kept, so a message
+ * comes out exactly as it went in: F0 summaries keep their sysex_length and
+ * priority, and status, data and source are stored as full bytes.
+ *
+ * Wire layout (host byte order, never leaves the process):
+ *
+ *   uint16 version | uint16 count | uint32 reserved     (8 bytes)
+ *   count x { int64 timestamp | uint32 sequence |
+ *             uint8 status, data1, data2, source |
+ *             uint16 sysex_length | uint8 priority |
+ *             uint8 reserved | uint32 reserved }      (24 bytes each)
+ *
+ * Only the used part is sent (PayloadSize()). Readers copy the payload
+ * out with LoadPayload(), which validates version and size, so field data
+ * alignment inside the BMessage does not matter.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "midi_message_queue.h"
+
+struct MIDIPackedMessage {
+    int64_t timestamp;
+    uint32_t sequence;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t source;
+    uint16_t sysex_length;
+    uint8_t priority;
+    uint8_t reserved0;
+    uint32_t reserved1;
+};
+
+static_assert(sizeof(MIDIPackedMessage) == 24, "MIDIPackedMessage layout changed");
+
+struct MIDIMessageBatch {
+    static constexpr uint16_t VERSION = 3;
+    static constexpr size_t MAX_MESSAGES = 64;
+    static constexpr size_t HEADER_SIZE = 8;
+    // BMessage type code for the field ('MIDb', spelled out to avoid multichar literals)
+    static constexpr uint32_t TYPE_CODE = ((uint32_t)'M' << 24) | ((uint32_t)'I' << 16) |
+                                          ((uint32_t)'D' << 8) | (uint32_t)'b';
+
+    uint16_t version;
+    uint16_t count;
+    uint32_t reserved;
+    MIDIPackedMessage messages[MAX_MESSAGES];
+
+    MIDIMessageBatch() : version(VERSION), count(0), reserved(0) {}
+
+    void Clear() { count = 0; }
+    bool IsEmpty() const { return count == 0; }
+    bool IsFull() const { return count >= MAX_MESSAGES; }
+    size_t Count() const { return count; }
+
+    // @return false if the batch is full
+    bool Add(const MIDIMessage& message) {
+        if (IsFull()) {
+            return false;
+        }
+        MIDIPackedMessage& packed = messages[count++];
+        packed.timestamp = message.timestamp;
+        packed.sequence = message.sequence;
+        packed.status = message.status;
+        packed.data1 = message.data1;
+        packed.data2 = message.data2;
+        packed.source = message.source;
+        packed.sysex_length = message.sysex_length;
+        packed.priority = message.priority;
+        packed.reserved0 = 0;
+        packed.reserved1 = 0;
+        return true;
+    }
+
+    void Get(size_t index, MIDIMessage& message) const {
+        const MIDIPackedMessage& packed = messages[index];
+        message = MIDIMessage();
+        message.timestamp = packed.timestamp;
+        message.sequence = packed.sequence;
+        message.status = packed.status;
+        message.data1 = packed.data1;
+        message.data2 = packed.data2;
+        message.source = packed.source;
+        message.sysex_length = packed.sysex_length;
+        message.priority = packed.priority;
+    }
+
+    // Bytes to send: header plus used entries
+    const void* Payload() const { return this; }
+    size_t PayloadSize() const { return HEADER_SIZE + count * sizeof(MIDIPackedMessage); }
+
+    // @return false (batch left empty) on a version or size mismatch
+    bool LoadPayload(const void* data, size_t size) {
+        count = 0;
+        if (!data || size < HEADER_SIZE) {
+            return false;
+        }
+
+        uint16_t header[2];
+        memcpy(header, data, sizeof(header));
+        if (header[0] != VERSION || header[1] > MAX_MESSAGES ||
+            size != HEADER_SIZE + header[1] * sizeof(MIDIPackedMessage)) {
+            return false;
+        }
+
+        memcpy(messages, static_cast<const uint8_t*>(data) + HEADER_SIZE,
+               header[1] * sizeof(MIDIPackedMessage));
+        count = header[1];
+        return true;
+    }
+};
+
+static_assert(offsetof(MIDIMessageBatch, messages) == MIDIMessageBatch::HEADER_SIZE,
+              "MIDIMessageBatch header layout changed");
+
+#endif // MIDI_MESSAGE_BATCH_H
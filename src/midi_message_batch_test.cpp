@@ -0,0 +1,157 @@
+/*
+ * MIDI Message Batch Test
+ * Packed layout round trip and payload validation
+ */
+
+#include "midi_message_batch.h"
+#include <stdio.h>
+#include <assert.h>
+#include <vector>
+
+static MIDIMessage MakeMessage(size_t i)
+{
+    MIDIMessage message(MIDI_NOTE_ON, (uint8_t)(i % 64), (uint8_t)(i % 128), MIDI_SOURCE_HARDWARE_USB,
+                        1000000 + (bigtime_t)i * 250);
+    message.sequence = 0x10000 + (uint32_t)i;
+    return message;
+}
+
+void test_round_trip()
+{
+    printf("Testing Add/Get round trip...\n");
+
+    MIDIMessageBatch batch;
+    assert(batch.IsEmpty() && batch.PayloadSize() == MIDIMessageBatch::HEADER_SIZE);
+
+    for (size_t i = 0; i < 3; i++) {
+        assert(batch.Add(MakeMessage(i)));
+    }
+    assert(batch.Count() == 3);
+    assert(batch.PayloadSize() == MIDIMessageBatch::HEADER_SIZE + 3 * sizeof(MIDIPackedMessage));
+
+    for (size_t i = 0; i < batch.Count(); i++) {
+        MIDIMessage expected = MakeMessage(i);
+        MIDIMessage message;
+        batch.Get(i, message);
+        assert(message.status == expected.status);
+        assert(message.data1 == expected.data1 && message.data2 == expected.data2);
+        assert(message.source == expected.source);
+        assert(message.timestamp == expected.timestamp);
+        assert(message.sequence == expected.sequence);
+    }
+
+    printf("✅ All fields survive packing\n");
+}
+
+void test_exact_fields()
+{
+    printf("Testing messages that are not plain MIDI 1.0...\n");
+
+    // MIDIEventHandler's SysEx summary: F0 with length and low priority
+    MIDIMessage sysex(0xF0, 0x47, 0x7F, MIDI_SOURCE_HARDWARE_MIDI, 2000);
+    sysex.sysex_length = 1200;
+    sysex.priority = 3;                    // MIDI_PRIORITY_LOW
+    sysex.sequence = 7;
+
+    // A bare data byte, a gesture marker (F5) with bytes above
+    // 0x7F, a realtime-priority note
+    MIDIMessage data_byte(0x45, 0x12, 0x34, MIDI_SOURCE_HARDWARE_USB, 3000);
+    MIDIMessage gesture(0xF5, 0x83, 0xFF, MIDI_SOURCE_GESTURE, 4000);
+    MIDIMessage urgent(MIDI_NOTE_ON, 5, 127, MIDI_SOURCE_SIMULATION, 5000);
+    urgent.priority = 0;                   // MIDI_PRIORITY_REALTIME
+
+    const MIDIMessage sent[] = { sysex, data_byte, gesture, urgent };
+    MIDIMessageBatch batch;
+    for (const MIDIMessage& message : sent) {
+        assert(batch.Add(message));
+    }
+
+    MIDIMessageBatch copy;
+    assert(copy.LoadPayload(batch.Payload(), batch.PayloadSize()));
+    for (size_t i = 0; i < copy.Count(); i++) {
+        MIDIMessage message;
+        copy.Get(i, message);
+        assert(message.status == sent[i].status);
+        assert(message.data1 == sent[i].data1 && message.data2 == sent[i].data2);
+        assert(message.source == sent[i].source && message.priority == sent[i].priority);
+        assert(message.sysex_length == sent[i].sysex_length);
+        assert(message.timestamp == sent[i].timestamp && message.sequence == sent[i].sequence);
+    }
+
+    printf("✅ SysEx summaries, data bytes and gestures come back unchanged\n");
+}
+
+void test_full_batch()
+{
+    printf("Testing a full batch...\n");
+
+    MIDIMessageBatch batch;
+    for (size_t i = 0; i < MIDIMessageBatch::MAX_MESSAGES; i++) {
+        assert(batch.Add(MakeMessage(i)));
+    }
+    assert(batch.IsFull());
+    assert(!batch.Add(MakeMessage(99)));
+    assert(batch.Count() == MIDIMessageBatch::MAX_MESSAGES);
+
+    batch.Clear();
+    assert(batch.IsEmpty() && batch.Add(MakeMessage(0)));
+
+    printf("✅ Add refuses messages beyond %zu\n", MIDIMessageBatch::MAX_MESSAGES);
+}
+
+void test_load_payload()
+{
+    printf("Testing payload copy and validation...\n");
+
+    MIDIMessageBatch source;
+    for (size_t i = 0; i < 10; i++) {
+        source.Add(MakeMessage(i));
+    }
+
+    // Copy through a misaligned buffer, as a BMessage field may be
+    std::vector<uint8_t> buffer(source.PayloadSize() + 1);
+    memcpy(buffer.data() + 1, source.Payload(), source.PayloadSize());
+
+    MIDIMessageBatch copy;
+    assert(copy.LoadPayload(buffer.data() + 1, source.PayloadSize()));
+    assert(copy.Count() == 10);
+    MIDIMessage message;
+    copy.Get(9, message);
+    assert(message.sequence == MakeMessage(9).sequence);
+
+    // Size must match the count in the header exactly
+    assert(!copy.LoadPayload(buffer.data() + 1, source.PayloadSize() - 1));
+    assert(copy.IsEmpty());
+    assert(!copy.LoadPayload(buffer.data() + 1, MIDIMessageBatch::HEADER_SIZE - 1));
+    assert(!copy.LoadPayload(nullptr, 0));
+
+    // Unknown version is rejected
+    uint16_t bad_version = MIDIMessageBatch::VERSION + 1;
+    memcpy(buffer.data() + 1, &bad_version, sizeof(bad_version));
+    assert(!copy.LoadPayload(buffer.data() + 1, source.PayloadSize()));
+
+    // Count beyond MAX_MESSAGES is rejected
+    MIDIMessageBatch oversized;
+    oversized.count = MIDIMessageBatch::MAX_MESSAGES + 1;
+    assert(!copy.LoadPayload(&oversized, sizeof(oversized)));
+
+    // An empty batch is valid
+    MIDIMessageBatch empty;
+    assert(copy.LoadPayload(empty.Payload(), empty.PayloadSize()) && copy.IsEmpty());
+
+    printf("✅ Malformed payloads leave the batch empty\n");
+}
+
+int main()
+{
+    printf("📦 MIDI Message Batch Test\n");
+    printf("==========================\n\n");
+
+    test_round_trip();
+    test_exact_fields();
+    test_full_batch();
+    test_load_payload();
+
+    printf("\n🎉 ALL TESTS PASSED! Packed batches round-trip correctly.\n");
+    return 0;
+}
@@ -1,14 +1,10 @@
 #include "midi_message_queue.h"
+#include "midi_message_batch.h"
 #include <cstring>
 #include <algorithm>
 
-// BMessage field name constants for MIDI message serialization
-const char* MIDI_MSG_STATUS = "midi:status";
-const char* MIDI_MSG_DATA1 = "midi:data1";
-const char* MIDI_MSG_DATA2 = "midi:data2";
-const char* MIDI_MSG_SOURCE = "midi:source";
-const char* MIDI_MSG_TIMESTAMP = "midi:timestamp";
-const char* MIDI_MSG_SEQUENCE = "midi:sequence";
+// BMessage field name for packed MIDI message batches
+const char* MIDI_MSG_BATCH = "midi:batch";
 
 MIDIMessageQueue::MIDIMessageQueue() {
     // Initialize buffer (defensive programming)
@@ -167,7 +163,7 @@ MIDIQueueStatsSnapshot MIDIMessageQueue::GetStatistics() const {
     snapshot.total_latency_us = stats.total_latency_us.load(RELAXED);
     snapshot.max_latency_us = stats.max_latency_us.load(RELAXED);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MIDI_SOURCE_COUNT; i++) {
         snapshot.source_counts[i] = stats.source_counts[i].load(RELAXED);
     }
 
@@ -187,7 +183,7 @@ void MIDIMessageQueue::ResetStatistics() {
     stats.total_latency_us.store(0, RELAXED);
     stats.max_latency_us.store(0, RELAXED);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MIDI_SOURCE_COUNT; i++) {
         stats.source_counts[i].store(0, RELAXED);
     }
 
@@ -196,37 +192,52 @@ void MIDIMessageQueue::ResetStatistics() {
     stats.overflow_events = 0;
 }
 
+#ifdef __HAIKU__
 BMessage* MIDIMessageQueue::CreateBMessage(const MIDIMessage& midi_msg, uint32 what) {
     BMessage* msg = new BMessage(what);
 
-    // Add MIDI message fields
-    msg->AddUInt8(MIDI_MSG_STATUS, midi_msg.status);
-    msg->AddUInt8(MIDI_MSG_DATA1, midi_msg.data1);
-    msg->AddUInt8(MIDI_MSG_DATA2, midi_msg.data2);
-    msg->AddUInt8(MIDI_MSG_SOURCE, midi_msg.source);
-    msg->AddInt64(MIDI_MSG_TIMESTAMP, midi_msg.timestamp);
-    msg->AddUInt32(MIDI_MSG_SEQUENCE, midi_msg.sequence);
+    MIDIMessageBatch batch;
+    batch.Add(midi_msg);
+    AddBatchToBMessage(msg, batch);
 
     return msg;
 }
 
+status_t MIDIMessageQueue::AddBatchToBMessage(BMessage* bmsg, const MIDIMessageBatch& batch) {
+    if (!bmsg) {
+        return B_BAD_VALUE;
+    }
+
+    // One fixed-size field: no per-message names, hashing or allocations
+    return bmsg->AddData(MIDI_MSG_BATCH, MIDIMessageBatch::TYPE_CODE,
+                         batch.Payload(), batch.PayloadSize(), true, 1);
+}
+
 bool MIDIMessageQueue::ExtractFromBMessage(BMessage* bmsg, MIDIMessage& midi_msg) {
+    MIDIMessageBatch batch;
+    if (!ExtractBatchFromBMessage(bmsg, batch) || batch.IsEmpty()) {
+        return false;
+    }
+
+    batch.Get(0, midi_msg);
+    return true;
+}
+
+bool MIDIMessageQueue::ExtractBatchFromBMessage(BMessage* bmsg, MIDIMessageBatch& batch) {
+    batch.Clear();
     if (!bmsg) {
         return false;
     }
 
-    // Extract MIDI message fields with type checking
-    if (bmsg->FindUInt8(MIDI_MSG_STATUS, &midi_msg.status) != B_OK ||
-        bmsg->FindUInt8(MIDI_MSG_DATA1, &midi_msg.data1) != B_OK ||
-        bmsg->FindUInt8(MIDI_MSG_DATA2, &midi_msg.data2) != B_OK ||
-        bmsg->FindUInt8(MIDI_MSG_SOURCE, &midi_msg.source) != B_OK ||
-        bmsg->FindInt64(MIDI_MSG_TIMESTAMP, &midi_msg.timestamp) != B_OK ||
-        bmsg->FindUInt32(MIDI_MSG_SEQUENCE, &midi_msg.sequence) != B_OK) {
+    const void* data = nullptr;
+    ssize_t size = 0;
+    if (bmsg->FindData(MIDI_MSG_BATCH, MIDIMessageBatch::TYPE_CODE, &data, &size) != B_OK) {
         return false;
     }
 
-    return true;
+    return batch.LoadPayload(data, static_cast<size_t>(size));
 }
+#endif
 
 void MIDIMessageQueue::UpdateLatencyStats(bigtime_t message_timestamp) {
     const bigtime_t current_time = system_time();
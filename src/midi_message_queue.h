@@ -1,11 +1,14 @@
 #ifndef MIDI_MESSAGE_QUEUE_H
 #define MIDI_MESSAGE_QUEUE_H
 
-#include <OS.h>
+#include "apc_mini_platform.h"
+#ifdef __HAIKU__
 #include <Message.h>
+#endif
 #include <atomic>
 #include <stdint.h>
 #include "apc_mini_defs.h"
+#include "ump.h"
 
 /**
  * MIDIMessageQueue - Lock-free ring buffer for real-time MIDI message handling
@@ -38,9 +41,12 @@ enum MIDIMessageSource {
     MIDI_SOURCE_HARDWARE_USB = 0,    // From USB Raw device
     MIDI_SOURCE_HARDWARE_MIDI = 1,   // From Haiku MIDI API
     MIDI_SOURCE_GUI = 2,             // From GUI interactions
-    MIDI_SOURCE_SIMULATION = 3       // From test simulation
+    MIDI_SOURCE_SIMULATION = 3,      // From test simulation
+    MIDI_SOURCE_GESTURE = 4          // Synthesized by GestureRecognizer
 };
 
+#define MIDI_SOURCE_COUNT 5
+
 // MIDI message structure optimized for cache efficiency
 struct MIDIMessage {
     uint8_t status;        // MIDI status byte (includes channel)
@@ -58,8 +64,28 @@ struct MIDIMessage {
     MIDIMessage(uint8_t s, uint8_t d1, uint8_t d2, MIDIMessageSource src, bigtime_t ts = 0)
         : status(s), data1(d1), data2(d2), source(static_cast<uint8_t>(src)),
           priority(2), sysex_length(0), timestamp(ts == 0 ? system_time() : ts), sequence(0) {}
+
+    // UMP word with the source as group (ump.h); UMP_NOOP for data bytes
+    uint32_t ToUMP() const {
+        return UMPFromMIDI1(source, status, data1, data2);
+    }
+
+    // Words that are not 32-bit MIDI 1.0 messages give status 0
+    static MIDIMessage FromUMP(uint32_t word, bigtime_t ts) {
+        MIDIMessage message;
+        if (UMPIsMIDI1(word)) {
+            message.status = UMPStatus(word);
+            message.data1 = UMPData1(word);
+            message.data2 = UMPData2(word);
+            message.source = UMPGroup(word);
+        }
+        message.timestamp = ts;
+        return message;
+    }
 };
 
+struct MIDIMessageBatch;
+
 // Queue statistics for performance monitoring
 struct MIDIQueueStats {
     std::atomic<uint64_t> messages_enqueued{0};    // Total messages added
@@ -68,7 +94,7 @@ struct MIDIQueueStats {
     std::atomic<uint64_t> max_queue_depth{0};      // Peak queue usage
     std::atomic<uint64_t> total_latency_us{0};     // Cumulative latency
     std::atomic<uint32_t> max_latency_us{0};       // Peak latency
-    std::atomic<uint32_t> source_counts[4]{0};     // Per-source message counts
+    std::atomic<uint32_t> source_counts[MIDI_SOURCE_COUNT]{0};  // Per-source message counts
 
     // Non-atomic stats (updated by consumer only)
     uint64_t last_reset_time;                      // When stats were last reset
@@ -83,7 +109,7 @@ struct MIDIQueueStatsSnapshot {
     uint64_t max_queue_depth;
     uint64_t total_latency_us;
     uint32_t max_latency_us;
-    uint32_t source_counts[4];
+    uint32_t source_counts[MIDI_SOURCE_COUNT];
     uint64_t last_reset_time;
     uint32_t overflow_events;
 };
@@ -186,11 +212,12 @@ public:
      */
     void ResetStatistics();
 
+#ifdef __HAIKU__
     /**
      * Create a BMessage for GUI updates
      *
-     * Converts MIDI message to Haiku BMessage format for thread-safe
-     * communication with GUI components.
+     * Packs the message into the single MIDI_MSG_BATCH data field
+     * (see midi_message_batch.h), as a batch of one.
      *
      * @param midi_msg MIDI message to convert
      * @param what Message code for BMessage
@@ -198,10 +225,18 @@ public:
      */
     static BMessage* CreateBMessage(const MIDIMessage& midi_msg, uint32 what);
 
+    /**
+     * Add a packed batch to a BMessage (one AddData call)
+     *
+     * @return B_OK, or the AddData error
+     */
+    static status_t AddBatchToBMessage(BMessage* bmsg, const MIDIMessageBatch& batch);
+
     /**
      * Extract MIDI message from BMessage
      *
-     * Reverse operation of CreateBMessage for receiving GUI messages.
+     * Reverse operation of CreateBMessage; returns the first message of
+     * the batch.
      *
      * @param bmsg BMessage to extract from
      * @param midi_msg Reference to store extracted MIDI message
@@ -209,6 +244,14 @@ public:
      */
     static bool ExtractFromBMessage(BMessage* bmsg, MIDIMessage& midi_msg);
 
+    /**
+     * Extract the whole packed batch (one FindData call)
+     *
+     * @return true if the field exists and has a valid layout
+     */
+    static bool ExtractBatchFromBMessage(BMessage* bmsg, MIDIMessageBatch& batch);
+#endif
+
 private:
     // Ring buffer storage (cache-aligned for performance)
     alignas(64) MIDIMessage buffer[MIDI_QUEUE_SIZE];
@@ -237,12 +280,7 @@ private:
     MIDIMessageQueue& operator=(const MIDIMessageQueue&) = delete;
 };
 
-// Constants for BMessage field names (used with CreateBMessage/ExtractFromBMessage)
-extern const char* MIDI_MSG_STATUS;
-extern const char* MIDI_MSG_DATA1;
-extern const char* MIDI_MSG_DATA2;
-extern const char* MIDI_MSG_SOURCE;
-extern const char* MIDI_MSG_TIMESTAMP;
-extern const char* MIDI_MSG_SEQUENCE;
+// BMessage field carrying a packed MIDIMessageBatch (CreateBMessage/ExtractFromBMessage)
+extern const char* MIDI_MSG_BATCH;
 
 #endif // MIDI_MESSAGE_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,271 @@
+/*
+ * Statically Composed MIDI Pipeline
+ *
+ * The dynamic path (reader std::function -> SubmitEvent -> queue ->
+ * ProcessMessage -> one std::function per registered callback) pays several
+ * indirect calls and copies per event. For the fixed production chain
+ * (filter -> transform -> state update -> UI inbox) the stages are known at
+ * compile time, so here they are types held in a std::tuple and run with a
+ * fold expression: the compiler sees every stage body and inlines the whole
+ * chain into a single function with no indirect calls.
+ *
+ * A stage is any copyable type with
+ *
+ *     bool Process(MIDIMessage& message);
+ *
+ * returning false to drop the message (later stages are skipped). Stages may
+ * rewrite the message in place.
+ *
+ * RegistryStage and CallbackStage connect a static pipeline to the dynamic
+ * callback registry (MIDIEventHandler) or to any std::function when runtime
+ * registration is needed; that one stage pays the indirect call, the rest
+ * stay fused.
+ */
+
+#ifndef MIDI_PIPELINE_H
+#define MIDI_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+#include "midi_message_queue.h"
+#include "midi_event_filter.h"
+#include "apc_device_profile.h"
+#include "led_echo_rules.h"
+#include "ingress_dedup.h"
+
+// ===============================
+// Filter stages
+// ===============================
+
+// Bit for a channel voice/system status nibble (0x8-0xF) in a type mask
+constexpr uint8_t MIDIStatusBit(uint8_t status) {
+    return static_cast<uint8_t>(1u << (((status & 0xF0) >> 4) - 8));
+}
+
+constexpr uint8_t MIDI_TYPES_APC_INPUT =
+    MIDIStatusBit(0x80) | MIDIStatusBit(0x90) | MIDIStatusBit(0xB0) | MIDIStatusBit(0xF0);
+
+// Accepts status types in the compile-time mask (one AND per event)
+template<uint8_t TypeMask>
+struct StatusFilterStage {
+    bool Process(MIDIMessage& message) const {
+        return message.status >= 0x80 && (MIDIStatusBit(message.status) & TypeMask) != 0;
+    }
+};
+
+// Runtime-configurable filter, same rules as MIDIEventHandler's callbacks
+struct EventFilterStage {
+    MIDIEventFilter filter;
+
+    bool Process(MIDIMessage& message) const {
+        return filter.ShouldAccept(message);
+    }
+};
+
+// ===============================
+// Transform stages
+// ===============================
+
+// Note On with velocity 0 becomes Note Off, so later stages see one form
+struct NoteOffNormalizeStage {
+    bool Process(MIDIMessage& message) const {
+        if ((message.status & 0xF0) == MIDI_NOTE_ON && message.data2 == 0) {
+            message.status = static_cast<uint8_t>(MIDI_NOTE_OFF | (message.status & 0x0F));
+        }
+        return true;
+    }
+};
+
+// ===============================
+// State update stage
+// ===============================
+
+// Last value seen per note/controller (single writer, any-thread readers)
+struct PipelineControlState {
+    std::atomic<uint8_t> note_values[128];
+    std::atomic<uint8_t> cc_values[128];
+    std::atomic<uint32_t> updates;
+
+    PipelineControlState() : updates(0) {
+        for (int i = 0; i < 128; i++) {
+            note_values[i].store(0, std::memory_order_relaxed);
+            cc_values[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Records notes and CCs the device profile knows; drops everything else
+template<typename Device>
+struct ControlStateStage {
+    PipelineControlState* state;
+
+    bool Process(MIDIMessage& message) const {
+        const uint8_t type = message.status & 0xF0;
+        const uint8_t number = message.data1 & 0x7F;
+
+        if (type == MIDI_NOTE_ON || type == MIDI_NOTE_OFF) {
+            if (Device::ClassifyNote(number).control_class == APC_CONTROL_NONE) {
+                return false;
+            }
+            state->note_values[number].store(type == MIDI_NOTE_ON ? message.data2 : 0,
+                                             std::memory_order_relaxed);
+        } else if (type == MIDI_CONTROL_CHANGE) {
+            if (Device::ClassifyCC(number).control_class == APC_CONTROL_NONE) {
+                return false;
+            }
+            state->cc_values[number].store(message.data2, std::memory_order_relaxed);
+        } else {
+            return true;
+        }
+
+        state->updates.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+// ===============================
+// Sink stages
+// ===============================
+
+// Hands the message to a consumer thread (e.g. the UI) through a queue
+struct QueueInboxStage {
+    MIDIMessageQueue* inbox;
+
+    bool Process(MIDIMessage& message) const {
+        return inbox->Enqueue(message);
+    }
+};
+
+// Bridge to the dynamic callback registry; Registry is MIDIEventHandler or
+// anything with ProcessSingleEvent(const MIDIMessage&)
+template<typename Registry>
+struct RegistryStage {
+    Registry* registry;
+
+    bool Process(MIDIMessage& message) const {
+        registry->ProcessSingleEvent(message);
+        return true;
+    }
+};
+
+// Bridge to an arbitrary runtime callback
+struct CallbackStage {
+    std::function<void(const MIDIMessage&)> callback;
+
+    bool Process(MIDIMessage& message) const {
+        if (callback) {
+            callback(message);
+        }
+        return true;
+    }
+};
+
+// ===============================
+// Pipeline
+// ===============================
+
+template<typename... Stages>
+class MIDIPipeline {
+public:
+    static constexpr size_t STAGE_COUNT = sizeof...(Stages);
+
+    explicit MIDIPipeline(Stages... pipeline_stages)
+        : stages(std::move(pipeline_stages)...)
+    {
+    }
+
+    /**
+     * Run a message through every stage (inlined, no allocation)
+     *
+     * @return true if the message passed all stages
+     */
+    bool Push(MIDIMessage& message) {
+        return Run(message, std::index_sequence_for<Stages...>{});
+    }
+
+    bool Push(uint8_t status, uint8_t data1, uint8_t data2,
+              MIDIMessageSource source = MIDI_SOURCE_HARDWARE_USB) {
+        MIDIMessage message(status, data1, data2, source);
+        return Push(message);
+    }
+
+    /**
+     * Run every MIDI 1.0 word of a UMP array through the stages; the group
+     * is the source (ump.h). SysEx7 and other packets are stepped over.
+     *
+     * @return Number of messages that passed all stages
+     */
+    size_t PushUMP(const uint32_t* words, size_t count, bigtime_t timestamp = 0) {
+        if (timestamp == 0) {
+            timestamp = system_time();
+        }
+        size_t passed = 0;
+        size_t index = 0;
+        while (index < count) {
+            if (UMPIsMIDI1(words[index])) {
+                MIDIMessage message = MIDIMessage::FromUMP(words[index], timestamp);
+                passed += Push(message) ? 1 : 0;
+            }
+            index += UMPWordCount(words[index]);
+        }
+        return passed;
+    }
+
+    // A whole pipeline is itself a stage, so chains nest (see staged_pipeline.h)
+    bool Process(MIDIMessage& message) {
+        return Push(message);
+    }
+
+    template<size_t Index>
+    auto& Stage() { return std::get<Index>(stages); }
+
+private:
+    template<size_t... Index>
+    bool Run(MIDIMessage& message, std::index_sequence<Index...>) {
+        // && folds left to right and stops at the first stage returning false
+        return (std::get<Index>(stages).Process(message) && ...);
+    }
+
+    std::tuple<Stages...> stages;
+};
+
+template<typename... Stages>
+MIDIPipeline<Stages...> MakeMIDIPipeline(Stages... stages)
+{
+    return MIDIPipeline<Stages...>(std::move(stages)...);
+}
+
+// Production input chain: filter -> transform -> state update -> LED echo
+// -> dedup -> UI inbox. The echo stage lights feedback LEDs from the reader
+// thread (led_echo_rules.h); the dedup stage drops the copy of an event
+// that already arrived over another source (ingress_dedup.h). Dedup comes
+// last so the reader's state and echo see every event even when the MIDI
+// Kit copy, which bypasses this chain, wins the race: only the UI inbox
+// must see an event once. Either one left null only passes the message on.
+template<typename Device>
+using APCInputPipeline = MIDIPipeline<StatusFilterStage<MIDI_TYPES_APC_INPUT>,
+                                      NoteOffNormalizeStage,
+                                      ControlStateStage<Device>,
+                                      LEDEchoStage,
+                                      IngressDedupStage,
+                                      QueueInboxStage>;
+
+template<typename Device>
+APCInputPipeline<Device> MakeAPCInputPipeline(PipelineControlState* state, MIDIMessageQueue* inbox,
+                                              LEDEchoRules* echo_rules = nullptr,
+                                              IngressDeduplicator* dedup = nullptr)
+{
+    return APCInputPipeline<Device>(StatusFilterStage<MIDI_TYPES_APC_INPUT>(),
+                                    NoteOffNormalizeStage(),
+                                    ControlStateStage<Device>{state},
+                                    LEDEchoStage{echo_rules},
+                                    IngressDedupStage{dedup},
+                                    QueueInboxStage{inbox});
+}
+
+#endif // MIDI_PIPELINE_H
@@ -0,0 +1,319 @@
+// MIDI Pipeline Benchmark
+// Compares ns/event of the statically composed input pipeline with the
+// dynamic path (SubmitEvent -> queue -> ProcessMessage -> std::function
+// callbacks) for the same APC Mini MK2 input stream.
+//
+// MIDIEventHandler derives from BHandler, so on non-Haiku builds the dynamic
+// path is reproduced by DynamicHandlerModel below, which mirrors
+// SubmitEvent(), ProcessMessage() and ExecuteCallbacks() step for step.
+//
+// Usage: midi_pipeline_benchmark [--events <count>] [--rounds <count>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "midi_pipeline.h"
+#include "midi_message_queue.h"
+
+typedef APCMiniMK2Device BenchDevice;
+
+static const size_t BATCH_SIZE = 1024;      // Well below queue capacity
+
+// ===============================
+// Dynamic path model
+// ===============================
+
+class DynamicHandlerModel {
+public:
+    typedef std::function<void(const MIDIMessage&)> Callback;
+
+    DynamicHandlerModel(MIDIMessageQueue* queue)
+        : message_queue(queue), events_processed(0), callbacks_executed(0), max_time(0), avg_time(0) {}
+
+    void RegisterCallback(Callback callback, const MIDIEventFilter& filter) {
+        Entry entry;
+        entry.callback = callback;
+        entry.filter = filter;
+        entry.enabled = true;
+        callbacks.push_back(entry);
+    }
+
+    // MIDIEventHandler::SubmitEvent
+    bool SubmitEvent(uint8_t status, uint8_t data1, uint8_t data2, MIDIMessageSource source) {
+        MIDIMessage msg;
+        msg.status = status;
+        msg.data1 = data1;
+        msg.data2 = data2;
+        msg.source = source;
+        msg.timestamp = system_time();
+        msg.priority = (status & 0xF0) == 0xF0 ? 3 : 1;
+        return message_queue->Enqueue(msg);
+    }
+
+    // MIDIEventHandler::ProcessPendingEvents
+    void ProcessPendingEvents() {
+        MIDIMessage message;
+        while (message_queue->Dequeue(message)) {
+            ProcessSingleEvent(message);
+        }
+    }
+
+    // MIDIEventHandler::ProcessMessage
+    void ProcessSingleEvent(const MIDIMessage& message) {
+        bigtime_t start_time = system_time();
+        if (!global_filter.ShouldAccept(message)) {
+            return;
+        }
+
+        for (const auto& entry : callbacks) {
+            if (entry.enabled && entry.filter.ShouldAccept(message)) {
+                entry.callback(message);
+                callbacks_executed.fetch_add(1);
+            }
+        }
+
+        uint32_t time_us = static_cast<uint32_t>(system_time() - start_time);
+        uint32_t current_max = max_time.load();
+        while (time_us > current_max && !max_time.compare_exchange_weak(current_max, time_us)) {
+        }
+        avg_time.store((avg_time.load() * 7 + time_us) / 8);
+        events_processed.fetch_add(1);
+    }
+
+private:
+    struct Entry {
+        Callback callback;
+        MIDIEventFilter filter;
+        bool enabled;
+    };
+
+    MIDIMessageQueue* message_queue;
+    std::vector<Entry> callbacks;
+    MIDIEventFilter global_filter;
+    std::atomic<uint64_t> events_processed;
+    std::atomic<uint64_t> callbacks_executed;
+    std::atomic<uint32_t> max_time;
+    std::atomic<uint32_t> avg_time;
+};
+
+// ===============================
+// Input stream
+// ===============================
+
+struct InputEvent {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+// Typical hardware traffic: pad hits and releases, fader sweeps, buttons
+static std::vector<InputEvent> BuildStream(size_t count)
+{
+    std::vector<InputEvent> events(count);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t roll = (seed >> 16) % 100;
+        InputEvent& event = events[i];
+        if (roll < 35) {
+            event = {0x90, static_cast<uint8_t>((seed >> 8) & 0x3F), static_cast<uint8_t>(1 + (seed & 0x7E))};
+        } else if (roll < 60) {
+            event = {0x90, static_cast<uint8_t>((seed >> 8) & 0x3F), 0};     // Release as Note On vel 0
+        } else if (roll < 90) {
+            event = {0xB0, static_cast<uint8_t>(APC_MINI_FADER_CC_START + (seed >> 8) % 9), static_cast<uint8_t>(seed & 0x7F)};
+        } else {
+            event = {0x90, static_cast<uint8_t>(APC_MINI_TRACK_NOTE_START + ((seed >> 8) & 0x7)), 127};
+        }
+    }
+    return events;
+}
+
+// UI side: drain the inbox as the window thread would
+static size_t DrainInbox(MIDIMessageQueue* inbox)
+{
+    MIDIMessage message;
+    size_t drained = 0;
+    while (inbox->Dequeue(message)) {
+        drained++;
+    }
+    return drained;
+}
+
+// ===============================
+// Runs
+// ===============================
+
+typedef std::function<void(uint8_t, uint8_t, uint8_t)> ReaderCallback;
+
+static double RunDynamic(const std::vector<InputEvent>& events, PipelineControlState& state, size_t& delivered)
+{
+    MIDIMessageQueue* handler_queue = new MIDIMessageQueue();
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    DynamicHandlerModel handler(handler_queue);
+
+    // Same three registrations as APCMiniGUIApp::RegisterMIDICallbacks(),
+    // with the state update and inbox post the GUI does per event
+    auto ui_callback = [&state, inbox](const MIDIMessage& msg) {
+        MIDIMessage normalized = msg;
+        NoteOffNormalizeStage().Process(normalized);
+        if (ControlStateStage<BenchDevice>{&state}.Process(normalized)) {
+            inbox->Enqueue(normalized);
+        }
+    };
+
+    MIDIEventFilter pad_filter;
+    pad_filter.accept_cc = false;
+    pad_filter.accept_sysex = false;
+    handler.RegisterCallback(ui_callback, pad_filter);
+
+    MIDIEventFilter fader_filter;
+    fader_filter.accept_note_on = false;
+    fader_filter.accept_note_off = false;
+    fader_filter.accept_sysex = false;
+    handler.RegisterCallback(ui_callback, fader_filter);
+
+    MIDIEventFilter sysex_filter;
+    sysex_filter.accept_note_on = false;
+    sysex_filter.accept_note_off = false;
+    sysex_filter.accept_cc = false;
+    handler.RegisterCallback(ui_callback, sysex_filter);
+
+    ReaderCallback reader = [&handler](uint8_t status, uint8_t data1, uint8_t data2) {
+        handler.SubmitEvent(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
+    };
+
+    delivered = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t base = 0; base < events.size(); base += BATCH_SIZE) {
+        size_t end = base + BATCH_SIZE < events.size() ? base + BATCH_SIZE : events.size();
+        for (size_t i = base; i < end; i++) {
+            reader(events[i].status, events[i].data1, events[i].data2);
+        }
+        handler.ProcessPendingEvents();
+        delivered += DrainInbox(inbox);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    delete inbox;
+    delete handler_queue;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / events.size();
+}
+
+static double RunStatic(const std::vector<InputEvent>& events, PipelineControlState& state, size_t& delivered)
+{
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<BenchDevice> pipeline = MakeAPCInputPipeline<BenchDevice>(&state, inbox);
+
+    // The USB reader still calls through one std::function
+    ReaderCallback reader = [&pipeline](uint8_t status, uint8_t data1, uint8_t data2) {
+        pipeline.Push(status, data1, data2, MIDI_SOURCE_HARDWARE_USB);
+    };
+
+    delivered = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t base = 0; base < events.size(); base += BATCH_SIZE) {
+        size_t end = base + BATCH_SIZE < events.size() ? base + BATCH_SIZE : events.size();
+        for (size_t i = base; i < end; i++) {
+            reader(events[i].status, events[i].data1, events[i].data2);
+        }
+        delivered += DrainInbox(inbox);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    delete inbox;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / events.size();
+}
+
+// Static chain with a registry bridge in place of the inbox
+static double RunStaticWithRegistry(const std::vector<InputEvent>& events, PipelineControlState& state,
+                                    size_t& delivered)
+{
+    MIDIMessageQueue* unused_queue = new MIDIMessageQueue();
+    DynamicHandlerModel handler(unused_queue);
+    size_t callback_count = 0;
+    handler.RegisterCallback([&callback_count](const MIDIMessage&) { callback_count++; }, MIDIEventFilter());
+
+    auto pipeline = MakeMIDIPipeline(StatusFilterStage<MIDI_TYPES_APC_INPUT>(),
+                                     NoteOffNormalizeStage(),
+                                     ControlStateStage<BenchDevice>{&state},
+                                     RegistryStage<DynamicHandlerModel>{&handler});
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < events.size(); i++) {
+        pipeline.Push(events[i].status, events[i].data1, events[i].data2, MIDI_SOURCE_HARDWARE_USB);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    delivered = callback_count;
+    delete unused_queue;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / events.size();
+}
+
+static bool SameState(const PipelineControlState& a, const PipelineControlState& b)
+{
+    for (int i = 0; i < 128; i++) {
+        if (a.note_values[i].load() != b.note_values[i].load() ||
+            a.cc_values[i].load() != b.cc_values[i].load()) {
+            return false;
+        }
+    }
+    return a.updates.load() == b.updates.load();
+}
+
+int main(int argc, char** argv)
+{
+    size_t event_count = 1000000;
+    int rounds = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            event_count = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--events <count>] [--rounds <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (event_count == 0 || rounds <= 0) {
+        printf("❌ --events and --rounds must be positive\n");
+        return 1;
+    }
+
+    printf("🧩 MIDI Pipeline Benchmark (%zu events x %d rounds, best round reported)\n", event_count, rounds);
+    printf("Stages: %zu (filter -> normalize -> state -> LED echo -> dedup -> UI inbox)\n\n",
+           APCInputPipeline<BenchDevice>::STAGE_COUNT);
+
+    std::vector<InputEvent> events = BuildStream(event_count);
+
+    double best_dynamic = 0, best_static = 0, best_bridge = 0;
+    for (int round = 0; round < rounds; round++) {
+        PipelineControlState dynamic_state, static_state, bridge_state;
+        size_t dynamic_delivered = 0, static_delivered = 0, bridge_delivered = 0;
+
+        double dynamic_ns = RunDynamic(events, dynamic_state, dynamic_delivered);
+        double static_ns = RunStatic(events, static_state, static_delivered);
+        double bridge_ns = RunStaticWithRegistry(events, bridge_state, bridge_delivered);
+
+        // Both paths must do the same work
+        if (!SameState(dynamic_state, static_state) || !SameState(static_state, bridge_state) ||
+            dynamic_delivered != static_delivered || static_delivered != bridge_delivered) {
+            printf("❌ Paths disagree: delivered %zu / %zu / %zu\n",
+                   dynamic_delivered, static_delivered, bridge_delivered);
+            return 1;
+        }
+
+        if (round == 0 || dynamic_ns < best_dynamic) best_dynamic = dynamic_ns;
+        if (round == 0 || static_ns < best_static) best_static = static_ns;
+        if (round == 0 || bridge_ns < best_bridge) best_bridge = bridge_ns;
+    }
+
+    printf("   Dynamic (SubmitEvent -> queue -> callbacks): %8.1f ns/event\n", best_dynamic);
+    printf("   Static pipeline -> UI inbox:                 %8.1f ns/event (%.1fx)\n",
+           best_static, best_dynamic / best_static);
+    printf("   Static pipeline -> registry bridge:          %8.1f ns/event\n", best_bridge);
+    return 0;
+}
@@ -0,0 +1,441 @@
+#include "midi_transport.h"
+#include "apc_device_profile.h"
+#include "thread_accounting.h"
+#include <string.h>
+
+#ifdef __HAIKU__
+#include "usb_raw_midi.h"
+#endif
+
+// ===============================
+// LoopbackTransport
+// ===============================
+
+LoopbackTransport::LoopbackTransport()
+    : is_open(false)
+{
+}
+
+APCMiniError LoopbackTransport::Open()
+{
+    is_open = true;
+    return APC_SUCCESS;
+}
+
+void LoopbackTransport::Close()
+{
+    is_open = false;
+}
+
+APCMiniError LoopbackTransport::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    if (!is_open) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    DeliverMIDI(status, data1, data2);
+    return APC_SUCCESS;
+}
+
+APCMiniError LoopbackTransport::SendSysEx(const uint8_t* data, size_t length)
+{
+    if (!is_open) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (!data || length < 2 || data[0] != 0xF0 || data[length - 1] != 0xF7) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    DeliverSysEx(data, length);
+    return APC_SUCCESS;
+}
+
+// ===============================
+// SimulatedDeviceTransport
+// ===============================
+
+SimulatedDeviceTransport::SimulatedDeviceTransport(const SimulatedLinkModel& link_model)
+    : model(link_model)
+    , is_open(false)
+    , echo_enabled(true)
+    , intro_response_enabled(true)
+    , packets_received(0)
+    , transfers_received(0)
+    , introductions_answered(0)
+    , stop_requested(false)
+    , link_free_at(0)
+    , last_delivery_at(0)
+    , last_led_lit_at(0)
+    , rng(link_model.seed)
+{
+    memset(led_velocity, 0, sizeof(led_velocity));
+    memset(led_channel, 0, sizeof(led_channel));
+    memset(fader_values, 0, sizeof(fader_values));
+}
+
+SimulatedDeviceTransport::~SimulatedDeviceTransport()
+{
+    Close();
+}
+
+APCMiniError SimulatedDeviceTransport::Open()
+{
+    if (is_open.load()) {
+        return APC_SUCCESS;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop_requested = false;
+        pending.clear();
+        link_free_at = 0;
+        last_delivery_at = 0;
+        last_led_lit_at = 0;
+    }
+
+    delivery_thread = std::thread(&SimulatedDeviceTransport::DeliveryThreadLoop, this);
+    is_open.store(true);
+    return APC_SUCCESS;
+}
+
+void SimulatedDeviceTransport::Close()
+{
+    if (!is_open.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop_requested = true;
+    }
+    pending_changed.notify_all();
+
+    if (delivery_thread.joinable()) {
+        delivery_thread.join();
+    }
+}
+
+APCMiniError SimulatedDeviceTransport::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    if (!is_open.load()) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    const uint8_t bytes[3] = { status, data1, data2 };
+    return Schedule(bytes, sizeof(bytes), false, true);
+}
+
+APCMiniError SimulatedDeviceTransport::SendSysEx(const uint8_t* data, size_t length)
+{
+    if (!is_open.load()) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (!data || length < 2 || data[0] != 0xF0 || data[length - 1] != 0xF7) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    return Schedule(data, length, true, true);
+}
+
+APCMiniError SimulatedDeviceTransport::SendMIDIBatch(const uint8_t (*messages)[3], size_t count)
+{
+    if (!is_open.load()) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (!messages || count == 0) {
+        return count == 0 ? APC_SUCCESS : APC_ERROR_INVALID_PARAMETER;
+    }
+
+    bigtime_t complete_at;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        packets_received.fetch_add(count);
+        transfers_received.fetch_add(1);
+
+        // One transfer: the whole batch shares a departure and its echoes
+        bigtime_t deliver_at = ComputeDeliveryTime(count, true, 2);
+        bool lit = false;
+        for (size_t i = 0; i < count; i++) {
+            ApplyToDevice(messages[i], 3, false);
+            uint8_t type = messages[i][0] & 0xF0;
+            lit = lit || type == MIDI_NOTE_ON || type == MIDI_NOTE_OFF;
+
+            if (echo_enabled.load()) {
+                PendingDelivery delivery;
+                delivery.deliver_at = deliver_at;
+                delivery.bytes.assign(messages[i], messages[i] + 3);
+                delivery.is_sysex = false;
+                pending.push_back(delivery);
+            }
+        }
+        if (lit) {
+            last_led_lit_at = deliver_at - model.base_latency_us;
+        }
+
+        // The host sees completion at the end of the frame carrying the last packet
+        complete_at = link_free_at;
+        if (model.frame_interval_us > 0) {
+            complete_at = (complete_at + model.frame_interval_us - 1) / model.frame_interval_us *
+                          model.frame_interval_us;
+        }
+        pending_changed.notify_one();
+    }
+
+    snooze_until(complete_at, B_SYSTEM_TIMEBASE);
+    return APC_SUCCESS;
+}
+
+void SimulatedDeviceTransport::InjectMIDI(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    if (!is_open.load()) {
+        return;
+    }
+
+    // Device -> host traffic does not compete with the outbound link
+    const uint8_t bytes[3] = { status, data1, data2 };
+    std::lock_guard<std::mutex> guard(lock);
+
+    PendingDelivery delivery;
+    delivery.deliver_at = ComputeDeliveryTime(1, false, 1);
+    delivery.bytes.assign(bytes, bytes + sizeof(bytes));
+    delivery.is_sysex = false;
+    pending.push_back(delivery);
+    pending_changed.notify_one();
+}
+
+void SimulatedDeviceTransport::SetFaderValue(uint8_t fader_index, uint8_t value)
+{
+    if (fader_index >= APC_MINI_TOTAL_FADER_COUNT) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    fader_values[fader_index] = value & 0x7F;
+}
+
+uint8_t SimulatedDeviceTransport::GetLEDVelocity(uint8_t note) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return led_velocity[note & 0x7F];
+}
+
+uint8_t SimulatedDeviceTransport::GetLEDChannel(uint8_t note) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return led_channel[note & 0x7F];
+}
+
+bigtime_t SimulatedDeviceTransport::GetLastLEDLitTime() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return last_led_lit_at;
+}
+
+APCMiniError SimulatedDeviceTransport::Schedule(const uint8_t* bytes, size_t length,
+                                                bool is_sysex, bool occupies_link)
+{
+    // USB-MIDI carries at most 3 MIDI bytes per 4-byte packet
+    const size_t packet_count = is_sysex ? (length + 2) / 3 : 1;
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    packets_received.fetch_add(packet_count);
+    transfers_received.fetch_add(1);
+    ApplyToDevice(bytes, length, is_sysex);
+
+    // Echoes and replies travel host -> device -> host (two link legs)
+    bigtime_t deliver_at = ComputeDeliveryTime(packet_count, occupies_link, 2);
+
+    // LED changes take effect one leg before their echo would arrive
+    if (!is_sysex && length >= 3 && ((bytes[0] & 0xF0) == MIDI_NOTE_ON || (bytes[0] & 0xF0) == MIDI_NOTE_OFF)) {
+        last_led_lit_at = deliver_at - model.base_latency_us;
+    }
+
+    if (echo_enabled.load()) {
+        PendingDelivery delivery;
+        delivery.deliver_at = deliver_at;
+        delivery.bytes.assign(bytes, bytes + length);
+        delivery.is_sysex = is_sysex;
+        pending.push_back(delivery);
+    }
+
+    bool is_introduction = is_sysex && length >= 6 &&
+                           memcmp(bytes, APCMiniMK2Profile::SYSEX_HEADER, 4) == 0 &&
+                           bytes[4] == APC_MK2_SYSEX_INTRO_CMD;
+
+    if (is_introduction && intro_response_enabled.load()) {
+        PendingDelivery response;
+        BuildIntroductionResponse(response.bytes);
+        response.deliver_at = deliver_at;
+        response.is_sysex = true;
+        pending.push_back(response);
+        introductions_answered.fetch_add(1);
+    }
+
+    pending_changed.notify_one();
+    return APC_SUCCESS;
+}
+
+bigtime_t SimulatedDeviceTransport::ComputeDeliveryTime(size_t packet_count, bool occupies_link,
+                                                        int legs)
+{
+    // Called with lock held
+    bigtime_t now = system_time();
+    bigtime_t departure = now;
+
+    if (occupies_link) {
+        // Single-server link: packets queue behind earlier traffic
+        if (link_free_at > departure) {
+            departure = link_free_at;
+        }
+        departure += model.per_transfer_us + model.per_packet_us * (bigtime_t)packet_count;
+        link_free_at = departure;
+    }
+
+    bigtime_t deliver_at = departure + model.base_latency_us * legs;
+
+    if (model.jitter_us > 0) {
+        std::uniform_int_distribution<bigtime_t> jitter(0, model.jitter_us);
+        deliver_at += jitter(rng);
+    }
+
+    if (model.frame_interval_us > 0) {
+        bigtime_t frames = (deliver_at + model.frame_interval_us - 1) / model.frame_interval_us;
+        deliver_at = frames * model.frame_interval_us;
+    }
+
+    // USB delivers in order: never overtake an earlier message
+    if (deliver_at < last_delivery_at) {
+        deliver_at = last_delivery_at;
+    }
+    last_delivery_at = deliver_at;
+
+    return deliver_at;
+}
+
+void SimulatedDeviceTransport::ApplyToDevice(const uint8_t* bytes, size_t length, bool is_sysex)
+{
+    // Called with lock held
+    if (is_sysex || length < 3) {
+        return;
+    }
+
+    uint8_t type = bytes[0] & 0xF0;
+    uint8_t note = bytes[1] & 0x7F;
+
+    if (type == MIDI_NOTE_ON) {
+        led_velocity[note] = bytes[2] & 0x7F;
+        led_channel[note] = bytes[0] & 0x0F;
+    } else if (type == MIDI_NOTE_OFF) {
+        led_velocity[note] = 0;
+        led_channel[note] = bytes[0] & 0x0F;
+    }
+}
+
+void SimulatedDeviceTransport::BuildIntroductionResponse(std::vector<uint8_t>& response)
+{
+    // Called with lock held.
+    // F0 47 7F 4F 61 <len MSB> <len LSB> <fader 1..9> F7
+    response.assign(APCMiniMK2Profile::SYSEX_HEADER, APCMiniMK2Profile::SYSEX_HEADER + 4);
+    response.push_back(APC_MK2_SYSEX_INTRO_RESP);
+    response.push_back(0x00);
+    response.push_back(APC_MINI_TOTAL_FADER_COUNT);
+    for (int i = 0; i < APC_MINI_TOTAL_FADER_COUNT; i++) {
+        response.push_back(fader_values[i]);
+    }
+    response.push_back(APC_MK2_SYSEX_END);
+}
+
+void SimulatedDeviceTransport::DeliveryThreadLoop()
+{
+    ScopedThreadAccounting accounting("sim_delivery");
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (!stop_requested) {
+        if (pending.empty()) {
+            pending_changed.wait(guard);
+            ThreadAccounting::NoteWakeup();
+            continue;
+        }
+
+        bigtime_t now = system_time();
+        bigtime_t deliver_at = pending.front().deliver_at;
+        if (deliver_at > now) {
+            // Sleep without the lock so senders are not blocked
+            guard.unlock();
+            snooze_until(deliver_at, B_SYSTEM_TIMEBASE);
+            ThreadAccounting::NoteWakeup();
+            guard.lock();
+            continue;
+        }
+
+        PendingDelivery delivery = std::move(pending.front());
+        pending.pop_front();
+
+        // Callbacks run without the lock so they may send again
+        guard.unlock();
+        if (delivery.is_sysex) {
+            DeliverSysEx(delivery.bytes.data(), delivery.bytes.size());
+        } else {
+            DeliverMIDI(delivery.bytes[0], delivery.bytes[1], delivery.bytes[2]);
+        }
+        guard.lock();
+    }
+}
+
+// ===============================
+// USBRawMIDITransport (Haiku only)
+// ===============================
+
+#ifdef __HAIKU__
+
+USBRawMIDITransport::USBRawMIDITransport(USBRawMIDI* usb)
+    : usb_midi(usb)
+{
+}
+
+APCMiniError USBRawMIDITransport::Open()
+{
+    if (!usb_midi) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    usb_midi->SetMIDICallback([this](uint8_t status, uint8_t data1, uint8_t data2) {
+        DeliverMIDI(status, data1, data2);
+    });
+
+    if (usb_midi->IsConnected()) {
+        return APC_SUCCESS;
+    }
+    return usb_midi->Initialize();
+}
+
+void USBRawMIDITransport::Close()
+{
+    if (usb_midi) {
+        usb_midi->SetMIDICallback(nullptr);
+    }
+}
+
+bool USBRawMIDITransport::IsOpen() const
+{
+    return usb_midi && usb_midi->IsConnected();
+}
+
+APCMiniError USBRawMIDITransport::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    return usb_midi ? usb_midi->SendMIDI(status, data1, data2) : APC_ERROR_DEVICE_NOT_FOUND;
+}
+
+APCMiniError USBRawMIDITransport::SendSysEx(const uint8_t* data, size_t length)
+{
+    return usb_midi ? usb_midi->SendSysEx(data, length) : APC_ERROR_DEVICE_NOT_FOUND;
+}
+
+APCMiniError USBRawMIDITransport::SendMIDIBatch(const uint8_t (*messages)[3], size_t count)
+{
+    return usb_midi ? usb_midi->SendMIDIBatch(messages, count) : APC_ERROR_DEVICE_NOT_FOUND;
+}
+
+#endif // __HAIKU__
@@ -0,0 +1,296 @@
+#ifndef MIDI_TRANSPORT_H
+#define MIDI_TRANSPORT_H
+
+/*
+ * MIDI Transport Abstraction
+ *
+ * Decouples the MIDI pipeline (queue, handler, load generation, probes)
+ * from the physical link so it can be exercised without an APC Mini
+ * attached and on hosts other than Haiku:
+ *
+ * - LoopbackTransport: every sent message is delivered straight back to the
+ *   receive callbacks in the sending thread (zero link latency baseline)
+ * - SimulatedDeviceTransport: a model of an APC Mini MK2 on a USB link with
+ *   configurable latency, per-packet cost, jitter and frame quantization,
+ *   delivered from its own thread like the USB reader thread
+ * - USBRawMIDITransport (Haiku only): adapter around the real USBRawMIDI
+ * - MidiKitTransport (Haiku only): MIDI Kit 2 endpoints, either the APC's
+ *   or a local producer routed back into a local consumer
+ *
+ * Receive callbacks run on the transport's delivery thread and must not
+ * block; they are expected to hand messages to MIDIMessageQueue.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <random>
+#include <atomic>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+class MIDITransport {
+public:
+    // Same signature as USBRawMIDI::MIDICallback
+    typedef std::function<void(uint8_t status, uint8_t data1, uint8_t data2)> MIDICallback;
+    // Complete SysEx message including F0 ... F7
+    typedef std::function<void(const uint8_t* data, size_t length)> SysExCallback;
+
+    virtual ~MIDITransport() {}
+
+    virtual const char* Name() const = 0;
+    virtual APCMiniError Open() = 0;
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+
+    virtual APCMiniError SendMIDI(uint8_t status, uint8_t data1, uint8_t data2) = 0;
+    virtual APCMiniError SendSysEx(const uint8_t* data, size_t length) = 0;
+
+    // Several short messages in as few link transfers as possible; returns
+    // once they are on the wire, like a USB bulk write. Default: SendMIDI each.
+    virtual APCMiniError SendMIDIBatch(const uint8_t (*messages)[3], size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            APCMiniError result = SendMIDI(messages[i][0], messages[i][1], messages[i][2]);
+            if (result != APC_SUCCESS) {
+                return result;
+            }
+        }
+        return APC_SUCCESS;
+    }
+
+    // Callbacks must be installed before Open()
+    void SetMIDICallback(MIDICallback callback) { midi_callback = callback; }
+    void SetSysExCallback(SysExCallback callback) { sysex_callback = callback; }
+
+protected:
+    void DeliverMIDI(uint8_t status, uint8_t data1, uint8_t data2) {
+        if (midi_callback) {
+            midi_callback(status, data1, data2);
+        }
+    }
+
+    void DeliverSysEx(const uint8_t* data, size_t length) {
+        if (sysex_callback) {
+            sysex_callback(data, length);
+        }
+    }
+
+    MIDICallback midi_callback;
+    SysExCallback sysex_callback;
+};
+
+// Echoes every outbound message back to the receive callbacks synchronously
+class LoopbackTransport : public MIDITransport {
+public:
+    LoopbackTransport();
+
+    virtual const char* Name() const override { return "loopback"; }
+    virtual APCMiniError Open() override;
+    virtual void Close() override;
+    virtual bool IsOpen() const override { return is_open; }
+
+    virtual APCMiniError SendMIDI(uint8_t status, uint8_t data1, uint8_t data2) override;
+    virtual APCMiniError SendSysEx(const uint8_t* data, size_t length) override;
+
+private:
+    bool is_open;
+};
+
+// Timing model for SimulatedDeviceTransport (all values in microseconds)
+struct SimulatedLinkModel {
+    bigtime_t base_latency_us;     // Fixed one-way cost per link leg (stack + firmware)
+    bigtime_t per_transfer_us;     // Link busy time per transfer (submission, hub scheduling)
+    bigtime_t per_packet_us;       // Link busy time per 4-byte USB-MIDI packet
+    bigtime_t jitter_us;           // Uniform random extra delay [0, jitter]
+    bigtime_t frame_interval_us;   // Deliveries aligned to USB frames (0 = off)
+    uint32_t seed;                 // Jitter RNG seed (runs are reproducible)
+
+    // Full-speed USB device: 1 ms frames, ~0.25 ms stack + firmware,
+    // about 50 packets per frame before the device saturates
+    static SimulatedLinkModel FullSpeedUSB() {
+        SimulatedLinkModel model;
+        model.base_latency_us = 250;
+        model.per_transfer_us = 0;
+        model.per_packet_us = 20;
+        model.jitter_us = 50;
+        model.frame_interval_us = 1000;
+        model.seed = 1;
+        return model;
+    }
+
+    // Same device behind a loaded hub: every transfer pays for scheduling
+    // and the packet rate halves
+    static SimulatedLinkModel BusyHubUSB() {
+        SimulatedLinkModel model = FullSpeedUSB();
+        model.base_latency_us = 400;
+        model.per_transfer_us = 300;
+        model.per_packet_us = 40;
+        model.jitter_us = 150;
+        return model;
+    }
+
+    // High-speed host path: 125 us microframes, cheap transfers
+    static SimulatedLinkModel HighSpeedUSB() {
+        SimulatedLinkModel model;
+        model.base_latency_us = 100;
+        model.per_transfer_us = 10;
+        model.per_packet_us = 2;
+        model.jitter_us = 10;
+        model.frame_interval_us = 125;
+        model.seed = 1;
+        return model;
+    }
+
+    // No delays at all, but still asynchronous delivery
+    static SimulatedLinkModel Instant() {
+        SimulatedLinkModel model;
+        model.base_latency_us = 0;
+        model.per_transfer_us = 0;
+        model.per_packet_us = 0;
+        model.jitter_us = 0;
+        model.frame_interval_us = 0;
+        model.seed = 1;
+        return model;
+    }
+};
+
+/*
+ * Simulated APC Mini MK2
+ *
+ * Outbound messages occupy the modelled link and are applied to the
+ * simulated device state (LED velocities/channels). The device answers the
+ * MK2 introduction message (0x60) with its response (0x61) carrying the
+ * current fader positions. With echo enabled every outbound message is
+ * also sent back (MIDI thru), which gives a full host->device->host path
+ * for load generation. Inject*() simulate a user touching the hardware.
+ * SendMIDI() queues and returns; SendMIDIBatch() is one transfer and blocks
+ * until it completes at the end of its USB frame.
+ */
+class SimulatedDeviceTransport : public MIDITransport {
+public:
+    SimulatedDeviceTransport(const SimulatedLinkModel& model = SimulatedLinkModel::FullSpeedUSB());
+    virtual ~SimulatedDeviceTransport();
+
+    virtual const char* Name() const override { return "simulated-mk2"; }
+    virtual APCMiniError Open() override;
+    virtual void Close() override;
+    virtual bool IsOpen() const override { return is_open.load(); }
+
+    virtual APCMiniError SendMIDI(uint8_t status, uint8_t data1, uint8_t data2) override;
+    virtual APCMiniError SendSysEx(const uint8_t* data, size_t length) override;
+    virtual APCMiniError SendMIDIBatch(const uint8_t (*messages)[3], size_t count) override;
+
+    // Device behaviour
+    void SetEchoEnabled(bool enabled) { echo_enabled.store(enabled); }
+    void SetIntroductionResponseEnabled(bool enabled) { intro_response_enabled.store(enabled); }
+    void SetFaderValue(uint8_t fader_index, uint8_t value);
+
+    // Simulated user input (device -> host)
+    void InjectMIDI(uint8_t status, uint8_t data1, uint8_t data2);
+
+    // Simulated device state
+    uint8_t GetLEDVelocity(uint8_t note) const;
+    uint8_t GetLEDChannel(uint8_t note) const;
+    // Modelled time the most recent LED message reached the device
+    bigtime_t GetLastLEDLitTime() const;
+    uint64_t GetPacketsReceived() const { return packets_received.load(); }
+    uint64_t GetTransfersReceived() const { return transfers_received.load(); }
+    uint64_t GetIntroductionsAnswered() const { return introductions_answered.load(); }
+
+private:
+    struct PendingDelivery {
+        bigtime_t deliver_at;
+        std::vector<uint8_t> bytes;   // 3 bytes for MIDI, full message for SysEx
+        bool is_sysex;
+    };
+
+    APCMiniError Schedule(const uint8_t* bytes, size_t length, bool is_sysex, bool occupies_link);
+    bigtime_t ComputeDeliveryTime(size_t packet_count, bool occupies_link, int legs);
+    void ApplyToDevice(const uint8_t* bytes, size_t length, bool is_sysex);
+    void BuildIntroductionResponse(std::vector<uint8_t>& response);
+    void DeliveryThreadLoop();
+
+    SimulatedLinkModel model;
+    std::atomic<bool> is_open;
+    std::atomic<bool> echo_enabled;
+    std::atomic<bool> intro_response_enabled;
+    std::atomic<uint64_t> packets_received;
+    std::atomic<uint64_t> transfers_received;
+    std::atomic<uint64_t> introductions_answered;
+
+    mutable std::mutex lock;
+    std::condition_variable pending_changed;
+    std::deque<PendingDelivery> pending;
+    std::thread delivery_thread;
+    bool stop_requested;
+    bigtime_t link_free_at;
+    bigtime_t last_delivery_at;
+    bigtime_t last_led_lit_at;
+    std::mt19937 rng;
+
+    uint8_t led_velocity[128];
+    uint8_t led_channel[128];
+    uint8_t fader_values[APC_MINI_TOTAL_FADER_COUNT];
+};
+
+#ifdef __HAIKU__
+class USBRawMIDI;
+
+// Adapter exposing the real hardware through the transport interface
+class USBRawMIDITransport : public MIDITransport {
+public:
+    USBRawMIDITransport(USBRawMIDI* usb_midi);
+
+    virtual const char* Name() const override { return "usb-raw"; }
+    virtual APCMiniError Open() override;
+    virtual void Close() override;
+    virtual bool IsOpen() const override;
+
+    virtual APCMiniError SendMIDI(uint8_t status, uint8_t data1, uint8_t data2) override;
+    virtual APCMiniError SendSysEx(const uint8_t* data, size_t length) override;
+    virtual APCMiniError SendMIDIBatch(const uint8_t (*messages)[3], size_t count) override;
+
+private:
+    USBRawMIDI* usb_midi;
+};
+
+class BMidiLocalProducer;
+class BMidiProducer;
+class BMidiConsumer;
+class MidiKitInput;
+
+// MIDI Kit 2 routing through the midi_server (midikit_transport.cpp).
+// endpoint_match selects the device endpoints by name; nullptr connects
+// our producer straight to our consumer, measuring the routing alone.
+class MidiKitTransport : public MIDITransport {
+public:
+    MidiKitTransport(const char* endpoint_match = "APC");
+    virtual ~MidiKitTransport();
+
+    virtual const char* Name() const override { return loop ? "midikit-loop" : "midikit"; }
+    virtual APCMiniError Open() override;
+    virtual void Close() override;
+    virtual bool IsOpen() const override { return local_producer != nullptr; }
+
+    virtual APCMiniError SendMIDI(uint8_t status, uint8_t data1, uint8_t data2) override;
+    virtual APCMiniError SendSysEx(const uint8_t* data, size_t length) override;
+
+private:
+    friend class MidiKitInput;
+
+    bool loop;
+    char match[32];
+    BMidiLocalProducer* local_producer;
+    MidiKitInput* local_consumer;
+    BMidiProducer* device_producer;
+    BMidiConsumer* device_consumer;
+};
+#endif
+
+#endif // MIDI_TRANSPORT_H
@@ -16,10 +16,9 @@
 #include <midi2/MidiConsumer.h>
 #include <midi/MidiPort.h>
 #include "apc_mini_defs.h"
+#include "workload.h"
 
-// Test configuration
-#define TEST_BATCH_SIZE 64
-#define TEST_ITERATIONS 10
+// Test configuration; the batch shape comes from a workload (default: batch64)
 #define TIMEOUT_US 5000000  // 5 seconds
 
 class MidiKitDriverTest {
@@ -29,7 +28,13 @@ public:
         , apc_consumer(nullptr)
         , midi_port(nullptr)
         , use_direct_port(false)
-        , start_time(0) {}
+        , start_time(0)
+        , batch_size(64)
+        , iterations(10)
+        , batch_interval_us(100000) {}
+
+    // Burst workloads only: burst_size per batch, one batch per interval
+    bool Configure(const Workload& workload);
 
     bool Initialize();
     void Shutdown();
@@ -42,6 +47,9 @@ private:
     BMidiPort* midi_port;
     bool use_direct_port;
     bigtime_t start_time;
+    uint32_t batch_size;
+    uint32_t iterations;
+    bigtime_t batch_interval_us;
 
     struct TestStats {
         uint32_t messages_sent;
@@ -236,9 +244,9 @@ void MidiKitDriverTest::SendBatchLEDCommands(int batch_num)
 
     bigtime_t batch_start = system_time();
 
-    // Send LED commands for all 64 pads
-    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
-        uint8_t note = APC_MINI_PAD_NOTE_START + pad;
+    // Send LED commands, wrapping around the 64 pads
+    for (uint32_t i = 0; i < batch_size; i++) {
+        uint8_t note = APC_MINI_PAD_NOTE_START + (i % APC_MINI_PAD_COUNT);
 
         if (use_direct_port) {
             // Direct port access using BMidiPort
@@ -263,8 +271,8 @@ void MidiKitDriverTest::SendBatchLEDCommands(int batch_num)
         stats.max_batch_time_us = batch_time;
     }
 
-    printf("Batch %2d: %6ld μs (%d msgs)\n",
-           batch_num, batch_time, TEST_BATCH_SIZE);
+    printf("Batch %2d: %6ld μs (%u msgs)\n",
+           batch_num, batch_time, batch_size);
 
     // Check for timeout (indicates blocking in driver)
     if (batch_time > TIMEOUT_US) {
@@ -277,15 +285,16 @@ void MidiKitDriverTest::SendBatchLEDCommands(int batch_num)
 void MidiKitDriverTest::RunBatchWriteTest()
 {
     printf("\n--- Starting Batch Write Test ---\n");
-    printf("Batches: %d x %d LED commands\n\n", TEST_ITERATIONS, TEST_BATCH_SIZE);
+    printf("Batches: %u x %u LED commands, %ld ms apart\n\n", iterations, batch_size,
+           batch_interval_us / 1000);
 
     start_time = system_time();
 
-    for (int i = 0; i < TEST_ITERATIONS; i++) {
+    for (uint32_t i = 0; i < iterations; i++) {
         SendBatchLEDCommands(i);
 
-        // Small delay between batches
-        snooze(100000); // 100ms
+        // Delay between batches
+        snooze(batch_interval_us);
     }
 
     bigtime_t total_time = system_time() - start_time;
@@ -321,7 +330,7 @@ void MidiKitDriverTest::PrintResults()
     }
 
     // Expected behavior analysis
-    printf("\nExpected batch time (64 msgs):\n");
+    printf("\nExpected batch time (%u msgs):\n", batch_size);
     printf("  USB MIDI: ~1-2 ms (fast bulk transfers)\n");
     printf("  Actual avg: %ld μs\n",
            stats.batches_completed > 0 ? stats.total_batch_time_us / stats.batches_completed : 0);
@@ -340,15 +349,50 @@ void MidiKitDriverTest::PrintResults()
     }
 }
 
+bool MidiKitDriverTest::Configure(const Workload& workload)
+{
+    const LoadProfile& profile = workload.phases[0].profile;
+    if (profile.arrival != LOAD_ARRIVAL_BURST) {
+        printf("ERROR: workload '%s' is not a burst workload\n", workload.name);
+        return false;
+    }
+
+    batch_size = profile.burst_size;
+    batch_interval_us = profile.burst_interval_us;
+    iterations = profile.BurstsBefore(profile.duration_us);
+    printf("Workload '%s': %s\n", workload.name, workload.description);
+    return true;
+}
+
 void MidiKitDriverTest::ResetStats()
 {
     memset(&stats, 0, sizeof(stats));
     stats.min_batch_time_us = UINT64_MAX;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    const char* workload_name = "batch64";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            workload_name = argv[++i];
+        } else {
+            printf("Usage: %s [--workload <name|file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Workload workload;
+    char error[128];
+    if (!Workload::Resolve(workload_name, workload, error, sizeof(error))) {
+        printf("ERROR: workload '%s': %s\n", workload_name, error);
+        return 1;
+    }
+
     MidiKitDriverTest test;
+    if (!test.Configure(workload)) {
+        return 1;
+    }
 
     if (!test.Initialize()) {
         printf("Test initialization failed\n");
@@ -0,0 +1,201 @@
+// MIDI Kit 2 transport (Haiku only)
+// Sends through a BMidiLocalProducer and receives through a
+// BMidiLocalConsumer, so the MIDI Kit path can be driven by the same
+// workloads as the USB Raw, loopback and simulated transports.
+
+#include "midi_transport.h"
+#include "sysex_assembler.h"
+#include <stdio.h>
+#include <string.h>
+
+#include <MidiRoster.h>
+#include <MidiProducer.h>
+#include <MidiConsumer.h>
+
+// Hooks run on the consumer's own thread, like the USB reader thread
+class MidiKitInput : public BMidiLocalConsumer {
+public:
+    MidiKitInput(MidiKitTransport* owner)
+        : BMidiLocalConsumer("APC Mini Transport Input")
+        , owner(owner)
+    {
+    }
+
+    virtual void NoteOff(uchar channel, uchar note, uchar velocity, bigtime_t) {
+        owner->DeliverMIDI(MIDI_NOTE_OFF | (channel & 0x0F), note, velocity);
+    }
+
+    virtual void NoteOn(uchar channel, uchar note, uchar velocity, bigtime_t) {
+        owner->DeliverMIDI(MIDI_NOTE_ON | (channel & 0x0F), note, velocity);
+    }
+
+    virtual void ControlChange(uchar channel, uchar control, uchar value, bigtime_t) {
+        owner->DeliverMIDI(MIDI_CONTROL_CHANGE | (channel & 0x0F), control, value);
+    }
+
+    // MIDI Kit hands over the body without F0/F7
+    virtual void SystemExclusive(void* data, size_t length, bigtime_t) {
+        uint8_t message[SysExAssembler::MAX_SYSEX_LENGTH];
+        if (length + 2 > sizeof(message)) {
+            return;
+        }
+        message[0] = 0xF0;
+        memcpy(message + 1, data, length);
+        message[length + 1] = 0xF7;
+        owner->DeliverSysEx(message, length + 2);
+    }
+
+private:
+    MidiKitTransport* owner;
+};
+
+// First roster endpoint whose name contains match (acquired; caller releases)
+static BMidiProducer* FindProducer(const char* match)
+{
+    BMidiRoster* roster = BMidiRoster::MidiRoster();
+    int32 id = 0;
+    while (BMidiProducer* producer = roster->NextProducer(&id)) {
+        if (strstr(producer->Name(), match)) {
+            return producer;
+        }
+        producer->Release();
+    }
+    return nullptr;
+}
+
+static BMidiConsumer* FindConsumer(const char* match)
+{
+    BMidiRoster* roster = BMidiRoster::MidiRoster();
+    int32 id = 0;
+    while (BMidiConsumer* consumer = roster->NextConsumer(&id)) {
+        if (strstr(consumer->Name(), match)) {
+            return consumer;
+        }
+        consumer->Release();
+    }
+    return nullptr;
+}
+
+MidiKitTransport::MidiKitTransport(const char* endpoint_match)
+    : loop(endpoint_match == nullptr)
+    , local_producer(nullptr)
+    , local_consumer(nullptr)
+    , device_producer(nullptr)
+    , device_consumer(nullptr)
+{
+    snprintf(match, sizeof(match), "%s", endpoint_match ? endpoint_match : "");
+}
+
+MidiKitTransport::~MidiKitTransport()
+{
+    Close();
+}
+
+APCMiniError MidiKitTransport::Open()
+{
+    if (local_producer) {
+        return APC_SUCCESS;
+    }
+    if (!BMidiRoster::MidiRoster()) {
+        return APC_ERROR_MIDI_INIT_FAILED;
+    }
+
+    // Endpoints are reference counted and must live on the heap
+    local_producer = new BMidiLocalProducer("APC Mini Transport Output");
+    local_consumer = new MidiKitInput(this);
+    if (local_producer->Register() != B_OK || local_consumer->Register() != B_OK) {
+        Close();
+        return APC_ERROR_MIDI_INIT_FAILED;
+    }
+
+    if (loop) {
+        if (local_producer->Connect(local_consumer) != B_OK) {
+            Close();
+            return APC_ERROR_MIDI_INIT_FAILED;
+        }
+        return APC_SUCCESS;
+    }
+
+    device_producer = FindProducer(match);
+    device_consumer = FindConsumer(match);
+    if (!device_producer || !device_consumer) {
+        Close();
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (device_producer->Connect(local_consumer) != B_OK ||
+        local_producer->Connect(device_consumer) != B_OK) {
+        Close();
+        return APC_ERROR_MIDI_INIT_FAILED;
+    }
+    return APC_SUCCESS;
+}
+
+void MidiKitTransport::Close()
+{
+    if (device_producer) {
+        if (local_consumer) {
+            device_producer->Disconnect(local_consumer);
+        }
+        device_producer->Release();
+        device_producer = nullptr;
+    }
+    if (device_consumer) {
+        if (local_producer) {
+            local_producer->Disconnect(device_consumer);
+        }
+        device_consumer->Release();
+        device_consumer = nullptr;
+    }
+    if (local_producer && local_consumer && loop) {
+        local_producer->Disconnect(local_consumer);
+    }
+    if (local_producer) {
+        local_producer->Unregister();
+        local_producer->Release();
+        local_producer = nullptr;
+    }
+    if (local_consumer) {
+        local_consumer->Unregister();
+        local_consumer->Release();
+        local_consumer = nullptr;
+    }
+}
+
+APCMiniError MidiKitTransport::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    if (!local_producer) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    uchar channel = status & 0x0F;
+    switch (status & 0xF0) {
+        case MIDI_NOTE_ON:
+            local_producer->SprayNoteOn(channel, data1, data2, system_time());
+            break;
+        case MIDI_NOTE_OFF:
+            local_producer->SprayNoteOff(channel, data1, data2, system_time());
+            break;
+        case MIDI_CONTROL_CHANGE:
+            local_producer->SprayControlChange(channel, data1, data2, system_time());
+            break;
+        default: {
+            uint8_t bytes[3] = { status, data1, data2 };
+            local_producer->SprayData(bytes, sizeof(bytes), true, system_time());
+            break;
+        }
+    }
+    return APC_SUCCESS;
+}
+
+APCMiniError MidiKitTransport::SendSysEx(const uint8_t* data, size_t length)
+{
+    if (!local_producer) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (!data || length < 2 || data[0] != 0xF0 || data[length - 1] != 0xF7) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    local_producer->SpraySystemExclusive(const_cast<uint8_t*>(data + 1), length - 2, system_time());
+    return APC_SUCCESS;
+}
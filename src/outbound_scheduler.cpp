@@ -0,0 +1,527 @@
+#include "outbound_scheduler.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+
+#include <string.h>
+
+static const char* QOS_NAMES[OUTBOUND_QOS_COUNT] = {
+    "interactive", "state_sync", "animation", "bulk"
+};
+
+static const char* METRIC_NAMES[OUTBOUND_QOS_COUNT][4] = {
+    { "outbound.interactive.enqueued", "outbound.interactive.sent",
+      "outbound.interactive.superseded", "outbound.interactive.dropped" },
+    { "outbound.state_sync.enqueued", "outbound.state_sync.sent",
+      "outbound.state_sync.superseded", "outbound.state_sync.dropped" },
+    { "outbound.animation.enqueued", "outbound.animation.sent",
+      "outbound.animation.superseded", "outbound.animation.dropped" },
+    { "outbound.bulk.enqueued", "outbound.bulk.sent",
+      "outbound.bulk.superseded", "outbound.bulk.dropped" }
+};
+
+static const uint64_t NO_SEQUENCE = UINT64_MAX;
+
+const char* OutboundQoSName(OutboundQoS qos)
+{
+    return (qos >= 0 && qos < OUTBOUND_QOS_COUNT) ? QOS_NAMES[qos] : "unknown";
+}
+
+OutboundScheduler::OutboundScheduler(BatchSendFunction send_batch_function,
+                                     SysExSendFunction send_sysex_function,
+                                     const OutboundSchedulerConfig& scheduler_config,
+                                     MetricsRegistry* metrics_registry)
+    : send_batch(send_batch_function)
+    , send_sysex(send_sysex_function)
+    , config(scheduler_config)
+    , registry(metrics_registry)
+    , stop_requested(false)
+    , writer_idle(false)
+    , running(false)
+    , next_sequence(0)
+    , animation_head(0)
+    , animation_count(0)
+    , transfer_count(0)
+    , tuner(TunerConfigFor(scheduler_config), scheduler_config.autotune ? metrics_registry : nullptr)
+    , tuner_enqueued(0)
+    , transfer_size(0)
+{
+    if (config.max_transfer == 0 || config.max_transfer > MAX_TRANSFER) {
+        config.max_transfer = MAX_TRANSFER;
+    }
+    transfer_size = config.autotune ? tuner.Current().batch_size : config.max_transfer;
+    if (config.animation_chunk == 0 || config.animation_chunk > config.max_transfer) {
+        config.animation_chunk = config.max_transfer;
+    }
+
+    memset(latest_sequence, 0, sizeof(latest_sequence));
+    memset(animation, 0, sizeof(animation));
+    for (size_t i = 0; i < OUTBOUND_QOS_COUNT; i++) {
+        queues[i].head = 0;
+        queues[i].count = 0;
+
+        ClassCounters& counter = counters[i];
+        counter.enqueued = 0;
+        counter.sent = 0;
+        counter.superseded = 0;
+        counter.dropped = 0;
+        counter.latency_sum_us = 0;
+        counter.max_latency_us = 0;
+        if (registry) {
+            registry->RegisterCounter(METRIC_NAMES[i][0], &counter.enqueued);
+            registry->RegisterCounter(METRIC_NAMES[i][1], &counter.sent);
+            registry->RegisterCounter(METRIC_NAMES[i][2], &counter.superseded);
+            registry->RegisterCounter(METRIC_NAMES[i][3], &counter.dropped);
+        }
+    }
+}
+
+OutboundScheduler::~OutboundScheduler()
+{
+    Stop();
+
+    if (registry) {
+        for (size_t i = 0; i < OUTBOUND_QOS_COUNT; i++) {
+            registry->Unregister(&counters[i].enqueued);
+            registry->Unregister(&counters[i].sent);
+            registry->Unregister(&counters[i].superseded);
+            registry->Unregister(&counters[i].dropped);
+        }
+    }
+}
+
+APCMiniError OutboundScheduler::Start()
+{
+    if (!send_batch) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) {
+        return APC_SUCCESS;
+    }
+    running = true;
+    stop_requested = false;
+    tuner_enqueued = EnqueuedTotal();
+    tuner.Begin(system_time());
+    writer_thread = std::thread(&OutboundScheduler::WriterThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void OutboundScheduler::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) {
+            return;
+        }
+        stop_requested = true;
+    }
+    work_available.notify_all();
+
+    if (writer_thread.joinable()) {
+        writer_thread.join();
+    }
+    running = false;
+}
+
+uint16_t OutboundScheduler::KeyFor(uint8_t status, uint8_t data1)
+{
+    switch (status & 0xF0) {
+        case MIDI_NOTE_OFF:
+        case MIDI_NOTE_ON:
+            return (uint16_t)(data1 & 0x7F);
+        case MIDI_CONTROL_CHANGE:
+            return (uint16_t)(128 + (data1 & 0x7F));
+        default:
+            return NO_KEY;
+    }
+}
+
+APCMiniError OutboundScheduler::EnqueueLocked(OutboundQoS qos, uint8_t status, uint8_t data1,
+                                              uint8_t data2, bigtime_t now)
+{
+    uint16_t key = KeyFor(status, data1);
+    if (qos == OUTBOUND_QOS_ANIMATION && key == NO_KEY) {
+        qos = OUTBOUND_QOS_STATE_SYNC;
+    }
+    uint64_t sequence = ++next_sequence;
+
+    if (config.prioritize && key != NO_KEY) {
+        latest_sequence[key][qos] = sequence;
+
+        // A newer frame value, or a higher class taking the LED over
+        AnimationSlot& slot = animation[key];
+        if (slot.pending && qos <= OUTBOUND_QOS_ANIMATION) {
+            slot.pending = false;
+            counters[OUTBOUND_QOS_ANIMATION].superseded.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (qos == OUTBOUND_QOS_ANIMATION) {
+            slot.bytes[0] = status;
+            slot.bytes[1] = data1;
+            slot.bytes[2] = data2;
+            slot.enqueued_at = now;
+            slot.sequence = sequence;
+            slot.pending = true;
+            // A replaced value keeps its key's place in line
+            if (!slot.queued) {
+                slot.queued = true;
+                animation_order[(animation_head + animation_count) % KEY_COUNT] = key;
+                animation_count++;
+            }
+            counters[qos].enqueued.fetch_add(1, std::memory_order_relaxed);
+            return APC_SUCCESS;
+        }
+    }
+
+    MessageQueue& queue = queues[config.prioritize ? qos : 0];
+    if (queue.count == MAX_PENDING) {
+        counters[qos].dropped.fetch_add(1, std::memory_order_relaxed);
+        return APC_ERROR_TIMEOUT;
+    }
+
+    PendingMessage& message = queue.entries[(queue.head + queue.count) % MAX_PENDING];
+    message.bytes[0] = status;
+    message.bytes[1] = data1;
+    message.bytes[2] = data2;
+    message.qos = (uint8_t)qos;
+    message.key = key;
+    message.enqueued_at = now;
+    message.sequence = sequence;
+    queue.count++;
+    counters[qos].enqueued.fetch_add(1, std::memory_order_relaxed);
+    return APC_SUCCESS;
+}
+
+APCMiniError OutboundScheduler::Send(OutboundQoS qos, uint8_t status, uint8_t data1,
+                                     uint8_t data2)
+{
+    const uint8_t message[1][3] = { { status, data1, data2 } };
+    return SendFrame(qos, message, 1);
+}
+
+APCMiniError OutboundScheduler::SendFrame(OutboundQoS qos, const uint8_t (*messages)[3],
+                                          size_t count)
+{
+    if (qos < 0 || qos >= OUTBOUND_QOS_COUNT || (!messages && count > 0)) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    if (!running || stop_requested) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    APCMiniError result = APC_SUCCESS;
+    bigtime_t now = system_time();
+    for (size_t i = 0; i < count && result == APC_SUCCESS; i++) {
+        result = EnqueueLocked(qos, messages[i][0], messages[i][1], messages[i][2], now);
+    }
+
+    if (writer_idle && count > 0) {
+        guard.unlock();
+        work_available.notify_one();
+    }
+    return result;
+}
+
+APCMiniError OutboundScheduler::SendSysEx(const uint8_t* data, size_t length)
+{
+    if (!data || length < 2 || data[0] != 0xF0 || data[length - 1] != 0xF7 || !send_sysex) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    if (!running || stop_requested) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    PendingSysEx sysex;
+    sysex.data.assign(data, data + length);
+    sysex.enqueued_at = system_time();
+    sysex.sequence = ++next_sequence;
+    sysex_queue.push_back(std::move(sysex));
+    counters[OUTBOUND_QOS_BULK].enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    if (writer_idle) {
+        guard.unlock();
+        work_available.notify_one();
+    }
+    return APC_SUCCESS;
+}
+
+bool OutboundScheduler::HasPendingLocked() const
+{
+    for (size_t i = 0; i < OUTBOUND_QOS_COUNT; i++) {
+        if (queues[i].count > 0) {
+            return true;
+        }
+    }
+    return animation_count > 0 || !sysex_queue.empty();
+}
+
+size_t OutboundScheduler::Pending() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return PendingLocked();
+}
+
+size_t OutboundScheduler::PendingLocked() const
+{
+    size_t pending = animation_count + sysex_queue.size();
+    for (size_t i = 0; i < OUTBOUND_QOS_COUNT; i++) {
+        pending += queues[i].count;
+    }
+    return pending;
+}
+
+uint64_t OutboundScheduler::EnqueuedTotal() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < OUTBOUND_QOS_COUNT; i++) {
+        total += counters[i].enqueued.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+BatchTunerConfig OutboundScheduler::TunerConfigFor(const OutboundSchedulerConfig& config)
+{
+    BatchTunerConfig tuning = config.tuning;
+    size_t max_transfer = config.max_transfer == 0 || config.max_transfer > MAX_TRANSFER
+                        ? MAX_TRANSFER : config.max_transfer;
+    if (tuning.max_batch == 0 || tuning.max_batch > max_transfer) {
+        tuning.max_batch = (uint16_t)max_transfer;
+    }
+    // Nothing is held back to fill a transfer; only its size is searched
+    tuning.max_flush_us = tuning.min_flush_us;
+    return tuning;
+}
+
+// Stale: superseded by a newer message for the same key queued or sent in a
+// higher class (latest_sequence is stamped at enqueue). That one drains
+// first or has already gone out, so sending this one after it would undo
+// it. Newer messages in lower classes are sent after this one anyway.
+bool OutboundScheduler::IsStaleLocked(const PendingMessage& message) const
+{
+    if (!config.prioritize || message.key == NO_KEY) {
+        return false;
+    }
+    for (uint8_t qos = 0; qos < message.qos; qos++) {
+        if (latest_sequence[message.key][qos] > message.sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OutboundScheduler::TakeFromQueueLocked(MessageQueue& queue, size_t limit,
+                                            uint64_t stop_before)
+{
+    while (queue.count > 0 && transfer_count < limit) {
+        const PendingMessage& message = queue.entries[queue.head];
+        if (message.sequence > stop_before) {
+            break;      // A SysEx queued earlier goes first
+        }
+        queue.head = (queue.head + 1) % MAX_PENDING;
+        queue.count--;
+
+        if (IsStaleLocked(message)) {
+            counters[message.qos].superseded.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        memcpy(transfer[transfer_count], message.bytes, 3);
+        transfer_meta[transfer_count] = message;
+        transfer_count++;
+    }
+}
+
+void OutboundScheduler::TakeAnimationLocked(size_t limit)
+{
+    while (animation_count > 0 && transfer_count < limit) {
+        uint16_t key = animation_order[animation_head];
+        animation_head = (animation_head + 1) % KEY_COUNT;
+        animation_count--;
+
+        AnimationSlot& slot = animation[key];
+        slot.queued = false;
+        if (!slot.pending) {
+            continue;   // Taken over by another class since it was queued
+        }
+        slot.pending = false;
+
+        PendingMessage& message = transfer_meta[transfer_count];
+        memcpy(message.bytes, slot.bytes, 3);
+        message.qos = OUTBOUND_QOS_ANIMATION;
+        message.key = key;
+        message.enqueued_at = slot.enqueued_at;
+        message.sequence = slot.sequence;
+        memcpy(transfer[transfer_count], slot.bytes, 3);
+        transfer_count++;
+    }
+}
+
+uint64_t OutboundScheduler::OldestSysExLocked() const
+{
+    return sysex_queue.empty() ? NO_SEQUENCE : sysex_queue.front().sequence;
+}
+
+// The bulk class is in arrival order across short messages and SysEx
+bool OutboundScheduler::SysExIsNextLocked() const
+{
+    const MessageQueue& bulk = queues[config.prioritize ? OUTBOUND_QOS_BULK : 0];
+    return !sysex_queue.empty() &&
+           (bulk.count == 0 || bulk.entries[bulk.head].sequence > OldestSysExLocked());
+}
+
+bool OutboundScheduler::BulkDueLocked(bigtime_t now) const
+{
+    const MessageQueue& bulk = queues[OUTBOUND_QOS_BULK];
+    bigtime_t oldest = -1;
+    if (bulk.count > 0) {
+        oldest = bulk.entries[bulk.head].enqueued_at;
+    }
+    if (!sysex_queue.empty() && (oldest < 0 || sysex_queue.front().enqueued_at < oldest)) {
+        oldest = sysex_queue.front().enqueued_at;
+    }
+    return oldest >= 0 && now - oldest >= config.bulk_max_wait_us;
+}
+
+void OutboundScheduler::RecordCompletion(const PendingMessage& message, bigtime_t completed_at,
+                                         bool success)
+{
+    ClassCounters& counter = counters[message.qos];
+    if (!success) {
+        counter.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bigtime_t latency = completed_at - message.enqueued_at;
+    counter.sent.fetch_add(1, std::memory_order_relaxed);
+    counter.latency_sum_us.fetch_add((uint64_t)latency, std::memory_order_relaxed);
+    if (latency > counter.max_latency_us.load(std::memory_order_relaxed)) {
+        counter.max_latency_us.store(latency, std::memory_order_relaxed);
+    }
+    if (completion_hook) {
+        completion_hook((OutboundQoS)message.qos, message.bytes, message.enqueued_at,
+                        completed_at);
+    }
+}
+
+void OutboundScheduler::WriterThreadLoop()
+{
+    ScopedThreadAccounting accounting("outbound");
+
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        if (!HasPendingLocked()) {
+            if (stop_requested) {
+                break;      // Everything queued before Stop() has been sent
+            }
+            writer_idle = true;
+            work_available.wait(guard, [this]() {
+                return stop_requested || HasPendingLocked();
+            });
+            writer_idle = false;
+            continue;
+        }
+
+        // Fill one transfer: interactive, state sync, aged bulk, a chunk
+        // of animation, and bulk only when nothing else is waiting
+        size_t max_transfer = config.autotune ? tuner.Current().batch_size : config.max_transfer;
+        bool sysex_turn = false;
+        transfer_count = 0;
+
+        if (config.prioritize) {
+            TakeFromQueueLocked(queues[OUTBOUND_QOS_INTERACTIVE], max_transfer, NO_SEQUENCE);
+            TakeFromQueueLocked(queues[OUTBOUND_QOS_STATE_SYNC], max_transfer, NO_SEQUENCE);
+
+            bool bulk_due = BulkDueLocked(system_time());
+            if (bulk_due) {
+                TakeFromQueueLocked(queues[OUTBOUND_QOS_BULK], max_transfer, OldestSysExLocked());
+            }
+            if (bulk_due && transfer_count == 0 && SysExIsNextLocked()) {
+                sysex_turn = true;      // An aged SysEx goes before animation
+            } else {
+                size_t room = max_transfer - transfer_count;
+                size_t chunk = room < config.animation_chunk ? room : config.animation_chunk;
+                TakeAnimationLocked(transfer_count + chunk);
+                if (transfer_count == 0) {
+                    TakeFromQueueLocked(queues[OUTBOUND_QOS_BULK], max_transfer,
+                                        OldestSysExLocked());
+                    sysex_turn = transfer_count == 0 && SysExIsNextLocked();
+                }
+            }
+        } else {
+            TakeFromQueueLocked(queues[0], max_transfer, OldestSysExLocked());
+            sysex_turn = transfer_count == 0 && !sysex_queue.empty();
+        }
+
+        if (sysex_turn) {
+            PendingSysEx sysex = std::move(sysex_queue.front());
+            sysex_queue.pop_front();
+
+            guard.unlock();
+            APCMiniError result = send_sysex(sysex.data.data(), sysex.data.size());
+            bigtime_t completed_at = system_time();
+            ThreadAccounting::NoteWakeup();
+
+            PendingMessage message;
+            memcpy(message.bytes, sysex.data.data(), sysex.data.size() < 3 ? sysex.data.size() : 3);
+            message.qos = OUTBOUND_QOS_BULK;
+            message.key = NO_KEY;
+            message.enqueued_at = sysex.enqueued_at;
+            message.sequence = sysex.sequence;
+            RecordCompletion(message, completed_at, result == APC_SUCCESS);
+            guard.lock();
+            continue;
+        }
+
+        if (transfer_count == 0) {
+            continue;       // Only stale entries were left
+        }
+
+        // The transfer buffers belong to this thread; producers only touch
+        // the queues, so they can keep enqueuing while the link is busy
+        size_t count = transfer_count;
+        guard.unlock();
+        APCMiniError result = send_batch(transfer, count);
+        bigtime_t completed_at = system_time();
+        ThreadAccounting::NoteWakeup();
+        bigtime_t latency_sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            RecordCompletion(transfer_meta[i], completed_at, result == APC_SUCCESS);
+            latency_sum += completed_at - transfer_meta[i].enqueued_at;
+        }
+        guard.lock();
+
+        if (config.autotune) {
+            uint64_t enqueued = EnqueuedTotal();
+            tuner.RecordOffered((size_t)(enqueued - tuner_enqueued));
+            tuner_enqueued = enqueued;
+            if (result == APC_SUCCESS) {
+                tuner.RecordTransfer(count, latency_sum);
+            }
+            if (tuner.EndEpochIfDue(completed_at, PendingLocked())) {
+                transfer_size.store(tuner.Current().batch_size, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+OutboundClassStats OutboundScheduler::GetStats(OutboundQoS qos) const
+{
+    OutboundClassStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (qos < 0 || qos >= OUTBOUND_QOS_COUNT) {
+        return stats;
+    }
+
+    const ClassCounters& counter = counters[qos];
+    stats.enqueued = counter.enqueued.load(std::memory_order_relaxed);
+    stats.sent = counter.sent.load(std::memory_order_relaxed);
+    stats.superseded = counter.superseded.load(std::memory_order_relaxed);
+    stats.dropped = counter.dropped.load(std::memory_order_relaxed);
+    stats.latency_sum_us = counter.latency_sum_us.load(std::memory_order_relaxed);
+    stats.max_latency_us = counter.max_latency_us.load(std::memory_order_relaxed);
+    return stats;
+}
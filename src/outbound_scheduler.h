@@ -0,0 +1,240 @@
+#ifndef OUTBOUND_SCHEDULER_H
+#define OUTBOUND_SCHEDULER_H
+
+/*
+ * Outbound QoS Scheduler
+ *
+ * Every outbound message used to go straight to the transport in the order
+ * it was produced, so a pad pressed while a full-grid animation frame was
+ * being written lit its LED only after the whole frame. Outbound traffic
+ * is now tagged with a class and one writer thread decides what goes into
+ * each USB transfer:
+ *
+ *   Class         Typical traffic                  Served
+ *   interactive   Feedback for a press/click       First, always
+ *   state sync    Restores, resets, button state   After interactive, in order
+ *   animation     Pattern and animation frames     A bounded chunk per transfer
+ *   bulk config   SysEx, configuration dumps       When the link is otherwise idle
+ *
+ * - Animation keeps only the latest value per LED: a frame that arrives
+ *   while the previous one is still pending replaces it in place, so a
+ *   frame source faster than the link drops superseded frames instead of
+ *   building a backlog
+ * - Last write wins across classes: a message for an LED (note) or
+ *   controller makes older pending messages for it in lower classes stale,
+ *   so a queued reset or frame never overwrites newer feedback once the
+ *   feedback has jumped ahead of it
+ * - A transfer already on the wire cannot be preempted; animation goes out
+ *   in chunks of at most animation_chunk packets so feedback never waits
+ *   behind a whole frame (32 packets fit one 1 ms full-speed USB frame)
+ * - Bulk traffic that has waited bulk_max_wait_us is promoted ahead of
+ *   animation, so continuous animation cannot starve it
+ *
+ * With prioritize off every message goes through one FIFO in arrival
+ * order, which is how the app behaved before (kept for comparison).
+ *
+ * With autotune on, the packets per transfer are chosen at runtime by a
+ * BatchAutotuner (transfer_batcher.h) within [tuning.min_batch,
+ * max_transfer], scored on the writer's own transfers. Only the transfer
+ * size is tuned: the writer never holds messages back to fill a transfer,
+ * so the tuner's flush interval is pinned.
+ *
+ * Metrics: "outbound.<class>.enqueued", ".sent", ".superseded", ".dropped"
+ * for class interactive, state_sync, animation and bulk.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "apc_mini_platform.h"
+#include "transfer_batcher.h"
+#include "apc_mini_defs.h"
+
+class MetricsRegistry;
+
+enum OutboundQoS {
+    OUTBOUND_QOS_INTERACTIVE = 0,
+    OUTBOUND_QOS_STATE_SYNC,
+    OUTBOUND_QOS_ANIMATION,
+    OUTBOUND_QOS_BULK,
+    OUTBOUND_QOS_COUNT
+};
+
+const char* OutboundQoSName(OutboundQoS qos);
+
+struct OutboundSchedulerConfig {
+    uint16_t max_transfer;          // Packets per USB transfer (upper bound when tuned)
+    uint16_t animation_chunk;       // Animation packets per transfer
+    bigtime_t bulk_max_wait_us;     // Older bulk traffic goes ahead of animation
+    bool prioritize;                // false: one FIFO in arrival order
+    bool autotune;                  // Tune packets per transfer at runtime
+    BatchTunerConfig tuning;        // Used when autotune is set
+
+    static OutboundSchedulerConfig Defaults() {
+        OutboundSchedulerConfig config;
+        config.max_transfer = 64;
+        config.animation_chunk = 32;
+        config.bulk_max_wait_us = 100000;
+        config.prioritize = true;
+        config.autotune = false;
+        config.tuning = BatchTunerConfig::Defaults();
+        return config;
+    }
+};
+
+struct OutboundClassStats {
+    uint64_t enqueued;              // Messages (or SysEx) accepted
+    uint64_t sent;                  // Handed to the transport
+    uint64_t superseded;            // Replaced or made stale by a newer message
+    uint64_t dropped;               // Queue full or transport error
+    uint64_t latency_sum_us;        // Enqueue to transfer completion, sent messages
+    bigtime_t max_latency_us;
+};
+
+class OutboundScheduler {
+public:
+    static const size_t MAX_TRANSFER = 128;
+    static const size_t MAX_PENDING = 1024;     // Per FIFO class
+    static const size_t KEY_COUNT = 256;        // 128 notes, then 128 controllers
+
+    // Called on the writer thread, never with the scheduler lock held
+    typedef std::function<APCMiniError(const uint8_t (*messages)[3], size_t count)> BatchSendFunction;
+    typedef std::function<APCMiniError(const uint8_t* data, size_t length)> SysExSendFunction;
+    typedef std::function<void(OutboundQoS qos, const uint8_t* message,
+                               bigtime_t enqueued_at, bigtime_t completed_at)> CompletionHook;
+
+    OutboundScheduler(BatchSendFunction send_batch, SysExSendFunction send_sysex = nullptr,
+                      const OutboundSchedulerConfig& config = OutboundSchedulerConfig::Defaults(),
+                      MetricsRegistry* registry = nullptr);
+    ~OutboundScheduler();
+
+    APCMiniError Start();
+    void Stop();                    // Sends what is still pending first
+    bool IsRunning() const { return running.load(); }
+
+    // Called for every message that reached the transport (for SysEx,
+    // message is the start of the SysEx); set before Start()
+    void SetCompletionHook(CompletionHook hook) { completion_hook = hook; }
+
+    /**
+     * Queue one short message
+     *
+     * Animation messages other than notes and CCs have no LED to merge on
+     * and are queued as state sync.
+     *
+     * @return APC_ERROR_TIMEOUT if the class queue is full,
+     *         APC_ERROR_DEVICE_NOT_FOUND if the writer is not running
+     */
+    APCMiniError Send(OutboundQoS qos, uint8_t status, uint8_t data1, uint8_t data2);
+
+    // Queue a frame or batch under one lock; stops at the first full queue
+    APCMiniError SendFrame(OutboundQoS qos, const uint8_t (*messages)[3], size_t count);
+
+    // Queue a complete SysEx message as bulk traffic
+    APCMiniError SendSysEx(const uint8_t* data, size_t length);
+
+    const OutboundSchedulerConfig& GetConfig() const { return config; }
+
+    // Packets per transfer the writer uses now (max_transfer unless tuned)
+    size_t TransferSize() const { return transfer_size.load(std::memory_order_relaxed); }
+    size_t Pending() const;         // Includes stale messages not yet discarded
+    OutboundClassStats GetStats(OutboundQoS qos) const;
+
+private:
+    static const uint16_t NO_KEY = 0xFFFF;
+
+    struct PendingMessage {
+        uint8_t bytes[3];
+        uint8_t qos;
+        uint16_t key;
+        bigtime_t enqueued_at;
+        uint64_t sequence;
+    };
+
+    struct MessageQueue {
+        PendingMessage entries[MAX_PENDING];
+        size_t head;
+        size_t count;
+    };
+
+    struct AnimationSlot {
+        uint8_t bytes[3];
+        bool pending;               // Has a value to send
+        bool queued;                // Key is in animation_order
+        bigtime_t enqueued_at;
+        uint64_t sequence;
+    };
+
+    struct PendingSysEx {
+        std::vector<uint8_t> data;
+        bigtime_t enqueued_at;
+        uint64_t sequence;
+    };
+
+    struct ClassCounters {
+        std::atomic<uint64_t> enqueued;
+        std::atomic<uint64_t> sent;
+        std::atomic<uint64_t> superseded;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> latency_sum_us;
+        std::atomic<int64_t> max_latency_us;
+    };
+
+    static uint16_t KeyFor(uint8_t status, uint8_t data1);
+    static BatchTunerConfig TunerConfigFor(const OutboundSchedulerConfig& config);
+
+    APCMiniError EnqueueLocked(OutboundQoS qos, uint8_t status, uint8_t data1, uint8_t data2,
+                               bigtime_t now);
+    bool HasPendingLocked() const;
+    size_t PendingLocked() const;
+    uint64_t EnqueuedTotal() const;
+    bool IsStaleLocked(const PendingMessage& message) const;
+    void TakeFromQueueLocked(MessageQueue& queue, size_t limit, uint64_t stop_before);
+    void TakeAnimationLocked(size_t limit);
+    uint64_t OldestSysExLocked() const;
+    bool SysExIsNextLocked() const;
+    bool BulkDueLocked(bigtime_t now) const;
+    void RecordCompletion(const PendingMessage& message, bigtime_t completed_at, bool success);
+    void WriterThreadLoop();
+
+    BatchSendFunction send_batch;
+    SysExSendFunction send_sysex;
+    OutboundSchedulerConfig config;
+    MetricsRegistry* registry;
+    CompletionHook completion_hook;
+
+    mutable std::mutex lock;
+    std::condition_variable work_available;
+    bool stop_requested;
+    bool writer_idle;
+    std::atomic<bool> running;
+    std::thread writer_thread;
+
+    uint64_t next_sequence;
+    uint64_t latest_sequence[KEY_COUNT][OUTBOUND_QOS_COUNT];   // Newest message per key and class
+    MessageQueue queues[OUTBOUND_QOS_COUNT];// Animation uses its queue only in FIFO mode
+    AnimationSlot animation[KEY_COUNT];
+    uint16_t animation_order[KEY_COUNT];    // Ring of keys, oldest first
+    size_t animation_head;
+    size_t animation_count;                 // Keys in animation_order
+    std::deque<PendingSysEx> sysex_queue;
+
+    // Writer thread only: the transfer being built
+    uint8_t transfer[MAX_TRANSFER][3];
+    PendingMessage transfer_meta[MAX_TRANSFER];
+    size_t transfer_count;
+    BatchAutotuner tuner;                   // Fed only when config.autotune
+    uint64_t tuner_enqueued;                // EnqueuedTotal() last fed to the tuner
+    std::atomic<size_t> transfer_size;
+
+    ClassCounters counters[OUTBOUND_QOS_COUNT];
+};
+
+#endif // OUTBOUND_SCHEDULER_H
@@ -0,0 +1,160 @@
+// Outbound Scheduler Benchmark
+// Pad-press-to-LED latency while a full-grid animation runs on the
+// simulated full-speed MK2 link: every outbound message in one FIFO (the
+// old behaviour) versus QoS classes with feedback served first. A press
+// counts as lit when the transfer carrying its feedback LED completes.
+//
+// Usage: outbound_scheduler_benchmark [--seconds <s>] [--press-ms <interval>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "outbound_scheduler.h"
+#include "midi_transport.h"
+
+struct FeedbackResult {
+    bigtime_t p50_us;
+    bigtime_t p99_us;
+    bigtime_t max_us;
+    uint64_t presses;
+    uint64_t lit;                   // Feedback that reached the device
+    double frames_per_sec;          // Animation frames' worth of LEDs delivered
+    uint64_t superseded;            // Animation values merged away
+};
+
+static bigtime_t Percentile(const std::vector<bigtime_t>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+static FeedbackResult Measure(bool prioritize, int fps, double seconds, int press_ms)
+{
+    SimulatedDeviceTransport device;
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    OutboundSchedulerConfig config = OutboundSchedulerConfig::Defaults();
+    config.prioritize = prioritize;
+    OutboundScheduler scheduler(
+        [&device](const uint8_t (*messages)[3], size_t count) {
+            return device.SendMIDIBatch(messages, count);
+        },
+        [&device](const uint8_t* data, size_t length) {
+            return device.SendSysEx(data, length);
+        },
+        config);
+
+    std::mutex latency_lock;
+    std::vector<bigtime_t> latencies;
+    scheduler.SetCompletionHook([&](OutboundQoS qos, const uint8_t*, bigtime_t enqueued_at,
+                                    bigtime_t completed_at) {
+        if (qos == OUTBOUND_QOS_INTERACTIVE) {
+            std::lock_guard<std::mutex> guard(latency_lock);
+            latencies.push_back(completed_at - enqueued_at);
+        }
+    });
+    scheduler.Start();
+
+    // A color wave over all 64 pads, one frame per tick
+    std::atomic<bool> animating(true);
+    std::thread animation([&scheduler, &animating, fps]() {
+        uint8_t frame[APC_MINI_PAD_COUNT][3];
+        bigtime_t next = system_time();
+        for (uint32_t step = 0; animating.load(); step++) {
+            for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+                frame[pad][0] = MIDI_NOTE_ON | 6;
+                frame[pad][1] = pad;
+                frame[pad][2] = (uint8_t)((pad + step) % 120 + 1);
+            }
+            scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT);
+            next += 1000000 / fps;
+            snooze_until(next, B_SYSTEM_TIMEBASE);
+        }
+    });
+
+    // Presses at jittered intervals on random pads
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> jitter(press_ms * 500, press_ms * 1500);
+    std::uniform_int_distribution<int> pad(0, APC_MINI_PAD_COUNT - 1);
+    uint64_t presses = 0;
+    bigtime_t end = system_time() + (bigtime_t)(seconds * 1000000);
+    while (system_time() < end) {
+        snooze(jitter(rng));
+        scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, (uint8_t)pad(rng), 127);
+        presses++;
+    }
+
+    animating = false;
+    animation.join();
+    scheduler.Stop();
+    device.Close();
+
+    FeedbackResult result;
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_us = Percentile(latencies, 0.50);
+    result.p99_us = Percentile(latencies, 0.99);
+    result.max_us = latencies.empty() ? 0 : latencies.back();
+    result.presses = presses;
+    result.lit = latencies.size();
+    OutboundClassStats animation_stats = scheduler.GetStats(OUTBOUND_QOS_ANIMATION);
+    result.frames_per_sec = animation_stats.sent / (double)APC_MINI_PAD_COUNT / seconds;
+    result.superseded = animation_stats.superseded;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 3.0;
+    int press_ms = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--press-ms") == 0 && i + 1 < argc) {
+            press_ms = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--seconds <s>] [--press-ms <interval>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seconds <= 0 || press_ms <= 0) {
+        printf("❌ --seconds and --press-ms must be positive\n");
+        return 1;
+    }
+
+    printf("🚦 Outbound Scheduler Benchmark (%.0f s per run, a press every ~%d ms)\n",
+           seconds, press_ms);
+    printf("   Pad press to feedback LED during a 64-pad animation, simulated full-speed MK2\n\n");
+    printf("   %-6s %-5s %9s %9s %9s %8s %10s %11s\n", "Anim", "Mode", "p50 us", "p99 us",
+           "max us", "Lit", "Frames/s", "Superseded");
+
+    const int rates[] = { 60, 250, 1000 };
+    for (int fps : rates) {
+        for (int mode = 0; mode < 2; mode++) {
+            bool prioritize = mode == 1;
+            FeedbackResult result = Measure(prioritize, fps, seconds, press_ms);
+            char anim[16];
+            snprintf(anim, sizeof(anim), "%d/s", fps);
+            printf("   %-6s %-5s %9lld %9lld %9lld %4llu/%-4llu %9.1f %11llu\n",
+                   mode == 0 ? anim : "", prioritize ? "QoS" : "FIFO",
+                   (long long)result.p50_us, (long long)result.p99_us, (long long)result.max_us,
+                   (unsigned long long)result.lit, (unsigned long long)result.presses,
+                   result.frames_per_sec, (unsigned long long)result.superseded);
+        }
+    }
+
+    printf("\n   FIFO queues feedback behind whole frames and, past the link rate,\n");
+    printf("   behind a growing backlog; QoS waits for at most one animation chunk.\n");
+    return 0;
+}
@@ -0,0 +1,466 @@
+/*
+ * Outbound Scheduler Test
+ * Class order inside a transfer, bounded animation chunks, latest-value
+ * animation frames, last write wins across classes, bulk ordering and
+ * aging, the FIFO comparison mode, feedback latency on the simulated MK2
+ * during continuous animation, and autotuned transfer sizes
+ */
+
+#include "outbound_scheduler.h"
+#include "metrics_registry.h"
+#include "midi_transport.h"
+#include <stdio.h>
+#include <assert.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::array<uint8_t, 3> Message;
+
+// Records every transfer; while closed, the writer blocks inside a send
+struct GatedLink {
+    std::mutex lock;
+    std::condition_variable changed;
+    bool open = true;
+    bigtime_t send_cost_us = 0;
+    std::vector<std::vector<Message>> transfers;
+    std::vector<std::vector<uint8_t>> sysex;
+    std::vector<int> order;             // Transfer index, or -1 - SysEx index
+
+    OutboundScheduler::BatchSendFunction Batch() {
+        return [this](const uint8_t (*messages)[3], size_t count) {
+            std::unique_lock<std::mutex> guard(lock);
+            std::vector<Message> transfer;
+            for (size_t i = 0; i < count; i++) {
+                transfer.push_back({ messages[i][0], messages[i][1], messages[i][2] });
+            }
+            order.push_back((int)transfers.size());
+            transfers.push_back(transfer);
+            changed.notify_all();
+            changed.wait(guard, [this]() { return open; });
+            guard.unlock();
+            if (send_cost_us > 0) {
+                snooze(send_cost_us);
+            }
+            return APC_SUCCESS;
+        };
+    }
+
+    OutboundScheduler::SysExSendFunction SysEx() {
+        return [this](const uint8_t* data, size_t length) {
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(-1 - (int)sysex.size());
+            sysex.push_back(std::vector<uint8_t>(data, data + length));
+            changed.notify_all();
+            return APC_SUCCESS;
+        };
+    }
+
+    void SetOpen(bool value) {
+        std::lock_guard<std::mutex> guard(lock);
+        open = value;
+        changed.notify_all();
+    }
+
+    void WaitForTransfers(size_t count) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this, count]() { return transfers.size() >= count; });
+    }
+
+    // Replays every note message in send order; -1 = never written
+    void Replay(int velocities[128]) {
+        for (int i = 0; i < 128; i++) {
+            velocities[i] = -1;
+        }
+        for (const std::vector<Message>& transfer : transfers) {
+            for (const Message& message : transfer) {
+                uint8_t type = message[0] & 0xF0;
+                if (type == MIDI_NOTE_ON) {
+                    velocities[message[1]] = message[2];
+                } else if (type == MIDI_NOTE_OFF) {
+                    velocities[message[1]] = 0;
+                }
+            }
+        }
+    }
+};
+
+static void BuildFrame(uint8_t frame[APC_MINI_PAD_COUNT][3], uint8_t velocity)
+{
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        frame[pad][0] = MIDI_NOTE_ON | 6;
+        frame[pad][1] = pad;
+        frame[pad][2] = velocity;
+    }
+}
+
+// Start the scheduler with its writer parked inside a send, so everything
+// queued next is scheduled together once the link opens
+static void StartBlocked(OutboundScheduler& scheduler, GatedLink& link)
+{
+    link.SetOpen(false);
+    assert(scheduler.Start() == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_ON, 120, 1) == APC_SUCCESS);
+    link.WaitForTransfers(1);
+}
+
+void test_class_order()
+{
+    printf("Testing class order inside transfers...\n");
+
+    GatedLink link;
+    MetricsRegistry registry;
+    OutboundScheduler scheduler(link.Batch(), link.SysEx(),
+                                OutboundSchedulerConfig::Defaults(), &registry);
+    StartBlocked(scheduler, link);
+
+    // Queued in the worst order: bulk, a full frame, state, then feedback
+    assert(scheduler.Send(OUTBOUND_QOS_BULK, MIDI_CONTROL_CHANGE, 10, 1) == APC_SUCCESS);
+    uint8_t frame[APC_MINI_PAD_COUNT][3];
+    BuildFrame(frame, 21);
+    assert(scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT) == APC_SUCCESS);
+    for (uint8_t i = 0; i < 8; i++) {
+        assert(scheduler.Send(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_ON, 100 + i, 1) == APC_SUCCESS);
+    }
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 70, 5) == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 71, 5) == APC_SUCCESS);
+    assert(scheduler.Pending() == 1 + APC_MINI_PAD_COUNT + 8 + 2);
+
+    link.SetOpen(true);
+    scheduler.Stop();
+
+    // Feedback, then state, then one animation chunk share the next transfer
+    const std::vector<Message>& next = link.transfers[1];
+    size_t chunk = scheduler.GetConfig().animation_chunk;
+    assert(next.size() == 2 + 8 + chunk);
+    assert(next[0][1] == 70 && next[1][1] == 71);
+    for (size_t i = 0; i < 8; i++) {
+        assert(next[2 + i][1] == 100 + i);
+    }
+    for (size_t i = 0; i < chunk; i++) {
+        assert(next[10 + i][1] == i);
+    }
+
+    // The rest of the frame goes out in chunks, and bulk comes last
+    size_t animation_sent = chunk;
+    for (size_t t = 2; t + 1 < link.transfers.size(); t++) {
+        assert(link.transfers[t].size() <= chunk);
+        animation_sent += link.transfers[t].size();
+    }
+    assert(animation_sent == APC_MINI_PAD_COUNT);
+    assert(link.transfers.back().size() == 1 && link.transfers.back()[0][1] == 10);
+
+    assert(scheduler.GetStats(OUTBOUND_QOS_INTERACTIVE).sent == 2);
+    assert(scheduler.GetStats(OUTBOUND_QOS_ANIMATION).sent == APC_MINI_PAD_COUNT);
+    assert(scheduler.GetStats(OUTBOUND_QOS_BULK).sent == 1);
+    MetricSample sample;
+    assert(registry.Find("outbound.state_sync.sent", sample) && sample.value == 9);
+    assert(registry.Find("outbound.interactive.enqueued", sample) && sample.value == 2);
+
+    printf("✅ Feedback first, animation in %zu-packet chunks, bulk last (%zu transfers)\n",
+           chunk, link.transfers.size());
+}
+
+void test_animation_supersede()
+{
+    printf("Testing latest-value animation frames...\n");
+
+    GatedLink link;
+    OutboundScheduler scheduler(link.Batch(), link.SysEx());
+    StartBlocked(scheduler, link);
+
+    // Ten frames pile up behind a busy link; only the last one is sent
+    uint8_t frame[APC_MINI_PAD_COUNT][3];
+    for (uint8_t velocity = 1; velocity <= 10; velocity++) {
+        BuildFrame(frame, velocity);
+        assert(scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT) ==
+               APC_SUCCESS);
+    }
+    assert(scheduler.Pending() == APC_MINI_PAD_COUNT);
+
+    link.SetOpen(true);
+    scheduler.Stop();
+
+    int velocities[128];
+    link.Replay(velocities);
+    size_t packets = 0;
+    for (size_t t = 1; t < link.transfers.size(); t++) {
+        packets += link.transfers[t].size();
+    }
+    assert(packets == APC_MINI_PAD_COUNT);
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        assert(velocities[pad] == 10);
+    }
+
+    OutboundClassStats stats = scheduler.GetStats(OUTBOUND_QOS_ANIMATION);
+    assert(stats.enqueued == 10 * APC_MINI_PAD_COUNT);
+    assert(stats.sent == APC_MINI_PAD_COUNT);
+    assert(stats.superseded == 9 * APC_MINI_PAD_COUNT);
+
+    printf("✅ 10 queued frames sent as 1, %llu values superseded\n",
+           (unsigned long long)stats.superseded);
+}
+
+void test_last_write_wins()
+{
+    printf("Testing last write wins across classes...\n");
+
+    GatedLink link;
+    OutboundScheduler scheduler(link.Batch(), link.SysEx());
+    StartBlocked(scheduler, link);
+
+    // A reset is still queued when the user presses pad 5
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        assert(scheduler.Send(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_OFF, pad, 0) == APC_SUCCESS);
+    }
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 5, 3) == APC_SUCCESS);
+
+    // A pending animation value loses to later feedback; a later frame
+    // value is sent after the feedback, which still lights first
+    assert(scheduler.Send(OUTBOUND_QOS_ANIMATION, MIDI_NOTE_ON, 7, 45) == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 7, 9) == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 8, 9) == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_ANIMATION, MIDI_NOTE_ON, 8, 13) == APC_SUCCESS);
+
+    link.SetOpen(true);
+    scheduler.Stop();
+
+    int velocities[128];
+    link.Replay(velocities);
+    assert(velocities[5] == 3);
+    assert(velocities[7] == 9);
+    assert(velocities[8] == 13);
+    assert(velocities[0] == 0 && velocities[63] == 0);
+
+    // The stale reset of pads 5, 7 and 8 was never sent
+    assert(scheduler.GetStats(OUTBOUND_QOS_STATE_SYNC).superseded == 3);
+    assert(scheduler.GetStats(OUTBOUND_QOS_INTERACTIVE).superseded == 0);
+    assert(scheduler.GetStats(OUTBOUND_QOS_INTERACTIVE).sent == 3);
+    assert(scheduler.GetStats(OUTBOUND_QOS_ANIMATION).superseded == 1);
+
+    printf("✅ Newer feedback survives a queued reset and stale frames\n");
+}
+
+void test_bulk_order_and_aging()
+{
+    printf("Testing bulk ordering and aging...\n");
+
+    // SysEx keeps its place among bulk short messages
+    {
+        GatedLink link;
+        OutboundScheduler scheduler(link.Batch(), link.SysEx());
+        StartBlocked(scheduler, link);
+
+        const uint8_t sysex[] = { 0xF0, 0x47, 0x7F, 0x4F, 0x60, 0x00, 0x04, 0x00, 0x01, 0x00, 0x00, 0xF7 };
+        assert(scheduler.Send(OUTBOUND_QOS_BULK, MIDI_CONTROL_CHANGE, 1, 1) == APC_SUCCESS);
+        assert(scheduler.SendSysEx(sysex, sizeof(sysex)) == APC_SUCCESS);
+        assert(scheduler.Send(OUTBOUND_QOS_BULK, MIDI_CONTROL_CHANGE, 2, 2) == APC_SUCCESS);
+        assert(scheduler.SendSysEx(sysex, sizeof(sysex) - 1) == APC_ERROR_INVALID_PARAMETER);
+
+        link.SetOpen(true);
+        scheduler.Stop();
+
+        assert(link.order.size() == 4);
+        assert(link.order[1] == 1 && link.transfers[1][0][1] == 1);
+        assert(link.order[2] == -1 && link.sysex[0].size() == sizeof(sysex));
+        assert(link.order[3] == 2 && link.transfers[2][0][1] == 2);
+        assert(scheduler.GetStats(OUTBOUND_QOS_BULK).sent == 3);
+    }
+
+    // Continuous animation cannot starve bulk past its maximum wait
+    {
+        GatedLink link;
+        link.send_cost_us = 1000;
+        OutboundSchedulerConfig config = OutboundSchedulerConfig::Defaults();
+        config.bulk_max_wait_us = 20000;
+        OutboundScheduler scheduler(link.Batch(), link.SysEx(), config);
+        assert(scheduler.Start() == APC_SUCCESS);
+
+        uint8_t frame[APC_MINI_PAD_COUNT][3];
+        bool bulk_queued = false;
+        bigtime_t start = system_time();
+        for (uint8_t velocity = 0; system_time() - start < 150000; velocity = (velocity + 1) & 0x7F) {
+            BuildFrame(frame, velocity);
+            scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT);
+            if (!bulk_queued && system_time() - start > 20000) {
+                assert(scheduler.Send(OUTBOUND_QOS_BULK, MIDI_CONTROL_CHANGE, 3, 3) == APC_SUCCESS);
+                bulk_queued = true;
+            }
+            snooze(500);
+        }
+        OutboundClassStats during = scheduler.GetStats(OUTBOUND_QOS_BULK);
+        scheduler.Stop();
+
+        assert(during.sent == 1);
+        assert(during.max_latency_us < config.bulk_max_wait_us + 50000);
+        assert(scheduler.GetStats(OUTBOUND_QOS_ANIMATION).superseded > 0);
+
+        printf("✅ SysEx kept its place; bulk sent after %lld us under continuous animation\n",
+               (long long)during.max_latency_us);
+    }
+}
+
+void test_fifo_mode()
+{
+    printf("Testing the FIFO comparison mode...\n");
+
+    GatedLink link;
+    OutboundSchedulerConfig config = OutboundSchedulerConfig::Defaults();
+    config.prioritize = false;
+    OutboundScheduler scheduler(link.Batch(), link.SysEx(), config);
+    StartBlocked(scheduler, link);
+
+    uint8_t frame[APC_MINI_PAD_COUNT][3];
+    BuildFrame(frame, 1);
+    assert(scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT) == APC_SUCCESS);
+    BuildFrame(frame, 2);
+    assert(scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT) == APC_SUCCESS);
+    assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON | 6, 5, 3) == APC_SUCCESS);
+
+    link.SetOpen(true);
+    scheduler.Stop();
+
+    // Arrival order, both frames, feedback at the very end
+    std::vector<Message> all;
+    for (size_t t = 1; t < link.transfers.size(); t++) {
+        all.insert(all.end(), link.transfers[t].begin(), link.transfers[t].end());
+    }
+    assert(all.size() == 2 * APC_MINI_PAD_COUNT + 1);
+    assert(all[0][2] == 1 && all[APC_MINI_PAD_COUNT][2] == 2);
+    assert(all.back()[1] == 5 && all.back()[2] == 3);
+    assert(scheduler.GetStats(OUTBOUND_QOS_ANIMATION).superseded == 0);
+
+    printf("✅ One queue, arrival order, nothing merged\n");
+}
+
+// Pad feedback while a 100 frames/s full-grid animation saturates the
+// simulated full-speed link; returns the worst feedback latency
+static bigtime_t MeasureFeedback(bool prioritize, int presses)
+{
+    SimulatedDeviceTransport device;
+    device.SetEchoEnabled(false);
+    assert(device.Open() == APC_SUCCESS);
+
+    OutboundSchedulerConfig config = OutboundSchedulerConfig::Defaults();
+    config.prioritize = prioritize;
+    OutboundScheduler scheduler(
+        [&device](const uint8_t (*messages)[3], size_t count) {
+            return device.SendMIDIBatch(messages, count);
+        },
+        [&device](const uint8_t* data, size_t length) {
+            return device.SendSysEx(data, length);
+        },
+        config);
+    assert(scheduler.Start() == APC_SUCCESS);
+
+    std::atomic<bool> animating(true);
+    std::thread animation([&scheduler, &animating]() {
+        uint8_t frame[APC_MINI_PAD_COUNT][3];
+        for (uint8_t step = 0; animating.load(); step++) {
+            BuildFrame(frame, (uint8_t)(step % 64));
+            scheduler.SendFrame(OUTBOUND_QOS_ANIMATION, frame, APC_MINI_PAD_COUNT);
+            snooze(10000);
+        }
+    });
+
+    // Feedback goes to the track buttons, which the animation never touches
+    for (int i = 0; i < presses; i++) {
+        snooze(7000);
+        assert(scheduler.Send(OUTBOUND_QOS_INTERACTIVE, MIDI_NOTE_ON,
+                              (uint8_t)(APC_MINI_TRACK_NOTE_START + i % 8),
+                              (uint8_t)(1 + i % 2)) == APC_SUCCESS);
+    }
+    animating = false;
+    animation.join();
+    scheduler.Stop();
+
+    OutboundClassStats stats = scheduler.GetStats(OUTBOUND_QOS_INTERACTIVE);
+    assert(stats.sent == (uint64_t)presses);
+    int last = presses - 1;
+    assert(device.GetLEDVelocity((uint8_t)(APC_MINI_TRACK_NOTE_START + last % 8)) == 1 + last % 2);
+    device.Close();
+    return stats.max_latency_us;
+}
+
+void test_feedback_latency()
+{
+    printf("Testing feedback latency during animation...\n");
+
+    bigtime_t qos = MeasureFeedback(true, 40);
+    bigtime_t fifo = MeasureFeedback(false, 40);
+
+    // One animation chunk plus the feedback transfer, with slack for a
+    // loaded machine; FIFO is reported for reference only
+    assert(qos < 20000);
+
+    printf("✅ Worst feedback latency %lld us with QoS, %lld us in one FIFO\n",
+           (long long)qos, (long long)fifo);
+}
+
+void test_autotuned_transfers()
+{
+    printf("Testing autotuned transfer size under sustained load...\n");
+
+    // Every transfer costs 300 us, so small transfers cannot keep up
+    GatedLink link;
+    link.send_cost_us = 300;
+    MetricsRegistry registry;
+    OutboundSchedulerConfig config = OutboundSchedulerConfig::Defaults();
+    config.autotune = true;
+    config.tuning.epoch_us = 20000;
+    config.tuning.epoch_min_messages = 32;
+    OutboundScheduler scheduler(link.Batch(), link.SysEx(), config, &registry);
+    const size_t initial = scheduler.TransferSize();
+    assert(initial > 1 && initial < config.max_transfer);
+
+    assert(scheduler.Start() == APC_SUCCESS);
+    uint64_t offered = 0;
+    bigtime_t end = system_time() + 600000;
+    while (system_time() < end) {
+        for (int i = 0; i < 48; i++) {
+            if (scheduler.Send(OUTBOUND_QOS_STATE_SYNC, MIDI_NOTE_ON, (uint8_t)(i % 64), 1) ==
+                APC_SUCCESS) {
+                offered++;
+            }
+        }
+        snooze(1000);
+    }
+    scheduler.Stop();
+
+    size_t delivered = 0;
+    size_t largest = 0;
+    for (const std::vector<Message>& transfer : link.transfers) {
+        delivered += transfer.size();
+        largest = transfer.size() > largest ? transfer.size() : largest;
+    }
+    MetricSample epochs;
+    assert(registry.Find("batcher.tuner_epochs", epochs) && epochs.value > 0);
+    printf("Offered %llu, %zu transfers, size %zu -> %zu, largest %zu, %llu epochs\n",
+           (unsigned long long)offered, link.transfers.size(), initial, scheduler.TransferSize(),
+           largest, (unsigned long long)epochs.value);
+    assert(delivered == offered);
+    assert(largest <= config.max_transfer);
+    assert(scheduler.TransferSize() > initial);
+
+    printf("✅ The writer grows its transfers until it keeps up\n");
+}
+
+int main()
+{
+    printf("🚦 Outbound Scheduler Test\n");
+    printf("==========================\n\n");
+
+    test_class_order();
+    test_animation_supersede();
+    test_last_write_wins();
+    test_bulk_order_and_aging();
+    test_fifo_mode();
+    test_feedback_latency();
+    test_autotuned_transfers();
+
+    printf("\n🎉 ALL TESTS PASSED! Feedback LEDs preempt animation frames.\n");
+    return 0;
+}
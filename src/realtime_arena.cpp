@@ -0,0 +1,185 @@
+#include "realtime_arena.h"
+#include "metrics_registry.h"
+#include <string.h>
+#include <errno.h>
+
+#ifndef __HAIKU__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+RealtimeArena::RealtimeArena()
+    : block_count(0)
+    , reserved_bytes(0)
+    , base(nullptr)
+    , capacity_bytes(0)
+    , next_offset(0)
+    , locked(false)
+#ifdef __HAIKU__
+    , area(-1)
+#endif
+    , registry(nullptr)
+    , capacity_metric(0)
+    , used_bytes(0)
+{
+    memset(blocks, 0, sizeof(blocks));
+}
+
+RealtimeArena::~RealtimeArena()
+{
+    if (registry) {
+        registry->Unregister(&capacity_metric);
+        registry->Unregister(&used_bytes);
+    }
+    Release();
+}
+
+bool RealtimeArena::Reserve(const char* name, size_t size, size_t alignment)
+{
+    if (IsCommitted() || block_count >= MAX_BLOCKS || size == 0 ||
+        alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        return false;
+    }
+
+    blocks[block_count].name = name;
+    blocks[block_count].size = size;
+    blocks[block_count].offset = 0;
+    blocks[block_count].allocated = false;
+    block_count++;
+
+    // Worst-case padding so allocation order does not matter
+    reserved_bytes += size + alignment - 1;
+    return true;
+}
+
+APCMiniError RealtimeArena::Commit(bool lock_pages)
+{
+    if (IsCommitted() || reserved_bytes == 0) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+#ifdef __HAIKU__
+    capacity_bytes = AlignUp(reserved_bytes, B_PAGE_SIZE);
+
+    void* address = nullptr;
+    area = create_area("apc realtime arena", &address, B_ANY_ADDRESS, capacity_bytes,
+                       lock_pages ? B_FULL_LOCK : B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+    if (area < 0) {
+        printf("❌ Realtime arena: create_area(%zu) failed: %s\n", capacity_bytes, strerror(area));
+        capacity_bytes = 0;
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+    base = static_cast<uint8_t*>(address);
+    locked = lock_pages;
+#else
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    capacity_bytes = AlignUp(reserved_bytes, page_size);
+
+    void* address = mmap(nullptr, capacity_bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+        printf("❌ Realtime arena: mmap(%zu) failed: %s\n", capacity_bytes, strerror(errno));
+        capacity_bytes = 0;
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+    base = static_cast<uint8_t*>(address);
+
+    if (lock_pages) {
+        if (mlock(base, capacity_bytes) == 0) {
+            locked = true;
+        } else {
+            printf("⚠️  Realtime arena: mlock(%zu) failed (%s), pages pre-faulted but not locked\n",
+                   capacity_bytes, strerror(errno));
+        }
+    }
+#endif
+
+    // Touch every page so nothing faults on first use from a hot thread
+    // (B_FULL_LOCK and mlock already do this; it is cheap to repeat)
+    memset(base, 0, capacity_bytes);
+
+    next_offset = 0;
+    capacity_metric.store(capacity_bytes, std::memory_order_relaxed);
+    return APC_SUCCESS;
+}
+
+void* RealtimeArena::Allocate(const char* name, size_t size, size_t alignment)
+{
+    if (!IsCommitted() || size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        return nullptr;
+    }
+
+    size_t offset = AlignUp(next_offset, alignment);
+    if (offset + size > capacity_bytes) {
+        printf("❌ Realtime arena exhausted: '%s' needs %zu bytes, %zu free\n",
+               name ? name : "?", size, capacity_bytes - next_offset);
+        return nullptr;
+    }
+    next_offset = offset + size;
+    used_bytes.store(next_offset, std::memory_order_relaxed);
+
+    // Record the placement against the matching reservation
+    for (size_t i = 0; i < block_count; i++) {
+        if (!blocks[i].allocated && name && blocks[i].name && strcmp(blocks[i].name, name) == 0) {
+            blocks[i].offset = offset;
+            blocks[i].size = size;
+            blocks[i].allocated = true;
+            break;
+        }
+    }
+
+    return base + offset;
+}
+
+bool RealtimeArena::Contains(const void* pointer) const
+{
+    const uint8_t* byte = static_cast<const uint8_t*>(pointer);
+    return base && byte >= base && byte < base + capacity_bytes;
+}
+
+void RealtimeArena::RegisterMetrics(MetricsRegistry* metrics_registry)
+{
+    if (registry || !metrics_registry) {
+        return;
+    }
+    registry = metrics_registry;
+    registry->RegisterCounter("rt.arena_bytes", &capacity_metric);
+    registry->RegisterCounter("rt.arena_used_bytes", &used_bytes);
+}
+
+void RealtimeArena::Print(FILE* out) const
+{
+    fprintf(out, "🧠 Realtime memory: %zu bytes mapped, %zu used, %s\n",
+            capacity_bytes, UsedBytes(),
+            !IsCommitted() ? "not committed" : (locked ? "locked" : "pre-faulted (not locked)"));
+
+    for (size_t i = 0; i < block_count; i++) {
+        if (blocks[i].allocated) {
+            fprintf(out, "   %-24s %8zu bytes @ +%zu\n", blocks[i].name, blocks[i].size, blocks[i].offset);
+        } else {
+            fprintf(out, "   %-24s %8zu bytes (reserved, unused)\n", blocks[i].name, blocks[i].size);
+        }
+    }
+}
+
+void RealtimeArena::Release()
+{
+    if (!base) {
+        return;
+    }
+
+#ifdef __HAIKU__
+    delete_area(area);
+    area = -1;
+#else
+    if (locked) {
+        munlock(base, capacity_bytes);
+    }
+    munmap(base, capacity_bytes);
+#endif
+
+    base = nullptr;
+    capacity_bytes = 0;
+    next_offset = 0;
+    locked = false;
+}
@@ -0,0 +1,151 @@
+#ifndef REALTIME_ARENA_H
+#define REALTIME_ARENA_H
+
+/*
+ * Realtime Memory Arena
+ *
+ * Realtime structures (MIDIMessageQueue is ~100 KB) used to come from plain
+ * `new`, so the first touch of each page could page-fault on the USB or
+ * dispatch thread. The arena moves all of that to startup:
+ *
+ * 1. Sizing: every realtime subsystem Reserve()s its block by name
+ * 2. Commit(): one region of the total size is mapped, every page is
+ *    touched (pre-faulted) and optionally locked in RAM
+ *    - Haiku: create_area() with B_FULL_LOCK
+ *    - elsewhere: mmap() + mlock(); a failed mlock (RLIMIT_MEMLOCK) is
+ *      reported but not fatal, the pages stay pre-faulted
+ * 3. Allocation: New<T>() / Allocate() hand out aligned blocks by bumping
+ *    a pointer. Blocks live until the arena is destroyed; Delete<T>() only
+ *    runs the destructor.
+ *
+ * Allocate() is not thread-safe; do it during startup.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+class MetricsRegistry;
+
+class RealtimeArena {
+public:
+    static constexpr size_t DEFAULT_ALIGNMENT = 64;    // Cache line
+    static constexpr size_t MAX_BLOCKS = 32;
+
+    RealtimeArena();
+    ~RealtimeArena();
+
+    /**
+     * Add a block to the arena size (before Commit)
+     *
+     * @return false after Commit() or when MAX_BLOCKS is reached
+     */
+    bool Reserve(const char* name, size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+    template<typename T>
+    bool Reserve(const char* name, size_t count = 1) {
+        return Reserve(name, sizeof(T) * count, alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT);
+    }
+
+    /**
+     * Map, pre-fault and optionally lock the reserved size
+     *
+     * @param lock_pages Keep the pages resident (mlock / B_FULL_LOCK)
+     * @return APC_SUCCESS, or APC_ERROR_INVALID_PARAMETER if already
+     *         committed or nothing was reserved
+     */
+    APCMiniError Commit(bool lock_pages);
+
+    /**
+     * Hand out an aligned block (after Commit)
+     *
+     * @return nullptr if the arena is not committed or exhausted
+     */
+    void* Allocate(const char* name, size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+    template<typename T, typename... Args>
+    T* New(const char* name, Args&&... args) {
+        void* memory = Allocate(name, sizeof(T), alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT);
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Destroy an object created with New(); its memory is not reused
+    template<typename T>
+    static void Delete(T* object) {
+        if (object) {
+            object->~T();
+        }
+    }
+
+    // New(), falling back to the heap when the arena is unavailable or full
+    template<typename T, typename... Args>
+    T* NewOrHeap(const char* name, Args&&... args) {
+        T* object = IsCommitted() ? New<T>(name, std::forward<Args>(args)...) : nullptr;
+        return object ? object : new T(std::forward<Args>(args)...);
+    }
+
+    // Destroy an object from NewOrHeap(), wherever it was placed
+    template<typename T>
+    void Destroy(T* object) const {
+        if (Contains(object)) {
+            Delete(object);
+        } else {
+            delete object;
+        }
+    }
+
+    bool IsCommitted() const { return base != nullptr; }
+    bool IsLocked() const { return locked; }
+    bool Contains(const void* pointer) const;
+
+    size_t ReservedBytes() const { return reserved_bytes; }
+    size_t CapacityBytes() const { return capacity_bytes; }   // Page-rounded
+    size_t UsedBytes() const { return used_bytes.load(std::memory_order_relaxed); }
+
+    // Publish "rt.arena_bytes" / "rt.arena_used_bytes"
+    void RegisterMetrics(MetricsRegistry* registry);
+
+    // Per-block footprint report
+    void Print(FILE* out) const;
+
+private:
+    struct Block {
+        const char* name;
+        size_t size;
+        size_t offset;       // Valid once allocated
+        bool allocated;
+    };
+
+    static size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    void Release();
+
+    Block blocks[MAX_BLOCKS];
+    size_t block_count;
+    size_t reserved_bytes;
+
+    uint8_t* base;
+    size_t capacity_bytes;
+    size_t next_offset;
+    bool locked;
+#ifdef __HAIKU__
+    area_id area;
+#endif
+
+    MetricsRegistry* registry;
+    std::atomic<uint64_t> capacity_metric;
+    std::atomic<uint64_t> used_bytes;
+
+    RealtimeArena(const RealtimeArena&) = delete;
+    RealtimeArena& operator=(const RealtimeArena&) = delete;
+};
+
+#endif // REALTIME_ARENA_H
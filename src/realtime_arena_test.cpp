@@ -0,0 +1,164 @@
+/*
+ * Realtime Arena Test
+ * Checks block placement and that hot threads take no page faults after warmup
+ */
+
+#include "realtime_arena.h"
+#include "metrics_registry.h"
+#include "midi_message_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <thread>
+#include <sys/resource.h>
+
+static const size_t LED_FRAME_BYTES = 256 * 1024;
+
+struct FaultCount {
+    long minor;
+    long major;
+};
+
+static FaultCount ThreadFaults()
+{
+    FaultCount faults = {0, 0};
+#ifdef RUSAGE_THREAD
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    faults.minor = usage.ru_minflt;
+    faults.major = usage.ru_majflt;
+#endif
+    return faults;
+}
+
+// Work a realtime thread does: cycle the queue and rewrite an LED buffer
+static void HotLoop(MIDIMessageQueue* queue, uint8_t* led_frames, size_t led_bytes, int rounds)
+{
+    MIDIMessage message;
+    for (int round = 0; round < rounds; round++) {
+        for (uint32_t i = 0; i < MIDIMessageQueue::MIDI_QUEUE_SIZE - 1; i++) {
+            queue->EnqueueMIDI(0x90, i & 0x3F, round & 0x7F, MIDI_SOURCE_HARDWARE_USB);
+        }
+        while (queue->Dequeue(message)) {
+        }
+        for (size_t offset = 0; offset < led_bytes; offset += 64) {
+            led_frames[offset] = static_cast<uint8_t>(round);
+        }
+    }
+}
+
+void test_reserve_and_allocate()
+{
+    printf("Testing Reserve/Commit/Allocate...\n");
+
+    RealtimeArena arena;
+    assert(arena.Allocate("early", 64) == nullptr);    // Not committed yet
+    assert(arena.Reserve<MIDIMessageQueue>("midi_queue"));
+    assert(arena.Reserve("led_frames", 1000, 128));
+    assert(arena.ReservedBytes() >= sizeof(MIDIMessageQueue) + 1000);
+
+    assert(arena.Commit(false) == APC_SUCCESS);
+    assert(arena.Commit(false) == APC_ERROR_INVALID_PARAMETER);
+    assert(!arena.Reserve("late", 64));
+    assert(arena.CapacityBytes() >= arena.ReservedBytes());
+
+    MIDIMessageQueue* queue = arena.New<MIDIMessageQueue>("midi_queue");
+    assert(queue != nullptr);
+    assert(arena.Contains(queue));
+    assert(reinterpret_cast<uintptr_t>(queue) % alignof(MIDIMessageQueue) == 0);
+    assert(queue->EnqueueMIDI(0x90, 1, 127, MIDI_SOURCE_GUI));
+
+    uint8_t* frames = static_cast<uint8_t*>(arena.Allocate("led_frames", 1000, 128));
+    assert(frames != nullptr);
+    assert(reinterpret_cast<uintptr_t>(frames) % 128 == 0);
+    assert(frames[999] == 0);
+
+    // Nothing left beyond page rounding
+    assert(arena.Allocate("overflow", arena.CapacityBytes()) == nullptr);
+    assert(arena.UsedBytes() <= arena.CapacityBytes());
+
+    MetricsRegistry registry;
+    arena.RegisterMetrics(&registry);
+    MetricSample sample;
+    assert(registry.Find("rt.arena_bytes", sample));
+    assert(sample.value == arena.CapacityBytes());
+
+    // A full or uncommitted arena falls back to the heap
+    MIDIMessageQueue* spilled = arena.NewOrHeap<MIDIMessageQueue>("spilled");
+    assert(spilled != nullptr && !arena.Contains(spilled));
+    arena.Destroy(spilled);
+    RealtimeArena uncommitted;
+    spilled = uncommitted.NewOrHeap<MIDIMessageQueue>("midi_queue");
+    assert(spilled != nullptr && !uncommitted.Contains(spilled));
+    uncommitted.Destroy(spilled);
+
+    arena.Print(stdout);
+    arena.Destroy(queue);
+    printf("✅ Blocks are placed, aligned and accounted for\n");
+}
+
+void test_no_faults_on_hot_thread()
+{
+    printf("Testing page faults on a hot thread after warmup...\n");
+
+#ifndef RUSAGE_THREAD
+    printf("⚠️  Per-thread fault counters not available, skipped\n");
+#else
+    RealtimeArena arena;
+    arena.Reserve<MIDIMessageQueue>("midi_queue");
+    arena.Reserve("led_frames", LED_FRAME_BYTES);
+    assert(arena.Commit(true) == APC_SUCCESS);
+    printf("Arena: %zu bytes, %s\n", arena.CapacityBytes(),
+           arena.IsLocked() ? "locked" : "pre-faulted only (mlock not permitted)");
+
+    MIDIMessageQueue* queue = arena.New<MIDIMessageQueue>("midi_queue");
+    uint8_t* arena_frames = static_cast<uint8_t*>(arena.Allocate("led_frames", LED_FRAME_BYTES));
+    assert(queue && arena_frames);
+
+    FaultCount arena_faults = {0, 0};
+    FaultCount heap_faults = {0, 0};
+
+    std::thread hot_thread([&]() {
+        // Warmup touches this thread's stack and code pages, not the data
+        uint8_t warmup_frames[4096];
+        HotLoop(queue, warmup_frames, sizeof(warmup_frames), 1);
+
+        FaultCount before = ThreadFaults();
+        HotLoop(queue, arena_frames, LED_FRAME_BYTES, 4);
+        FaultCount after = ThreadFaults();
+        arena_faults.minor = after.minor - before.minor;
+        arena_faults.major = after.major - before.major;
+
+        // Control: the same work on a fresh heap block faults on first touch
+        uint8_t* heap_frames = static_cast<uint8_t*>(malloc(LED_FRAME_BYTES));
+        before = ThreadFaults();
+        HotLoop(queue, heap_frames, LED_FRAME_BYTES, 1);
+        after = ThreadFaults();
+        heap_faults.minor = after.minor - before.minor;
+        heap_faults.major = after.major - before.major;
+        free(heap_frames);
+    });
+    hot_thread.join();
+
+    printf("Arena-backed hot loop: %ld minor, %ld major faults\n", arena_faults.minor, arena_faults.major);
+    printf("Heap-backed control:   %ld minor, %ld major faults\n", heap_faults.minor, heap_faults.major);
+    assert(arena_faults.minor == 0);
+    assert(arena_faults.major == 0);
+
+    RealtimeArena::Delete(queue);
+    printf("✅ No page faults on the hot thread\n");
+#endif
+}
+
+int main()
+{
+    printf("🧠 Realtime Arena Test\n");
+    printf("======================\n\n");
+
+    test_reserve_and_allocate();
+    test_no_faults_on_hot_thread();
+
+    printf("\n🎉 ALL TESTS PASSED! Realtime memory is pre-faulted.\n");
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include "rtt_prober.h"
+#include "metrics_registry.h"
+#include "apc_device_profile.h"
+#include "thread_accounting.h"
+#include <string.h>
+
+// USBRawMIDI::SendIntroductionMessage() with the probe's application ID
+const uint8_t RTTProber::INTRODUCTION_MESSAGE[12] = {
+    APC_MK2_SYSEX_HEADER, APC_MK2_SYSEX_INTRO_CMD,
+    0x00, 0x04,                 // Data length
+    PROBE_APPLICATION_ID,
+    0x01, 0x00, 0x00,           // Application version
+    APC_MK2_SYSEX_END
+};
+
+RTTProber::RTTProber(SysExSender sysex_sender, MetricsRegistry* metrics_registry)
+    : sender(sysex_sender)
+    , registry(metrics_registry)
+    , interval_us_value(DEFAULT_INTERVAL_US)
+    , timeout_us_value(DEFAULT_TIMEOUT_US)
+    , running(false)
+    , stop_requested(false)
+    , probe_outstanding(false)
+    , probe_sent_at(0)
+    , foreign_pending(0)
+    , replies_ahead(0)
+    , last_rtt(0)
+    , have_fader_values(false)
+    , probes_sent(0)
+    , replies_matched(0)
+    , timeouts(0)
+    , unmatched_replies(0)
+    , foreign_replies(0)
+    , send_failures(0)
+{
+    memset(fader_values, 0, sizeof(fader_values));
+
+    if (registry) {
+        registry->RegisterHistogram("usb.rtt_us", &histogram);
+        registry->RegisterCounter("usb.rtt_probes", &probes_sent);
+        registry->RegisterCounter("usb.rtt_replies", &replies_matched);
+        registry->RegisterCounter("usb.rtt_timeouts", &timeouts);
+    }
+}
+
+RTTProber::~RTTProber()
+{
+    Stop();
+
+    if (registry) {
+        registry->Unregister(&histogram);
+        registry->Unregister(&probes_sent);
+        registry->Unregister(&replies_matched);
+        registry->Unregister(&timeouts);
+    }
+}
+
+APCMiniError RTTProber::Start()
+{
+    if (running.load()) {
+        return APC_SUCCESS;
+    }
+    if (!sender) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop_requested = false;
+        probe_outstanding = false;
+        foreign_pending = 0;
+        replies_ahead = 0;
+    }
+
+    running.store(true);
+    probe_thread = std::thread(&RTTProber::ProbeThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void RTTProber::Stop()
+{
+    if (!running.load()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop_requested = true;
+    }
+    state_changed.notify_all();
+
+    if (probe_thread.joinable()) {
+        probe_thread.join();
+    }
+    running.store(false);
+}
+
+APCMiniError RTTProber::SendProbe()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        // Mark outstanding before sending: a loopback or fast device may
+        // answer before SendSysEx() returns
+        probe_outstanding = true;
+        probe_sent_at = system_time();
+        replies_ahead = foreign_pending;
+    }
+
+    APCMiniError result = sender(INTRODUCTION_MESSAGE, sizeof(INTRODUCTION_MESSAGE));
+    if (result != APC_SUCCESS) {
+        std::lock_guard<std::mutex> guard(lock);
+        probe_outstanding = false;
+        send_failures.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    probes_sent.fetch_add(1, std::memory_order_relaxed);
+    return APC_SUCCESS;
+}
+
+void RTTProber::ExpireOutstanding(bigtime_t now)
+{
+    // Called with lock held
+    if (probe_outstanding && now - probe_sent_at >= timeout_us_value.load()) {
+        probe_outstanding = false;
+        timeouts.fetch_add(1, std::memory_order_relaxed);
+        // A reply went missing; which one is unknown, so stop expecting any
+        foreign_pending = 0;
+        replies_ahead = 0;
+    }
+}
+
+bool RTTProber::HandleSysEx(const uint8_t* data, size_t length)
+{
+    const bigtime_t now = system_time();
+
+    // F0 47 7F 4F 61 <len MSB> <len LSB> <data...> F7
+    if (!data || length < 8 ||
+        memcmp(data, APCMiniMK2Profile::SYSEX_HEADER, sizeof(APCMiniMK2Profile::SYSEX_HEADER)) != 0 ||
+        data[4] != APC_MK2_SYSEX_INTRO_RESP) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    size_t payload = ((size_t)data[5] << 7) | data[6];
+    if (payload > APC_MINI_TOTAL_FADER_COUNT) {
+        payload = APC_MINI_TOTAL_FADER_COUNT;
+    }
+    if (7 + payload < length) {
+        memcpy(fader_values, data + 7, payload);
+        have_fader_values = true;
+    }
+
+    ExpireOutstanding(now);
+
+    // Responses come back in request order; those owed to other
+    // introductions sent before the probe are not its reply
+    if (foreign_pending > 0 && (!probe_outstanding || replies_ahead > 0)) {
+        foreign_pending--;
+        if (replies_ahead > 0) {
+            replies_ahead--;
+        }
+        foreign_replies.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (!probe_outstanding) {
+        unmatched_replies.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    last_rtt = now - probe_sent_at;
+    probe_outstanding = false;
+    histogram.Record(last_rtt);
+    replies_matched.fetch_add(1, std::memory_order_relaxed);
+
+    state_changed.notify_all();
+    return true;
+}
+
+void RTTProber::NoteSysExSent(const uint8_t* data, size_t length)
+{
+    // F0 47 7F 4F 60 <len MSB> <len LSB> <application ID> ...
+    if (!data || length < 8 ||
+        memcmp(data, APCMiniMK2Profile::SYSEX_HEADER, sizeof(APCMiniMK2Profile::SYSEX_HEADER)) != 0 ||
+        data[4] != APC_MK2_SYSEX_INTRO_CMD || data[7] == PROBE_APPLICATION_ID) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    foreign_pending++;
+}
+
+bool RTTProber::ProbeOnce(bigtime_t timeout_us, bigtime_t* rtt_us)
+{
+    if (running.load() || !sender) {
+        return false;
+    }
+
+    uint64_t replies_before = replies_matched.load();
+    if (SendProbe() != APC_SUCCESS) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    const bigtime_t deadline = probe_sent_at + timeout_us;
+
+    while (replies_matched.load() == replies_before) {
+        bigtime_t remaining = deadline - system_time();
+        if (remaining <= 0) {
+            if (probe_outstanding) {
+                probe_outstanding = false;
+                timeouts.fetch_add(1, std::memory_order_relaxed);
+            }
+            return false;
+        }
+        state_changed.wait_for(guard, std::chrono::microseconds(remaining));
+    }
+
+    if (rtt_us) {
+        *rtt_us = last_rtt;
+    }
+    return true;
+}
+
+bool RTTProber::GetLastFaderValues(uint8_t* values, size_t count) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!have_fader_values || !values) {
+        return false;
+    }
+
+    size_t copy = count < (size_t)APC_MINI_TOTAL_FADER_COUNT ? count : APC_MINI_TOTAL_FADER_COUNT;
+    memcpy(values, fader_values, copy);
+    return true;
+}
+
+RTTProberStats RTTProber::GetStats() const
+{
+    RTTProberStats stats;
+    stats.probes_sent = probes_sent.load();
+    stats.replies_matched = replies_matched.load();
+    stats.timeouts = timeouts.load();
+    stats.unmatched_replies = unmatched_replies.load();
+    stats.foreign_replies = foreign_replies.load();
+    stats.send_failures = send_failures.load();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stats.last_rtt_us = last_rtt;
+    }
+    stats.p50_us = histogram.Percentile(50.0);
+    stats.p99_us = histogram.Percentile(99.0);
+    stats.max_us = histogram.Max();
+    return stats;
+}
+
+void RTTProber::ProbeThreadLoop()
+{
+    ScopedThreadAccounting accounting("rtt_probe");
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (!stop_requested) {
+        ExpireOutstanding(system_time());
+
+        if (!probe_outstanding) {
+            guard.unlock();
+            SendProbe();
+            guard.lock();
+        }
+
+        // Sleep one interval, waking early only to stop
+        bigtime_t wake_at = system_time() + interval_us_value.load();
+        while (!stop_requested) {
+            bigtime_t remaining = wake_at - system_time();
+            if (remaining <= 0) {
+                break;
+            }
+            state_changed.wait_for(guard, std::chrono::microseconds(remaining));
+            ThreadAccounting::NoteWakeup();
+        }
+    }
+}
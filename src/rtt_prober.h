@@ -0,0 +1,141 @@
+#ifndef RTT_PROBER_H
+#define RTT_PROBER_H
+
+/*
+ * Round-Trip Time Prober for the APC Mini MK2
+ *
+ * The MK2 answers the introduction message (F0 47 7F 4F 60 ...) with an
+ * introduction response (F0 47 7F 4F 61 ...) carrying the fader positions.
+ * That gives a host-initiated round trip that needs no user action, so the
+ * link latency can be watched continuously instead of with manual runs of
+ * latency_benchmark:
+ *
+ * - A background thread sends one probe per interval (default 1 s)
+ * - Only one probe is outstanding at a time; the response carries no ID,
+ *   so the first response after a probe is matched to it. A probe without
+ *   a reply within the timeout is counted and abandoned.
+ * - Probes are tagged with their own application ID. Introductions sent by
+ *   anyone else and reported through NoteSysExSent() have their responses
+ *   skipped, so an application handshake is never taken for a probe reply.
+ * - Only profiles with SysEx answer; do not start it for the MK1.
+ * - RTTs go into a LatencyHistogram registered with MetricsRegistry as
+ *   "usb.rtt_us" together with probe/reply/timeout counters
+ *
+ * The receive path must route every incoming SysEx message to
+ * HandleSysEx(); it returns true for introduction responses.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "latency_histogram.h"
+
+class MetricsRegistry;
+
+struct RTTProberStats {
+    uint64_t probes_sent;
+    uint64_t replies_matched;
+    uint64_t timeouts;
+    uint64_t unmatched_replies;    // Responses with no probe outstanding
+    uint64_t foreign_replies;      // Responses to introductions that were not probes
+    uint64_t send_failures;
+    bigtime_t last_rtt_us;
+    bigtime_t p50_us;
+    bigtime_t p99_us;
+    bigtime_t max_us;
+};
+
+class RTTProber {
+public:
+    // Sends a complete SysEx message; usually USBRawMIDI::SendSysEx
+    typedef std::function<APCMiniError(const uint8_t* data, size_t length)> SysExSender;
+
+    static constexpr bigtime_t DEFAULT_INTERVAL_US = 1000000;   // 1 probe/s
+    static constexpr bigtime_t DEFAULT_TIMEOUT_US = 250000;     // 250 ms
+
+    RTTProber(SysExSender sender, MetricsRegistry* registry = nullptr);
+    ~RTTProber();
+
+    void SetInterval(bigtime_t interval_us) { interval_us_value.store(interval_us); }
+    void SetTimeout(bigtime_t timeout_us) { timeout_us_value.store(timeout_us); }
+
+    APCMiniError Start();
+    void Stop();
+    bool IsRunning() const { return running.load(); }
+
+    /**
+     * Send a single probe and wait for its reply (for tests and tools)
+     *
+     * Must not be used while the background thread is running.
+     * @return true and the RTT in rtt_us when a reply arrived in time
+     */
+    bool ProbeOnce(bigtime_t timeout_us, bigtime_t* rtt_us);
+
+    /**
+     * Feed an incoming SysEx message (any thread)
+     *
+     * @return true if it was an introduction response (consumed)
+     */
+    bool HandleSysEx(const uint8_t* data, size_t length);
+
+    /**
+     * Report a SysEx message put on the link by anyone (the writer thread)
+     *
+     * Probes are recognized and ignored; other introduction messages expect
+     * a response that must not be matched to a probe.
+     */
+    void NoteSysExSent(const uint8_t* data, size_t length);
+
+    // Fader positions from the most recent response (9 values, 0-127)
+    bool GetLastFaderValues(uint8_t* values, size_t count) const;
+
+    RTTProberStats GetStats() const;
+    const LatencyHistogram& GetHistogram() const { return histogram; }
+
+    // Introduction message sent as the probe
+    static const uint8_t INTRODUCTION_MESSAGE[12];
+    static constexpr uint8_t PROBE_APPLICATION_ID = 0x7E;
+
+private:
+    APCMiniError SendProbe();
+    void ExpireOutstanding(bigtime_t now);
+    void ProbeThreadLoop();
+
+    SysExSender sender;
+    MetricsRegistry* registry;
+    LatencyHistogram histogram;
+
+    std::atomic<bigtime_t> interval_us_value;
+    std::atomic<bigtime_t> timeout_us_value;
+    std::atomic<bool> running;
+
+    // Outstanding probe (guarded by lock)
+    mutable std::mutex lock;
+    std::condition_variable state_changed;
+    bool stop_requested;
+    bool probe_outstanding;
+    bigtime_t probe_sent_at;
+    uint32_t foreign_pending;       // Responses owed to other introductions
+    uint32_t replies_ahead;         // Of those, sent before the outstanding probe
+    bigtime_t last_rtt;
+    uint8_t fader_values[APC_MINI_TOTAL_FADER_COUNT];
+    bool have_fader_values;
+
+    std::atomic<uint64_t> probes_sent;
+    std::atomic<uint64_t> replies_matched;
+    std::atomic<uint64_t> timeouts;
+    std::atomic<uint64_t> unmatched_replies;
+    std::atomic<uint64_t> foreign_replies;
+    std::atomic<uint64_t> send_failures;
+
+    std::thread probe_thread;
+};
+
+#endif // RTT_PROBER_H
@@ -0,0 +1,503 @@
+#include "staged_pipeline.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ===============================
+// MIDISPSCRing
+// ===============================
+
+static uint32_t RoundUpPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 2;
+    while (result < value && result < (1u << 20)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+MIDISPSCRing::MIDISPSCRing(uint32_t capacity)
+    : slots(RoundUpPowerOfTwo(capacity))
+    , mask((uint32_t)slots.size() - 1)
+    , head(0)
+    , cached_tail(0)
+    , tail(0)
+    , cached_head(0)
+{
+}
+
+size_t MIDISPSCRing::Push(const MIDIMessage* messages, size_t count)
+{
+    uint32_t write = head.load(std::memory_order_relaxed);
+    size_t room = Capacity() - (write - cached_tail);
+    if (room < count) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        room = Capacity() - (write - cached_tail);
+    }
+
+    size_t accepted = count < room ? count : room;
+    for (size_t i = 0; i < accepted; i++) {
+        slots[(write + i) & mask] = messages[i];
+    }
+    if (accepted > 0) {
+        head.store(write + (uint32_t)accepted, std::memory_order_release);
+    }
+    return accepted;
+}
+
+size_t MIDISPSCRing::Pop(MIDIMessage* messages, size_t max_count)
+{
+    uint32_t read = tail.load(std::memory_order_relaxed);
+    size_t available = cached_head - read;
+    if (available < max_count) {
+        cached_head = head.load(std::memory_order_acquire);
+        available = cached_head - read;
+    }
+
+    size_t taken = max_count < available ? max_count : available;
+    for (size_t i = 0; i < taken; i++) {
+        messages[i] = slots[(read + i) & mask];
+    }
+    if (taken > 0) {
+        tail.store(read + (uint32_t)taken, std::memory_order_release);
+    }
+    return taken;
+}
+
+uint32_t MIDISPSCRing::Depth() const
+{
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+// ===============================
+// StagedPipelineLayout
+// ===============================
+
+StagedPipelineLayout StagedPipelineLayout::Inline()
+{
+    StagedPipelineLayout layout;
+    memset(layout.stage_worker, 0, sizeof(layout.stage_worker));
+    for (size_t i = 0; i <= MAX_WORKERS; i++) {
+        layout.worker_cpu[i] = -1;
+    }
+    layout.ring_capacity = 1024;
+    return layout;
+}
+
+StagedPipelineLayout StagedPipelineLayout::Spread(size_t stage_count, size_t workers)
+{
+    StagedPipelineLayout layout = Inline();
+    if (stage_count > MAX_STAGES) {
+        stage_count = MAX_STAGES;
+    }
+    if (workers > stage_count) {
+        workers = stage_count;
+    }
+    if (workers > MAX_WORKERS) {
+        workers = MAX_WORKERS;
+    }
+    if (workers == 0) {
+        return layout;
+    }
+
+    size_t per_worker = stage_count / workers;
+    size_t extra = stage_count % workers;
+    size_t stage = 0;
+    for (size_t worker = 1; worker <= workers; worker++) {
+        size_t group = per_worker + (worker <= extra ? 1 : 0);
+        for (size_t i = 0; i < group; i++) {
+            layout.stage_worker[stage++] = (uint8_t)worker;
+        }
+    }
+    return layout;
+}
+
+void StagedPipelineLayout::PinSequential(int first_cpu)
+{
+    for (size_t worker = 1; worker <= MAX_WORKERS; worker++) {
+        worker_cpu[worker] = (int16_t)(first_cpu + (int)worker - 1);
+    }
+}
+
+// ===============================
+// StagedPipeline
+// ===============================
+
+StagedPipeline::StagedPipeline(MetricsRegistry* metrics_registry)
+    : registry(metrics_registry)
+    , stage_count(0)
+    , inline_end(0)
+    , running(false)
+    , started_at(0)
+    , dropped(0)
+{
+}
+
+StagedPipeline::~StagedPipeline()
+{
+    Stop();
+    if (registry) {
+        for (size_t i = 0; i < stage_count; i++) {
+            for (int metric = 0; metric < METRIC_COUNT; metric++) {
+                registry->Unregister(&stages[i].metrics[metric]);
+            }
+        }
+    }
+}
+
+bool StagedPipeline::AddStageThunk(const char* name, void* stage, StageThunk run)
+{
+    if (running || stage_count == MAX_STAGES || !stage) {
+        return false;
+    }
+
+    StageSlot& slot = stages[stage_count];
+    snprintf(slot.name, sizeof(slot.name), "%s", name);
+    slot.stage = stage;
+    slot.run = run;
+    slot.worker = 0;
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        slot.metrics[metric].store(0, std::memory_order_relaxed);
+    }
+    slot.passed.store(0, std::memory_order_relaxed);
+    slot.high_water.store(0, std::memory_order_relaxed);
+    slot.sampled_at = 0;
+    slot.sampled_busy = 0;
+
+    static const char* const suffixes[METRIC_COUNT] = {
+        "processed", "busy_us", "occupancy_pct", "queue_depth", "stalls"
+    };
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        snprintf(slot.metric_names[metric], sizeof(slot.metric_names[metric]), "pipeline.%s.%s",
+                 slot.name, suffixes[metric]);
+        if (registry) {
+            registry->RegisterCounter(slot.metric_names[metric], &slot.metrics[metric]);
+        }
+    }
+
+    stage_count++;
+    return true;
+}
+
+APCMiniError StagedPipeline::Start(const StagedPipelineLayout& layout)
+{
+    if (running) {
+        return APC_SUCCESS;
+    }
+    if (stage_count == 0) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    // Workers must follow the stage order
+    for (size_t i = 0; i < stage_count; i++) {
+        uint8_t worker = layout.stage_worker[i];
+        if (worker > StagedPipelineLayout::MAX_WORKERS ||
+            (i > 0 && worker < layout.stage_worker[i - 1])) {
+            return APC_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    inline_end = 0;
+    while (inline_end < stage_count && layout.stage_worker[inline_end] == 0) {
+        stages[inline_end].worker = 0;
+        inline_end++;
+    }
+
+    // One worker per distinct placement, each with its own input ring
+    for (size_t first = inline_end; first < stage_count;) {
+        uint8_t index = layout.stage_worker[first];
+        size_t end = first;
+        while (end < stage_count && layout.stage_worker[end] == index) {
+            stages[end].worker = index;
+            end++;
+        }
+
+        Worker* worker = new Worker();
+        worker->index = index;
+        worker->requested_cpu = layout.worker_cpu[index];
+        worker->cpu.store(-1);
+        worker->first_stage = first;
+        worker->end_stage = end;
+        worker->input = new MIDISPSCRing(layout.ring_capacity);
+        worker->next = nullptr;
+        worker->upstream_done.store(false);
+        worker->sleeping.store(false);
+        worker->received.store(0);
+        worker->completed.store(0);
+        rings.push_back(worker->input);
+
+        if (!workers.empty()) {
+            workers.back()->next = worker;
+        }
+        workers.push_back(worker);
+        first = end;
+    }
+
+    started_at = system_time();
+    for (size_t i = 0; i < stage_count; i++) {
+        stages[i].sampled_at = started_at;
+        stages[i].sampled_busy = stages[i].metrics[METRIC_BUSY].load();
+    }
+
+    running = true;
+    for (Worker* worker : workers) {
+        worker->thread = std::thread(&StagedPipeline::WorkerLoop, this, worker);
+    }
+    return APC_SUCCESS;
+}
+
+void StagedPipeline::Stop()
+{
+    if (!running) {
+        return;
+    }
+
+    // Join front to back: each worker drains its ring, then tells the next
+    // one that nothing more will arrive
+    for (Worker* worker : workers) {
+        worker->upstream_done.store(true);
+        Wake(*worker);
+        worker->thread.join();
+    }
+
+    for (Worker* worker : workers) {
+        delete worker;
+    }
+    for (MIDISPSCRing* ring : rings) {
+        delete ring;
+    }
+    workers.clear();
+    rings.clear();
+    running = false;
+}
+
+bool StagedPipeline::Submit(const MIDIMessage& message)
+{
+    return SubmitBatch(&message, 1) == 1;
+}
+
+size_t StagedPipeline::SubmitBatch(const MIDIMessage* messages, size_t count)
+{
+    if (!running) {
+        return 0;
+    }
+
+    MIDIMessage batch[BATCH_SIZE];
+    size_t taken = 0;
+
+    while (taken < count) {
+        size_t chunk = count - taken < BATCH_SIZE ? count - taken : BATCH_SIZE;
+
+        // Only take what is sure to fit, so inline stages never run on a
+        // message that is then refused
+        if (!workers.empty()) {
+            size_t room = workers.front()->input->Free();
+            if (room < chunk) {
+                chunk = room;
+            }
+            if (chunk == 0) {
+                dropped.fetch_add(count - taken, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        memcpy(batch, messages + taken, chunk * sizeof(MIDIMessage));
+        size_t kept = RunStages(0, inline_end, batch, chunk);
+        taken += chunk;
+
+        if (!workers.empty() && kept > 0) {
+            Worker& first = *workers.front();
+            first.input->Push(batch, kept);
+            first.received.fetch_add(kept, std::memory_order_relaxed);
+            Wake(first);
+        }
+    }
+    return taken;
+}
+
+void StagedPipeline::Flush()
+{
+    // Workers pass messages on before counting them complete, so checking
+    // front to back sees everything that was in flight
+    for (Worker* worker : workers) {
+        while (worker->completed.load(std::memory_order_acquire) <
+               worker->received.load(std::memory_order_acquire)) {
+            Wake(*worker);
+            snooze(100);
+        }
+    }
+}
+
+size_t StagedPipeline::RunStages(size_t first, size_t end, MIDIMessage* batch, size_t count)
+{
+    if (first == end) {
+        return count;
+    }
+
+    bigtime_t before = system_time();
+    for (size_t i = first; i < end && count > 0; i++) {
+        StageSlot& slot = stages[i];
+        slot.metrics[METRIC_PROCESSED].fetch_add(count, std::memory_order_relaxed);
+        count = slot.run(slot.stage, batch, count);
+        slot.passed.fetch_add(count, std::memory_order_relaxed);
+
+        bigtime_t after = system_time();
+        slot.metrics[METRIC_BUSY].fetch_add((uint64_t)(after - before), std::memory_order_relaxed);
+        before = after;
+    }
+    return count;
+}
+
+void StagedPipeline::PushBlocking(Worker& target, const MIDIMessage* batch, size_t count,
+                                  size_t stalling_stage)
+{
+    size_t pushed = 0;
+    while (pushed < count) {
+        size_t accepted = target.input->Push(batch + pushed, count - pushed);
+        if (accepted > 0) {
+            target.received.fetch_add(accepted, std::memory_order_relaxed);
+            Wake(target);
+            pushed += accepted;
+            continue;
+        }
+
+        // Downstream is behind: back-pressure instead of dropping mid-pipeline
+        stages[stalling_stage].metrics[METRIC_STALLS].fetch_add(1, std::memory_order_relaxed);
+        Wake(target);
+        std::this_thread::yield();
+    }
+}
+
+void StagedPipeline::Wake(Worker& worker)
+{
+    // Pairs with the fence in WorkerLoop: either the worker sees the new
+    // messages before sleeping, or we see it sleeping and notify
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.sleeping.load(std::memory_order_relaxed) ||
+        worker.upstream_done.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> guard(worker.wait_lock);
+        worker.wake.notify_one();
+    }
+}
+
+void StagedPipeline::WorkerLoop(Worker* worker)
+{
+    char thread_name[THREAD_ACCOUNTING_NAME_LENGTH];
+    snprintf(thread_name, sizeof(thread_name), "pipeline_%s", stages[worker->first_stage].name);
+    ScopedThreadAccounting accounting(thread_name);
+
+    if (worker->requested_cpu >= 0 && PinCurrentThread(worker->requested_cpu)) {
+        worker->cpu.store(worker->requested_cpu);
+    }
+
+    StageSlot& input_stage = stages[worker->first_stage];
+    MIDIMessage batch[BATCH_SIZE];
+
+    for (;;) {
+        uint32_t depth = worker->input->Depth();
+        size_t count = worker->input->Pop(batch, BATCH_SIZE);
+
+        if (count == 0) {
+            // upstream_done is set after the upstream's last push
+            if (worker->upstream_done.load(std::memory_order_acquire) &&
+                worker->input->Depth() == 0) {
+                break;
+            }
+
+            std::unique_lock<std::mutex> guard(worker->wait_lock);
+            worker->sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (worker->input->Depth() == 0 && !worker->upstream_done.load(std::memory_order_relaxed)) {
+                worker->wake.wait(guard);
+                ThreadAccounting::NoteWakeup();
+            }
+            worker->sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Gauge: what waits behind this batch; high water: backlog seen
+        input_stage.metrics[METRIC_DEPTH].store(depth > count ? depth - count : 0,
+                                                 std::memory_order_relaxed);
+        if (depth > input_stage.high_water.load(std::memory_order_relaxed)) {
+            input_stage.high_water.store(depth, std::memory_order_relaxed);
+        }
+
+        size_t kept = RunStages(worker->first_stage, worker->end_stage, batch, count);
+        if (worker->next && kept > 0) {
+            PushBlocking(*worker->next, batch, kept, worker->end_stage - 1);
+        }
+        worker->completed.fetch_add(count, std::memory_order_release);
+    }
+
+    input_stage.metrics[METRIC_DEPTH].store(0, std::memory_order_relaxed);
+}
+
+StageStats StagedPipeline::GetStageStats(size_t index) const
+{
+    StageStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.cpu = -1;
+    if (index >= stage_count) {
+        return stats;
+    }
+
+    const StageSlot& slot = stages[index];
+    stats.name = slot.name;
+    stats.worker = slot.worker;
+    for (const Worker* worker : workers) {
+        if (worker->index == slot.worker) {
+            stats.cpu = worker->cpu.load();
+        }
+    }
+    stats.processed = slot.metrics[METRIC_PROCESSED].load();
+    stats.passed = slot.passed.load();
+    stats.busy_us = (bigtime_t)slot.metrics[METRIC_BUSY].load();
+    stats.queue_depth = (uint32_t)slot.metrics[METRIC_DEPTH].load();
+    stats.queue_high_water = slot.high_water.load();
+    stats.stalls = slot.metrics[METRIC_STALLS].load();
+
+    bigtime_t elapsed = system_time() - started_at;
+    if (started_at > 0 && elapsed > 0) {
+        stats.occupancy = (double)stats.busy_us / elapsed;
+    }
+    return stats;
+}
+
+void StagedPipeline::Sample()
+{
+    bigtime_t now = system_time();
+    for (size_t i = 0; i < stage_count; i++) {
+        StageSlot& slot = stages[i];
+        uint64_t busy = slot.metrics[METRIC_BUSY].load();
+        bigtime_t interval = now - slot.sampled_at;
+        if (interval > 0) {
+            uint64_t percent = (busy - slot.sampled_busy) * 100 / (uint64_t)interval;
+            slot.metrics[METRIC_OCCUPANCY].store(percent > 100 ? 100 : percent);
+        }
+        slot.sampled_at = now;
+        slot.sampled_busy = busy;
+    }
+}
+
+bool StagedPipeline::PinCurrentThread(int cpu)
+{
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    // Haiku schedules threads on any CPU; there is no affinity call
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,285 @@
+#ifndef STAGED_PIPELINE_H
+#define STAGED_PIPELINE_H
+
+/*
+ * Pipelined Multi-Core Event Processing
+ *
+ * MIDIPipeline fuses every stage into one function on one thread, which is
+ * the right choice while the stages are cheap: the whole chain costs less
+ * than handing a message to another core. Once one stage gets expensive
+ * (a heavy transform, many dispatch targets) that thread caps throughput.
+ *
+ * StagedPipeline splits the chain into up to MAX_STAGES stages - normally
+ * parse/normalize, transform/state and fan-out - and lets a layout decide
+ * where each one runs:
+ *
+ *   - inline in Submit() on the caller's thread (the looper model)
+ *   - on worker threads, connected by single-producer/single-consumer rings;
+ *     consecutive stages placed on the same worker run fused
+ *   - workers optionally pinned to a CPU (Linux affinity; Haiku has no
+ *     affinity API and runs them unpinned)
+ *
+ * Workers move messages in batches: pop up to BATCH_SIZE, run each of their
+ * stages over the whole batch (a stage drops a message by returning false;
+ * order is kept), push the survivors downstream. The time spent in each
+ * stage is measured per batch, so occupancy costs two clock reads per
+ * stage per batch rather than per message.
+ *
+ * A stage is the same type MIDIPipeline uses (bool Process(MIDIMessage&));
+ * a whole MIDIPipeline can be one stage. Stages are owned by the caller and
+ * must outlive the pipeline.
+ *
+ * Threading: Submit()/SubmitBatch() from one thread (the ring into the first
+ * worker is single-producer). Stages on a worker are only called from that
+ * worker. Stop() drains every ring before returning.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "apc_mini_platform.h"
+#include "midi_message_queue.h"
+
+class MetricsRegistry;
+
+// ===============================
+// SPSC ring
+// ===============================
+
+// Bounded single-producer/single-consumer ring of MIDIMessage. Each side
+// caches the other side's index and only reloads it when the cached value
+// says full/empty, so a steady stream touches the shared line once per batch.
+class MIDISPSCRing {
+public:
+    explicit MIDISPSCRing(uint32_t capacity);
+
+    MIDISPSCRing(const MIDISPSCRing&) = delete;
+    MIDISPSCRing& operator=(const MIDISPSCRing&) = delete;
+
+    // Producer: copy up to count messages in, return how many fit
+    size_t Push(const MIDIMessage* messages, size_t count);
+
+    // Consumer: copy up to max_count messages out
+    size_t Pop(MIDIMessage* messages, size_t max_count);
+
+    uint32_t Depth() const;
+    uint32_t Capacity() const { return mask + 1; }
+
+    // Producer: room left (only grows until the producer pushes again)
+    uint32_t Free() const { return Capacity() - Depth(); }
+
+private:
+    std::vector<MIDIMessage> slots;
+    uint32_t mask;
+
+    alignas(64) std::atomic<uint32_t> head;     // Next slot to write (producer)
+    uint32_t cached_tail;
+    alignas(64) std::atomic<uint32_t> tail;     // Next slot to read (consumer)
+    uint32_t cached_head;
+};
+
+// ===============================
+// Layout
+// ===============================
+
+struct StagedPipelineLayout {
+    static constexpr size_t MAX_STAGES = 4;
+    static constexpr size_t MAX_WORKERS = 4;
+
+    // Where each stage runs: 0 = inline in Submit(), 1..MAX_WORKERS = that
+    // worker. Must not decrease from one stage to the next.
+    uint8_t stage_worker[MAX_STAGES];
+
+    // CPU per worker (index 1..MAX_WORKERS; index 0 unused), -1 = unpinned
+    int16_t worker_cpu[MAX_WORKERS + 1];
+
+    uint32_t ring_capacity;         // Per ring, rounded up to a power of two
+
+    // Every stage inline on the submitting thread
+    static StagedPipelineLayout Inline();
+
+    // stage_count stages spread over workers (1..MAX_WORKERS) in contiguous
+    // groups, earlier workers taking the extra stage when they do not divide
+    static StagedPipelineLayout Spread(size_t stage_count, size_t workers);
+
+    // Pin worker w to first_cpu + w - 1
+    void PinSequential(int first_cpu);
+};
+
+// ===============================
+// Statistics
+// ===============================
+
+struct StageStats {
+    const char* name;
+    uint8_t worker;                 // 0 = inline
+    int cpu;                        // -1 = unpinned or pinning failed
+    uint64_t processed;             // Messages offered to the stage
+    uint64_t passed;                // Messages the stage let through
+    bigtime_t busy_us;              // Time spent inside the stage
+    double occupancy;               // busy_us over wall time since Start() (0-1)
+    uint32_t queue_depth;           // Input ring depth (worker stages)
+    uint32_t queue_high_water;
+    uint64_t stalls;                // Times the stage waited for room downstream
+};
+
+// ===============================
+// Pipeline
+// ===============================
+
+class StagedPipeline {
+public:
+    static constexpr size_t MAX_STAGES = StagedPipelineLayout::MAX_STAGES;
+    static constexpr size_t BATCH_SIZE = 64;
+
+    StagedPipeline(MetricsRegistry* registry = nullptr);
+    ~StagedPipeline();
+
+    StagedPipeline(const StagedPipeline&) = delete;
+    StagedPipeline& operator=(const StagedPipeline&) = delete;
+
+    /**
+     * Append a stage (before Start())
+     *
+     * Publishes pipeline.<name>.processed, .busy_us, .occupancy_pct,
+     * .queue_depth and .stalls when a registry was given.
+     *
+     * @return false when MAX_STAGES are already added or the pipeline runs
+     */
+    template<typename Stage>
+    bool AddStage(const char* name, Stage* stage) {
+        return AddStageThunk(name, stage, &RunStage<Stage>);
+    }
+
+    /**
+     * Create rings and start the workers the layout uses
+     *
+     * @return APC_ERROR_INVALID_PARAMETER for a layout that does not fit the
+     *         stages (a stage placed before the previous one's worker)
+     */
+    APCMiniError Start(const StagedPipelineLayout& layout);
+
+    // Drain every ring through the remaining stages and join the workers
+    void Stop();
+
+    bool IsRunning() const { return running; }
+
+    /**
+     * Feed one message
+     *
+     * @return false if the first ring is full (counted as dropped; Submit()
+     *         never blocks). A message an inline stage filters out counts
+     *         as taken.
+     */
+    bool Submit(const MIDIMessage& message);
+
+    /**
+     * Feed a batch, e.g. one USB transfer
+     *
+     * @return how many messages from the front were taken; the caller may
+     *         retry the rest later or drop them
+     */
+    size_t SubmitBatch(const MIDIMessage* messages, size_t count);
+
+    // Wait until every submitted message left the last stage
+    void Flush();
+
+    size_t StageCount() const { return stage_count; }
+    StageStats GetStageStats(size_t index) const;
+
+    // Refusals because the first ring was full
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Refresh the .occupancy_pct metrics over the interval since the last call
+    void Sample();
+
+    // Pin the calling thread (e.g. the USB reader feeding Submit())
+    static bool PinCurrentThread(int cpu);
+
+private:
+    typedef size_t (*StageThunk)(void* stage, MIDIMessage* batch, size_t count);
+
+    enum MetricIndex {
+        METRIC_PROCESSED = 0,
+        METRIC_BUSY,
+        METRIC_OCCUPANCY,
+        METRIC_DEPTH,
+        METRIC_STALLS,
+        METRIC_COUNT
+    };
+
+    struct StageSlot {
+        char name[24];
+        char metric_names[METRIC_COUNT][48];
+        void* stage;
+        StageThunk run;
+        uint8_t worker;
+        std::atomic<uint64_t> metrics[METRIC_COUNT];
+        std::atomic<uint64_t> passed;
+        std::atomic<uint32_t> high_water;
+        // Last Sample(), for the windowed occupancy
+        bigtime_t sampled_at;
+        uint64_t sampled_busy;
+    };
+
+    struct Worker {
+        uint8_t index;
+        int requested_cpu;
+        std::atomic<int> cpu;                      // Effective; -1 unpinned
+        size_t first_stage;
+        size_t end_stage;
+        MIDISPSCRing* input;
+        Worker* next;                              // nullptr for the last worker
+        std::thread thread;
+        std::atomic<bool> upstream_done;
+        std::atomic<bool> sleeping;
+        std::atomic<uint64_t> received;            // Messages pushed into input
+        std::atomic<uint64_t> completed;           // Messages done and passed on
+        std::mutex wait_lock;
+        std::condition_variable wake;
+    };
+
+    template<typename Stage>
+    static size_t RunStage(void* context, MIDIMessage* batch, size_t count) {
+        Stage* stage = static_cast<Stage*>(context);
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (stage->Process(batch[i])) {
+                if (kept != i) {
+                    batch[kept] = batch[i];
+                }
+                kept++;
+            }
+        }
+        return kept;
+    }
+
+    bool AddStageThunk(const char* name, void* stage, StageThunk run);
+
+    // Run stages [first, end) over the batch, timing each; returns survivors
+    size_t RunStages(size_t first, size_t end, MIDIMessage* batch, size_t count);
+
+    // Push everything into a worker's ring, waiting for room when it is full
+    void PushBlocking(Worker& target, const MIDIMessage* batch, size_t count, size_t stalling_stage);
+    static void Wake(Worker& worker);
+
+    void WorkerLoop(Worker* worker);
+
+    MetricsRegistry* registry;
+    StageSlot stages[MAX_STAGES];
+    size_t stage_count;
+
+    size_t inline_end;                             // Stages [0, inline_end) run in Submit()
+    std::vector<Worker*> workers;
+    std::vector<MIDISPSCRing*> rings;
+    bool running;
+    bigtime_t started_at;
+    std::atomic<uint64_t> dropped;
+};
+
+#endif // STAGED_PIPELINE_H
@@ -0,0 +1,213 @@
+// Staged Pipeline Benchmark
+// Throughput of parse/normalize -> transform/state -> fan-out under
+// saturated synthetic input, with the stages spread over 1 to 4 cores:
+//
+//   1 core:  every stage inline on the reader thread (today's looper)
+//   2 cores: parse inline on the reader, transform + fan-out on a worker
+//   3 cores: parse inline, transform and fan-out on a worker each
+//   4 cores: the reader only feeds; each stage on its own worker
+//
+// Real APC stages do a few nanoseconds of work, less than a cross-core
+// handoff, so each stage also burns --work iterations per message to stand
+// in for an expensive transform or many dispatch targets. With three equal
+// stages the ceiling is 3x; the fourth core takes the reader off the
+// parse stage.
+//
+// Usage: staged_pipeline_benchmark [--events <count>] [--work <iterations>] [--pin]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "staged_pipeline.h"
+#include "midi_pipeline.h"
+
+typedef APCMiniMK2Device BenchDevice;
+
+static const size_t SUBMIT_BATCH = 32;       // Messages per simulated USB transfer
+
+// Fixed per-message cost the compiler cannot remove
+struct WorkStage {
+    uint32_t iterations;
+    uint32_t sink;
+
+    bool Process(MIDIMessage& message) {
+        uint32_t hash = message.status * 31u + message.data1;
+        for (uint32_t i = 0; i < iterations; i++) {
+            hash = hash * 1664525u + 1013904223u;
+        }
+        sink += hash;
+        return true;
+    }
+};
+
+// Last stage: count what is dispatched, as the UI inbox would see it
+struct CountStage {
+    uint64_t delivered;
+
+    bool Process(MIDIMessage&) {
+        delivered++;
+        return true;
+    }
+};
+
+typedef MIDIPipeline<StatusFilterStage<MIDI_TYPES_APC_INPUT>, NoteOffNormalizeStage, WorkStage> ParseStage;
+typedef MIDIPipeline<ControlStateStage<BenchDevice>, WorkStage> TransformStage;
+typedef MIDIPipeline<WorkStage, CountStage> FanOutStage;
+
+// Pads, releases, faders and buttons, all of which pass every stage
+static std::vector<MIDIMessage> BuildStream(size_t count)
+{
+    std::vector<MIDIMessage> events(count);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t roll = (seed >> 16) % 100;
+        uint8_t pad = (uint8_t)((seed >> 8) & 0x3F);
+        if (roll < 35) {
+            events[i] = MIDIMessage(0x90, pad, (uint8_t)(1 + (seed & 0x7E)), MIDI_SOURCE_HARDWARE_USB, 1);
+        } else if (roll < 60) {
+            events[i] = MIDIMessage(0x90, pad, 0, MIDI_SOURCE_HARDWARE_USB, 1);
+        } else if (roll < 90) {
+            events[i] = MIDIMessage(0xB0, (uint8_t)(APC_MINI_FADER_CC_START + (seed >> 8) % 9),
+                                    (uint8_t)(seed & 0x7F), MIDI_SOURCE_HARDWARE_USB, 1);
+        } else {
+            events[i] = MIDIMessage(0x90, (uint8_t)(APC_MINI_TRACK_NOTE_START + ((seed >> 8) & 0x7)), 127,
+                                    MIDI_SOURCE_HARDWARE_USB, 1);
+        }
+    }
+    return events;
+}
+
+static StagedPipelineLayout LayoutForCores(int cores)
+{
+    StagedPipelineLayout layout = StagedPipelineLayout::Inline();
+    switch (cores) {
+        case 2:
+            layout.stage_worker[1] = 1;
+            layout.stage_worker[2] = 1;
+            break;
+        case 3:
+            layout.stage_worker[1] = 1;
+            layout.stage_worker[2] = 2;
+            break;
+        case 4:
+            layout = StagedPipelineLayout::Spread(3, 3);
+            break;
+        default:
+            break;
+    }
+    return layout;
+}
+
+struct RunResult {
+    double messages_per_sec;
+    StageStats stages[3];
+    uint64_t delivered;
+};
+
+static RunResult Run(const std::vector<MIDIMessage>& events, int cores, uint32_t work, bool pin)
+{
+    PipelineControlState state;
+    ParseStage parse = MakeMIDIPipeline(StatusFilterStage<MIDI_TYPES_APC_INPUT>(), NoteOffNormalizeStage(),
+                                        WorkStage{work, 0});
+    TransformStage transform = MakeMIDIPipeline(ControlStateStage<BenchDevice>{&state}, WorkStage{work, 0});
+    FanOutStage fan_out = MakeMIDIPipeline(WorkStage{work, 0}, CountStage{0});
+
+    StagedPipeline pipeline;
+    pipeline.AddStage("parse", &parse);
+    pipeline.AddStage("transform", &transform);
+    pipeline.AddStage("fanout", &fan_out);
+
+    // Reader on CPU 0, workers after it
+    StagedPipelineLayout layout = LayoutForCores(cores);
+    if (pin) {
+        layout.PinSequential(1);
+        StagedPipeline::PinCurrentThread(0);
+    }
+    pipeline.Start(layout);
+
+    // Saturated: the reader offers the next transfer as soon as there is room
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (offset < events.size()) {
+        size_t count = events.size() - offset < SUBMIT_BATCH ? events.size() - offset : SUBMIT_BATCH;
+        size_t taken = pipeline.SubmitBatch(&events[offset], count);
+        offset += taken;
+        if (taken < count) {
+            std::this_thread::yield();
+        }
+    }
+    pipeline.Flush();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    RunResult result;
+    for (int i = 0; i < 3; i++) {
+        result.stages[i] = pipeline.GetStageStats(i);
+    }
+    pipeline.Stop();
+
+    result.messages_per_sec = events.size() / std::chrono::duration<double>(elapsed).count();
+    result.delivered = fan_out.Stage<1>().delivered;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    size_t event_count = 500000;
+    uint32_t work = 200;
+    bool pin = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            event_count = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--work") == 0 && i + 1 < argc) {
+            work = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else {
+            printf("Usage: %s [--events <count>] [--work <iterations>] [--pin]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (event_count == 0) {
+        printf("❌ --events must be positive\n");
+        return 1;
+    }
+
+    unsigned cpus = std::thread::hardware_concurrency();
+    printf("🧵 Staged Pipeline Benchmark (%zu events, %u work iterations per stage, %s)\n",
+           event_count, work, pin ? "pinned" : "unpinned");
+    printf("Stages: parse/normalize -> transform/state -> fan-out, %u CPUs available\n\n", cpus);
+    if (cpus < 4) {
+        printf("⚠️  Fewer than 4 CPUs: runs with more cores than that are oversubscribed\n\n");
+    }
+
+    std::vector<MIDIMessage> events = BuildStream(event_count);
+
+    double baseline = 0;
+    for (int cores = 1; cores <= 4; cores++) {
+        RunResult result = Run(events, cores, work, pin);
+        if (result.delivered != event_count) {
+            printf("❌ %d cores: delivered %llu of %zu\n", cores, (unsigned long long)result.delivered,
+                   event_count);
+            return 1;
+        }
+        if (cores == 1) {
+            baseline = result.messages_per_sec;
+        }
+
+        printf("   %d core%s: %10.0f msg/s (%.2fx) | occupancy", cores, cores == 1 ? " " : "s",
+               result.messages_per_sec, result.messages_per_sec / baseline);
+        for (int i = 0; i < 3; i++) {
+            const StageStats& stage = result.stages[i];
+            printf("  %s %3.0f%%%s", stage.name, stage.occupancy * 100,
+                   stage.worker == 0 ? " (inline)" : "");
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "state_journal.h"
+#include "metrics_registry.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __HAIKU__
+#include <FindDirectory.h>
+#endif
+
+// 'APCJ'
+#define JOURNAL_MAGIC    0x4150434Au
+#define JOURNAL_VERSION  1
+
+void JournalState::Clear()
+{
+    memset(this, 0, sizeof(*this));
+    leds.Clear();
+}
+
+void JournalState::SetFader(uint8_t fader_index, uint8_t value)
+{
+    if (fader_index >= APC_MINI_TOTAL_FADER_COUNT) {
+        return;
+    }
+    fader_values[fader_index] = value;
+    faders_known |= (uint16_t)(1u << fader_index);
+}
+
+size_t JournalState::BuildLEDMessages(uint8_t (*messages)[3], size_t max_messages) const
+{
+    size_t count = 0;
+    for (size_t led = 0; led < LED_SNAPSHOT_LED_COUNT && count < max_messages; led++) {
+        messages[count][0] = MIDI_NOTE_ON | (leds.channel[led] & 0x0F);
+        messages[count][1] = LEDSnapshot::NoteForLED(led);
+        messages[count][2] = leds.velocity[led];
+        count++;
+    }
+    return count;
+}
+
+StateJournal::StateJournal(MetricsRegistry* metrics_registry)
+    : registry(metrics_registry)
+    , fd(-1)
+    , header(nullptr)
+    , next_sequence(1)
+    , newest_valid(-1)
+    , commits(0)
+    , restores(0)
+    , invalid_records(0)
+{
+    if (registry) {
+        registry->RegisterCounter("journal.commits", &commits);
+        registry->RegisterCounter("journal.invalid_records", &invalid_records);
+    }
+}
+
+StateJournal::~StateJournal()
+{
+    if (registry) {
+        registry->Unregister(&commits);
+        registry->Unregister(&invalid_records);
+    }
+    Close();
+}
+
+APCMiniError StateJournal::Open(const char* path)
+{
+    if (!path) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+    Close();
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        printf("❌ State journal: cannot open %s\n", path);
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    struct stat info;
+    bool fresh = fstat(fd, &info) != 0 || info.st_size != (off_t)sizeof(FileHeader);
+    if (fresh && ftruncate(fd, sizeof(FileHeader)) != 0) {
+        close(fd);
+        fd = -1;
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    void* mapping = mmap(nullptr, sizeof(FileHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        fd = -1;
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+    header = static_cast<FileHeader*>(mapping);
+
+    if (fresh || header->magic != JOURNAL_MAGIC || header->version != JOURNAL_VERSION ||
+        header->record_size != sizeof(Record)) {
+        // Unknown layout (older build, truncated file): start empty
+        memset(static_cast<void*>(header), 0, sizeof(FileHeader));
+        header->version = JOURNAL_VERSION;
+        header->record_size = sizeof(Record);
+        header->magic = JOURNAL_MAGIC;
+    }
+
+    // Sequences keep growing past torn records; the next commit must not
+    // overwrite the newest record that still checks out
+    next_sequence = 1;
+    newest_valid = -1;
+    uint64_t newest_sequence = 0;
+    for (int i = 0; i < 2; i++) {
+        const Record& record = header->records[i];
+        uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+        if (sequence >= next_sequence) {
+            next_sequence = sequence + 1;
+        }
+        if (sequence > newest_sequence && record.checksum == Checksum(record.state, sequence)) {
+            newest_sequence = sequence;
+            newest_valid = i;
+        }
+    }
+
+    return APC_SUCCESS;
+}
+
+void StateJournal::Close()
+{
+    if (header) {
+        munmap(header, sizeof(FileHeader));
+        header = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+APCMiniError StateJournal::Commit(const JournalState& state)
+{
+    if (!header) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    // Overwrite the other record; the newest valid one stays intact throughout
+    int target_index = newest_valid == 0 ? 1 : 0;
+    Record& target = header->records[target_index];
+
+    uint64_t sequence = next_sequence++;
+    target.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&target.state, &state, sizeof(state));
+    target.checksum = Checksum(state, sequence);
+    target.sequence.store(sequence, std::memory_order_release);
+    newest_valid = target_index;
+
+    commits.fetch_add(1, std::memory_order_relaxed);
+    return APC_SUCCESS;
+}
+
+APCMiniError StateJournal::Sync()
+{
+    if (!header) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    return msync(header, sizeof(FileHeader), MS_SYNC) == 0 ? APC_SUCCESS : APC_ERROR_TIMEOUT;
+}
+
+bool StateJournal::Restore(JournalState& state)
+{
+    if (!header) {
+        return false;
+    }
+
+    JournalState candidates[2];
+    uint64_t sequences[2] = {0, 0};
+    bool valid[2];
+    for (int i = 0; i < 2; i++) {
+        valid[i] = ReadRecord(header->records[i], candidates[i], &sequences[i]);
+    }
+
+    int newest = -1;
+    for (int i = 0; i < 2; i++) {
+        if (valid[i] && (newest < 0 || sequences[i] > sequences[newest])) {
+            newest = i;
+        }
+    }
+    if (newest < 0) {
+        return false;
+    }
+
+    state = candidates[newest];
+    restores.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool StateJournal::ReadRecord(const Record& record, JournalState& state, uint64_t* sequence)
+{
+    uint64_t before = record.sequence.load(std::memory_order_acquire);
+    if (before == 0) {
+        return false;   // Empty, or interrupted while being written
+    }
+
+    memcpy(&state, &record.state, sizeof(state));
+    uint32_t checksum = record.checksum;
+
+    if (record.sequence.load(std::memory_order_acquire) != before ||
+        checksum != Checksum(state, before)) {
+        invalid_records.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    *sequence = before;
+    return true;
+}
+
+StateJournalStats StateJournal::GetStats() const
+{
+    StateJournalStats stats;
+    stats.commits = commits.load();
+    stats.restores = restores.load();
+    stats.invalid_records = invalid_records.load();
+    stats.sequence = next_sequence - 1;
+    return stats;
+}
+
+uint32_t StateJournal::Checksum(const JournalState& state, uint64_t sequence)
+{
+    // FNV-1a over the sequence and the state bytes
+    uint32_t hash = 2166136261u;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&sequence);
+    for (size_t i = 0; i < sizeof(sequence); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    bytes = reinterpret_cast<const uint8_t*>(&state);
+    for (size_t i = 0; i < sizeof(state); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool StateJournal::DefaultPath(char* path, size_t path_size)
+{
+    if (!path || path_size == 0) {
+        return false;
+    }
+
+#ifdef __HAIKU__
+    char directory[B_PATH_NAME_LENGTH];
+    if (find_directory(B_USER_SETTINGS_DIRECTORY, -1, true, directory, sizeof(directory)) != B_OK) {
+        return false;
+    }
+    int written = snprintf(path, path_size, "%s/%s", directory, STATE_JOURNAL_FILE_NAME);
+#else
+    const char* home = getenv("HOME");
+    if (!home || !*home) {
+        return false;
+    }
+    int written = snprintf(path, path_size, "%s/.%s", home, STATE_JOURNAL_FILE_NAME);
+#endif
+
+    return written > 0 && (size_t)written < path_size;
+}
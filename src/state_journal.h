@@ -0,0 +1,131 @@
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+/*
+ * Memory-Mapped State Journal
+ *
+ * Keeps the last known device state (LEDs, fader positions, pad colors) in
+ * a small file mapped with MAP_SHARED, so it survives a crash or restart of
+ * the application. Startup reads it back in microseconds instead of showing
+ * dark LEDs and faders stuck at the "needs sync" value.
+ *
+ * Crash consistency: the file holds two sequence-stamped records. Commit()
+ * always writes the one that is not the newest valid record:
+ *
+ *   1. clear its sequence (record now invalid)
+ *   2. copy the state and its checksum
+ *   3. store the new sequence (release)
+ *
+ * A crash at any point leaves the other record intact; Restore() returns
+ * the valid record with the highest sequence. The pages live in the file
+ * cache, so a process crash loses nothing; Sync() additionally flushes them
+ * to disk for power loss.
+ *
+ * Threading: one writer (Commit, Sync); Restore from the same thread or
+ * before the writer starts.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+#include "led_snapshot_bank.h"
+
+class MetricsRegistry;
+
+#define STATE_JOURNAL_FILE_NAME "apc_mini_state.journal"
+
+struct JournalState {
+    LEDSnapshot leds;                                   // What the device shows
+    APCMiniMK2RGB pad_rgb[APC_MINI_PAD_COUNT];          // GUI pad colors
+    uint8_t fader_values[APC_MINI_TOTAL_FADER_COUNT];
+    uint16_t faders_known;                              // Bit per fader: value reported by the device
+    uint8_t device_mode;
+    uint8_t led_mode;
+
+    void Clear();
+    void SetFader(uint8_t fader_index, uint8_t value);
+    bool IsFaderKnown(uint8_t fader_index) const { return (faders_known >> fader_index) & 1; }
+
+    // Note On messages (status, note, velocity) that bring the device LEDs
+    // to this state, ready for one batched send
+    size_t BuildLEDMessages(uint8_t (*messages)[3], size_t max_messages) const;
+};
+
+struct StateJournalStats {
+    uint64_t commits;
+    uint64_t restores;
+    uint64_t invalid_records;      // Torn or corrupt records skipped by Restore
+    uint64_t sequence;             // Sequence of the newest record
+};
+
+class StateJournal {
+public:
+    StateJournal(MetricsRegistry* registry = nullptr);
+    ~StateJournal();
+
+    /**
+     * Map (creating if needed) the journal file
+     *
+     * A file with a different layout is reset to empty.
+     */
+    APCMiniError Open(const char* path);
+    void Close();
+    bool IsOpen() const { return header != nullptr; }
+
+    // Persist a new version of the state (memcpy + checksum, no syscalls)
+    APCMiniError Commit(const JournalState& state);
+
+    // Flush the mapping to disk (blocking; call on quit or periodically)
+    APCMiniError Sync();
+
+    /**
+     * Read back the newest valid state
+     *
+     * @return false if the journal is empty or both records are invalid
+     */
+    bool Restore(JournalState& state);
+
+    StateJournalStats GetStats() const;
+
+    /**
+     * Per-user journal location (settings directory on Haiku, $HOME elsewhere)
+     *
+     * @return false if no directory could be determined
+     */
+    static bool DefaultPath(char* path, size_t path_size);
+
+private:
+    struct Record {
+        std::atomic<uint64_t> sequence;    // 0 = empty or being written
+        uint32_t checksum;
+        uint32_t reserved;
+        JournalState state;
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t record_size;
+        uint32_t reserved2;
+        Record records[2];
+    };
+
+    static uint32_t Checksum(const JournalState& state, uint64_t sequence);
+    bool ReadRecord(const Record& record, JournalState& state, uint64_t* sequence);
+
+    MetricsRegistry* registry;
+    int fd;
+    FileHeader* header;
+    uint64_t next_sequence;
+    int newest_valid;               // Record index Commit must not touch, -1 if none
+
+    std::atomic<uint64_t> commits;
+    std::atomic<uint64_t> restores;
+    std::atomic<uint64_t> invalid_records;
+};
+
+#endif // STATE_JOURNAL_H
@@ -0,0 +1,126 @@
+// State Journal Restart Benchmark
+// Restart-to-restored time on the simulated MK2 (full-speed USB model):
+// map the journal, read back the newest record and push every LED, until
+// the last LED message has reached the device. Commit cost is reported too,
+// since the GUI commits on every LED or fader change.
+//
+// Usage: state_journal_benchmark [--restarts <count>] [--path <file>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <unistd.h>
+
+#include "state_journal.h"
+#include "midi_transport.h"
+#include "latency_histogram.h"
+
+static void Report(const char* name, LatencyHistogram& histogram)
+{
+    printf("   %-22s p50 %6lld  p99 %6lld  max %6lld us\n", name,
+           (long long)histogram.Percentile(50.0), (long long)histogram.Percentile(99.0),
+           (long long)histogram.Max());
+}
+
+int main(int argc, char** argv)
+{
+    int restarts = 200;
+    const char* path = "/tmp/apc_mini_state_journal_benchmark.journal";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--restarts") == 0 && i + 1 < argc) {
+            restarts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            printf("Usage: %s [--restarts <count>] [--path <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (restarts <= 0) {
+        printf("❌ --restarts must be positive\n");
+        return 1;
+    }
+
+    printf("📓 State Journal Restart Benchmark (%d restarts)\n\n", restarts);
+
+    // Previous session: a full look plus known faders
+    JournalState saved;
+    saved.Clear();
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        saved.leds.SetPad(pad, (uint8_t)(pad + 1));
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        saved.leds.SetTrackButton(i, LED_BUTTON_ON);
+        saved.leds.SetSceneButton(i, LED_BUTTON_BLINK);
+    }
+    for (uint8_t fader = 0; fader < APC_MINI_TOTAL_FADER_COUNT; fader++) {
+        saved.SetFader(fader, (uint8_t)(fader * 14));
+    }
+
+    {
+        StateJournal journal;
+        if (journal.Open(path) != APC_SUCCESS) {
+            return 1;
+        }
+
+        // Commit cost, paid on the LED/fader path while running
+        const int commits = 100000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < commits; i++) {
+            saved.fader_values[0] = (uint8_t)(i & 0x7F);
+            journal.Commit(saved);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        printf("   Commit:                %8.0f ns (%zu-byte record, no syscalls)\n\n",
+               std::chrono::duration<double, std::nano>(elapsed).count() / commits,
+               sizeof(JournalState));
+        journal.Sync();
+    }
+
+    SimulatedDeviceTransport device(SimulatedLinkModel::FullSpeedUSB());
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    LatencyHistogram read_latency;
+    LatencyHistogram lit_latency;
+    uint8_t messages[LED_SNAPSHOT_LED_COUNT][3];
+    int failures = 0;
+
+    for (int i = 0; i < restarts; i++) {
+        // Each iteration is a fresh process view of the file
+        bigtime_t start = system_time();
+        StateJournal journal;
+        JournalState restored;
+        if (journal.Open(path) != APC_SUCCESS || !journal.Restore(restored)) {
+            failures++;
+            continue;
+        }
+        bigtime_t read_done = system_time();
+
+        size_t count = restored.BuildLEDMessages(messages, LED_SNAPSHOT_LED_COUNT);
+        for (size_t m = 0; m < count; m++) {
+            device.SendMIDI(messages[m][0], messages[m][1], messages[m][2]);
+        }
+
+        read_latency.Record(read_done - start);
+        bigtime_t lit_at = device.GetLastLEDLitTime();
+        lit_latency.Record(lit_at - start);
+
+        snooze_until(lit_at + 5000, B_SYSTEM_TIMEBASE);
+    }
+
+    device.Close();
+    unlink(path);
+
+    Report("Open + restore", read_latency);
+    Report("Restart to LEDs lit", lit_latency);
+    if (failures > 0) {
+        printf("\n❌ %d restarts found no state\n", failures);
+        return 1;
+    }
+
+    printf("\n   Restore is a page-cache read; the LED push is bound by link packets.\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * State Journal Test
+ * Round trip, persistence across reopen, torn record fallback, layout reset
+ */
+
+#include "state_journal.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define TEST_JOURNAL_PATH "/tmp/apc_mini_state_journal_test.journal"
+
+static JournalState MakeState(uint8_t seed)
+{
+    JournalState state;
+    state.Clear();
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        state.leds.SetPad(pad, (uint8_t)((pad + seed) % 128));
+        state.pad_rgb[pad].red = seed;
+        state.pad_rgb[pad].green = pad;
+        state.pad_rgb[pad].blue = (uint8_t)(seed + pad);
+    }
+    state.leds.SetTrackButton(seed % 8, LED_BUTTON_ON);
+    state.SetFader(seed % APC_MINI_TOTAL_FADER_COUNT, seed);
+    state.device_mode = 1;
+    return state;
+}
+
+// Record offsets are private; find a record by its pad colors in the file
+static long FindRecordOffset(const JournalState& state)
+{
+    FILE* file = fopen(TEST_JOURNAL_PATH, "rb");
+    assert(file);
+    static uint8_t contents[1 << 16];
+    size_t size = fread(contents, 1, sizeof(contents), file);
+    fclose(file);
+
+    const uint8_t* needle = reinterpret_cast<const uint8_t*>(&state.pad_rgb);
+    for (size_t offset = 0; offset + sizeof(state.pad_rgb) <= size; offset++) {
+        if (memcmp(contents + offset, needle, sizeof(state.pad_rgb)) == 0) {
+            return (long)offset;
+        }
+    }
+    return -1;
+}
+
+static void CorruptByte(long offset)
+{
+    int fd = open(TEST_JOURNAL_PATH, O_RDWR);
+    assert(fd >= 0);
+    uint8_t value = 0;
+    assert(pread(fd, &value, 1, offset) == 1);
+    value ^= 0xFF;
+    assert(pwrite(fd, &value, 1, offset) == 1);
+    close(fd);
+}
+
+void test_round_trip_and_reopen()
+{
+    printf("Testing commit/restore and reopen...\n");
+    unlink(TEST_JOURNAL_PATH);
+
+    MetricsRegistry registry;
+    JournalState restored;
+    {
+        StateJournal journal(&registry);
+        assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+
+        // Fresh file: nothing to restore
+        assert(!journal.Restore(restored));
+
+        JournalState state = MakeState(5);
+        assert(journal.Commit(state) == APC_SUCCESS);
+        assert(journal.Restore(restored));
+        assert(memcmp(&restored, &state, sizeof(state)) == 0);
+
+        MetricSample sample;
+        assert(registry.Find("journal.commits", sample) && sample.value == 1);
+    }
+
+    // A new process sees the last committed state
+    StateJournal journal;
+    assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+    assert(journal.Restore(restored));
+    JournalState expected = MakeState(5);
+    assert(memcmp(&restored, &expected, sizeof(expected)) == 0);
+    assert(restored.IsFaderKnown(5) && restored.fader_values[5] == 5);
+    assert(!restored.IsFaderKnown(0));
+
+    // Sequence continues where the previous instance stopped
+    assert(journal.Commit(MakeState(6)) == APC_SUCCESS);
+    assert(journal.GetStats().sequence == 2);
+    assert(journal.Sync() == APC_SUCCESS);
+
+    printf("✅ State survives close and reopen\n");
+}
+
+void test_torn_record_falls_back()
+{
+    printf("Testing fallback to the older record...\n");
+    unlink(TEST_JOURNAL_PATH);
+
+    JournalState older = MakeState(20);
+    JournalState newer = MakeState(21);
+    {
+        StateJournal journal;
+        assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+        assert(journal.Commit(older) == APC_SUCCESS);
+        assert(journal.Commit(newer) == APC_SUCCESS);
+    }
+
+    // Damage the newest record as a crash mid-memcpy would
+    long offset = FindRecordOffset(newer);
+    assert(offset > 0);
+    CorruptByte(offset);
+
+    JournalState restored;
+    {
+        StateJournal journal;
+        assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+        assert(journal.Restore(restored));
+        assert(memcmp(&restored, &older, sizeof(older)) == 0);
+        assert(journal.GetStats().invalid_records == 1);
+
+        // The next commit overwrites the damaged record, not the good one
+        JournalState latest = MakeState(22);
+        assert(journal.Commit(latest) == APC_SUCCESS);
+        assert(journal.Restore(restored));
+        assert(memcmp(&restored, &latest, sizeof(latest)) == 0);
+    }
+
+    // Both records damaged: nothing restored
+    CorruptByte(FindRecordOffset(older));
+    CorruptByte(FindRecordOffset(MakeState(22)));
+    StateJournal journal;
+    assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+    assert(!journal.Restore(restored));
+    assert(journal.GetStats().invalid_records == 2);
+
+    printf("✅ A torn write never loses the previous state\n");
+}
+
+void test_layout_mismatch_resets()
+{
+    printf("Testing reset of foreign files...\n");
+    unlink(TEST_JOURNAL_PATH);
+
+    FILE* file = fopen(TEST_JOURNAL_PATH, "wb");
+    assert(file);
+    fputs("not a journal", file);
+    fclose(file);
+
+    StateJournal journal;
+    assert(journal.Open(TEST_JOURNAL_PATH) == APC_SUCCESS);
+    JournalState restored;
+    assert(!journal.Restore(restored));
+    assert(journal.Commit(MakeState(1)) == APC_SUCCESS);
+    assert(journal.Restore(restored));
+    journal.Close();
+    assert(!journal.IsOpen());
+    assert(journal.Commit(MakeState(2)) == APC_ERROR_DEVICE_NOT_FOUND);
+
+    assert(journal.Open(nullptr) == APC_ERROR_INVALID_PARAMETER);
+
+    printf("✅ Unknown layouts start empty\n");
+}
+
+void test_led_messages()
+{
+    printf("Testing LED message build...\n");
+
+    JournalState state = MakeState(3);
+    uint8_t messages[LED_SNAPSHOT_LED_COUNT][3];
+    size_t count = state.BuildLEDMessages(messages, LED_SNAPSHOT_LED_COUNT);
+    assert(count == LED_SNAPSHOT_LED_COUNT);
+
+    for (size_t led = 0; led < count; led++) {
+        assert((messages[led][0] & 0xF0) == MIDI_NOTE_ON);
+        assert(messages[led][1] == LEDSnapshot::NoteForLED(led));
+        assert(messages[led][2] == state.leds.velocity[led]);
+    }
+    assert(messages[APC_MINI_PAD_COUNT + 3][2] == LED_BUTTON_ON);
+
+    // Truncated to the caller's buffer
+    assert(state.BuildLEDMessages(messages, 10) == 10);
+
+    printf("✅ Journal state converts to %zu Note On messages\n", count);
+}
+
+int main()
+{
+    printf("📓 State Journal Test\n");
+    printf("=====================\n\n");
+
+    test_round_trip_and_reopen();
+    test_torn_record_falls_back();
+    test_layout_mismatch_resets();
+    test_led_messages();
+
+    unlink(TEST_JOURNAL_PATH);
+
+    printf("\n🎉 ALL TESTS PASSED! Device state survives restarts.\n");
+    return 0;
+}
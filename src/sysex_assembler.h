@@ -0,0 +1,125 @@
+#ifndef SYSEX_ASSEMBLER_H
+#define SYSEX_ASSEMBLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * SysExAssembler - Rebuilds SysEx messages from USB-MIDI event packets
+ *
+ * USB-MIDI splits SysEx into 4-byte packets (USB MIDI 1.0, section 4):
+ *   CIN 0x4 - SysEx starts or continues (3 bytes)
+ *   CIN 0x5 - SysEx ends with 1 byte (also single-byte system common)
+ *   CIN 0x6 - SysEx ends with 2 bytes
+ *   CIN 0x7 - SysEx ends with 3 bytes
+ *
+ * The USB reader thread feeds every packet through Feed(); when it returns
+ * true a complete F0 ... F7 message is available from Data()/Length().
+ * Storage is fixed (no allocation in the reader thread); messages longer
+ * than MAX_SYSEX_LENGTH are discarded and counted.
+ */
+class SysExAssembler {
+public:
+    static constexpr size_t MAX_SYSEX_LENGTH = 256;
+
+    SysExAssembler() : length(0), in_progress(false), overflow(false), dropped_messages(0) {}
+
+    /**
+     * Feed one USB-MIDI packet
+     *
+     * @param cin Code Index Number (low nibble of the packet header)
+     * @param midi The three MIDI bytes of the packet
+     * @return true when the packet completed a SysEx message
+     */
+    bool Feed(uint8_t cin, const uint8_t midi[3]) {
+        switch (cin & 0x0F) {
+            case 0x4:
+                return Append(midi, 3, false);
+            case 0x5:
+                return Append(midi, 1, true);
+            case 0x6:
+                return Append(midi, 2, true);
+            case 0x7:
+                return Append(midi, 3, true);
+            default:
+                return false;
+        }
+    }
+
+    void Reset() {
+        length = 0;
+        in_progress = false;
+        overflow = false;
+    }
+
+    // A non-SysEx status arrived mid-message: drop what was collected
+    void Abort() {
+        if (in_progress) {
+            dropped_messages++;
+        }
+        Reset();
+    }
+
+    const uint8_t* Data() const { return buffer; }
+    size_t Length() const { return length; }
+    bool InProgress() const { return in_progress; }
+    uint32_t DroppedMessages() const { return dropped_messages; }
+
+    // True for CINs that carry SysEx data (as opposed to channel messages)
+    static bool IsSysExCIN(uint8_t cin) {
+        cin &= 0x0F;
+        return cin >= 0x4 && cin <= 0x7;
+    }
+
+private:
+    bool Append(const uint8_t* bytes, size_t count, bool terminates) {
+        for (size_t i = 0; i < count; i++) {
+            uint8_t byte = bytes[i];
+
+            if (byte == 0xF0) {
+                // Start byte always begins a fresh message
+                if (in_progress) {
+                    dropped_messages++;
+                }
+                length = 0;
+                in_progress = true;
+                overflow = false;
+            } else if (!in_progress) {
+                // CIN 0x5 is also used for single-byte system common
+                // messages; those are not SysEx and are ignored here
+                return false;
+            }
+
+            if (length < MAX_SYSEX_LENGTH) {
+                buffer[length++] = byte;
+            } else {
+                overflow = true;
+            }
+
+            if (byte == 0xF7) {
+                in_progress = false;
+                if (overflow) {
+                    dropped_messages++;
+                    length = 0;
+                    return false;
+                }
+                return true;
+            }
+        }
+
+        if (terminates && in_progress) {
+            // End CIN without F7: malformed, drop it
+            dropped_messages++;
+            Reset();
+        }
+        return false;
+    }
+
+    uint8_t buffer[MAX_SYSEX_LENGTH];
+    size_t length;
+    bool in_progress;
+    bool overflow;
+    uint32_t dropped_messages;
+};
+
+#endif // SYSEX_ASSEMBLER_H
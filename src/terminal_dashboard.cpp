@@ -0,0 +1,429 @@
+#include "terminal_dashboard.h"
+#include <string.h>
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+
+// Layout (80x24 and larger; smaller terminals are clipped)
+#define PAD_TOP_ROW        2
+#define PAD_LEFT_COLUMN    2
+#define PAD_CELL_WIDTH     4       // 3 colored cells + gap
+#define SCENE_COLUMN       35
+#define TRACK_ROW          11
+#define FADER_TOP_ROW      13
+#define FADER_BAR_COLUMN   6
+#define FADER_BAR_WIDTH    16
+#define STATS_COLUMN       44
+
+// xterm 256-color indices used for chrome
+#define COLOR_WHITE        15
+#define COLOR_DIM          240
+#define COLOR_PRESSED_BG   238
+#define COLOR_TRACK_ON     9
+#define COLOR_SCENE_ON     10
+#define COLOR_BLINK        11
+#define COLOR_FADER        12
+#define COLOR_TITLE        14
+
+// MK2 LED channels: 0-6 brightness, 7-10 pulse, 11-15 blink
+#define MK2_PULSE_FIRST_CHANNEL  7
+#define MK2_BLINK_FIRST_CHANNEL  11
+
+static const uint8_t MK2_BRIGHTNESS_PERCENT[7] = { 10, 25, 50, 65, 75, 90, 100 };
+
+static const TerminalCanvas::Cell BLANK_CELL = { " ", DASHBOARD_COLOR_DEFAULT, DASHBOARD_COLOR_DEFAULT };
+
+void DashboardSnapshot::Clear()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+// ===============================
+// TerminalCanvas
+// ===============================
+
+bool TerminalCanvas::Cell::operator==(const Cell& other) const
+{
+    return fg == other.fg && bg == other.bg && strcmp(glyph, other.glyph) == 0;
+}
+
+TerminalCanvas::TerminalCanvas(int canvas_columns, int canvas_rows)
+    : columns(0)
+    , rows(0)
+    , invalidated(true)
+    , cursor_column(-1)
+    , cursor_row(-1)
+    , current_fg(DASHBOARD_COLOR_DEFAULT)
+    , current_bg(DASHBOARD_COLOR_DEFAULT)
+{
+    Resize(canvas_columns, canvas_rows);
+}
+
+void TerminalCanvas::Resize(int new_columns, int new_rows)
+{
+    columns = new_columns > 0 ? new_columns : 1;
+    rows = new_rows > 0 ? new_rows : 1;
+    shown.assign((size_t)columns * rows, BLANK_CELL);
+    next.assign((size_t)columns * rows, BLANK_CELL);
+    invalidated = true;
+}
+
+void TerminalCanvas::Clear()
+{
+    std::fill(next.begin(), next.end(), BLANK_CELL);
+}
+
+void TerminalCanvas::Put(int column, int row, const char* glyph, uint16_t fg, uint16_t bg)
+{
+    if (column < 0 || column >= columns || row < 0 || row >= rows || !glyph) {
+        return;
+    }
+
+    Cell& cell = next[row * columns + column];
+    strncpy(cell.glyph, glyph, sizeof(cell.glyph) - 1);
+    cell.glyph[sizeof(cell.glyph) - 1] = '\0';
+    cell.fg = fg;
+    cell.bg = bg;
+}
+
+void TerminalCanvas::Text(int column, int row, const char* text, uint16_t fg, uint16_t bg)
+{
+    if (!text) {
+        return;
+    }
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    while (*p) {
+        size_t length = *p < 0x80 ? 1 : (*p >> 5) == 0x6 ? 2 : (*p >> 4) == 0xE ? 3 : 4;
+        char glyph[4] = { '?', 0, 0, 0 };
+        if (length < sizeof(glyph)) {
+            memcpy(glyph, p, length);
+        }
+        Put(column++, row, glyph, fg, bg);
+
+        // Step over the whole sequence, stopping at a truncated one
+        for (size_t i = 0; i < length && *p; i++) {
+            p++;
+        }
+    }
+}
+
+size_t TerminalCanvas::Render(std::string& out)
+{
+    if (invalidated) {
+        out += "\x1b[0m\x1b[2J";
+        current_fg = DASHBOARD_COLOR_DEFAULT;
+        current_bg = DASHBOARD_COLOR_DEFAULT;
+        cursor_column = -1;
+        cursor_row = -1;
+        std::fill(shown.begin(), shown.end(), BLANK_CELL);
+        invalidated = false;
+    }
+
+    size_t written = 0;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            size_t index = (size_t)row * columns + column;
+            if (next[index] == shown[index]) {
+                continue;
+            }
+
+            MoveTo(out, column, row);
+            SetColors(out, next[index].fg, next[index].bg);
+            out += next[index].glyph;
+            shown[index] = next[index];
+            written++;
+
+            // The last column leaves the cursor in a pending-wrap state
+            cursor_column = column + 1 < columns ? column + 1 : -1;
+        }
+    }
+
+    return written;
+}
+
+void TerminalCanvas::MoveTo(std::string& out, int column, int row)
+{
+    if (cursor_row == row && cursor_column == column) {
+        return;
+    }
+
+    char sequence[32];
+    if (cursor_row == row && cursor_column >= 0 && column > cursor_column) {
+        int gap = column - cursor_column;
+        if (gap == 1) {
+            snprintf(sequence, sizeof(sequence), "\x1b[C");
+        } else {
+            snprintf(sequence, sizeof(sequence), "\x1b[%dC", gap);
+        }
+    } else {
+        snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row + 1, column + 1);
+    }
+    out += sequence;
+
+    cursor_column = column;
+    cursor_row = row;
+}
+
+void TerminalCanvas::SetColors(std::string& out, uint16_t fg, uint16_t bg)
+{
+    if (fg == current_fg && bg == current_bg) {
+        return;
+    }
+
+    char sequence[32];
+    size_t length = 0;
+    length += snprintf(sequence + length, sizeof(sequence) - length, "\x1b[");
+    if (fg != current_fg) {
+        length += fg == DASHBOARD_COLOR_DEFAULT
+            ? snprintf(sequence + length, sizeof(sequence) - length, "39")
+            : snprintf(sequence + length, sizeof(sequence) - length, "38;5;%u", fg);
+    }
+    if (bg != current_bg) {
+        if (fg != current_fg) {
+            sequence[length++] = ';';
+        }
+        length += bg == DASHBOARD_COLOR_DEFAULT
+            ? snprintf(sequence + length, sizeof(sequence) - length, "49")
+            : snprintf(sequence + length, sizeof(sequence) - length, "48;5;%u", bg);
+    }
+    snprintf(sequence + length, sizeof(sequence) - length, "m");
+    out += sequence;
+
+    current_fg = fg;
+    current_bg = bg;
+}
+
+// ===============================
+// TerminalDashboard
+// ===============================
+
+TerminalDashboard::TerminalDashboard(int output_fd)
+    : fd(output_fd)
+    , started(false)
+    , fixed_size(false)
+    , canvas(80, 24)
+{
+    memset(&stats, 0, sizeof(stats));
+    frame.reserve(16384);
+}
+
+TerminalDashboard::~TerminalDashboard()
+{
+    Stop();
+}
+
+void TerminalDashboard::Start()
+{
+    if (started) {
+        return;
+    }
+    // Alternate screen, hidden cursor
+    WriteAll("\x1b[?1049h\x1b[?25l");
+    canvas.Invalidate();
+    started = true;
+}
+
+void TerminalDashboard::Stop()
+{
+    if (!started) {
+        return;
+    }
+    WriteAll("\x1b[0m\x1b[?25h\x1b[?1049l");
+    started = false;
+}
+
+void TerminalDashboard::SetFixedSize(int columns, int rows)
+{
+    fixed_size = true;
+    canvas.Resize(columns, rows);
+}
+
+size_t TerminalDashboard::RenderFrame(const DashboardSnapshot& snapshot)
+{
+    UpdateSize();
+
+    canvas.Clear();
+    Draw(snapshot);
+
+    frame.clear();
+    size_t cells = canvas.Render(frame);
+
+    stats.frames++;
+    stats.last_frame_bytes = frame.size();
+    if (frame.empty()) {
+        return 0;
+    }
+
+    // A failed write leaves the terminal unknown: repaint next frame
+    if (!WriteAll(frame)) {
+        canvas.Invalidate();
+        return 0;
+    }
+
+    stats.frames_written++;
+    stats.bytes_written += frame.size();
+    stats.cells_written += cells;
+    return frame.size();
+}
+
+uint16_t TerminalDashboard::ColorFromMK2(const APCMiniMK2RGB& color, uint8_t brightness_channel)
+{
+    uint32_t percent = brightness_channel < MK2_PULSE_FIRST_CHANNEL
+        ? MK2_BRIGHTNESS_PERCENT[brightness_channel] : 100;
+
+    // 7-bit component scaled by brightness onto the 6-level xterm cube
+    uint32_t red = ((color.red & 0x7F) * percent * 5 + 127 * 50) / (127 * 100);
+    uint32_t green = ((color.green & 0x7F) * percent * 5 + 127 * 50) / (127 * 100);
+    uint32_t blue = ((color.blue & 0x7F) * percent * 5 + 127 * 50) / (127 * 100);
+    return (uint16_t)(16 + 36 * red + 6 * green + blue);
+}
+
+void TerminalDashboard::UpdateSize()
+{
+    if (fixed_size) {
+        return;
+    }
+
+    struct winsize size;
+    if (ioctl(fd, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0 &&
+        (size.ws_col != canvas.Columns() || size.ws_row != canvas.Rows())) {
+        canvas.Resize(size.ws_col, size.ws_row);
+    }
+}
+
+void TerminalDashboard::Draw(const DashboardSnapshot& snapshot)
+{
+    char line[96];
+    snprintf(line, sizeof(line), " APC Mini MK2 dashboard - %s",
+             snapshot.source[0] ? snapshot.source : "no device");
+    canvas.Text(0, 0, line, COLOR_TITLE);
+
+    DrawPads(snapshot);
+    DrawFaders(snapshot);
+    DrawStats(snapshot);
+
+    canvas.Text(1, canvas.Rows() - 1, snapshot.status, COLOR_DIM);
+}
+
+void TerminalDashboard::DrawPads(const DashboardSnapshot& snapshot)
+{
+    // Pad 0 is bottom-left on the hardware
+    for (int pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        int row = PAD_TOP_ROW + (APC_MINI_PAD_ROWS - 1 - PAD_NOTE_TO_Y(pad));
+        int column = PAD_LEFT_COLUMN + PAD_NOTE_TO_X(pad) * PAD_CELL_WIDTH;
+        uint8_t velocity = snapshot.pad_velocity[pad] & 0x7F;
+        uint8_t channel = snapshot.pad_channel[pad] & 0x0F;
+
+        if (velocity == 0) {
+            const char* mark = snapshot.pad_pressed[pad] ? "o" : ".";
+            canvas.Put(column + 1, row, mark, snapshot.pad_pressed[pad] ? COLOR_WHITE : COLOR_DIM,
+                       DASHBOARD_COLOR_DEFAULT);
+            continue;
+        }
+
+        uint16_t bg = ColorFromMK2(APC_MK2_PRESET_COLORS[velocity], channel);
+        const char* mark = snapshot.pad_pressed[pad] ? "o"
+                         : channel >= MK2_BLINK_FIRST_CHANNEL ? "*"
+                         : channel >= MK2_PULSE_FIRST_CHANNEL ? "~" : " ";
+        canvas.Put(column, row, " ", COLOR_WHITE, bg);
+        canvas.Put(column + 1, row, mark, COLOR_WHITE, bg);
+        canvas.Put(column + 2, row, " ", COLOR_WHITE, bg);
+    }
+
+    // Scene buttons (green LEDs) right of the grid, first at the top
+    for (int i = 0; i < 8; i++) {
+        uint16_t fg = snapshot.scene_led[i] == 2 ? COLOR_BLINK
+                    : snapshot.scene_led[i] ? COLOR_SCENE_ON : COLOR_DIM;
+        uint16_t bg = snapshot.scene_pressed[i] ? COLOR_PRESSED_BG : DASHBOARD_COLOR_DEFAULT;
+        canvas.Put(SCENE_COLUMN, PAD_TOP_ROW + i, ">", fg, bg);
+    }
+
+    // Track buttons (red LEDs) under the grid, shift at the end
+    for (int i = 0; i < 8; i++) {
+        int column = PAD_LEFT_COLUMN + i * PAD_CELL_WIDTH;
+        uint16_t fg = snapshot.track_led[i] == 2 ? COLOR_BLINK
+                    : snapshot.track_led[i] ? COLOR_TRACK_ON : COLOR_DIM;
+        uint16_t bg = snapshot.track_pressed[i] ? COLOR_PRESSED_BG : DASHBOARD_COLOR_DEFAULT;
+        canvas.Put(column + 1, TRACK_ROW, "#", fg, bg);
+    }
+    canvas.Text(SCENE_COLUMN - 2, TRACK_ROW, "SHIFT",
+                snapshot.shift_pressed ? COLOR_WHITE : COLOR_DIM,
+                snapshot.shift_pressed ? COLOR_PRESSED_BG : DASHBOARD_COLOR_DEFAULT);
+}
+
+void TerminalDashboard::DrawFaders(const DashboardSnapshot& snapshot)
+{
+    for (int i = 0; i < APC_MINI_TOTAL_FADER_COUNT; i++) {
+        int row = FADER_TOP_ROW + i;
+        char label[8];
+        if (i < APC_MINI_TRACK_FADER_COUNT) {
+            snprintf(label, sizeof(label), "F%d", i + 1);
+        } else {
+            snprintf(label, sizeof(label), "M");
+        }
+        canvas.Text(PAD_LEFT_COLUMN, row, label);
+
+        uint8_t value = snapshot.faders[i] & 0x7F;
+        int filled = (value * FADER_BAR_WIDTH + 63) / 127;
+        for (int cell = 0; cell < FADER_BAR_WIDTH; cell++) {
+            if (cell < filled) {
+                canvas.Put(FADER_BAR_COLUMN + cell, row, "\xe2\x96\x88", COLOR_FADER,
+                           DASHBOARD_COLOR_DEFAULT);      // U+2588 full block
+            } else {
+                canvas.Put(FADER_BAR_COLUMN + cell, row, "\xe2\x96\x91", COLOR_DIM,
+                           DASHBOARD_COLOR_DEFAULT);      // U+2591 light shade
+            }
+        }
+
+        char number[8];
+        snprintf(number, sizeof(number), "%3u", value);
+        canvas.Text(FADER_BAR_COLUMN + FADER_BAR_WIDTH + 1, row, number);
+    }
+}
+
+void TerminalDashboard::DrawStats(const DashboardSnapshot& snapshot)
+{
+    char line[64];
+    int row = PAD_TOP_ROW;
+
+    canvas.Text(STATS_COLUMN, row++, "Latency (send to echo)", COLOR_TITLE);
+    snprintf(line, sizeof(line), "  p50 %8lld us", (long long)snapshot.latency_p50_us);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  p95 %8lld us", (long long)snapshot.latency_p95_us);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  p99 %8lld us", (long long)snapshot.latency_p99_us);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  max %8lld us", (long long)snapshot.latency_max_us);
+    canvas.Text(STATS_COLUMN, row++, line);
+
+    row++;
+    canvas.Text(STATS_COLUMN, row++, "Throughput", COLOR_TITLE);
+    snprintf(line, sizeof(line), "  rx %9.0f msg/s", snapshot.rx_per_sec);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  tx %9.0f msg/s", snapshot.tx_per_sec);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  total rx %llu", (unsigned long long)snapshot.rx_total);
+    canvas.Text(STATS_COLUMN, row++, line);
+    snprintf(line, sizeof(line), "  total tx %llu", (unsigned long long)snapshot.tx_total);
+    canvas.Text(STATS_COLUMN, row++, line);
+}
+
+bool TerminalDashboard::WriteAll(const std::string& data)
+{
+    // One write() per frame; loop only if the kernel takes part of it
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = write(fd, data.data() + offset, data.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += (size_t)written;
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+#ifndef TERMINAL_DASHBOARD_H
+#define TERMINAL_DASHBOARD_H
+
+/*
+ * Terminal Dashboard
+ *
+ * Headless replacement for the BWindow GUI: pad grid in the MK2 palette,
+ * track/scene buttons, faders, latency percentiles and throughput, drawn
+ * with ANSI escape sequences so it works over SSH.
+ *
+ * Instead of reprinting everything like PrintDeviceState()/PrintPadMatrix(),
+ * TerminalCanvas keeps two cell buffers: what the terminal currently shows
+ * and what the next frame should show. Render() emits only the cells that
+ * differ, moving the cursor and changing colors only when needed, and the
+ * dashboard sends the whole frame with a single write(). A frame with no
+ * changes writes nothing.
+ *
+ * The caller owns the frame clock: build a DashboardSnapshot from its state
+ * at a fixed rate and hand it to RenderFrame().
+ *
+ * Threading: one rendering thread.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+#define DASHBOARD_COLOR_DEFAULT 256    // Terminal default foreground/background
+
+// Everything one frame shows (plain copy, cheap to take under a lock)
+struct DashboardSnapshot {
+    uint8_t pad_velocity[APC_MINI_PAD_COUNT];    // LED color (MK2 palette index)
+    uint8_t pad_channel[APC_MINI_PAD_COUNT];     // LED brightness/behaviour channel
+    bool pad_pressed[APC_MINI_PAD_COUNT];
+    uint8_t track_led[8];                        // 0 off, 1 on, 2 blink
+    uint8_t scene_led[8];
+    bool track_pressed[8];
+    bool scene_pressed[8];
+    bool shift_pressed;
+    uint8_t faders[APC_MINI_TOTAL_FADER_COUNT];
+
+    bigtime_t latency_p50_us;
+    bigtime_t latency_p95_us;
+    bigtime_t latency_p99_us;
+    bigtime_t latency_max_us;
+    double rx_per_sec;
+    double tx_per_sec;
+    uint64_t rx_total;
+    uint64_t tx_total;
+
+    char source[32];                             // Transport name
+    char status[64];                             // Free text (bottom line)
+
+    void Clear();
+};
+
+class TerminalCanvas {
+public:
+    struct Cell {
+        char glyph[4];                 // One UTF-8 character, NUL terminated
+        uint16_t fg;                   // xterm 256-color index or DASHBOARD_COLOR_DEFAULT
+        uint16_t bg;
+
+        bool operator==(const Cell& other) const;
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+
+    TerminalCanvas(int columns = 80, int rows = 24);
+
+    // New size; the next Render() repaints the whole screen
+    void Resize(int columns, int rows);
+    int Columns() const { return columns; }
+    int Rows() const { return rows; }
+
+    // Start a frame: every cell blank in default colors
+    void Clear();
+
+    // Drawing clips to the canvas; Text() takes ASCII or UTF-8
+    void Put(int column, int row, const char* glyph, uint16_t fg, uint16_t bg);
+    void Text(int column, int row, const char* text, uint16_t fg = DASHBOARD_COLOR_DEFAULT,
+              uint16_t bg = DASHBOARD_COLOR_DEFAULT);
+    const Cell& At(int column, int row) const { return next[row * columns + column]; }
+
+    // Forget what the terminal shows (after resize or external output)
+    void Invalidate() { invalidated = true; }
+
+    /**
+     * Append the escape sequences that turn the shown screen into the
+     * drawn one, and remember it as shown
+     *
+     * @return number of cells written
+     */
+    size_t Render(std::string& out);
+
+private:
+    void MoveTo(std::string& out, int column, int row);
+    void SetColors(std::string& out, uint16_t fg, uint16_t bg);
+
+    int columns;
+    int rows;
+    std::vector<Cell> shown;           // What the terminal displays
+    std::vector<Cell> next;            // Frame being drawn
+    bool invalidated;
+
+    // Terminal cursor and colors after the last Render() (-1 = unknown)
+    int cursor_column;
+    int cursor_row;
+    uint16_t current_fg;
+    uint16_t current_bg;
+};
+
+struct DashboardStats {
+    uint64_t frames;
+    uint64_t frames_written;           // Frames with at least one changed cell
+    uint64_t bytes_written;
+    uint64_t cells_written;
+    size_t last_frame_bytes;
+};
+
+class TerminalDashboard {
+public:
+    TerminalDashboard(int fd);
+    ~TerminalDashboard();
+
+    // Switch to the alternate screen and hide the cursor (Stop() restores)
+    void Start();
+    void Stop();
+
+    /**
+     * Draw the snapshot and write the changes in one write()
+     *
+     * @return bytes written (0 when nothing changed)
+     */
+    size_t RenderFrame(const DashboardSnapshot& snapshot);
+
+    // Size to draw at; by default the terminal size is queried every frame
+    void SetFixedSize(int columns, int rows);
+
+    DashboardStats GetStats() const { return stats; }
+
+    // xterm 256-color index closest to a 7-bit MK2 color
+    static uint16_t ColorFromMK2(const APCMiniMK2RGB& color, uint8_t brightness_channel);
+
+private:
+    void UpdateSize();
+    void Draw(const DashboardSnapshot& snapshot);
+    void DrawPads(const DashboardSnapshot& snapshot);
+    void DrawFaders(const DashboardSnapshot& snapshot);
+    void DrawStats(const DashboardSnapshot& snapshot);
+    bool WriteAll(const std::string& data);
+
+    int fd;
+    bool started;
+    bool fixed_size;
+    TerminalCanvas canvas;
+    std::string frame;                 // Reused output buffer
+    DashboardStats stats;
+};
+
+#endif // TERMINAL_DASHBOARD_H
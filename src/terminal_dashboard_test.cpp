@@ -0,0 +1,315 @@
+/*
+ * Terminal Dashboard Test
+ * Diffed rendering checked against a minimal terminal emulator, minimal
+ * escape sequences, and one write per changed frame
+ */
+
+#include "terminal_dashboard.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+
+// Just enough of a VT100/xterm to replay what the canvas emits
+class MiniTerminal {
+public:
+    MiniTerminal(int columns, int rows)
+        : columns(columns), rows(rows), cells((size_t)columns * rows, TerminalCanvas::Cell()),
+          column(0), row(0), fg(DASHBOARD_COLOR_DEFAULT), bg(DASHBOARD_COLOR_DEFAULT)
+    {
+        ClearScreen();
+    }
+
+    void Feed(const std::string& data) {
+        size_t i = 0;
+        while (i < data.size()) {
+            if (data[i] == '\x1b') {
+                assert(i + 1 < data.size() && data[i + 1] == '[');
+                size_t end = i + 2;
+                while (end < data.size() && !((data[end] >= 'A' && data[end] <= 'Z') ||
+                                              (data[end] >= 'a' && data[end] <= 'z'))) {
+                    end++;
+                }
+                assert(end < data.size());
+                Control(data.substr(i + 2, end - i - 2), data[end]);
+                i = end + 1;
+                continue;
+            }
+
+            unsigned char lead = (unsigned char)data[i];
+            size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : 3;
+            assert(column < columns && row < rows);
+            TerminalCanvas::Cell& cell = cells[(size_t)row * columns + column];
+            memset(cell.glyph, 0, sizeof(cell.glyph));
+            memcpy(cell.glyph, data.data() + i, length);
+            cell.fg = fg;
+            cell.bg = bg;
+            column++;
+            i += length;
+        }
+    }
+
+    const TerminalCanvas::Cell& At(int c, int r) const { return cells[(size_t)r * columns + c]; }
+
+private:
+    void ClearScreen() {
+        for (TerminalCanvas::Cell& cell : cells) {
+            strcpy(cell.glyph, " ");
+            cell.fg = DASHBOARD_COLOR_DEFAULT;
+            cell.bg = DASHBOARD_COLOR_DEFAULT;
+        }
+    }
+
+    void Control(const std::string& params, char command) {
+        std::vector<int> values;
+        const char* p = params.c_str();
+        while (*p) {
+            values.push_back((int)strtol(p, const_cast<char**>(&p), 10));
+            if (*p == ';') {
+                p++;
+            }
+        }
+
+        switch (command) {
+            case 'H':
+                row = values.size() > 0 ? values[0] - 1 : 0;
+                column = values.size() > 1 ? values[1] - 1 : 0;
+                break;
+            case 'C':
+                column += values.empty() ? 1 : values[0];
+                break;
+            case 'J':
+                ClearScreen();
+                break;
+            case 'm':
+                for (size_t i = 0; i < values.size(); i++) {
+                    if (values[i] == 0) {
+                        fg = bg = DASHBOARD_COLOR_DEFAULT;
+                    } else if (values[i] == 39) {
+                        fg = DASHBOARD_COLOR_DEFAULT;
+                    } else if (values[i] == 49) {
+                        bg = DASHBOARD_COLOR_DEFAULT;
+                    } else if (values[i] == 38 && i + 2 < values.size()) {
+                        fg = (uint16_t)values[i + 2];
+                        i += 2;
+                    } else if (values[i] == 48 && i + 2 < values.size()) {
+                        bg = (uint16_t)values[i + 2];
+                        i += 2;
+                    }
+                }
+                break;
+            default:
+                assert(!"unexpected control sequence");
+        }
+    }
+
+    int columns;
+    int rows;
+    std::vector<TerminalCanvas::Cell> cells;
+    int column;
+    int row;
+    uint16_t fg;
+    uint16_t bg;
+};
+
+static void AssertSameScreen(const TerminalCanvas& canvas, const MiniTerminal& terminal)
+{
+    for (int r = 0; r < canvas.Rows(); r++) {
+        for (int c = 0; c < canvas.Columns(); c++) {
+            assert(canvas.At(c, r) == terminal.At(c, r));
+        }
+    }
+}
+
+static size_t CountOccurrences(const std::string& text, const char* needle)
+{
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void test_canvas_diff()
+{
+    printf("Testing diffed canvas rendering...\n");
+
+    TerminalCanvas canvas(20, 5);
+    MiniTerminal terminal(20, 5);
+
+    canvas.Clear();
+    canvas.Text(0, 0, "hello", 10);
+    canvas.Put(5, 2, "\xe2\x96\x88", 12, 200);
+    canvas.Text(18, 4, "ab");
+
+    std::string out;
+    size_t cells = canvas.Render(out);
+    assert(cells == 8);
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    // Same content: nothing at all to send
+    out.clear();
+    canvas.Clear();
+    canvas.Text(0, 0, "hello", 10);
+    canvas.Put(5, 2, "\xe2\x96\x88", 12, 200);
+    canvas.Text(18, 4, "ab");
+    assert(canvas.Render(out) == 0);
+    assert(out.empty());
+
+    // One changed cell: one cursor move, one color change, one glyph
+    canvas.Clear();
+    canvas.Text(0, 0, "hallo", 10);
+    canvas.Put(5, 2, "\xe2\x96\x88", 12, 200);
+    canvas.Text(18, 4, "ab");
+    out.clear();
+    assert(canvas.Render(out) == 1);
+    assert(out == "\x1b[1;2H\x1b[38;5;10ma");
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    // Changes on one row with gaps use relative moves, colors only when they change
+    canvas.Clear();
+    canvas.Text(0, 0, "HALLO", 10);
+    canvas.Put(5, 2, "\xe2\x96\x88", 12, 200);
+    canvas.Text(18, 4, "ab");
+    out.clear();
+    canvas.Render(out);
+    assert(CountOccurrences(out, "H") == 2);   // One CUP plus the glyph itself
+    assert(CountOccurrences(out, "m") == 0);   // Color already current
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    // Cleared cells go back to default colors
+    canvas.Clear();
+    out.clear();
+    canvas.Render(out);
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    // Text and cells outside the canvas are clipped
+    canvas.Text(18, 1, "clipped");
+    canvas.Put(-1, 0, "x", 1, 1);
+    canvas.Put(0, 9, "x", 1, 1);
+    out.clear();
+    assert(canvas.Render(out) == 2);
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    // Invalidate repaints from a cleared screen
+    canvas.Invalidate();
+    out.clear();
+    canvas.Render(out);
+    assert(out.compare(0, 8, "\x1b[0m\x1b[2J") == 0);
+    terminal.Feed(out);
+    AssertSameScreen(canvas, terminal);
+
+    printf("✅ Only changed cells are emitted, screen matches the canvas\n");
+}
+
+static DashboardSnapshot MakeSnapshot()
+{
+    DashboardSnapshot snapshot;
+    snapshot.Clear();
+    for (int pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        snapshot.pad_velocity[pad] = (uint8_t)(pad % 8 == 0 ? 0 : pad + 1);
+        snapshot.pad_channel[pad] = 6;
+    }
+    snapshot.pad_pressed[9] = true;
+    snapshot.track_led[2] = 1;
+    snapshot.scene_led[5] = 2;
+    for (int i = 0; i < APC_MINI_TOTAL_FADER_COUNT; i++) {
+        snapshot.faders[i] = (uint8_t)(i * 15);
+    }
+    snapshot.latency_p50_us = 1200;
+    snapshot.latency_p99_us = 2100;
+    snapshot.rx_per_sec = 950;
+    snprintf(snapshot.source, sizeof(snapshot.source), "simulated-mk2");
+    snprintf(snapshot.status, sizeof(snapshot.status), "test");
+    return snapshot;
+}
+
+void test_dashboard_frames()
+{
+    printf("Testing dashboard frames through a pipe...\n");
+
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+
+    TerminalDashboard dashboard(pipe_fds[1]);
+    dashboard.SetFixedSize(80, 24);
+
+    DashboardSnapshot snapshot = MakeSnapshot();
+    size_t first = dashboard.RenderFrame(snapshot);
+    assert(first > 0);
+
+    char buffer[65536];
+    ssize_t received = read(pipe_fds[0], buffer, sizeof(buffer));
+    assert(received == (ssize_t)first);
+
+    // The frame replays to the same screen the canvas holds
+    MiniTerminal terminal(80, 24);
+    terminal.Feed(std::string(buffer, (size_t)received));
+    assert(strcmp(terminal.At(1, 0).glyph, "A") == 0);      // Title
+    assert(strcmp(terminal.At(6, 13).glyph, "\xe2\x96\x88") != 0);  // Fader 1 at 0
+
+    // Unchanged state: no write at all
+    assert(dashboard.RenderFrame(snapshot) == 0);
+    assert(read(pipe_fds[0], buffer, sizeof(buffer)) < 0);
+
+    // One fader step: a few cells, far smaller than a repaint
+    snapshot.faders[0] = 30;
+    size_t delta = dashboard.RenderFrame(snapshot);
+    assert(delta > 0 && delta < first / 10);
+    received = read(pipe_fds[0], buffer, sizeof(buffer));
+    assert(received == (ssize_t)delta);
+    terminal.Feed(std::string(buffer, (size_t)received));
+    assert(strcmp(terminal.At(6, 13).glyph, "\xe2\x96\x88") == 0);
+
+    DashboardStats stats = dashboard.GetStats();
+    assert(stats.frames == 3);
+    assert(stats.frames_written == 2);
+    assert(stats.bytes_written == first + delta);
+    printf("full frame %zu bytes, one fader step %zu bytes\n", first, delta);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    printf("✅ One write per changed frame, none when idle\n");
+}
+
+void test_palette_mapping()
+{
+    printf("Testing MK2 color mapping...\n");
+
+    APCMiniMK2RGB black = { 0, 0, 0 };
+    APCMiniMK2RGB red = { 0x7F, 0, 0 };
+    APCMiniMK2RGB white = { 0x7F, 0x7F, 0x7F };
+
+    assert(TerminalDashboard::ColorFromMK2(black, 6) == 16);
+    assert(TerminalDashboard::ColorFromMK2(red, 6) == 16 + 36 * 5);
+    assert(TerminalDashboard::ColorFromMK2(white, 6) == 231);
+
+    // Lower brightness channels darken; pulse/blink channels are full brightness
+    assert(TerminalDashboard::ColorFromMK2(red, 0) < TerminalDashboard::ColorFromMK2(red, 6));
+    assert(TerminalDashboard::ColorFromMK2(red, 12) == TerminalDashboard::ColorFromMK2(red, 6));
+
+    printf("✅ Palette maps onto the xterm color cube\n");
+}
+
+int main()
+{
+    printf("🖥️  Terminal Dashboard Test\n");
+    printf("===========================\n\n");
+
+    test_canvas_diff();
+    test_dashboard_frames();
+    test_palette_mapping();
+
+    printf("\n🎉 ALL TESTS PASSED! Dashboard frames are diffed.\n");
+    return 0;
+}
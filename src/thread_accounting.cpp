@@ -0,0 +1,314 @@
+#include "thread_accounting.h"
+#include "metrics_registry.h"
+#include <string.h>
+
+#ifndef __HAIKU__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+thread_local ThreadAccounting::Slot* ThreadAccounting::current_slot = nullptr;
+
+static const char* const METRIC_SUFFIXES[] = {
+    "cpu_us", "blocked_us", "wakeups", "wakeups_per_s"
+};
+
+ThreadAccounting::ThreadAccounting(MetricsRegistry* registry)
+    : metrics(registry)
+{
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        slots[i].in_use = false;
+        slots[i].owner = this;
+    }
+}
+
+ThreadAccounting::~ThreadAccounting()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (slots[i].in_use) {
+            ReleaseSlot(slots[i]);
+        }
+    }
+}
+
+ThreadAccounting& ThreadAccounting::Default()
+{
+    static ThreadAccounting accounting(&MetricsRegistry::Default());
+    return accounting;
+}
+
+bool ThreadAccounting::RegisterCurrentThread(const char* name)
+{
+    if (!name || current_slot) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (!slots[i].in_use) {
+            slot = &slots[i];
+            break;
+        }
+    }
+    if (!slot) {
+        return false;
+    }
+
+    strncpy(slot->name, name, sizeof(slot->name) - 1);
+    slot->name[sizeof(slot->name) - 1] = '\0';
+
+#ifdef __HAIKU__
+    slot->thread = find_thread(NULL);
+#else
+    slot->tid = (pid_t)syscall(SYS_gettid);
+#endif
+
+    OSCounters counters;
+    if (!ReadCounters(*slot, counters)) {
+        memset(&counters, 0, sizeof(counters));
+    }
+
+    slot->in_use = true;
+    slot->registered_at = system_time();
+    slot->cpu_at_register = counters.cpu_us;
+    slot->wait_at_register = counters.wait_us;
+    slot->switches_at_register = counters.switches;
+    slot->last_sample_at = slot->registered_at;
+    slot->last_cpu = 0;
+    slot->last_wakeups = 0;
+    slot->wakeups.store(0, std::memory_order_relaxed);
+
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        slot->metrics[i].store(0, std::memory_order_relaxed);
+        snprintf(slot->metric_names[i], sizeof(slot->metric_names[i]), "thread.%s.%s",
+                 slot->name, METRIC_SUFFIXES[i]);
+        if (metrics) {
+            metrics->RegisterCounter(slot->metric_names[i], &slot->metrics[i]);
+        }
+    }
+
+    current_slot = slot;
+    return true;
+}
+
+void ThreadAccounting::UnregisterCurrentThread()
+{
+    if (!current_slot || current_slot->owner != this) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    ReleaseSlot(*current_slot);
+    current_slot = nullptr;
+}
+
+void ThreadAccounting::ReleaseSlot(Slot& slot)
+{
+    // Called with lock held
+    if (metrics) {
+        for (int i = 0; i < METRIC_COUNT; i++) {
+            metrics->Unregister(&slot.metrics[i]);
+        }
+    }
+    slot.in_use = false;
+}
+
+void ThreadAccounting::NoteWakeup()
+{
+    Slot* slot = current_slot;
+    if (slot) {
+        slot->wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t ThreadAccounting::Sample(ThreadUsage* usage, size_t max_usage)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    bigtime_t now = system_time();
+    size_t written = 0;
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (!slots[i].in_use) {
+            continue;
+        }
+
+        ThreadUsage sample;
+        SampleSlot(slots[i], now, sample);
+        if (usage && written < max_usage) {
+            usage[written++] = sample;
+        }
+    }
+    return written;
+}
+
+bool ThreadAccounting::Find(const char* name, ThreadUsage& usage)
+{
+    ThreadUsage all[MAX_THREADS];
+    size_t count = Sample(all, MAX_THREADS);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(all[i].name, name) == 0) {
+            usage = all[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ThreadAccounting::ThreadCount() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = 0;
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (slots[i].in_use) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void ThreadAccounting::Print(FILE* out)
+{
+    ThreadUsage all[MAX_THREADS];
+    size_t count = Sample(all, MAX_THREADS);
+    Print(out, all, count);
+}
+
+void ThreadAccounting::Print(FILE* out, const ThreadUsage* all, size_t count)
+{
+    fprintf(out, "%-20s %10s %7s %12s %10s %10s\n",
+            "Thread", "CPU ms", "CPU %", "Blocked ms", "Wakeups", "Wakeups/s");
+    for (size_t i = 0; i < count; i++) {
+        const ThreadUsage& usage = all[i];
+        fprintf(out, "%-20s %10.1f %7.2f %12.1f %10llu %10.1f%s\n",
+                usage.name, usage.cpu_us / 1000.0, usage.cpu_percent,
+                usage.blocked_us / 1000.0, (unsigned long long)usage.wakeups,
+                usage.wakeups_per_sec, usage.alive ? "" : "  (exited)");
+    }
+}
+
+void ThreadAccounting::SampleSlot(Slot& slot, bigtime_t now, ThreadUsage& usage)
+{
+    // Called with lock held
+    memset(&usage, 0, sizeof(usage));
+    memcpy(usage.name, slot.name, sizeof(usage.name));
+
+    OSCounters counters;
+    usage.alive = ReadCounters(slot, counters);
+
+    usage.lifetime_us = now - slot.registered_at;
+    usage.wakeups = slot.wakeups.load(std::memory_order_relaxed);
+
+    if (usage.alive) {
+        usage.cpu_us = counters.cpu_us - slot.cpu_at_register;
+        usage.context_switches = counters.switches - slot.switches_at_register;
+        bigtime_t waited = counters.wait_us - slot.wait_at_register;
+        usage.blocked_us = usage.lifetime_us - usage.cpu_us - waited;
+        if (usage.blocked_us < 0) {
+            usage.blocked_us = 0;
+        }
+    } else {
+        usage.cpu_us = slot.last_cpu;
+    }
+
+    bigtime_t interval = now - slot.last_sample_at;
+    if (interval > 0) {
+        usage.wakeups_per_sec = (usage.wakeups - slot.last_wakeups) * 1000000.0 / interval;
+        usage.cpu_percent = (usage.cpu_us - slot.last_cpu) * 100.0 / interval;
+        if (usage.cpu_percent < 0) {
+            usage.cpu_percent = 0;
+        }
+    }
+
+    slot.last_sample_at = now;
+    slot.last_cpu = usage.cpu_us;
+    slot.last_wakeups = usage.wakeups;
+
+    slot.metrics[METRIC_CPU].store((uint64_t)usage.cpu_us, std::memory_order_relaxed);
+    slot.metrics[METRIC_BLOCKED].store((uint64_t)usage.blocked_us, std::memory_order_relaxed);
+    slot.metrics[METRIC_WAKEUPS].store(usage.wakeups, std::memory_order_relaxed);
+    slot.metrics[METRIC_WAKEUP_RATE].store((uint64_t)(usage.wakeups_per_sec + 0.5),
+                                           std::memory_order_relaxed);
+}
+
+#ifdef __HAIKU__
+
+bool ThreadAccounting::ReadCounters(const Slot& slot, OSCounters& counters) const
+{
+    memset(&counters, 0, sizeof(counters));
+
+    thread_info info;
+    if (get_thread_info(slot.thread, &info) != B_OK) {
+        return false;
+    }
+
+    // thread_info has no run queue wait or switch counts
+    counters.cpu_us = info.user_time + info.kernel_time;
+    return true;
+}
+
+#else
+
+bool ThreadAccounting::ReadCounters(const Slot& slot, OSCounters& counters) const
+{
+    memset(&counters, 0, sizeof(counters));
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)slot.tid);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    // Fields 14 and 15 (utime, stime) follow the parenthesised command name,
+    // which may itself contain spaces
+    char line[1024];
+    bool parsed = false;
+    if (fgets(line, sizeof(line), file)) {
+        const char* rest = strrchr(line, ')');
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        if (rest && sscanf(rest + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                           &utime, &stime) == 2) {
+            long ticks = sysconf(_SC_CLK_TCK);
+            counters.cpu_us = (bigtime_t)((utime + stime) * 1000000ULL / (ticks > 0 ? ticks : 100));
+            parsed = true;
+        }
+    }
+    fclose(file);
+    if (!parsed) {
+        return false;
+    }
+
+    // Nanosecond run time and run queue wait, when schedstats are enabled
+    snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", (int)slot.tid);
+    file = fopen(path, "r");
+    if (file) {
+        unsigned long long run_ns = 0;
+        unsigned long long wait_ns = 0;
+        if (fscanf(file, "%llu %llu", &run_ns, &wait_ns) == 2) {
+            counters.cpu_us = (bigtime_t)(run_ns / 1000);
+            counters.wait_us = (bigtime_t)(wait_ns / 1000);
+        }
+        fclose(file);
+    }
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int)slot.tid);
+    file = fopen(path, "r");
+    if (file) {
+        while (fgets(line, sizeof(line), file)) {
+            unsigned long long switches = 0;
+            if (sscanf(line, "voluntary_ctxt_switches: %llu", &switches) == 1) {
+                counters.switches = switches;
+                break;
+            }
+        }
+        fclose(file);
+    }
+
+    return true;
+}
+
+#endif // __HAIKU__
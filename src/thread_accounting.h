@@ -0,0 +1,159 @@
+#ifndef THREAD_ACCOUNTING_H
+#define THREAD_ACCOUNTING_H
+
+/*
+ * Per-Thread CPU Time and Wakeup Accounting
+ *
+ * Several long-running threads sleep on timers (USB reader, event looper,
+ * sync thread, delivery and probe threads). This module reports, per named
+ * thread, how much CPU it used, how often it woke up and how long it was
+ * blocked, so idle cost can be measured instead of guessed:
+ *
+ * - Threads register themselves at the top of their body
+ *   (ScopedThreadAccounting) and call NoteWakeup() after each sleep/wait
+ *   returns. Counting in the loop works on every platform; on Linux the
+ *   kernel's voluntary context switch count is reported next to it.
+ * - CPU time comes from the OS: get_thread_info() on Haiku,
+ *   /proc/self/task/<tid> on Linux.
+ * - Blocked time is wall time since registration minus CPU time minus run
+ *   queue wait (where the OS reports it).
+ * - Sample() refreshes the numbers and publishes them to MetricsRegistry as
+ *   "thread.<name>.cpu_us", ".blocked_us", ".wakeups" and ".wakeups_per_s".
+ *
+ * Registration and Sample() take a lock; NoteWakeup() is one relaxed
+ * atomic increment through a thread-local pointer.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+
+#include "apc_mini_platform.h"
+
+#ifndef __HAIKU__
+#include <sys/types.h>
+#endif
+
+class MetricsRegistry;
+
+#define THREAD_ACCOUNTING_NAME_LENGTH 32
+
+struct ThreadUsage {
+    char name[THREAD_ACCOUNTING_NAME_LENGTH];
+    bigtime_t lifetime_us;         // Wall time since registration
+    bigtime_t cpu_us;              // User + kernel time since registration
+    bigtime_t blocked_us;          // Neither running nor runnable
+    uint64_t wakeups;              // Counted with NoteWakeup()
+    uint64_t context_switches;     // Voluntary switches from the OS (0 if unknown)
+    double wakeups_per_sec;        // Over the last sampling interval
+    double cpu_percent;            // Over the last sampling interval
+    bool alive;                    // OS still knows the thread
+};
+
+class ThreadAccounting {
+public:
+    static constexpr size_t MAX_THREADS = 12;
+
+    ThreadAccounting(MetricsRegistry* registry = nullptr);
+    ~ThreadAccounting();
+
+    // Process-wide instance, publishing to MetricsRegistry::Default()
+    static ThreadAccounting& Default();
+
+    /**
+     * Start accounting for the calling thread
+     *
+     * @return false if all slots are in use (the thread runs unaccounted)
+     */
+    bool RegisterCurrentThread(const char* name);
+    void UnregisterCurrentThread();
+
+    // Count one wakeup of the calling thread (no-op if it is not registered)
+    static void NoteWakeup();
+
+    /**
+     * Refresh every registered thread from the OS and update the metrics
+     *
+     * @return Number of entries written (at most max_usage)
+     */
+    size_t Sample(ThreadUsage* usage, size_t max_usage);
+
+    // Sample and look up one thread by name
+    bool Find(const char* name, ThreadUsage& usage);
+
+    size_t ThreadCount() const;
+
+    // Sample and print a table; the static form prints an earlier sample
+    void Print(FILE* out);
+    static void Print(FILE* out, const ThreadUsage* usage, size_t count);
+
+private:
+    enum MetricIndex {
+        METRIC_CPU = 0,
+        METRIC_BLOCKED,
+        METRIC_WAKEUPS,
+        METRIC_WAKEUP_RATE,
+        METRIC_COUNT
+    };
+
+    struct Slot {
+        bool in_use;
+        ThreadAccounting* owner;
+        char name[THREAD_ACCOUNTING_NAME_LENGTH];
+        char metric_names[METRIC_COUNT][THREAD_ACCOUNTING_NAME_LENGTH + 24];
+        std::atomic<uint64_t> metrics[METRIC_COUNT];
+        std::atomic<uint64_t> wakeups;
+#ifdef __HAIKU__
+        thread_id thread;
+#else
+        pid_t tid;
+#endif
+        bigtime_t registered_at;
+        bigtime_t cpu_at_register;
+        bigtime_t wait_at_register;
+        uint64_t switches_at_register;
+        // Previous sample, for rates
+        bigtime_t last_sample_at;
+        bigtime_t last_cpu;
+        uint64_t last_wakeups;
+    };
+
+    struct OSCounters {
+        bigtime_t cpu_us;
+        bigtime_t wait_us;             // Runnable but not running
+        uint64_t switches;
+    };
+
+    bool ReadCounters(const Slot& slot, OSCounters& counters) const;
+    void SampleSlot(Slot& slot, bigtime_t now, ThreadUsage& usage);
+    void ReleaseSlot(Slot& slot);
+
+    MetricsRegistry* metrics;
+    mutable std::mutex lock;
+    Slot slots[MAX_THREADS];
+
+    static thread_local Slot* current_slot;
+};
+
+// Registers the calling thread for the lifetime of the object
+class ScopedThreadAccounting {
+public:
+    explicit ScopedThreadAccounting(const char* name,
+                                    ThreadAccounting& accounting = ThreadAccounting::Default())
+        : target(accounting)
+    {
+        target.RegisterCurrentThread(name);
+    }
+
+    ~ScopedThreadAccounting() { target.UnregisterCurrentThread(); }
+
+    ScopedThreadAccounting(const ScopedThreadAccounting&) = delete;
+    ScopedThreadAccounting& operator=(const ScopedThreadAccounting&) = delete;
+
+private:
+    ThreadAccounting& target;
+};
+
+#endif // THREAD_ACCOUNTING_H
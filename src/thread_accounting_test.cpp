@@ -0,0 +1,177 @@
+/*
+ * Thread Accounting Test
+ * CPU time, wakeup counting, blocked time and metrics publication
+ */
+
+#include "thread_accounting.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+// Spin until the calling thread has used cpu_us of CPU time, so the test
+// does not depend on how busy the machine is
+static void BurnCPU(ThreadAccounting& accounting, const char* name, bigtime_t cpu_us)
+{
+    volatile uint64_t sink = 0;
+    bigtime_t give_up = system_time() + 10000000;
+    ThreadUsage usage;
+    do {
+        for (int i = 0; i < 100000; i++) {
+            sink += i;
+        }
+    } while (accounting.Find(name, usage) && usage.cpu_us < cpu_us && system_time() < give_up);
+}
+
+void test_register_and_metrics()
+{
+    printf("Testing registration and metric names...\n");
+
+    MetricsRegistry registry;
+    ThreadAccounting accounting(&registry);
+
+    {
+        ScopedThreadAccounting scope("main_test", accounting);
+        assert(accounting.ThreadCount() == 1);
+
+        // A thread registers once
+        assert(!accounting.RegisterCurrentThread("again"));
+
+        ThreadAccounting::NoteWakeup();
+        ThreadAccounting::NoteWakeup();
+
+        ThreadUsage usage;
+        assert(accounting.Find("main_test", usage));
+        assert(usage.alive && usage.wakeups == 2);
+
+        MetricSample sample;
+        assert(registry.Find("thread.main_test.wakeups", sample) && sample.value == 2);
+        assert(registry.Find("thread.main_test.cpu_us", sample));
+        assert(registry.Find("thread.main_test.blocked_us", sample));
+        assert(registry.Find("thread.main_test.wakeups_per_s", sample));
+    }
+
+    assert(accounting.ThreadCount() == 0);
+    MetricSample sample;
+    assert(!registry.Find("thread.main_test.wakeups", sample));
+
+    // Unregistered threads are ignored
+    ThreadAccounting::NoteWakeup();
+
+    printf("✅ Threads publish thread.<name>.* while registered\n");
+}
+
+void test_busy_and_sleeping_threads()
+{
+    printf("Testing busy vs sleeping thread...\n");
+
+    MetricsRegistry registry;
+    ThreadAccounting accounting(&registry);
+    std::atomic<int> ready(0);
+    std::atomic<bool> release(false);
+
+    std::thread busy([&]() {
+        ScopedThreadAccounting scope("busy", accounting);
+        ready.fetch_add(1);
+        BurnCPU(accounting, "busy", 150000);
+        ready.fetch_add(1);
+        while (!release.load()) {
+            snooze(1000);
+        }
+    });
+
+    std::thread sleeper([&]() {
+        ScopedThreadAccounting scope("sleeper", accounting);
+        ready.fetch_add(1);
+        for (int i = 0; i < 20; i++) {
+            snooze(10000);
+            ThreadAccounting::NoteWakeup();
+        }
+        ready.fetch_add(1);
+        while (!release.load()) {
+            snooze(1000);
+        }
+    });
+
+    // Each thread bumps ready once registered and once done
+    while (ready.load() < 4) {
+        snooze(1000);
+    }
+
+    ThreadUsage busy_usage;
+    ThreadUsage sleeper_usage;
+    assert(accounting.Find("busy", busy_usage));
+    assert(accounting.Find("sleeper", sleeper_usage));
+
+    printf("busy: cpu %.1f ms, blocked %.1f ms\n", busy_usage.cpu_us / 1000.0,
+           busy_usage.blocked_us / 1000.0);
+    printf("sleeper: cpu %.1f ms, blocked %.1f ms, wakeups %llu\n", sleeper_usage.cpu_us / 1000.0,
+           sleeper_usage.blocked_us / 1000.0, (unsigned long long)sleeper_usage.wakeups);
+
+    // Generous bounds: CPU time granularity can be a 10 ms tick
+    assert(busy_usage.cpu_us >= 100000);
+    assert(sleeper_usage.cpu_us < busy_usage.cpu_us);
+    assert(sleeper_usage.wakeups == 20);
+    assert(sleeper_usage.blocked_us >= 100000);
+    assert(sleeper_usage.blocked_us <= sleeper_usage.lifetime_us);
+
+    release.store(true);
+    busy.join();
+    sleeper.join();
+    assert(accounting.ThreadCount() == 0);
+
+    printf("✅ CPU time and wakeups separate busy from sleeping threads\n");
+}
+
+void test_slot_limit()
+{
+    printf("Testing slot limit...\n");
+
+    ThreadAccounting accounting;
+    std::atomic<int> registered(0);
+    std::atomic<bool> release(false);
+    std::thread threads[ThreadAccounting::MAX_THREADS + 2];
+
+    for (size_t i = 0; i < ThreadAccounting::MAX_THREADS + 2; i++) {
+        threads[i] = std::thread([&, i]() {
+            char name[16];
+            snprintf(name, sizeof(name), "worker%zu", i);
+            if (accounting.RegisterCurrentThread(name)) {
+                registered.fetch_add(1);
+            }
+            while (!release.load()) {
+                snooze(1000);
+            }
+            accounting.UnregisterCurrentThread();
+        });
+    }
+
+    while (accounting.ThreadCount() < ThreadAccounting::MAX_THREADS) {
+        snooze(1000);
+    }
+    snooze(20000);
+
+    assert(registered.load() == (int)ThreadAccounting::MAX_THREADS);
+    release.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(accounting.ThreadCount() == 0);
+
+    printf("✅ Extra threads run unaccounted\n");
+}
+
+int main()
+{
+    printf("⏱️  Thread Accounting Test\n");
+    printf("==========================\n\n");
+
+    test_register_and_metrics();
+    test_busy_and_sleeping_threads();
+    test_slot_limit();
+
+    printf("\n🎉 ALL TESTS PASSED! Per-thread usage is accounted.\n");
+    return 0;
+}
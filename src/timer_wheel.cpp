@@ -0,0 +1,113 @@
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(bigtime_t tick, bigtime_t start_time)
+    : origin(start_time)
+    , tick_us(tick > 0 ? tick : DEFAULT_TICK_US)
+    , current_tick(0)
+    , armed_count(0)
+{
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        slots[i].next = &slots[i];
+        slots[i].prev = &slots[i];
+    }
+}
+
+void TimerWheel::Arm(WheelTimer* timer, bigtime_t deadline)
+{
+    if (timer->armed) {
+        Unlink(timer);
+    } else {
+        armed_count++;
+    }
+
+    // Round up: a timer never fires before its deadline
+    uint64_t tick = 0;
+    if (deadline > origin) {
+        tick = (uint64_t)((deadline - origin + tick_us - 1) / tick_us);
+    }
+    if (tick <= current_tick) {
+        tick = current_tick + 1;
+    }
+
+    timer->expires_tick = tick;
+    timer->armed = true;
+    Link(&slots[tick & SLOT_MASK], timer);
+}
+
+void TimerWheel::Cancel(WheelTimer* timer)
+{
+    if (!timer->armed) {
+        return;
+    }
+
+    Unlink(timer);
+    timer->armed = false;
+    armed_count--;
+}
+
+size_t TimerWheel::Advance(bigtime_t now, ExpiryHandler handler, void* context)
+{
+    if (now < origin) {
+        return 0;
+    }
+
+    uint64_t target_tick = (uint64_t)((now - origin) / tick_us);
+    if (armed_count == 0) {
+        // Nothing can fire; skip idle time in one step
+        if (target_tick > current_tick) {
+            current_tick = target_tick;
+        }
+        return 0;
+    }
+
+    size_t fired = 0;
+    WheelTimer due;
+
+    while (current_tick < target_tick && armed_count > 0) {
+        current_tick++;
+        WheelTimer* head = &slots[current_tick & SLOT_MASK];
+
+        // Collect first so handlers can re-arm into this slot safely
+        due.next = &due;
+        due.prev = &due;
+        WheelTimer* timer = head->next;
+        while (timer != head) {
+            WheelTimer* next = timer->next;
+            if (timer->expires_tick <= current_tick) {
+                Unlink(timer);
+                Link(&due, timer);
+            }
+            timer = next;
+        }
+
+        while (due.next != &due) {
+            WheelTimer* expired = due.next;
+            Unlink(expired);
+            expired->armed = false;
+            armed_count--;
+            fired++;
+            handler(expired, context);
+        }
+    }
+
+    if (target_tick > current_tick) {
+        current_tick = target_tick;
+    }
+    return fired;
+}
+
+void TimerWheel::Link(WheelTimer* head, WheelTimer* timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+void TimerWheel::Unlink(WheelTimer* timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = nullptr;
+    timer->prev = nullptr;
+}
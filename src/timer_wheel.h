@@ -0,0 +1,78 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/*
+ * Hashed Timer Wheel
+ *
+ * Many short timers (long-press thresholds, double-tap windows) armed and
+ * cancelled far more often than they fire. Instead of one BMessageRunner or
+ * thread per pending timer, a single owner thread advances the wheel from
+ * its existing poll loop:
+ *
+ * - Timers are intrusive (WheelTimer lives in the caller's state), so
+ *   Arm() and Cancel() are O(1) list splices and never allocate
+ * - SLOT_COUNT slots of one tick each; deadlines further out than one turn
+ *   stay in their slot until the wheel comes around to their tick
+ * - Advance() fires every timer whose tick has passed, in tick order
+ *
+ * Not thread-safe: arm, cancel and advance from one thread. Handlers may
+ * arm or cancel any timer, including the one that is firing.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apc_mini_platform.h"
+
+struct WheelTimer {
+    WheelTimer* next;
+    WheelTimer* prev;
+    uint64_t expires_tick;
+    uint32_t cookie;          // Free for the owner (e.g. control index)
+    bool armed;
+
+    WheelTimer() : next(nullptr), prev(nullptr), expires_tick(0), cookie(0), armed(false) {}
+
+    bool IsArmed() const { return armed; }
+};
+
+class TimerWheel {
+public:
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOT_COUNT = 1 << SLOT_BITS;   // 256 ticks per turn
+    static constexpr size_t SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr bigtime_t DEFAULT_TICK_US = 1000;     // Matches the 1 ms looper poll
+
+    typedef void (*ExpiryHandler)(WheelTimer* timer, void* context);
+
+    TimerWheel(bigtime_t tick_us = DEFAULT_TICK_US, bigtime_t start_time = system_time());
+
+    // Fire at the first tick at or after deadline (re-arming moves the timer)
+    void Arm(WheelTimer* timer, bigtime_t deadline);
+    void Cancel(WheelTimer* timer);
+
+    /**
+     * Fire all timers due by now
+     *
+     * @return Number of timers fired
+     */
+    size_t Advance(bigtime_t now, ExpiryHandler handler, void* context);
+
+    size_t ArmedCount() const { return armed_count; }
+    bigtime_t TickUs() const { return tick_us; }
+
+private:
+    static void Link(WheelTimer* head, WheelTimer* timer);
+    static void Unlink(WheelTimer* timer);
+
+    WheelTimer slots[SLOT_COUNT];   // List heads (circular, sentinel)
+    bigtime_t origin;
+    bigtime_t tick_us;
+    uint64_t current_tick;          // Last tick processed
+    size_t armed_count;
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,490 @@
+#include "transfer_batcher.h"
+#include "midi_transport.h"
+#include "metrics_registry.h"
+#include "thread_accounting.h"
+#include <string.h>
+#include <chrono>
+
+// A setting keeps up if its backlog stays within a couple of batches or it
+// delivered nearly everything offered during the epoch
+#define KEEP_UP_DELIVERED_RATIO  0.95
+#define KEEP_UP_BACKLOG_BATCHES  2
+
+// Epochs without enough traffic are dropped after this many epoch lengths
+#define IDLE_EPOCH_FACTOR        10
+
+// ===============================
+// BatchAutotuner
+// ===============================
+
+BatchAutotuner::BatchAutotuner(const BatchTunerConfig& tuner_config, MetricsRegistry* metrics_registry)
+    : config(tuner_config)
+    , registry(metrics_registry)
+    , have_best(false)
+    , converged(false)
+    , fixed(false)
+    , neighbour_count(0)
+    , next_neighbour(0)
+    , converged_epochs(0)
+    , epoch_start(0)
+    , epoch_offered(0)
+    , epoch_delivered(0)
+    , epoch_transfers(0)
+    , epoch_latency_sum(0)
+    , epochs(0)
+    , setting_changes(0)
+    , published_batch(0)
+    , published_flush(0)
+    , published_converged(0)
+    , published_throughput(0)
+    , published_latency(0)
+{
+    if (config.min_batch < 1) {
+        config.min_batch = 1;
+    }
+    if (config.max_batch < config.min_batch) {
+        config.max_batch = config.min_batch;
+    }
+    if (config.min_flush_us < 1) {
+        config.min_flush_us = 1;
+    }
+    if (config.max_flush_us < config.min_flush_us) {
+        config.max_flush_us = config.min_flush_us;
+    }
+
+    // Start near the geometric middle of the bounds
+    BatchSetting start;
+    start.batch_size = config.min_batch;
+    while ((uint32_t)start.batch_size * 2 * start.batch_size * 2 <=
+           (uint32_t)config.min_batch * config.max_batch) {
+        start.batch_size *= 2;
+    }
+    start.flush_interval_us = config.min_flush_us;
+    while (start.flush_interval_us * 2 * start.flush_interval_us * 2 <=
+           config.min_flush_us * config.max_flush_us) {
+        start.flush_interval_us *= 2;
+    }
+    current = Clamp(start);
+
+    memset(&best, 0, sizeof(best));
+    best.setting = current;
+
+    if (registry) {
+        registry->RegisterCounter("batcher.batch_size", &published_batch);
+        registry->RegisterCounter("batcher.flush_interval_us", &published_flush);
+        registry->RegisterCounter("batcher.tuner_converged", &published_converged);
+        registry->RegisterCounter("batcher.tuner_epochs", &epochs);
+        registry->RegisterCounter("batcher.tuner_changes", &setting_changes);
+        registry->RegisterCounter("batcher.throughput_mps", &published_throughput);
+        registry->RegisterCounter("batcher.latency_us", &published_latency);
+    }
+    Publish();
+}
+
+BatchAutotuner::~BatchAutotuner()
+{
+    if (registry) {
+        registry->Unregister(&published_batch);
+        registry->Unregister(&published_flush);
+        registry->Unregister(&published_converged);
+        registry->Unregister(&epochs);
+        registry->Unregister(&setting_changes);
+        registry->Unregister(&published_throughput);
+        registry->Unregister(&published_latency);
+    }
+}
+
+void BatchAutotuner::Begin(bigtime_t now)
+{
+    epoch_start = now;
+    epoch_offered = 0;
+    epoch_delivered = 0;
+    epoch_transfers = 0;
+    epoch_latency_sum = 0;
+}
+
+void BatchAutotuner::RecordTransfer(size_t messages, bigtime_t latency_sum_us)
+{
+    epoch_delivered += messages;
+    epoch_transfers++;
+    epoch_latency_sum += (double)latency_sum_us;
+}
+
+bool BatchAutotuner::EndEpochIfDue(bigtime_t now, size_t backlog)
+{
+    bigtime_t elapsed = now - epoch_start;
+    if (elapsed < config.epoch_us) {
+        return false;
+    }
+    if (epoch_offered < config.epoch_min_messages && epoch_delivered < config.epoch_min_messages) {
+        // Too little traffic to judge; start over after a long idle spell
+        if (elapsed >= config.epoch_us * IDLE_EPOCH_FACTOR) {
+            Begin(now);
+        }
+        return false;
+    }
+
+    BatchEpochResult result;
+    result.setting = current;
+    result.offered = epoch_offered;
+    result.delivered = epoch_delivered;
+    result.transfers = epoch_transfers;
+    result.throughput_mps = epoch_delivered * 1000000.0 / elapsed;
+    result.mean_latency_us = epoch_delivered > 0 ? epoch_latency_sum / epoch_delivered : 1e12;
+    result.keeps_up = backlog <= (size_t)current.batch_size * KEEP_UP_BACKLOG_BATCHES ||
+                      epoch_delivered >= epoch_offered * KEEP_UP_DELIVERED_RATIO;
+
+    epochs.fetch_add(1, std::memory_order_relaxed);
+    published_throughput.store((uint64_t)(result.throughput_mps + 0.5), std::memory_order_relaxed);
+    published_latency.store((uint64_t)(result.mean_latency_us + 0.5), std::memory_order_relaxed);
+    Begin(now);
+
+    if (fixed) {
+        best = result;
+        return false;
+    }
+
+    BatchSetting previous = current;
+
+    if (!have_best) {
+        // First measurement is the reference for the search
+        best = result;
+        have_best = true;
+        StartSearch();
+        if (!NextCandidate()) {
+            converged = true;
+        }
+    } else if (!converged) {
+        if (IsBetter(result, best)) {
+            best = result;
+            StartSearch();
+        }
+        if (!NextCandidate()) {
+            converged = true;
+            converged_epochs = 0;
+            current = best.setting;
+        }
+    } else {
+        // Converged: keep re-measuring the chosen setting
+        best = result;
+        converged_epochs++;
+        if (!result.keeps_up || converged_epochs >= config.retune_epochs) {
+            converged = false;
+            StartSearch();
+            if (!NextCandidate()) {
+                converged = true;
+            }
+            converged_epochs = 0;
+        }
+    }
+
+    bool changed = current != previous;
+    if (changed) {
+        setting_changes.fetch_add(1, std::memory_order_relaxed);
+    }
+    Publish();
+    return changed;
+}
+
+void BatchAutotuner::SetFixed(const BatchSetting& setting)
+{
+    fixed = true;
+    converged = false;
+    have_best = false;
+    current = Clamp(setting);
+    Publish();
+}
+
+void BatchAutotuner::Resume()
+{
+    fixed = false;
+    converged = false;
+    have_best = false;
+    Publish();
+}
+
+BatchSetting BatchAutotuner::Clamp(const BatchSetting& setting) const
+{
+    BatchSetting clamped = setting;
+    if (clamped.batch_size < config.min_batch) {
+        clamped.batch_size = config.min_batch;
+    }
+    if (clamped.batch_size > config.max_batch) {
+        clamped.batch_size = config.max_batch;
+    }
+    if (clamped.flush_interval_us < config.min_flush_us) {
+        clamped.flush_interval_us = config.min_flush_us;
+    }
+    if (clamped.flush_interval_us > config.max_flush_us) {
+        clamped.flush_interval_us = config.max_flush_us;
+    }
+    return clamped;
+}
+
+bool BatchAutotuner::IsBetter(const BatchEpochResult& candidate, const BatchEpochResult& reference) const
+{
+    // Keeping up with the offered load beats any latency
+    if (candidate.keeps_up != reference.keeps_up) {
+        return candidate.keeps_up;
+    }
+    if (!candidate.keeps_up) {
+        return candidate.throughput_mps > reference.throughput_mps * (1.0 + config.min_improvement);
+    }
+    return candidate.mean_latency_us < reference.mean_latency_us * (1.0 - config.min_improvement);
+}
+
+void BatchAutotuner::StartSearch()
+{
+    const BatchSetting& center = best.setting;
+    BatchSetting options[MAX_NEIGHBOURS] = {
+        { (uint16_t)(center.batch_size * 2), center.flush_interval_us },
+        { (uint16_t)(center.batch_size / 2), center.flush_interval_us },
+        { center.batch_size, center.flush_interval_us / 2 },
+        { center.batch_size, center.flush_interval_us * 2 }
+    };
+
+    neighbour_count = 0;
+    next_neighbour = 0;
+    for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+        BatchSetting option = Clamp(options[i]);
+        bool duplicate = option == center;
+        for (int j = 0; j < neighbour_count && !duplicate; j++) {
+            duplicate = neighbours[j] == option;
+        }
+        if (!duplicate) {
+            neighbours[neighbour_count++] = option;
+        }
+    }
+}
+
+bool BatchAutotuner::NextCandidate()
+{
+    if (next_neighbour >= neighbour_count) {
+        return false;
+    }
+    current = neighbours[next_neighbour++];
+    return true;
+}
+
+void BatchAutotuner::Publish()
+{
+    published_batch.store(current.batch_size, std::memory_order_relaxed);
+    published_flush.store((uint64_t)current.flush_interval_us, std::memory_order_relaxed);
+    published_converged.store(converged ? 1 : 0, std::memory_order_relaxed);
+}
+
+// ===============================
+// TransferBatcher
+// ===============================
+
+static BatchTunerConfig LimitBatch(BatchTunerConfig config)
+{
+    if (config.max_batch > TransferBatcher::MAX_BATCH) {
+        config.max_batch = TransferBatcher::MAX_BATCH;
+    }
+    return config;
+}
+
+TransferBatcher::TransferBatcher(MIDITransport* midi_transport, const BatchTunerConfig& config,
+                                 MetricsRegistry* metrics_registry)
+    : transport(midi_transport)
+    , registry(metrics_registry)
+    , tuner(LimitBatch(config), metrics_registry)
+    , setting(tuner.Current())
+    , running(false)
+    , stop_requested(false)
+    , pending_head(0)
+    , pending_count(0)
+    , messages_sent(0)
+    , transfers(0)
+    , send_failures(0)
+    , dropped(0)
+{
+    if (registry) {
+        registry->RegisterCounter("batcher.messages_sent", &messages_sent);
+        registry->RegisterCounter("batcher.transfers", &transfers);
+        registry->RegisterCounter("batcher.send_failures", &send_failures);
+        registry->RegisterCounter("batcher.dropped", &dropped);
+    }
+}
+
+TransferBatcher::~TransferBatcher()
+{
+    Stop();
+    if (registry) {
+        registry->Unregister(&messages_sent);
+        registry->Unregister(&transfers);
+        registry->Unregister(&send_failures);
+        registry->Unregister(&dropped);
+    }
+}
+
+APCMiniError TransferBatcher::Start()
+{
+    if (!transport) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) {
+        return APC_SUCCESS;
+    }
+    running = true;
+    stop_requested = false;
+    tuner.Begin(system_time());
+    flush_thread = std::thread(&TransferBatcher::FlushThreadLoop, this);
+    return APC_SUCCESS;
+}
+
+void TransferBatcher::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) {
+            return;
+        }
+        stop_requested = true;
+    }
+    pending_changed.notify_all();
+
+    if (flush_thread.joinable()) {
+        flush_thread.join();
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    running = false;
+}
+
+APCMiniError TransferBatcher::Send(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!running || stop_requested) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (pending_count == MAX_PENDING) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return APC_ERROR_TIMEOUT;
+    }
+
+    PendingMessage& message = pending[(pending_head + pending_count) % MAX_PENDING];
+    message.bytes[0] = status;
+    message.bytes[1] = data1;
+    message.bytes[2] = data2;
+    message.enqueued_at = system_time();
+    pending_count++;
+    tuner.RecordOffered(1);
+
+    // Wake the flush thread to arm the deadline or send a full batch
+    if (pending_count == 1 || pending_count >= setting.batch_size) {
+        pending_changed.notify_one();
+    }
+    return APC_SUCCESS;
+}
+
+void TransferBatcher::SetFixedSetting(const BatchSetting& fixed_setting)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    tuner.SetFixed(fixed_setting);
+    setting = tuner.Current();
+}
+
+void TransferBatcher::ResumeTuning()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    tuner.Resume();
+    setting = tuner.Current();
+}
+
+BatchSetting TransferBatcher::CurrentSetting() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return setting;
+}
+
+bool TransferBatcher::IsConverged() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return tuner.IsConverged();
+}
+
+BatchEpochResult TransferBatcher::BestResult() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return tuner.Best();
+}
+
+size_t TransferBatcher::Pending() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return pending_count;
+}
+
+TransferBatcherStats TransferBatcher::GetStats() const
+{
+    TransferBatcherStats stats;
+    stats.messages_sent = messages_sent.load();
+    stats.transfers = transfers.load();
+    stats.send_failures = send_failures.load();
+    stats.dropped = dropped.load();
+    return stats;
+}
+
+void TransferBatcher::FlushThreadLoop()
+{
+    ScopedThreadAccounting accounting("batch_flush");
+
+    uint8_t batch[MAX_BATCH][3];
+    bigtime_t enqueued[MAX_BATCH];
+
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        bigtime_t now = system_time();
+        if (tuner.EndEpochIfDue(now, pending_count)) {
+            setting = tuner.Current();
+        }
+
+        if (pending_count == 0) {
+            if (stop_requested) {
+                break;
+            }
+            pending_changed.wait(guard);
+            ThreadAccounting::NoteWakeup();
+            continue;
+        }
+
+        bigtime_t deadline = pending[pending_head].enqueued_at + setting.flush_interval_us;
+        if (pending_count < setting.batch_size && now < deadline && !stop_requested) {
+            pending_changed.wait_for(guard, std::chrono::microseconds(deadline - now));
+            ThreadAccounting::NoteWakeup();
+            continue;
+        }
+
+        size_t count = pending_count < setting.batch_size ? pending_count : setting.batch_size;
+        for (size_t i = 0; i < count; i++) {
+            const PendingMessage& message = pending[(pending_head + i) % MAX_PENDING];
+            memcpy(batch[i], message.bytes, 3);
+            enqueued[i] = message.enqueued_at;
+        }
+        pending_head = (pending_head + count) % MAX_PENDING;
+        pending_count -= count;
+
+        // The transfer blocks until completion; senders keep queueing meanwhile
+        guard.unlock();
+        APCMiniError result = transport->SendMIDIBatch(batch, count);
+        bigtime_t done = system_time();
+        guard.lock();
+
+        if (result != APC_SUCCESS) {
+            send_failures.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        bigtime_t latency_sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            latency_sum += done - enqueued[i];
+        }
+        tuner.RecordTransfer(count, latency_sum);
+        messages_sent.fetch_add(count, std::memory_order_relaxed);
+        transfers.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,221 @@
+#ifndef TRANSFER_BATCHER_H
+#define TRANSFER_BATCHER_H
+
+/*
+ * Outbound Transfer Batcher with Runtime Autotuner
+ *
+ * TransferBatcher collects outbound short messages and hands them to
+ * MIDITransport::SendMIDIBatch() as one transfer when either the batch is
+ * full or the oldest message has waited for the flush interval. Larger
+ * batches amortize the per-transfer cost (submission, hub scheduling, frame
+ * wait); shorter flush intervals bound the latency at low message rates.
+ *
+ * The best pair depends on host controller, hub and load, so BatchAutotuner
+ * searches it online within configured bounds:
+ *
+ *   - every epoch (a minimum time and message count) scores the active
+ *     setting by achieved throughput and mean enqueue-to-completion latency
+ *   - hill climbing: try the neighbours (batch x2 / /2, interval x2 / /2)
+ *     of the best setting, move when one is clearly better, converge when
+ *     none is
+ *   - a setting that cannot keep up with the offered load (backlog grows)
+ *     loses to any that can; among those that keep up, lower latency wins
+ *   - once converged, re-tune periodically or as soon as the setting stops
+ *     keeping up
+ *
+ * The tuner is plain logic driven by timestamps so it can be tested without
+ * threads; its decisions are published as batcher.* metrics.
+ *
+ * Threading: Send() from any thread; one flush thread owned by the batcher
+ * calls the transport.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "apc_mini_platform.h"
+#include "apc_mini_defs.h"
+
+class MIDITransport;
+class MetricsRegistry;
+
+struct BatchSetting {
+    uint16_t batch_size;            // Messages per transfer (flush when reached)
+    bigtime_t flush_interval_us;    // Longest a message waits for its batch
+
+    bool operator==(const BatchSetting& other) const {
+        return batch_size == other.batch_size && flush_interval_us == other.flush_interval_us;
+    }
+    bool operator!=(const BatchSetting& other) const { return !(*this == other); }
+};
+
+struct BatchTunerConfig {
+    uint16_t min_batch;
+    uint16_t max_batch;             // At most TransferBatcher::MAX_BATCH
+    bigtime_t min_flush_us;
+    bigtime_t max_flush_us;
+    bigtime_t epoch_us;             // Minimum epoch length
+    uint32_t epoch_min_messages;    // Epochs with less traffic are extended
+    uint32_t retune_epochs;         // Converged epochs before searching again
+    double min_improvement;         // Relative latency gain needed to move (0.1 = 10%)
+
+    static BatchTunerConfig Defaults() {
+        BatchTunerConfig config;
+        config.min_batch = 1;
+        config.max_batch = 64;
+        config.min_flush_us = 125;
+        config.max_flush_us = 4000;
+        config.epoch_us = 200000;
+        config.epoch_min_messages = 64;
+        config.retune_epochs = 50;
+        config.min_improvement = 0.1;
+        return config;
+    }
+};
+
+// Measurement of one setting over one epoch
+struct BatchEpochResult {
+    BatchSetting setting;
+    uint64_t offered;               // Messages enqueued
+    uint64_t delivered;             // Messages whose transfer completed
+    uint64_t transfers;
+    double throughput_mps;          // Delivered per second
+    double mean_latency_us;         // Enqueue to transfer completion
+    bool keeps_up;                  // Delivered at least ~offered (no growing backlog)
+};
+
+class BatchAutotuner {
+public:
+    BatchAutotuner(const BatchTunerConfig& config = BatchTunerConfig::Defaults(),
+                   MetricsRegistry* registry = nullptr);
+    ~BatchAutotuner();
+
+    BatchSetting Current() const { return current; }
+    bool IsConverged() const { return converged; }
+    const BatchEpochResult& Best() const { return best; }
+    uint64_t EpochCount() const { return epochs.load(std::memory_order_relaxed); }
+
+    // Start measuring at now (call once before recording)
+    void Begin(bigtime_t now);
+
+    void RecordOffered(size_t messages) { epoch_offered += messages; }
+    void RecordTransfer(size_t messages, bigtime_t latency_sum_us);
+
+    /**
+     * Close the epoch if it is long enough and pick the next setting
+     *
+     * @param backlog  messages still waiting in the batcher
+     * @return true if Current() changed
+     */
+    bool EndEpochIfDue(bigtime_t now, size_t backlog);
+
+    // Pin a setting (tuning off) or resume tuning from it
+    void SetFixed(const BatchSetting& setting);
+    void Resume();
+    bool IsFixed() const { return fixed; }
+
+private:
+    enum { MAX_NEIGHBOURS = 4 };
+
+    BatchSetting Clamp(const BatchSetting& setting) const;
+    bool IsBetter(const BatchEpochResult& candidate, const BatchEpochResult& reference) const;
+    void StartSearch();
+    bool NextCandidate();
+    void Publish();
+
+    BatchTunerConfig config;
+    MetricsRegistry* registry;
+
+    BatchSetting current;
+    BatchEpochResult best;          // Best measured setting of the current search
+    bool have_best;
+    bool converged;
+    bool fixed;
+
+    BatchSetting neighbours[MAX_NEIGHBOURS];
+    int neighbour_count;
+    int next_neighbour;
+    uint32_t converged_epochs;
+
+    bigtime_t epoch_start;
+    uint64_t epoch_offered;
+    uint64_t epoch_delivered;
+    uint64_t epoch_transfers;
+    double epoch_latency_sum;
+
+    std::atomic<uint64_t> epochs;
+    std::atomic<uint64_t> setting_changes;
+    std::atomic<uint64_t> published_batch;
+    std::atomic<uint64_t> published_flush;
+    std::atomic<uint64_t> published_converged;
+    std::atomic<uint64_t> published_throughput;
+    std::atomic<uint64_t> published_latency;
+};
+
+struct TransferBatcherStats {
+    uint64_t messages_sent;
+    uint64_t transfers;
+    uint64_t send_failures;
+    uint64_t dropped;               // Send() with the pending buffer full
+};
+
+class TransferBatcher {
+public:
+    static const size_t MAX_BATCH = 128;
+    static const size_t MAX_PENDING = 1024;
+
+    TransferBatcher(MIDITransport* transport,
+                    const BatchTunerConfig& config = BatchTunerConfig::Defaults(),
+                    MetricsRegistry* registry = nullptr);
+    ~TransferBatcher();
+
+    APCMiniError Start();
+    void Stop();                    // Flushes what is pending first
+
+    // Queue one message; APC_ERROR_TIMEOUT if the pending buffer is full
+    APCMiniError Send(uint8_t status, uint8_t data1, uint8_t data2);
+
+    // Disable tuning and use a fixed setting (comparisons, known devices)
+    void SetFixedSetting(const BatchSetting& setting);
+    void ResumeTuning();
+
+    BatchSetting CurrentSetting() const;
+    bool IsConverged() const;
+    BatchEpochResult BestResult() const;
+    size_t Pending() const;
+    TransferBatcherStats GetStats() const;
+
+private:
+    struct PendingMessage {
+        uint8_t bytes[3];
+        bigtime_t enqueued_at;
+    };
+
+    void FlushThreadLoop();
+
+    MIDITransport* transport;
+    MetricsRegistry* registry;
+    BatchAutotuner tuner;           // Guarded by lock
+    BatchSetting setting;           // Copy of tuner.Current() for the flush thread
+
+    mutable std::mutex lock;
+    std::condition_variable pending_changed;
+    std::thread flush_thread;
+    bool running;
+    bool stop_requested;
+
+    PendingMessage pending[MAX_PENDING];   // Ring buffer
+    size_t pending_head;
+    size_t pending_count;
+
+    std::atomic<uint64_t> messages_sent;
+    std::atomic<uint64_t> transfers;
+    std::atomic<uint64_t> send_failures;
+    std::atomic<uint64_t> dropped;
+};
+
+#endif // TRANSFER_BATCHER_H
@@ -0,0 +1,286 @@
+/*
+ * Transfer Batcher Test
+ * Autotuner search on a synthetic cost model, re-tuning when the load
+ * changes, and the batcher against simulated devices with different timing
+ */
+
+#include "transfer_batcher.h"
+#include "midi_transport.h"
+#include "metrics_registry.h"
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+
+#define EPOCH_US 10000
+
+// Synthetic link: latency grows with distance from (best_batch, best_flush)
+// in log2 steps; batches below min_batch cannot keep up with the load
+struct SyntheticLink {
+    int best_batch;
+    bigtime_t best_flush;
+    int min_batch;
+};
+
+static void RunEpoch(BatchAutotuner& tuner, const SyntheticLink& link, bigtime_t& now)
+{
+    BatchSetting setting = tuner.Current();
+    double distance = fabs(log2((double)setting.batch_size / link.best_batch)) +
+                      fabs(log2((double)setting.flush_interval_us / link.best_flush));
+    bigtime_t latency = 1000 + (bigtime_t)(200 * distance);
+    bool keeps_up = setting.batch_size >= link.min_batch;
+
+    const size_t offered = 100;
+    // Saturated links deliver in proportion to the batch size
+    size_t delivered = keeps_up ? offered : offered * setting.batch_size / link.min_batch;
+    tuner.RecordOffered(offered);
+    for (size_t sent = 0; sent < delivered; sent += setting.batch_size) {
+        size_t count = delivered - sent < setting.batch_size ? delivered - sent : setting.batch_size;
+        tuner.RecordTransfer(count, latency * (bigtime_t)count);
+    }
+
+    now += EPOCH_US;
+    tuner.EndEpochIfDue(now, keeps_up ? 0 : offered - delivered);
+}
+
+static BatchTunerConfig TestConfig()
+{
+    BatchTunerConfig config = BatchTunerConfig::Defaults();
+    config.epoch_us = EPOCH_US;
+    config.epoch_min_messages = 16;
+    config.retune_epochs = 1000;
+    config.min_improvement = 0.02;
+    return config;
+}
+
+static int RunUntilConverged(BatchAutotuner& tuner, const SyntheticLink& link, bigtime_t& now)
+{
+    int epochs = 0;
+    while (!tuner.IsConverged() && epochs < 100) {
+        RunEpoch(tuner, link, now);
+        epochs++;
+    }
+    return epochs;
+}
+
+void test_tuner_converges()
+{
+    printf("Testing convergence on a synthetic link...\n");
+
+    MetricsRegistry registry;
+    BatchAutotuner tuner(TestConfig(), &registry);
+    bigtime_t now = 0;
+    tuner.Begin(now);
+
+    // Starts near the middle of the bounds
+    assert(tuner.Current().batch_size == 8);
+    assert(tuner.Current().flush_interval_us == 500);
+
+    // Lowest latency at batch 2 / 250 us, but the load needs batch >= 4
+    SyntheticLink link = { 2, 250, 4 };
+    int epochs = RunUntilConverged(tuner, link, now);
+    assert(tuner.IsConverged());
+    printf("converged after %d epochs on batch %u, flush %lld us\n", epochs,
+           tuner.Current().batch_size, (long long)tuner.Current().flush_interval_us);
+    assert(tuner.Current().batch_size == 4);
+    assert(tuner.Current().flush_interval_us == 250);
+
+    // Decisions are visible as metrics
+    MetricSample sample;
+    assert(registry.Find("batcher.batch_size", sample) && sample.value == 4);
+    assert(registry.Find("batcher.flush_interval_us", sample) && sample.value == 250);
+    assert(registry.Find("batcher.tuner_converged", sample) && sample.value == 1);
+    assert(registry.Find("batcher.tuner_epochs", sample) && sample.value == (uint64_t)epochs);
+    assert(registry.Find("batcher.tuner_changes", sample) && sample.value > 0);
+
+    // Short epochs are not judged
+    uint64_t before = tuner.EpochCount();
+    tuner.RecordOffered(1);
+    assert(!tuner.EndEpochIfDue(now + EPOCH_US, 0));
+    assert(tuner.EpochCount() == before);
+
+    printf("✅ Tuner finds the lowest-latency setting that keeps up\n");
+}
+
+void test_tuner_bounds_and_fixed()
+{
+    printf("Testing bounds and fixed settings...\n");
+
+    BatchTunerConfig config = TestConfig();
+    config.min_batch = 4;
+    config.max_batch = 16;
+    config.min_flush_us = 500;
+    config.max_flush_us = 1000;
+    BatchAutotuner tuner(config);
+    bigtime_t now = 0;
+    tuner.Begin(now);
+
+    // Optimum outside the bounds: settles on the nearest corner
+    SyntheticLink link = { 64, 4000, 1 };
+    RunUntilConverged(tuner, link, now);
+    assert(tuner.IsConverged());
+    assert(tuner.Current().batch_size == 16);
+    assert(tuner.Current().flush_interval_us == 1000);
+
+    // Fixed settings are clamped and never changed by epochs
+    tuner.SetFixed({ 1, 100 });
+    assert(tuner.IsFixed());
+    assert(tuner.Current().batch_size == 4 && tuner.Current().flush_interval_us == 500);
+    for (int i = 0; i < 10; i++) {
+        RunEpoch(tuner, link, now);
+    }
+    assert(tuner.Current().batch_size == 4);
+
+    tuner.Resume();
+    RunUntilConverged(tuner, link, now);
+    assert(tuner.Current().batch_size == 16);
+
+    printf("✅ Search stays within bounds; fixed settings hold\n");
+}
+
+void test_tuner_retunes_on_load_change()
+{
+    printf("Testing re-tuning after a load change...\n");
+
+    BatchAutotuner tuner(TestConfig());
+    bigtime_t now = 0;
+    tuner.Begin(now);
+
+    SyntheticLink light = { 1, 125, 1 };
+    RunUntilConverged(tuner, light, now);
+    assert(tuner.Current().batch_size == 1);
+
+    // Heavier load: batch 1 falls behind, tuner must search again
+    SyntheticLink heavy = { 1, 125, 16 };
+    RunEpoch(tuner, heavy, now);
+    assert(!tuner.IsConverged());
+    RunUntilConverged(tuner, heavy, now);
+    assert(tuner.IsConverged());
+    assert(tuner.Current().batch_size == 16);
+
+    printf("✅ A setting that stops keeping up triggers a new search\n");
+}
+
+// Offer messages at a steady rate for duration_us
+static void Produce(TransferBatcher& batcher, int rate_per_sec, bigtime_t duration_us,
+                    std::atomic<uint64_t>& offered)
+{
+    bigtime_t interval = 1000000 / rate_per_sec;
+    bigtime_t start = system_time();
+    bigtime_t next = start;
+    uint8_t note = 0;
+    while (next - start < duration_us) {
+        snooze_until(next, B_SYSTEM_TIMEBASE);
+        // Several messages per wakeup keep the sleep count reasonable
+        for (int i = 0; i < 4; i++) {
+            if (batcher.Send(MIDI_NOTE_ON | 6, note, 5) == APC_SUCCESS) {
+                offered.fetch_add(1);
+            }
+            note = (note + 1) % APC_MINI_PAD_COUNT;
+        }
+        next += interval * 4;
+    }
+}
+
+static BatchSetting TuneOnDevice(const SimulatedLinkModel& model, int rate_per_sec)
+{
+    SimulatedDeviceTransport device(model);
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    BatchTunerConfig config = BatchTunerConfig::Defaults();
+    config.epoch_us = 30000;
+    config.epoch_min_messages = 32;
+    MetricsRegistry registry;
+    TransferBatcher batcher(&device, config, &registry);
+    assert(batcher.Start() == APC_SUCCESS);
+
+    std::atomic<uint64_t> offered(0);
+    Produce(batcher, rate_per_sec, 1500000, offered);
+    BatchSetting setting = batcher.CurrentSetting();
+    BatchEpochResult best = batcher.BestResult();
+    batcher.Stop();
+
+    // Everything offered went out, in fewer transfers than messages
+    TransferBatcherStats stats = batcher.GetStats();
+    assert(stats.messages_sent == offered.load());
+    assert(stats.send_failures == 0 && stats.dropped == 0);
+    assert(device.GetPacketsReceived() == offered.load());
+    assert(device.GetTransfersReceived() == stats.transfers);
+
+    MetricSample sample;
+    assert(registry.Find("batcher.transfers", sample) && sample.value == stats.transfers);
+    assert(registry.Find("batcher.tuner_epochs", sample) && sample.value > 5);
+
+    printf("   %5d msg/s: batch %3u, flush %5lld us | %llu msgs in %llu transfers | "
+           "best epoch %.0f msg/s, %.0f us mean%s\n",
+           rate_per_sec, setting.batch_size, (long long)setting.flush_interval_us,
+           (unsigned long long)stats.messages_sent, (unsigned long long)stats.transfers,
+           best.throughput_mps, best.mean_latency_us, batcher.IsConverged() ? ", converged" : "");
+
+    device.Close();
+    return setting;
+}
+
+void test_batcher_on_simulated_devices()
+{
+    printf("Testing batcher on simulated devices...\n");
+
+    // Full-speed USB completes at most one transfer per 1 ms frame: at
+    // 6000 msg/s only batches of 8 or more keep up
+    printf("   full-speed USB:\n");
+    BatchSetting full_speed = TuneOnDevice(SimulatedLinkModel::FullSpeedUSB(), 6000);
+    assert(full_speed.batch_size >= 8);
+
+    // High-speed microframes are 8x shorter: small batches suffice
+    printf("   high-speed USB:\n");
+    BatchSetting high_speed = TuneOnDevice(SimulatedLinkModel::HighSpeedUSB(), 6000);
+    assert(high_speed.batch_size >= 1);
+
+    printf("✅ Batcher delivers everything and adapts to each link model\n");
+}
+
+void test_batcher_lifecycle()
+{
+    printf("Testing batcher lifecycle...\n");
+
+    SimulatedDeviceTransport device(SimulatedLinkModel::Instant());
+    device.SetEchoEnabled(false);
+    device.Open();
+
+    TransferBatcher batcher(&device);
+    assert(batcher.Send(0x90, 1, 1) == APC_ERROR_DEVICE_NOT_FOUND);
+    assert(batcher.Start() == APC_SUCCESS);
+
+    // Fixed large batch and long deadline: Stop() still flushes the tail
+    batcher.SetFixedSetting({ 64, 4000 });
+    for (uint8_t i = 0; i < 10; i++) {
+        assert(batcher.Send(0x96, i, 3) == APC_SUCCESS);
+    }
+    batcher.Stop();
+    assert(batcher.Pending() == 0);
+    assert(batcher.GetStats().messages_sent == 10);
+    assert(device.GetLEDVelocity(9) == 3);
+
+    TransferBatcher orphan(nullptr);
+    assert(orphan.Start() == APC_ERROR_DEVICE_NOT_FOUND);
+
+    device.Close();
+    printf("✅ Pending messages are flushed on stop\n");
+}
+
+int main()
+{
+    printf("📦 Transfer Batcher Test\n");
+    printf("========================\n\n");
+
+    test_tuner_converges();
+    test_tuner_bounds_and_fixed();
+    test_tuner_retunes_on_load_change();
+    test_batcher_lifecycle();
+    test_batcher_on_simulated_devices();
+
+    printf("\n🎉 ALL TESTS PASSED! Transfer batching tunes itself.\n");
+    return 0;
+}
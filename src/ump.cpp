@@ -0,0 +1,193 @@
+#include "ump.h"
+
+size_t USBMIDIToUMP(const USBMIDIEventPacket* packets, size_t count, uint8_t cable, uint8_t group,
+                    uint32_t* words, size_t capacity, size_t* consumed)
+{
+    size_t written = 0;
+    size_t index = 0;
+
+    if (packets && words) {
+        for (; index < count; index++) {
+            const USBMIDIEventPacket& packet = packets[index];
+            uint8_t cin = packet.header & 0x0F;
+            uint8_t length = USBMIDICINLength(cin);
+            if ((packet.header >> 4) != (cable & 0x0F) || length == 0) {
+                continue;
+            }
+
+            // CIN 0x5 carrying a status other than F7 is a single-byte system common
+            bool system_common_1 = cin == USB_MIDI_CIN_SYSEX_END_1 &&
+                                   packet.midi[0] >= 0x80 && packet.midi[0] != 0xF7;
+            if (!SysExAssembler::IsSysExCIN(cin) || system_common_1) {
+                if (capacity - written < 1) {
+                    break;
+                }
+                words[written++] = UMPFromMIDI1(group, packet.midi[0], packet.midi[1], packet.midi[2]);
+                continue;
+            }
+
+            if (capacity - written < 2) {
+                break;
+            }
+            bool starts = packet.midi[0] == 0xF0;
+            bool ends = cin != USB_MIDI_CIN_SYSEX_START;
+            uint8_t status = starts ? (ends ? UMP_SYSEX7_COMPLETE : UMP_SYSEX7_START)
+                                    : (ends ? UMP_SYSEX7_END : UMP_SYSEX7_CONTINUE);
+            uint8_t data[UMP_SYSEX7_MAX_BYTES] = {};
+            uint8_t data_length = 0;
+            for (uint8_t i = starts ? 1 : 0; i < length; i++) {
+                if (packet.midi[i] != 0xF7) {
+                    data[data_length++] = packet.midi[i];
+                }
+            }
+            words[written++] = UMPSysEx7Header(group, status, data_length) |
+                               ((uint32_t)data[0] << 8) | data[1];
+            words[written++] = ((uint32_t)data[2] << 24);
+        }
+    }
+
+    if (consumed) {
+        *consumed = index;
+    }
+    return written;
+}
+
+size_t UMPDecodeBytes(const uint32_t* words, size_t count, uint8_t group,
+                      uint8_t* bytes, size_t capacity, size_t* consumed)
+{
+    size_t written = 0;
+    size_t index = 0;
+
+    if (words && bytes) {
+        while (index < count) {
+            const uint32_t* packet = &words[index];
+            size_t packet_words = UMPWordCount(packet[0]);
+            if (count - index < packet_words) {
+                break;
+            }
+
+            if (UMPGroup(packet[0]) == (group & 0x0F)) {
+                if (UMPType(packet[0]) == UMP_TYPE_SYSEX7) {
+                    uint8_t status = UMPSysEx7Status(packet[0]);
+                    uint8_t data_length = UMPSysEx7Count(packet[0]);
+                    bool starts = status == UMP_SYSEX7_COMPLETE || status == UMP_SYSEX7_START;
+                    bool ends = status == UMP_SYSEX7_COMPLETE || status == UMP_SYSEX7_END;
+                    if (capacity - written < (size_t)data_length + starts + ends) {
+                        break;
+                    }
+                    if (starts) {
+                        bytes[written++] = 0xF0;
+                    }
+                    for (uint8_t i = 0; i < data_length; i++) {
+                        bytes[written++] = UMPSysEx7Byte(packet, i);
+                    }
+                    if (ends) {
+                        bytes[written++] = 0xF7;
+                    }
+                } else {
+                    uint8_t length = UMPMIDI1Length(packet[0]);
+                    if (capacity - written < length) {
+                        break;
+                    }
+                    const uint8_t message[3] = { UMPStatus(packet[0]), UMPData1(packet[0]),
+                                                 UMPData2(packet[0]) };
+                    for (uint8_t i = 0; i < length; i++) {
+                        bytes[written++] = message[i];
+                    }
+                }
+            }
+            index += packet_words;
+        }
+    }
+
+    if (consumed) {
+        *consumed = index;
+    }
+    return written;
+}
+
+size_t UMPEncodeSysEx7(uint8_t group, const uint8_t* data, size_t length,
+                       uint32_t* words, size_t capacity)
+{
+    if (!words || (!data && length > 0)) {
+        return 0;
+    }
+    if (length > 0 && data[0] == 0xF0) {
+        data++;
+        length--;
+    }
+    if (length > 0 && data[length - 1] == 0xF7) {
+        length--;
+    }
+
+    size_t packets = length == 0 ? 1 : (length + UMP_SYSEX7_MAX_BYTES - 1) / UMP_SYSEX7_MAX_BYTES;
+    if (capacity < packets * 2) {
+        return 0;
+    }
+
+    for (size_t packet = 0; packet < packets; packet++) {
+        size_t offset = packet * UMP_SYSEX7_MAX_BYTES;
+        uint8_t count = (uint8_t)(length - offset < UMP_SYSEX7_MAX_BYTES
+                                  ? length - offset : UMP_SYSEX7_MAX_BYTES);
+        uint8_t status = packets == 1 ? UMP_SYSEX7_COMPLETE
+                       : packet == 0 ? UMP_SYSEX7_START
+                       : packet == packets - 1 ? UMP_SYSEX7_END : UMP_SYSEX7_CONTINUE;
+
+        uint8_t bytes[UMP_SYSEX7_MAX_BYTES] = {};
+        for (uint8_t i = 0; i < count; i++) {
+            bytes[i] = data[offset + i] & 0x7F;
+        }
+        words[packet * 2] = UMPSysEx7Header(group, status, count) |
+                            ((uint32_t)bytes[0] << 8) | bytes[1];
+        words[packet * 2 + 1] = ((uint32_t)bytes[2] << 24) | ((uint32_t)bytes[3] << 16) |
+                                ((uint32_t)bytes[4] << 8) | bytes[5];
+    }
+    return packets * 2;
+}
+
+void UMPSysEx7Assembler::Append(uint8_t byte)
+{
+    if (length < MAX_SYSEX_LENGTH) {
+        buffer[length++] = byte;
+    } else {
+        overflow = true;
+    }
+}
+
+bool UMPSysEx7Assembler::Feed(const uint32_t words[2])
+{
+    if (UMPType(words[0]) != UMP_TYPE_SYSEX7) {
+        return false;
+    }
+
+    uint8_t status = UMPSysEx7Status(words[0]);
+    if (status == UMP_SYSEX7_COMPLETE || status == UMP_SYSEX7_START) {
+        // A start always begins a fresh message
+        if (in_progress) {
+            dropped_messages++;
+        }
+        Reset();
+        in_progress = true;
+        Append(0xF0);
+    } else if (!in_progress) {
+        return false;               // Continue/end of a message we never saw start
+    }
+
+    uint8_t count = UMPSysEx7Count(words[0]);
+    for (uint8_t i = 0; i < count; i++) {
+        Append(UMPSysEx7Byte(words, i));
+    }
+
+    if (status == UMP_SYSEX7_START || status == UMP_SYSEX7_CONTINUE) {
+        return false;
+    }
+
+    Append(0xF7);
+    in_progress = false;
+    if (overflow) {
+        dropped_messages++;
+        length = 0;
+        return false;
+    }
+    return true;
+}
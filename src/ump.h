@@ -0,0 +1,217 @@
+#ifndef UMP_H
+#define UMP_H
+
+/*
+ * Universal MIDI Packet (UMP) Words
+ *
+ * Helpers for UMP words: fixed-size, naturally aligned packets that can be
+ * moved with memcpy. They are conversions only; the queue, the packed
+ * batch and the pipeline stages still carry MIDIMessage.
+ *
+ *   Type  Words  Carries
+ *   0x0   1      Utility; word 0 is a NOOP (used here for "nothing")
+ *   0x1   1      System common / realtime: group, status, data1, data2
+ *   0x2   1      MIDI 1.0 channel voice:   group, status, data1, data2
+ *   0x3   2      SysEx7: group, status (complete/start/continue/end),
+ *                byte count 0-6, then the data bytes without F0/F7
+ *
+ *   Word layout of types 0x1/0x2:  type:4 | group:4 | status:8 | data1:8 | data2:8
+ *
+ * Inside the process the group names the MIDIMessageSource the event came
+ * from (MIDIMessage::ToUMP()). Statuses MIDI 1.0 gives no standalone
+ * meaning (F0 summaries from MIDIEventHandler, F4/F5 markers such as
+ * gesture events, a stray F7) travel verbatim in a system word but are
+ * never put on the wire.
+ *
+ * The conversions:
+ *
+ * - USBMIDIToUMP() turns received event packets into words; each SysEx
+ *   packet becomes one SysEx7 packet, so no state is kept between calls
+ * - UMPDecodeBytes() flattens words back into a MIDI 1.0 byte stream, which
+ *   USBMIDIEncoder packs for the device
+ * - UMPEncodeSysEx7() and UMPSysEx7Assembler convert whole F0 ... F7
+ *   messages to and from SysEx7 packets
+ *
+ * MIDIMessage::ToUMP()/FromUMP() and MIDIPipeline::PushUMP() connect words
+ * to the existing types. The USB readers still decode each packet with
+ * USBMIDIDecoder and deliver three-byte callbacks; nothing in the readers
+ * or the GUI produces words yet.
+ *
+ * Only MIDI 1.0 semantics are carried; MIDI 2.0 channel voice (type 0x4)
+ * and the other types are skipped by every reader here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "usb_midi_codec.h"
+
+#define UMP_TYPE_UTILITY            0x0
+#define UMP_TYPE_SYSTEM             0x1
+#define UMP_TYPE_MIDI1_VOICE        0x2
+#define UMP_TYPE_SYSEX7             0x3
+
+#define UMP_SYSEX7_COMPLETE         0x0     // Whole message in one packet
+#define UMP_SYSEX7_START            0x1
+#define UMP_SYSEX7_CONTINUE         0x2
+#define UMP_SYSEX7_END              0x3
+#define UMP_SYSEX7_MAX_BYTES        6
+
+#define UMP_NOOP                    0u
+
+// Words per packet, indexed by message type
+inline constexpr uint8_t UMP_WORD_COUNT[16] = { 1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4 };
+
+constexpr uint8_t UMPType(uint32_t word) { return (uint8_t)(word >> 28); }
+constexpr uint8_t UMPGroup(uint32_t word) { return (uint8_t)((word >> 24) & 0x0F); }
+constexpr uint8_t UMPStatus(uint32_t word) { return (uint8_t)(word >> 16); }
+constexpr uint8_t UMPData1(uint32_t word) { return (uint8_t)(word >> 8); }
+constexpr uint8_t UMPData2(uint32_t word) { return (uint8_t)word; }
+
+// Words in the packet this word starts
+constexpr size_t UMPWordCount(uint32_t word)
+{
+    return UMP_WORD_COUNT[UMPType(word)];
+}
+
+/**
+ * Pack one MIDI 1.0 message into a 32-bit word
+ *
+ * Data bytes the status does not use are zeroed; data bytes are masked to
+ * 7 bits. Data bytes and SysEx (status < 0x80) give UMP_NOOP.
+ */
+constexpr uint32_t UMPFromMIDI1(uint8_t group, uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0)
+{
+    if (status < 0x80) {
+        return UMP_NOOP;
+    }
+    uint8_t length = USBMIDIStatusLength(status);
+    if (length == 0) {
+        length = 3;                 // Not a standalone status: keep both bytes verbatim
+    }
+    uint32_t type = status < 0xF0 ? UMP_TYPE_MIDI1_VOICE : UMP_TYPE_SYSTEM;
+    return (type << 28) | ((uint32_t)(group & 0x0F) << 24) | ((uint32_t)status << 16) |
+           ((uint32_t)(length > 1 ? data1 & 0x7F : 0) << 8) |
+           (uint32_t)(length > 2 ? data2 & 0x7F : 0);
+}
+
+// True for the 32-bit words UMPFromMIDI1() produces
+constexpr bool UMPIsMIDI1(uint32_t word)
+{
+    return (UMPType(word) == UMP_TYPE_MIDI1_VOICE || UMPType(word) == UMP_TYPE_SYSTEM) &&
+           UMPStatus(word) >= 0x80;
+}
+
+// Bytes the word puts on a MIDI 1.0 wire (0 for in-process-only statuses and other types)
+constexpr uint8_t UMPMIDI1Length(uint32_t word)
+{
+    return UMPIsMIDI1(word) ? USBMIDIStatusLength(UMPStatus(word)) : 0;
+}
+
+constexpr uint32_t UMPSysEx7Header(uint8_t group, uint8_t status, uint8_t count)
+{
+    return ((uint32_t)UMP_TYPE_SYSEX7 << 28) | ((uint32_t)(group & 0x0F) << 24) |
+           ((uint32_t)(status & 0x0F) << 20) | ((uint32_t)(count & 0x0F) << 16);
+}
+
+constexpr uint8_t UMPSysEx7Status(uint32_t first_word) { return (uint8_t)((first_word >> 20) & 0x0F); }
+
+constexpr uint8_t UMPSysEx7Count(uint32_t first_word)
+{
+    return (uint8_t)((first_word >> 16) & 0x0F) > UMP_SYSEX7_MAX_BYTES
+        ? UMP_SYSEX7_MAX_BYTES : (uint8_t)((first_word >> 16) & 0x0F);
+}
+
+// Data byte index (0-5) of a SysEx7 packet
+constexpr uint8_t UMPSysEx7Byte(const uint32_t* words, uint8_t index)
+{
+    return index < 2 ? (uint8_t)(words[0] >> (8 - 8 * index))
+                     : (uint8_t)(words[1] >> (24 - 8 * (index - 2)));
+}
+
+static_assert(UMPFromMIDI1(0, 0x90, 0x3C, 0x7F) == 0x20903C7Fu, "");
+static_assert(UMPFromMIDI1(3, 0xC5, 12, 99) == 0x23C50C00u, "");
+static_assert(UMPFromMIDI1(0, 0xF8, 1, 2) == 0x10F80000u, "");
+static_assert(UMPFromMIDI1(0, 0xF2, 0x81, 0x02) == 0x10F20102u, "");
+static_assert(UMPFromMIDI1(4, 0xF5, 7, 2) == 0x14F50702u && UMPMIDI1Length(0x14F50702u) == 0, "");
+static_assert(UMPFromMIDI1(0, 0x45) == UMP_NOOP, "");
+static_assert(UMPWordCount(UMPSysEx7Header(0, UMP_SYSEX7_START, 6)) == 2, "");
+static_assert(UMPMIDI1Length(0x20B03040u) == 3 && UMPMIDI1Length(0x20D03000u) == 2, "");
+
+/**
+ * Convert received event packets for one cable into words in one group
+ *
+ * Channel voice and system packets become one word each; SysEx packets
+ * (CIN 0x4-0x7) become one SysEx7 packet each. Other cables and reserved
+ * CINs are skipped.
+ *
+ * @param consumed If not null, receives the number of packets used; stops
+ *                 early only when words cannot hold the next packet
+ * @return Number of words written
+ */
+size_t USBMIDIToUMP(const USBMIDIEventPacket* packets, size_t count, uint8_t cable, uint8_t group,
+                    uint32_t* words, size_t capacity, size_t* consumed = nullptr);
+
+/**
+ * Flatten the packets of one group into the MIDI 1.0 bytes they carry
+ *
+ * SysEx7 packets get F0/F7 back; in-process-only statuses, other groups
+ * and non-MIDI 1.0 types are skipped. A packet cut off at the end of words
+ * is left unconsumed.
+ *
+ * @param consumed If not null, receives the number of words used; stops
+ *                 early only when bytes cannot hold the next packet
+ * @return Number of bytes written
+ */
+size_t UMPDecodeBytes(const uint32_t* words, size_t count, uint8_t group,
+                      uint8_t* bytes, size_t capacity, size_t* consumed = nullptr);
+
+/**
+ * Split one SysEx message into SysEx7 packets
+ *
+ * A leading F0 and trailing F7 are stripped if present.
+ *
+ * @return Number of words written (two per packet), 0 if capacity is short
+ */
+size_t UMPEncodeSysEx7(uint8_t group, const uint8_t* data, size_t length,
+                       uint32_t* words, size_t capacity);
+
+/**
+ * UMPSysEx7Assembler - Rebuilds F0 ... F7 messages from SysEx7 packets
+ *
+ * The counterpart of SysExAssembler for words: fixed storage, messages
+ * longer than MAX_SYSEX_LENGTH and starts that interrupt an open message
+ * are discarded and counted. Packets of other groups are not filtered
+ * here; feed one group per assembler.
+ */
+class UMPSysEx7Assembler {
+public:
+    static constexpr size_t MAX_SYSEX_LENGTH = SysExAssembler::MAX_SYSEX_LENGTH;
+
+    UMPSysEx7Assembler() : length(0), in_progress(false), overflow(false), dropped_messages(0) {}
+
+    // @return true when the packet completed a message (Data()/Length())
+    bool Feed(const uint32_t words[2]);
+
+    void Reset() {
+        length = 0;
+        in_progress = false;
+        overflow = false;
+    }
+
+    const uint8_t* Data() const { return buffer; }
+    size_t Length() const { return length; }
+    bool InProgress() const { return in_progress; }
+    uint32_t DroppedMessages() const { return dropped_messages; }
+
+private:
+    void Append(uint8_t byte);
+
+    uint8_t buffer[MAX_SYSEX_LENGTH];
+    size_t length;
+    bool in_progress;
+    bool overflow;
+    uint32_t dropped_messages;
+};
+
+#endif // UMP_H
@@ -0,0 +1,103 @@
+// UMP Word Benchmark
+// Cost per event of getting a received USB-MIDI burst into the pipeline:
+// packet by packet through USBMIDIDecoder and Push(MIDIMessage&),
+// against one bulk USBMIDIToUMP() and PushUMP() over the word array. Also
+// the bytes each carrier takes per event. Both paths stamp one timestamp
+// per burst, so the figures compare the conversions and not system_time().
+//
+// Usage: ump_benchmark [--events <n>] [--burst <packets>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "midi_pipeline.h"
+#include "ump.h"
+
+// Keeps the pipeline from being optimized away
+struct CountingStage {
+    uint64_t* count;
+
+    bool Process(MIDIMessage& message) const {
+        *count += message.data2;
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    int events = 1000000;
+    int burst = 64;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            events = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            burst = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--events <n>] [--burst <packets>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (events <= 0 || burst <= 0) {
+        printf("❌ --events and --burst must be positive\n");
+        return 1;
+    }
+
+    // Pad presses and fader moves as the reader receives them
+    std::vector<USBMIDIEventPacket> packets(burst);
+    for (int i = 0; i < burst; i++) {
+        packets[i] = i % 3 == 2
+            ? USBMIDIEncodeMessage(0, MIDI_CONTROL_CHANGE, (uint8_t)(APC_MINI_FADER_CC_START + i % 9),
+                                   (uint8_t)(i % 128))
+            : USBMIDIEncodeMessage(0, MIDI_NOTE_ON, (uint8_t)(i % APC_MINI_PAD_COUNT),
+                                   i % 2 == 0 ? 127 : 0);
+    }
+    int rounds = (events + burst - 1) / burst;
+
+    uint64_t checksum = 0;
+    auto pipeline = MakeMIDIPipeline(NoteOffNormalizeStage(), CountingStage{&checksum});
+
+    printf("📦 UMP Word Benchmark (%d events, bursts of %d packets)\n\n", rounds * burst, burst);
+    printf("   %-26s %10s %14s\n", "Path", "ns/event", "bytes/event");
+
+    // Packet by packet, three bytes per callback
+    USBMIDIDecoder decoder;
+    bigtime_t start = system_time();
+    for (int round = 0; round < rounds; round++) {
+        bigtime_t now = system_time();
+        for (int i = 0; i < burst; i++) {
+            if (decoder.Feed(packets[i]) == USB_MIDI_DECODE_MESSAGE) {
+                const uint8_t* m = decoder.Message();
+                MIDIMessage message(m[0], m[1], m[2], MIDI_SOURCE_HARDWARE_USB, now);
+                pipeline.Push(message);
+            }
+        }
+    }
+    bigtime_t elapsed = system_time() - start;
+    printf("   %-26s %10.1f %14zu\n", "decoder + Push()",
+           (double)elapsed * 1000.0 / ((double)rounds * burst), sizeof(MIDIMessage));
+    uint64_t decoder_checksum = checksum;
+
+    // One bulk conversion, then the word array
+    checksum = 0;
+    std::vector<uint32_t> words(burst * 2);
+    start = system_time();
+    for (int round = 0; round < rounds; round++) {
+        size_t count = USBMIDIToUMP(packets.data(), burst, 0, MIDI_SOURCE_HARDWARE_USB,
+                                    words.data(), words.size());
+        pipeline.PushUMP(words.data(), count, system_time());
+    }
+    elapsed = system_time() - start;
+    printf("   %-26s %10.1f %14zu\n", "USBMIDIToUMP + PushUMP()",
+           (double)elapsed * 1000.0 / ((double)rounds * burst), sizeof(uint32_t));
+
+    if (checksum != decoder_checksum) {
+        printf("\n❌ Paths disagree (%llu vs %llu)\n", (unsigned long long)checksum,
+               (unsigned long long)decoder_checksum);
+        return 1;
+    }
+    printf("\n   Both paths deliver the same events.\n");
+    return 0;
+}
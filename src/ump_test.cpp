@@ -0,0 +1,218 @@
+/*
+ * UMP Word Test
+ * MIDI 1.0 mapping for every status, groups as sources, USB-MIDI packets
+ * to words and back to bytes, SysEx7 split/reassembly, MIDIMessage
+ * conversion and pushing word arrays through the input pipeline
+ */
+
+#include "ump.h"
+#include "midi_pipeline.h"
+#include "gesture_recognizer.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <vector>
+
+void test_midi1_mapping()
+{
+    printf("Testing MIDI 1.0 mapping...\n");
+
+    for (int status = 0x80; status <= 0xFF; status++) {
+        uint32_t word = UMPFromMIDI1(5, (uint8_t)status, 0x12, 0x34);
+        uint8_t length = USBMIDIStatusLength((uint8_t)status);
+
+        assert(UMPType(word) == (status < 0xF0 ? UMP_TYPE_MIDI1_VOICE : UMP_TYPE_SYSTEM));
+        assert(UMPGroup(word) == 5 && UMPStatus(word) == status);
+        assert(UMPWordCount(word) == 1 && UMPIsMIDI1(word));
+        assert(UMPMIDI1Length(word) == length);
+        if (length != 0) {
+            assert(UMPData1(word) == (length > 1 ? 0x12 : 0));
+            assert(UMPData2(word) == (length > 2 ? 0x34 : 0));
+        } else {
+            // In-process statuses keep both bytes
+            assert(UMPData1(word) == 0x12 && UMPData2(word) == 0x34);
+        }
+    }
+
+    assert(UMPFromMIDI1(0, 0x7F, 1, 2) == UMP_NOOP);
+    assert(!UMPIsMIDI1(UMP_NOOP));
+    assert(UMPData1(UMPFromMIDI1(0, 0x90, 0xFF, 0xFF)) == 0x7F);
+
+    // Sources ride in the group
+    MIDIMessage gesture(MIDI_GESTURE_STATUS, 17, 2, MIDI_SOURCE_GESTURE, 1000);
+    MIDIMessage back = MIDIMessage::FromUMP(gesture.ToUMP(), 1000);
+    assert(back.status == MIDI_GESTURE_STATUS && back.data1 == 17 && back.data2 == 2);
+    assert(back.source == MIDI_SOURCE_GESTURE && back.timestamp == 1000);
+    assert(MIDIMessage::FromUMP(UMPSysEx7Header(0, 0, 0), 5).status == 0);
+
+    printf("✅ Every status maps to one word and back\n");
+}
+
+void test_usb_edge()
+{
+    printf("Testing USB-MIDI packets <-> words...\n");
+
+    // A byte stream with channel voice, system, realtime inside SysEx, SysEx
+    const uint8_t stream[] = {
+        0x90, 0x3C, 0x7F,  0xB0, 0x30, 0x40,  0xC2, 0x05,  0xF2, 0x10, 0x20,
+        0xF0, 0x47, 0x7F, 0xF8, 0x4F, 0x60, 0x00, 0x04, 0x01, 0x02, 0x03, 0xF7,
+        0xF6,  0xF0, 0x7E, 0xF7,  0x80, 0x3C, 0x00
+    };
+
+    USBMIDIEncoder encoder(1);
+    USBMIDIEventPacket packets[32];
+    size_t packet_count = encoder.Encode(stream, sizeof(stream), packets, 32);
+    packets[packet_count++] = USBMIDIEncodeMessage(0, 0x90, 1, 1);     // Other cable
+
+    uint32_t words[64];
+    size_t consumed = 0;
+    size_t word_count = USBMIDIToUMP(packets, packet_count, 1, MIDI_SOURCE_HARDWARE_USB,
+                                     words, 64, &consumed);
+    assert(consumed == packet_count);
+
+    uint8_t bytes[64];
+    size_t used = 0;
+    size_t length = UMPDecodeBytes(words, word_count, MIDI_SOURCE_HARDWARE_USB, bytes, 64, &used);
+    assert(used == word_count);
+    assert(length == sizeof(stream) && memcmp(bytes, stream, length) == 0);
+
+    // Other groups are skipped
+    assert(UMPDecodeBytes(words, word_count, 3, bytes, 64) == 0);
+
+    // Short output buffers stop at a packet boundary
+    assert(USBMIDIToUMP(packets, packet_count, 1, 0, words, 1, &consumed) == 1 && consumed == 1);
+    length = UMPDecodeBytes(words, word_count, 0, bytes, 4, &used);
+    assert(length == 3 && used == 1);
+
+    // A SysEx7 packet cut off at the end of the array is left alone
+    words[0] = UMPSysEx7Header(0, UMP_SYSEX7_COMPLETE, 1);
+    assert(UMPDecodeBytes(words, 1, 0, bytes, 64, &used) == 0 && used == 0);
+
+    printf("✅ %zu packets -> %zu words -> the original %zu bytes\n", packet_count - 1,
+           word_count, sizeof(stream));
+}
+
+void test_sysex7()
+{
+    printf("Testing SysEx7 split and reassembly...\n");
+
+    UMPSysEx7Assembler assembler;
+    for (size_t payload = 0; payload <= 20; payload++) {
+        std::vector<uint8_t> message;
+        message.push_back(0xF0);
+        for (size_t i = 0; i < payload; i++) {
+            message.push_back((uint8_t)(i * 7 & 0x7F));
+        }
+        message.push_back(0xF7);
+
+        uint32_t words[16];
+        size_t count = UMPEncodeSysEx7(2, message.data(), message.size(), words, 16);
+        size_t packets = payload == 0 ? 1 : (payload + 5) / 6;
+        assert(count == packets * 2);
+        assert(UMPEncodeSysEx7(2, message.data(), message.size(), words, count - 1) == 0);
+
+        for (size_t p = 0; p < packets; p++) {
+            assert(UMPType(words[p * 2]) == UMP_TYPE_SYSEX7 && UMPGroup(words[p * 2]) == 2);
+            bool complete = assembler.Feed(&words[p * 2]);
+            assert(complete == (p == packets - 1));
+        }
+        assert(assembler.Length() == message.size());
+        assert(memcmp(assembler.Data(), message.data(), message.size()) == 0);
+
+        // Bytes out match the original message too
+        uint8_t bytes[32];
+        assert(UMPDecodeBytes(words, count, 2, bytes, 32) == message.size());
+        assert(memcmp(bytes, message.data(), message.size()) == 0);
+    }
+
+    // An interrupted message is dropped; a stray end is ignored
+    const uint8_t long_message[] = { 0xF0, 1, 2, 3, 4, 5, 6, 7, 8, 0xF7 };
+    uint32_t words[8];
+    UMPEncodeSysEx7(0, long_message, sizeof(long_message), words, 8);
+    assert(!assembler.Feed(&words[0]));
+    assert(!assembler.Feed(&words[0]) && assembler.DroppedMessages() == 1);
+    assembler.Reset();
+    assert(!assembler.Feed(&words[2]) && !assembler.InProgress());
+
+    // Longer than the assembler holds
+    std::vector<uint8_t> huge(UMPSysEx7Assembler::MAX_SYSEX_LENGTH + 10, 0x11);
+    huge.front() = 0xF0;
+    huge.back() = 0xF7;
+    std::vector<uint32_t> huge_words(huge.size());
+    size_t count = UMPEncodeSysEx7(0, huge.data(), huge.size(), huge_words.data(), huge_words.size());
+    bool completed = false;
+    for (size_t i = 0; i < count; i += 2) {
+        completed |= assembler.Feed(&huge_words[i]);
+    }
+    assert(!completed && assembler.DroppedMessages() == 2);
+
+    printf("✅ F0 ... F7 survives SysEx7 at every length\n");
+}
+
+void test_message_words()
+{
+    printf("Testing MIDIMessage conversion...\n");
+
+    MIDIMessage pad(MIDI_NOTE_ON, 12, 100, MIDI_SOURCE_HARDWARE_MIDI, 5000);
+    MIDIMessage gesture(MIDI_GESTURE_STATUS, 3, 1, MIDI_SOURCE_GESTURE, 6000);
+    assert(pad.ToUMP() == UMPFromMIDI1(MIDI_SOURCE_HARDWARE_MIDI, MIDI_NOTE_ON, 12, 100));
+
+    MIDIMessage message = MIDIMessage::FromUMP(pad.ToUMP(), 5000);
+    assert(message.status == MIDI_NOTE_ON && message.data1 == 12 && message.data2 == 100);
+    assert(message.source == MIDI_SOURCE_HARDWARE_MIDI && message.timestamp == 5000);
+    message = MIDIMessage::FromUMP(gesture.ToUMP(), 6000);
+    assert(message.status == MIDI_GESTURE_STATUS);
+    assert(message.source == MIDI_SOURCE_GESTURE && message.data1 == 3);
+
+    // Not a 32-bit MIDI 1.0 word
+    assert(MIDIMessage::FromUMP(UMPSysEx7Header(0, UMP_SYSEX7_START, 6), 0).status == 0);
+
+    printf("✅ The source travels as the group\n");
+}
+
+void test_pipeline_words()
+{
+    printf("Testing word arrays through the input pipeline...\n");
+
+    PipelineControlState state;
+    MIDIMessageQueue* inbox = new MIDIMessageQueue();
+    APCInputPipeline<APCMiniMK2Device> pipeline =
+        MakeAPCInputPipeline<APCMiniMK2Device>(&state, inbox);
+
+    uint32_t words[8];
+    size_t count = 0;
+    words[count++] = UMPFromMIDI1(MIDI_SOURCE_HARDWARE_USB, MIDI_NOTE_ON, 7, 127);
+    const uint8_t sysex[] = { 0xF0, 0x47, 0x7F, 0xF7 };
+    count += UMPEncodeSysEx7(MIDI_SOURCE_HARDWARE_USB, sysex, sizeof(sysex), &words[count], 2);
+    words[count++] = UMPFromMIDI1(MIDI_SOURCE_HARDWARE_USB, MIDI_CONTROL_CHANGE,
+                                  APC_MINI_FADER_CC_START, 64);
+    words[count++] = UMPFromMIDI1(MIDI_SOURCE_HARDWARE_USB, MIDI_NOTE_ON, 7, 0);
+
+    assert(pipeline.PushUMP(words, count, 1234) == 3);
+    assert(state.note_values[7].load() == 0);
+    assert(state.cc_values[APC_MINI_FADER_CC_START].load() == 64);
+
+    MIDIMessage message;
+    assert(inbox->Dequeue(message) && message.status == MIDI_NOTE_ON && message.timestamp == 1234);
+    assert(inbox->Dequeue(message) && message.status == MIDI_CONTROL_CHANGE);
+    assert(inbox->Dequeue(message) && message.status == MIDI_NOTE_OFF);
+    assert(!inbox->Dequeue(message));
+
+    delete inbox;
+    printf("✅ Words dispatch like messages; SysEx7 is stepped over\n");
+}
+
+int main()
+{
+    printf("📦 UMP Word Test\n");
+    printf("================\n\n");
+
+    test_midi1_mapping();
+    test_usb_edge();
+    test_sysex7();
+    test_message_words();
+    test_pipeline_words();
+
+    printf("\n🎉 ALL TESTS PASSED! UMP words convert cleanly at the edges.\n");
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "usb_raw_midi.h"
+#include "apc_device_profile.h"
+#include "thread_accounting.h"
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -18,8 +20,7 @@ public:
     APCMiniUSBDevice(const char* path) : BUSBDevice(path), endpoint_in(nullptr), endpoint_out(nullptr) {}
 
     bool IsAPCMini() {
-        return (VendorID() == APC_MINI_VENDOR_ID &&
-                (ProductID() == APC_MINI_PRODUCT_ID || ProductID() == APC_MINI_MK2_PRODUCT_ID));
+        return APCIsSupportedDevice(VendorID(), ProductID());
     }
 
     status_t FindMIDIEndpoints() {
@@ -57,11 +58,11 @@ public:
 
     virtual status_t DeviceAdded(BUSBDevice* device) {
         // Check if this is an APC Mini device
-        if (device->VendorID() == APC_MINI_VENDOR_ID &&
-            (device->ProductID() == APC_MINI_PRODUCT_ID || device->ProductID() == APC_MINI_MK2_PRODUCT_ID)) {
+        const APCDeviceDescriptor* profile = APCFindDevice(device->VendorID(), device->ProductID());
+        if (profile) {
 
-            printf("   🎹 Found APC Mini device: VID=%04X PID=%04X Location=%s\n",
-                   device->VendorID(), device->ProductID(), device->Location());
+            printf("   🎹 Found %s device: VID=%04X PID=%04X Location=%s\n",
+                   profile->name, device->VendorID(), device->ProductID(), device->Location());
             found_device = device;
 
             // Find MIDI endpoints
@@ -149,6 +150,7 @@ USBRawMIDI::USBRawMIDI()
     , interface_num(-1)
     , endpoint_in(0)
     , endpoint_out(0)
+    , device_profile(nullptr)
     , reader_thread(-1)
     , should_stop(false)
     , pause_requested(false)
@@ -196,7 +198,9 @@ APCMiniError USBRawMIDI::Initialize()
         return APC_ERROR_DEVICE_NOT_FOUND;
     }
 
-    printf("   ✅ APC Mini MK2 connected successfully!\n");
+    device_profile = APCFindDevice(g_usb_roster->found_device->VendorID(),
+                                   g_usb_roster->found_device->ProductID());
+    printf("   ✅ %s connected successfully!\n", device_profile->name);
     printf("   📡 MIDI endpoints active: IN=%p OUT=%p\n",
            g_usb_roster->endpoint_in,
            g_usb_roster->endpoint_out);
@@ -229,6 +233,7 @@ void USBRawMIDI::Shutdown()
     }
 
     device_fd = -1;
+    device_profile = nullptr;
     printf("USB MIDI connection closed\n");
 }
 
@@ -238,30 +243,8 @@ APCMiniError USBRawMIDI::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
         return APC_ERROR_USB_TRANSFER_FAILED;
     }
 
-    // Create USB MIDI packet
-    usb_midi_event_packet packet;
-    packet.cn = 0;  // Cable number 0
-
-    // Determine Code Index Number based on MIDI message type
-    uint8_t msg_type = status & 0xF0;
-    switch (msg_type) {
-        case MIDI_NOTE_OFF:
-            packet.cin = 0x8;
-            break;
-        case MIDI_NOTE_ON:
-            packet.cin = 0x9;
-            break;
-        case MIDI_CONTROL_CHANGE:
-            packet.cin = 0xB;
-            break;
-        default:
-            packet.cin = 0x9; // Default to note on
-            break;
-    }
-
-    packet.midi[0] = status;
-    packet.midi[1] = data1;
-    packet.midi[2] = data2;
+    // Cable 0; the CIN comes from the codec's status table
+    USBMIDIEventPacket packet = USBMIDIEncodeMessage(0, status, data1, data2);
 
     // Acquire lock for exclusive endpoint access
     BAutolock auto_lock(endpoint_lock);
@@ -296,6 +279,53 @@ APCMiniError USBRawMIDI::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
     return result_code;
 }
 
+APCMiniError USBRawMIDI::SendMIDIBatch(const uint8_t (*messages)[3], size_t count)
+{
+    if (!IsConnected() || !g_usb_roster || !g_usb_roster->found_device) {
+        return APC_ERROR_USB_TRANSFER_FAILED;
+    }
+    if (!messages || count == 0) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    BUSBEndpoint* endpoint = g_usb_roster->endpoint_out;
+    if (!endpoint) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    // Acquire lock once for the whole batch
+    BAutolock auto_lock(endpoint_lock);
+    if (!auto_lock.IsLocked()) {
+        return APC_ERROR_USB_TRANSFER_FAILED;
+    }
+
+    USBMIDIEventPacket packets[MIDI_BATCH_MAX_PACKETS];
+    size_t offset = 0;
+
+    while (offset < count) {
+        size_t chunk = count - offset < MIDI_BATCH_MAX_PACKETS ? count - offset : MIDI_BATCH_MAX_PACKETS;
+        for (size_t i = 0; i < chunk; i++) {
+            const uint8_t* message = messages[offset + i];
+            packets[i] = USBMIDIEncodeMessage(0, message[0], message[1], message[2]);
+        }
+
+        size_t length = chunk * sizeof(USBMIDIEventPacket);
+        ssize_t result = endpoint->IsInterrupt() ? endpoint->InterruptTransfer(packets, length)
+                                                 : endpoint->BulkTransfer(packets, length);
+        if (result != (ssize_t)length) {
+            printf("USB MIDI batch send failed: %s (sent %zd of %zu bytes)\n",
+                   strerror(result < 0 ? result : B_ERROR), result < 0 ? 0 : result, length);
+            stats.error_count++;
+            return APC_ERROR_USB_TRANSFER_FAILED;
+        }
+
+        stats.messages_sent += chunk;
+        offset += chunk;
+    }
+
+    return APC_SUCCESS;
+}
+
 APCMiniError USBRawMIDI::SendSysEx(const uint8_t* data, size_t length)
 {
     if (!g_usb_roster || !g_usb_roster->found_device) {
@@ -306,6 +336,9 @@ APCMiniError USBRawMIDI::SendSysEx(const uint8_t* data, size_t length)
     if (!endpoint) {
         return APC_ERROR_DEVICE_NOT_FOUND;
     }
+    if (!data || length < 2 || data[0] != 0xF0 || data[length - 1] != 0xF7) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
 
     // Acquire lock for exclusive endpoint access
     BAutolock auto_lock(endpoint_lock);
@@ -313,57 +346,33 @@ APCMiniError USBRawMIDI::SendSysEx(const uint8_t* data, size_t length)
         return APC_ERROR_USB_TRANSFER_FAILED;
     }
 
-    // Send SysEx as USB MIDI packets (4 bytes each)
-    // CIN values: 0x04 = SysEx start/continue, 0x05/0x06/0x07 = SysEx end with 1/2/3 bytes
+    // The codec chunks the message into CIN 0x4 ... 0x5/0x6/0x7 packets;
+    // send them in as few transfers as possible
+    USBMIDIEncoder encoder;
+    USBMIDIEventPacket packets[MIDI_BATCH_MAX_PACKETS];
     size_t offset = 0;
-    APCMiniError result_code = APC_SUCCESS;
-
-    while (offset < length && result_code == APC_SUCCESS) {
-        usb_midi_event_packet packet = {0};
-        size_t remaining = length - offset;
 
-        if (remaining >= 3) {
-            // Full packet (3 MIDI bytes)
-            if (offset + 3 < length) {
-                // Not the last packet
-                packet.cin = 0x04;  // SysEx starts or continues
-            } else {
-                // Last packet with 3 bytes
-                packet.cin = 0x07;  // SysEx ends with 3 bytes
-            }
-            packet.midi[0] = data[offset];
-            packet.midi[1] = data[offset + 1];
-            packet.midi[2] = data[offset + 2];
-            offset += 3;
-        } else if (remaining == 2) {
-            // Last packet with 2 bytes
-            packet.cin = 0x06;  // SysEx ends with 2 bytes
-            packet.midi[0] = data[offset];
-            packet.midi[1] = data[offset + 1];
-            packet.midi[2] = 0;
-            offset += 2;
-        } else {
-            // Last packet with 1 byte
-            packet.cin = 0x05;  // SysEx ends with 1 byte
-            packet.midi[0] = data[offset];
-            packet.midi[1] = 0;
-            packet.midi[2] = 0;
-            offset += 1;
+    while (offset < length) {
+        size_t consumed = 0;
+        size_t count = encoder.Encode(data + offset, length - offset, packets,
+                                      MIDI_BATCH_MAX_PACKETS, &consumed);
+        offset += consumed;
+        if (count == 0) {
+            continue;
         }
 
-        // Send packet
-        ssize_t result = endpoint->BulkTransfer(&packet, sizeof(packet));
-        if (result != sizeof(packet)) {
-            printf("USB SysEx packet send failed: %s\n",
-                   strerror(result < 0 ? result : B_ERROR));
-            result_code = APC_ERROR_USB_TRANSFER_FAILED;
+        size_t bytes = count * sizeof(USBMIDIEventPacket);
+        ssize_t result = endpoint->IsInterrupt() ? endpoint->InterruptTransfer(packets, bytes)
+                                                 : endpoint->BulkTransfer(packets, bytes);
+        if (result != (ssize_t)bytes) {
+            printf("USB SysEx send failed: %s\n", strerror(result < 0 ? result : B_ERROR));
             stats.error_count++;
-        } else {
-            stats.messages_sent++;
+            return APC_ERROR_USB_TRANSFER_FAILED;
         }
+        stats.messages_sent += count;
     }
 
-    return result_code;
+    return APC_SUCCESS;
 }
 
 APCMiniError USBRawMIDI::SendIntroductionMessage()
@@ -426,6 +435,16 @@ APCMiniError USBRawMIDI::SetPadColor(uint8_t pad, APCMiniLEDColor color)
     return SendNoteOn(note, velocity);
 }
 
+APCMiniError USBRawMIDI::SetPadBehavior(uint8_t pad, uint8_t color, APCMiniMK2LEDBehavior behavior)
+{
+    if (pad >= APC_MINI_PAD_COUNT) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t note = APC_MINI_PAD_NOTE_START + pad;
+    return SendMIDI(MIDI_NOTE_ON | (behavior & 0x0F), note, color & 0x7F);
+}
+
 void USBRawMIDI::ResetStats()
 {
     memset(&stats, 0, sizeof(stats));
@@ -453,6 +472,7 @@ int32 USBRawMIDI::ReaderThreadEntry(void* data)
 void USBRawMIDI::ReaderThreadLoop()
 {
     printf("   🔄 USB MIDI reader thread started (ultra-low latency mode)\n");
+    ScopedThreadAccounting accounting("usb_reader");
 
     while (!should_stop) {
         // Check if pause is requested
@@ -482,8 +502,9 @@ void USBRawMIDI::ReaderThreadLoop()
             continue;
         }
 
-        // Read USB MIDI packet - protected by endpoint lock
-        usb_midi_event_packet packet;
+        // Read USB MIDI packets - protected by endpoint lock; the device
+        // may pack several events into one transfer
+        USBMIDIEventPacket packets[MIDI_READ_MAX_PACKETS];
         ssize_t result;
 
         {
@@ -495,27 +516,34 @@ void USBRawMIDI::ReaderThreadLoop()
 
             // Use appropriate transfer method based on endpoint type
             if (endpoint->IsInterrupt()) {
-                result = endpoint->InterruptTransfer(&packet, sizeof(packet));
+                result = endpoint->InterruptTransfer(packets, sizeof(packets));
             } else {
-                result = endpoint->BulkTransfer(&packet, sizeof(packet));
+                result = endpoint->BulkTransfer(packets, sizeof(packets));
             }
         }
 
-        if (result >= 4) {
-            // Process received MIDI packet
-            if (packet.cin != 0 && midi_callback) {
-                bigtime_t current_time = system_time();
-
-                // Extract MIDI bytes from packet
-                uint8_t status = packet.midi[0];
-                uint8_t data1 = packet.midi[1];
-                uint8_t data2 = packet.midi[2];
-
-                // Call callback with MIDI data
-                midi_callback(status, data1, data2);
-
+        if (result >= (ssize_t)sizeof(USBMIDIEventPacket)) {
+            size_t count = result / sizeof(USBMIDIEventPacket);
+            for (size_t i = 0; i < count; i++) {
+                // The decoder skips other cables and reserved CINs and
+                // reassembles SysEx before delivery
+                switch (midi_decoder.Feed(packets[i])) {
+                    case USB_MIDI_DECODE_SYSEX:
+                        if (sysex_callback) {
+                            sysex_callback(midi_decoder.SysExData(), midi_decoder.SysExLength());
+                        }
+                        break;
+                    case USB_MIDI_DECODE_MESSAGE:
+                        if (midi_callback) {
+                            const uint8_t* message = midi_decoder.Message();
+                            midi_callback(message[0], message[1], message[2]);
+                        }
+                        break;
+                    default:
+                        continue;
+                }
                 stats.messages_received++;
-                last_message_time = current_time;
+                last_message_time = system_time();
             }
         } else if (result < 0) {
             // Real error (negative return indicates error)
@@ -526,6 +554,7 @@ void USBRawMIDI::ReaderThreadLoop()
 
         // Minimal delay to prevent excessive CPU usage (ultra low latency mode)
         snooze(100); // 0.1ms - near real-time
+        ThreadAccounting::NoteWakeup();
     }
 
     printf("USB MIDI reader thread stopped\n");
@@ -575,9 +604,7 @@ int USBDeviceScanner::ScanUSBDevices(USBDevice* /*devices*/, int /*max_devices*/
 
 bool USBDeviceScanner::IsAPCMini(const USBDevice& device)
 {
-    return (device.vendor_id == APC_MINI_VENDOR_ID &&
-            (device.product_id == APC_MINI_PRODUCT_ID ||
-             device.product_id == APC_MINI_MK2_PRODUCT_ID));
+    return APCIsSupportedDevice(device.vendor_id, device.product_id);
 }
 
 void USBDeviceScanner::PrintDeviceInfo(const USBDevice& device)
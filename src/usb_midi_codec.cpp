@@ -0,0 +1,224 @@
+#include "usb_midi_codec.h"
+
+#include <string.h>
+
+USBMIDIEncoder::USBMIDIEncoder(uint8_t cable)
+    : cable(cable & 0x0F)
+{
+    memset(&stats, 0, sizeof(stats));
+    Reset();
+}
+
+void USBMIDIEncoder::Reset()
+{
+    running_status = 0;
+    message_length = 0;
+    expected_length = 0;
+    in_sysex = false;
+    sysex_length = 0;
+    memset(message, 0, sizeof(message));
+    memset(sysex, 0, sizeof(sysex));
+}
+
+size_t USBMIDIEncoder::Encode(const uint8_t* bytes, size_t length, USBMIDIEventPacket* packets,
+                              size_t capacity, size_t* consumed)
+{
+    size_t written = 0;
+    size_t index = 0;
+
+    if (bytes && packets) {
+        while (index < length) {
+            uint8_t byte = bytes[index];
+
+            // Fast path: a whole channel message (explicit or running status)
+            // in the input skips the byte-at-a-time state machine
+            if (!in_sysex && message_length == 0 && written < capacity) {
+                uint8_t status = byte >= 0x80 ? byte : running_status;
+                size_t start = byte >= 0x80 ? index + 1 : index;
+                size_t data_length = (size_t)USBMIDIStatusLength(status) - 1;
+                if (status >= 0x80 && status < 0xF0 && start + data_length <= length) {
+                    uint8_t data1 = bytes[start];
+                    uint8_t data2 = data_length == 2 ? bytes[start + 1] : 0;
+                    if (((data1 | data2) & 0x80) == 0) {
+                        packets[written++] = USBMIDIEncodeMessage(cable, status, data1, data2);
+                        running_status = status;
+                        index = start + data_length;
+                        continue;
+                    }
+                }
+            }
+
+            // Only F6 right after held SysEx bytes needs two packets
+            size_t needed = (in_sysex && sysex_length > 0 && byte == 0xF6) ? 2 : 1;
+            if (capacity - written < needed) {
+                break;
+            }
+            written += EncodeByte(byte, packets + written);
+            index++;
+        }
+    }
+
+    stats.bytes_in += index;
+    stats.packets_out += written;
+    if (consumed) {
+        *consumed = index;
+    }
+    return written;
+}
+
+size_t USBMIDIEncoder::FlushSysEx(uint8_t cin, USBMIDIEventPacket* packets)
+{
+    packets[0].header = USBMIDIHeader(cable, cin);
+    for (uint8_t i = 0; i < 3; i++) {
+        packets[0].midi[i] = i < sysex_length ? sysex[i] : 0;
+    }
+    sysex_length = 0;
+    return 1;
+}
+
+size_t USBMIDIEncoder::EncodeByte(uint8_t byte, USBMIDIEventPacket* packets)
+{
+    // Realtime goes out immediately and leaves every other state alone
+    if (USBMIDIIsRealtime(byte)) {
+        packets[0] = USBMIDIEncodeMessage(cable, byte);
+        return 1;
+    }
+
+    size_t count = 0;
+
+    if (in_sysex) {
+        if (byte < 0x80) {
+            sysex[sysex_length++] = byte;
+            return sysex_length == 3 ? FlushSysEx(USB_MIDI_CIN_SYSEX_START, packets) : 0;
+        }
+        if (byte == 0xF7) {
+            sysex[sysex_length++] = byte;
+            in_sysex = false;
+            return FlushSysEx((uint8_t)(USB_MIDI_CIN_SYSEX_END_1 + sysex_length - 1), packets);
+        }
+
+        // Any other status ends the SysEx without F7: close the packet
+        // stream with an end CIN so the receiver drops the partial message
+        stats.aborted_sysex++;
+        in_sysex = false;
+        if (sysex_length > 0) {
+            count = FlushSysEx((uint8_t)(USB_MIDI_CIN_SYSEX_END_1 + sysex_length - 1), packets);
+        }
+    }
+
+    if (byte >= 0x80) {
+        message_length = 0;
+        if (byte == 0xF0) {
+            running_status = 0;
+            in_sysex = true;
+            sysex[0] = byte;
+            sysex_length = 1;
+            return count;
+        }
+
+        uint8_t length = USBMIDIStatusLength(byte);
+        if (length == 0) {
+            // Stray F7 or undefined F4/F5
+            running_status = 0;
+            stats.dropped_bytes++;
+            return count;
+        }
+
+        // Channel voice sets running status; system common cancels it
+        running_status = byte < 0xF0 ? byte : 0;
+        if (length == 1) {
+            packets[count] = USBMIDIEncodeMessage(cable, byte);
+            return count + 1;
+        }
+        message[0] = byte;
+        message_length = 1;
+        expected_length = length;
+        return count;
+    }
+
+    if (message_length == 0) {
+        if (running_status == 0) {
+            stats.dropped_bytes++;
+            return count;
+        }
+        message[0] = running_status;
+        message_length = 1;
+        expected_length = USBMIDIStatusLength(running_status);
+    }
+
+    message[message_length++] = byte;
+    if (message_length < expected_length) {
+        return count;
+    }
+    packets[count] = USBMIDIEncodeMessage(cable, message[0], message[1], message[2]);
+    message_length = 0;
+    return count + 1;
+}
+
+USBMIDIDecoder::USBMIDIDecoder(uint8_t cable)
+    : cable(cable & 0x0F)
+{
+    Reset();
+}
+
+void USBMIDIDecoder::Reset()
+{
+    sysex.Reset();
+    memset(message, 0, sizeof(message));
+    message_length = 0;
+}
+
+USBMIDIDecodeResult USBMIDIDecoder::Feed(const USBMIDIEventPacket& packet)
+{
+    uint8_t cin = packet.header & 0x0F;
+    uint8_t length = USBMIDICINLength(cin);
+    if ((packet.header >> 4) != cable || length == 0) {
+        return USB_MIDI_DECODE_NONE;
+    }
+
+    // CIN 0x5 carrying a status other than F7 is a single-byte system common
+    bool system_common_1 = cin == USB_MIDI_CIN_SYSEX_END_1 &&
+                           packet.midi[0] >= 0x80 && packet.midi[0] != 0xF7;
+    if (SysExAssembler::IsSysExCIN(cin) && !system_common_1) {
+        return sysex.Feed(cin, packet.midi) ? USB_MIDI_DECODE_SYSEX : USB_MIDI_DECODE_NONE;
+    }
+
+    // A new status interrupts an open SysEx; realtime does not
+    if (!USBMIDIIsRealtime(packet.midi[0])) {
+        sysex.Abort();
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        message[i] = i < length ? packet.midi[i] : 0;
+    }
+    message_length = length;
+    return USB_MIDI_DECODE_MESSAGE;
+}
+
+size_t USBMIDIDecodeBytes(const USBMIDIEventPacket* packets, size_t count, uint8_t cable,
+                          uint8_t* bytes, size_t capacity, size_t* consumed)
+{
+    size_t written = 0;
+    size_t index = 0;
+
+    if (packets && bytes) {
+        for (; index < count; index++) {
+            const USBMIDIEventPacket& packet = packets[index];
+            if ((packet.header >> 4) != (cable & 0x0F)) {
+                continue;
+            }
+            uint8_t length = USBMIDICINLength(packet.header);
+            if (capacity - written < length) {
+                break;
+            }
+            for (uint8_t i = 0; i < length; i++) {
+                bytes[written++] = packet.midi[i];
+            }
+        }
+    }
+
+    if (consumed) {
+        *consumed = index;
+    }
+    return written;
+}
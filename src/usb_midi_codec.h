@@ -0,0 +1,252 @@
+#ifndef USB_MIDI_CODEC_H
+#define USB_MIDI_CODEC_H
+
+/*
+ * USB-MIDI Event Packet Codec
+ *
+ * USB MIDI 1.0 carries MIDI in 4-byte event packets: a header byte (cable
+ * number in the high nibble, Code Index Number in the low nibble) and up
+ * to three MIDI bytes. The CIN tells the receiver how many of those bytes
+ * are valid, so every packet must be classified by its status byte:
+ *
+ *   CIN  Bytes  Carries
+ *   0x2  2      Two-byte system common (F1 MTC quarter frame, F3 song select)
+ *   0x3  3      Three-byte system common (F2 song position)
+ *   0x4  3      SysEx starts or continues
+ *   0x5  1      SysEx ends with 1 byte, or single-byte system common (F6)
+ *   0x6  2      SysEx ends with 2 bytes
+ *   0x7  3      SysEx ends with 3 bytes
+ *   0x8-0xE     Channel voice; CIN = status >> 4 (C0/D0 carry 2 bytes)
+ *   0xF  1      Single byte (realtime F8-FF)
+ *
+ * Both directions share the constexpr tables below:
+ *
+ * - USBMIDIEncodeMessage() packs one complete message (SendMIDI, batches)
+ * - USBMIDIEncoder turns an arbitrary MIDI byte stream into packets in
+ *   bulk: running status is expanded, realtime bytes are sent the moment
+ *   they arrive (also inside a message or SysEx) and SysEx is chunked into
+ *   CIN 0x4 ... 0x5/0x6/0x7 packets
+ * - USBMIDIDecoder turns received packets back into short messages and
+ *   reassembled SysEx (SysExAssembler); USBMIDIDecodeBytes() flattens
+ *   packets into a byte stream
+ *
+ * Nothing here allocates, so the reader thread can use it directly.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apc_mini_defs.h"
+#include "sysex_assembler.h"
+
+#define USB_MIDI_CIN_SYSCOMMON_2    0x02
+#define USB_MIDI_CIN_SYSCOMMON_3    0x03
+#define USB_MIDI_CIN_SYSEX_START    0x04
+#define USB_MIDI_CIN_SYSEX_END_1    0x05    // Also single-byte system common
+#define USB_MIDI_CIN_SYSEX_END_2    0x06
+#define USB_MIDI_CIN_SYSEX_END_3    0x07
+#define USB_MIDI_CIN_SINGLE_BYTE    0x0F
+
+struct USBMIDICodecTables {
+    uint8_t status_cin[128];        // Indexed by status - 0x80; 0 = not a packet of its own
+    uint8_t status_length[128];     // Message length including status; 0 = variable/undefined
+    uint8_t cin_length[16];         // Valid MIDI bytes per CIN; 0 = reserved
+};
+
+constexpr USBMIDICodecTables BuildUSBMIDICodecTables()
+{
+    USBMIDICodecTables tables = {};
+
+    // Channel voice: the CIN is the status nibble
+    for (int status = 0x80; status < 0xF0; status++) {
+        uint8_t type = (uint8_t)(status & 0xF0);
+        tables.status_cin[status - 0x80] = (uint8_t)(status >> 4);
+        tables.status_length[status - 0x80] = (type == 0xC0 || type == 0xD0) ? 2 : 3;
+    }
+
+    // System common; F0/F7 frame SysEx and F4/F5 are undefined
+    tables.status_cin[0xF1 - 0x80] = USB_MIDI_CIN_SYSCOMMON_2;
+    tables.status_length[0xF1 - 0x80] = 2;
+    tables.status_cin[0xF2 - 0x80] = USB_MIDI_CIN_SYSCOMMON_3;
+    tables.status_length[0xF2 - 0x80] = 3;
+    tables.status_cin[0xF3 - 0x80] = USB_MIDI_CIN_SYSCOMMON_2;
+    tables.status_length[0xF3 - 0x80] = 2;
+    tables.status_cin[0xF6 - 0x80] = USB_MIDI_CIN_SYSEX_END_1;
+    tables.status_length[0xF6 - 0x80] = 1;
+
+    // System realtime: one byte, may appear anywhere
+    for (int status = 0xF8; status <= 0xFF; status++) {
+        tables.status_cin[status - 0x80] = USB_MIDI_CIN_SINGLE_BYTE;
+        tables.status_length[status - 0x80] = 1;
+    }
+
+    const uint8_t cin_length[16] = { 0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1 };
+    for (int cin = 0; cin < 16; cin++) {
+        tables.cin_length[cin] = cin_length[cin];
+    }
+    return tables;
+}
+
+inline constexpr USBMIDICodecTables USB_MIDI_CODEC_TABLES = BuildUSBMIDICodecTables();
+
+// True for F8-FF, which may interrupt any message without affecting it
+constexpr bool USBMIDIIsRealtime(uint8_t byte)
+{
+    return byte >= 0xF8;
+}
+
+// CIN a status byte is sent with (0 for data bytes, F0, F7, F4, F5)
+constexpr uint8_t USBMIDIStatusCIN(uint8_t status)
+{
+    return status >= 0x80 ? USB_MIDI_CODEC_TABLES.status_cin[status - 0x80] : 0;
+}
+
+// Length of the message a status byte starts (0 for data bytes, SysEx, undefined)
+constexpr uint8_t USBMIDIStatusLength(uint8_t status)
+{
+    return status >= 0x80 ? USB_MIDI_CODEC_TABLES.status_length[status - 0x80] : 0;
+}
+
+// Number of valid MIDI bytes in a packet with this CIN
+constexpr uint8_t USBMIDICINLength(uint8_t cin)
+{
+    return USB_MIDI_CODEC_TABLES.cin_length[cin & 0x0F];
+}
+
+constexpr uint8_t USBMIDIHeader(uint8_t cable, uint8_t cin)
+{
+    return (uint8_t)(((cable & 0x0F) << 4) | (cin & 0x0F));
+}
+
+/**
+ * Pack one complete message into an event packet
+ *
+ * Unused bytes are zeroed. Bytes that do not start a message of their own
+ * (data, F0, F7, F4, F5) go out as CIN 0xF single bytes, so nothing is
+ * ever mislabelled as a Note On.
+ */
+constexpr USBMIDIEventPacket USBMIDIEncodeMessage(uint8_t cable, uint8_t status,
+                                                  uint8_t data1 = 0, uint8_t data2 = 0)
+{
+    uint8_t cin = USBMIDIStatusCIN(status);
+    uint8_t length = USBMIDIStatusLength(status);
+    if (cin == 0 || length == 0) {
+        cin = USB_MIDI_CIN_SINGLE_BYTE;
+        length = 1;
+    }
+    USBMIDIEventPacket packet = { USBMIDIHeader(cable, cin),
+                                  { status, (uint8_t)(length > 1 ? data1 : 0),
+                                    (uint8_t)(length > 2 ? data2 : 0) } };
+    return packet;
+}
+
+static_assert(sizeof(USBMIDIEventPacket) == 4, "USB-MIDI event packets are 4 bytes");
+static_assert(USBMIDIStatusCIN(0x90) == USB_MIDI_CIN_NOTE_ON, "");
+static_assert(USBMIDIStatusCIN(0x8F) == USB_MIDI_CIN_NOTE_OFF, "");
+static_assert(USBMIDIStatusCIN(0xB0) == USB_MIDI_CIN_CC, "");
+static_assert(USBMIDIStatusLength(0xC5) == 2 && USBMIDICINLength(0xC) == 2, "");
+static_assert(USBMIDIStatusCIN(0xF2) == 0x3 && USBMIDIStatusLength(0xF2) == 3, "");
+static_assert(USBMIDIStatusCIN(0xF8) == 0xF && USBMIDICINLength(0xF) == 1, "");
+static_assert(USBMIDIStatusCIN(0xF0) == 0 && USBMIDIStatusCIN(0xF7) == 0, "");
+static_assert(USBMIDIEncodeMessage(0, 0xE3, 0x12, 0x34).header == 0x0E, "");
+static_assert(USBMIDIEncodeMessage(1, 0xC0, 5, 99).midi[2] == 0, "");
+static_assert(USBMIDIEncodeMessage(0, 0xF4).header == 0x0F, "");
+
+struct USBMIDIEncoderStats {
+    uint64_t bytes_in;
+    uint64_t packets_out;
+    uint32_t dropped_bytes;         // Data bytes with no status to run on
+    uint32_t aborted_sysex;         // SysEx cut short by another status byte
+};
+
+/**
+ * USBMIDIEncoder - MIDI byte stream to USB-MIDI event packets
+ *
+ * Keeps parser state between calls, so a stream may be fed in pieces of
+ * any size. Every packet carries at least one input byte; up to two SysEx
+ * bytes may be held over from the previous call, so a packet buffer one
+ * longer than the input never runs short.
+ */
+class USBMIDIEncoder {
+public:
+    explicit USBMIDIEncoder(uint8_t cable = 0);
+
+    /**
+     * Encode bytes into packets
+     *
+     * @param consumed If not null, receives the number of input bytes used;
+     *                 encoding stops early only when packets is full
+     * @return Number of packets written
+     */
+    size_t Encode(const uint8_t* bytes, size_t length, USBMIDIEventPacket* packets,
+                  size_t capacity, size_t* consumed = nullptr);
+
+    // Drop partial messages and running status (e.g. after a device reset)
+    void Reset();
+
+    uint8_t Cable() const { return cable; }
+    const USBMIDIEncoderStats& GetStats() const { return stats; }
+
+private:
+    // Packets for one byte: at most two (an aborted SysEx, then F6)
+    size_t EncodeByte(uint8_t byte, USBMIDIEventPacket* packets);
+    size_t FlushSysEx(uint8_t cin, USBMIDIEventPacket* packets);
+
+    uint8_t cable;
+    uint8_t running_status;         // 0 when none
+    uint8_t message[3];
+    uint8_t message_length;         // Bytes collected for the current message
+    uint8_t expected_length;
+    bool in_sysex;
+    uint8_t sysex[3];
+    uint8_t sysex_length;
+    USBMIDIEncoderStats stats;
+};
+
+enum USBMIDIDecodeResult {
+    USB_MIDI_DECODE_NONE = 0,       // Nothing complete yet (SysEx chunk, other cable, reserved CIN)
+    USB_MIDI_DECODE_MESSAGE,        // A short message: Message()/MessageLength()
+    USB_MIDI_DECODE_SYSEX           // A complete F0 ... F7: SysExData()/SysExLength()
+};
+
+/**
+ * USBMIDIDecoder - USB-MIDI event packets to MIDI messages
+ *
+ * Packets for other cables and reserved CINs (0x0, 0x1) are skipped.
+ * CIN 0x5 is a SysEx end only while a SysEx is open or when it carries F7;
+ * otherwise it is the single-byte system common F6.
+ */
+class USBMIDIDecoder {
+public:
+    explicit USBMIDIDecoder(uint8_t cable = 0);
+
+    USBMIDIDecodeResult Feed(const USBMIDIEventPacket& packet);
+
+    // Last short message; unused bytes are 0
+    const uint8_t* Message() const { return message; }
+    uint8_t MessageLength() const { return message_length; }
+
+    const uint8_t* SysExData() const { return sysex.Data(); }
+    size_t SysExLength() const { return sysex.Length(); }
+    uint32_t DroppedSysEx() const { return sysex.DroppedMessages(); }
+
+    void Reset();
+
+private:
+    uint8_t cable;
+    uint8_t message[3];
+    uint8_t message_length;
+    SysExAssembler sysex;
+};
+
+/**
+ * Flatten packets for one cable into the MIDI bytes they carry
+ *
+ * @param consumed If not null, receives the number of packets used; stops
+ *                 early only when bytes cannot hold the next packet
+ * @return Number of bytes written
+ */
+size_t USBMIDIDecodeBytes(const USBMIDIEventPacket* packets, size_t count, uint8_t cable,
+                          uint8_t* bytes, size_t capacity, size_t* consumed = nullptr);
+
+#endif // USB_MIDI_CODEC_H
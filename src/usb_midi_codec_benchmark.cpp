@@ -0,0 +1,179 @@
+// USB-MIDI Codec Benchmark
+// Bulk encode and decode throughput for typical APC Mini traffic (LED
+// updates with running status, fader CCs with clock interleaved) and
+// for SysEx dumps, next to the old per-message switch for reference.
+//
+// Usage: usb_midi_codec_benchmark [--mbytes <MB per run>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/time.h>
+
+#include "usb_midi_codec.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static volatile uint8_t sink;
+
+static double Now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// The header switch SendMIDI used before the codec (Note On/Off, CC only)
+static uint8_t LegacyHeader(uint8_t status)
+{
+    switch (status & 0xF0) {
+        case MIDI_NOTE_OFF: return USB_MIDI_CIN_NOTE_OFF;
+        case MIDI_NOTE_ON: return USB_MIDI_CIN_NOTE_ON;
+        case MIDI_CONTROL_CHANGE: return USB_MIDI_CIN_CC;
+        default: return 0x0F;
+    }
+}
+
+// 64 pad colors as Note Ons on one status byte
+static Bytes LEDFrameStream()
+{
+    Bytes stream;
+    stream.push_back(MIDI_NOTE_ON | 6);
+    for (uint8_t pad = 0; pad < APC_MINI_PAD_COUNT; pad++) {
+        stream.push_back(pad);
+        stream.push_back((uint8_t)((pad * 7) & 0x7F));
+    }
+    return stream;
+}
+
+// Fader sweeps with a MIDI clock tick every few messages
+static Bytes FaderStream()
+{
+    Bytes stream;
+    for (int i = 0; i < 256; i++) {
+        stream.push_back(MIDI_CONTROL_CHANGE);
+        stream.push_back((uint8_t)(APC_MINI_FADER_CC_START + i % 9));
+        if (i % 6 == 0) {
+            stream.push_back(0xF8);
+        }
+        stream.push_back((uint8_t)(i & 0x7F));
+    }
+    return stream;
+}
+
+static Bytes SysExStream()
+{
+    Bytes stream;
+    stream.push_back(0xF0);
+    for (int i = 0; i < 1021; i++) {
+        stream.push_back((uint8_t)(i & 0x7F));
+    }
+    stream.push_back(0xF7);
+    return stream;
+}
+
+struct CodecResult {
+    double encode_mbps;
+    double decode_mbps;
+    double packets_per_sec;
+};
+
+static CodecResult Measure(const Bytes& stream, double mbytes)
+{
+    std::vector<USBMIDIEventPacket> packets(stream.size() + 1);
+    size_t rounds = (size_t)(mbytes * 1e6 / stream.size()) + 1;
+
+    USBMIDIEncoder encoder;
+    size_t count = 0;
+    double start = Now();
+    for (size_t i = 0; i < rounds; i++) {
+        count = encoder.Encode(stream.data(), stream.size(), packets.data(), packets.size());
+    }
+    double encode_seconds = Now() - start;
+
+    sink = packets[count / 2].midi[0];
+
+    USBMIDIDecoder decoder;
+    start = Now();
+    for (size_t i = 0; i < rounds; i++) {
+        for (size_t p = 0; p < count; p++) {
+            if (decoder.Feed(packets[p]) == USB_MIDI_DECODE_MESSAGE) {
+                sink = decoder.Message()[1];
+            }
+        }
+    }
+    double decode_seconds = Now() - start;
+
+    CodecResult result;
+    double total = (double)rounds * stream.size();
+    result.encode_mbps = total / encode_seconds / 1e6;
+    result.decode_mbps = total / decode_seconds / 1e6;
+    result.packets_per_sec = (double)rounds * count / encode_seconds;
+    return result;
+}
+
+static double MeasureLegacy(const Bytes& stream, double mbytes)
+{
+    // Pre-split 3-byte messages: the old path cannot parse a byte stream
+    std::vector<uint8_t> messages;
+    uint8_t status = stream[0];
+    for (size_t i = 1; i + 1 < stream.size(); i += 2) {
+        messages.push_back(status);
+        messages.push_back(stream[i]);
+        messages.push_back(stream[i + 1]);
+    }
+    size_t count = messages.size() / 3;
+    std::vector<USBMIDIEventPacket> packets(count);
+    size_t rounds = (size_t)(mbytes * 1e6 / stream.size()) + 1;
+
+    double start = Now();
+    for (size_t i = 0; i < rounds; i++) {
+        for (size_t m = 0; m < count; m++) {
+            packets[m].header = LegacyHeader(messages[m * 3]);
+            memcpy(packets[m].midi, &messages[m * 3], 3);
+        }
+        sink = packets[i % count].header;
+    }
+    return (double)rounds * stream.size() / (Now() - start) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    double mbytes = 64.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mbytes") == 0 && i + 1 < argc) {
+            mbytes = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--mbytes <MB per run>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (mbytes <= 0) {
+        printf("❌ --mbytes must be positive\n");
+        return 1;
+    }
+
+    printf("🔌 USB-MIDI Codec Benchmark (%.0f MB of MIDI per run)\n\n", mbytes);
+    printf("   %-20s %12s %12s %14s\n", "Stream", "Encode MB/s", "Decode MB/s", "Packets/s");
+
+    struct {
+        const char* name;
+        Bytes stream;
+    } streams[] = {
+        { "LED frame (running)", LEDFrameStream() },
+        { "Faders + clock", FaderStream() },
+        { "SysEx 1 KB", SysExStream() }
+    };
+    for (const auto& entry : streams) {
+        CodecResult result = Measure(entry.stream, mbytes);
+        printf("   %-20s %12.1f %12.1f %14.0f\n", entry.name, result.encode_mbps,
+               result.decode_mbps, result.packets_per_sec);
+    }
+
+    printf("\n   Old header switch on the pre-split LED frame: %.1f MB/s\n",
+           MeasureLegacy(streams[0].stream, mbytes));
+    printf("   (it only labels 8x/9x/Bx and cannot parse running status or SysEx)\n");
+    return 0;
+}
@@ -0,0 +1,491 @@
+/*
+ * USB-MIDI Codec Test
+ * Status/CIN tables against the USB MIDI 1.0 spec, exhaustive round trips
+ * of every short message, running status, realtime interleaving, SysEx of
+ * every length, malformed input and randomized streams fed in pieces
+ */
+
+#include "usb_midi_codec.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+// Reference CIN and length per status, written out from the spec tables
+static void SpecStatus(uint8_t status, uint8_t& cin, uint8_t& length)
+{
+    cin = 0;
+    length = 0;
+    if (status < 0xF0) {
+        cin = status >> 4;
+        length = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+        return;
+    }
+    switch (status) {
+        case 0xF1: case 0xF3: cin = 0x2; length = 2; break;
+        case 0xF2: cin = 0x3; length = 3; break;
+        case 0xF6: cin = 0x5; length = 1; break;
+        default:
+            if (status >= 0xF8) {
+                cin = 0xF;
+                length = 1;
+            }
+            break;
+    }
+}
+
+// Encode a stream in pieces of chunk bytes, with a packet buffer one longer
+// than each piece
+static std::vector<USBMIDIEventPacket> EncodeStream(USBMIDIEncoder& encoder, const Bytes& stream,
+                                                    size_t chunk)
+{
+    std::vector<USBMIDIEventPacket> packets;
+    USBMIDIEventPacket buffer[65];
+    assert(chunk >= 1 && chunk < 65);
+    for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+        size_t length = stream.size() - offset < chunk ? stream.size() - offset : chunk;
+        size_t consumed = 0;
+        size_t count = encoder.Encode(&stream[offset], length, buffer, length + 1, &consumed);
+        assert(consumed == length);
+        packets.insert(packets.end(), buffer, buffer + count);
+    }
+    return packets;
+}
+
+// Decoded bytes split into realtime and everything else; the encoder may
+// move a realtime byte ahead of the message it interrupted, never reorder
+// either stream
+static void DecodeSplit(const std::vector<USBMIDIEventPacket>& packets, Bytes& normal,
+                        Bytes& realtime)
+{
+    Bytes bytes(packets.size() * 3 + 1);
+    size_t consumed = 0;
+    size_t length = USBMIDIDecodeBytes(packets.data(), packets.size(), 0, bytes.data(),
+                                       bytes.size(), &consumed);
+    assert(consumed == packets.size());
+    for (size_t i = 0; i < length; i++) {
+        (USBMIDIIsRealtime(bytes[i]) ? realtime : normal).push_back(bytes[i]);
+    }
+}
+
+// Message-level decode back into a byte stream (no running status)
+static Bytes DecodeMessages(USBMIDIDecoder& decoder, const std::vector<USBMIDIEventPacket>& packets,
+                            Bytes* realtime = nullptr)
+{
+    Bytes out;
+    for (const USBMIDIEventPacket& packet : packets) {
+        switch (decoder.Feed(packet)) {
+            case USB_MIDI_DECODE_MESSAGE:
+                if (USBMIDIIsRealtime(decoder.Message()[0])) {
+                    if (realtime) {
+                        realtime->push_back(decoder.Message()[0]);
+                    }
+                } else {
+                    out.insert(out.end(), decoder.Message(), decoder.Message() + decoder.MessageLength());
+                }
+                break;
+            case USB_MIDI_DECODE_SYSEX:
+                out.insert(out.end(), decoder.SysExData(), decoder.SysExData() + decoder.SysExLength());
+                break;
+            default:
+                break;
+        }
+    }
+    return out;
+}
+
+// Simple deterministic generator (xorshift32)
+struct Random {
+    uint32_t state;
+    uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint8_t Data() { return (uint8_t)(Next() & 0x7F); }
+};
+
+void test_tables()
+{
+    printf("Testing status and CIN tables...\n");
+
+    for (int status = 0x80; status <= 0xFF; status++) {
+        uint8_t cin;
+        uint8_t length;
+        SpecStatus((uint8_t)status, cin, length);
+        assert(USBMIDIStatusCIN((uint8_t)status) == cin);
+        assert(USBMIDIStatusLength((uint8_t)status) == length);
+        if (cin != 0) {
+            assert(USBMIDICINLength(cin) == length);
+        }
+    }
+    for (int data = 0; data < 0x80; data++) {
+        assert(USBMIDIStatusCIN((uint8_t)data) == 0 && USBMIDIStatusLength((uint8_t)data) == 0);
+    }
+
+    // CIN lengths, USB MIDI 1.0 table 4-1
+    const uint8_t spec[16] = { 0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1 };
+    for (int cin = 0; cin < 16; cin++) {
+        assert(USBMIDICINLength((uint8_t)cin) == spec[cin]);
+    }
+
+    // What SendMIDI used to get wrong: everything but 8x/9x/Bx
+    assert(USBMIDIEncodeMessage(0, 0xE0, 0, 64).header == 0x0E);
+    assert(USBMIDIEncodeMessage(0, 0xA5, 1, 2).header == 0x0A);
+    assert(USBMIDIEncodeMessage(0, 0xD0, 3, 4).header == 0x0D);
+    assert(USBMIDIEncodeMessage(0, 0xF8).header == 0x0F);
+    assert(USBMIDIEncodeMessage(3, 0x90, 1, 2).header == 0x39);
+
+    printf("✅ 128 statuses and 16 CINs match the spec\n");
+}
+
+void test_channel_voice_exhaustive()
+{
+    printf("Testing every channel voice message...\n");
+
+    USBMIDIDecoder decoder;
+    size_t messages = 0;
+    for (int status = 0x80; status < 0xF0; status++) {
+        uint8_t length = USBMIDIStatusLength((uint8_t)status);
+
+        // Single messages through USBMIDIEncodeMessage
+        for (int data1 = 0; data1 < 128; data1++) {
+            for (int data2 = 0; data2 < (length == 3 ? 128 : 1); data2++) {
+                USBMIDIEventPacket packet = USBMIDIEncodeMessage(0, (uint8_t)status,
+                                                                 (uint8_t)data1, (uint8_t)data2);
+                assert(packet.header == status >> 4);
+                assert(decoder.Feed(packet) == USB_MIDI_DECODE_MESSAGE);
+                assert(decoder.MessageLength() == length);
+                assert(decoder.Message()[0] == status && decoder.Message()[1] == data1);
+                assert(decoder.Message()[2] == (length == 3 ? data2 : 0));
+                messages++;
+            }
+        }
+
+        // The same as one running-status stream: the status byte only once
+        Bytes stream;
+        Bytes expected;
+        stream.push_back((uint8_t)status);
+        for (int data1 = 0; data1 < 128; data1++) {
+            for (int data2 = 0; data2 < (length == 3 ? 128 : 1); data2++) {
+                expected.push_back((uint8_t)status);
+                expected.push_back((uint8_t)data1);
+                stream.push_back((uint8_t)data1);
+                if (length == 3) {
+                    expected.push_back((uint8_t)data2);
+                    stream.push_back((uint8_t)data2);
+                }
+            }
+        }
+        USBMIDIEncoder encoder;
+        std::vector<USBMIDIEventPacket> packets = EncodeStream(encoder, stream, 64);
+        assert(packets.size() == expected.size() / length);
+        Bytes normal;
+        Bytes realtime;
+        DecodeSplit(packets, normal, realtime);
+        assert(normal == expected && realtime.empty());
+        assert(DecodeMessages(decoder, packets) == expected);
+        messages += packets.size();
+    }
+
+    printf("✅ %zu channel voice messages round-trip, with and without running status\n", messages);
+}
+
+void test_system_messages()
+{
+    printf("Testing system common and realtime...\n");
+
+    USBMIDIEncoder encoder;
+    USBMIDIDecoder decoder;
+    Bytes stream;
+    Bytes expected;
+    for (int value = 0; value < 128; value++) {
+        const uint8_t f1[] = { 0xF1, (uint8_t)value };
+        const uint8_t f3[] = { 0xF3, (uint8_t)value };
+        stream.insert(stream.end(), f1, f1 + 2);
+        stream.insert(stream.end(), f3, f3 + 2);
+        for (int lsb = 0; lsb < 128; lsb++) {
+            const uint8_t f2[] = { 0xF2, (uint8_t)lsb, (uint8_t)value };
+            stream.insert(stream.end(), f2, f2 + 3);
+        }
+    }
+    stream.push_back(0xF6);
+    expected = stream;
+    std::vector<USBMIDIEventPacket> packets = EncodeStream(encoder, stream, 7);
+    assert(packets.size() == 128 * 130 + 1);
+    assert(packets.back().header == USB_MIDI_CIN_SYSEX_END_1 && packets.back().midi[0] == 0xF6);
+    assert(DecodeMessages(decoder, packets) == expected);
+
+    // System common cancels running status
+    const uint8_t cancel[] = { 0x90, 1, 2, 0xF3, 5, 3, 4 };
+    size_t count = encoder.Encode(cancel, sizeof(cancel), packets.data(), packets.size());
+    assert(count == 2 && encoder.GetStats().dropped_bytes == 2);
+
+    // Every realtime byte at every position inside a 3-byte message and a
+    // running-status message: sent first, the message stays intact
+    const uint8_t message[] = { 0x92, 0x3C, 0x64, 0x3E, 0x40 };
+    size_t cases = 0;
+    for (int rt = 0xF8; rt <= 0xFF; rt++) {
+        for (size_t at = 0; at <= sizeof(message); at++) {
+            Bytes interleaved(message, message + sizeof(message));
+            interleaved.insert(interleaved.begin() + at, (uint8_t)rt);
+            USBMIDIEncoder fresh;
+            std::vector<USBMIDIEventPacket> out = EncodeStream(fresh, interleaved, 64);
+            assert(out.size() == 3);
+            size_t rt_index = at < 3 ? 0 : at < 5 ? 1 : 2;
+            assert(out[rt_index].header == 0x0F && out[rt_index].midi[0] == rt);
+            Bytes normal;
+            Bytes realtime;
+            DecodeSplit(out, normal, realtime);
+            const uint8_t want[] = { 0x92, 0x3C, 0x64, 0x92, 0x3E, 0x40 };
+            assert(normal == Bytes(want, want + sizeof(want)));
+            assert(realtime.size() == 1 && realtime[0] == rt);
+            cases++;
+        }
+    }
+
+    printf("✅ %zu system common messages and %zu realtime interleavings\n",
+           packets.size(), cases);
+}
+
+void test_sysex_lengths()
+{
+    printf("Testing SysEx of every length...\n");
+
+    size_t total_packets = 0;
+    for (size_t payload = 0; payload <= 300; payload++) {
+        Bytes stream;
+        stream.push_back(0xF0);
+        for (size_t i = 0; i < payload; i++) {
+            stream.push_back((uint8_t)(i % 128));
+        }
+        stream.push_back(0xF7);
+
+        for (size_t chunk : { (size_t)1, (size_t)2, (size_t)5, (size_t)64 }) {
+            USBMIDIEncoder encoder;
+            std::vector<USBMIDIEventPacket> packets = EncodeStream(encoder, stream, chunk);
+
+            // ceil(n / 3) packets, CIN 4 until the last, which ends with 1-3 bytes
+            size_t n = stream.size();
+            assert(packets.size() == (n + 2) / 3);
+            for (size_t i = 0; i + 1 < packets.size(); i++) {
+                assert(packets[i].header == USB_MIDI_CIN_SYSEX_START);
+            }
+            uint8_t last = (uint8_t)(n % 3 == 0 ? 3 : n % 3);
+            assert(packets.back().header == USB_MIDI_CIN_SYSEX_END_1 + last - 1);
+            for (uint8_t i = last; i < 3; i++) {
+                assert(packets.back().midi[i] == 0);
+            }
+
+            Bytes normal;
+            Bytes realtime;
+            DecodeSplit(packets, normal, realtime);
+            assert(normal == stream);
+
+            USBMIDIDecoder decoder;
+            Bytes decoded = DecodeMessages(decoder, packets);
+            if (n <= SysExAssembler::MAX_SYSEX_LENGTH) {
+                assert(decoded == stream);
+            } else {
+                assert(decoded.empty() && decoder.DroppedSysEx() == 1);
+            }
+            total_packets += packets.size();
+        }
+    }
+
+    // Realtime anywhere inside a SysEx: delivered at once, SysEx intact
+    Bytes sysex = { 0xF0, 0x47, 0x7F, 0x4F, 0x60, 0x00, 0x04, 0x41, 0x09, 0x01, 0x04, 0xF7 };
+    for (size_t at = 1; at < sysex.size(); at++) {
+        Bytes stream = sysex;
+        stream.insert(stream.begin() + at, 0xFE);
+        USBMIDIEncoder encoder;
+        std::vector<USBMIDIEventPacket> packets = EncodeStream(encoder, stream, 3);
+        USBMIDIDecoder decoder;
+        Bytes realtime;
+        assert(DecodeMessages(decoder, packets, &realtime) == sysex);
+        assert(realtime.size() == 1 && realtime[0] == 0xFE);
+        // At most the two held SysEx bytes are sent after it
+        size_t before = 0;
+        for (const USBMIDIEventPacket& packet : packets) {
+            if (packet.header == 0x0F) {
+                break;
+            }
+            before += USBMIDICINLength(packet.header);
+        }
+        assert(before <= at && at - before <= 2);
+    }
+
+    printf("✅ 301 SysEx lengths in 4 chunkings (%zu packets), realtime inside SysEx\n",
+           total_packets);
+}
+
+void test_malformed_input()
+{
+    printf("Testing malformed streams...\n");
+
+    USBMIDIEncoder encoder;
+    USBMIDIEventPacket packets[16];
+
+    // Data without status, stray F7, undefined F4/F5
+    const uint8_t stray[] = { 0x10, 0x20, 0xF7, 0xF4, 0x01, 0xF5 };
+    assert(encoder.Encode(stray, sizeof(stray), packets, 16) == 0);
+    assert(encoder.GetStats().dropped_bytes == 6);
+
+    // SysEx cut by a status: the held bytes end the packet stream without F7
+    // so the receiver drops it, and the new message goes through
+    USBMIDIDecoder decoder;
+    const uint8_t cut[] = { 0xF0, 0x01, 0x02, 0x03, 0x04, 0x90, 0x3C, 0x7F };
+    size_t count = encoder.Encode(cut, sizeof(cut), packets, 16);
+    assert(count == 3 && encoder.GetStats().aborted_sysex == 1);
+    assert(packets[1].header == USB_MIDI_CIN_SYSEX_END_2 && packets[1].midi[0] == 0x03);
+    std::vector<USBMIDIEventPacket> out(packets, packets + count);
+    const uint8_t note[] = { 0x90, 0x3C, 0x7F };
+    assert(DecodeMessages(decoder, out) == Bytes(note, note + 3));
+    assert(decoder.DroppedSysEx() == 1);
+
+    // Cut right after a full packet: nothing held, the decoder aborts on the
+    // next status instead
+    const uint8_t cut_even[] = { 0xF0, 0x01, 0x02, 0xB0, 0x30, 0x40 };
+    count = encoder.Encode(cut_even, sizeof(cut_even), packets, 16);
+    assert(count == 2);
+    out.assign(packets, packets + count);
+    const uint8_t cc[] = { 0xB0, 0x30, 0x40 };
+    assert(DecodeMessages(decoder, out) == Bytes(cc, cc + 3));
+    assert(decoder.DroppedSysEx() == 2);
+
+    // F6 after held SysEx bytes needs two packets; with one slot it waits
+    const uint8_t tune[] = { 0xF0, 0x01, 0xF6 };
+    size_t consumed = 0;
+    count = encoder.Encode(tune, sizeof(tune), packets, 1, &consumed);
+    assert(count == 0 && consumed == 2);
+    count = encoder.Encode(tune + 2, 1, packets, 2, &consumed);
+    assert(count == 2 && consumed == 1);
+    assert(packets[0].header == USB_MIDI_CIN_SYSEX_END_2 && packets[1].midi[0] == 0xF6);
+    out.assign(packets, packets + count);
+    const uint8_t f6[] = { 0xF6 };
+    assert(DecodeMessages(decoder, out) == Bytes(f6, f6 + 1));
+
+    // Full packet buffer: stops, and resumes where it left off
+    const uint8_t notes[] = { 0x90, 1, 2, 3, 4, 5, 6 };
+    count = encoder.Encode(notes, sizeof(notes), packets, 1, &consumed);
+    assert(count == 1 && consumed == 3);
+    count = encoder.Encode(notes + consumed, sizeof(notes) - consumed, packets, 16, &consumed);
+    assert(count == 2 && packets[1].midi[0] == 0x90 && packets[1].midi[1] == 5);
+
+    // Other cables and reserved CINs are skipped
+    USBMIDIDecoder cable_one(1);
+    USBMIDIEventPacket other = USBMIDIEncodeMessage(0, 0x90, 1, 2);
+    USBMIDIEventPacket mine = USBMIDIEncodeMessage(1, 0x90, 1, 2);
+    USBMIDIEventPacket reserved = { 0x11, { 0x90, 1, 2 } };
+    assert(cable_one.Feed(other) == USB_MIDI_DECODE_NONE);
+    assert(cable_one.Feed(reserved) == USB_MIDI_DECODE_NONE);
+    assert(cable_one.Feed(mine) == USB_MIDI_DECODE_MESSAGE);
+
+    printf("✅ Stray bytes dropped, cut SysEx discarded, buffers never overrun\n");
+}
+
+void test_random_streams()
+{
+    printf("Testing randomized streams...\n");
+
+    Random random = { 0x2545F491 };
+    size_t messages = 0;
+    size_t bytes = 0;
+    for (int round = 0; round < 200; round++) {
+        Bytes stream;
+        Bytes expected;
+        Bytes expected_realtime;
+        uint8_t running = 0;
+
+        for (int m = 0; m < 500; m++) {
+            Bytes message;
+            uint32_t kind = random.Next() % 10;
+            if (kind < 6) {
+                uint8_t status = (uint8_t)(0x80 + random.Next() % 0x70);
+                uint8_t length = USBMIDIStatusLength(status);
+                message.push_back(status);
+                for (uint8_t i = 1; i < length; i++) {
+                    message.push_back(random.Data());
+                }
+                expected.insert(expected.end(), message.begin(), message.end());
+                // Drop the status when running status allows it
+                if (status == running && random.Next() % 2) {
+                    message.erase(message.begin());
+                }
+                running = status;
+            } else if (kind < 8) {
+                uint8_t status = (uint8_t)(0xF0 + random.Next() % 8);
+                uint8_t length = USBMIDIStatusLength(status);
+                if (status == 0xF0) {
+                    message.push_back(0xF0);
+                    size_t payload = random.Next() % 40;
+                    for (size_t i = 0; i < payload; i++) {
+                        message.push_back(random.Data());
+                    }
+                    message.push_back(0xF7);
+                } else if (length > 0) {
+                    message.push_back(status);
+                    for (uint8_t i = 1; i < length; i++) {
+                        message.push_back(random.Data());
+                    }
+                } else {
+                    continue;
+                }
+                expected.insert(expected.end(), message.begin(), message.end());
+                running = 0;
+            } else {
+                uint8_t rt = (uint8_t)(0xF8 + random.Next() % 8);
+                message.push_back(rt);
+                expected_realtime.push_back(rt);
+            }
+
+            // Sprinkle realtime inside the message
+            if (random.Next() % 4 == 0 && message.size() > 1) {
+                uint8_t rt = (uint8_t)(0xF8 + random.Next() % 8);
+                size_t at = 1 + random.Next() % (message.size() - 1);
+                message.insert(message.begin() + at, rt);
+                expected_realtime.push_back(rt);
+            }
+            stream.insert(stream.end(), message.begin(), message.end());
+            messages++;
+        }
+
+        USBMIDIEncoder encoder;
+        std::vector<USBMIDIEventPacket> packets =
+            EncodeStream(encoder, stream, 1 + random.Next() % 64);
+        assert(encoder.GetStats().dropped_bytes == 0 && encoder.GetStats().aborted_sysex == 0);
+
+        Bytes normal;
+        Bytes realtime;
+        DecodeSplit(packets, normal, realtime);
+        assert(normal == expected);
+        assert(realtime == expected_realtime);
+
+        USBMIDIDecoder decoder;
+        Bytes decoded_realtime;
+        assert(DecodeMessages(decoder, packets, &decoded_realtime) == expected);
+        assert(decoded_realtime == expected_realtime);
+        bytes += stream.size();
+    }
+
+    printf("✅ %zu random messages (%zu bytes) round-trip in random pieces\n", messages, bytes);
+}
+
+int main()
+{
+    printf("🔌 USB-MIDI Codec Test\n");
+    printf("======================\n\n");
+
+    test_tables();
+    test_channel_voice_exhaustive();
+    test_system_messages();
+    test_sysex_lengths();
+    test_malformed_input();
+    test_random_streams();
+
+    printf("\n🎉 ALL TESTS PASSED! Every MIDI message survives USB-MIDI packing.\n");
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "usb_raw_midi.h"
+#include "apc_device_profile.h"
+#include "thread_accounting.h"
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -27,6 +29,7 @@ USBRawMIDI::USBRawMIDI()
     , interface_num(-1)
     , endpoint_in(0)
     , endpoint_out(0)
+    , device_profile(nullptr)
     , reader_thread(-1)
     , should_stop(false)
     , last_message_time(0)
@@ -100,11 +103,7 @@ APCMiniError USBRawMIDI::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
         return APC_ERROR_DEVICE_NOT_FOUND;
     }
 
-    USBMIDIEventPacket packet;
-    packet.header = CalculateUSBMIDIHeader(0, status);
-    packet.midi[0] = status;
-    packet.midi[1] = data1;
-    packet.midi[2] = data2;
+    USBMIDIEventPacket packet = USBMIDIEncodeMessage(0, status, data1, data2);
 
     bigtime_t start_time = system_time();
     APCMiniError result = SendUSBMIDIPacket(packet);
@@ -120,6 +119,47 @@ APCMiniError USBRawMIDI::SendMIDI(uint8_t status, uint8_t data1, uint8_t data2)
     return result;
 }
 
+APCMiniError USBRawMIDI::SendMIDIBatch(const uint8_t (*messages)[3], size_t count)
+{
+    if (device_fd < 0) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    if (!messages || count == 0) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    USBMIDIEventPacket packets[MIDI_BATCH_MAX_PACKETS];
+    size_t offset = 0;
+
+    while (offset < count) {
+        size_t chunk = count - offset < MIDI_BATCH_MAX_PACKETS ? count - offset : MIDI_BATCH_MAX_PACKETS;
+        for (size_t i = 0; i < chunk; i++) {
+            const uint8_t* message = messages[offset + i];
+            packets[i] = USBMIDIEncodeMessage(0, message[0], message[1], message[2]);
+        }
+
+        // One bulk transfer for the whole chunk
+        usb_raw_command cmd;
+        cmd.transfer.interface = interface_num;
+        cmd.transfer.endpoint = endpoint_out;
+        cmd.transfer.data = packets;
+        cmd.transfer.length = chunk * sizeof(USBMIDIEventPacket);
+        cmd.transfer.timeout = USB_TRANSFER_TIMEOUT_MS * 1000;
+
+        if (ioctl(device_fd, B_USB_RAW_COMMAND_BULK_TRANSFER, &cmd, sizeof(cmd)) < 0 ||
+            cmd.transfer.length != chunk * sizeof(USBMIDIEventPacket)) {
+            printf("USB batch transfer failed: %s\n", strerror(errno));
+            stats.error_count++;
+            return APC_ERROR_USB_TRANSFER_FAILED;
+        }
+
+        stats.messages_sent += chunk;
+        offset += chunk;
+    }
+
+    return APC_SUCCESS;
+}
+
 APCMiniError USBRawMIDI::SendNoteOn(uint8_t note, uint8_t velocity)
 {
     return SendMIDI(MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity);
@@ -145,6 +185,16 @@ APCMiniError USBRawMIDI::SetPadColor(uint8_t pad, APCMiniLEDColor color)
     return SendNoteOn(note, static_cast<uint8_t>(color));
 }
 
+APCMiniError USBRawMIDI::SetPadBehavior(uint8_t pad, uint8_t color, APCMiniMK2LEDBehavior behavior)
+{
+    if (pad >= APC_MINI_PAD_COUNT) {
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t note = APC_MINI_PAD_NOTE_START + pad;
+    return SendMIDI(MIDI_NOTE_ON | (behavior & 0x0F), note, color & 0x7F);
+}
+
 APCMiniError USBRawMIDI::SetPadColorsBatch(const uint8_t* pads, const APCMiniLEDColor* colors, size_t count)
 {
     if (!pads || !colors || count == 0) {
@@ -236,13 +286,15 @@ APCMiniError USBRawMIDI::OpenDevice(const char* device_path)
     printf("Device descriptor: VID=0x%04x PID=0x%04x Class=0x%02x\n",
            desc.idVendor, desc.idProduct, desc.bDeviceClass);
 
-    if (desc.idVendor != APC_MINI_VENDOR_ID || desc.idProduct != APC_MINI_PRODUCT_ID) {
-        printf("Device VID:PID %04x:%04x doesn't match APC Mini %04x:%04x\n",
-               desc.idVendor, desc.idProduct, APC_MINI_VENDOR_ID, APC_MINI_PRODUCT_ID);
+    device_profile = APCFindDevice(desc.idVendor, desc.idProduct);
+    if (!device_profile) {
+        printf("Device VID:PID %04x:%04x doesn't match any supported APC device\n",
+               desc.idVendor, desc.idProduct);
         close(device_fd);
         device_fd = -1;
         return APC_ERROR_DEVICE_NOT_FOUND;
     }
+    printf("Opened %s\n", device_profile->name);
 
     return APC_SUCCESS;
 }
@@ -256,6 +308,7 @@ void USBRawMIDI::CloseDevice()
     interface_num = -1;
     endpoint_in = 0;
     endpoint_out = 0;
+    device_profile = nullptr;
 }
 
 APCMiniError USBRawMIDI::ClaimInterface()
@@ -314,30 +367,29 @@ APCMiniError USBRawMIDI::SendUSBMIDIPacket(const USBMIDIEventPacket& packet)
 
 void USBRawMIDI::ProcessUSBMIDIPacket(const USBMIDIEventPacket& packet)
 {
-    // Extract MIDI data from USB packet
-    uint8_t cable = (packet.header >> 4) & 0x0F;
-    uint8_t cin = packet.header & 0x0F;
-
     // Debug: Log packet details in debug builds
     #ifdef DEBUG
     printf("USB MIDI Packet: Header=0x%02x Cable=%d CIN=0x%x MIDI=[0x%02x 0x%02x 0x%02x]\n",
-           packet.header, cable, cin, packet.midi[0], packet.midi[1], packet.midi[2]);
+           packet.header, packet.header >> 4, packet.header & 0x0F,
+           packet.midi[0], packet.midi[1], packet.midi[2]);
     #endif
 
-    // Ignore packets not for our cable (typically 0)
-    if (cable != 0) {
-        return;
-    }
-
-    // Validate CIN (Code Index Number)
-    if (cin == 0x00 || cin == 0x01) {
-        // Reserved or misc function codes - ignore
-        return;
+    // The decoder skips other cables and reserved CINs and reassembles SysEx
+    switch (midi_decoder.Feed(packet)) {
+        case USB_MIDI_DECODE_SYSEX:
+            if (sysex_callback) {
+                sysex_callback(midi_decoder.SysExData(), midi_decoder.SysExLength());
+            }
+            return;
+        case USB_MIDI_DECODE_MESSAGE:
+            break;
+        default:
+            return;
     }
 
-    uint8_t status = packet.midi[0];
-    uint8_t data1 = packet.midi[1];
-    uint8_t data2 = packet.midi[2];
+    uint8_t status = midi_decoder.Message()[0];
+    uint8_t data1 = midi_decoder.Message()[1];
+    uint8_t data2 = midi_decoder.Message()[2];
 
     // Update statistics
     stats.messages_received++;
@@ -350,13 +402,13 @@ void USBRawMIDI::ProcessUSBMIDIPacket(const USBMIDIEventPacket& packet)
 
     // Categorize message types for statistics
     if ((status & 0xF0) == MIDI_NOTE_ON || (status & 0xF0) == MIDI_NOTE_OFF) {
-        if (IS_PAD_NOTE(data1)) {
+        if (device_profile && device_profile->classify_note(data1).control_class == APC_CONTROL_PAD) {
             stats.pad_presses++;
         } else {
             stats.button_presses++;
         }
     } else if ((status & 0xF0) == MIDI_CONTROL_CHANGE) {
-        if (IS_ANY_FADER_CC(data1)) {
+        if (device_profile && device_profile->classify_cc(data1).control_class != APC_CONTROL_NONE) {
             stats.fader_moves++;
         }
     }
@@ -376,18 +428,21 @@ int32 USBRawMIDI::ReaderThreadEntry(void* data)
 
 void USBRawMIDI::ReaderThreadLoop()
 {
-    USBMIDIEventPacket packet;
+    ScopedThreadAccounting accounting("usb_reader");
+    USBMIDIEventPacket packets[MIDI_READ_MAX_PACKETS];
 
     while (!should_stop) {
-        // Use Haiku USB Raw command structure for input transfers
+        // Use Haiku USB Raw command structure for input transfers; the
+        // device may pack several events into one transfer
         usb_raw_command cmd;
         cmd.transfer.interface = interface_num;
         cmd.transfer.endpoint = endpoint_in;
-        cmd.transfer.data = &packet;
-        cmd.transfer.length = sizeof(packet);
+        cmd.transfer.data = packets;
+        cmd.transfer.length = sizeof(packets);
         cmd.transfer.timeout = 10000; // 10ms timeout for low latency (was 100ms)
 
         int result = ioctl(device_fd, B_USB_RAW_COMMAND_BULK_TRANSFER, &cmd, sizeof(cmd));
+        ThreadAccounting::NoteWakeup();
 
         if (result < 0) {
             if (errno == ETIMEDOUT) {
@@ -399,8 +454,9 @@ void USBRawMIDI::ReaderThreadLoop()
             continue;
         }
 
-        if (cmd.transfer.length == sizeof(packet)) {
-            ProcessUSBMIDIPacket(packet);
+        size_t count = cmd.transfer.length / sizeof(USBMIDIEventPacket);
+        for (size_t i = 0; i < count; i++) {
+            ProcessUSBMIDIPacket(packets[i]);
         }
     }
 }
@@ -418,28 +474,6 @@ void USBRawMIDI::UpdateLatencyStats(bigtime_t latency)
     }
 }
 
-uint8_t USBRawMIDI::CalculateUSBMIDIHeader(uint8_t cable, uint8_t status)
-{
-    uint8_t cin;
-
-    switch (status & 0xF0) {
-        case MIDI_NOTE_OFF:
-            cin = USB_MIDI_CIN_NOTE_OFF;
-            break;
-        case MIDI_NOTE_ON:
-            cin = USB_MIDI_CIN_NOTE_ON;
-            break;
-        case MIDI_CONTROL_CHANGE:
-            cin = USB_MIDI_CIN_CC;
-            break;
-        default:
-            cin = 0x0F; // Single byte or unknown
-            break;
-    }
-
-    return (cable << 4) | cin;
-}
-
 // USBDeviceScanner implementation
 int USBDeviceScanner::ScanUSBDevices(USBDevice* devices, int max_devices)
 {
@@ -484,8 +518,9 @@ int USBDeviceScanner::ScanUSBDevices(USBDevice* devices, int max_devices)
             devices[device_count].manufacturer[sizeof(devices[device_count].manufacturer) - 1] = '\0';
 
             // Set product name based on known devices
-            if (desc.vendor_id == APC_MINI_VENDOR_ID && desc.product_id == APC_MINI_PRODUCT_ID) {
-                strncpy(devices[device_count].product, "APC Mini",
+            const APCDeviceDescriptor* profile = APCFindDevice(desc.vendor_id, desc.product_id);
+            if (profile) {
+                strncpy(devices[device_count].product, profile->name,
                        sizeof(devices[device_count].product) - 1);
             } else {
                 strncpy(devices[device_count].product, "Unknown",
@@ -510,9 +545,7 @@ int USBDeviceScanner::ScanUSBDevices(USBDevice* devices, int max_devices)
 
 bool USBDeviceScanner::IsAPCMini(const USBDevice& device)
 {
-    return device.vendor_id == APC_MINI_VENDOR_ID &&
-           (device.product_id == APC_MINI_PRODUCT_ID ||
-            device.product_id == APC_MINI_MK2_PRODUCT_ID);
+    return APCIsSupportedDevice(device.vendor_id, device.product_id);
 }
 
 void USBDeviceScanner::PrintDeviceInfo(const USBDevice& device)
@@ -521,11 +554,8 @@ void USBDeviceScanner::PrintDeviceInfo(const USBDevice& device)
     printf("  VID:PID = %04x:%04x\n", device.vendor_id, device.product_id);
     printf("  Manufacturer: %s\n", device.manufacturer);
     printf("  Product: %s\n", device.product);
-    if (IsAPCMini(device)) {
-        if (device.product_id == APC_MINI_PRODUCT_ID) {
-            printf("  *** This is an APC Mini (Original)! ***\n");
-        } else if (device.product_id == APC_MINI_MK2_PRODUCT_ID) {
-            printf("  *** This is an APC Mini MK2! ***\n");
-        }
+    const APCDeviceDescriptor* profile = APCFindDevice(device.vendor_id, device.product_id);
+    if (profile) {
+        printf("  *** This is an %s! ***\n", profile->name);
     }
 }
\ No newline at end of file
@@ -39,13 +39,18 @@
 #define USB_RAW_MIDI_H
 
 #include "apc_mini_defs.h"
+#include "usb_midi_codec.h"
 #include <OS.h>
 #include <Locker.h>
 #include <functional>
 
+struct APCDeviceDescriptor;
+
 class USBRawMIDI {
 public:
     typedef std::function<void(uint8_t status, uint8_t data1, uint8_t data2)> MIDICallback;
+    // Complete SysEx message (F0 ... F7), reassembled by the reader thread
+    typedef std::function<void(const uint8_t* data, size_t length)> SysExCallback;
 
     USBRawMIDI();
     ~USBRawMIDI();
@@ -62,6 +67,16 @@ public:
     APCMiniError SendNoteOff(uint8_t note);
     APCMiniError SendControlChange(uint8_t controller, uint8_t value);
     APCMiniError SetPadColor(uint8_t pad, APCMiniLEDColor color);
+    // MK2: palette color with a native brightness, pulse or blink behavior
+    APCMiniError SetPadBehavior(uint8_t pad, uint8_t color, APCMiniMK2LEDBehavior behavior);
+
+    // Several channel messages (status, data1, data2) in as few USB transfers
+    // as possible, up to MIDI_BATCH_MAX_PACKETS per transfer
+    static const size_t MIDI_BATCH_MAX_PACKETS = 64;
+    APCMiniError SendMIDIBatch(const uint8_t (*messages)[3], size_t count);
+
+    // Packets the reader accepts per transfer (one 64-byte full-speed bulk packet)
+    static const size_t MIDI_READ_MAX_PACKETS = 16;
 
     // Optimized batch operations
     // Sends multiple LED updates in a single operation with reader thread paused
@@ -74,6 +89,7 @@ public:
 
     // Callback registration
     void SetMIDICallback(MIDICallback callback) { midi_callback = callback; }
+    void SetSysExCallback(SysExCallback callback) { sysex_callback = callback; }
 
     // Reader thread control for batch operations
     void PauseReader();
@@ -82,6 +98,9 @@ public:
     // Device detection
     static bool FindAPCMini(char* device_path, size_t path_size);
 
+    // Profile of the opened device (apc_device_profile.h); nullptr when closed
+    const APCDeviceDescriptor* GetDeviceProfile() const { return device_profile; }
+
     // Statistics
     const APCMiniStats& GetStats() const { return stats; }
     void ResetStats();
@@ -92,6 +111,7 @@ private:
     int interface_num;
     int endpoint_in;
     int endpoint_out;
+    const APCDeviceDescriptor* device_profile;
 
     // Threading
     thread_id reader_thread;
@@ -101,8 +121,10 @@ private:
     sem_id pause_sem;            // Signals when pause is complete
     BLocker endpoint_lock;       // Synchronizes USB endpoint access
 
-    // Callback
+    // Callbacks
     MIDICallback midi_callback;
+    SysExCallback sysex_callback;
+    USBMIDIDecoder midi_decoder;      // Reader thread only
 
     // Statistics
     APCMiniStats stats;
@@ -124,7 +146,6 @@ private:
 
     // Utilities
     void UpdateLatencyStats(bigtime_t latency);
-    uint8_t CalculateUSBMIDIHeader(uint8_t cable, uint8_t status);
 };
 
 // USB Raw device discovery utilities
@@ -10,6 +10,7 @@ USBRawMIDI::USBRawMIDI()
     , interface_num(-1)
     , endpoint_in(-1)
     , endpoint_out(-1)
+    , device_profile(nullptr)
     , reader_thread(-1)
     , should_stop(false)
     , last_message_time(0)
@@ -40,6 +41,12 @@ APCMiniError USBRawMIDI::SendMIDI(uint8_t /*status*/, uint8_t /*data1*/, uint8_t
     return APC_ERROR_USB_TRANSFER_FAILED;
 }
 
+APCMiniError USBRawMIDI::SendMIDIBatch(const uint8_t (* /*messages*/)[3], size_t /*count*/)
+{
+    // Stub - not implemented
+    return APC_ERROR_USB_TRANSFER_FAILED;
+}
+
 APCMiniError USBRawMIDI::SendNoteOn(uint8_t note, uint8_t velocity)
 {
     return SendMIDI(MIDI_NOTE_ON | APC_MINI_MIDI_CHANNEL, note, velocity);
@@ -60,6 +67,11 @@ APCMiniError USBRawMIDI::SetPadColor(uint8_t pad, APCMiniLEDColor color)
     return SendNoteOn(pad, static_cast<uint8_t>(color));
 }
 
+APCMiniError USBRawMIDI::SetPadBehavior(uint8_t pad, uint8_t color, APCMiniMK2LEDBehavior behavior)
+{
+    return SendMIDI(MIDI_NOTE_ON | (behavior & 0x0F), pad, color & 0x7F);
+}
+
 void USBRawMIDI::ResetStats()
 {
     memset(&stats, 0, sizeof(stats));
@@ -117,11 +129,6 @@ void USBRawMIDI::UpdateLatencyStats(bigtime_t /*latency*/)
     // Stub
 }
 
-uint8_t USBRawMIDI::CalculateUSBMIDIHeader(uint8_t /*cable*/, uint8_t /*status*/)
-{
-    return 0;
-}
-
 // USBDeviceScanner stubs
 int USBDeviceScanner::ScanUSBDevices(USBDevice* /*devices*/, int /*max_devices*/)
 {
@@ -13,11 +13,10 @@
 #include <midi2/MidiProducer.h>
 #include <midi2/MidiConsumer.h>
 
-// Test configuration
-#define WARMUP_ITERATIONS 10
-#define LATENCY_TEST_ITERATIONS 100
-#define THROUGHPUT_TEST_ITERATIONS 1000
-#define BATCH_SIZE 64
+#include "workload.h"
+
+// Test configuration comes from a workload (default: virtual) with latency,
+// throughput and batch phases; each phase is one burst shape
 
 // Statistics structure
 struct BenchmarkStats {
@@ -130,7 +129,17 @@ private:
 // Benchmark test runner
 class VirtualMIDIBenchmark {
 public:
-    VirtualMIDIBenchmark() : producer(nullptr), consumer(nullptr) {}
+    VirtualMIDIBenchmark()
+        : producer(nullptr)
+        , consumer(nullptr)
+        , warmup_iterations(10)
+        , latency_iterations(100)
+        , latency_interval_us(100)
+        , throughput_iterations(1000)
+        , batch_size(64) {}
+
+    // Needs burst phases named latency, throughput and batch
+    bool Configure(const Workload& workload);
 
     bool Initialize();
     void Shutdown();
@@ -144,11 +153,48 @@ private:
     VirtualMIDIProducer* producer;
     VirtualMIDIConsumer* consumer;
     BenchmarkStats overall_stats;
+    uint32_t warmup_iterations;
+    uint32_t latency_iterations;
+    bigtime_t latency_interval_us;
+    uint32_t throughput_iterations;
+    uint32_t batch_size;
 
     void WarmUp();
     void ResetStats();
 };
 
+static const LoadProfile* FindBurstPhase(const Workload& workload, const char* name)
+{
+    for (size_t i = 0; i < workload.phase_count; i++) {
+        if (strcmp(workload.phases[i].name, name) == 0) {
+            const LoadProfile& profile = workload.phases[i].profile;
+            return profile.arrival == LOAD_ARRIVAL_BURST ? &profile : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool VirtualMIDIBenchmark::Configure(const Workload& workload)
+{
+    const LoadProfile* latency = FindBurstPhase(workload, "latency");
+    const LoadProfile* throughput = FindBurstPhase(workload, "throughput");
+    const LoadProfile* batch = FindBurstPhase(workload, "batch");
+    if (!latency || !throughput || !batch) {
+        printf("ERROR: workload '%s' needs burst phases latency, throughput and batch\n",
+               workload.name);
+        return false;
+    }
+
+    // Single messages, one per burst; bursts in the warmup window warm up
+    warmup_iterations = latency->BurstsBefore(latency->warmup_us);
+    latency_iterations = latency->BurstsBefore(latency->duration_us) - warmup_iterations;
+    latency_interval_us = latency->burst_interval_us;
+    throughput_iterations = throughput->burst_size * throughput->BurstsBefore(throughput->duration_us);
+    batch_size = batch->burst_size;
+    printf("Workload '%s': %s\n", workload.name, workload.description);
+    return latency_iterations > 0 && throughput_iterations > 0 && batch_size > 0;
+}
+
 bool VirtualMIDIBenchmark::Initialize()
 {
     printf("=== Virtual MIDI Benchmark ===\n");
@@ -228,10 +274,10 @@ void VirtualMIDIBenchmark::Shutdown()
 
 void VirtualMIDIBenchmark::WarmUp()
 {
-    printf("Warming up (%d iterations)...\n", WARMUP_ITERATIONS);
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+    printf("Warming up (%u iterations)...\n", warmup_iterations);
+    for (uint32_t i = 0; i < warmup_iterations; i++) {
         producer->SendTestNoteOn(0, 60, 127);
-        snooze(100); // 100μs delay
+        snooze(latency_interval_us);
     }
     snooze(10000); // Wait 10ms for messages to settle
 
@@ -249,14 +295,14 @@ void VirtualMIDIBenchmark::ResetStats()
 void VirtualMIDIBenchmark::RunLatencyTest()
 {
     printf("\n=== Latency Test ===\n");
-    printf("Iterations: %d\n", LATENCY_TEST_ITERATIONS);
+    printf("Iterations: %u\n", latency_iterations);
     printf("Testing single-message latency...\n\n");
 
     WarmUp();
 
     bigtime_t test_start = system_time();
 
-    for (int i = 0; i < LATENCY_TEST_ITERATIONS; i++) {
+    for (uint32_t i = 0; i < latency_iterations; i++) {
         uint8_t note = 60 + (i % 12); // C4 to B4
         uint8_t velocity = 64 + (i % 64);
 
@@ -264,7 +310,7 @@ void VirtualMIDIBenchmark::RunLatencyTest()
         producer->SendTestNoteOn(0, note, velocity);
 
         // Small delay to let message propagate
-        snooze(100); // 100μs
+        snooze(latency_interval_us);
     }
 
     // Wait for all messages to arrive
@@ -299,7 +345,7 @@ void VirtualMIDIBenchmark::RunLatencyTest()
 void VirtualMIDIBenchmark::RunThroughputTest()
 {
     printf("\n=== Throughput Test ===\n");
-    printf("Iterations: %d\n", THROUGHPUT_TEST_ITERATIONS);
+    printf("Iterations: %u\n", throughput_iterations);
     printf("Testing maximum message rate...\n\n");
 
     producer->ResetStats();
@@ -308,7 +354,7 @@ void VirtualMIDIBenchmark::RunThroughputTest()
     bigtime_t test_start = system_time();
 
     // Send messages as fast as possible
-    for (int i = 0; i < THROUGHPUT_TEST_ITERATIONS; i++) {
+    for (uint32_t i = 0; i < throughput_iterations; i++) {
         producer->SendTestNoteOn(0, i % 128, 127);
         // NO delay - test maximum throughput
     }
@@ -343,7 +389,7 @@ void VirtualMIDIBenchmark::RunThroughputTest()
 void VirtualMIDIBenchmark::RunBatchTest()
 {
     printf("\n=== Batch Test ===\n");
-    printf("Batch size: %d messages\n", BATCH_SIZE);
+    printf("Batch size: %u messages\n", batch_size);
     printf("Testing batch write performance...\n\n");
 
     producer->ResetStats();
@@ -352,8 +398,8 @@ void VirtualMIDIBenchmark::RunBatchTest()
     bigtime_t batch_start = system_time();
 
     // Send batch of messages (simulates LED update scenario)
-    for (int i = 0; i < BATCH_SIZE; i++) {
-        producer->SendTestNoteOn(0, i, (i % 6) + 1); // Simulate LED colors
+    for (uint32_t i = 0; i < batch_size; i++) {
+        producer->SendTestNoteOn(0, i % 128, (i % 6) + 1); // Simulate LED colors
     }
 
     // Wait for batch to complete
@@ -368,7 +414,7 @@ void VirtualMIDIBenchmark::RunBatchTest()
     printf("  Messages sent:     %u\n", sent);
     printf("  Messages received: %u\n", received);
     printf("  Batch duration:    %ld μs\n", batch_duration);
-    printf("  Per-message time:  %ld μs\n", batch_duration / BATCH_SIZE);
+    printf("  Per-message time:  %ld μs\n", batch_duration / batch_size);
 
     overall_stats.messages_sent += sent;
     overall_stats.messages_received += received;
@@ -402,9 +448,29 @@ void VirtualMIDIBenchmark::PrintSummary()
     printf("      USB/hardware will add additional latency on top of this baseline.\n");
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    const char* workload_name = "virtual";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            workload_name = argv[++i];
+        } else {
+            printf("Usage: %s [--workload <name|file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Workload workload;
+    char error[128];
+    if (!Workload::Resolve(workload_name, workload, error, sizeof(error))) {
+        printf("ERROR: workload '%s': %s\n", workload_name, error);
+        return 1;
+    }
+
     VirtualMIDIBenchmark benchmark;
+    if (!benchmark.Configure(workload)) {
+        return 1;
+    }
 
     if (!benchmark.Initialize()) {
         printf("Benchmark initialization failed\n");
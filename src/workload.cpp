@@ -0,0 +1,469 @@
+#include "workload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+
+// Builtins are written in the file format itself
+struct BuiltinWorkload {
+    const char* name;
+    const char* text;
+};
+
+static const BuiltinWorkload BUILTIN_WORKLOADS[] = {
+    { "steady",
+      "description = Constant 1 kHz pad/fader/SysEx mix (load_generator_benchmark default)\n"
+      "rate_hz = 1000\n"
+      "mix = pad:70 fader:25 sysex:5\n"
+      "duration_ms = 2000\n"
+      "warmup_ms = 200\n" },
+    { "batch64",
+      "description = 10 batches of 64 pad LEDs, 100 ms apart (midikit_driver_test)\n"
+      "arrival = burst\n"
+      "burst_size = 64\n"
+      "burst_interval_ms = 100\n"
+      "mix = pad:100\n"
+      "duration_ms = 1000\n" },
+    { "probe",
+      "description = One pad LED every 100 ms, 3 warmup + 20 measured (latency_benchmark)\n"
+      "arrival = burst\n"
+      "burst_size = 1\n"
+      "burst_interval_ms = 100\n"
+      "mix = pad:100\n"
+      "duration_ms = 2300\n"
+      "warmup_ms = 300\n" },
+    { "virtual",
+      "description = Single pad LEDs every 100 us, a flood of 1000, a batch of 64 (virtual_midi_benchmark)\n"
+      "arrival = burst\n"
+      "mix = pad:100\n"
+      "[phase latency]\n"
+      "burst_size = 1\n"
+      "burst_interval_ms = 0.1\n"
+      "duration_ms = 11\n"
+      "warmup_ms = 1\n"
+      "[phase throughput]\n"
+      "burst_size = 1000\n"
+      "burst_interval_ms = 1000\n"
+      "duration_ms = 1000\n"
+      "[phase batch]\n"
+      "burst_size = 64\n"
+      "burst_interval_ms = 10\n"
+      "duration_ms = 10\n" },
+    { "stress",
+      "description = 2000 pad LEDs back to back in one burst (apc_mini_test stress mode)\n"
+      "arrival = burst\n"
+      "burst_size = 2000\n"
+      "burst_interval_ms = 1000\n"
+      "mix = pad:100\n"
+      "duration_ms = 1000\n" },
+    { "burst100",
+      "description = Bursts of 100 pad LEDs every 10 ms (stress test)\n"
+      "arrival = burst\n"
+      "burst_size = 100\n"
+      "burst_interval_ms = 10\n"
+      "mix = pad:100\n"
+      "duration_ms = 1000\n"
+      "warmup_ms = 100\n" },
+    { "ramp",
+      "description = Pad/fader/SysEx mix stepping from 500 Hz to 4 kHz\n"
+      "mix = pad:70 fader:25 sysex:5\n"
+      "duration_ms = 1000\n"
+      "warmup_ms = 100\n"
+      "[phase 500hz]\n"
+      "rate_hz = 500\n"
+      "[phase 1khz]\n"
+      "rate_hz = 1000\n"
+      "[phase 2khz]\n"
+      "rate_hz = 2000\n"
+      "[phase 4khz]\n"
+      "rate_hz = 4000\n" },
+};
+
+static const size_t BUILTIN_WORKLOAD_COUNT = sizeof(BUILTIN_WORKLOADS) / sizeof(BUILTIN_WORKLOADS[0]);
+
+static void SetError(char* error, size_t error_size, int line, const char* format, ...)
+{
+    if (!error || error_size == 0) {
+        return;
+    }
+    int used = line > 0 ? snprintf(error, error_size, "line %d: ", line) : 0;
+    if (used < 0 || (size_t)used >= error_size) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error + used, error_size - used, format, args);
+    va_end(args);
+}
+
+static char* Trim(char* text)
+{
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return text;
+}
+
+static bool ParseUnsigned(const char* text, uint64_t max, uint64_t& value)
+{
+    char* end = nullptr;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || parsed > max || text[0] == '-') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool ParseMilliseconds(const char* text, bigtime_t& value_us)
+{
+    char* end = nullptr;
+    double parsed = strtod(text, &end);
+    if (end == text || *end != '\0' || !(parsed >= 0.0) || parsed > 1e9) {
+        return false;
+    }
+    value_us = (bigtime_t)llround(parsed * 1000.0);
+    return true;
+}
+
+// "pad:70 fader:25 sysex:5"; kinds left out are 0
+static bool ParseMix(const char* text, LoadProfile& profile)
+{
+    unsigned percent[3] = { 0, 0, 0 };
+    static const char* const kinds[3] = { "pad", "fader", "sysex" };
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* token = strtok(buffer, " \t,"); token; token = strtok(nullptr, " \t,")) {
+        char* colon = strchr(token, ':');
+        if (!colon) {
+            return false;
+        }
+        *colon = '\0';
+
+        int kind = -1;
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(token, kinds[i]) == 0) {
+                kind = i;
+            }
+        }
+        uint64_t value = 0;
+        if (kind < 0 || !ParseUnsigned(colon + 1, 100, value)) {
+            return false;
+        }
+        percent[kind] = (unsigned)value;
+    }
+
+    if (percent[0] + percent[1] + percent[2] != 100) {
+        return false;
+    }
+    profile.pad_percent = (uint8_t)percent[0];
+    profile.fader_percent = (uint8_t)percent[1];
+    profile.sysex_percent = (uint8_t)percent[2];
+    return true;
+}
+
+static bool ApplyPhaseKey(LoadProfile& profile, const char* key, const char* value)
+{
+    uint64_t number = 0;
+
+    if (strcmp(key, "rate_hz") == 0) {
+        if (!ParseUnsigned(value, 10000000, number)) return false;
+        profile.rate_hz = (uint32_t)number;
+    } else if (strcmp(key, "arrival") == 0) {
+        if (strcmp(value, "constant") == 0) {
+            profile.arrival = LOAD_ARRIVAL_CONSTANT;
+        } else if (strcmp(value, "poisson") == 0) {
+            profile.arrival = LOAD_ARRIVAL_POISSON;
+        } else if (strcmp(value, "burst") == 0) {
+            profile.arrival = LOAD_ARRIVAL_BURST;
+        } else {
+            return false;
+        }
+    } else if (strcmp(key, "burst_size") == 0) {
+        if (!ParseUnsigned(value, 100000, number)) return false;
+        profile.burst_size = (uint32_t)number;
+    } else if (strcmp(key, "burst_interval_ms") == 0) {
+        return ParseMilliseconds(value, profile.burst_interval_us);
+    } else if (strcmp(key, "duration_ms") == 0) {
+        return ParseMilliseconds(value, profile.duration_us);
+    } else if (strcmp(key, "warmup_ms") == 0) {
+        return ParseMilliseconds(value, profile.warmup_us);
+    } else if (strcmp(key, "drain_ms") == 0) {
+        return ParseMilliseconds(value, profile.drain_timeout_us);
+    } else if (strcmp(key, "mix") == 0) {
+        return ParseMix(value, profile);
+    } else if (strcmp(key, "poll_us") == 0) {
+        if (!ParseUnsigned(value, 1000000, number)) return false;
+        profile.dispatch_poll_us = (bigtime_t)number;
+    } else if (strcmp(key, "seed") == 0) {
+        if (!ParseUnsigned(value, UINT32_MAX, number)) return false;
+        profile.seed = (uint32_t)number;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool IsPhaseKey(const char* key)
+{
+    static const char* const keys[] = {
+        "rate_hz", "arrival", "burst_size", "burst_interval_ms", "duration_ms",
+        "warmup_ms", "drain_ms", "mix", "poll_us", "seed"
+    };
+    for (const char* known : keys) {
+        if (strcmp(key, known) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ValidatePhase(const WorkloadPhase& phase, char* error, size_t error_size)
+{
+    const LoadProfile& profile = phase.profile;
+    if (profile.duration_us <= 0) {
+        SetError(error, error_size, 0, "phase '%s': duration_ms must be positive", phase.name);
+        return false;
+    }
+    if (profile.warmup_us >= profile.duration_us) {
+        SetError(error, error_size, 0, "phase '%s': warmup_ms must be shorter than duration_ms",
+                 phase.name);
+        return false;
+    }
+    if (profile.arrival == LOAD_ARRIVAL_BURST) {
+        if (profile.burst_size == 0 || profile.burst_interval_us <= 0) {
+            SetError(error, error_size, 0, "phase '%s': bursts need burst_size and burst_interval_ms",
+                     phase.name);
+            return false;
+        }
+    } else if (profile.rate_hz == 0) {
+        SetError(error, error_size, 0, "phase '%s': rate_hz must be positive", phase.name);
+        return false;
+    }
+    return true;
+}
+
+Workload::Workload()
+    : phase_count(0)
+{
+    name[0] = '\0';
+    description[0] = '\0';
+}
+
+bool Workload::Parse(const char* text, char* error, size_t error_size)
+{
+    Workload parsed;
+    snprintf(parsed.name, sizeof(parsed.name), "unnamed");
+    LoadProfile defaults = LoadProfile::Default();
+    LoadProfile* current = &defaults;
+
+    std::string source(text ? text : "");
+    int line_number = 0;
+    size_t position = 0;
+
+    while (position <= source.size()) {
+        size_t end = source.find('\n', position);
+        if (end == std::string::npos) {
+            end = source.size();
+        }
+        std::string raw = source.substr(position, end - position);
+        position = end + 1;
+        line_number++;
+
+        size_t comment = raw.find('#');
+        if (comment != std::string::npos) {
+            raw.erase(comment);
+        }
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%s", raw.c_str());
+        char* line = Trim(buffer);
+        if (*line == '\0') {
+            continue;
+        }
+
+        // [phase <name>]
+        if (*line == '[') {
+            char* close = strchr(line, ']');
+            if (!close || strncmp(line, "[phase", 6) != 0 || close[1] != '\0') {
+                SetError(error, error_size, line_number, "expected [phase <name>]");
+                return false;
+            }
+            *close = '\0';
+            char* phase_name = Trim(line + 6);
+            if (*phase_name == '\0') {
+                SetError(error, error_size, line_number, "phase needs a name");
+                return false;
+            }
+            if (parsed.phase_count == WORKLOAD_MAX_PHASES) {
+                SetError(error, error_size, line_number, "more than %d phases", WORKLOAD_MAX_PHASES);
+                return false;
+            }
+            WorkloadPhase& phase = parsed.phases[parsed.phase_count++];
+            snprintf(phase.name, sizeof(phase.name), "%s", phase_name);
+            phase.profile = defaults;
+            current = &phase.profile;
+            continue;
+        }
+
+        char* equals = strchr(line, '=');
+        if (!equals) {
+            SetError(error, error_size, line_number, "expected key = value");
+            return false;
+        }
+        *equals = '\0';
+        char* key = Trim(line);
+        char* value = Trim(equals + 1);
+
+        if (strcmp(key, "name") == 0 || strcmp(key, "description") == 0) {
+            if (parsed.phase_count > 0) {
+                SetError(error, error_size, line_number, "'%s' must come before the first phase", key);
+                return false;
+            }
+            if (key[0] == 'n') {
+                snprintf(parsed.name, sizeof(parsed.name), "%s", value);
+            } else {
+                snprintf(parsed.description, sizeof(parsed.description), "%s", value);
+            }
+            continue;
+        }
+
+        if (!IsPhaseKey(key)) {
+            SetError(error, error_size, line_number, "unknown key '%s'", key);
+            return false;
+        }
+        if (!ApplyPhaseKey(*current, key, value)) {
+            SetError(error, error_size, line_number, "invalid value '%s' for %s", value, key);
+            return false;
+        }
+    }
+
+    if (parsed.phase_count == 0) {
+        snprintf(parsed.phases[0].name, sizeof(parsed.phases[0].name), "main");
+        parsed.phases[0].profile = defaults;
+        parsed.phase_count = 1;
+    }
+    for (size_t i = 0; i < parsed.phase_count; i++) {
+        if (!ValidatePhase(parsed.phases[i], error, error_size)) {
+            return false;
+        }
+    }
+
+    *this = parsed;
+    return true;
+}
+
+bool Workload::LoadFile(const char* path, char* error, size_t error_size)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        SetError(error, error_size, 0, "cannot open '%s'", path);
+        return false;
+    }
+
+    std::string text;
+    char chunk[1024];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, count);
+    }
+    fclose(file);
+
+    if (!Parse(text.c_str(), error, error_size)) {
+        return false;
+    }
+
+    // Unnamed files take their base name
+    if (strcmp(name, "unnamed") == 0) {
+        const char* base = strrchr(path, '/');
+        base = base ? base + 1 : path;
+        snprintf(name, sizeof(name), "%.*s", (int)strcspn(base, "."), base);
+    }
+    return true;
+}
+
+std::string Workload::Format() const
+{
+    static const char* const arrivals[] = { "constant", "poisson", "burst" };
+
+    std::string text;
+    char line[192];
+    snprintf(line, sizeof(line), "name = %s\n", name);
+    text += line;
+    if (description[0]) {
+        snprintf(line, sizeof(line), "description = %s\n", description);
+        text += line;
+    }
+
+    for (size_t i = 0; i < phase_count; i++) {
+        const LoadProfile& profile = phases[i].profile;
+        snprintf(line, sizeof(line), "\n[phase %s]\n", phases[i].name);
+        text += line;
+        snprintf(line, sizeof(line), "arrival = %s\n", arrivals[profile.arrival]);
+        text += line;
+        if (profile.arrival == LOAD_ARRIVAL_BURST) {
+            snprintf(line, sizeof(line), "burst_size = %u\nburst_interval_ms = %.3f\n",
+                     profile.burst_size, profile.burst_interval_us / 1000.0);
+        } else {
+            snprintf(line, sizeof(line), "rate_hz = %u\n", profile.rate_hz);
+        }
+        text += line;
+        snprintf(line, sizeof(line),
+                 "mix = pad:%u fader:%u sysex:%u\n"
+                 "duration_ms = %.3f\nwarmup_ms = %.3f\ndrain_ms = %.3f\n"
+                 "poll_us = %lld\nseed = %u\n",
+                 profile.pad_percent, profile.fader_percent, profile.sysex_percent,
+                 profile.duration_us / 1000.0, profile.warmup_us / 1000.0,
+                 profile.drain_timeout_us / 1000.0, (long long)profile.dispatch_poll_us, profile.seed);
+        text += line;
+    }
+    return text;
+}
+
+bigtime_t Workload::TotalDurationUs() const
+{
+    bigtime_t total = 0;
+    for (size_t i = 0; i < phase_count; i++) {
+        total += phases[i].profile.duration_us;
+    }
+    return total;
+}
+
+size_t Workload::BuiltinCount()
+{
+    return BUILTIN_WORKLOAD_COUNT;
+}
+
+const char* Workload::BuiltinName(size_t index)
+{
+    return index < BUILTIN_WORKLOAD_COUNT ? BUILTIN_WORKLOADS[index].name : nullptr;
+}
+
+bool Workload::Builtin(const char* builtin_name, Workload& workload)
+{
+    for (const BuiltinWorkload& builtin : BUILTIN_WORKLOADS) {
+        if (strcmp(builtin.name, builtin_name) == 0) {
+            if (!workload.Parse(builtin.text, nullptr, 0)) {
+                return false;
+            }
+            snprintf(workload.name, sizeof(workload.name), "%s", builtin.name);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Workload::Resolve(const char* name_or_path, Workload& workload, char* error, size_t error_size)
+{
+    if (Builtin(name_or_path, workload)) {
+        return true;
+    }
+    return workload.LoadFile(name_or_path, error, error_size);
+}
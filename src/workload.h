@@ -0,0 +1,99 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+/*
+ * Benchmark Workload Definitions
+ *
+ * The benchmark tools each used to hard-code their traffic (batches of 64
+ * LEDs, 20 probe iterations, bursts of 100), so their numbers could not be
+ * compared. A Workload describes the traffic once, as text, and
+ * WorkloadDriver (workload_driver.h) runs it against any MIDITransport.
+ *
+ * Format: one "key = value" per line, '#' starts a comment. Keys before the
+ * first [phase <name>] header are defaults that every phase starts from;
+ * without any header the workload has one phase named "main".
+ *
+ *     name = ramp
+ *     description = Pad/fader mix stepping up to 4 kHz
+ *     mix = pad:70 fader:25 sysex:5
+ *     warmup_ms = 200
+ *     duration_ms = 1000
+ *
+ *     [phase 1k]
+ *     rate_hz = 1000
+ *
+ *     [phase burst]
+ *     arrival = burst
+ *     burst_size = 64
+ *     burst_interval_ms = 100
+ *
+ * Phase keys:
+ *   rate_hz            target rate for constant/poisson arrivals
+ *   arrival            constant | poisson | burst
+ *   burst_size         messages per burst, sent back to back
+ *   burst_interval_ms  time between burst starts
+ *   duration_ms        sending time (warmup included)
+ *   warmup_ms          leading part that is sent but not measured
+ *   drain_ms           longest wait for in-flight messages afterwards
+ *   mix                pad:<pct> fader:<pct> sysex:<pct>, adding up to 100
+ *   poll_us            dispatcher idle poll interval (0 = spin)
+ *   seed               RNG seed for the mix and Poisson arrivals
+ * Millisecond values may have a fraction (burst_interval_ms = 0.5).
+ *
+ * Tools: load_generator_benchmark, workload_bench, latency_benchmark,
+ * virtual_midi_benchmark and midikit_driver_test take --workload; the
+ * apc_mini_test stress mode runs the "stress" builtin. The standalone
+ * benchmarks/ project (raw_driver_benchmark and its copies of the other
+ * two) is out of scope: it builds on its own headers without the core
+ * sources, and raw_driver_benchmark writes to /dev/midi/usb descriptors,
+ * which no MIDITransport wraps.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "load_generator.h"
+
+#define WORKLOAD_NAME_LENGTH 32
+#define WORKLOAD_DESCRIPTION_LENGTH 96
+#define WORKLOAD_MAX_PHASES 8
+
+struct WorkloadPhase {
+    char name[WORKLOAD_NAME_LENGTH];
+    LoadProfile profile;
+};
+
+struct Workload {
+    char name[WORKLOAD_NAME_LENGTH];
+    char description[WORKLOAD_DESCRIPTION_LENGTH];
+    WorkloadPhase phases[WORKLOAD_MAX_PHASES];
+    size_t phase_count;
+
+    Workload();
+
+    /**
+     * Replace this workload with the parsed text
+     *
+     * @return false with a "line N: ..." message in error on invalid input
+     */
+    bool Parse(const char* text, char* error, size_t error_size);
+
+    bool LoadFile(const char* path, char* error, size_t error_size);
+
+    // Same text format; Parse(Format()) gives the same workload back
+    std::string Format() const;
+
+    // Sum of the phase durations
+    bigtime_t TotalDurationUs() const;
+
+    // Workloads that reproduce the traffic the tools used to hard-code
+    static size_t BuiltinCount();
+    static const char* BuiltinName(size_t index);
+    static bool Builtin(const char* name, Workload& workload);
+
+    // Builtin name, or else a file path
+    static bool Resolve(const char* name_or_path, Workload& workload, char* error, size_t error_size);
+};
+
+#endif // WORKLOAD_H
@@ -0,0 +1,107 @@
+// Workload Benchmark
+// Runs one workload (builtin or file, see workload.h) against several
+// transports and prints the results side by side.
+//
+// Usage: workload_bench [--workload <name|file>] [--transports a,b,...] [--list]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+#include "workload_driver.h"
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("  --workload <name|file>   Builtin workload or workload file (default: steady)\n");
+    printf("  --transports a,b,...     Transports to compare (default: all this build knows)\n");
+    printf("  --list                   List builtin workloads and transports\n");
+}
+
+static void PrintList()
+{
+    printf("Builtin workloads:\n");
+    for (size_t i = 0; i < Workload::BuiltinCount(); i++) {
+        Workload workload;
+        Workload::Builtin(Workload::BuiltinName(i), workload);
+        printf("  %-10s %s\n", workload.name, workload.description);
+    }
+    printf("Transports:\n");
+    for (size_t i = 0; i < WorkloadDriver::TransportCount(); i++) {
+        printf("  %s\n", WorkloadDriver::TransportName(i));
+    }
+}
+
+static std::vector<std::string> SplitList(const char* text)
+{
+    std::vector<std::string> items;
+    const char* cursor = text;
+    while (*cursor) {
+        const char* end = strchr(cursor, ',');
+        size_t length = end ? (size_t)(end - cursor) : strlen(cursor);
+        if (length > 0) {
+            items.push_back(std::string(cursor, length));
+        }
+        cursor += length + (end ? 1 : 0);
+    }
+    return items;
+}
+
+int main(int argc, char** argv)
+{
+    const char* workload_name = "steady";
+    std::vector<std::string> transports;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            workload_name = argv[++i];
+        } else if (strcmp(argv[i], "--transports") == 0 && i + 1 < argc) {
+            transports = SplitList(argv[++i]);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            PrintList();
+            return 0;
+        } else {
+            PrintUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (transports.empty()) {
+        for (size_t i = 0; i < WorkloadDriver::TransportCount(); i++) {
+            transports.push_back(WorkloadDriver::TransportName(i));
+        }
+    }
+
+    Workload workload;
+    char error[128];
+    if (!Workload::Resolve(workload_name, workload, error, sizeof(error))) {
+        printf("❌ Workload '%s': %s\n", workload_name, error);
+        return 1;
+    }
+
+    printf("APC Mini Workload Benchmark\n");
+    printf("===========================\n");
+    printf("Workload '%s': %s (%zu phase%s, %.1f s per transport)\n", workload.name, workload.description,
+           workload.phase_count, workload.phase_count == 1 ? "" : "s",
+           workload.TotalDurationUs() / 1000000.0);
+
+    std::vector<WorkloadReport> reports(transports.size());
+    for (size_t i = 0; i < transports.size(); i++) {
+        printf("🚀 %s...\n", transports[i].c_str());
+        APCMiniError result = WorkloadDriver::Run(workload, transports[i].c_str(), reports[i]);
+        if (result == APC_ERROR_INVALID_PARAMETER) {
+            printf("❌ Unknown transport '%s' (see --list)\n", transports[i].c_str());
+            return 1;
+        }
+        if (result != APC_SUCCESS) {
+            printf("⚠️  %s unavailable, skipped\n", transports[i].c_str());
+        }
+    }
+
+    WorkloadDriver::PrintComparison(reports.data(), reports.size());
+    printf("\nSend latency compares across all transports; delivery only where the transport echoes.\n");
+    return 0;
+}
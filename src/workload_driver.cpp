@@ -0,0 +1,208 @@
+// Workload Driver
+// Runs a Workload against any transport through LoadGenerator
+
+#include "workload_driver.h"
+#include "midi_message_queue.h"
+#include "realtime_arena.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __HAIKU__
+#include "usb_raw_midi.h"
+
+// USBRawMIDITransport borrows its device; the driver needs one it owns
+class OwnedUSBRawMIDITransport : public USBRawMIDITransport {
+public:
+    OwnedUSBRawMIDITransport() : USBRawMIDITransport(&usb) {}
+    virtual ~OwnedUSBRawMIDITransport() { usb.Shutdown(); }
+
+    virtual APCMiniError Open() override {
+        if (!usb.IsConnected()) {
+            APCMiniError result = usb.Initialize();
+            if (result != APC_SUCCESS) {
+                return result;
+            }
+        }
+        return USBRawMIDITransport::Open();
+    }
+
+private:
+    USBRawMIDI usb;
+};
+#endif
+
+struct TransportEntry {
+    const char* name;
+    bool loops_back;
+};
+
+static const TransportEntry TRANSPORTS[] = {
+    { "loopback", true },
+    { "simulated", true },         // Full-speed USB link model
+    { "simulated-hs", true },      // High-speed USB link model
+    { "simulated-hub", true },     // Full-speed behind a busy hub
+#ifdef __HAIKU__
+    { "usb-raw", false },          // Real APC; LED messages are not echoed
+    { "midikit", false },          // Real APC through the midi_server
+    { "midikit-loop", true },      // midi_server routing alone
+#endif
+};
+
+static const size_t TRANSPORT_COUNT = sizeof(TRANSPORTS) / sizeof(TRANSPORTS[0]);
+
+size_t WorkloadDriver::TransportCount()
+{
+    return TRANSPORT_COUNT;
+}
+
+const char* WorkloadDriver::TransportName(size_t index)
+{
+    return index < TRANSPORT_COUNT ? TRANSPORTS[index].name : nullptr;
+}
+
+MIDITransport* WorkloadDriver::CreateTransport(const char* name, bool* loops_back)
+{
+    MIDITransport* transport = nullptr;
+    if (strcmp(name, "loopback") == 0) {
+        transport = new LoopbackTransport();
+    } else if (strcmp(name, "simulated") == 0) {
+        transport = new SimulatedDeviceTransport(SimulatedLinkModel::FullSpeedUSB());
+    } else if (strcmp(name, "simulated-hs") == 0) {
+        transport = new SimulatedDeviceTransport(SimulatedLinkModel::HighSpeedUSB());
+    } else if (strcmp(name, "simulated-hub") == 0) {
+        transport = new SimulatedDeviceTransport(SimulatedLinkModel::BusyHubUSB());
+#ifdef __HAIKU__
+    } else if (strcmp(name, "usb-raw") == 0) {
+        transport = new OwnedUSBRawMIDITransport();
+    } else if (strcmp(name, "midikit") == 0) {
+        transport = new MidiKitTransport("APC");
+    } else if (strcmp(name, "midikit-loop") == 0) {
+        transport = new MidiKitTransport(nullptr);
+#endif
+    }
+
+    if (transport && loops_back) {
+        *loops_back = false;
+        for (size_t i = 0; i < TRANSPORT_COUNT; i++) {
+            if (strcmp(TRANSPORTS[i].name, name) == 0) {
+                *loops_back = TRANSPORTS[i].loops_back;
+            }
+        }
+    }
+    return transport;
+}
+
+APCMiniError WorkloadDriver::Run(const Workload& workload, MIDITransport* transport, bool loops_back,
+                                 WorkloadReport& report)
+{
+    memset(&report, 0, sizeof(report));
+    snprintf(report.workload, sizeof(report.workload), "%s", workload.name);
+    snprintf(report.transport, sizeof(report.transport), "%s", transport->Name());
+    report.loops_back = loops_back;
+
+    // Check up front so a missing device is reported once, not per phase
+    if (transport->Open() != APC_SUCCESS) {
+        return APC_ERROR_DEVICE_NOT_FOUND;
+    }
+    transport->Close();
+    report.opened = true;
+
+    // Dispatch queue pre-faulted like the application's
+    RealtimeArena arena;
+    arena.Reserve<MIDIMessageQueue>("load_queue");
+    bool arena_ready = arena.Commit(true) == APC_SUCCESS;
+
+    LoadGenerator generator(transport, arena_ready ? &arena : nullptr);
+    for (size_t i = 0; i < workload.phase_count; i++) {
+        LoadProfile profile = workload.phases[i].profile;
+        if (!loops_back) {
+            // Nothing comes back; waiting for it only stretches the run
+            profile.drain_timeout_us = 0;
+        }
+        snprintf(report.phase_names[i], sizeof(report.phase_names[i]), "%s", workload.phases[i].name);
+        report.results[i] = generator.Run(profile);
+        report.phase_count = i + 1;
+    }
+    return APC_SUCCESS;
+}
+
+APCMiniError WorkloadDriver::Run(const Workload& workload, const char* transport_name,
+                                 WorkloadReport& report)
+{
+    bool loops_back = false;
+    MIDITransport* transport = CreateTransport(transport_name, &loops_back);
+    if (!transport) {
+        memset(&report, 0, sizeof(report));
+        snprintf(report.workload, sizeof(report.workload), "%s", workload.name);
+        snprintf(report.transport, sizeof(report.transport), "%s", transport_name);
+        return APC_ERROR_INVALID_PARAMETER;
+    }
+
+    // Table name: the simulated variants share one Name()
+    APCMiniError result = Run(workload, transport, loops_back, report);
+    snprintf(report.transport, sizeof(report.transport), "%s", transport_name);
+    delete transport;
+    return result;
+}
+
+static void PrintPhaseLine(const char* label, const WorkloadReport& report, size_t phase)
+{
+    const LoadRunResult& result = report.results[phase];
+    printf("  %-14s | sent %7llu (%8.1f/s) | send p50 %5lld  p99 %6lld  max %6lld us | ",
+           label, (unsigned long long)result.messages_sent, result.achieved_send_rate_hz,
+           (long long)result.send_p50_us, (long long)result.send_p99_us, (long long)result.send_max_us);
+    if (report.loops_back) {
+        printf("delivery p50 %6lld  p99 %7lld us, lost %llu\n",
+               (long long)result.latency_p50_us, (long long)result.latency_p99_us,
+               (unsigned long long)result.messages_lost);
+    } else {
+        printf("delivery n/a (no echo)\n");
+    }
+}
+
+void WorkloadDriver::PrintReport(const WorkloadReport& report)
+{
+    printf("\n📋 Workload '%s' on %s\n", report.workload, report.transport);
+    if (!report.opened) {
+        printf("  ⚠️  transport unavailable\n");
+        return;
+    }
+    for (size_t i = 0; i < report.phase_count; i++) {
+        PrintPhaseLine(report.phase_names[i], report, i);
+    }
+}
+
+void WorkloadDriver::PrintComparison(const WorkloadReport* reports, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // Phases come from the first report that ran; all ran the same workload
+    const WorkloadReport* reference = nullptr;
+    for (size_t i = 0; i < count && !reference; i++) {
+        if (reports[i].opened) {
+            reference = &reports[i];
+        }
+    }
+
+    printf("\n📊 Workload '%s' side by side\n", reports[0].workload);
+    if (!reference) {
+        printf("  ⚠️  no transport could be opened\n");
+        return;
+    }
+
+    for (size_t phase = 0; phase < reference->phase_count; phase++) {
+        const LoadRunResult& first = reference->results[phase];
+        printf("\n[%s] %u Hz offered, %llu measured after warmup\n", reference->phase_names[phase],
+               first.target_rate_hz, (unsigned long long)(first.messages_sent - first.messages_warmup));
+        for (size_t i = 0; i < count; i++) {
+            if (!reports[i].opened) {
+                printf("  %-14s | ⚠️  unavailable\n", reports[i].transport);
+                continue;
+            }
+            PrintPhaseLine(reports[i].transport, reports[i], phase);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef WORKLOAD_DRIVER_H
+#define WORKLOAD_DRIVER_H
+
+/*
+ * Workload Driver
+ *
+ * Runs a Workload (workload.h) phase by phase through LoadGenerator against
+ * a named transport, so every benchmark tool offers the same traffic to
+ * loopback, simulated, MIDI Kit and USB Raw paths and the results line up.
+ *
+ * Transports that echo (loopback, simulated, midikit-loop) report delivery
+ * latency through the dispatch queue. Real hardware does not echo LED
+ * messages, so for those only the send latency (intended time to the send
+ * call returning) is measured; it is the one figure every transport shares.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "workload.h"
+#include "load_generator.h"
+#include "midi_transport.h"
+
+struct WorkloadReport {
+    char workload[WORKLOAD_NAME_LENGTH];
+    char transport[WORKLOAD_NAME_LENGTH];
+    bool opened;                   // Transport could be opened
+    bool loops_back;               // Delivery figures are meaningful
+    size_t phase_count;
+    char phase_names[WORKLOAD_MAX_PHASES][WORKLOAD_NAME_LENGTH];
+    LoadRunResult results[WORKLOAD_MAX_PHASES];
+};
+
+class WorkloadDriver {
+public:
+    // Transports this build can create, by name
+    static size_t TransportCount();
+    static const char* TransportName(size_t index);
+
+    /**
+     * Create a transport by name (delete it when done)
+     *
+     * @param loops_back Set when the transport echoes what it is sent
+     * @return nullptr for an unknown name
+     */
+    static MIDITransport* CreateTransport(const char* name, bool* loops_back);
+
+    /**
+     * Run every phase of the workload against the transport
+     *
+     * @return APC_ERROR_DEVICE_NOT_FOUND if the transport does not open
+     */
+    static APCMiniError Run(const Workload& workload, MIDITransport* transport, bool loops_back,
+                            WorkloadReport& report);
+
+    // Create, run and delete in one go
+    static APCMiniError Run(const Workload& workload, const char* transport_name, WorkloadReport& report);
+
+    static void PrintReport(const WorkloadReport& report);
+
+    // One block per phase, one line per transport
+    static void PrintComparison(const WorkloadReport* reports, size_t count);
+};
+
+#endif // WORKLOAD_DRIVER_H
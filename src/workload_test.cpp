@@ -0,0 +1,261 @@
+/*
+ * Workload Test
+ * Workload file parsing and errors, the builtins, the burst schedule with
+ * warmup exclusion, and one workload compared across transports
+ */
+
+#include "workload.h"
+#include "workload_driver.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+void test_parse_defaults_and_phases()
+{
+    printf("Testing workload parsing...\n");
+
+    Workload workload;
+    char error[128] = "";
+    const char* text =
+        "# Two phases sharing a mix\n"
+        "name = sample\n"
+        "description = Two phases\n"
+        "mix = pad:50 fader:50\n"
+        "duration_ms = 500\n"
+        "warmup_ms = 50   # not measured\n"
+        "\n"
+        "[phase slow]\n"
+        "rate_hz = 200\n"
+        "\n"
+        "[phase bursty]\n"
+        "arrival = burst\n"
+        "burst_size = 16\n"
+        "burst_interval_ms = 2.5\n"
+        "seed = 7\n";
+    assert(workload.Parse(text, error, sizeof(error)));
+    assert(strcmp(workload.name, "sample") == 0);
+    assert(strcmp(workload.description, "Two phases") == 0);
+    assert(workload.phase_count == 2);
+
+    // Keys before the first phase are defaults for every phase
+    const LoadProfile& slow = workload.phases[0].profile;
+    assert(strcmp(workload.phases[0].name, "slow") == 0);
+    assert(slow.rate_hz == 200 && slow.arrival == LOAD_ARRIVAL_CONSTANT);
+    assert(slow.pad_percent == 50 && slow.fader_percent == 50 && slow.sysex_percent == 0);
+    assert(slow.duration_us == 500000 && slow.warmup_us == 50000);
+
+    const LoadProfile& bursty = workload.phases[1].profile;
+    assert(bursty.arrival == LOAD_ARRIVAL_BURST);
+    assert(bursty.burst_size == 16 && bursty.burst_interval_us == 2500);
+    assert(bursty.EffectiveRateHz() == 6400);
+    assert(bursty.seed == 7 && slow.seed == LoadProfile::Default().seed);
+    assert(workload.TotalDurationUs() == 1000000);
+
+    // No phase header: a single phase named "main"
+    assert(workload.Parse("rate_hz = 300\n", error, sizeof(error)));
+    assert(workload.phase_count == 1 && strcmp(workload.phases[0].name, "main") == 0);
+    assert(workload.phases[0].profile.rate_hz == 300);
+
+    printf("✅ Defaults, phases and bursts parsed\n");
+}
+
+void test_parse_errors()
+{
+    printf("Testing workload errors...\n");
+
+    struct BadCase {
+        const char* text;
+        const char* message;
+    };
+    const BadCase cases[] = {
+        { "rate_hz = 100\nbogus = 1\n", "line 2: unknown key 'bogus'" },
+        { "rate_hz = fast\n", "line 1: invalid value 'fast' for rate_hz" },
+        { "mix = pad:70 fader:20\n", "line 1: invalid value" },
+        { "rate_hz\n", "line 1: expected key = value" },
+        { "[phase a]\nname = late\n", "line 2: 'name' must come before the first phase" },
+        { "[stage a]\n", "line 1: expected [phase <name>]" },
+        { "warmup_ms = 3000\nduration_ms = 2000\n", "warmup_ms must be shorter" },
+        { "arrival = burst\nburst_size = 8\n", "bursts need burst_size and burst_interval_ms" },
+    };
+
+    // A failed parse leaves the workload as it was
+    Workload workload;
+    assert(Workload::Builtin("steady", workload));
+
+    for (const BadCase& bad : cases) {
+        char error[128] = "";
+        assert(!workload.Parse(bad.text, error, sizeof(error)));
+        if (!strstr(error, bad.message)) {
+            printf("❌ '%s' gave '%s'\n", bad.message, error);
+            assert(false);
+        }
+        assert(strcmp(workload.name, "steady") == 0);
+    }
+
+    char error[128] = "";
+    assert(!Workload::Resolve("/nonexistent/workload.txt", workload, error, sizeof(error)));
+    assert(strstr(error, "cannot open") != nullptr);
+
+    printf("✅ %zu invalid workloads rejected with line numbers\n", sizeof(cases) / sizeof(cases[0]));
+}
+
+void test_builtins_and_round_trip()
+{
+    printf("Testing builtins and Format()...\n");
+
+    assert(Workload::BuiltinCount() >= 5);
+    for (size_t i = 0; i < Workload::BuiltinCount(); i++) {
+        Workload workload;
+        assert(Workload::Builtin(Workload::BuiltinName(i), workload));
+        assert(strcmp(workload.name, Workload::BuiltinName(i)) == 0);
+        assert(workload.description[0] != '\0');
+
+        // Parse(Format()) gives the same traffic back
+        Workload copy;
+        char error[128] = "";
+        std::string text = workload.Format();
+        if (!copy.Parse(text.c_str(), error, sizeof(error))) {
+            printf("❌ %s: %s\n", workload.name, error);
+            assert(false);
+        }
+        assert(strcmp(copy.name, workload.name) == 0);
+        assert(copy.phase_count == workload.phase_count);
+        for (size_t p = 0; p < workload.phase_count; p++) {
+            const LoadProfile& a = workload.phases[p].profile;
+            const LoadProfile& b = copy.phases[p].profile;
+            assert(strcmp(workload.phases[p].name, copy.phases[p].name) == 0);
+            assert(a.arrival == b.arrival && a.EffectiveRateHz() == b.EffectiveRateHz());
+            assert(a.burst_size == b.burst_size && a.burst_interval_us == b.burst_interval_us);
+            assert(a.duration_us == b.duration_us && a.warmup_us == b.warmup_us);
+            assert(a.drain_timeout_us == b.drain_timeout_us && a.seed == b.seed);
+            assert(a.pad_percent == b.pad_percent && a.sysex_percent == b.sysex_percent);
+        }
+    }
+
+    // batch64 is the traffic midikit_driver_test used to hard-code
+    Workload batch;
+    assert(Workload::Builtin("batch64", batch));
+    assert(batch.phases[0].profile.burst_size == 64);
+    assert(batch.phases[0].profile.burst_interval_us == 100000);
+    assert(batch.phases[0].profile.BurstsBefore(batch.phases[0].profile.duration_us) == 10);
+
+    // probe and virtual replace latency_benchmark's and virtual_midi_benchmark's counts
+    Workload probe;
+    assert(Workload::Builtin("probe", probe));
+    const LoadProfile& probe_profile = probe.phases[0].profile;
+    assert(probe_profile.BurstsBefore(probe_profile.warmup_us) == 3);
+    assert(probe_profile.BurstsBefore(probe_profile.duration_us) == 23);
+
+    Workload virtual_midi;
+    assert(Workload::Builtin("virtual", virtual_midi) && virtual_midi.phase_count == 3);
+    const LoadProfile& latency = virtual_midi.phases[0].profile;
+    assert(latency.BurstsBefore(latency.warmup_us) == 10);
+    assert(latency.BurstsBefore(latency.duration_us) == 110);
+    assert(virtual_midi.phases[1].profile.burst_size == 1000);
+    assert(virtual_midi.phases[2].profile.burst_size == 64);
+
+    // stress replaces apc_mini_test's STRESS_TEST_MESSAGES Note On/Off pairs
+    Workload stress;
+    assert(Workload::Builtin("stress", stress));
+    const LoadProfile& stress_profile = stress.phases[0].profile;
+    assert(stress_profile.burst_size == STRESS_TEST_MESSAGES * 2);
+    assert(stress_profile.BurstsBefore(stress_profile.duration_us) == 1);
+
+    assert(!Workload::Builtin("missing", batch));
+
+    printf("✅ %zu builtins parse and round-trip\n", Workload::BuiltinCount());
+}
+
+void test_burst_schedule_and_warmup()
+{
+    printf("Testing bursts and warmup on loopback...\n");
+
+    // 5 bursts of 8 (0, 20, 40, 60, 80 ms); the first falls in the warmup
+    Workload workload;
+    char error[128] = "";
+    assert(workload.Parse("name = bursts\n"
+                          "arrival = burst\n"
+                          "burst_size = 8\n"
+                          "burst_interval_ms = 20\n"
+                          "mix = pad:100\n"
+                          "duration_ms = 100\n"
+                          "warmup_ms = 20\n"
+                          "drain_ms = 1000\n"
+                          "poll_us = 100\n", error, sizeof(error)));
+
+    LoopbackTransport loopback;
+    WorkloadReport report;
+    assert(WorkloadDriver::Run(workload, &loopback, true, report) == APC_SUCCESS);
+    assert(report.opened && report.phase_count == 1);
+    assert(strcmp(report.transport, "loopback") == 0);
+
+    const LoadRunResult& result = report.results[0];
+    assert(result.target_rate_hz == 400);
+    assert(result.messages_sent == 40);
+    assert(result.per_kind_sent[LOAD_MESSAGE_PAD] == 40);
+    assert(result.messages_warmup == 8);
+    assert(result.messages_dispatched == 40 && result.messages_lost == 0);
+    assert(result.send_max_us >= result.send_p50_us);
+
+    printf("✅ 40 sent in 5 bursts, 8 warmup messages left out of the figures\n");
+}
+
+void test_transports_side_by_side()
+{
+    printf("Testing one workload across transports...\n");
+
+    assert(WorkloadDriver::TransportCount() >= 4);
+    bool loops_back = false;
+    MIDITransport* transport = WorkloadDriver::CreateTransport("simulated", &loops_back);
+    assert(transport && loops_back);
+    assert(strcmp(transport->Name(), "simulated-mk2") == 0);
+    delete transport;
+    assert(WorkloadDriver::CreateTransport("carrier-pigeon", &loops_back) == nullptr);
+
+    Workload workload;
+    char error[128] = "";
+    assert(workload.Parse("name = compare\n"
+                          "rate_hz = 500\n"
+                          "mix = pad:70 fader:25 sysex:5\n"
+                          "duration_ms = 200\n"
+                          "warmup_ms = 20\n"
+                          "poll_us = 100\n", error, sizeof(error)));
+
+    const char* names[] = { "loopback", "simulated", "carrier-pigeon" };
+    WorkloadReport reports[3];
+    assert(WorkloadDriver::Run(workload, names[0], reports[0]) == APC_SUCCESS);
+    assert(WorkloadDriver::Run(workload, names[1], reports[1]) == APC_SUCCESS);
+    assert(WorkloadDriver::Run(workload, names[2], reports[2]) == APC_ERROR_INVALID_PARAMETER);
+    assert(!reports[2].opened);
+
+    // Same seed and schedule: both transports saw identical traffic
+    const LoadRunResult& loopback = reports[0].results[0];
+    const LoadRunResult& simulated = reports[1].results[0];
+    assert(strcmp(reports[1].transport, "simulated") == 0);
+    assert(loopback.messages_sent == 100 && simulated.messages_sent == 100);
+    for (int kind = 0; kind < 3; kind++) {
+        assert(loopback.per_kind_sent[kind] == simulated.per_kind_sent[kind]);
+    }
+    assert(simulated.messages_lost == 0);
+
+    // The simulated USB link adds latency the loopback does not have
+    assert(simulated.latency_p50_us > loopback.latency_p50_us);
+
+    WorkloadDriver::PrintComparison(reports, 3);
+    printf("✅ Identical traffic on every transport, results side by side\n");
+}
+
+int main()
+{
+    printf("📐 Workload Test\n");
+    printf("================\n\n");
+
+    test_parse_defaults_and_phases();
+    test_parse_errors();
+    test_builtins_and_round_trip();
+    test_burst_schedule_and_warmup();
+    test_transports_side_by_side();
+
+    printf("\n🎉 ALL TESTS PASSED! Every benchmark can share one workload.\n");
+    return 0;
+}